@@ -13,8 +13,16 @@ main_sources(SITL_COMMON_SRC_EXCLUDES
 
 main_sources(SITL_SRC
     config/config_streamer_file.c
+    drivers/sdcard/sdcard.c
+    drivers/sdcard/sdcard.h
+    drivers/sdcard/sdcard_file.c
+    drivers/sdcard/sdcard_file.h
     drivers/serial_tcp.c
     drivers/serial_tcp.h
+    io/asyncfatfs/asyncfatfs.c
+    io/asyncfatfs/asyncfatfs.h
+    io/asyncfatfs/fat_standard.c
+    io/asyncfatfs/fat_standard.h
     target/SITL/sim/realFlight.c
     target/SITL/sim/realFlight.h
     target/SITL/sim/simHelper.c
@@ -131,6 +139,45 @@ function (target_sitl name)
     )
 
     setup_firmware_target(${exe_target} ${name} ${ARGN})
+
+    if(NOT MACOSX AND NOT WIN32 AND NOT CYGWIN)
+        # The same firmware as a loadable vehicle for the fleet host, which runs many vehicles in one process.
+        # Hidden visibility keeps the firmware state of every loaded copy private to that copy.
+        set(vehicle_target ${name}_vehicle)
+        add_library(${vehicle_target} MODULE)
+        target_sources(${vehicle_target} PRIVATE ${target_sources} ${COMMON_SRC})
+        target_include_directories(${vehicle_target} PRIVATE ${CMAKE_CURRENT_SOURCE_DIR})
+        target_compile_definitions(${vehicle_target} PRIVATE ${target_definitions} SITL_VEHICLE)
+        if(WARNINGS_AS_ERRORS)
+            target_compile_options(${vehicle_target} PRIVATE -Werror)
+        endif()
+        target_compile_options(${vehicle_target} PRIVATE ${SITL_COMPILE_OPTIONS} -fvisibility=hidden)
+        target_link_libraries(${vehicle_target} PRIVATE ${SITL_LINK_LIBRARIS})
+        target_link_options(${vehicle_target} PRIVATE ${SITL_LINK_OPTIONS} -T${script_path})
+        set_target_properties(${vehicle_target} PROPERTIES
+            PREFIX ""
+            LINK_DEPENDS ${script_path}
+            LIBRARY_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/bin"
+        )
+        setup_executable(${vehicle_target} ${name})
+        # The generated settings come from the executable
+        add_dependencies(${vehicle_target} ${exe_target})
+
+        set(fleet_target ${name}_fleet.elf)
+        add_executable(${fleet_target} ${MAIN_SRC_DIR}/target/SITL/fleet/fleet.c)
+        target_include_directories(${fleet_target} PRIVATE ${MAIN_SRC_DIR})
+        target_compile_options(${fleet_target} PRIVATE ${MAIN_COMPILE_OPTIONS})
+        target_link_libraries(${fleet_target} PRIVATE -lpthread -ldl)
+        set_target_properties(${fleet_target} PROPERTIES
+            RUNTIME_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/bin"
+        )
+
+        add_custom_target(${name}_fleet ALL
+            cmake -E copy $<TARGET_FILE:${vehicle_target}> ${CMAKE_BINARY_DIR}/${binary_name}_vehicle.so
+            COMMAND cmake -E copy $<TARGET_FILE:${fleet_target}> ${CMAKE_BINARY_DIR}/${binary_name}_fleet
+        )
+        add_dependencies(${name}_fleet ${vehicle_target} ${fleet_target})
+    endif()
     #clean_<target>
     set(generator_cmd "")
     if (CMAKE_GENERATOR STREQUAL "Unix Makefiles")
@@ -147,5 +194,10 @@ function (target_sitl name)
         set_property(TARGET ${clean_target} PROPERTY
             EXCLUDE_FROM_ALL 1
             EXCLUDE_FROM_DEFAULT_BUILD 1)
+        # A parallel "make all" runs the clean target too, it must not remove files the other targets already built
+        add_dependencies(${exe_target} ${clean_target})
+        if(DEFINED fleet_target)
+            add_dependencies(${fleet_target} ${clean_target})
+        endif()
     endif()
 endfunction()
@@ -26,9 +26,11 @@
 
 #include "blackbox.h"
 #include "blackbox_encoding.h"
+#include "blackbox_gyro_capture.h"
 #include "blackbox_io.h"
 
 #include "build/debug.h"
+#include "build/trace.h"
 #include "build/version.h"
 
 #include "common/axis.h"
@@ -70,6 +72,7 @@
 
 #include "rx/rx.h"
 #include "rx/msp_override.h"
+#include "rx/rx_latency.h"
 
 #include "sensors/diagnostics.h"
 #include "sensors/acceleration.h"
@@ -99,7 +102,7 @@
 #define BLACKBOX_INVERTED_CARD_DETECTION 0
 #endif
 
-PG_REGISTER_WITH_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 2);
+PG_REGISTER_WITH_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 3);
 
 PG_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig,
     .device = DEFAULT_BLACKBOX_DEVICE,
@@ -109,6 +112,8 @@ PG_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig,
     .includeFlags = BLACKBOX_FEATURE_NAV_PID | BLACKBOX_FEATURE_NAV_POS |
         BLACKBOX_FEATURE_MAG | BLACKBOX_FEATURE_ACC | BLACKBOX_FEATURE_ATTITUDE |
         BLACKBOX_FEATURE_RC_DATA | BLACKBOX_FEATURE_RC_COMMAND | BLACKBOX_FEATURE_MOTORS,
+    .gyroCapture = SETTING_BLACKBOX_GYRO_CAPTURE_DEFAULT,
+    .gyroCaptureDurationMs = SETTING_BLACKBOX_GYRO_CAPTURE_DURATION_DEFAULT,
 );
 
 void blackboxIncludeFlagSet(uint32_t mask)
@@ -449,6 +454,7 @@ typedef enum BlackboxState {
     BLACKBOX_STATE_SEND_SYSINFO,
     BLACKBOX_STATE_PAUSED,
     BLACKBOX_STATE_RUNNING,
+    BLACKBOX_STATE_GYRO_CAPTURE,
     BLACKBOX_STATE_SHUTTING_DOWN
 } BlackboxState;
 
@@ -780,6 +786,9 @@ static void blackboxSetState(BlackboxState newState)
     case BLACKBOX_STATE_RUNNING:
         blackboxSlowFrameIterationTimer = blackboxSInterval; //Force a slow frame to be written on the first iteration
         break;
+    case BLACKBOX_STATE_GYRO_CAPTURE:
+        blackboxLoggedAnyFrames = true;
+        break;
     case BLACKBOX_STATE_SHUTTING_DOWN:
         xmitState.u.startTime = millis();
         break;
@@ -1438,6 +1447,14 @@ void blackboxStart(void)
         return;
     }
 
+    if (blackboxConfig()->gyroCapture != GYRO_CAPTURE_OFF) {
+        // Samples are buffered from now on, the header goes out once the log file is ready
+        gyroCaptureStart(blackboxConfig()->gyroCapture, blackboxConfig()->gyroCaptureDurationMs,
+                getGyroLooptime(), gyroConfig()->gyro_anti_aliasing_lpf_hz);
+        blackboxSetState(BLACKBOX_STATE_PREPARE_LOG_FILE);
+        return;
+    }
+
     memset(&gpsHistory, 0, sizeof(gpsHistory));
 
     blackboxHistory[0] = &blackboxHistoryRing[0];
@@ -1481,6 +1498,11 @@ void blackboxFinish(void)
         // We're already stopped/shutting down
         break;
 
+    case BLACKBOX_STATE_GYRO_CAPTURE:
+        // Keep going until what has been captured is written and the log is terminated
+        gyroCaptureStop();
+        break;
+
     case BLACKBOX_STATE_RUNNING:
     case BLACKBOX_STATE_PAUSED:
         blackboxLogEvent(FLIGHT_LOG_EVENT_LOG_END, NULL);
@@ -1905,6 +1927,14 @@ static bool blackboxWriteSysinfo(void)
         BLACKBOX_PRINT_HEADER_LINE("mag_hardware", "%d",                    MAG_NONE);
 #endif
         BLACKBOX_PRINT_HEADER_LINE("serialrx_provider", "%d",               rxConfig()->serialrx_provider);
+        BLACKBOX_PRINT_HEADER_LINE_CUSTOM(
+            rxLatencyStats_t rxLatencyStats;
+            rxLatencyGetStats(&rxLatencyStats);
+            // Measured since boot, up to the start of this log
+            blackboxPrintfHeaderLine("rx_latency", "%u,%u,%u,%u,%u",
+                (unsigned)rxLatencyStats.sampleCount, (unsigned)rxLatencyStats.minUs, (unsigned)rxLatencyStats.avgUs,
+                (unsigned)rxLatencyStats.p99Us, (unsigned)rxLatencyStats.maxUs);
+            );
         BLACKBOX_PRINT_HEADER_LINE("motor_pwm_protocol", "%d",              motorConfig()->motorPwmProtocol);
         BLACKBOX_PRINT_HEADER_LINE("motor_pwm_rate", "%d",                  getEscUpdateFrequency());
         BLACKBOX_PRINT_HEADER_LINE("debug_mode", "%d",                      systemConfig()->debug_mode);
@@ -2090,6 +2120,8 @@ static void blackboxLogIteration(timeUs_t currentTimeUs)
  */
 void blackboxUpdate(timeUs_t currentTimeUs)
 {
+    TRACE_BEGIN(TRACE_EVENT_BLACKBOX, 0);
+
     if (blackboxState >= BLACKBOX_FIRST_HEADER_SENDING_STATE && blackboxState <= BLACKBOX_LAST_HEADER_SENDING_STATE) {
         blackboxReplenishHeaderBudget();
     }
@@ -2097,7 +2129,11 @@ void blackboxUpdate(timeUs_t currentTimeUs)
     switch (blackboxState) {
     case BLACKBOX_STATE_PREPARE_LOG_FILE:
         if (blackboxDeviceBeginLog()) {
-            blackboxSetState(BLACKBOX_STATE_SEND_HEADER);
+            if (blackboxConfig()->gyroCapture != GYRO_CAPTURE_OFF) {
+                blackboxSetState(BLACKBOX_STATE_GYRO_CAPTURE);
+            } else {
+                blackboxSetState(BLACKBOX_STATE_SEND_HEADER);
+            }
         }
         break;
     case BLACKBOX_STATE_SEND_HEADER:
@@ -2197,6 +2233,12 @@ void blackboxUpdate(timeUs_t currentTimeUs)
         }
         blackboxAdvanceIterationTimers();
         break;
+    case BLACKBOX_STATE_GYRO_CAPTURE:
+        // Capture bypasses the frame encoder, the samples go to the device as they are
+        if (gyroCaptureWrite()) {
+            blackboxSetState(BLACKBOX_STATE_SHUTTING_DOWN);
+        }
+        break;
     case BLACKBOX_STATE_SHUTTING_DOWN:
         //On entry of this state, startTime is set
         /*
@@ -2216,8 +2258,11 @@ void blackboxUpdate(timeUs_t currentTimeUs)
 
     // Did we run out of room on the device? Stop!
     if (isBlackboxDeviceFull()) {
+        gyroCaptureStop();
         blackboxSetState(BLACKBOX_STATE_STOPPED);
     }
+
+    TRACE_END(TRACE_EVENT_BLACKBOX, 0);
 }
 
 static bool canUseBlackboxWithCurrentConfiguration(void)
@@ -42,6 +42,8 @@ typedef struct blackboxConfig_s {
     uint8_t device;
     uint8_t invertedCardDetection;
     uint32_t includeFlags;
+    uint8_t gyroCapture;                // gyroCaptureSource_e, replaces the flight log when not OFF
+    uint16_t gyroCaptureDurationMs;
 } blackboxConfig_t;
 
 PG_DECLARE(blackboxConfig_t, blackboxConfig);
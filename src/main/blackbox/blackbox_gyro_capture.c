@@ -0,0 +1,284 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "platform.h"
+
+#ifdef USE_BLACKBOX
+
+#include "blackbox/blackbox_gyro_capture.h"
+#include "blackbox/blackbox_io.h"
+
+#include "common/maths.h"
+#include "common/streambuf.h"
+#include "common/utils.h"
+
+// Holds a few PID loop iterations worth of samples, enough to ride out a slow flash page write
+#define GYRO_CAPTURE_BUFFER_SIZE    128
+
+typedef struct gyroCaptureState_s {
+    bool running;               // Accepting samples
+    bool headerWritten;
+    bool finished;              // END record written
+    gyroCaptureHeader_t header;
+    uint32_t samplesSeen;
+    uint32_t pendingGap;
+    uint16_t head;
+    uint16_t tail;
+    int16_t buffer[GYRO_CAPTURE_BUFFER_SIZE][XYZ_AXIS_COUNT];
+    gyroCaptureStats_t stats;
+} gyroCaptureState_t;
+
+STATIC_ASSERT((GYRO_CAPTURE_BUFFER_SIZE & (GYRO_CAPTURE_BUFFER_SIZE - 1)) == 0, gyro_capture_buffer_size_not_power_of_two);
+
+static gyroCaptureState_t capture;
+
+static void writeLE16(uint8_t *buf, int16_t value)
+{
+    buf[0] = (uint16_t)value & 0xFF;
+    buf[1] = (uint16_t)value >> 8;
+}
+
+static int16_t readLE16(const uint8_t *buf)
+{
+    return (int16_t)(buf[0] | (buf[1] << 8));
+}
+
+int gyroCaptureEncodeHeader(const gyroCaptureHeader_t *header, uint8_t *buf)
+{
+    sbuf_t sbuf;
+    sbufInit(&sbuf, buf, buf + GYRO_CAPTURE_HEADER_SIZE);
+
+    uint32_t scale;
+    memcpy(&scale, &header->scale, sizeof(scale));
+
+    sbufWriteData(&sbuf, GYRO_CAPTURE_MAGIC, GYRO_CAPTURE_MAGIC_LENGTH);
+    sbufWriteU8(&sbuf, header->version);
+    sbufWriteU8(&sbuf, header->source);
+    sbufWriteU8(&sbuf, header->axisCount);
+    sbufWriteU8(&sbuf, 0);
+    sbufWriteU16(&sbuf, header->sampleIntervalUs);
+    sbufWriteU16(&sbuf, header->antiAliasLpfHz);
+    sbufWriteU32(&sbuf, header->windowSamples);
+    sbufWriteU32(&sbuf, scale);
+
+    return sbuf.ptr - buf;
+}
+
+bool gyroCaptureDecodeHeader(const uint8_t *buf, int len, gyroCaptureHeader_t *header)
+{
+    if (len < GYRO_CAPTURE_HEADER_SIZE || memcmp(buf, GYRO_CAPTURE_MAGIC, GYRO_CAPTURE_MAGIC_LENGTH) != 0) {
+        return false;
+    }
+
+    sbuf_t sbuf;
+    sbufInit(&sbuf, (uint8_t *)buf + GYRO_CAPTURE_MAGIC_LENGTH, (uint8_t *)buf + GYRO_CAPTURE_HEADER_SIZE);
+
+    header->version = sbufReadU8(&sbuf);
+    header->source = sbufReadU8(&sbuf);
+    header->axisCount = sbufReadU8(&sbuf);
+    sbufReadU8(&sbuf);
+    header->sampleIntervalUs = sbufReadU16(&sbuf);
+    header->antiAliasLpfHz = sbufReadU16(&sbuf);
+    header->windowSamples = sbufReadU32(&sbuf);
+    const uint32_t scale = sbufReadU32(&sbuf);
+    memcpy(&header->scale, &scale, sizeof(header->scale));
+
+    // Newer versions may only append to the header
+    return header->version == GYRO_CAPTURE_VERSION && header->axisCount == XYZ_AXIS_COUNT;
+}
+
+gyroCaptureRecordType_e gyroCaptureDecodeRecord(const uint8_t *buf, int16_t *values)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        values[axis] = readLE16(&buf[axis * 2]);
+    }
+
+    if (values[0] != GYRO_CAPTURE_MARKER) {
+        return GYRO_CAPTURE_RECORD_SAMPLE;
+    }
+
+    switch (values[1]) {
+    case GYRO_CAPTURE_RECORD_GAP:
+    case GYRO_CAPTURE_RECORD_END:
+        return values[1];
+    default:
+        return GYRO_CAPTURE_RECORD_INVALID;
+    }
+}
+
+static unsigned bufferUsed(void)
+{
+    return (uint16_t)(capture.head - capture.tail);
+}
+
+static void bufferPut(int16_t a, int16_t b, int16_t c)
+{
+    int16_t *record = capture.buffer[capture.head & (GYRO_CAPTURE_BUFFER_SIZE - 1)];
+    record[0] = a;
+    record[1] = b;
+    record[2] = c;
+    capture.head++;
+}
+
+static int16_t takeGap(void)
+{
+    const int16_t gap = MIN(capture.pendingGap, (uint32_t)INT16_MAX);
+    capture.pendingGap -= gap;
+    return gap;
+}
+
+void gyroCaptureStart(gyroCaptureSource_e source, uint16_t durationMs, uint16_t sampleIntervalUs, uint16_t antiAliasLpfHz)
+{
+    memset(&capture, 0, sizeof(capture));
+
+    capture.header.version = GYRO_CAPTURE_VERSION;
+    capture.header.source = source;
+    capture.header.axisCount = XYZ_AXIS_COUNT;
+    capture.header.sampleIntervalUs = sampleIntervalUs;
+    capture.header.antiAliasLpfHz = antiAliasLpfHz;
+    capture.header.windowSamples = sampleIntervalUs ? ((uint32_t)durationMs * 1000) / sampleIntervalUs : 0;
+    capture.header.scale = 1.0f / GYRO_CAPTURE_LSB_PER_DPS;
+
+    capture.running = source != GYRO_CAPTURE_OFF && capture.header.windowSamples > 0;
+}
+
+void gyroCaptureStop(void)
+{
+    capture.running = false;
+}
+
+bool gyroCaptureIsRunning(void)
+{
+    return capture.running;
+}
+
+gyroCaptureSource_e gyroCaptureGetSource(void)
+{
+    return capture.header.source;
+}
+
+void FAST_CODE gyroCapturePush(const float *sample)
+{
+    if (!capture.running) {
+        return;
+    }
+
+    if (++capture.samplesSeen >= capture.header.windowSamples) {
+        capture.running = false;
+    }
+
+    // Report lost samples before the next one that makes it in
+    if (capture.pendingGap && bufferUsed() <= GYRO_CAPTURE_BUFFER_SIZE - 2) {
+        bufferPut(GYRO_CAPTURE_MARKER, GYRO_CAPTURE_RECORD_GAP, takeGap());
+    }
+
+    if (capture.pendingGap || bufferUsed() == GYRO_CAPTURE_BUFFER_SIZE) {
+        capture.pendingGap++;
+        capture.stats.samplesDropped++;
+        return;
+    }
+
+    int16_t value[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        value[axis] = lrintf(constrainf(sample[axis] * GYRO_CAPTURE_LSB_PER_DPS, -INT16_MAX, INT16_MAX));
+    }
+
+    bufferPut(value[X], value[Y], value[Z]);
+    capture.stats.samplesCaptured++;
+}
+
+static void writeRecord(const int16_t *values)
+{
+    uint8_t buf[GYRO_CAPTURE_RECORD_SIZE];
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        writeLE16(&buf[axis * 2], values[axis]);
+    }
+    for (unsigned i = 0; i < sizeof(buf); i++) {
+        blackboxWrite(buf[i]);
+    }
+}
+
+bool gyroCaptureWrite(void)
+{
+    if (capture.finished) {
+        return true;
+    }
+
+    if (!capture.headerWritten) {
+        const blackboxBufferReserveStatus_e status = blackboxDeviceReserveBufferSpace(GYRO_CAPTURE_HEADER_SIZE);
+        if (status == BLACKBOX_RESERVE_PERMANENT_FAILURE) {
+            capture.running = false;
+            capture.finished = true;
+            return true;
+        }
+        if (status != BLACKBOX_RESERVE_SUCCESS) {
+            return false;
+        }
+
+        uint8_t buf[GYRO_CAPTURE_HEADER_SIZE];
+        const int len = gyroCaptureEncodeHeader(&capture.header, buf);
+        for (int i = 0; i < len; i++) {
+            blackboxWrite(buf[i]);
+        }
+        capture.headerWritten = true;
+    }
+
+    // Write as much as the device takes, whatever doesn't fit waits for the next call
+    unsigned count = bufferUsed();
+    while (count > 0 && blackboxDeviceReserveBufferSpace(count * GYRO_CAPTURE_RECORD_SIZE) != BLACKBOX_RESERVE_SUCCESS) {
+        count /= 2;
+    }
+
+    for (; count > 0; count--) {
+        writeRecord(capture.buffer[capture.tail & (GYRO_CAPTURE_BUFFER_SIZE - 1)]);
+        capture.tail++;
+    }
+
+    if (capture.running || bufferUsed() > 0) {
+        return false;
+    }
+
+    const unsigned gapRecords = (capture.pendingGap + INT16_MAX - 1) / INT16_MAX;
+    if (blackboxDeviceReserveBufferSpace((gapRecords + 1) * GYRO_CAPTURE_RECORD_SIZE) != BLACKBOX_RESERVE_SUCCESS) {
+        return false;
+    }
+
+    while (capture.pendingGap) {
+        const int16_t gap[XYZ_AXIS_COUNT] = { GYRO_CAPTURE_MARKER, GYRO_CAPTURE_RECORD_GAP, takeGap() };
+        writeRecord(gap);
+    }
+
+    const int16_t end[XYZ_AXIS_COUNT] = { GYRO_CAPTURE_MARKER, GYRO_CAPTURE_RECORD_END, 0 };
+    writeRecord(end);
+    blackboxDeviceFlush();
+
+    capture.finished = true;
+    return true;
+}
+
+const gyroCaptureStats_t *gyroCaptureGetStats(void)
+{
+    return &capture.stats;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common/axis.h"
+
+/*
+ * Gyro capture log, written to the blackbox device instead of a flight log.
+ *
+ * A fixed size header, all fields little endian:
+ *   "INAVGCAP"                 8 byte magic
+ *   version                    u8
+ *   source                     u8, gyroCaptureSource_e
+ *   axis count                 u8, always 3 (roll, pitch, yaw in body frame)
+ *   reserved                   u8
+ *   sample interval            u16, us
+ *   anti-aliasing LPF cutoff   u16, Hz, 0 if disabled
+ *   window                     u32, samples the capture was set up for
+ *   scale                      float, deg/s per LSB
+ *
+ * followed by records of one signed 16 bit value per axis. A record whose first value is GYRO_CAPTURE_MARKER is not
+ * a sample, its second value is the record type and the third its argument. Samples are clipped to never produce the
+ * marker. The log ends with an END record, a log without one was cut short.
+ */
+
+#define GYRO_CAPTURE_MAGIC              "INAVGCAP"
+#define GYRO_CAPTURE_MAGIC_LENGTH       8
+#define GYRO_CAPTURE_VERSION            1
+#define GYRO_CAPTURE_HEADER_SIZE        24
+#define GYRO_CAPTURE_RECORD_SIZE        (XYZ_AXIS_COUNT * 2)
+#define GYRO_CAPTURE_MARKER             INT16_MIN
+#define GYRO_CAPTURE_LSB_PER_DPS        16      // +/-2048 deg/s, about the resolution of a 2000 deg/s gyro
+
+typedef enum {
+    GYRO_CAPTURE_OFF = 0,
+    GYRO_CAPTURE_RAW,               // Calibrated and aligned, before any filter
+    GYRO_CAPTURE_PREFILTERED,       // After the anti-aliasing LPF, what the filter chain in the PID loop gets
+} gyroCaptureSource_e;
+
+typedef enum {
+    GYRO_CAPTURE_RECORD_SAMPLE = 0,
+    GYRO_CAPTURE_RECORD_GAP,        // Argument is the number of samples lost to a full buffer
+    GYRO_CAPTURE_RECORD_END,
+    GYRO_CAPTURE_RECORD_INVALID,
+} gyroCaptureRecordType_e;
+
+typedef struct gyroCaptureHeader_s {
+    uint8_t version;
+    uint8_t source;
+    uint8_t axisCount;
+    uint16_t sampleIntervalUs;
+    uint16_t antiAliasLpfHz;
+    uint32_t windowSamples;
+    float scale;
+} gyroCaptureHeader_t;
+
+typedef struct gyroCaptureStats_s {
+    uint32_t samplesCaptured;
+    uint32_t samplesDropped;
+} gyroCaptureStats_t;
+
+int gyroCaptureEncodeHeader(const gyroCaptureHeader_t *header, uint8_t *buf);
+bool gyroCaptureDecodeHeader(const uint8_t *buf, int len, gyroCaptureHeader_t *header);
+gyroCaptureRecordType_e gyroCaptureDecodeRecord(const uint8_t *buf, int16_t *values);
+
+void gyroCaptureStart(gyroCaptureSource_e source, uint16_t durationMs, uint16_t sampleIntervalUs, uint16_t antiAliasLpfHz);
+void gyroCaptureStop(void);
+bool gyroCaptureIsRunning(void);
+gyroCaptureSource_e gyroCaptureGetSource(void);
+// Called at the gyro rate with the sample of the configured source, deg/s
+void gyroCapturePush(const float *sample);
+// Called from the blackbox update, writes what has been captured. Returns true once the END record is written
+bool gyroCaptureWrite(void);
+const gyroCaptureStats_t *gyroCaptureGetStats(void);
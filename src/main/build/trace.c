@@ -0,0 +1,115 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "platform.h"
+
+#ifdef USE_TRACE
+
+#include "build/trace.h"
+
+#include "common/utils.h"
+
+#include "drivers/time.h"
+
+STATIC_ASSERT((TRACE_BUFFER_SIZE & (TRACE_BUFFER_SIZE - 1)) == 0, trace_buffer_size_must_be_power_of_two);
+STATIC_ASSERT(TRACE_BUFFER_SIZE <= 0x8000, trace_buffer_too_large_for_sequence_tag);
+
+#define TRACE_BUFFER_MASK   (TRACE_BUFFER_SIZE - 1)
+
+/*
+ * Each slot carries the low bits of the sequence number it was written with, set only once the event is complete.
+ * Writers claim slots with an atomic increment so trace points may be hit from interrupts, and a reader (which may be
+ * on another thread in SITL) can tell when a slot it is copying is being rewritten.
+ */
+typedef struct traceSlot_s {
+    traceEvent_t event;
+    volatile uint16_t sequence;
+} traceSlot_t;
+
+#define TRACE_SEQUENCE_INVALID(sequence) ((uint16_t)((sequence) + 0x8000))
+
+static traceSlot_t traceBuffer[TRACE_BUFFER_SIZE];
+static volatile uint32_t traceHead;
+
+static const char * const traceEventNames[TRACE_EVENT_COUNT] = {
+    [TRACE_EVENT_SCHEDULER]     = "scheduler",
+    [TRACE_EVENT_TASK]          = "task",
+    [TRACE_EVENT_GYRO]          = "taskGyro",
+    [TRACE_EVENT_PID_LOOP]      = "taskMainPidLoop",
+    [TRACE_EVENT_BLACKBOX]      = "blackboxUpdate",
+    [TRACE_EVENT_AFATFS_POLL]   = "afatfs_poll",
+    [TRACE_EVENT_BUS]           = "bus",
+};
+
+void traceRecordAt(tracePhase_e phase, traceEventId_e id, uint16_t arg, uint32_t timeUs)
+{
+    const uint32_t sequence = __atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED);
+    traceSlot_t *slot = &traceBuffer[sequence & TRACE_BUFFER_MASK];
+
+    slot->sequence = TRACE_SEQUENCE_INVALID(sequence);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->event.timeUs = timeUs;
+    slot->event.arg = arg;
+    slot->event.id = id;
+    slot->event.phase = phase;
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->sequence = (uint16_t)sequence;
+}
+
+void traceRecord(tracePhase_e phase, traceEventId_e id, uint16_t arg)
+{
+    traceRecordAt(phase, id, arg, micros());
+}
+
+uint32_t traceGetHead(void)
+{
+    return traceHead;
+}
+
+uint32_t traceGetTail(void)
+{
+    const uint32_t head = traceHead;
+    return head > TRACE_BUFFER_SIZE ? head - TRACE_BUFFER_SIZE : 0;
+}
+
+bool traceGetEvent(uint32_t sequence, traceEvent_t *event)
+{
+    const traceSlot_t *slot = &traceBuffer[sequence & TRACE_BUFFER_MASK];
+
+    if (slot->sequence != (uint16_t)sequence) {
+        return false;
+    }
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    *event = slot->event;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    // A writer which claimed this slot while we were copying it will have invalidated the sequence
+    return slot->sequence == (uint16_t)sequence;
+}
+
+const char *traceGetEventName(traceEventId_e id)
+{
+    return id < TRACE_EVENT_COUNT ? traceEventNames[id] : "unknown";
+}
+
+#endif
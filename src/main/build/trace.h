@@ -0,0 +1,85 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Event tracer. Trace points record begin/end/instant events with a microsecond timestamp into a fixed-size ring
+ * buffer, so the ordering of task runs, bus transfers and blocking writes within a loop iteration can be inspected
+ * afterwards (over MSP2_INAV_TRACE, or as a Chrome trace file from SITL).
+ *
+ * When USE_TRACE is not defined the trace points compile to nothing.
+ */
+
+typedef enum {
+    TRACE_PHASE_BEGIN = 0,
+    TRACE_PHASE_END,
+    TRACE_PHASE_INSTANT,
+} tracePhase_e;
+
+typedef enum {
+    TRACE_EVENT_SCHEDULER = 0,
+    TRACE_EVENT_TASK,               // arg: cfTaskId_e
+    TRACE_EVENT_GYRO,
+    TRACE_EVENT_PID_LOOP,
+    TRACE_EVENT_BLACKBOX,
+    TRACE_EVENT_AFATFS_POLL,
+    TRACE_EVENT_BUS,                // arg: devHardwareType_e
+    TRACE_EVENT_COUNT
+} traceEventId_e;
+
+typedef struct traceEvent_s {
+    uint32_t timeUs;
+    uint16_t arg;
+    uint8_t id;                     // traceEventId_e
+    uint8_t phase;                  // tracePhase_e
+} traceEvent_t;
+
+#ifdef USE_TRACE
+
+// Number of events kept, must be a power of two
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE 256
+#endif
+
+void traceRecord(tracePhase_e phase, traceEventId_e id, uint16_t arg);
+void traceRecordAt(tracePhase_e phase, traceEventId_e id, uint16_t arg, uint32_t timeUs);
+
+// Sequence number the next event will be recorded with (the total number of events recorded so far)
+uint32_t traceGetHead(void);
+// Oldest sequence number which may still be in the buffer
+uint32_t traceGetTail(void);
+// Copy out the event with the given sequence number, returns false if it has been overwritten or isn't complete yet
+bool traceGetEvent(uint32_t sequence, traceEvent_t *event);
+const char *traceGetEventName(traceEventId_e id);
+
+#define TRACE_BEGIN(id, arg)    traceRecord(TRACE_PHASE_BEGIN, (id), (arg))
+#define TRACE_BEGIN_AT(id, arg, timeUs) traceRecordAt(TRACE_PHASE_BEGIN, (id), (arg), (timeUs))
+#define TRACE_END(id, arg)      traceRecord(TRACE_PHASE_END, (id), (arg))
+#define TRACE_INSTANT(id, arg)  traceRecord(TRACE_PHASE_INSTANT, (id), (arg))
+
+#else
+
+#define TRACE_BEGIN(id, arg)    do {} while (0)
+#define TRACE_BEGIN_AT(id, arg, timeUs) do {} while (0)
+#define TRACE_END(id, arg)      do {} while (0)
+#define TRACE_INSTANT(id, arg)  do {} while (0)
+
+#endif
@@ -0,0 +1,334 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+#include "platform.h"
+
+#if defined(USE_MAG_ELLIPSOID_CALIBRATION)
+
+#include "common/ellipsoid_fit.h"
+#include "common/maths.h"
+
+#define ELLIPSOID_FIT_INITIAL_P         1e4f    // Prior variance of the parameters
+#define ELLIPSOID_FIT_EIGEN_SWEEPS      8
+
+enum {
+    PARAM_U = 0,
+    PARAM_V,
+    PARAM_M,
+    PARAM_N,
+    PARAM_P,
+    PARAM_Q,
+    PARAM_R,
+    PARAM_S,
+    PARAM_T,
+};
+
+void ellipsoidFitInit(ellipsoidFit_t *fit, const fpVector3_t *reference)
+{
+    memset(fit, 0, sizeof(*fit));
+    fit->reference = *reference;
+
+    for (int i = 0; i < ELLIPSOID_FIT_PARAMS; i++) {
+        fit->P[i][i] = ELLIPSOID_FIT_INITIAL_P;
+    }
+}
+
+// Face of a cube by the largest component of the direction, quadrant of the face by the signs of the other two
+static int ellipsoidFitBin(const fpVector3_t *dir)
+{
+    int axis = 0;
+    for (int i = 1; i < 3; i++) {
+        if (fabsf(dir->v[i]) > fabsf(dir->v[axis])) {
+            axis = i;
+        }
+    }
+
+    return axis * 8 + (dir->v[axis] < 0) * 4 + (dir->v[(axis + 1) % 3] < 0) * 2 + (dir->v[(axis + 2) % 3] < 0);
+}
+
+/*
+ * RLS step without forgetting: k = P phi / (1 + phi' P phi), theta += k e, P -= k phi' P. The update of P
+ * is written as the symmetric u u' / (1 + phi' u) with u = P phi. The sum of the squared residuals of
+ * the whole fit grows by e^2 / (1 + phi' u) with the a-priori error e.
+ */
+static void ellipsoidFitUpdate(ellipsoidFit_t *fit, const fpVector3_t *x)
+{
+    const float xx = sq(x->x);
+    const float yy = sq(x->y);
+    const float zz = sq(x->z);
+
+    const float phi[ELLIPSOID_FIT_PARAMS] = {
+        xx + yy - 2 * zz,
+        xx - 2 * yy + zz,
+        x->x * x->y,
+        x->x * x->z,
+        x->y * x->z,
+        x->x,
+        x->y,
+        x->z,
+        1.0f,
+    };
+
+    float u[ELLIPSOID_FIT_PARAMS];
+    float e = xx + yy + zz;
+    float denom = 1.0f;
+
+    for (int i = 0; i < ELLIPSOID_FIT_PARAMS; i++) {
+        float sum = 0;
+        for (int j = 0; j < ELLIPSOID_FIT_PARAMS; j++) {
+            sum += fit->P[i][j] * phi[j];
+        }
+        u[i] = sum;
+        e -= fit->theta[i] * phi[i];
+        denom += phi[i] * sum;
+    }
+
+    const float gain = e / denom;
+
+    for (int i = 0; i < ELLIPSOID_FIT_PARAMS; i++) {
+        fit->theta[i] += u[i] * gain;
+
+        const float ui = u[i] / denom;
+        for (int j = i; j < ELLIPSOID_FIT_PARAMS; j++) {
+            fit->P[i][j] -= ui * u[j];
+            fit->P[j][i] = fit->P[i][j];
+        }
+    }
+
+    fit->sumSquaredResiduals += e * gain;
+}
+
+// Eigenvalues d and eigenvectors (columns of v) of the symmetric a by cyclic Jacobi rotations, a is destroyed
+static void ellipsoidFitEigen(float a[3][3], float v[3][3], float d[3])
+{
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            v[i][j] = (i == j) ? 1.0f : 0.0f;
+        }
+    }
+
+    for (int sweep = 0; sweep < ELLIPSOID_FIT_EIGEN_SWEEPS; sweep++) {
+        if (sq(a[0][1]) + sq(a[0][2]) + sq(a[1][2]) < 1e-14f * (sq(a[0][0]) + sq(a[1][1]) + sq(a[2][2]))) {
+            break;
+        }
+
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                if (a[p][q] == 0) {
+                    continue;
+                }
+
+                const float theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+                const float t = ((theta >= 0) ? 1.0f : -1.0f) / (fabsf(theta) + sqrtf(sq(theta) + 1));
+                const float c = 1 / sqrtf(sq(t) + 1);
+                const float s = t * c;
+
+                for (int k = 0; k < 3; k++) {
+                    const float akp = a[k][p];
+                    const float akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+
+                for (int k = 0; k < 3; k++) {
+                    const float apk = a[p][k];
+                    const float aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+
+                    const float vkp = v[k][p];
+                    const float vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        d[i] = a[i][i];
+    }
+}
+
+/*
+ * With the quadratic form A and b = -(Q R S) the ellipsoid is x'Ax + b'x - T = 0, centred at
+ * o = A^-1 (Q R S)' / 2 and (x - o)' A (x - o) = o'Ao + T = r2. The soft-iron matrix is the symmetric
+ * square root of A / r2, from the eigenvectors of A which also give its inverse.
+ */
+static void ellipsoidFitSolve(ellipsoidFit_t *fit)
+{
+    const float *theta = fit->theta;
+
+    float A[3][3] = {
+        { 1 - theta[PARAM_U] - theta[PARAM_V], -theta[PARAM_M] / 2, -theta[PARAM_N] / 2 },
+        { -theta[PARAM_M] / 2, 1 - theta[PARAM_U] + 2 * theta[PARAM_V], -theta[PARAM_P] / 2 },
+        { -theta[PARAM_N] / 2, -theta[PARAM_P] / 2, 1 + 2 * theta[PARAM_U] - theta[PARAM_V] },
+    };
+    float V[3][3];
+    float d[3];
+
+    fit->solved = false;
+    fit->converged = false;
+    fit->solvedAt = fit->sampleCount;
+
+    ellipsoidFitEigen(A, V, d);
+
+    const float dMin = MIN(d[0], MIN(d[1], d[2]));
+    const float dMax = MAX(d[0], MAX(d[1], d[2]));
+
+    if (dMin <= 0 || dMax > sq(ELLIPSOID_FIT_MAX_AXIS_RATIO) * dMin) {
+        return;
+    }
+
+    // Centre in the eigenvector basis
+    const float h[3] = { theta[PARAM_Q] / 2, theta[PARAM_R] / 2, theta[PARAM_S] / 2 };
+    float w[3];
+    float r2 = theta[PARAM_T];
+
+    for (int i = 0; i < 3; i++) {
+        w[i] = (V[0][i] * h[0] + V[1][i] * h[1] + V[2][i] * h[2]) / d[i];
+        r2 += d[i] * sq(w[i]);
+    }
+
+    if (r2 <= 0) {
+        return;
+    }
+
+    float scale[3];
+    for (int i = 0; i < 3; i++) {
+        fit->offset.v[i] = V[i][0] * w[0] + V[i][1] * w[1] + V[i][2] * w[2];
+        scale[i] = sqrtf(d[i] / r2);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            fit->softIron.m[i][j] = V[i][0] * scale[0] * V[j][0] + V[i][1] * scale[1] * V[j][1] + V[i][2] * scale[2] * V[j][2];
+        }
+    }
+
+    fit->solved = true;
+
+    // A sample off by a fraction err of the radius has a residual of about 2 err r2
+    const float variance = fit->sumSquaredResiduals / (fit->sampleCount - ELLIPSOID_FIT_PARAMS);
+    fit->residual = sqrtf(variance) / (2 * r2);
+
+    // Offset terms relative to the radius, T relative to r2, the rest are relative already
+    float paramStd = 0;
+    for (int i = 0; i < ELLIPSOID_FIT_PARAMS; i++) {
+        float std = sqrtf(variance * fit->P[i][i]);
+        if (i == PARAM_T) {
+            std /= r2;
+        } else if (i >= PARAM_Q) {
+            std /= sqrtf(r2);
+        }
+        paramStd = MAX(paramStd, std);
+    }
+    fit->paramStd = paramStd;
+
+    fit->converged = fit->sampleCount >= ELLIPSOID_FIT_MIN_SAMPLES &&
+                     fit->binsCovered >= ELLIPSOID_FIT_MIN_BINS &&
+                     fit->paramStd <= ELLIPSOID_FIT_MAX_PARAM_STD &&
+                     fit->residual <= ELLIPSOID_FIT_MAX_RESIDUAL;
+}
+
+bool ellipsoidFitPushSample(ellipsoidFit_t *fit, const fpVector3_t *sample)
+{
+    fpVector3_t x = {
+        .x = sample->x - fit->reference.x,
+        .y = sample->y - fit->reference.y,
+        .z = sample->z - fit->reference.z,
+    };
+
+    if (fit->scale == 0) {
+        fit->scale = MAX(calc_length_pythagorean_3D(x.x, x.y, x.z), calc_length_pythagorean_3D(sample->x, sample->y, sample->z));
+        if (fit->scale == 0) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        x.v[i] /= fit->scale;
+    }
+
+    // Direction from the centre found so far
+    fpVector3_t dir = {
+        .x = x.x - fit->offset.x,
+        .y = x.y - fit->offset.y,
+        .z = x.z - fit->offset.z,
+    };
+
+    const float length = calc_length_pythagorean_3D(dir.x, dir.y, dir.z);
+    if (length == 0) {
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        dir.v[i] /= length;
+    }
+
+    if (fit->sampleCount > 0 && (dir.x * fit->lastDirection.x + dir.y * fit->lastDirection.y + dir.z * fit->lastDirection.z) > ELLIPSOID_FIT_MIN_STEP_COS) {
+        return false;
+    }
+
+    const int bin = ellipsoidFitBin(&dir);
+    if (fit->binSamples[bin] >= ELLIPSOID_FIT_BIN_SAMPLES) {
+        return false;
+    }
+
+    if (fit->binSamples[bin]++ == 0) {
+        fit->binsCovered++;
+    }
+
+    fit->lastDirection = dir;
+    fit->sampleCount++;
+
+    ellipsoidFitUpdate(fit, &x);
+
+    if (fit->sampleCount >= 2 * ELLIPSOID_FIT_PARAMS && fit->sampleCount - fit->solvedAt >= ELLIPSOID_FIT_SOLVE_SAMPLES) {
+        ellipsoidFitSolve(fit);
+    }
+
+    return true;
+}
+
+bool ellipsoidFitIsConverged(const ellipsoidFit_t *fit)
+{
+    return fit->converged;
+}
+
+bool ellipsoidFitGetResult(const ellipsoidFit_t *fit, fpVector3_t *offset, fpMat3_t *softIron)
+{
+    if (!fit->converged) {
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        offset->v[i] = fit->reference.v[i] + fit->offset.v[i] * fit->scale;
+        for (int j = 0; j < 3; j++) {
+            softIron->m[i][j] = fit->softIron.m[i][j] / fit->scale;
+        }
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/vector.h"
+
+/*
+ * Recursive least-squares fit of an ellipsoid to samples of a constant field, e.g. the magnetometer
+ * with hard-iron offset and soft-iron distortion.
+ *
+ * The ellipsoid is written as |x|^2 = U(x^2+y^2-2z^2) + V(x^2-2y^2+z^2) + Mxy + Nxz + Pyz + Qx + Ry + Sz + T,
+ * which is linear in its 9 parameters and fixes the trace of the quadratic form, so no constraint has
+ * to be solved and the origin may lie on the ellipsoid. Each sample is one RLS step with a 9x9
+ * covariance, the same cost whatever the number of samples; no samples are stored.
+ *
+ * Samples are binned by their direction from the centre found so far and a bin takes only a few of
+ * them, so the fit isn't dominated by the attitude the craft holds most of the time. Every few samples
+ * the parameters are turned into an offset and a symmetric soft-iron matrix (no rotation of the field)
+ * and checked: the fit is converged once enough of the sphere is covered, every parameter is known
+ * well enough from the residuals so far and the residual radius error is small.
+ */
+
+#define ELLIPSOID_FIT_PARAMS            9
+#define ELLIPSOID_FIT_BINS              24      // Quadrants of the faces of a cube
+#define ELLIPSOID_FIT_BIN_SAMPLES       16      // Samples taken from each bin
+#define ELLIPSOID_FIT_MIN_BINS          12      // Half of the sphere
+#define ELLIPSOID_FIT_MIN_SAMPLES       48
+#define ELLIPSOID_FIT_SOLVE_SAMPLES     8       // Solved again after this many new samples
+#define ELLIPSOID_FIT_MIN_STEP_COS      0.99f   // Samples closer than ~8deg to the last one are skipped
+#define ELLIPSOID_FIT_MAX_PARAM_STD     0.015f
+#define ELLIPSOID_FIT_MAX_RESIDUAL      0.05f   // RMS radius error, fraction of the radius
+#define ELLIPSOID_FIT_MAX_AXIS_RATIO    2.0f
+
+typedef struct {
+    fpVector3_t reference;      // Samples are fitted as (sample - reference) / scale
+    float       scale;
+
+    float       theta[ELLIPSOID_FIT_PARAMS];
+    float       P[ELLIPSOID_FIT_PARAMS][ELLIPSOID_FIT_PARAMS];
+    float       sumSquaredResiduals;
+    uint16_t    sampleCount;
+
+    uint8_t     binSamples[ELLIPSOID_FIT_BINS];
+    uint8_t     binsCovered;
+    fpVector3_t lastDirection;
+
+    // Last solution, in units of the scaled samples
+    bool        solved;
+    bool        converged;
+    uint16_t    solvedAt;       // sampleCount of the last solution
+    fpVector3_t offset;
+    fpMat3_t    softIron;       // |softIron * (x - offset)| = 1
+    float       residual;       // RMS radius error, fraction of the radius
+    float       paramStd;       // Largest standard deviation of a parameter
+} ellipsoidFit_t;
+
+// Starts a new fit, samples are expected around reference
+void ellipsoidFitInit(ellipsoidFit_t *fit, const fpVector3_t *reference);
+// Returns true if the sample was used
+bool ellipsoidFitPushSample(ellipsoidFit_t *fit, const fpVector3_t *sample);
+bool ellipsoidFitIsConverged(const ellipsoidFit_t *fit);
+// Offset and soft-iron matrix in units of the samples: |softIron * (sample - offset)| = 1
+bool ellipsoidFitGetResult(const ellipsoidFit_t *fit, fpVector3_t *offset, fpMat3_t *softIron);
@@ -31,7 +31,10 @@
 // Use floating point M_PI instead explicitly.
 #define M_PIf       3.14159265358979323846f
 #define M_LN2f      0.69314718055994530942f
+// glibc defines the same constant with _GNU_SOURCE
+#ifndef M_Ef
 #define M_Ef        2.71828182845904523536f
+#endif
 
 #define RAD    (M_PIf / 180.0f)
 
@@ -25,6 +25,7 @@
 #include "build/build_config.h"
 
 #include "common/crc.h"
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "config/config_eeprom.h"
@@ -33,6 +34,7 @@
 
 #include "drivers/system.h"
 #include "drivers/flash.h"
+#include "drivers/time.h"
 
 #include "fc/config.h"
 
@@ -40,7 +42,11 @@
     void config_streamer_impl_unlock(void);
 #endif
 
-static uint16_t eepromConfigSize;
+static uint32_t eepromConfigSize;            // Valid part of the log, including padding of the last segment
+static bool eepromLogClean;                 // No damaged segment after the valid part, new segments can be appended
+static uint16_t eepromLogChecksum;          // Checksum of the last valid segment, seeds the checksum of the next one
+static uint32_t eepromLogGeneration;
+static configSaveStats_t configSaveStats;
 
 typedef enum {
     CR_CLASSICATION_SYSTEM   = 0,
@@ -52,6 +58,17 @@ typedef enum {
 
 #define CR_CLASSIFICATION_MASK (0x3)
 
+// Not a PG. First record of a compacted log, tells logs written by different compactions apart
+#define CR_PGN_LOG      0
+
+/*
+ * The config area is a log of segments:
+ *   header | segment 0 | segment 1 | ... | unwritten space
+ * A segment is a list of records followed by the footer and a checksum, padded to the flash write size. Segment 0 is
+ * written by a compaction and holds every PG, later segments only hold the records changed since the previous save.
+ * The latest copy of a record wins.
+ */
+
 // Header for the saved copy.
 typedef struct {
     uint8_t format;
@@ -76,6 +93,10 @@ typedef struct {
 } PG_PACKED configFooter_t;
 // checksum is appended just after footer. It is not included in footer to make checksum calculation consistent
 
+typedef struct {
+    uint32_t generation;
+} PG_PACKED configLogRecord_t;
+
 // Used to check the compiler packing at build time.
 typedef struct {
     uint8_t byte;
@@ -129,83 +150,172 @@ void initEEPROM(void)
 #endif
 }
 
-// Scan the EEPROM config. Returns true if the config is valid.
-bool isEEPROMContentValid(void)
+static uint32_t configAlign(uint32_t offset)
 {
-    const uint8_t *p = &__config_start;
-    const configHeader_t *header = (const configHeader_t *)p;
+    return (offset + CONFIG_STREAMER_BUFFER_SIZE - 1) & ~(uint32_t)(CONFIG_STREAMER_BUFFER_SIZE - 1);
+}
 
-    if (header->format != EEPROM_CONF_VERSION) {
-        return false;
+#if defined(CONFIG_IN_RAM) || defined(CONFIG_IN_FILE)
+#define CONFIG_ERASED_BYTE  0x00    // Cleared by the streamer on a full rewrite
+#else
+#define CONFIG_ERASED_BYTE  0xFF
+#endif
+
+static bool isEEPROMSpaceErased(const uint8_t *p)
+{
+    // Unwritten space is 0xFF on flash and zero in RAM. A segment never starts with an empty record
+    const configRecord_t *record = (const configRecord_t *)p;
+    return record->size == 0 || record->size == 0xFFFF;
+}
+
+// A segment can only be appended where nothing was programmed since the last erase
+static bool isEEPROMRangeErased(uint32_t offset, uint32_t size)
+{
+    const uint8_t *end = &__config_start + offset + size;
+
+    for (const uint8_t *p = &__config_start + offset; p < end; p++) {
+        if (*p != CONFIG_ERASED_BYTE) {
+            return false;
+        }
     }
-    uint16_t crc = crc16_ccitt_update(0, header, sizeof(*header));
-    p += sizeof(*header);
 
+    return true;
+}
+
+// Validate the segment starting at p. Returns the end of the segment (after the checksum) or NULL if it is invalid
+static const uint8_t *scanEEPROMSegment(const uint8_t *p, uint16_t *crc)
+{
     for (;;) {
         const configRecord_t *record = (const configRecord_t *)p;
 
+        if (p + sizeof(*record) >= &__config_end) {
+            // Too big. Further checking for size doesn't make sense
+            return NULL;
+        }
+
         if (record->size == 0) {
             // Found the end.  Stop scanning.
             break;
         }
 
-        if (p + sizeof(*record) >= &__config_end) {
-            // Too big. Further checking for size doesn't make sense
-            return false;
-        }
-
         if (p + record->size >= &__config_end || record->size < sizeof(*record)) {
             // Too big or too small.
-            return false;
+            return NULL;
         }
 
-        crc = crc16_ccitt_update(crc, p, record->size);
+        *crc = crc16_ccitt_update(*crc, p, record->size);
 
         p += record->size;
     }
 
     const configFooter_t *footer = (const configFooter_t *)p;
-    crc = crc16_ccitt_update(crc, footer, sizeof(*footer));
+    *crc = crc16_ccitt_update(*crc, footer, sizeof(*footer));
     p += sizeof(*footer);
+    if (p + sizeof(uint16_t) > &__config_end) {
+        return NULL;
+    }
     const uint16_t checkSum = *(uint16_t *)p;
     p += sizeof(checkSum);
+
+    return *crc == checkSum ? p : NULL;
+}
+
+// Scan the EEPROM config. Returns true if the config is valid.
+bool isEEPROMContentValid(void)
+{
+    const uint8_t *p = &__config_start;
+    const configHeader_t *header = (const configHeader_t *)p;
+
+    eepromConfigSize = 0;
+
+    if (header->format != EEPROM_CONF_VERSION) {
+        return false;
+    }
+    uint16_t crc = crc16_ccitt_update(0, header, sizeof(*header));
+    p += sizeof(*header);
+
+    const configRecord_t *record = (const configRecord_t *)p;
+    if (p + sizeof(*record) + sizeof(configLogRecord_t) < &__config_end && record->pgn == CR_PGN_LOG && record->size == sizeof(*record) + sizeof(configLogRecord_t)) {
+        eepromLogGeneration = ((const configLogRecord_t *)record->pg)->generation;
+    } else {
+        // Written before appending was supported
+        eepromLogGeneration = 0;
+    }
+
+    p = scanEEPROMSegment(p, &crc);
+    if (!p) {
+        return false;
+    }
+
+    // Segments appended by later saves. Each checksum is chained to the previous one, so segments left behind by an
+    // earlier log (flash which wasn't erased by the last compaction) are never picked up
+    eepromLogClean = true;
+    for (;;) {
+        p = &__config_start + configAlign(p - &__config_start);
+
+        if (p + sizeof(configRecord_t) >= &__config_end || isEEPROMSpaceErased(p)) {
+            break;
+        }
+
+        uint16_t segmentCrc = crc;
+        const uint8_t *segmentEnd = scanEEPROMSegment(p, &segmentCrc);
+        if (!segmentEnd) {
+            // Interrupted save. Ignore it, the next save has to compact the log
+            eepromLogClean = false;
+            break;
+        }
+
+        crc = segmentCrc;
+        p = segmentEnd;
+    }
+
+    eepromLogChecksum = crc;
     eepromConfigSize = p - &__config_start;
-    return crc == checkSum;
+    return true;
 }
 
-uint16_t getEEPROMConfigSize(void)
+uint32_t getEEPROMConfigSize(void)
 {
     return eepromConfigSize;
 }
 
-// find config record for reg + classification (profile info) in EEPROM
+const configSaveStats_t *getEEPROMSaveStats(void)
+{
+    return &configSaveStats;
+}
+
+// find the latest config record for reg + classification (profile info) in EEPROM
 // return NULL when record is not found
 // this function assumes that EEPROM content is valid
 static const configRecord_t *findEEPROM(const pgRegistry_t *reg, configRecordFlags_e classification)
 {
-    const uint8_t *p = &__config_start;
-    p += sizeof(configHeader_t);             // skip header
-    while (true) {
+    const uint8_t *p = &__config_start + sizeof(configHeader_t);
+    const uint8_t *end = &__config_start + eepromConfigSize;
+    const configRecord_t *found = NULL;
+
+    while (p + sizeof(configRecord_t) <= end) {
         const configRecord_t *record = (const configRecord_t *)p;
-        // Ensure that the record header fits into config memory, otherwise accessing size and flags may cause a hardfault.
-        if (p + sizeof(*record) >= &__config_end) {
-            break;
+
+        if (record->size == 0) {
+            // End of a segment, skip footer and checksum
+            p = &__config_start + configAlign(p + sizeof(configFooter_t) + sizeof(uint16_t) - &__config_start);
+            continue;
         }
 
         // Check that record header makes sense
-        if (record->size == 0 || p + record->size >= &__config_end || record->size < sizeof(*record)) {
+        if (p + record->size > end || record->size < sizeof(*record)) {
             break;
         }
 
-        // Check if this is the record we're looking for (check for size)
+        // Check if this is the record we're looking for (check for size). Later segments override earlier ones
         if (pgN(reg) == record->pgn && (record->flags & CR_CLASSIFICATION_MASK) == classification) {
-            return record;
+            found = record;
         }
 
         p += record->size;
     }
-    // record not found
-    return NULL;
+
+    return found;
 }
 
 // Initialize all PG records from EEPROM.
@@ -213,6 +323,9 @@ static const configRecord_t *findEEPROM(const pgRegistry_t *reg, configRecordFla
 //   but each PG is loaded/initialized exactly once and in defined order.
 bool loadEEPROM(void)
 {
+    // Makes sure only the valid part of the log is used
+    isEEPROMContentValid();
+
     PG_FOREACH(reg) {
         configRecordFlags_e cls_start, cls_end;
         if (pgIsSystem(reg)) {
@@ -236,68 +349,142 @@ bool loadEEPROM(void)
     return true;
 }
 
-static bool writeSettingsToEEPROM(void)
+static bool isConfigRecordChanged(const pgRegistry_t *reg, configRecordFlags_e classification, const uint8_t *address)
 {
-    config_streamer_t streamer;
-    config_streamer_init(&streamer);
-
-    config_streamer_start(&streamer, (uintptr_t)&__config_start, &__config_end - &__config_start);
+    const configRecord_t *record = findEEPROM(reg, classification);
 
-    configHeader_t header = {
-        .format = EEPROM_CONF_VERSION,
-    };
+    return !record || record->version != pgVersion(reg) ||
+        record->size != sizeof(configRecord_t) + pgSize(reg) || memcmp(record->pg, address, pgSize(reg)) != 0;
+}
 
-    if (config_streamer_write(&streamer, (uint8_t *)&header, sizeof(header)) < 0) {
+static bool writeToEEPROM(config_streamer_t *streamer, const void *data, uint32_t size, uint16_t *crc)
+{
+    if (config_streamer_write(streamer, data, size) < 0) {
         return false;
     }
-    uint16_t crc = crc16_ccitt_update(0, (uint8_t *)&header, sizeof(header));
+    *crc = crc16_ccitt_update(*crc, data, size);
+    return true;
+}
+
+// Write a record for every PG instance, or only for those which differ from their latest copy in EEPROM.
+// Without a streamer only the size and number of records which would be written are calculated.
+static bool writeRecordsToEEPROM(config_streamer_t *streamer, bool changedOnly, uint16_t *crc, uint32_t *size, uint16_t *count)
+{
+    *size = 0;
+    *count = 0;
+
     PG_FOREACH(reg) {
         const uint16_t regSize = pgSize(reg);
-        configRecord_t record = {
-            .size = sizeof(configRecord_t) + regSize,
-            .pgn = pgN(reg),
-            .version = pgVersion(reg),
-            .flags = 0
-        };
+        // write the only instance for system PGs, one instance for each profile otherwise
+        const int instanceCount = pgIsSystem(reg) ? 1 : MAX_PROFILE_COUNT;
 
-        if (pgIsSystem(reg)) {
-            // write the only instance
-            record.flags |= CR_CLASSICATION_SYSTEM;
-            if (config_streamer_write(&streamer, (uint8_t *)&record, sizeof(record)) < 0) {
-                return false;
-            }
-            crc = crc16_ccitt_update(crc, (uint8_t *)&record, sizeof(record));
-            if (config_streamer_write(&streamer, reg->address, regSize) < 0) {
-                return false;
+        for (int profileIndex = 0; profileIndex < instanceCount; profileIndex++) {
+            const configRecordFlags_e classification = pgIsSystem(reg) ? CR_CLASSICATION_SYSTEM : ((profileIndex + 1) & CR_CLASSIFICATION_MASK);
+            const uint8_t *address = reg->address + (regSize * profileIndex);
+
+            if (changedOnly && !isConfigRecordChanged(reg, classification, address)) {
+                continue;
             }
-            crc = crc16_ccitt_update(crc, reg->address, regSize);
-        } else {
-            // write one instance for each profile
-            for (uint8_t profileIndex = 0; profileIndex < MAX_PROFILE_COUNT; profileIndex++) {
-                record.flags = 0;
 
-                record.flags |= ((profileIndex + 1) & CR_CLASSIFICATION_MASK);
-                if (config_streamer_write(&streamer, (uint8_t *)&record, sizeof(record)) < 0) {
-                    return false;
-                }
-                crc = crc16_ccitt_update(crc, (uint8_t *)&record, sizeof(record));
-                const uint8_t *address = reg->address + (regSize * profileIndex);
-                if (config_streamer_write(&streamer, address, regSize) < 0) {
+            configRecord_t record = {
+                .size = sizeof(configRecord_t) + regSize,
+                .pgn = pgN(reg),
+                .version = pgVersion(reg),
+                .flags = classification
+            };
+
+            if (streamer) {
+                if (!writeToEEPROM(streamer, &record, sizeof(record), crc) || !writeToEEPROM(streamer, address, regSize, crc)) {
                     return false;
                 }
-                crc = crc16_ccitt_update(crc, address, regSize);
             }
+
+            *size += record.size;
+            (*count)++;
         }
     }
 
+    return true;
+}
+
+/*
+ * A save appends a segment with only the records which changed since the previous save, so most saves program a few
+ * hundred bytes instead of erasing the sector and rewriting every PG. Only when the appended segment doesn't fit into
+ * erased space, or the log is damaged, the whole config is rewritten (compacted) into a freshly erased config area.
+ * configSize is set to the size of the log the save should leave behind.
+ */
+static bool writeSettingsToEEPROM(bool compact, uint32_t *configSize)
+{
+    const uint32_t eepromSize = &__config_end - &__config_start;
+    uint32_t recordsSize;
+    uint16_t recordCount;
+    uint16_t crc = 0;
+
+    if (!compact) {
+        writeRecordsToEEPROM(NULL, true, &crc, &recordsSize, &recordCount);
+
+        if (recordCount == 0) {
+            // Nothing changed
+            configSaveStats.lastBytesWritten = 0;
+            configSaveStats.lastRecordsWritten = 0;
+            configSaveStats.lastSaveCompacted = false;
+            *configSize = eepromConfigSize;
+            return true;
+        }
+
+        const uint32_t segmentSize = configAlign(recordsSize + sizeof(configFooter_t) + sizeof(uint16_t));
+        compact = eepromConfigSize + segmentSize > eepromSize || !isEEPROMRangeErased(eepromConfigSize, segmentSize);
+    }
+
+    config_streamer_t streamer;
+    config_streamer_init(&streamer);
+
+    uint32_t bytesWritten = 0;
+    const uint32_t startOffset = compact ? 0 : eepromConfigSize;
+
+    if (compact) {
+        config_streamer_start(&streamer, (uintptr_t)&__config_start, eepromSize);
+
+        configHeader_t header = {
+            .format = EEPROM_CONF_VERSION,
+        };
+
+        crc = 0;
+        if (!writeToEEPROM(&streamer, &header, sizeof(header), &crc)) {
+            return false;
+        }
+
+        configRecord_t logRecord = {
+            .size = sizeof(configRecord_t) + sizeof(configLogRecord_t),
+            .pgn = CR_PGN_LOG,
+            .version = 0,
+            .flags = 0
+        };
+        const configLogRecord_t logData = {
+            .generation = eepromLogGeneration + 1,
+        };
+
+        if (!writeToEEPROM(&streamer, &logRecord, sizeof(logRecord), &crc) || !writeToEEPROM(&streamer, &logData, sizeof(logData), &crc)) {
+            return false;
+        }
+
+        bytesWritten = sizeof(header) + logRecord.size;
+    } else {
+        config_streamer_start(&streamer, (uintptr_t)&__config_start + eepromConfigSize, eepromSize - eepromConfigSize);
+        crc = eepromLogChecksum;
+    }
+
+    if (!writeRecordsToEEPROM(&streamer, !compact, &crc, &recordsSize, &recordCount)) {
+        return false;
+    }
+
     configFooter_t footer = {
         .terminator = 0,
     };
 
-    if (config_streamer_write(&streamer, (uint8_t *)&footer, sizeof(footer)) < 0) {
+    if (!writeToEEPROM(&streamer, &footer, sizeof(footer), &crc)) {
         return false;
     }
-    crc = crc16_ccitt_update(crc, (uint8_t *)&footer, sizeof(footer));
 
     // append checksum now
     if (config_streamer_write(&streamer, (uint8_t *)&crc, sizeof(crc)) < 0) {
@@ -310,25 +497,44 @@ static bool writeSettingsToEEPROM(void)
 
     bool success = config_streamer_finish(&streamer) == 0;
 
+    bytesWritten += recordsSize + sizeof(footer) + sizeof(crc);
+    configSaveStats.lastBytesWritten = configAlign(bytesWritten);
+    *configSize = startOffset + configSaveStats.lastBytesWritten;
+    configSaveStats.lastRecordsWritten = recordCount;
+    configSaveStats.lastSaveCompacted = compact;
+    if (compact) {
+        configSaveStats.compactionCount++;
+    }
+
     return success;
 }
 
 void writeConfigToEEPROM(void)
 {
-    bool success = false;
+    const timeUs_t saveStartUs = micros();
+
+    // An invalid or damaged log can't be appended to
+    bool compact = !isEEPROMContentValid() || !eepromLogClean;
+
     // write it
-    for (int attempt = 0; attempt < 3 && !success; attempt++) {
-        if (writeSettingsToEEPROM()) {
-            success = true;
+    for (int attempt = 0; attempt < 3; attempt++) {
+        uint32_t configSize = 0;
+        bool success = writeSettingsToEEPROM(compact, &configSize);
 #ifdef CONFIG_IN_EXTERNAL_FLASH
-            // copy it back from flash to the in-memory buffer.
-            success = loadEEPROMFromExternalFlash();
+        // copy it back from flash to the in-memory buffer.
+        success = success && loadEEPROMFromExternalFlash();
 #endif
+
+        // Every segment, including the one just written, has to read back, with nothing damaged after it
+        if (success && isEEPROMContentValid() && eepromLogClean && eepromConfigSize == configSize) {
+            configSaveStats.lastDurationUs = micros() - saveStartUs;
+            configSaveStats.maxDurationUs = MAX(configSaveStats.maxDurationUs, configSaveStats.lastDurationUs);
+            configSaveStats.saveCount++;
+            return;
         }
-    }
 
-    if (success && isEEPROMContentValid()) {
-        return;
+        // A failed attempt may have left a partial segment behind, retry with a full rewrite
+        compact = true;
     }
 
     // Flash write failed - just die now
@@ -23,7 +23,18 @@
 
 #define EEPROM_CONF_VERSION 126
 
+typedef struct configSaveStats_s {
+    uint32_t lastDurationUs;
+    uint32_t maxDurationUs;
+    uint32_t lastBytesWritten;
+    uint16_t lastRecordsWritten;
+    bool lastSaveCompacted;
+    uint16_t saveCount;
+    uint16_t compactionCount;
+} configSaveStats_t;
+
 bool isEEPROMContentValid(void);
 bool loadEEPROM(void);
 void writeConfigToEEPROM(void);
-uint16_t getEEPROMConfigSize(void);
+uint32_t getEEPROMConfigSize(void);
+const configSaveStats_t *getEEPROMSaveStats(void);
@@ -29,6 +29,18 @@
     #define FLASH_PAGE_SIZE ((uint32_t)0x800)  
 #endif
 
+// Erase every sector of the config area. Segments appended after a full rewrite rely on finding the rest of it erased
+static bool eraseFLASHForEEPROM(void)
+{
+    for (uint32_t address = (uint32_t)&__config_start; address < (uint32_t)&__config_end; address += FLASH_PAGE_SIZE) {
+        if (flash_sector_erase(address) != FLASH_OPERATE_DONE) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void config_streamer_impl_unlock(void)
 {
     flash_unlock();
@@ -45,14 +57,11 @@ int config_streamer_impl_write_word(config_streamer_t *c, config_streamer_buffer
     if (c->err != 0) {
         return c->err;
     }
-    // Erases sectors from the start address
-    if (c->address % FLASH_PAGE_SIZE == 0) {
-        const flash_status_type status =flash_sector_erase(c->address);
-		   if (status != FLASH_OPERATE_DONE) {
-			   return -1;
-		   }
-	   }
-    
+    // Only a full rewrite starts at the beginning of the config area, appended segments never erase
+    if (c->address == (uintptr_t)&__config_start && !eraseFLASHForEEPROM()) {
+        return -1;
+    }
+
     const flash_status_type status = flash_word_program(c->address, *buffer);
     if (status != FLASH_OPERATE_DONE) {
         return -2;
@@ -58,10 +58,12 @@ int config_streamer_impl_write_word(config_streamer_t *c, config_streamer_buffer
         return -2; // address is past end of partition
     }
 
-    uint32_t flashSectorSize = flashGeometry->sectorSize;
-
-    if (flashAddress % flashSectorSize == 0) {
-        flashEraseSector(flashAddress);
+    // Only a full rewrite starts at the beginning of the config area, it erases all of it. Segments appended later
+    // rely on finding the rest of it erased
+    if (dataOffset == 0) {
+        for (uint32_t sectorAddress = flashStartAddress; sectorAddress < flashStartAddress + EEPROM_SIZE; sectorAddress += flashGeometry->sectorSize) {
+            flashEraseSector(sectorAddress);
+        }
     }
 
     if (flashPageProgram(flashAddress, (uint8_t *)buffer, CONFIG_STREAMER_BUFFER_SIZE) == flashAddress) {
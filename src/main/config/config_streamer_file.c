@@ -101,6 +101,11 @@ int config_streamer_impl_write_word(config_streamer_t *c, config_streamer_buffer
         return -1;
     }
 
+    if (c->address == (uintptr_t)&eepromData[0]) {
+        // Full rewrite, don't leave the tail of a longer config behind
+        memset(eepromData, 0, sizeof(eepromData));
+    }
+
     if ((c->address >= (uintptr_t)eepromData) && (c->address < (uintptr_t)ARRAYEND(eepromData))) {
         *((uint32_t*)c->address) = *buffer;
         fprintf(stderr, "[EEPROM] Program word  %p = %08x\n", (void*)c->address, *((uint32_t*)c->address));
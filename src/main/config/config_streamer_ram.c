@@ -19,6 +19,7 @@
 #include "platform.h"
 #include "drivers/system.h"
 #include "config/config_streamer.h"
+#include "common/utils.h"
 
 #if defined(CONFIG_IN_RAM)
 
@@ -70,6 +70,23 @@ static uint32_t getFLASHSectorForEEPROM(uint32_t address)
     }
 }
 
+// Erase every sector of the config area. Segments appended after a full rewrite rely on finding the rest of it erased
+static bool eraseFLASHForEEPROM(void)
+{
+    for (uint32_t address = (uint32_t)&__config_start; address < (uint32_t)&__config_end; address += FLASH_PAGE_SIZE) {
+        // The config area may be a 128K sector, erase it only once
+        if (address != (uint32_t)&__config_start && getFLASHSectorForEEPROM(address) == getFLASHSectorForEEPROM(address - FLASH_PAGE_SIZE)) {
+            continue;
+        }
+
+        if (FLASH_EraseSector(getFLASHSectorForEEPROM(address), VoltageRange_3) != FLASH_COMPLETE) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void config_streamer_impl_unlock(void)
 {
     FLASH_Unlock();
@@ -87,11 +104,9 @@ int config_streamer_impl_write_word(config_streamer_t *c, config_streamer_buffer
         return c->err;
     }
 
-    if (c->address % FLASH_PAGE_SIZE == 0) {
-        const FLASH_Status status = FLASH_EraseSector(getFLASHSectorForEEPROM(c->address), VoltageRange_3);
-        if (status != FLASH_COMPLETE) {
-            return -1;
-        }
+    // Only a full rewrite starts at the beginning of the config area, appended segments never erase
+    if (c->address == (uintptr_t)&__config_start && !eraseFLASHForEEPROM()) {
+        return -1;
     }
 
     const FLASH_Status status = FLASH_ProgramWord(c->address, *buffer);
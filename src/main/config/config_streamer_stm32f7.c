@@ -98,6 +98,31 @@ static uint32_t getFLASHSectorForEEPROM(uint32_t address)
 #  error "Unsupported CPU!"
 #endif
 
+// Erase every sector of the config area. Segments appended after a full rewrite rely on finding the rest of it erased
+static bool eraseFLASHForEEPROM(void)
+{
+    for (uint32_t address = (uint32_t)&__config_start; address < (uint32_t)&__config_end; address += FLASH_PAGE_SIZE) {
+        // FLASH_PAGE_SIZE is the smallest sector, the config area may be in a larger one
+        if (address != (uint32_t)&__config_start && getFLASHSectorForEEPROM(address) == getFLASHSectorForEEPROM(address - FLASH_PAGE_SIZE)) {
+            continue;
+        }
+
+        FLASH_EraseInitTypeDef EraseInitStruct = {
+            .TypeErase     = FLASH_TYPEERASE_SECTORS,
+            .VoltageRange  = FLASH_VOLTAGE_RANGE_3, // 2.7-3.6V
+            .NbSectors     = 1
+        };
+        EraseInitStruct.Sector = getFLASHSectorForEEPROM(address);
+
+        uint32_t SECTORError;
+        if (HAL_FLASHEx_Erase(&EraseInitStruct, &SECTORError) != HAL_OK) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void config_streamer_impl_unlock(void)
 {
     HAL_FLASH_Unlock();
@@ -114,19 +139,9 @@ int config_streamer_impl_write_word(config_streamer_t *c, config_streamer_buffer
         return c->err;
     }
 
-    if (c->address % FLASH_PAGE_SIZE == 0) {
-        FLASH_EraseInitTypeDef EraseInitStruct = {
-            .TypeErase     = FLASH_TYPEERASE_SECTORS,
-            .VoltageRange  = FLASH_VOLTAGE_RANGE_3, // 2.7-3.6V
-            .NbSectors     = 1
-        };
-        EraseInitStruct.Sector = getFLASHSectorForEEPROM(c->address);
-
-        uint32_t SECTORError;
-        const HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&EraseInitStruct, &SECTORError);
-        if (status != HAL_OK){
-            return -1;
-        }
+    // Only a full rewrite starts at the beginning of the config area, appended segments never erase
+    if (c->address == (uintptr_t)&__config_start && !eraseFLASHForEEPROM()) {
+        return -1;
     }
 
     const HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, c->address, (uint64_t)*buffer);
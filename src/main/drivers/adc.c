@@ -28,7 +28,10 @@
 #include "drivers/adc.h"
 #if defined(USE_ADC) && !defined(SITL_BUILD)
 #include "drivers/io.h"
+#include "drivers/dma.h"
+#include "drivers/nvic.h"
 
+#include "drivers/adc_decimator.h"
 #include "drivers/adc_impl.h"
 
 #ifndef ADC_INSTANCE
@@ -50,13 +53,12 @@
 
 #ifdef USE_ADC
 
-#if defined(USE_ADC_AVERAGING)
-static uint8_t activeChannelCount[ADCDEV_COUNT] = {0};
-#endif
-
 static int adcFunctionMap[ADC_FUNCTION_COUNT];
 adc_config_t adcConfig[ADC_CHN_COUNT];  // index 0 is dummy for ADC_CHN_NONE
-volatile ADC_VALUES_ALIGNMENT(uint16_t adcValues[ADCDEV_COUNT][ADC_CHN_COUNT * ADC_AVERAGE_N_SAMPLES]);
+volatile ADC_VALUES_ALIGNMENT(uint16_t adcValues[ADCDEV_COUNT][ADC_CHN_COUNT * ADC_DMA_BUFFER_SEQUENCES]);
+
+static adcDecimator_t adcDecimators[ADCDEV_COUNT];
+static uint16_t adcOutputRateHz;
 
 uint32_t adcChannelByTag(ioTag_t ioTag)
 {
@@ -78,27 +80,54 @@ bool adcIsFunctionAssigned(uint8_t function)
     return (adcFunctionMap[function] != ADC_CHN_NONE);
 }
 
-uint16_t adcGetChannel(uint8_t function)
+uint16_t adcGetChannelHighRes(uint8_t function)
 {
     int channel = adcFunctionMap[function];
     if (channel == ADC_CHN_NONE)
         return 0;
 
     if (adcConfig[channel].adcDevice != ADCINVALID && adcConfig[channel].enabled) {
-#if !defined(USE_ADC_AVERAGING)
-        return adcValues[adcConfig[channel].adcDevice][adcConfig[channel].dmaIndex];
-#else
-        uint32_t acc = 0;
-        for (int i = 0; i < ADC_AVERAGE_N_SAMPLES; i++) {
-            acc += adcValues[adcConfig[channel].adcDevice][adcConfig[channel].dmaIndex + i * activeChannelCount[adcConfig[channel].adcDevice]];
-        }
-        return acc / ADC_AVERAGE_N_SAMPLES;
-#endif
+        return adcDecimatorGetValue(&adcDecimators[adcConfig[channel].adcDevice], adcConfig[channel].dmaIndex);
     } else {
         return 0;
     }
 }
 
+uint16_t adcGetChannel(uint8_t function)
+{
+    return (adcGetChannelHighRes(function) + (1 << (ADC_DECIMATOR_FRACTION_BITS - 1))) >> ADC_DECIMATOR_FRACTION_BITS;
+}
+
+static void adcDmaIRQHandler(DMA_t dma)
+{
+    adcDecimator_t *decimator = &adcDecimators[dma->userParam];
+    const unsigned halfSequences = ADC_DMA_BUFFER_SEQUENCES / 2;
+
+    if (DMA_GET_FLAG_STATUS(dma, DMA_IT_HTIF)) {
+        DMA_CLEAR_FLAG(dma, DMA_IT_HTIF);
+        adcDecimatorProcess(decimator, &adcValues[dma->userParam][0], halfSequences);
+    }
+
+    if (DMA_GET_FLAG_STATUS(dma, DMA_IT_TCIF)) {
+        DMA_CLEAR_FLAG(dma, DMA_IT_TCIF);
+        adcDecimatorProcess(decimator, &adcValues[dma->userParam][halfSequences * decimator->channelCount], halfSequences);
+    }
+
+#if !defined(AT32F43x)
+    // HAL also enables the error interrupts, nothing to recover in circular mode
+    DMA_CLEAR_FLAG(dma, DMA_IT_TEIF | DMA_IT_DMEIF | DMA_IT_FEIF);
+#endif
+}
+
+void adcDecimationStart(ADCDevice adcDevice, DMA_t dma, uint8_t channelCount, uint32_t sequenceRateHz)
+{
+    adcDecimatorInit(&adcDecimators[adcDevice], channelCount, adcDecimatorRatio(sequenceRateHz, adcOutputRateHz));
+
+    if (dma) {
+        dmaSetHandler(dma, adcDmaIRQHandler, NVIC_PRIO_ADC_DMA, adcDevice);
+    }
+}
+
 #if defined(ADC_CHANNEL_1_PIN) || defined(ADC_CHANNEL_2_PIN) || defined(ADC_CHANNEL_3_PIN) || defined(ADC_CHANNEL_4_PIN)
 static bool isChannelInUse(int channel)
 {
@@ -125,6 +154,7 @@ static void disableChannelMapping(int channel)
 void adcInit(drv_adc_config_t *init)
 {
     memset(&adcConfig, 0, sizeof(adcConfig));
+    adcOutputRateHz = init->outputRateHz;
 
     // Remember ADC function to ADC channel mapping
     for (int i = 0; i < ADC_FUNCTION_COUNT; i++) {
@@ -141,9 +171,6 @@ void adcInit(drv_adc_config_t *init)
         adcConfig[ADC_CHN_1].adcDevice = adcDeviceByInstance(ADC_CHANNEL_1_INSTANCE);
         if (adcConfig[ADC_CHN_1].adcDevice != ADCINVALID) {
             adcConfig[ADC_CHN_1].tag = IO_TAG(ADC_CHANNEL_1_PIN);
-#if defined(USE_ADC_AVERAGING)
-            activeChannelCount[adcConfig[ADC_CHN_1].adcDevice] += 1;
-#endif
         }
     }
 #else
@@ -155,9 +182,6 @@ void adcInit(drv_adc_config_t *init)
         adcConfig[ADC_CHN_2].adcDevice = adcDeviceByInstance(ADC_CHANNEL_2_INSTANCE);
         if (adcConfig[ADC_CHN_2].adcDevice != ADCINVALID) {
             adcConfig[ADC_CHN_2].tag = IO_TAG(ADC_CHANNEL_2_PIN);
-#if defined(USE_ADC_AVERAGING)
-            activeChannelCount[adcConfig[ADC_CHN_2].adcDevice] += 1;
-#endif
         }
     }
 #else
@@ -169,9 +193,6 @@ void adcInit(drv_adc_config_t *init)
         adcConfig[ADC_CHN_3].adcDevice = adcDeviceByInstance(ADC_CHANNEL_3_INSTANCE);
         if (adcConfig[ADC_CHN_3].adcDevice != ADCINVALID) {
             adcConfig[ADC_CHN_3].tag = IO_TAG(ADC_CHANNEL_3_PIN);
-#if defined(USE_ADC_AVERAGING)
-            activeChannelCount[adcConfig[ADC_CHN_3].adcDevice] += 1;
-#endif
         }
     }
 #else
@@ -183,9 +204,6 @@ void adcInit(drv_adc_config_t *init)
         adcConfig[ADC_CHN_4].adcDevice = adcDeviceByInstance(ADC_CHANNEL_4_INSTANCE);
         if (adcConfig[ADC_CHN_4].adcDevice != ADCINVALID) {
             adcConfig[ADC_CHN_4].tag = IO_TAG(ADC_CHANNEL_4_PIN);
-#if defined(USE_ADC_AVERAGING)
-            activeChannelCount[adcConfig[ADC_CHN_4].adcDevice] += 1;
-#endif
         }
     }
 #else
@@ -204,6 +222,12 @@ uint16_t adcGetChannel(uint8_t channel)
     return 0;
 }
 
+uint16_t adcGetChannelHighRes(uint8_t channel)
+{
+    UNUSED(channel);
+    return 0;
+}
+
 #endif
 
 #else // USE_ADC
@@ -224,4 +248,10 @@ uint16_t adcGetChannel(uint8_t channel)
     UNUSED(channel);
     return 0;
 }
+
+uint16_t adcGetChannelHighRes(uint8_t channel)
+{
+    UNUSED(channel);
+    return 0;
+}
 #endif
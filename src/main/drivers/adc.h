@@ -39,17 +39,19 @@ typedef enum {
 
 typedef struct drv_adc_config_s {
     uint8_t adcFunctionChannel[ADC_FUNCTION_COUNT];
+    uint16_t outputRateHz;      // Rate of the oversampled results
 } drv_adc_config_t;
 
+// Full scale of adcGetChannelHighRes(), the 12 bit full scale with 4 bits of oversampling below it
+#define ADC_HIGHRES_MAX         0xFFF0
+
 void adcInit(drv_adc_config_t *init);
 uint16_t adcGetChannel(uint8_t channel);
+uint16_t adcGetChannelHighRes(uint8_t function);
 bool adcIsFunctionAssigned(uint8_t function);
 int adcGetFunctionChannelAllocation(uint8_t function);
 
-#if defined(USE_ADC_AVERAGING)
-#if !defined(ADC_AVERAGE_N_SAMPLES)
-#define ADC_AVERAGE_N_SAMPLES   20
-#endif
-#else
-#define ADC_AVERAGE_N_SAMPLES   1
+// Conversion sequences in the circular DMA buffer, one half is decimated while the DMA fills the other
+#if !defined(ADC_DMA_BUFFER_SEQUENCES)
+#define ADC_DMA_BUFFER_SEQUENCES    32
 #endif
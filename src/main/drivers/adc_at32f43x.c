@@ -37,6 +37,9 @@
 #define ADC1_DMA_STREAM DMA2_CHANNEL1
 #endif
 
+// ADC clock cycles per channel in a sequence, 640.5 cycles sampling and 12.5 cycles conversion
+#define ADC_CYCLES_PER_CONVERSION   (640 + 13)
+
 static adcDevice_t adcHardware[ADCDEV_COUNT] = {
     { .ADCx = ADC1, .rccADC = RCC_APB2(ADC1), .rccDMA = RCC_AHB1(DMA2), .DMAy_Channelx = ADC1_DMA_STREAM, .dmaMuxid= DMAMUX_DMAREQ_ID_ADC1,.enabled = false, .usedChannelCount = 0 },
 };
@@ -95,9 +98,9 @@ static void adcInstanceInit(ADCDevice adcDevice)
     dma_default_para_init(&dma_init_struct);
     dma_init_struct.peripheral_base_addr = (uint32_t)&adc->ADCx->odt;
     // dma buffer_size= usedChannelCount*sanmple rate
-    dma_init_struct.buffer_size = adc->usedChannelCount * ADC_AVERAGE_N_SAMPLES;
+    dma_init_struct.buffer_size = adc->usedChannelCount * ADC_DMA_BUFFER_SEQUENCES;
     dma_init_struct.peripheral_inc_enable = FALSE;
-    dma_init_struct.memory_inc_enable =  ((adc->usedChannelCount > 1) || (ADC_AVERAGE_N_SAMPLES > 1)) ? TRUE : FALSE;
+    dma_init_struct.memory_inc_enable = TRUE;
     dma_init_struct.loop_mode_enable = TRUE;
     dma_init_struct.direction = DMA_DIR_PERIPHERAL_TO_MEMORY;
     dma_init_struct.memory_base_addr = (uint32_t)adcValues[adcDevice];
@@ -105,8 +108,12 @@ static void adcInstanceInit(ADCDevice adcDevice)
     dma_init_struct.peripheral_data_width = DMA_PERIPHERAL_DATA_WIDTH_HALFWORD;  
     dma_init_struct.priority = DMA_PRIORITY_MEDIUM;
     dma_init(dmadac->ref, &dma_init_struct);
+    // Each half of the buffer is decimated once the DMA is done with it
+    crm_clocks_freq_type clocks;
+    crm_clocks_freq_get(&clocks);
+    adcDecimationStart(adcDevice, dmadac, adc->usedChannelCount, clocks.ahb_freq / 17 / (ADC_CYCLES_PER_CONVERSION * adc->usedChannelCount));  // ADC_HCLK_DIV_17
     //enable dma transfer and dma interrupt 
-    dma_interrupt_enable(dmadac->ref, DMA_FDT_INT, TRUE);
+    dma_interrupt_enable(dmadac->ref, DMA_HDT_INT | DMA_FDT_INT, TRUE);
     //AT32 DMA MUX 
     dmaMuxEnable(dmadac, adc->dmaMuxid);
     dma_channel_enable(dmadac->ref,TRUE);
@@ -115,7 +122,7 @@ static void adcInstanceInit(ADCDevice adcDevice)
     adc_common_config_type adc_common_struct;
     adc_common_default_para_init(&adc_common_struct);
     adc_common_struct.combine_mode = ADC_INDEPENDENT_MODE;
-    adc_common_struct.div = ADC_HCLK_DIV_4;
+    adc_common_struct.div = ADC_HCLK_DIV_17;
     adc_common_struct.common_dma_mode = ADC_COMMON_DMAMODE_DISABLE;
     adc_common_struct.sampling_interval = ADC_SAMPLING_INTERVAL_5CYCLES;
     adc_common_struct.tempervintrv_state = FALSE;
@@ -183,7 +190,7 @@ void adcHardwareInit(drv_adc_config_t *init)
 
         adcConfig[i].adcChannel = adcChannelByTag(adcConfig[i].tag);
         adcConfig[i].dmaIndex = adc->usedChannelCount++; 
-        adcConfig[i].sampleTime = ADC_SAMPLETIME_6_5;
+        adcConfig[i].sampleTime = ADC_SAMPLETIME_640_5;
         adcConfig[i].enabled = true;
 
         adc->enabled = true;
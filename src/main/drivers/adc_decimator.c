@@ -0,0 +1,97 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "drivers/adc_decimator.h"
+
+// Largest boxcar sum shifted to 16 bits still fits
+STATIC_ASSERT((uint64_t)ADC_DECIMATOR_MAX_DECIMATION * 0xFFF << ADC_DECIMATOR_FRACTION_BITS <= UINT32_MAX, adc_decimator_sum_overflow);
+
+void adcDecimatorInit(adcDecimator_t *decimator, uint8_t channelCount, uint16_t decimation)
+{
+    memset(decimator, 0, sizeof(*decimator));
+    decimator->channelCount = MIN(channelCount, ADC_DECIMATOR_MAX_CHANNELS);
+    decimator->decimation = constrain(decimation, 1, ADC_DECIMATOR_MAX_DECIMATION);
+}
+
+uint16_t adcDecimatorRatio(uint32_t sequenceRateHz, uint16_t outputRateHz)
+{
+    if (outputRateHz == 0) {
+        return ADC_DECIMATOR_MAX_DECIMATION;
+    }
+
+    return constrain((sequenceRateHz + outputRateHz / 2) / outputRateHz, 1, ADC_DECIMATOR_MAX_DECIMATION);
+}
+
+static void adcDecimatorOutput(adcDecimator_t *decimator)
+{
+    for (int i = 0; i < decimator->channelCount; i++) {
+        adcDecimatorChannel_t *channel = &decimator->channel[i];
+        const uint16_t boxcar = ((channel->sum << ADC_DECIMATOR_FRACTION_BITS) + decimator->decimation / 2) / decimator->decimation;
+        channel->sum = 0;
+
+        if (!decimator->primed) {
+            // No history yet, start from a settled filter instead of ramping up from zero
+            for (int tap = 0; tap < ADC_DECIMATOR_FIR_TAPS - 1; tap++) {
+                channel->history[tap] = boxcar;
+            }
+        }
+
+        channel->value = (boxcar + 3 * channel->history[0] + 3 * channel->history[1] + channel->history[2] + 4) / 8;
+
+        channel->history[2] = channel->history[1];
+        channel->history[1] = channel->history[0];
+        channel->history[0] = boxcar;
+    }
+
+    decimator->primed = true;
+    decimator->sampleCount = 0;
+    decimator->outputCount++;
+}
+
+void adcDecimatorProcess(adcDecimator_t *decimator, const volatile uint16_t *samples, unsigned sequenceCount)
+{
+    const uint8_t channelCount = decimator->channelCount;
+
+    while (sequenceCount > 0) {
+        // Sequences up to the end of the boxcar
+        const unsigned count = MIN(sequenceCount, (unsigned)(decimator->decimation - decimator->sampleCount));
+
+        for (int i = 0; i < channelCount; i++) {
+            uint32_t sum = 0;
+            for (unsigned sequence = 0; sequence < count; sequence++) {
+                sum += samples[sequence * channelCount + i];
+            }
+            decimator->channel[i].sum += sum;
+        }
+
+        samples += count * channelCount;
+        sequenceCount -= count;
+        decimator->sampleCount += count;
+
+        if (decimator->sampleCount == decimator->decimation) {
+            adcDecimatorOutput(decimator);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "drivers/adc.h"
+
+/*
+ * Oversampling of the ADC channels. The DMA fills a circular buffer with interleaved conversion sequences, each
+ * half of it is handed over once it's complete. Every channel goes through a boxcar stage, which sums up
+ * `decimation` samples, and a [1 3 3 1]/8 FIR on the boxcar outputs. The FIR takes the boxcar aliases down a lot
+ * more than a longer boxcar would. Results are kept at 16 bits, the 12 bit full scale is 0xFFF0.
+ */
+
+#define ADC_DECIMATOR_MAX_CHANNELS  ADC_CHN_MAX
+#define ADC_DECIMATOR_MAX_DECIMATION 4096
+#define ADC_DECIMATOR_FIR_TAPS      4
+#define ADC_DECIMATOR_FRACTION_BITS 4   // Bits below the 12 bit conversion result
+
+typedef struct adcDecimatorChannel_s {
+    uint32_t sum;
+    uint16_t history[ADC_DECIMATOR_FIR_TAPS - 1];   // Last boxcar outputs, newest first
+    volatile uint16_t value;
+} adcDecimatorChannel_t;
+
+typedef struct adcDecimator_s {
+    uint8_t channelCount;
+    uint16_t decimation;
+    uint16_t sampleCount;       // Samples in the current boxcar sum, same for all channels
+    bool primed;                // FIR history holds real outputs
+    volatile uint32_t outputCount;
+    adcDecimatorChannel_t channel[ADC_DECIMATOR_MAX_CHANNELS];
+} adcDecimator_t;
+
+void adcDecimatorInit(adcDecimator_t *decimator, uint8_t channelCount, uint16_t decimation);
+// Decimation that gets the output rate closest to outputRateHz from the conversion sequence rate
+uint16_t adcDecimatorRatio(uint32_t sequenceRateHz, uint16_t outputRateHz);
+// Takes sequenceCount conversion sequences of channelCount samples each, as the DMA writes them
+void adcDecimatorProcess(adcDecimator_t *decimator, const volatile uint16_t *samples, unsigned sequenceCount);
+
+static inline uint16_t adcDecimatorGetValue(const adcDecimator_t *decimator, uint8_t channel)
+{
+    return decimator->channel[channel].value;
+}
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "drivers/io_types.h"
+#include "drivers/dma.h"
 #include "rcc_types.h"
 
 #if defined(STM32F4) || defined(STM32F7) || defined(AT32F43x) 
@@ -88,9 +89,11 @@ typedef struct adc_config_s {
 
 extern const adcTagMap_t adcTagMap[ADC_TAG_MAP_COUNT];
 extern adc_config_t adcConfig[ADC_CHN_COUNT];
-extern volatile ADC_VALUES_ALIGNMENT(uint16_t adcValues[ADCDEV_COUNT][ADC_CHN_COUNT * ADC_AVERAGE_N_SAMPLES]);
+extern volatile ADC_VALUES_ALIGNMENT(uint16_t adcValues[ADCDEV_COUNT][ADC_CHN_COUNT * ADC_DMA_BUFFER_SEQUENCES]);
 
 void adcHardwareInit(drv_adc_config_t *init);
+// Called by the MCU driver once the conversions run, the DMA stream must raise the half and full transfer interrupts
+void adcDecimationStart(ADCDevice adcDevice, DMA_t dma, uint8_t channelCount, uint32_t sequenceRateHz);
 #if defined(AT32F43x) 
 ADCDevice adcDeviceByInstance(adc_type *instance);
 #else
@@ -25,6 +25,7 @@
 #include "drivers/io.h"
 #include "io_impl.h"
 #include "rcc.h"
+#include "drivers/dma.h"
 
 #include "drivers/sensor.h"
 #include "drivers/accgyro/accgyro.h"
@@ -36,6 +37,9 @@
 #define ADC1_DMA_STREAM DMA2_Stream0
 #endif
 
+// ADC clock cycles per channel in a sequence, 480 cycles sampling and 12 cycles conversion
+#define ADC_CYCLES_PER_CONVERSION   (480 + 12)
+
 static adcDevice_t adcHardware[ADCDEV_COUNT] = {
     { .ADCx = ADC1, .rccADC = RCC_APB2(ADC1), .rccDMA = RCC_AHB1(DMA2), .DMAy_Streamx = ADC1_DMA_STREAM, .channel = DMA_Channel_0, .enabled = false, .usedChannelCount = 0 },
     //{ .ADCx = ADC2, .rccADC = RCC_APB2(ADC2), .rccDMA = RCC_AHB1(DMA2), .DMAy_Streamx = DMA2_Stream1, .channel = DMA_Channel_0, .enabled = false, .usedChannelCount = 0 }
@@ -99,15 +103,23 @@ static void adcInstanceInit(ADCDevice adcDevice)
     DMA_InitStructure.DMA_Channel = adc->channel;
     DMA_InitStructure.DMA_Memory0BaseAddr = (uint32_t)adcValues[adcDevice];
     DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
-    DMA_InitStructure.DMA_BufferSize = adc->usedChannelCount * ADC_AVERAGE_N_SAMPLES;
+    DMA_InitStructure.DMA_BufferSize = adc->usedChannelCount * ADC_DMA_BUFFER_SEQUENCES;
     DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
-    DMA_InitStructure.DMA_MemoryInc = ((adc->usedChannelCount > 1) || (ADC_AVERAGE_N_SAMPLES > 1)) ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
     DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
     DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
     DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
     DMA_InitStructure.DMA_Priority = DMA_Priority_High;
     DMA_Init(adc->DMAy_Streamx, &DMA_InitStructure);
 
+    // Each half of the buffer is decimated once the DMA is done with it
+    RCC_ClocksTypeDef clocks;
+    RCC_GetClocksFreq(&clocks);
+    DMA_t dma = dmaGetByRef(adc->DMAy_Streamx);
+    dmaInit(dma, OWNER_ADC, adcDevice);
+    adcDecimationStart(adcDevice, dma, adc->usedChannelCount, clocks.PCLK2_Frequency / 8 / (ADC_CYCLES_PER_CONVERSION * adc->usedChannelCount));  // ADC_Prescaler_Div8
+    DMA_ITConfig(adc->DMAy_Streamx, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
     DMA_Cmd(adc->DMAy_Streamx, ENABLE);
 
     ADC_CommonStructInit(&ADC_CommonInitStructure);
@@ -33,6 +33,9 @@
 #include "adc.h"
 #include "adc_impl.h"
 
+// ADC clock cycles per channel in a sequence, 480 cycles sampling and 12 cycles conversion
+#define ADC_CYCLES_PER_CONVERSION   (480 + 12)
+
 static adcDevice_t adcHardware[ADCDEV_COUNT] = {
     { .ADCx = ADC1, .rccADC = RCC_APB2(ADC1), .rccDMA = RCC_AHB1(DMA2), .DMAy_Streamx = DMA2_Stream0, .channel = DMA_CHANNEL_0, .enabled = false, .usedChannelCount = 0 },
     //{ .ADCx = ADC2, .rccADC = RCC_APB2(ADC2), .rccDMA = RCC_AHB1(DMA2), .DMAy_Streamx = DMA2_Stream1, .channel = DMA_Channel_0, .enabled = false, .usedChannelCount = 0 }
@@ -110,7 +113,7 @@ static void adcInstanceInit(ADCDevice adcDevice)
     adc->DmaHandle.Init.Channel = adc->channel;
     adc->DmaHandle.Init.Direction = DMA_PERIPH_TO_MEMORY;
     adc->DmaHandle.Init.PeriphInc = DMA_PINC_DISABLE;
-    adc->DmaHandle.Init.MemInc = ((adc->usedChannelCount > 1) || (ADC_AVERAGE_N_SAMPLES > 1)) ? DMA_MINC_ENABLE : DMA_MINC_DISABLE;
+    adc->DmaHandle.Init.MemInc = DMA_MINC_ENABLE;
     adc->DmaHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
     adc->DmaHandle.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
     adc->DmaHandle.Init.Mode = DMA_CIRCULAR;
@@ -150,9 +153,14 @@ static void adcInstanceInit(ADCDevice adcDevice)
         }
     }
 
+    // Each half of the buffer is decimated once the DMA is done with it, HAL_ADC_Start_DMA() enables the interrupts
+    DMA_t dma = dmaGetByRef(adc->DMAy_Streamx);
+    dmaInit(dma, OWNER_ADC, adcDevice);
+    adcDecimationStart(adcDevice, dma, adc->usedChannelCount, HAL_RCC_GetPCLK2Freq() / 8 / (ADC_CYCLES_PER_CONVERSION * adc->usedChannelCount));  // ADC_CLOCK_SYNC_PCLK_DIV8
+
     //HAL_CLEANINVALIDATECACHE((uint32_t*)&adcValues[adcDevice], configuredAdcChannels);
     /*##-4- Start the conversion process #######################################*/
-    if (HAL_ADC_Start_DMA(&adc->ADCHandle, (uint32_t*)&adcValues[adcDevice], adc->usedChannelCount * ADC_AVERAGE_N_SAMPLES) != HAL_OK)
+    if (HAL_ADC_Start_DMA(&adc->ADCHandle, (uint32_t*)&adcValues[adcDevice], adc->usedChannelCount * ADC_DMA_BUFFER_SEQUENCES) != HAL_OK)
     {
         /* Start Conversation Error */
     }
@@ -40,6 +40,8 @@
 #include "adc.h"
 #include "adc_impl.h"
 
+// ADC clock cycles per channel in a sequence, 387.5 cycles sampling and 6.5 cycles conversion
+#define ADC_CYCLES_PER_CONVERSION   (388 + 6)
 
 static adcDevice_t adcHardware[ADCDEV_COUNT] = {
     {
@@ -167,7 +169,7 @@ static void adcInstanceInit(ADCDevice adcDevice)
     adc->DmaHandle.Init.Request = adc->channel;
     adc->DmaHandle.Init.Direction = DMA_PERIPH_TO_MEMORY;
     adc->DmaHandle.Init.PeriphInc = DMA_PINC_DISABLE;
-    adc->DmaHandle.Init.MemInc = ((adc->usedChannelCount > 1) || (ADC_AVERAGE_N_SAMPLES > 1)) ? DMA_MINC_ENABLE : DMA_MINC_DISABLE;
+    adc->DmaHandle.Init.MemInc = DMA_MINC_ENABLE;
     adc->DmaHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
     adc->DmaHandle.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
     adc->DmaHandle.Init.Mode = DMA_CIRCULAR;
@@ -203,7 +205,12 @@ static void adcInstanceInit(ADCDevice adcDevice)
         }
     }
 
-    if (HAL_ADC_Start_DMA(&adc->ADCHandle, (uint32_t*)&adcValues[adcDevice], adc->usedChannelCount * ADC_AVERAGE_N_SAMPLES) != HAL_OK) {
+    // Each half of the buffer is decimated once the DMA is done with it, HAL_ADC_Start_DMA() enables the interrupts
+    DMA_t dma = dmaGetByRef(adc->DMAy_Streamx);
+    dmaInit(dma, OWNER_ADC, adcDevice);
+    adcDecimationStart(adcDevice, dma, adc->usedChannelCount, HAL_RCC_GetHCLKFreq() / 4 / (ADC_CYCLES_PER_CONVERSION * adc->usedChannelCount));  // ADC_CLOCK_SYNC_PCLK_DIV4
+
+    if (HAL_ADC_Start_DMA(&adc->ADCHandle, (uint32_t*)&adcValues[adcDevice], adc->usedChannelCount * ADC_DMA_BUFFER_SEQUENCES) != HAL_OK) {
         return;
     }
 }
@@ -31,5 +31,9 @@ typedef struct baroDev_s {
     baroOpFuncPtr get_ut;
     baroOpFuncPtr start_up;
     baroOpFuncPtr get_up;
+    // Sensors measuring on their own set read instead of the start/get pairs. It is called every read_interval,
+    // fetches all samples queued since the previous call and returns false if there were none.
+    uint16_t read_interval;
+    baroOpFuncPtr read;
     baroCalculateFuncPtr calculate;
 } baroDev_t;
@@ -15,6 +15,7 @@
  * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -46,111 +47,90 @@ typedef struct bmp280_calib_param_s {
     int16_t dig_P7; /* calibration P7 data */
     int16_t dig_P8; /* calibration P8 data */
     int16_t dig_P9; /* calibration P9 data */
-    int32_t t_fine; /* calibration t_fine data */
 } bmp280_calib_param_t;
 
 STATIC_UNIT_TESTED bmp280_calib_param_t bmp280_cal;
-// uncompensated pressure and temperature
-int32_t bmp280_up = 0;
-int32_t bmp280_ut = 0;
 
-static bool bmp280_start_ut(baroDev_t * baro)
-{
-    UNUSED(baro);
-    return true;
-}
+// Trimming coefficients folded into the floating point compensation of the datasheet, see 8.1
+typedef struct bmp280_float_calib_s {
+    float t1, t2, t3;
+    float p1, p2, p3, p4, p5, p6, p7, p8, p9;
+} bmp280_float_calib_t;
 
-static bool bmp280_get_ut(baroDev_t * baro)
+static bmp280_float_calib_t bmp280_fcal;
+
+static float bmp280_pressure;       // Pa
+static float bmp280_temperature;    // DegC
+
+static void bmp280_scale_calibration(void)
 {
-    UNUSED(baro);
-    return true;
+    bmp280_fcal.t1 = bmp280_cal.dig_T1 / 1024.0f;
+    bmp280_fcal.t2 = bmp280_cal.dig_T2;
+    bmp280_fcal.t3 = bmp280_cal.dig_T3 / 64.0f;
+
+    bmp280_fcal.p1 = bmp280_cal.dig_P1;
+    bmp280_fcal.p2 = bmp280_cal.dig_P2 * (float)bmp280_cal.dig_P1 / 17179869184.0f;    // 2^34
+    bmp280_fcal.p3 = bmp280_cal.dig_P3 * (float)bmp280_cal.dig_P1 / 9007199254740992.0f; // 2^53
+    bmp280_fcal.p4 = bmp280_cal.dig_P4 * 16.0f;
+    bmp280_fcal.p5 = bmp280_cal.dig_P5 / 8192.0f;
+    bmp280_fcal.p6 = bmp280_cal.dig_P6 / 536870912.0f;      // 2^29
+    bmp280_fcal.p7 = bmp280_cal.dig_P7 / 16.0f;
+    bmp280_fcal.p8 = bmp280_cal.dig_P8 / 524288.0f;         // 2^19
+    bmp280_fcal.p9 = bmp280_cal.dig_P9 / 34359738368.0f;    // 2^35
 }
 
-static bool bmp280_start_up(baroDev_t * baro)
+// Returns t_fine, the temperature in DegC is t_fine / 5120
+static float bmp280_compensate_T(int32_t adc_T)
 {
-    // start measurement
-    // set oversampling + power mode (forced), and start sampling
-    busWrite(baro->busDev, BMP280_CTRL_MEAS_REG, BMP280_MODE);
-    return true;
+    const float var1 = adc_T / 16384.0f - bmp280_fcal.t1;
+    return var1 * (bmp280_fcal.t2 + var1 * bmp280_fcal.t3);
 }
 
-static bool bmp280_get_up(baroDev_t * baro)
+// Returns pressure in Pa
+static float bmp280_compensate_P(int32_t adc_P, float t_fine)
 {
-    uint8_t data[BMP280_DATA_FRAME_SIZE];
-
-    //error free measurements
-    static int32_t bmp280_up_valid;
-    static int32_t bmp280_ut_valid;
-
-    //read data from sensor
-    bool ack = busReadBuf(baro->busDev, BMP280_PRESSURE_MSB_REG, data, BMP280_DATA_FRAME_SIZE);
+    const float var1 = t_fine / 2 - 64000;
+    const float offset = bmp280_fcal.p4 + var1 * (bmp280_fcal.p5 + var1 * bmp280_fcal.p6);
+    const float sensitivity = bmp280_fcal.p1 + var1 * (bmp280_fcal.p2 + var1 * bmp280_fcal.p3);
 
-    //check if pressure and temperature readings are valid, otherwise use previous measurements from the moment
-    if (ack) {
-        bmp280_up = (int32_t)((((uint32_t)(data[0])) << 12) | (((uint32_t)(data[1])) << 4) | ((uint32_t)data[2] >> 4));
-        bmp280_ut = (int32_t)((((uint32_t)(data[3])) << 12) | (((uint32_t)(data[4])) << 4) | ((uint32_t)data[5] >> 4));
-        bmp280_up_valid = bmp280_up;
-        bmp280_ut_valid = bmp280_ut;
-    }
-    else {
-        //assign previous valid measurements
-        bmp280_up = bmp280_up_valid;
-        bmp280_ut = bmp280_ut_valid;
+    if (sensitivity == 0) {
+        return 0;
     }
 
-    return ack;
+    const float p = (1048576 - adc_P - offset) * 6250 / sensitivity;
+    return p + bmp280_fcal.p7 + p * (bmp280_fcal.p8 + p * bmp280_fcal.p9);
 }
 
-// Returns temperature in DegC, resolution is 0.01 DegC. Output value of "5123" equals 51.23 DegC
-// t_fine carries fine temperature as global value
-static int32_t bmp280_compensate_T(int32_t adc_T)
+// The sensor measures continuously, the data registers always hold the latest result
+static bool bmp280_read(baroDev_t * baro)
 {
-    int32_t var1, var2, T;
+    uint8_t data[BMP280_DATA_FRAME_SIZE];
 
-    var1 = ((((adc_T >> 3) - ((int32_t)bmp280_cal.dig_T1 << 1))) * ((int32_t)bmp280_cal.dig_T2)) >> 11;
-    var2  = (((((adc_T >> 4) - ((int32_t)bmp280_cal.dig_T1)) * ((adc_T >> 4) - ((int32_t)bmp280_cal.dig_T1))) >> 12) * ((int32_t)bmp280_cal.dig_T3)) >> 14;
-    bmp280_cal.t_fine = var1 + var2;
-    T = (bmp280_cal.t_fine * 5 + 128) >> 8;
+    //read data from sensor, keep the previous measurement on error
+    if (!busReadBuf(baro->busDev, BMP280_PRESSURE_MSB_REG, data, BMP280_DATA_FRAME_SIZE)) {
+        return false;
+    }
 
-    return T;
-}
+    const int32_t adc_P = (int32_t)((((uint32_t)(data[0])) << 12) | (((uint32_t)(data[1])) << 4) | ((uint32_t)data[2] >> 4));
+    const int32_t adc_T = (int32_t)((((uint32_t)(data[3])) << 12) | (((uint32_t)(data[4])) << 4) | ((uint32_t)data[5] >> 4));
 
-// Returns pressure in Pa as unsigned 32 bit integer in Q24.8 format (24 integer bits and 8 fractional bits).
-// Output value of "24674867" represents 24674867/256 = 96386.2 Pa = 963.862 hPa
-static uint32_t bmp280_compensate_P(int32_t adc_P)
-{
-    int64_t var1, var2, p;
-    var1 = ((int64_t)bmp280_cal.t_fine) - 128000;
-    var2 = var1 * var1 * (int64_t)bmp280_cal.dig_P6;
-    var2 = var2 + ((var1*(int64_t)bmp280_cal.dig_P5) << 17);
-    var2 = var2 + (((int64_t)bmp280_cal.dig_P4) << 35);
-    var1 = ((var1 * var1 * (int64_t)bmp280_cal.dig_P3) >> 8) + ((var1 * (int64_t)bmp280_cal.dig_P2) << 12);
-    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)bmp280_cal.dig_P1) >> 33;
-    if (var1 == 0) {
-        return 0;
-    }
+    const float t_fine = bmp280_compensate_T(adc_T);
+    bmp280_temperature = t_fine / 5120;
+    bmp280_pressure = bmp280_compensate_P(adc_P, t_fine);
 
-    p = 1048576 - adc_P;
-    p = (((p << 31) - var2) * 3125) / var1;
-    var1 = (((int64_t)bmp280_cal.dig_P9) * (p >> 13) * (p >> 13)) >> 25;
-    var2 = (((int64_t)bmp280_cal.dig_P8) * p) >> 19;
-    p = ((p + var1 + var2) >> 8) + (((int64_t)bmp280_cal.dig_P7) << 4);
-    return (uint32_t)p;
+    return true;
 }
 
 STATIC_UNIT_TESTED bool bmp280_calculate(baroDev_t * baro, int32_t * pressure, int32_t * temperature)
 {
     UNUSED(baro);
 
-    int32_t t = bmp280_compensate_T(bmp280_ut);
-    uint32_t p = bmp280_compensate_P(bmp280_up);
-
     if (pressure) {
-        *pressure = (int32_t)(p / 256);
+        *pressure = lrintf(bmp280_pressure);
     }
 
     if (temperature) {
-        *temperature = t;
+        *temperature = lrintf(bmp280_temperature * 100);
     }
 
     return true;
@@ -189,21 +169,18 @@ bool bmp280Detect(baroDev_t *baro)
     }
 
     // read calibration
-    busReadBuf(baro->busDev, BMP280_TEMPERATURE_CALIB_DIG_T1_LSB_REG, (uint8_t *)&bmp280_cal, 24);
+    busReadBuf(baro->busDev, BMP280_TEMPERATURE_CALIB_DIG_T1_LSB_REG, (uint8_t *)&bmp280_cal, BMP280_PRESSURE_TEMPERATURE_CALIB_DATA_LENGTH);
+    bmp280_scale_calibration();
 
-    //set filter setting
-    busWrite(baro->busDev, BMP280_CONFIG_REG, BMP280_FILTER);
+    //set standby time and filter setting
+    busWrite(baro->busDev, BMP280_CONFIG_REG, BMP280_STANDBY | BMP280_FILTER);
 
-    // set oversampling + power mode (forced), and start sampling
+    // set oversampling + power mode (normal), and start sampling
     busWrite(baro->busDev, BMP280_CTRL_MEAS_REG, BMP280_MODE);
 
-    baro->ut_delay = 0;
-    baro->get_ut = bmp280_get_ut;
-    baro->start_ut = bmp280_start_ut;
-
-    baro->up_delay = ((T_INIT_MAX + T_MEASURE_PER_OSRS_MAX * (((1 << BMP280_TEMPERATURE_OSR) >> 1) + ((1 << BMP280_PRESSURE_OSR) >> 1)) + (BMP280_PRESSURE_OSR ? T_SETUP_PRESSURE_MAX : 0) + 15) / 16) * 1000;
-    baro->start_up = bmp280_start_up;
-    baro->get_up = bmp280_get_up;
+    // the chip has no FIFO, read each result once
+    baro->read_interval = ((T_INIT_MAX + T_MEASURE_PER_OSRS_MAX * (((1 << BMP280_TEMPERATURE_OSR) >> 1) + ((1 << BMP280_PRESSURE_OSR) >> 1)) + (BMP280_PRESSURE_OSR ? T_SETUP_PRESSURE_MAX : 0) + T_STANDBY + 15) / 16) * 1000;
+    baro->read = bmp280_read;
 
     baro->calculate = bmp280_calculate;
 
@@ -32,6 +32,7 @@
 #define BMP280_TEMPERATURE_LSB_REG           (0xFB)  /* Temperature LSB Reg */
 #define BMP280_TEMPERATURE_XLSB_REG          (0xFC)  /* Temperature XLSB Reg */
 #define BMP280_FORCED_MODE                   (0x01)
+#define BMP280_NORMAL_MODE                   (0x03)
 
 #define BMP280_TEMPERATURE_CALIB_DIG_T1_LSB_REG             (0x88)
 #define BMP280_PRESSURE_TEMPERATURE_CALIB_DATA_LENGTH       (24)
@@ -51,13 +52,16 @@
 #define BMP280_FILTER_COEFF_16                (0x04)
 
 
-// configure pressure and temperature oversampling, forced sampling mode
+#define BMP280_STANDBY_0_5_MS                 (0x00)
+
+// configure pressure and temperature oversampling, normal sampling mode
 #define BMP280_PRESSURE_OSR              (BMP280_OVERSAMP_8X)
 #define BMP280_TEMPERATURE_OSR           (BMP280_OVERSAMP_1X)
-#define BMP280_MODE                      (BMP280_PRESSURE_OSR << 2 | BMP280_TEMPERATURE_OSR << 5 | BMP280_FORCED_MODE)
+#define BMP280_MODE                      (BMP280_PRESSURE_OSR << 2 | BMP280_TEMPERATURE_OSR << 5 | BMP280_NORMAL_MODE)
 
-//configure IIR pressure filter
+//configure IIR pressure filter and standby time between measurements
 #define BMP280_FILTER                    (BMP280_FILTER_COEFF_8 << 2)
+#define BMP280_STANDBY                   (BMP280_STANDBY_0_5_MS << 5)
 
 #define T_INIT_MAX                       (20)
 // 20/16 = 1.25 ms
@@ -65,6 +69,8 @@
 // 37/16 = 2.3125 ms
 #define T_SETUP_PRESSURE_MAX             (10)
 // 10/16 = 0.625 ms
+#define T_STANDBY                        (8)
+// 8/16 = 0.5 ms
 
 bool bmp280Detect(baroDev_t *baro);
 
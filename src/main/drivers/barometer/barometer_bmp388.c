@@ -21,6 +21,7 @@
  * INAV port: Michel Pastor
  */
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
@@ -28,8 +29,9 @@
 #include <platform.h>
 #include "build/build_config.h"
 #include "build/debug.h"
-#include "common/utils.h"
 #include "common/log.h" // XXX
+#include "common/maths.h"
+#include "common/utils.h"
 
 #include "drivers/time.h"
 #include "drivers/io.h"
@@ -97,7 +99,9 @@
 // from Datasheet 3.3
 #define BMP388_MODE_SLEEP                               (0x00)
 #define BMP388_MODE_FORCED                              (0x01)
-#define BMP388_MODE_NORMAL                              (0x02)
+#define BMP388_MODE_NORMAL                              (0x03)
+
+#define BMP388_CMD_FIFO_FLUSH                           (0xB0)
 
 #define BMP388_CALIRATION_LOWER_REG                     (0x30) // See datasheet 4.3.19, "calibration data"
 #define BMP388_TRIMMING_NVM_PAR_T1_LSB_REG              (0x31) // See datasheet 3.11.1 "Memory map trimming coefficients"
@@ -129,9 +133,27 @@
 #define BMP388_OSR_P_MASK                   (0x03)  // -----111
 #define BMP388_OSR4_T_MASK                  (0x38)  // --111---
 
-// configure pressure and temperature oversampling, forced sampling mode
+// FIFO_CONFIG_1 register
+#define BMP388_FIFO_MODE_BIT                0
+#define BMP388_FIFO_STOP_ON_FULL_BIT        1
+#define BMP388_FIFO_TIME_EN_BIT             2
+#define BMP388_FIFO_PRESS_EN_BIT            3
+#define BMP388_FIFO_TEMP_EN_BIT             4
+
+// FIFO frame headers, see datasheet 3.6
+#define BMP388_FIFO_FRAME_PRESS_TEMP        (0x94)
+#define BMP388_FIFO_FRAME_CONFIG_CHANGE     (0x48)
+#define BMP388_FIFO_FRAME_CONFIG_ERROR      (0x44)
+#define BMP388_FIFO_FRAME_SIZE              (7)     // Header, temperature and pressure
+#define BMP388_FIFO_READ_FRAMES             (8)     // Read at most this many at once
+
+#define BMP388_ODR_50HZ                     (0x02)
+#define BMP388_ODR_INTERVAL_US              (20000)
+
+// configure pressure and temperature oversampling, normal mode at 50Hz with the samples queued in the FIFO
 #define BMP388_PRESSURE_OSR              (BMP388_OVERSAMP_8X)
 #define BMP388_TEMPERATURE_OSR           (BMP388_OVERSAMP_1X)
+#define BMP388_READ_INTERVAL_US          (2 * BMP388_ODR_INTERVAL_US)
 
 // see Datasheet 3.11.1 Memory Map Trimming Coefficients
 typedef struct bmp388_calib_param_s {
@@ -154,140 +176,117 @@ typedef struct bmp388_calib_param_s {
 STATIC_ASSERT(sizeof(bmp388_calib_param_t) == BMP388_TRIMMING_DATA_LENGTH, bmp388_calibration_structure_incorrectly_packed);
 
 static bmp388_calib_param_t bmp388_cal;
-// uncompensated pressure and temperature
-static uint32_t bmp388_up = 0;
-static uint32_t bmp388_ut = 0;
-static uint8_t sensor_data[BMP388_DATA_FRAME_SIZE+1];
 
-static int64_t t_lin = 0;
+// Trimming coefficients scaled as in the floating point compensation of the datasheet, see 8.4 and 8.5
+typedef struct bmp388_float_calib_s {
+    float t1, t2, t3;
+    float p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11;
+} bmp388_float_calib_t;
 
-static bool bmp388StartUT(baroDev_t *baro);
-static bool bmp388GetUT(baroDev_t *baro);
-static bool bmp388StartUP(baroDev_t *baro);
-static bool bmp388GetUP(baroDev_t *baro);
+static bmp388_float_calib_t bmp388_fcal;
 
-static bool bmp388Calculate(baroDev_t *baro, int32_t *pressure, int32_t *temperature);
+// Average of the samples read last
+static float bmp388_pressure;       // Pa
+static float bmp388_temperature;    // DegC
 
-static bool bmp388BeginForcedMeasurement(busDevice_t *busdev)
+static void bmp388ScaleCalibration(void)
 {
-    // enable pressure measurement, temperature measurement, set power mode and start sampling
-    uint8_t mode = BMP388_MODE_FORCED << 4 | 1 << 1 | 1 << 0;
-    return busWrite(busdev, BMP388_PWR_CTRL_REG, mode);
+    bmp388_fcal.t1 = bmp388_cal.T1 * 256.0f;                // 2^-8
+    bmp388_fcal.t2 = bmp388_cal.T2 / 1073741824.0f;         // 2^30
+    bmp388_fcal.t3 = bmp388_cal.T3 / 281474976710656.0f;    // 2^48
+
+    bmp388_fcal.p1 = (bmp388_cal.P1 - 16384) / 1048576.0f;  // 2^20
+    bmp388_fcal.p2 = (bmp388_cal.P2 - 16384) / 536870912.0f; // 2^29
+    bmp388_fcal.p3 = bmp388_cal.P3 / 4294967296.0f;         // 2^32
+    bmp388_fcal.p4 = bmp388_cal.P4 / 137438953472.0f;       // 2^37
+    bmp388_fcal.p5 = bmp388_cal.P5 * 8.0f;                  // 2^-3
+    bmp388_fcal.p6 = bmp388_cal.P6 / 64.0f;                 // 2^6
+    bmp388_fcal.p7 = bmp388_cal.P7 / 256.0f;                // 2^8
+    bmp388_fcal.p8 = bmp388_cal.P8 / 32768.0f;              // 2^15
+    bmp388_fcal.p9 = bmp388_cal.P9 / 281474976710656.0f;    // 2^48
+    bmp388_fcal.p10 = bmp388_cal.P10 / 281474976710656.0f;  // 2^48
+    bmp388_fcal.p11 = bmp388_cal.P11 / 36893488147419103232.0f; // 2^65
 }
 
-static bool bmp388StartUT(baroDev_t *baro)
+// Returns temperature in DegC
+static float bmp388CompensateTemperature(uint32_t uncomp_temperature)
 {
-    UNUSED(baro);
-    // dummy
-    return true;
+    const float partial_data1 = (float)uncomp_temperature - bmp388_fcal.t1;
+    return partial_data1 * bmp388_fcal.t2 + partial_data1 * partial_data1 * bmp388_fcal.t3;
 }
 
-static bool bmp388GetUT(baroDev_t *baro)
+// Returns pressure in Pa
+static float bmp388CompensatePressure(uint32_t uncomp_pressure, float temperature)
 {
-    UNUSED(baro);
-    // dummy
-    return true;
-}
+    const float t = temperature;
+    const float p = uncomp_pressure;
 
-static bool bmp388StartUP(baroDev_t *baro)
-{
-    // start measurement
-    return bmp388BeginForcedMeasurement(baro->busDev);
+    const float offset = bmp388_fcal.p5 + t * (bmp388_fcal.p6 + t * (bmp388_fcal.p7 + t * bmp388_fcal.p8));
+    const float sensitivity = bmp388_fcal.p1 + t * (bmp388_fcal.p2 + t * (bmp388_fcal.p3 + t * bmp388_fcal.p4));
+
+    return offset + p * (sensitivity + p * (bmp388_fcal.p9 + t * bmp388_fcal.p10 + p * bmp388_fcal.p11));
 }
 
-static bool bmp388GetUP(baroDev_t *baro)
+/*
+ * The sensor measures at 50Hz and queues the results in its FIFO, every frame that is there is
+ * fetched with a single burst read. Frames cut off at the end of the read stay in the FIFO for the next one.
+ */
+static bool bmp388ReadFIFO(baroDev_t *baro)
 {
-    if (baro->busDev->busType == BUSTYPE_SPI) {
-        // In SPI mode, first byte read is a dummy byte
-        busReadBuf(baro->busDev, BMP388_DATA_0_REG, &sensor_data[0], BMP388_DATA_FRAME_SIZE + 1);
-    } else {
-        // In I2C mode, no dummy byte is read
-        busReadBuf(baro->busDev, BMP388_DATA_0_REG, &sensor_data[1], BMP388_DATA_FRAME_SIZE);
+    // In SPI mode, first byte read is a dummy byte
+    const uint8_t offset = (baro->busDev->busType == BUSTYPE_SPI) ? 1 : 0;
+    uint8_t buf[BMP388_FIFO_READ_FRAMES * BMP388_FIFO_FRAME_SIZE + 1];
+
+    if (!busReadBuf(baro->busDev, BMP388_FIFO_LENGTH_0_REG, buf, 2 + offset)) {
+        return false;
     }
 
-    bmp388_up = sensor_data[1] << 0 | sensor_data[2] << 8 | sensor_data[3] << 16;
-    bmp388_ut = sensor_data[4] << 0 | sensor_data[5] << 8 | sensor_data[6] << 16;
-    return true;
-}
+    const uint16_t length = MIN(buf[offset] | (buf[offset + 1] & 0x01) << 8, BMP388_FIFO_READ_FRAMES * BMP388_FIFO_FRAME_SIZE);
+    if (length == 0 || !busReadBuf(baro->busDev, BMP388_FIFO_DATA_REG, buf, length + offset)) {
+        return false;
+    }
 
-// Returns temperature in DegC, resolution is 0.01 DegC. Output value of "5123" equals 51.23 DegC
-static int64_t bmp388CompensateTemperature(uint32_t uncomp_temperature)
-{
-    uint64_t partial_data1;
-    uint64_t partial_data2;
-    uint64_t partial_data3;
-    int64_t partial_data4;
-    int64_t partial_data5;
-    int64_t partial_data6;
-    int64_t comp_temp;
-
-    partial_data1 = uncomp_temperature - (256 * bmp388_cal.T1);
-    partial_data2 = bmp388_cal.T2 * partial_data1;
-    partial_data3 = partial_data1 * partial_data1;
-    partial_data4 = (int64_t)partial_data3 * bmp388_cal.T3;
-    partial_data5 = ((int64_t)(partial_data2 * 262144) + partial_data4);
-    partial_data6 = partial_data5 / 4294967296;
-    /* Update t_lin, needed for pressure calculation */
-    t_lin = partial_data6;
-    comp_temp = (int64_t)((partial_data6 * 25)  / 16384);
-
-    return comp_temp;
-}
+    const uint8_t *frame = &buf[offset];
+    const uint8_t *end = frame + length;
+    float pressureSum = 0;
+    float temperatureSum = 0;
+    int samples = 0;
+
+    while (frame < end) {
+        if (frame[0] == BMP388_FIFO_FRAME_PRESS_TEMP && frame + BMP388_FIFO_FRAME_SIZE <= end) {
+            const uint32_t ut = frame[1] << 0 | frame[2] << 8 | frame[3] << 16;
+            const uint32_t up = frame[4] << 0 | frame[5] << 8 | frame[6] << 16;
+            const float temperature = bmp388CompensateTemperature(ut);
+
+            temperatureSum += temperature;
+            pressureSum += bmp388CompensatePressure(up, temperature);
+            samples++;
+            frame += BMP388_FIFO_FRAME_SIZE;
+        } else if (frame[0] == BMP388_FIFO_FRAME_CONFIG_CHANGE || frame[0] == BMP388_FIFO_FRAME_CONFIG_ERROR) {
+            frame += 2;
+        } else {
+            // Empty or partial frame
+            break;
+        }
+    }
 
-static uint64_t bmp388CompensatePressure(uint32_t uncomp_pressure)
-{
-    int64_t partial_data1;
-    int64_t partial_data2;
-    int64_t partial_data3;
-    int64_t partial_data4;
-    int64_t partial_data5;
-    int64_t partial_data6;
-    int64_t offset;
-    int64_t sensitivity;
-    uint64_t comp_press;
-
-    partial_data1 = t_lin * t_lin;
-    partial_data2 = partial_data1 / 64;
-    partial_data3 = (partial_data2 * t_lin) / 256;
-    partial_data4 = (bmp388_cal.P8 * partial_data3) / 32;
-    partial_data5 = (bmp388_cal.P7 * partial_data1) * 16;
-    partial_data6 = (bmp388_cal.P6 * t_lin) * 4194304;
-    offset = (bmp388_cal.P5 * 140737488355328) + partial_data4 + partial_data5 + partial_data6;
-
-    partial_data2 = (bmp388_cal.P4 * partial_data3) / 32;
-    partial_data4 = (bmp388_cal.P3 * partial_data1) * 4;
-    partial_data5 = (bmp388_cal.P2 - 16384) * t_lin * 2097152;
-    sensitivity = ((bmp388_cal.P1 - 16384) * 70368744177664) + partial_data2 + partial_data4 + partial_data5;
-
-    partial_data1 = (sensitivity / 16777216) * uncomp_pressure;
-    partial_data2 = bmp388_cal.P10 * t_lin;
-    partial_data3 = partial_data2 + (65536 * bmp388_cal.P9);
-    partial_data4 = (partial_data3 * uncomp_pressure) / 8192;
-    partial_data5 = (partial_data4 * uncomp_pressure) / 512;
-    partial_data6 = (int64_t)((uint64_t)uncomp_pressure * (uint64_t)uncomp_pressure);
-    partial_data2 = (bmp388_cal.P11 * partial_data6) / 65536;
-    partial_data3 = (partial_data2 * uncomp_pressure) / 128;
-    partial_data4 = (offset / 4) + partial_data1 + partial_data5 + partial_data3;
-    comp_press = (((uint64_t)partial_data4 * 25) / (uint64_t)1099511627776);
-
-    return comp_press;
+    if (samples == 0) {
+        return false;
+    }
+
+    bmp388_pressure = pressureSum / samples;
+    bmp388_temperature = temperatureSum / samples;
+    return true;
 }
 
 STATIC_UNIT_TESTED bool bmp388Calculate(baroDev_t *baro, int32_t *pressure, int32_t *temperature)
 {
     UNUSED(baro);
 
-    // calculate
-    int64_t t;
-    int64_t p;
-
-    t = bmp388CompensateTemperature(bmp388_ut);
-    p = bmp388CompensatePressure(bmp388_up);
-
     if (pressure)
-        *pressure = (int32_t)(p / 256);
+        *pressure = lrintf(bmp388_pressure);
     if (temperature)
-        *temperature = t;
+        *temperature = lrintf(bmp388_temperature * 100);
 
     return true;
 }
@@ -347,21 +346,25 @@ bool bmp388Detect(baroDev_t *baro)
         busReadBuf(baro->busDev, BMP388_TRIMMING_NVM_PAR_T1_LSB_REG, (uint8_t*)&bmp388_cal, sizeof(bmp388_calib_param_t));
     }
 
-    // set oversampling + power mode (forced), and start sampling
+    bmp388ScaleCalibration();
+
+    // set oversampling and output data rate
     busWrite(baro->busDev, BMP388_OSR_REG,
         ((BMP388_PRESSURE_OSR << BMP388_OSR_P_BIT) & BMP388_OSR_P_MASK) |
         ((BMP388_TEMPERATURE_OSR << BMP388_OSR4_T_BIT) & BMP388_OSR4_T_MASK)
     );
+    busWrite(baro->busDev, BMP388_ODR_REG, BMP388_ODR_50HZ);
 
-    bmp388BeginForcedMeasurement(baro->busDev);
+    // queue pressure and temperature of every sample, no subsampling
+    busWrite(baro->busDev, BMP388_FIFO_CONFIG_2_REG, 0);
+    busWrite(baro->busDev, BMP388_FIFO_CONFIG_1_REG, 1 << BMP388_FIFO_MODE_BIT | 1 << BMP388_FIFO_PRESS_EN_BIT | 1 << BMP388_FIFO_TEMP_EN_BIT);
+    busWrite(baro->busDev, BMP388_CMD_REG, BMP388_CMD_FIFO_FLUSH);
 
-    baro->ut_delay = 0;
-    baro->get_ut = bmp388GetUT;
-    baro->start_ut = bmp388StartUT;
+    // enable pressure measurement, temperature measurement, set power mode (normal) and start sampling
+    busWrite(baro->busDev, BMP388_PWR_CTRL_REG, BMP388_MODE_NORMAL << 4 | 1 << 1 | 1 << 0);
 
-    baro->up_delay = 234 + (392 + ((1 << (BMP388_PRESSURE_OSR + 1)) * 2000)) + (313 + ((1 << (BMP388_TEMPERATURE_OSR + 1)) * 2000));
-    baro->start_up = bmp388StartUP;
-    baro->get_up = bmp388GetUP;
+    baro->read_interval = BMP388_READ_INTERVAL_US;
+    baro->read = bmp388ReadFIFO;
 
     baro->calculate = bmp388Calculate;
 
@@ -63,6 +63,7 @@
 #define DPS310_ID_REV_AND_PROD_ID       (0x10)
 
 #define DPS310_RESET_BIT_SOFT_RST       (0x09)    // 0b1001
+#define DPS310_RESET_BIT_FIFO_FLUSH     (0x80)
 
 #define DPS310_MEAS_CFG_COEF_RDY        (1 << 7)
 #define DPS310_MEAS_CFG_SENSOR_RDY      (1 << 6)
@@ -78,12 +79,24 @@
 #define DPS310_PRS_CFG_BIT_PM_PRC_16    (0x04)      // 0100 - 16 times (Standard).
 
 #define DPS310_TMP_CFG_BIT_TMP_EXT          (0x80)
-#define DPS310_TMP_CFG_BIT_TMP_RATE_32HZ    (0x50)  //  101 - 32 measurements pr. sec.
+#define DPS310_TMP_CFG_BIT_TMP_RATE_1HZ     (0x00)  //  000 - 1 measurement pr. sec.
 #define DPS310_TMP_CFG_BIT_TMP_PRC_16       (0x04)  // 0100 - 16 times (Standard).
 
+#define DPS310_CFG_REG_BIT_FIFO_EN          (0x02)
 #define DPS310_CFG_REG_BIT_P_SHIFT          (0x04)
 #define DPS310_CFG_REG_BIT_T_SHIFT          (0x08)
 
+// Results in the FIFO are told apart by the LSB, an empty FIFO reads as the most negative value
+#define DPS310_FIFO_SIZE                    32
+#define DPS310_FIFO_RESULT_TEMPERATURE      (0x000001)
+#define DPS310_FIFO_EMPTY                   (0x800000)
+
+// Pressure is queued at 32Hz, a read gets a bit more than one result
+#define DPS310_READ_INTERVAL_US             (1000000 / 25)
+
+// Scaling factors kT (for temperature) and kP (for pressure) of the chosen precision rate, see Table 9
+#define DPS310_SCALE_FACTOR_PRC_16          253952.0f
+
 #define DPS310_COEF_SRCE_BIT_TMP_COEF_SRCE  (0x80)
 
 typedef struct {
@@ -98,9 +111,18 @@ typedef struct {
     int16_t c30;    // 16bit
 } calibrationCoefficients_t;
 
+// Coefficients with the scaling of the raw values folded in, see section 4.9 of datasheet
+typedef struct {
+    float c0, c1;
+    float c00, c10, c20, c30;
+    float c01, c11, c21;
+} scaledCoefficients_t;
+
 typedef struct {
     calibrationCoefficients_t   calib;
-    float                       pressure;       // Pa
+    scaledCoefficients_t        scaled;
+    int32_t                     Traw;           // Latest temperature result
+    float                       pressure;       // Pa, average of the samples read last
     float                       temperature;    // DegC
 } baroState_t;
 
@@ -199,6 +221,19 @@ static bool deviceConfigure(busDevice_t * busDev)
     // 0x20 c30 [15:8] + 0x21 c30 [7:0]
     baroState.calib.c30 = getTwosComplement(((uint32_t)coef[16] << 8) | (uint32_t)coef[17], 16);
 
+    const float kP = DPS310_SCALE_FACTOR_PRC_16;
+    const float kT = DPS310_SCALE_FACTOR_PRC_16;
+
+    baroState.scaled.c0 = baroState.calib.c0 * 0.5f;
+    baroState.scaled.c1 = baroState.calib.c1 / kT;
+    baroState.scaled.c00 = baroState.calib.c00;
+    baroState.scaled.c10 = baroState.calib.c10 / kP;
+    baroState.scaled.c20 = baroState.calib.c20 / (kP * kP);
+    baroState.scaled.c30 = baroState.calib.c30 / (kP * kP * kP);
+    baroState.scaled.c01 = baroState.calib.c01 / kT;
+    baroState.scaled.c11 = baroState.calib.c11 / (kP * kT);
+    baroState.scaled.c21 = baroState.calib.c21 / (kP * kP * kT);
+
     // MEAS_CFG: Make sure the device is in IDLE mode
     registerWriteBits(busDev, DPS310_REG_MEAS_CFG, DPS310_MEAS_CFG_MEAS_CTRL_MASK, DPS310_MEAS_CFG_MEAS_IDLE);
 
@@ -210,19 +245,26 @@ static bool deviceConfigure(busDevice_t * busDev)
     registerWrite(busDev, 0x0E, 0x00);
     registerWrite(busDev, 0x0F, 0x00);
 
-    // Make ONE temperature measurement and flush it
+    // Make ONE temperature measurement, it compensates the pressure until the FIFO brings a new one
     registerWriteBits(busDev, DPS310_REG_MEAS_CFG, DPS310_MEAS_CFG_MEAS_CTRL_MASK, DPS310_MEAS_CFG_MEAS_TEMP_SING);
     delay(40);
 
+    uint8_t buf[3];
+    if (!busReadBuf(busDev, DPS310_REG_TMP_B2, buf, 3)) {
+        return false;
+    }
+    baroState.Traw = getTwosComplement((buf[0] << 16) + (buf[1] << 8) + buf[2], 24);
+
     // PRS_CFG: pressure measurement rate (32 Hz) and oversampling (16 time standard)
     registerSetBits(busDev, DPS310_REG_PRS_CFG, DPS310_PRS_CFG_BIT_PM_RATE_32HZ | DPS310_PRS_CFG_BIT_PM_PRC_16);
 
-    // TMP_CFG: temperature measurement rate (32 Hz) and oversampling (16 times)
+    // TMP_CFG: temperature measurement rate (1 Hz) and oversampling (16 times), leaves time for 32 pressure measurements
     const uint8_t TMP_COEF_SRCE = registerRead(busDev, DPS310_REG_COEF_SRCE) & DPS310_COEF_SRCE_BIT_TMP_COEF_SRCE;
-    registerSetBits(busDev, DPS310_REG_TMP_CFG, DPS310_TMP_CFG_BIT_TMP_RATE_32HZ | DPS310_TMP_CFG_BIT_TMP_PRC_16 | TMP_COEF_SRCE);
+    registerSetBits(busDev, DPS310_REG_TMP_CFG, DPS310_TMP_CFG_BIT_TMP_RATE_1HZ | DPS310_TMP_CFG_BIT_TMP_PRC_16 | TMP_COEF_SRCE);
 
-    // CFG_REG: set pressure and temperature result bit-shift (required when the oversampling rate is >8 times)
-    registerSetBits(busDev, DPS310_REG_CFG_REG, DPS310_CFG_REG_BIT_T_SHIFT | DPS310_CFG_REG_BIT_P_SHIFT);
+    // CFG_REG: set pressure and temperature result bit-shift (required when the oversampling rate is >8 times), queue the results in the FIFO
+    registerSetBits(busDev, DPS310_REG_CFG_REG, DPS310_CFG_REG_BIT_T_SHIFT | DPS310_CFG_REG_BIT_P_SHIFT | DPS310_CFG_REG_BIT_FIFO_EN);
+    registerWrite(busDev, DPS310_REG_RESET, DPS310_RESET_BIT_FIFO_FLUSH);
 
     // MEAS_CFG: Continuous pressure and temperature measurement
     registerWriteBits(busDev, DPS310_REG_MEAS_CFG, DPS310_MEAS_CFG_MEAS_CTRL_MASK, DPS310_MEAS_CFG_MEAS_CTRL_CONT);
@@ -230,50 +272,50 @@ static bool deviceConfigure(busDevice_t * busDev)
     return true;
 }
 
-static bool deviceReadMeasurement(baroDev_t *baro)
+// See section 4.9, How to Calculate Compensated Pressure and Temperature Values, of datasheet
+static float deviceCompensatePressure(int32_t Praw, int32_t Traw)
 {
-    // 1. Check if pressure is ready
-    bool pressure_ready = registerRead(baro->busDev, DPS310_REG_MEAS_CFG) & DPS310_MEAS_CFG_PRS_RDY;
-    if (!pressure_ready) {
-        return false;
-    }
+    const scaledCoefficients_t *c = &baroState.scaled;
+    const float P = Praw;
+    const float T = Traw;
 
-    // 2. Choose scaling factors kT (for temperature) and kP (for pressure) based on the chosen precision rate.
-    // The scaling factors are listed in Table 9.
-    static float kT = 253952; // 16 times (Standard)
-    static float kP = 253952; // 16 times (Standard)
+    return c->c00 + P * (c->c10 + P * (c->c20 + P * c->c30)) + T * c->c01 + T * P * (c->c11 + P * c->c21);
+}
 
-    // 3. Read the pressure and temperature result from the registers
-    // Read PSR_B2, PSR_B1, PSR_B0, TMP_B2, TMP_B1, TMP_B0
-    uint8_t buf[6];
-    if (!busReadBuf(baro->busDev, DPS310_REG_PSR_B2, buf, 6)) {
-        return false;
-    }
+/*
+ * Each read of the pressure registers takes the oldest result out of the FIFO, they are read until
+ * it is empty. Temperature results come once a second and are kept to compensate the pressures after them.
+ */
+static bool deviceReadFIFO(baroDev_t *baro)
+{
+    float pressureSum = 0;
+    int samples = 0;
 
-    const int32_t Praw = getTwosComplement((buf[0] << 16) + (buf[1] << 8) + buf[2], 24);
-    const int32_t Traw = getTwosComplement((buf[3] << 16) + (buf[4] << 8) + buf[5], 24);
+    for (int i = 0; i < DPS310_FIFO_SIZE; i++) {
+        uint8_t buf[3];
+        if (!busReadBuf(baro->busDev, DPS310_REG_PSR_B2, buf, 3)) {
+            break;
+        }
 
-    // 4. Calculate scaled measurement results.
-    const float Praw_sc = Praw / kP;
-    const float Traw_sc = Traw / kT;
+        const uint32_t result = (buf[0] << 16) + (buf[1] << 8) + buf[2];
+        if (result == DPS310_FIFO_EMPTY) {
+            break;
+        }
 
-    // 5. Calculate compensated measurement results.
-    const float c00 = baroState.calib.c00;
-    const float c01 = baroState.calib.c01;
-    const float c10 = baroState.calib.c10;
-    const float c11 = baroState.calib.c11;
-    const float c20 = baroState.calib.c20;
-    const float c21 = baroState.calib.c21;
-    const float c30 = baroState.calib.c30;
+        if (result & DPS310_FIFO_RESULT_TEMPERATURE) {
+            baroState.Traw = getTwosComplement(result, 24);
+        } else {
+            pressureSum += deviceCompensatePressure(getTwosComplement(result, 24), baroState.Traw);
+            samples++;
+        }
+    }
 
-    // See section 4.9.1, How to Calculate Compensated Pressure Values, of datasheet
-    baroState.pressure = c00 + Praw_sc * (c10 + Praw_sc * (c20 + Praw_sc * c30)) + Traw_sc * c01 + Traw_sc * Praw_sc * (c11 + Praw_sc * c21);
+    if (samples == 0) {
+        return false;
+    }
 
-    const float c0 = baroState.calib.c0;
-    const float c1 = baroState.calib.c1;
-    
-    // See section 4.9.2, How to Calculate Compensated Temperature Values, of datasheet
-    baroState.temperature = c0 * 0.5f + c1 * Traw_sc;
+    baroState.pressure = pressureSum / samples;
+    baroState.temperature = baroState.scaled.c0 + baroState.scaled.c1 * baroState.Traw;
 
     return true;
 }
@@ -330,15 +372,8 @@ bool baroDPS310Detect(baroDev_t *baro)
         return false;
     }
 
-    const uint32_t baroDelay = 1000000 / 32 / 2;      // twice the sample rate to capture all new data
-
-    baro->ut_delay = 0;
-    baro->start_ut = NULL;
-    baro->get_ut = NULL;
-
-    baro->up_delay = baroDelay;
-    baro->start_up = NULL;
-    baro->get_up = deviceReadMeasurement;
+    baro->read_interval = DPS310_READ_INTERVAL_US;
+    baro->read = deviceReadFIFO;
 
     baro->calculate = deviceCalculate;
 
@@ -47,9 +47,20 @@ typedef struct {
 
 
 spl06_coeffs_t spl06_cal;
-// uncompensated pressure and temperature
-static int32_t spl06_pressure_raw = 0;
+
+// Coefficients with the scaling of the raw values folded in
+typedef struct {
+    float c0, c1;
+    float c00, c10, c20, c30;
+    float c01, c11, c21;
+} spl06_scaled_coeffs_t;
+
+static spl06_scaled_coeffs_t spl06_scaled;
+// latest temperature result, compensates the pressures after it
 static int32_t spl06_temperature_raw = 0;
+// average of the samples read last
+static float spl06_pressure = 0;       // Pa
+static float spl06_temperature = 0;    // DegC
 
 static int8_t spl06_samples_to_cfg_reg_value(uint8_t sample_rate)
 {
@@ -83,64 +94,78 @@ static int32_t spl06_raw_value_scale_factor(uint8_t oversampling_rate)
     }
 }
 
-static bool spl06_start_temperature_measurement(baroDev_t * baro)
+static int32_t spl06_raw_value(const uint8_t *data)
 {
-    return busWrite(baro->busDev, SPL06_MODE_AND_STATUS_REG, SPL06_MEAS_TEMPERATURE);
+    return (int32_t)((data[0] & 0x80 ? 0xFF000000 : 0) | (((uint32_t)(data[0])) << 16) | (((uint32_t)(data[1])) << 8) | ((uint32_t)data[2]));
 }
 
-static bool spl06_read_temperature(baroDev_t * baro)
+static void spl06_scale_coefficients(void)
 {
-    uint8_t data[SPL06_TEMPERATURE_LEN];
-    int32_t spl06_temperature;
-
-    bool ack = busReadBuf(baro->busDev, SPL06_TEMPERATURE_START_REG, data, SPL06_TEMPERATURE_LEN);
-
-    if (ack) {
-        spl06_temperature = (int32_t)((data[0] & 0x80 ? 0xFF000000 : 0) | (((uint32_t)(data[0])) << 16) | (((uint32_t)(data[1])) << 8) | ((uint32_t)data[2]));
-        spl06_temperature_raw = spl06_temperature;
-    }
-
-    return ack;
+    const float kp = spl06_raw_value_scale_factor(SPL06_PRESSURE_OVERSAMPLING);
+    const float kt = spl06_raw_value_scale_factor(SPL06_TEMPERATURE_OVERSAMPLING);
+
+    spl06_scaled.c0 = (float)spl06_cal.c0 / 2;
+    spl06_scaled.c1 = spl06_cal.c1 / kt;
+    spl06_scaled.c00 = spl06_cal.c00;
+    spl06_scaled.c10 = spl06_cal.c10 / kp;
+    spl06_scaled.c20 = spl06_cal.c20 / (kp * kp);
+    spl06_scaled.c30 = spl06_cal.c30 / (kp * kp * kp);
+    spl06_scaled.c01 = spl06_cal.c01 / kt;
+    spl06_scaled.c11 = spl06_cal.c11 / (kp * kt);
+    spl06_scaled.c21 = spl06_cal.c21 / (kp * kp * kt);
 }
 
-static bool spl06_start_pressure_measurement(baroDev_t * baro)
+// Returns temperature in degrees centigrade
+static float spl06_compensate_temperature(int32_t temperature_raw)
 {
-    return busWrite(baro->busDev, SPL06_MODE_AND_STATUS_REG, SPL06_MEAS_PRESSURE);
+    return spl06_scaled.c0 + temperature_raw * spl06_scaled.c1;
 }
 
-static bool spl06_read_pressure(baroDev_t * baro)
+// Returns pressure in Pascal
+static float spl06_compensate_pressure(int32_t pressure_raw, int32_t temperature_raw)
 {
-    uint8_t data[SPL06_PRESSURE_LEN];
-    int32_t spl06_pressure;
+    const float p_raw = pressure_raw;
+    const float t_raw = temperature_raw;
 
-    bool ack = busReadBuf(baro->busDev, SPL06_PRESSURE_START_REG, data, SPL06_PRESSURE_LEN);
+    const float pressure_cal = spl06_scaled.c00 + p_raw * (spl06_scaled.c10 + p_raw * (spl06_scaled.c20 + p_raw * spl06_scaled.c30));
+    const float p_temp_comp = t_raw * (spl06_scaled.c01 + p_raw * (spl06_scaled.c11 + p_raw * spl06_scaled.c21));
 
-    if (ack) {
-        spl06_pressure = (int32_t)((data[0] & 0x80 ? 0xFF000000 : 0) | (((uint32_t)(data[0])) << 16) | (((uint32_t)(data[1])) << 8) | ((uint32_t)data[2]));
-        spl06_pressure_raw = spl06_pressure;
-    }
-
-    return ack;
+    return pressure_cal + p_temp_comp;
 }
 
-// Returns temperature in degrees centigrade
-static float spl06_compensate_temperature(int32_t temperature_raw)
+// Each read of the pressure registers takes the oldest result out of the FIFO, they are read until it is empty
+static bool spl06_read_fifo(baroDev_t * baro)
 {
-    const float t_raw_sc = (float)temperature_raw / spl06_raw_value_scale_factor(SPL06_TEMPERATURE_OVERSAMPLING);
-    const float temp_comp = (float)spl06_cal.c0 / 2 + t_raw_sc * spl06_cal.c1;
-    return temp_comp;
-}
+    float pressure_sum = 0;
+    int samples = 0;
 
-// Returns pressure in Pascal
-static float spl06_compensate_pressure(int32_t pressure_raw, int32_t temperature_raw)
-{
-    const float p_raw_sc = (float)pressure_raw / spl06_raw_value_scale_factor(SPL06_PRESSURE_OVERSAMPLING);
-    const float t_raw_sc = (float)temperature_raw / spl06_raw_value_scale_factor(SPL06_TEMPERATURE_OVERSAMPLING);
+    for (int i = 0; i < SPL06_FIFO_SIZE; i++) {
+        uint8_t data[SPL06_PRESSURE_LEN];
+        if (!busReadBuf(baro->busDev, SPL06_PRESSURE_START_REG, data, SPL06_PRESSURE_LEN)) {
+            break;
+        }
 
-    const float pressure_cal = (float)spl06_cal.c00 + p_raw_sc * ((float)spl06_cal.c10 + p_raw_sc * ((float)spl06_cal.c20 + p_raw_sc * spl06_cal.c30));
-    const float p_temp_comp = t_raw_sc * ((float)spl06_cal.c01 + p_raw_sc * ((float)spl06_cal.c11 + p_raw_sc * spl06_cal.c21));
+        const int32_t result = spl06_raw_value(data);
+        if (result == SPL06_FIFO_EMPTY) {
+            break;
+        }
 
-    return pressure_cal + p_temp_comp;
+        if (result & SPL06_FIFO_RESULT_TEMPERATURE) {
+            spl06_temperature_raw = result;
+        } else {
+            pressure_sum += spl06_compensate_pressure(result, spl06_temperature_raw);
+            samples++;
+        }
+    }
+
+    if (samples == 0) {
+        return false;
+    }
+
+    spl06_pressure = pressure_sum / samples;
+    spl06_temperature = spl06_compensate_temperature(spl06_temperature_raw);
+
+    return true;
 }
 
 bool spl06_calculate(baroDev_t * baro, int32_t * pressure, int32_t * temperature)
@@ -148,11 +173,11 @@ bool spl06_calculate(baroDev_t * baro, int32_t * pressure, int32_t * temperature
     UNUSED(baro);
 
     if (pressure) {
-        *pressure = lrintf(spl06_compensate_pressure(spl06_pressure_raw, spl06_temperature_raw));
+        *pressure = lrintf(spl06_pressure);
     }
 
     if (temperature) {
-        *temperature = lrintf(spl06_compensate_temperature(spl06_temperature_raw) * 100);
+        *temperature = lrintf(spl06_temperature * 100);
     }
 
     return true;
@@ -201,17 +226,28 @@ static bool spl06_configure_measurements(baroDev_t *baro)
 {
     uint8_t reg_value;
 
-    reg_value = SPL06_TEMP_USE_EXT_SENSOR | spl06_samples_to_cfg_reg_value(SPL06_TEMPERATURE_OVERSAMPLING);
+    reg_value = SPL06_TEMP_USE_EXT_SENSOR | SPL06_TEMPERATURE_RATE | spl06_samples_to_cfg_reg_value(SPL06_TEMPERATURE_OVERSAMPLING);
     if (!busWrite(baro->busDev, SPL06_TEMPERATURE_CFG_REG, reg_value)) {
         return false;
     }
 
-    reg_value = spl06_samples_to_cfg_reg_value(SPL06_PRESSURE_OVERSAMPLING);
+    reg_value = SPL06_PRESSURE_RATE | spl06_samples_to_cfg_reg_value(SPL06_PRESSURE_OVERSAMPLING);
     if (!busWrite(baro->busDev, SPL06_PRESSURE_CFG_REG, reg_value)) {
         return false;
     }
 
-    reg_value = 0;
+    // one temperature measurement compensates the pressure until the FIFO brings a new one
+    uint8_t data[SPL06_TEMPERATURE_LEN];
+    if (!busWrite(baro->busDev, SPL06_MODE_AND_STATUS_REG, SPL06_MEAS_TEMPERATURE)) {
+        return false;
+    }
+    delay(SPL06_MEASUREMENT_TIME(SPL06_TEMPERATURE_OVERSAMPLING));
+    if (!busReadBuf(baro->busDev, SPL06_TEMPERATURE_START_REG, data, SPL06_TEMPERATURE_LEN)) {
+        return false;
+    }
+    spl06_temperature_raw = spl06_raw_value(data);
+
+    reg_value = SPL06_FIFO_ENABLE;
     if (SPL06_TEMPERATURE_OVERSAMPLING > 8) {
         reg_value |= SPL06_TEMPERATURE_RESULT_BIT_SHIFT;
     }
@@ -222,7 +258,9 @@ static bool spl06_configure_measurements(baroDev_t *baro)
         return false;
     }
 
-    return true;
+    // measure continuously, results queue in the FIFO
+    return busWrite(baro->busDev, SPL06_RST_REG, SPL06_FIFO_FLUSH) &&
+           busWrite(baro->busDev, SPL06_MODE_AND_STATUS_REG, SPL06_MEAS_CFG_CONTINUOUS | SPL06_MEAS_TEMPERATURE | SPL06_MEAS_PRESSURE);
 }
 
 bool spl06Detect(baroDev_t *baro)
@@ -239,13 +277,10 @@ bool spl06Detect(baroDev_t *baro)
         return false;
     }
 
-    baro->ut_delay = SPL06_MEASUREMENT_TIME(SPL06_TEMPERATURE_OVERSAMPLING) * 1000;
-    baro->get_ut = spl06_read_temperature;
-    baro->start_ut = spl06_start_temperature_measurement;
+    spl06_scale_coefficients();
 
-    baro->up_delay = SPL06_MEASUREMENT_TIME(SPL06_PRESSURE_OVERSAMPLING) * 1000;
-    baro->start_up = spl06_start_pressure_measurement;
-    baro->get_up = spl06_read_pressure;
+    baro->read_interval = SPL06_READ_INTERVAL_US;
+    baro->read = spl06_read_fifo;
 
     baro->calculate = spl06_calculate;
 
@@ -57,12 +57,25 @@
 #define SPL06_MEAS_CFG_COEFFS_RDY              (1<<7)
 
 // INT_AND_FIFO_CFG_REG
+#define SPL06_FIFO_ENABLE                      (1<<1)
 #define SPL06_PRESSURE_RESULT_BIT_SHIFT        (1<<2)  // necessary for pressure oversampling > 8
 #define SPL06_TEMPERATURE_RESULT_BIT_SHIFT     (1<<3)  // necessary for temperature oversampling > 8
 
+// RST_REG
+#define SPL06_FIFO_FLUSH                       (1<<7)
+
+// FIFO results are told apart by the LSB, an empty FIFO reads as the most negative value
+#define SPL06_FIFO_SIZE                        32
+#define SPL06_FIFO_RESULT_TEMPERATURE          (1<<0)
+#define SPL06_FIFO_EMPTY                       (-8388608)  // 0x800000
+
+#define SPL06_PRESSURE_RATE                    (5<<4)  // 32 measurements per second
+#define SPL06_TEMPERATURE_RATE                 (0<<4)  // 1 measurement per second
 #define SPL06_PRESSURE_OVERSAMPLING            8       // oversampling 8
 #define SPL06_TEMPERATURE_OVERSAMPLING         8       // oversampling 8
 
+#define SPL06_READ_INTERVAL_US                 (1000000 / 25)
+
 #define SPL06_MEASUREMENT_TIME(oversampling)   ((2 + lrintf(oversampling * 1.6)) + 1) // ms
 
 bool spl06Detect(baroDev_t *baro);
@@ -26,6 +26,7 @@
 
 #include "platform.h"
 #include "build/debug.h"
+#include "build/trace.h"
 
 #include "common/memory.h"
 
@@ -238,7 +239,7 @@ void * busDeviceGetScratchpadMemory(const busDevice_t * dev)
     return (void *)dev->scratchpad;
 }
 
-bool busTransfer(const busDevice_t * dev, uint8_t * rxBuf, const uint8_t * txBuf, int length)
+static bool busTransferUntraced(const busDevice_t * dev, uint8_t * rxBuf, const uint8_t * txBuf, int length)
 {
 #ifdef USE_SPI
     return spiBusTransfer(dev, rxBuf, txBuf, length);
@@ -252,7 +253,15 @@ bool busTransfer(const busDevice_t * dev, uint8_t * rxBuf, const uint8_t * txBuf
     return false;
 }
 
-bool busTransferMultiple(const busDevice_t * dev, busTransferDescriptor_t * dsc, int count)
+bool busTransfer(const busDevice_t * dev, uint8_t * rxBuf, const uint8_t * txBuf, int length)
+{
+    TRACE_BEGIN(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    const bool result = busTransferUntraced(dev, rxBuf, txBuf, length);
+    TRACE_END(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    return result;
+}
+
+static bool busTransferMultipleUntraced(const busDevice_t * dev, busTransferDescriptor_t * dsc, int count)
 {
 #ifdef USE_SPI
     // busTransfer function is only supported on SPI bus
@@ -268,7 +277,15 @@ bool busTransferMultiple(const busDevice_t * dev, busTransferDescriptor_t * dsc,
     return false;
 }
 
-bool busWriteBuf(const busDevice_t * dev, uint8_t reg, const uint8_t * data, uint8_t length)
+bool busTransferMultiple(const busDevice_t * dev, busTransferDescriptor_t * dsc, int count)
+{
+    TRACE_BEGIN(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    const bool result = busTransferMultipleUntraced(dev, dsc, count);
+    TRACE_END(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    return result;
+}
+
+static bool busWriteBufUntraced(const busDevice_t * dev, uint8_t reg, const uint8_t * data, uint8_t length)
 {
 #if !defined(USE_SPI) && !defined(USE_I2C)
     UNUSED(reg);
@@ -301,7 +318,15 @@ bool busWriteBuf(const busDevice_t * dev, uint8_t reg, const uint8_t * data, uin
     }
 }
 
-bool busWrite(const busDevice_t * dev, uint8_t reg, uint8_t data)
+bool busWriteBuf(const busDevice_t * dev, uint8_t reg, const uint8_t * data, uint8_t length)
+{
+    TRACE_BEGIN(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    const bool result = busWriteBufUntraced(dev, reg, data, length);
+    TRACE_END(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    return result;
+}
+
+static bool busWriteUntraced(const busDevice_t * dev, uint8_t reg, uint8_t data)
 {
 #if !defined(USE_SPI) && !defined(USE_I2C)
     UNUSED(reg);
@@ -333,7 +358,15 @@ bool busWrite(const busDevice_t * dev, uint8_t reg, uint8_t data)
     }
 }
 
-bool busReadBuf(const busDevice_t * dev, uint8_t reg, uint8_t * data, uint8_t length)
+bool busWrite(const busDevice_t * dev, uint8_t reg, uint8_t data)
+{
+    TRACE_BEGIN(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    const bool result = busWriteUntraced(dev, reg, data);
+    TRACE_END(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    return result;
+}
+
+static bool busReadBufUntraced(const busDevice_t * dev, uint8_t reg, uint8_t * data, uint8_t length)
 {
 #if !defined(USE_SPI) && !defined(USE_I2C)
     UNUSED(reg);
@@ -365,7 +398,15 @@ bool busReadBuf(const busDevice_t * dev, uint8_t reg, uint8_t * data, uint8_t le
     }
 }
 
-bool busRead(const busDevice_t * dev, uint8_t reg, uint8_t * data)
+bool busReadBuf(const busDevice_t * dev, uint8_t reg, uint8_t * data, uint8_t length)
+{
+    TRACE_BEGIN(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    const bool result = busReadBufUntraced(dev, reg, data, length);
+    TRACE_END(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    return result;
+}
+
+static bool busReadUntraced(const busDevice_t * dev, uint8_t reg, uint8_t * data)
 {
 #if !defined(USE_SPI) && !defined(USE_I2C)
     UNUSED(reg);
@@ -396,6 +437,14 @@ bool busRead(const busDevice_t * dev, uint8_t reg, uint8_t * data)
     }
 }
 
+bool busRead(const busDevice_t * dev, uint8_t reg, uint8_t * data)
+{
+    TRACE_BEGIN(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    const bool result = busReadUntraced(dev, reg, data);
+    TRACE_END(TRACE_EVENT_BUS, dev->descriptorPtr->devHwType);
+    return result;
+}
+
 void busSelectDevice(const busDevice_t * dev)
 {
 #ifdef USE_SPI
@@ -278,3 +278,24 @@ bool displayCanvasGetWidgets(displayWidgets_t *widgets, const displayCanvas_t *d
 {
     return displayCanvas && displayCanvas->vTable->getWidgets ? displayCanvas->vTable->getWidgets(widgets, displayCanvas) : false;
 }
+
+void displayCanvasBeginGroup(displayCanvas_t *displayCanvas, unsigned group)
+{
+    if (displayCanvas->vTable->beginGroup) {
+        displayCanvas->vTable->beginGroup(displayCanvas, group);
+    }
+}
+
+void displayCanvasEndGroup(displayCanvas_t *displayCanvas)
+{
+    if (displayCanvas->vTable->endGroup) {
+        displayCanvas->vTable->endGroup(displayCanvas);
+    }
+}
+
+void displayCanvasInvalidateGroup(displayCanvas_t *displayCanvas, unsigned group)
+{
+    if (displayCanvas->vTable->invalidateGroup) {
+        displayCanvas->vTable->invalidateGroup(displayCanvas, group);
+    }
+}
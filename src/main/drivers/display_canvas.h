@@ -53,10 +53,12 @@ typedef enum {
 } displayCanvasOutlineType_e;
 
 typedef struct displayCanvasVTable_s displayCanvasVTable_t;
+typedef struct displayList_s displayList_t;
 
 typedef struct displayCanvas_s {
     const displayCanvasVTable_t *vTable;
     void *device;
+    displayList_t *displayList;     // Set when the drawing is recorded by drivers/display_list.c
     uint16_t width;
     uint16_t height;
     uint8_t gridElementWidth;
@@ -104,6 +106,11 @@ typedef struct displayCanvasVTable_s {
     void (*contextPop)(displayCanvas_t *displayCanvas);
 
     bool (*getWidgets)(displayWidgets_t *widgets, const displayCanvas_t *displayCanvas);
+
+    // Groups of primitives which draw one widget, see drivers/display_list.h
+    void (*beginGroup)(displayCanvas_t *displayCanvas, unsigned group);
+    void (*endGroup)(displayCanvas_t *displayCanvas);
+    void (*invalidateGroup)(displayCanvas_t *displayCanvas, unsigned group);
 } displayCanvasVTable_t;
 
 void displayCanvasSetStrokeColor(displayCanvas_t *displayCanvas, displayCanvasColor_e color);
@@ -146,3 +153,7 @@ void displayCanvasContextPush(displayCanvas_t *displayCanvas);
 void displayCanvasContextPop(displayCanvas_t *displayCanvas);
 
 bool displayCanvasGetWidgets(displayWidgets_t *widgets, const displayCanvas_t *displayCanvas);
+
+void displayCanvasBeginGroup(displayCanvas_t *displayCanvas, unsigned group);
+void displayCanvasEndGroup(displayCanvas_t *displayCanvas);
+void displayCanvasInvalidateGroup(displayCanvas_t *displayCanvas, unsigned group);
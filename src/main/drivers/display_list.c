@@ -0,0 +1,1028 @@
+/*
+ * This file is part of INAV.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 3, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "drivers/display_list.h"
+
+#define DISPLAY_LIST_STATE_UNKNOWN      0xFF    // Default of the display, after a reset
+#define DISPLAY_LIST_STATE_DIRTY        0xFE    // Display state lost, set again before the next drawing
+
+#define DISPLAY_LIST_MAX_STRING         64      // Longer strings are sent without recording them
+#define DISPLAY_LIST_MAX_COMMAND        (1 + 2 * 2 + 3 + DISPLAY_LIST_MAX_STRING)   // Op, position, options, color, length and string
+
+#define FNV_OFFSET_BASIS                2166136261u
+#define FNV_PRIME                       16777619u
+
+typedef enum {
+    DISPLAY_LIST_OP_SET_STROKE_COLOR,
+    DISPLAY_LIST_OP_SET_FILL_COLOR,
+    DISPLAY_LIST_OP_SET_STROKE_AND_FILL_COLOR,
+    DISPLAY_LIST_OP_SET_COLOR_INVERSION,
+    DISPLAY_LIST_OP_SET_PIXEL,
+    DISPLAY_LIST_OP_SET_PIXEL_TO_STROKE_COLOR,
+    DISPLAY_LIST_OP_SET_PIXEL_TO_FILL_COLOR,
+    DISPLAY_LIST_OP_SET_STROKE_WIDTH,
+    DISPLAY_LIST_OP_SET_LINE_OUTLINE_TYPE,
+    DISPLAY_LIST_OP_SET_LINE_OUTLINE_COLOR,
+    DISPLAY_LIST_OP_CLIP_TO_RECT,
+    DISPLAY_LIST_OP_CLEAR_RECT,
+    DISPLAY_LIST_OP_RESET_DRAWING_STATE,
+    DISPLAY_LIST_OP_DRAW_CHARACTER,
+    DISPLAY_LIST_OP_DRAW_CHARACTER_MASK,
+    DISPLAY_LIST_OP_DRAW_STRING,
+    DISPLAY_LIST_OP_DRAW_STRING_MASK,
+    DISPLAY_LIST_OP_MOVE_TO_POINT,
+    DISPLAY_LIST_OP_STROKE_LINE_TO_POINT,
+    DISPLAY_LIST_OP_STROKE_TRIANGLE,
+    DISPLAY_LIST_OP_FILL_TRIANGLE,
+    DISPLAY_LIST_OP_FILL_STROKE_TRIANGLE,
+    DISPLAY_LIST_OP_STROKE_RECT,
+    DISPLAY_LIST_OP_FILL_RECT,
+    DISPLAY_LIST_OP_FILL_STROKE_RECT,
+    DISPLAY_LIST_OP_STROKE_ELLIPSE_IN_RECT,
+    DISPLAY_LIST_OP_FILL_ELLIPSE_IN_RECT,
+    DISPLAY_LIST_OP_FILL_STROKE_ELLIPSE_IN_RECT,
+    DISPLAY_LIST_OP_CTM_RESET,
+    DISPLAY_LIST_OP_CTM_SET,
+    DISPLAY_LIST_OP_CTM_TRANSLATE,
+    DISPLAY_LIST_OP_CTM_SCALE,
+    DISPLAY_LIST_OP_CTM_ROTATE,
+    DISPLAY_LIST_OP_CONTEXT_PUSH,
+    DISPLAY_LIST_OP_CONTEXT_POP,
+} displayListOp_e;
+
+// One primitive, encoded for the recording
+typedef struct displayListCommand_s {
+    uint8_t length;
+    uint8_t data[DISPLAY_LIST_MAX_COMMAND];
+} displayListCommand_t;
+
+typedef struct displayListReader_s {
+    const uint8_t *data;
+    unsigned pos;
+} displayListReader_t;
+
+static const displayListState_t displayListUnknownState = {
+    .strokeColor = DISPLAY_LIST_STATE_UNKNOWN,
+    .fillColor = DISPLAY_LIST_STATE_UNKNOWN,
+    .strokeWidth = DISPLAY_LIST_STATE_UNKNOWN,
+    .outlineType = DISPLAY_LIST_STATE_UNKNOWN,
+    .outlineColor = DISPLAY_LIST_STATE_UNKNOWN,
+    .colorInversion = DISPLAY_LIST_STATE_UNKNOWN,
+};
+
+static const displayListState_t displayListDirtyState = {
+    .strokeColor = DISPLAY_LIST_STATE_DIRTY,
+    .fillColor = DISPLAY_LIST_STATE_DIRTY,
+    .strokeWidth = DISPLAY_LIST_STATE_DIRTY,
+    .outlineType = DISPLAY_LIST_STATE_DIRTY,
+    .outlineColor = DISPLAY_LIST_STATE_DIRTY,
+    .colorInversion = DISPLAY_LIST_STATE_DIRTY,
+};
+
+static void commandInit(displayListCommand_t *cmd, displayListOp_e op)
+{
+    cmd->data[0] = op;
+    cmd->length = 1;
+}
+
+static void commandPutU8(displayListCommand_t *cmd, uint8_t v)
+{
+    cmd->data[cmd->length++] = v;
+}
+
+static void commandPutInt(displayListCommand_t *cmd, int v)
+{
+    const int16_t v16 = v;
+    memcpy(&cmd->data[cmd->length], &v16, sizeof(v16));
+    cmd->length += sizeof(v16);
+}
+
+static void commandPutFloat(displayListCommand_t *cmd, float v)
+{
+    memcpy(&cmd->data[cmd->length], &v, sizeof(v));
+    cmd->length += sizeof(v);
+}
+
+static void commandPutString(displayListCommand_t *cmd, const char *s, unsigned len)
+{
+    commandPutU8(cmd, len);
+    memcpy(&cmd->data[cmd->length], s, len);
+    cmd->length += len;
+}
+
+static uint8_t readU8(displayListReader_t *r)
+{
+    return r->data[r->pos++];
+}
+
+static int readInt(displayListReader_t *r)
+{
+    int16_t v;
+    memcpy(&v, &r->data[r->pos], sizeof(v));
+    r->pos += sizeof(v);
+    return v;
+}
+
+static float readFloat(displayListReader_t *r)
+{
+    float v;
+    memcpy(&v, &r->data[r->pos], sizeof(v));
+    r->pos += sizeof(v);
+    return v;
+}
+
+static void readRect(displayListReader_t *r, int *x, int *y, int *w, int *h)
+{
+    *x = readInt(r);
+    *y = readInt(r);
+    *w = readInt(r);
+    *h = readInt(r);
+}
+
+static void readTriangle(displayListReader_t *r, int *v)
+{
+    for (int ii = 0; ii < 6; ii++) {
+        v[ii] = readInt(r);
+    }
+}
+
+// Sends one recorded primitive to the display, returns its length
+static unsigned displayListExecute(displayList_t *list, const uint8_t *data)
+{
+    const displayCanvasVTable_t *t = list->target;
+    displayCanvas_t *canvas = list->canvas;
+    displayListReader_t r = { .data = data, .pos = 0 };
+    int x, y, w, h;
+    int v[6];
+    float m[6];
+    char s[DISPLAY_LIST_MAX_STRING + 1];
+
+    const displayListOp_e op = readU8(&r);
+    switch (op) {
+        case DISPLAY_LIST_OP_SET_STROKE_COLOR:
+            x = readU8(&r);
+            if (t->setStrokeColor) {
+                t->setStrokeColor(canvas, x);
+            }
+            break;
+        case DISPLAY_LIST_OP_SET_FILL_COLOR:
+            x = readU8(&r);
+            if (t->setFillColor) {
+                t->setFillColor(canvas, x);
+            }
+            break;
+        case DISPLAY_LIST_OP_SET_STROKE_AND_FILL_COLOR:
+            x = readU8(&r);
+            if (t->setStrokeAndFillColor) {
+                t->setStrokeAndFillColor(canvas, x);
+            } else {
+                if (t->setStrokeColor) {
+                    t->setStrokeColor(canvas, x);
+                }
+                if (t->setFillColor) {
+                    t->setFillColor(canvas, x);
+                }
+            }
+            break;
+        case DISPLAY_LIST_OP_SET_COLOR_INVERSION:
+            x = readU8(&r);
+            if (t->setColorInversion) {
+                t->setColorInversion(canvas, x);
+            }
+            break;
+        case DISPLAY_LIST_OP_SET_PIXEL:
+            x = readInt(&r);
+            y = readInt(&r);
+            w = readU8(&r);
+            if (t->setPixel) {
+                t->setPixel(canvas, x, y, w);
+            }
+            break;
+        case DISPLAY_LIST_OP_SET_PIXEL_TO_STROKE_COLOR:
+            x = readInt(&r);
+            y = readInt(&r);
+            if (t->setPixelToStrokeColor) {
+                t->setPixelToStrokeColor(canvas, x, y);
+            }
+            break;
+        case DISPLAY_LIST_OP_SET_PIXEL_TO_FILL_COLOR:
+            x = readInt(&r);
+            y = readInt(&r);
+            if (t->setPixelToFillColor) {
+                t->setPixelToFillColor(canvas, x, y);
+            }
+            break;
+        case DISPLAY_LIST_OP_SET_STROKE_WIDTH:
+            x = readU8(&r);
+            if (t->setStrokeWidth) {
+                t->setStrokeWidth(canvas, x);
+            }
+            break;
+        case DISPLAY_LIST_OP_SET_LINE_OUTLINE_TYPE:
+            x = readU8(&r);
+            if (t->setLineOutlineType) {
+                t->setLineOutlineType(canvas, x);
+            }
+            break;
+        case DISPLAY_LIST_OP_SET_LINE_OUTLINE_COLOR:
+            x = readU8(&r);
+            if (t->setLineOutlineColor) {
+                t->setLineOutlineColor(canvas, x);
+            }
+            break;
+        case DISPLAY_LIST_OP_CLIP_TO_RECT:
+            readRect(&r, &x, &y, &w, &h);
+            if (t->clipToRect) {
+                t->clipToRect(canvas, x, y, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_CLEAR_RECT:
+            readRect(&r, &x, &y, &w, &h);
+            if (t->clearRect) {
+                t->clearRect(canvas, x, y, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_RESET_DRAWING_STATE:
+            if (t->resetDrawingState) {
+                t->resetDrawingState(canvas);
+            }
+            break;
+        case DISPLAY_LIST_OP_DRAW_CHARACTER:
+            x = readInt(&r);
+            y = readInt(&r);
+            w = (uint16_t)readInt(&r);
+            h = readU8(&r);
+            if (t->drawCharacter) {
+                t->drawCharacter(canvas, x, y, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_DRAW_CHARACTER_MASK:
+            x = readInt(&r);
+            y = readInt(&r);
+            w = (uint16_t)readInt(&r);
+            h = readU8(&r);
+            v[0] = readU8(&r);
+            if (t->drawCharacterMask) {
+                t->drawCharacterMask(canvas, x, y, w, v[0], h);
+            }
+            break;
+        case DISPLAY_LIST_OP_DRAW_STRING:
+        case DISPLAY_LIST_OP_DRAW_STRING_MASK:
+            x = readInt(&r);
+            y = readInt(&r);
+            h = readU8(&r);
+            w = op == DISPLAY_LIST_OP_DRAW_STRING_MASK ? readU8(&r) : 0;
+            v[0] = readU8(&r);
+            memcpy(s, &r.data[r.pos], v[0]);
+            s[v[0]] = '\0';
+            r.pos += v[0];
+            if (op == DISPLAY_LIST_OP_DRAW_STRING && t->drawString) {
+                t->drawString(canvas, x, y, s, h);
+            } else if (op == DISPLAY_LIST_OP_DRAW_STRING_MASK && t->drawStringMask) {
+                t->drawStringMask(canvas, x, y, s, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_MOVE_TO_POINT:
+            x = readInt(&r);
+            y = readInt(&r);
+            if (t->moveToPoint) {
+                t->moveToPoint(canvas, x, y);
+            }
+            break;
+        case DISPLAY_LIST_OP_STROKE_LINE_TO_POINT:
+            x = readInt(&r);
+            y = readInt(&r);
+            if (t->strokeLineToPoint) {
+                t->strokeLineToPoint(canvas, x, y);
+            }
+            break;
+        case DISPLAY_LIST_OP_STROKE_TRIANGLE:
+            readTriangle(&r, v);
+            if (t->strokeTriangle) {
+                t->strokeTriangle(canvas, v[0], v[1], v[2], v[3], v[4], v[5]);
+            }
+            break;
+        case DISPLAY_LIST_OP_FILL_TRIANGLE:
+            readTriangle(&r, v);
+            if (t->fillTriangle) {
+                t->fillTriangle(canvas, v[0], v[1], v[2], v[3], v[4], v[5]);
+            }
+            break;
+        case DISPLAY_LIST_OP_FILL_STROKE_TRIANGLE:
+            readTriangle(&r, v);
+            if (t->fillStrokeTriangle) {
+                t->fillStrokeTriangle(canvas, v[0], v[1], v[2], v[3], v[4], v[5]);
+            }
+            break;
+        case DISPLAY_LIST_OP_STROKE_RECT:
+            readRect(&r, &x, &y, &w, &h);
+            if (t->strokeRect) {
+                t->strokeRect(canvas, x, y, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_FILL_RECT:
+            readRect(&r, &x, &y, &w, &h);
+            if (t->fillRect) {
+                t->fillRect(canvas, x, y, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_FILL_STROKE_RECT:
+            readRect(&r, &x, &y, &w, &h);
+            if (t->fillStrokeRect) {
+                t->fillStrokeRect(canvas, x, y, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_STROKE_ELLIPSE_IN_RECT:
+            readRect(&r, &x, &y, &w, &h);
+            if (t->strokeEllipseInRect) {
+                t->strokeEllipseInRect(canvas, x, y, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_FILL_ELLIPSE_IN_RECT:
+            readRect(&r, &x, &y, &w, &h);
+            if (t->fillEllipseInRect) {
+                t->fillEllipseInRect(canvas, x, y, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_FILL_STROKE_ELLIPSE_IN_RECT:
+            readRect(&r, &x, &y, &w, &h);
+            if (t->fillStrokeEllipseInRect) {
+                t->fillStrokeEllipseInRect(canvas, x, y, w, h);
+            }
+            break;
+        case DISPLAY_LIST_OP_CTM_RESET:
+            if (t->ctmReset) {
+                t->ctmReset(canvas);
+            }
+            break;
+        case DISPLAY_LIST_OP_CTM_SET:
+            for (int ii = 0; ii < 6; ii++) {
+                m[ii] = readFloat(&r);
+            }
+            if (t->ctmSet) {
+                t->ctmSet(canvas, m[0], m[1], m[2], m[3], m[4], m[5]);
+            }
+            break;
+        case DISPLAY_LIST_OP_CTM_TRANSLATE:
+            m[0] = readFloat(&r);
+            m[1] = readFloat(&r);
+            if (t->ctmTranslate) {
+                t->ctmTranslate(canvas, m[0], m[1]);
+            }
+            break;
+        case DISPLAY_LIST_OP_CTM_SCALE:
+            m[0] = readFloat(&r);
+            m[1] = readFloat(&r);
+            if (t->ctmScale) {
+                t->ctmScale(canvas, m[0], m[1]);
+            }
+            break;
+        case DISPLAY_LIST_OP_CTM_ROTATE:
+            m[0] = readFloat(&r);
+            if (t->ctmRotate) {
+                t->ctmRotate(canvas, m[0]);
+            }
+            break;
+        case DISPLAY_LIST_OP_CONTEXT_PUSH:
+            if (t->contextPush) {
+                t->contextPush(canvas);
+            }
+            break;
+        case DISPLAY_LIST_OP_CONTEXT_POP:
+            if (t->contextPop) {
+                t->contextPop(canvas);
+            }
+            break;
+    }
+    return r.pos;
+}
+
+static void displayListExecuteCommand(displayList_t *list, displayListOp_e op)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, op);
+    displayListExecute(list, cmd.data);
+}
+
+static bool displayListIsRecording(const displayList_t *list)
+{
+    return list->group >= 0 && !list->groupOverflow;
+}
+
+static void displayListSyncState(displayList_t *list, const displayListState_t *state);
+
+// Sends the group recorded so far, inside its own context. The rest of the group goes straight to the display.
+static void displayListFlushGroup(displayList_t *list)
+{
+    const displayListState_t recordedSent = list->sent;
+
+    // Not recording any more, the state the group starts from goes to the display ahead of it
+    list->groupOverflow = true;
+    list->sent = list->groupSent;
+    displayListSyncState(list, &list->groupState);
+    list->groupSent = list->sent;
+
+    displayListExecuteCommand(list, DISPLAY_LIST_OP_CONTEXT_PUSH);
+    for (unsigned pos = 0; pos < list->length; ) {
+        pos += displayListExecute(list, &list->buffer[pos]);
+    }
+    list->length = 0;
+    list->sent = recordedSent;
+
+    list->groups[list->group].length = 0;
+    list->stats.groupsSent++;
+}
+
+static void displayListEmit(displayList_t *list, const displayListCommand_t *cmd)
+{
+    if (displayListIsRecording(list)) {
+        if (list->length + cmd->length <= DISPLAY_LIST_BUFFER_SIZE) {
+            memcpy(&list->buffer[list->length], cmd->data, cmd->length);
+            list->length += cmd->length;
+            return;
+        }
+        displayListFlushGroup(list);
+    }
+    displayListExecute(list, cmd->data);
+}
+
+static void displayListEmitU8(displayList_t *list, displayListOp_e op, uint8_t v)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, op);
+    commandPutU8(&cmd, v);
+    displayListEmit(list, &cmd);
+}
+
+static void displayListSyncState(displayList_t *list, const displayListState_t *state)
+{
+    displayListState_t *sent = &list->sent;
+
+    if (state->strokeColor != DISPLAY_LIST_STATE_UNKNOWN && state->strokeColor != sent->strokeColor &&
+        state->fillColor == state->strokeColor && state->fillColor != sent->fillColor) {
+
+        displayListEmitU8(list, DISPLAY_LIST_OP_SET_STROKE_AND_FILL_COLOR, state->strokeColor);
+        sent->strokeColor = sent->fillColor = state->strokeColor;
+        list->stats.stateChangesSent++;
+    }
+
+#define SYNC_FIELD(field, op) \
+    if (state->field != DISPLAY_LIST_STATE_UNKNOWN && state->field != sent->field) { \
+        displayListEmitU8(list, op, state->field); \
+        sent->field = state->field; \
+        list->stats.stateChangesSent++; \
+    }
+
+    SYNC_FIELD(strokeColor, DISPLAY_LIST_OP_SET_STROKE_COLOR);
+    SYNC_FIELD(fillColor, DISPLAY_LIST_OP_SET_FILL_COLOR);
+    SYNC_FIELD(strokeWidth, DISPLAY_LIST_OP_SET_STROKE_WIDTH);
+    SYNC_FIELD(outlineType, DISPLAY_LIST_OP_SET_LINE_OUTLINE_TYPE);
+    SYNC_FIELD(outlineColor, DISPLAY_LIST_OP_SET_LINE_OUTLINE_COLOR);
+    SYNC_FIELD(colorInversion, DISPLAY_LIST_OP_SET_COLOR_INVERSION);
+
+#undef SYNC_FIELD
+}
+
+// Primitive which draws, the drawing state has to be in place first
+static void displayListDraw(displayList_t *list, const displayListCommand_t *cmd)
+{
+    displayListSyncState(list, &list->state);
+    displayListEmit(list, cmd);
+}
+
+static void displayListSetState(displayList_t *list, uint8_t *field, unsigned value)
+{
+    *field = value < DISPLAY_LIST_STATE_DIRTY ? value : DISPLAY_LIST_STATE_DIRTY - 1;
+    list->stats.stateChanges++;
+}
+
+#define DISPLAY_LIST(canvas) ((canvas)->displayList)
+
+static void setStrokeColor(displayCanvas_t *displayCanvas, displayCanvasColor_e color)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    displayListSetState(list, &list->state.strokeColor, color);
+}
+
+static void setFillColor(displayCanvas_t *displayCanvas, displayCanvasColor_e color)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    displayListSetState(list, &list->state.fillColor, color);
+}
+
+static void setStrokeAndFillColor(displayCanvas_t *displayCanvas, displayCanvasColor_e color)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    displayListSetState(list, &list->state.strokeColor, color);
+    displayListSetState(list, &list->state.fillColor, color);
+}
+
+static void setColorInversion(displayCanvas_t *displayCanvas, bool inverted)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    displayListSetState(list, &list->state.colorInversion, inverted);
+}
+
+static void setStrokeWidth(displayCanvas_t *displayCanvas, unsigned w)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    displayListSetState(list, &list->state.strokeWidth, w);
+}
+
+static void setLineOutlineType(displayCanvas_t *displayCanvas, displayCanvasOutlineType_e outlineType)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    displayListSetState(list, &list->state.outlineType, outlineType);
+}
+
+static void setLineOutlineColor(displayCanvas_t *displayCanvas, displayCanvasColor_e outlineColor)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    displayListSetState(list, &list->state.outlineColor, outlineColor);
+}
+
+static void drawPoint(displayCanvas_t *displayCanvas, displayListOp_e op, int x, int y)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, op);
+    commandPutInt(&cmd, x);
+    commandPutInt(&cmd, y);
+    displayListDraw(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void drawRect(displayCanvas_t *displayCanvas, displayListOp_e op, int x, int y, int w, int h)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, op);
+    commandPutInt(&cmd, x);
+    commandPutInt(&cmd, y);
+    commandPutInt(&cmd, w);
+    commandPutInt(&cmd, h);
+    displayListDraw(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void drawTriangle(displayCanvas_t *displayCanvas, displayListOp_e op, int x1, int y1, int x2, int y2, int x3, int y3)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, op);
+    commandPutInt(&cmd, x1);
+    commandPutInt(&cmd, y1);
+    commandPutInt(&cmd, x2);
+    commandPutInt(&cmd, y2);
+    commandPutInt(&cmd, x3);
+    commandPutInt(&cmd, y3);
+    displayListDraw(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void setPixel(displayCanvas_t *displayCanvas, int x, int y, displayCanvasColor_e color)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_SET_PIXEL);
+    commandPutInt(&cmd, x);
+    commandPutInt(&cmd, y);
+    commandPutU8(&cmd, color);
+    displayListDraw(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void setPixelToStrokeColor(displayCanvas_t *displayCanvas, int x, int y)
+{
+    drawPoint(displayCanvas, DISPLAY_LIST_OP_SET_PIXEL_TO_STROKE_COLOR, x, y);
+}
+
+static void setPixelToFillColor(displayCanvas_t *displayCanvas, int x, int y)
+{
+    drawPoint(displayCanvas, DISPLAY_LIST_OP_SET_PIXEL_TO_FILL_COLOR, x, y);
+}
+
+static void clipToRect(displayCanvas_t *displayCanvas, int x, int y, int w, int h)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_CLIP_TO_RECT);
+    commandPutInt(&cmd, x);
+    commandPutInt(&cmd, y);
+    commandPutInt(&cmd, w);
+    commandPutInt(&cmd, h);
+    displayListEmit(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void clearRect(displayCanvas_t *displayCanvas, int x, int y, int w, int h)
+{
+    drawRect(displayCanvas, DISPLAY_LIST_OP_CLEAR_RECT, x, y, w, h);
+}
+
+static void resetDrawingState(displayCanvas_t *displayCanvas)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_RESET_DRAWING_STATE);
+    displayListEmit(list, &cmd);
+    list->state = displayListUnknownState;
+    list->sent = displayListUnknownState;
+}
+
+static void drawCharacterCommand(displayCanvas_t *displayCanvas, displayListOp_e op, int x, int y, uint16_t chr, displayCanvasColor_e color, displayCanvasBitmapOption_t opts)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, op);
+    commandPutInt(&cmd, x);
+    commandPutInt(&cmd, y);
+    commandPutInt(&cmd, (int16_t)chr);
+    commandPutU8(&cmd, opts);
+    if (op == DISPLAY_LIST_OP_DRAW_CHARACTER_MASK) {
+        commandPutU8(&cmd, color);
+    }
+    displayListDraw(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void drawCharacter(displayCanvas_t *displayCanvas, int x, int y, uint16_t chr, displayCanvasBitmapOption_t opts)
+{
+    drawCharacterCommand(displayCanvas, DISPLAY_LIST_OP_DRAW_CHARACTER, x, y, chr, 0, opts);
+}
+
+static void drawCharacterMask(displayCanvas_t *displayCanvas, int x, int y, uint16_t chr, displayCanvasColor_e color, displayCanvasBitmapOption_t opts)
+{
+    drawCharacterCommand(displayCanvas, DISPLAY_LIST_OP_DRAW_CHARACTER_MASK, x, y, chr, color, opts);
+}
+
+static void drawStringCommand(displayCanvas_t *displayCanvas, displayListOp_e op, int x, int y, const char *s, displayCanvasColor_e color, displayCanvasBitmapOption_t opts)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    const unsigned len = strlen(s);
+
+    if (len > DISPLAY_LIST_MAX_STRING) {
+        // Doesn't fit in a command, sent as it is
+        displayListSyncState(list, &list->state);
+        if (displayListIsRecording(list)) {
+            displayListFlushGroup(list);
+        }
+        if (op == DISPLAY_LIST_OP_DRAW_STRING && list->target->drawString) {
+            list->target->drawString(displayCanvas, x, y, s, opts);
+        } else if (op == DISPLAY_LIST_OP_DRAW_STRING_MASK && list->target->drawStringMask) {
+            list->target->drawStringMask(displayCanvas, x, y, s, color, opts);
+        }
+        return;
+    }
+
+    displayListCommand_t cmd;
+    commandInit(&cmd, op);
+    commandPutInt(&cmd, x);
+    commandPutInt(&cmd, y);
+    commandPutU8(&cmd, opts);
+    if (op == DISPLAY_LIST_OP_DRAW_STRING_MASK) {
+        commandPutU8(&cmd, color);
+    }
+    commandPutString(&cmd, s, len);
+    displayListDraw(list, &cmd);
+}
+
+static void drawString(displayCanvas_t *displayCanvas, int x, int y, const char *s, displayCanvasBitmapOption_t opts)
+{
+    drawStringCommand(displayCanvas, DISPLAY_LIST_OP_DRAW_STRING, x, y, s, 0, opts);
+}
+
+static void drawStringMask(displayCanvas_t *displayCanvas, int x, int y, const char *s, displayCanvasColor_e color, displayCanvasBitmapOption_t opts)
+{
+    drawStringCommand(displayCanvas, DISPLAY_LIST_OP_DRAW_STRING_MASK, x, y, s, color, opts);
+}
+
+static void moveToPoint(displayCanvas_t *displayCanvas, int x, int y)
+{
+    drawPoint(displayCanvas, DISPLAY_LIST_OP_MOVE_TO_POINT, x, y);
+}
+
+static void strokeLineToPoint(displayCanvas_t *displayCanvas, int x, int y)
+{
+    drawPoint(displayCanvas, DISPLAY_LIST_OP_STROKE_LINE_TO_POINT, x, y);
+}
+
+static void strokeTriangle(displayCanvas_t *displayCanvas, int x1, int y1, int x2, int y2, int x3, int y3)
+{
+    drawTriangle(displayCanvas, DISPLAY_LIST_OP_STROKE_TRIANGLE, x1, y1, x2, y2, x3, y3);
+}
+
+static void fillTriangle(displayCanvas_t *displayCanvas, int x1, int y1, int x2, int y2, int x3, int y3)
+{
+    drawTriangle(displayCanvas, DISPLAY_LIST_OP_FILL_TRIANGLE, x1, y1, x2, y2, x3, y3);
+}
+
+static void fillStrokeTriangle(displayCanvas_t *displayCanvas, int x1, int y1, int x2, int y2, int x3, int y3)
+{
+    drawTriangle(displayCanvas, DISPLAY_LIST_OP_FILL_STROKE_TRIANGLE, x1, y1, x2, y2, x3, y3);
+}
+
+static void strokeRect(displayCanvas_t *displayCanvas, int x, int y, int w, int h)
+{
+    drawRect(displayCanvas, DISPLAY_LIST_OP_STROKE_RECT, x, y, w, h);
+}
+
+static void fillRect(displayCanvas_t *displayCanvas, int x, int y, int w, int h)
+{
+    drawRect(displayCanvas, DISPLAY_LIST_OP_FILL_RECT, x, y, w, h);
+}
+
+static void fillStrokeRect(displayCanvas_t *displayCanvas, int x, int y, int w, int h)
+{
+    drawRect(displayCanvas, DISPLAY_LIST_OP_FILL_STROKE_RECT, x, y, w, h);
+}
+
+static void strokeEllipseInRect(displayCanvas_t *displayCanvas, int x, int y, int w, int h)
+{
+    drawRect(displayCanvas, DISPLAY_LIST_OP_STROKE_ELLIPSE_IN_RECT, x, y, w, h);
+}
+
+static void fillEllipseInRect(displayCanvas_t *displayCanvas, int x, int y, int w, int h)
+{
+    drawRect(displayCanvas, DISPLAY_LIST_OP_FILL_ELLIPSE_IN_RECT, x, y, w, h);
+}
+
+static void fillStrokeEllipseInRect(displayCanvas_t *displayCanvas, int x, int y, int w, int h)
+{
+    drawRect(displayCanvas, DISPLAY_LIST_OP_FILL_STROKE_ELLIPSE_IN_RECT, x, y, w, h);
+}
+
+static void ctmReset(displayCanvas_t *displayCanvas)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_CTM_RESET);
+    displayListEmit(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void ctmSet(displayCanvas_t *displayCanvas, float m11, float m12, float m21, float m22, float m31, float m32)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_CTM_SET);
+    commandPutFloat(&cmd, m11);
+    commandPutFloat(&cmd, m12);
+    commandPutFloat(&cmd, m21);
+    commandPutFloat(&cmd, m22);
+    commandPutFloat(&cmd, m31);
+    commandPutFloat(&cmd, m32);
+    displayListEmit(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void ctmTranslate(displayCanvas_t *displayCanvas, float tx, float ty)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_CTM_TRANSLATE);
+    commandPutFloat(&cmd, tx);
+    commandPutFloat(&cmd, ty);
+    displayListEmit(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void ctmScale(displayCanvas_t *displayCanvas, float sx, float sy)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_CTM_SCALE);
+    commandPutFloat(&cmd, sx);
+    commandPutFloat(&cmd, sy);
+    displayListEmit(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void ctmRotate(displayCanvas_t *displayCanvas, float r)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_CTM_ROTATE);
+    commandPutFloat(&cmd, r);
+    displayListEmit(DISPLAY_LIST(displayCanvas), &cmd);
+}
+
+static void contextPush(displayCanvas_t *displayCanvas)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_CONTEXT_PUSH);
+    displayListEmit(list, &cmd);
+
+    if (list->contextDepth < DISPLAY_LIST_CONTEXT_DEPTH) {
+        list->contextStack[list->contextDepth].state = list->state;
+        list->contextStack[list->contextDepth].sent = list->sent;
+    }
+    list->contextDepth++;
+}
+
+static void displayListContextPop(displayList_t *list)
+{
+    displayListCommand_t cmd;
+    commandInit(&cmd, DISPLAY_LIST_OP_CONTEXT_POP);
+    displayListEmit(list, &cmd);
+
+    if (list->contextDepth == 0) {
+        // Popped a context pushed before the list knew about it
+        list->sent = displayListDirtyState;
+        return;
+    }
+    list->contextDepth--;
+    if (list->contextDepth < DISPLAY_LIST_CONTEXT_DEPTH) {
+        list->state = list->contextStack[list->contextDepth].state;
+        list->sent = list->contextStack[list->contextDepth].sent;
+    } else {
+        list->sent = displayListDirtyState;
+    }
+}
+
+static void contextPop(displayCanvas_t *displayCanvas)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+
+    if (list->group >= 0 && list->contextDepth <= list->groupContextDepth) {
+        // Would pop the context the group is drawn in
+        return;
+    }
+    displayListContextPop(list);
+}
+
+static bool getWidgets(displayWidgets_t *widgets, const displayCanvas_t *displayCanvas)
+{
+    const displayList_t *list = DISPLAY_LIST(displayCanvas);
+    return list->target->getWidgets ? list->target->getWidgets(widgets, displayCanvas) : false;
+}
+
+static uint32_t displayListHash(uint32_t hash, const uint8_t *data, unsigned size)
+{
+    for (unsigned ii = 0; ii < size; ii++) {
+        hash = (hash ^ data[ii]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static void beginGroup(displayCanvas_t *displayCanvas, unsigned group)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+
+    if (list->group >= 0 || group >= DISPLAY_LIST_MAX_GROUPS) {
+        list->ignoredGroups++;
+        return;
+    }
+
+    list->group = group;
+    list->groupOverflow = false;
+    list->groupContextDepth = list->contextDepth;
+    list->groupState = list->state;
+    list->groupSent = list->sent;
+    // The recording starts from the drawing state, which is set before it's sent
+    list->sent = list->state;
+    list->length = 0;
+}
+
+static void endGroup(displayCanvas_t *displayCanvas)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+
+    if (list->ignoredGroups) {
+        list->ignoredGroups--;
+        return;
+    }
+    if (list->group < 0) {
+        return;
+    }
+
+    // Contexts left pushed by the group are dropped with it
+    while (list->contextDepth > list->groupContextDepth) {
+        displayListContextPop(list);
+    }
+
+    displayListGroup_t *group = &list->groups[list->group];
+
+    if (!list->groupOverflow) {
+        const uint32_t hash = displayListHash(displayListHash(FNV_OFFSET_BASIS, (const uint8_t *)&list->groupState, sizeof(list->groupState)), list->buffer, list->length);
+
+        const uint16_t length = list->length;
+
+        if (length == 0 || (group->length == length && group->hash == hash && group->skips < DISPLAY_LIST_MAX_SKIPS)) {
+            group->skips += length ? 1 : 0;
+            list->stats.groupsSkipped++;
+            list->sent = list->groupSent;
+        } else {
+            displayListFlushGroup(list);
+            group->hash = hash;
+            group->length = length;
+            group->skips = 0;
+        }
+    }
+
+    if (list->groupOverflow) {
+        displayListExecuteCommand(list, DISPLAY_LIST_OP_CONTEXT_POP);
+        list->sent = list->groupSent;
+    }
+
+    list->group = -1;
+    list->groupOverflow = false;
+    list->length = 0;
+}
+
+static void invalidateGroup(displayCanvas_t *displayCanvas, unsigned group)
+{
+    displayList_t *list = DISPLAY_LIST(displayCanvas);
+
+    if (group < DISPLAY_LIST_MAX_GROUPS) {
+        list->groups[group].length = 0;
+    }
+}
+
+static const displayCanvasVTable_t displayListVTable = {
+    .setStrokeColor = setStrokeColor,
+    .setFillColor = setFillColor,
+    .setStrokeAndFillColor = setStrokeAndFillColor,
+    .setColorInversion = setColorInversion,
+    .setPixel = setPixel,
+    .setPixelToStrokeColor = setPixelToStrokeColor,
+    .setPixelToFillColor = setPixelToFillColor,
+    .setStrokeWidth = setStrokeWidth,
+    .setLineOutlineType = setLineOutlineType,
+    .setLineOutlineColor = setLineOutlineColor,
+
+    .clipToRect = clipToRect,
+    .clearRect = clearRect,
+    .resetDrawingState = resetDrawingState,
+    .drawCharacter = drawCharacter,
+    .drawCharacterMask = drawCharacterMask,
+    .drawString = drawString,
+    .drawStringMask = drawStringMask,
+    .moveToPoint = moveToPoint,
+    .strokeLineToPoint = strokeLineToPoint,
+    .strokeTriangle = strokeTriangle,
+    .fillTriangle = fillTriangle,
+    .fillStrokeTriangle = fillStrokeTriangle,
+    .strokeRect = strokeRect,
+    .fillRect = fillRect,
+    .fillStrokeRect = fillStrokeRect,
+    .strokeEllipseInRect = strokeEllipseInRect,
+    .fillEllipseInRect = fillEllipseInRect,
+    .fillStrokeEllipseInRect = fillStrokeEllipseInRect,
+
+    .ctmReset = ctmReset,
+    .ctmSet = ctmSet,
+    .ctmTranslate = ctmTranslate,
+    .ctmScale = ctmScale,
+    .ctmRotate = ctmRotate,
+
+    .contextPush = contextPush,
+    .contextPop = contextPop,
+
+    .getWidgets = getWidgets,
+
+    .beginGroup = beginGroup,
+    .endGroup = endGroup,
+    .invalidateGroup = invalidateGroup,
+};
+
+void displayListInit(displayList_t *list, displayCanvas_t *canvas)
+{
+    memset(list, 0, sizeof(*list));
+    list->target = canvas->vTable;
+    list->canvas = canvas;
+    list->group = -1;
+    list->state = displayListUnknownState;
+    list->sent = displayListUnknownState;
+
+    canvas->vTable = &displayListVTable;
+    canvas->displayList = list;
+}
+
+void displayListResetDrawing(displayList_t *list)
+{
+    list->state = displayListUnknownState;
+    list->sent = displayListUnknownState;
+    list->contextDepth = 0;
+    list->group = -1;
+    list->ignoredGroups = 0;
+    list->groupOverflow = false;
+    list->length = 0;
+}
+
+void displayListInvalidate(displayList_t *list)
+{
+    for (unsigned ii = 0; ii < DISPLAY_LIST_MAX_GROUPS; ii++) {
+        list->groups[ii].length = 0;
+    }
+}
+
+const displayListStats_t *displayListGetStats(const displayList_t *list)
+{
+    return &list->stats;
+}
@@ -0,0 +1,105 @@
+/*
+ * This file is part of INAV.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 3, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "drivers/display_canvas.h"
+
+/*
+ * Display list for canvases on a slow link to the display.
+ *
+ * Installed in front of the canvas of a display, it sits between the drawing code and the
+ * primitives of the display:
+ *  - Colors, stroke width and outlines are only sent before something is drawn and only
+ *    when they differ from what the display already has, so redundant state changes are dropped.
+ *  - The primitives between displayCanvasBeginGroup() and displayCanvasEndGroup() are recorded
+ *    instead of sent. At the end of the group the recording, with the drawing state it started
+ *    from, is compared to the one from the last time the group was drawn and only sent if it
+ *    changed. A sent group is wrapped in a context push/pop, so it leaves no state behind.
+ * Primitives outside of a group go straight to the display.
+ */
+
+#define DISPLAY_LIST_BUFFER_SIZE        512     // Recording of the largest group
+#define DISPLAY_LIST_MAX_GROUPS         8
+#define DISPLAY_LIST_CONTEXT_DEPTH      4
+#define DISPLAY_LIST_MAX_SKIPS          10      // A group unchanged this many times is sent anyway, in case it was drawn over
+
+typedef struct displayListState_s {
+    uint8_t strokeColor;
+    uint8_t fillColor;
+    uint8_t strokeWidth;
+    uint8_t outlineType;
+    uint8_t outlineColor;
+    uint8_t colorInversion;
+} displayListState_t;
+
+typedef struct displayListGroup_s {
+    uint32_t hash;
+    uint16_t length;            // 0 when the group has to be sent the next time
+    uint8_t skips;
+} displayListGroup_t;
+
+typedef struct displayListStats_s {
+    uint32_t groupsSent;
+    uint32_t groupsSkipped;
+    uint32_t stateChanges;      // Made by the drawing code
+    uint32_t stateChangesSent;
+} displayListStats_t;
+
+typedef struct displayList_s {
+    const displayCanvasVTable_t *target;    // Primitives of the display
+    displayCanvas_t *canvas;
+
+    displayListState_t state;               // As set by the drawing code
+    displayListState_t sent;                // As the display (or the recording) has it
+    struct {
+        displayListState_t state;
+        displayListState_t sent;
+    } contextStack[DISPLAY_LIST_CONTEXT_DEPTH];
+    uint8_t contextDepth;
+
+    int8_t group;                           // Being recorded, -1 when none
+    uint8_t ignoredGroups;                  // Nested or out of range groups, drawn as part of the outer one
+    bool groupOverflow;                     // Recording didn't fit, rest of the group is sent as drawn
+    uint8_t groupContextDepth;
+    displayListState_t groupState;          // Drawing state the recording starts from
+    displayListState_t groupSent;           // State of the display while the group is recorded
+    displayListGroup_t groups[DISPLAY_LIST_MAX_GROUPS];
+
+    uint16_t length;
+    uint8_t buffer[DISPLAY_LIST_BUFFER_SIZE];
+
+    displayListStats_t stats;
+} displayList_t;
+
+// Puts the list in front of the current primitives of the canvas
+void displayListInit(displayList_t *list, displayCanvas_t *canvas);
+// The display was reset to its default drawing state, at the start of a frame
+void displayListResetDrawing(displayList_t *list);
+// The display was cleared, every group is sent the next time it's drawn
+void displayListInvalidate(displayList_t *list);
+const displayListStats_t *displayListGetStats(const displayList_t *list);
@@ -0,0 +1,204 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_DSHOT_BIDIR
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "drivers/pwm_mapping.h"
+#include "drivers/dshot_bidir.h"
+
+#define GCR_INVALID 0xFF
+
+typedef struct dshotBidirMotor_s {
+    uint32_t erpm;
+    dshotBidirStats_t stats;
+} dshotBidirMotor_t;
+
+static dshotBidirMotor_t dshotBidirMotors[MAX_MOTORS];
+static uint8_t dshotBidirMotorCount;
+
+// 5 bit GCR code to nibble
+static const uint8_t gcrDecodeTable[32] = {
+    GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID, GCR_INVALID,
+    GCR_INVALID, 0x9,         0xA,         0xB,         GCR_INVALID, 0xD,         0xE,         0xF,
+    GCR_INVALID, GCR_INVALID, 0x2,         0x3,         GCR_INVALID, 0x5,         0x6,         0x7,
+    GCR_INVALID, 0x0,         0x8,         0x1,         GCR_INVALID, 0x4,         0xC,         GCR_INVALID,
+};
+
+bool dshotBidirEdgesToGcr(const uint32_t *edges, unsigned edgeCount, unsigned bitTicks, uint32_t *gcr)
+{
+    if (edgeCount < 2) {
+        return false;
+    }
+
+    uint32_t value = 0;
+    unsigned bits = 0;
+
+    for (unsigned i = 1; i <= edgeCount && bits < DSHOT_BIDIR_FRAME_BITS; i++) {
+        unsigned len;
+
+        if (i < edgeCount) {
+            // Counter wraps at 16 bits on most timers, a frame is far shorter than that
+            const uint16_t ticks = edges[i] - edges[i - 1];
+            len = (ticks + bitTicks / 2) / bitTicks;
+        } else {
+            // The line stays put until the end of the frame after the last transition
+            len = DSHOT_BIDIR_FRAME_BITS - bits;
+        }
+
+        if (len == 0) {
+            return false;
+        }
+
+        // Return to idle after a frame ending low may come late, nothing after the last bit matters
+        len = MIN(len, DSHOT_BIDIR_FRAME_BITS - bits);
+
+        // A transition followed by len - 1 bit periods without one
+        value = (value << len) | (1 << (len - 1));
+        bits += len;
+    }
+
+    if (bits != DSHOT_BIDIR_FRAME_BITS) {
+        return false;
+    }
+
+    // The top bit is the start bit
+    *gcr = value & ((1 << (DSHOT_BIDIR_FRAME_BITS - 1)) - 1);
+    return true;
+}
+
+bool dshotBidirGcrToFrame(uint32_t gcr, uint16_t *frame)
+{
+    uint16_t value = 0;
+
+    for (int shift = 15; shift >= 0; shift -= 5) {
+        const uint8_t nibble = gcrDecodeTable[(gcr >> shift) & 0x1F];
+        if (nibble == GCR_INVALID) {
+            return false;
+        }
+        value = (value << 4) | nibble;
+    }
+
+    // Checksum is sent inverted, all four nibbles xor to 0xF
+    uint16_t csum = value ^ (value >> 8);
+    csum ^= csum >> 4;
+    if ((csum & 0xF) != 0xF) {
+        return false;
+    }
+
+    *frame = value;
+    return true;
+}
+
+uint32_t dshotBidirFrameToErpm(uint16_t frame)
+{
+    const uint16_t data = frame >> 4;
+
+    // Longest period the ESC can report means the motor is not turning
+    if (data == 0x0FFF) {
+        return 0;
+    }
+
+    const uint32_t periodUs = (uint32_t)(data & 0x01FF) << (data >> 9);
+    if (periodUs == 0) {
+        return 0;
+    }
+
+    // One electrical revolution per period
+    return (60 * 1000000 + periodUs / 2) / periodUs;
+}
+
+bool dshotBidirDecodeEdges(const uint32_t *edges, unsigned edgeCount, unsigned bitTicks, uint32_t *erpm)
+{
+    uint32_t gcr;
+    uint16_t frame;
+
+    if (!dshotBidirEdgesToGcr(edges, edgeCount, bitTicks, &gcr) || !dshotBidirGcrToFrame(gcr, &frame)) {
+        return false;
+    }
+
+    // A zero mantissa with a non-zero exponent can't come from a real period
+    if ((frame >> 4) != 0x0FFF && ((frame >> 4) & 0x01FF) == 0) {
+        return false;
+    }
+
+    *erpm = dshotBidirFrameToErpm(frame);
+    return true;
+}
+
+void dshotBidirInit(uint8_t motorCount)
+{
+    memset(dshotBidirMotors, 0, sizeof(dshotBidirMotors));
+    dshotBidirMotorCount = MIN(motorCount, MAX_MOTORS);
+}
+
+bool dshotBidirIsEnabled(void)
+{
+    return dshotBidirMotorCount > 0;
+}
+
+void dshotBidirUpdateMotor(uint8_t motorIndex, const uint32_t *edges, unsigned edgeCount, unsigned bitTicks)
+{
+    if (motorIndex >= dshotBidirMotorCount) {
+        return;
+    }
+
+    dshotBidirMotor_t *motor = &dshotBidirMotors[motorIndex];
+    uint32_t erpm;
+
+    motor->stats.frameCount++;
+
+    if (dshotBidirDecodeEdges(edges, edgeCount, bitTicks, &erpm)) {
+        motor->erpm = erpm;
+    } else {
+        motor->stats.errorCount++;
+    }
+}
+
+uint32_t dshotBidirGetMotorErpm(uint8_t motorIndex)
+{
+    return (motorIndex < dshotBidirMotorCount) ? dshotBidirMotors[motorIndex].erpm : 0;
+}
+
+void dshotBidirGetMotorStats(uint8_t motorIndex, dshotBidirStats_t *stats)
+{
+    if (motorIndex < dshotBidirMotorCount) {
+        *stats = dshotBidirMotors[motorIndex].stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+void dshotBidirGetStats(dshotBidirStats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    for (int i = 0; i < dshotBidirMotorCount; i++) {
+        stats->frameCount += dshotBidirMotors[i].stats.frameCount;
+        stats->errorCount += dshotBidirMotors[i].stats.errorCount;
+    }
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Bidirectional (inverted) DShot telemetry. After every frame the ESC answers on the same wire with a 21 bit
+ * frame at 5/4 of the DShot bit rate. The timer captures the time of every edge, a transition marks a GCR 1 bit.
+ * The 20 bit GCR value carries 16 bits: a 12 bit eRPM period (3 bit exponent, 9 bit mantissa, in us) and an inverted
+ * 4 bit checksum.
+ */
+
+#define DSHOT_BIDIR_FRAME_BITS          21
+#define DSHOT_BIDIR_EDGE_BUFFER_SIZE    (DSHOT_BIDIR_FRAME_BITS + 1)    // Start edge, one edge per bit and the return to idle
+
+typedef struct dshotBidirStats_s {
+    uint32_t frameCount;        // Motor updates which expected an answer
+    uint32_t errorCount;        // ... which got no answer, or one that failed to decode
+} dshotBidirStats_t;
+
+// Edge timestamps to the 20 GCR bits, edges are timer counter values starting with the start bit
+bool dshotBidirEdgesToGcr(const uint32_t *edges, unsigned edgeCount, unsigned bitTicks, uint32_t *gcr);
+// GCR to the 16 bit telemetry frame, fails on invalid codes and checksum
+bool dshotBidirGcrToFrame(uint32_t gcr, uint16_t *frame);
+// Telemetry frame to eRPM, 0 when the motor is stopped
+uint32_t dshotBidirFrameToErpm(uint16_t frame);
+
+bool dshotBidirDecodeEdges(const uint32_t *edges, unsigned edgeCount, unsigned bitTicks, uint32_t *erpm);
+
+void dshotBidirInit(uint8_t motorCount);
+bool dshotBidirIsEnabled(void);
+// Called once per motor update with the edges captured after the previous one
+void dshotBidirUpdateMotor(uint8_t motorIndex, const uint32_t *edges, unsigned edgeCount, unsigned bitTicks);
+// Last valid eRPM, kept when a frame is lost
+uint32_t dshotBidirGetMotorErpm(uint8_t motorIndex);
+void dshotBidirGetMotorStats(uint8_t motorIndex, dshotBidirStats_t *stats);
+void dshotBidirGetStats(dshotBidirStats_t *stats);
@@ -14,6 +14,7 @@
 #define NVIC_PRIO_SDIO                      3
 #define NVIC_PRIO_USB                       5
 #define NVIC_PRIO_SERIALUART                5
+#define NVIC_PRIO_ADC_DMA                   6
 #define NVIC_PRIO_VCP                       7
 
 
@@ -32,6 +32,7 @@
 
 #include "drivers/io.h"
 #include "drivers/timer.h"
+#include "drivers/dshot_bidir.h"
 #include "drivers/pwm_mapping.h"
 #include "drivers/pwm_output.h"
 #include "io/servo_sbus.h"
@@ -42,6 +43,8 @@
 #include "fc/config.h"
 #include "fc/runtime_config.h"
 
+#include "rx/rx_latency.h"
+
 #define MULTISHOT_5US_PW    (MULTISHOT_TIMER_HZ * 5 / 1000000.0f)
 #define MULTISHOT_20US_MULT (MULTISHOT_TIMER_HZ * 20 / 1000000.0f / 1000.0f)
 
@@ -57,6 +60,10 @@
 
 #define DSHOT_DMA_BUFFER_SIZE   18 /* resolution + frame reset (2us) */
 
+#ifdef USE_DSHOT_BIDIR
+#define DSHOT_BIDIR_BIT_TICKS   (DSHOT_MOTOR_BITLENGTH * 4 / 5)    // Telemetry comes back at 5/4 of the DShot bit rate
+#endif
+
 #define DSHOT_COMMAND_INTERVAL_US 10000
 #define DSHOT_COMMAND_QUEUE_LENGTH 8
 #define DHSOT_COMMAND_QUEUE_SIZE   DSHOT_COMMAND_QUEUE_LENGTH * sizeof(dshotCommands_e)
@@ -78,6 +85,10 @@ typedef struct {
     // DSHOT parameters
     timerDMASafeType_t dmaBuffer[DSHOT_DMA_BUFFER_SIZE];
 #endif
+#ifdef USE_DSHOT_BIDIR
+    bool bidir;
+    timerDMASafeType_t captureBuffer[DSHOT_BIDIR_EDGE_BUFFER_SIZE];
+#endif
 } pwmOutputPort_t;
 
 typedef struct {
@@ -113,6 +124,11 @@ static uint8_t commandsBuff[DHSOT_COMMAND_QUEUE_SIZE];
 static currentExecutingCommand_t currentExecutingCommand;
 #endif
 
+#ifdef USE_DSHOT_BIDIR
+static bool useDshotBidir = false;
+static bool dshotBidirFrameSent = false;
+#endif
+
 static void pwmOutConfigTimer(pwmOutputPort_t * p, TCH_t * tch, uint32_t hz, uint16_t period, uint16_t value)
 {
     p->tch = tch;
@@ -263,6 +279,14 @@ static pwmOutputPort_t * motorConfigDshot(const timerHardware_t * timerHardware,
         // Only mark as DSHOT channel if DMA was set successfully
         ZERO_FARRAY(port->dmaBuffer);
         port->configured = true;
+
+#ifdef USE_DSHOT_BIDIR
+        if (useDshotBidir && enableOutput) {
+            // Line idles high, keep it there while the pin listens
+            IOConfigGPIOAF(IOGetByTag(timerHardware->tag), IOCFG_AF_PP_UP, timerHardware->alternateFunction);
+            port->bidir = timerPWMConfigChannelDMACapture(port->tch, port->captureBuffer, DSHOT_BIDIR_EDGE_BUFFER_SIZE);
+        }
+#endif
     }
 
     return port;
@@ -276,7 +300,7 @@ static void loadDmaBufferDshot(timerDMASafeType_t *dmaBuffer, uint16_t packet)
     }
 }
 
-static uint16_t prepareDshotPacket(const uint16_t value, bool requestTelemetry)
+static uint16_t prepareDshotPacket(const uint16_t value, bool requestTelemetry, bool inverted)
 {
     uint16_t packet = (value << 1) | (requestTelemetry ? 1 : 0);
 
@@ -287,6 +311,10 @@ static uint16_t prepareDshotPacket(const uint16_t value, bool requestTelemetry)
         csum ^=  csum_data;   // xor data by nibbles
         csum_data >>= 4;
     }
+    // Bidirectional DShot ESCs expect the checksum inverted
+    if (inverted) {
+        csum = ~csum;
+    }
     csum &= 0xf;
 
     // append checksum
@@ -408,10 +436,27 @@ void pwmCompleteMotorUpdate(void) {
 
         executeDShotCommands();
 
+#ifdef USE_DSHOT_BIDIR
+        // Collect the answers to the previous frame before the pins go back to output
+        for (int index = 0; index < motorCount; index++) {
+            pwmOutputPort_t * port = motors[index].pwmPort;
+            if (port && port->configured && port->bidir) {
+                const uint32_t edgeCount = timerPWMStopDMACapture(port->tch);
+                if (dshotBidirFrameSent) {
+                    dshotBidirUpdateMotor(index, (const uint32_t *)port->captureBuffer, edgeCount, DSHOT_BIDIR_BIT_TICKS);
+                }
+            }
+        }
+#endif
+
         // Generate DMA buffers
         for (int index = 0; index < motorCount; index++) {
             if (motors[index].pwmPort && motors[index].pwmPort->configured) {
-                uint16_t packet = prepareDshotPacket(motors[index].value, motors[index].requestTelemetry);
+                bool inverted = false;
+#ifdef USE_DSHOT_BIDIR
+                inverted = motors[index].pwmPort->bidir;
+#endif
+                uint16_t packet = prepareDshotPacket(motors[index].value, motors[index].requestTelemetry, inverted);
                 loadDmaBufferDshot(motors[index].pwmPort->dmaBuffer, packet);
                 timerPWMPrepareDMA(motors[index].pwmPort->tch, DSHOT_DMA_BUFFER_SIZE);
                 motors[index].requestTelemetry = false;
@@ -424,6 +469,12 @@ void pwmCompleteMotorUpdate(void) {
                 timerPWMStartDMA(motors[index].pwmPort->tch);
             }
         }
+
+#ifdef USE_DSHOT_BIDIR
+        dshotBidirFrameSent = true;
+#endif
+
+        rxLatencyMotorsUpdated(currentTimeUs);
     }
 #endif
 }
@@ -464,7 +515,14 @@ void pwmMotorPreconfigure(void)
         case PWM_TYPE_DSHOT600:
         case PWM_TYPE_DSHOT300:
         case PWM_TYPE_DSHOT150:
+#ifdef USE_DSHOT_BIDIR
+            useDshotBidir = motorConfig()->dshotBidir;
+            dshotBidirInit(useDshotBidir ? getMotorCount() : 0);
+            // Leave room for the answer between frames
+            motorConfigDigitalUpdateInterval(getEscUpdateFrequency() / (useDshotBidir ? 2 : 1));
+#else
             motorConfigDigitalUpdateInterval(getEscUpdateFrequency());
+#endif
             motorWritePtr = pwmWriteDigital;
             break;
 #endif
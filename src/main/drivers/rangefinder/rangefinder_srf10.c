@@ -91,6 +91,8 @@ static bool isSensorResponding = true;
 
 static void srf10_init(rangefinderDev_t * rangefinder)
 {
+    minimumFiringIntervalMs = SRF10_MinimumFiringIntervalFor600cmRangeMs;
+
     busWrite(rangefinder->busDev, SRF10_WRITE_MaxGainRegister, SRF10_COMMAND_SetGain_Max);
     busWrite(rangefinder->busDev, SRF10_WRITE_RangeRegister, SRF10_RangeValue6m);
 
@@ -106,19 +108,15 @@ static void srf10_init(rangefinderDev_t * rangefinder)
  */
 static void srf10_start_reading(rangefinderDev_t * rangefinder)
 {
-    uint8_t revision;
+    // software revision, unused, range high and low byte in a single read
+    uint8_t data[SRF10_READ_RangeLowByte + 1];
 
-    // check if there is a measurement outstanding, 0xFF is returned if no measurement
-    isSensorResponding = busRead(rangefinder->busDev, SRF10_READ_SoftwareRevision, &revision);
+    isSensorResponding = busReadBuf(rangefinder->busDev, SRF10_READ_SoftwareRevision, data, sizeof(data));
 
-    if (isSensorResponding && revision != 0xFF) {
+    // check if there is a measurement outstanding, 0xFF is returned if no measurement
+    if (isSensorResponding && data[SRF10_READ_SoftwareRevision] != 0xFF) {
         // there is a measurement
-        uint8_t lowByte, highByte;
-
-        isSensorResponding = busRead(rangefinder->busDev, SRF10_READ_RangeLowByte, &lowByte);
-        isSensorResponding = busRead(rangefinder->busDev, SRF10_READ_RangeHighByte, &highByte);
-
-        srf10measurementCm =  highByte << 8 | lowByte;
+        srf10measurementCm = data[SRF10_READ_RangeHighByte] << 8 | data[SRF10_READ_RangeLowByte];
 
         if (srf10measurementCm > SRF10_MAX_RANGE_CM) {
             srf10measurementCm = RANGEFINDER_OUT_OF_RANGE;
@@ -153,7 +151,9 @@ static bool deviceDetect(busDevice_t * busDev)
     for (int retry = 0; retry < 5; retry++) {
         uint8_t inquiryResult;
 
-        delay(150);
+        if (retry > 0) {
+            delay(150);
+        }
 
         bool ack = busRead(busDev, SRF10_READ_Unused, &inquiryResult);
         if (ack && inquiryResult == SRF10_READ_Unused_ReturnValue) {
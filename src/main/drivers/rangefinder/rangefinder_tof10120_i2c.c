@@ -45,8 +45,8 @@ static bool isTof10120Responding = false;
 
 static void tof10120i2cInit(rangefinderDev_t *rangefinder)
 {
+    // Distance is only read on request, nothing to wait for here
     busWrite(rangefinder->busDev, TOF10120_I2C_REGISTRY_SENDING_METHOD_CONFIG, 0x01);
-    delay(100);
 }
 
 void tof10120i2cUpdate(rangefinderDev_t *rangefinder)
@@ -86,9 +86,6 @@ int32_t tof10120i2cGetDistance(rangefinderDev_t *rangefinder)
 
 static bool deviceDetect(rangefinderDev_t *rangefinder)
 {
-    busWrite(rangefinder->busDev, TOF10120_I2C_REGISTRY_SENDING_METHOD_CONFIG, 0x01);
-    delay(100);
-
     uint8_t response = 0;
 
     if (!busRead(rangefinder->busDev, TOF10120_I2C_REGISTRY_BUS_ADDR_CONFIG, &response) || !response) {
@@ -54,10 +54,20 @@ static bool isUs42Responding = false;
 static void us42Init(rangefinderDev_t *rangefinder)
 {
     busWriteBuf(rangefinder->busDev, US42_I2C_REGISTRY_PROBE, nullProbeCommandValue, 0);
+    timeOfLastMeasurementMs = millis();
 }
 
+/*
+ * Reads the echo of the last probe and sends the next one. Until the echo can be back the bus
+ * isn't touched.
+ */
 void us42Update(rangefinderDev_t *rangefinder)
 {
+    const timeMs_t timeNowMs = millis();
+    if (timeNowMs - timeOfLastMeasurementMs < (timeMs_t)minimumReadingIntervalMs) {
+        return;
+    }
+
     uint8_t data[2];
     isUs42Responding = busReadBuf(rangefinder->busDev, US42_I2C_REGISTRY_PROBE, data, 2);
 
@@ -72,13 +82,10 @@ void us42Update(rangefinderDev_t *rangefinder)
         us42MeasurementCm = RANGEFINDER_HARDWARE_FAILURE;
     }    
 
-    const timeMs_t timeNowMs = millis();
-    if (timeNowMs > timeOfLastMeasurementMs + minimumReadingIntervalMs) {
-        // measurement repeat interval should be greater than minimumReadingIntervalMs
-        // to avoid interference between connective measurements.
-        timeOfLastMeasurementMs = timeNowMs;
-        busWriteBuf(rangefinder->busDev, US42_I2C_REGISTRY_PROBE, nullProbeCommandValue, 0);
-    }
+    // measurement repeat interval should be greater than minimumReadingIntervalMs
+    // to avoid interference between connective measurements.
+    timeOfLastMeasurementMs = timeNowMs;
+    busWriteBuf(rangefinder->busDev, US42_I2C_REGISTRY_PROBE, nullProbeCommandValue, 0);
 }
 
 /**
@@ -95,7 +102,9 @@ static bool deviceDetect(busDevice_t * busDev)
     for (int retry = 0; retry < 5; retry++) {
         uint8_t inquiryResult;
 
-        delay(150);
+        if (retry > 0) {
+            delay(150);
+        }
 
         bool ack = busRead(busDev, US42_I2C_REGISTRY_BASE, &inquiryResult);
         if (ack && inquiryResult == US42_I2C_REGISTRY_STATUS_OK) {
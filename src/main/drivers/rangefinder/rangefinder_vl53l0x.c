@@ -117,6 +117,11 @@
 #define VL53L0X_DETECTION_CONE_DECIDEGREES  900
 
 #define VL53L0X_I2C_ADDRESS     0x29
+#define VL53L0X_DATA_READY_POLL_MS  10  // GPIO1 is polled without bus traffic
+
+// Burst read from RESULT_INTERRUPT_STATUS up to the range in RESULT_RANGE_STATUS + 10
+#define VL53L0X_RESULT_BLOCK_SIZE   13
+#define VL53L0X_RESULT_RANGE_MM     11
 
 /** @defgroup VL53L0X_DefineRegisters_group Define Registers
  *  @brief List of all the defined registers
@@ -209,7 +214,7 @@
 #define setTimeout(timeout)                 {timeoutValueMs = timeout;}
 #define getTimeout()                        (timeoutValueMs)
 #define startTimeout()                      (timeoutStartMs = millis())
-#define checkTimeoutExpired()               (timeoutValueMs > 0 && ((uint16_t)millis() - timeoutStartMs) > timeoutValueMs)
+#define checkTimeoutExpired()               (timeoutValueMs > 0 && (millis() - timeoutStartMs) > timeoutValueMs)
 #define decodeVcselPeriod(reg_val)          (((reg_val) + 1) << 1)
 #define encodeVcselPeriod(period_pclks)     (((period_pclks) >> 1) - 1)
 #define calcMacroPeriod(vcsel_period_pclks) ((((uint32_t)2304 * (vcsel_period_pclks) * 1655) + 500) / 1000)
@@ -219,12 +224,6 @@ typedef enum {
     VcselPeriodFinalRange
 } vcselPeriodType_e;
 
-typedef enum {
-    MEASUREMENT_START,
-    MEASUREMENT_WAIT,
-    MEASUREMENT_READ,
-} measurementSteps_e;
-
 typedef struct {
     bool tcc;
     bool msrc;
@@ -252,7 +251,6 @@ static bool isResponding = true;
 static uint32_t measurementTimingBudgetUs;
 static timeMs_t timeoutStartMs = 0;
 static timeMs_t timeoutValueMs = 0;
-static measurementSteps_e measSteps = MEASUREMENT_START;
 
 static uint8_t readReg(busDevice_t * busDev, uint8_t reg)
 {
@@ -800,6 +798,21 @@ bool getSpadInfo(busDevice_t * busDev, uint8_t * count, bool * type_is_aperture)
     return true;
 }
 
+// Back-to-back ranging, a new measurement is started as soon as the last one is done
+static void startContinuous(busDevice_t * busDev)
+{
+    writeReg(busDev, 0x80, 0x01);
+    writeReg(busDev, 0xFF, 0x01);
+    writeReg(busDev, 0x00, 0x00);
+    writeReg(busDev, 0x91, stopVariable);
+    writeReg(busDev, 0x00, 0x01);
+    writeReg(busDev, 0xFF, 0x00);
+    writeReg(busDev, 0x80, 0x00);
+    writeReg(busDev, VL53L0X_REG_SYSRANGE_START, 0x02); // VL53L0X_REG_SYSRANGE_MODE_BACKTOBACK
+
+    startTimeout();
+}
+
 static void vl53l0x_Init(rangefinderDev_t * rangefinder)
 {
     uint8_t byte;
@@ -1015,117 +1028,51 @@ static void vl53l0x_Init(rangefinderDev_t * rangefinder)
     // Set timeout
     setTimeout(100);
 
+    if (rangefinder->busDev->irqPin) {
+        IOInit(rangefinder->busDev->irqPin, OWNER_RANGEFINDER, RESOURCE_INPUT, 0);
+        IOConfigGPIO(rangefinder->busDev->irqPin, IOCFG_IPU);
+    }
+
+    startContinuous(rangefinder->busDev);
+
     // We are initialized
     isInitialized = true;
 }
 
+/*
+ * The sensor ranges back to back on its own, an update only picks up a finished result. Interrupt
+ * status and range come in one burst read and the interrupt is cleared only when a result was taken.
+ * With GPIO1 wired up an update without a new result doesn't touch the bus at all.
+ */
 void vl53l0x_Update(rangefinderDev_t * rangefinder)
 {
+    uint8_t result[VL53L0X_RESULT_BLOCK_SIZE];
+
     if (!isInitialized) {
         return;
     }
 
-#if 1   // SINGLE MEASUREMENT MODE
-    switch (measSteps) {
-        case MEASUREMENT_START:
-            // Initiate new measurement
-            writeReg(rangefinder->busDev, 0x80, 0x01);
-            writeReg(rangefinder->busDev, 0xFF, 0x01);
-            writeReg(rangefinder->busDev, 0x00, 0x00);
-            writeReg(rangefinder->busDev, 0x91, stopVariable);
-            writeReg(rangefinder->busDev, 0x00, 0x01);
-            writeReg(rangefinder->busDev, 0xFF, 0x00);
-            writeReg(rangefinder->busDev, 0x80, 0x00);
-            writeReg(rangefinder->busDev, VL53L0X_REG_SYSRANGE_START, 0x01);
+    // GPIO1 is configured active low
+    const bool hasDataReadyPin = (rangefinder->busDev->irqPin != IO_NONE);
+    if (!hasDataReadyPin || !IORead(rangefinder->busDev->irqPin)) {
+        readMulti(rangefinder->busDev, VL53L0X_REG_RESULT_INTERRUPT_STATUS, result, sizeof(result));
+
+        if (isResponding && (result[0] & 0x07) != 0) {
+            // assumptions: Linearity Corrective Gain is 1000 (default);
+            uint16_t raw = ((uint16_t)result[VL53L0X_RESULT_RANGE_MM] << 8) | result[VL53L0X_RESULT_RANGE_MM + 1];
+            writeReg(rangefinder->busDev, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01);
 
+            lastMeasurementCm = raw / 10;
+            lastMeasurementIsNew = true;
             startTimeout();
-            measSteps = MEASUREMENT_WAIT;
-            break;
-
-        case MEASUREMENT_WAIT:
-            // Wait for data and read the measurement
-            if (readReg(rangefinder->busDev, VL53L0X_REG_SYSRANGE_START) & 0x01) {
-                if (checkTimeoutExpired()) {
-                    lastMeasurementCm = RANGEFINDER_OUT_OF_RANGE;
-                    measSteps = MEASUREMENT_START;
-                }
-            }
-            else {
-                startTimeout();
-                measSteps = MEASUREMENT_READ;
-            }
-            break;
-
-        case MEASUREMENT_READ:
-            if ((readReg(rangefinder->busDev, VL53L0X_REG_RESULT_INTERRUPT_STATUS) & 0x07) == 0) {
-                if (checkTimeoutExpired()) {
-                    lastMeasurementCm = RANGEFINDER_OUT_OF_RANGE;
-                    measSteps = MEASUREMENT_START;
-                }
-            }
-            else {
-                // assumptions: Linearity Corrective Gain is 1000 (default);
-                uint16_t raw = readReg16(rangefinder->busDev, VL53L0X_REG_RESULT_RANGE_STATUS + 10);
-                writeReg(rangefinder->busDev, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01);
-
-                lastMeasurementCm = raw / 10;
-                lastMeasurementIsNew = true;
-                measSteps = MEASUREMENT_START;
-            }
-            break;
+            return;
+        }
     }
-#else   // CONTINUOUS MEASUREMENT MODE
-    switch (measSteps) {
-        case MEASUREMENT_START:
-            // Initiate new measurement
-            writeReg(rangefinder->busDev, 0x80, 0x01);
-            writeReg(rangefinder->busDev, 0xFF, 0x01);
-            writeReg(rangefinder->busDev, 0x00, 0x00);
-            writeReg(rangefinder->busDev, 0x91, stopVariable);
-            writeReg(rangefinder->busDev, 0x00, 0x01);
-            writeReg(rangefinder->busDev, 0xFF, 0x00);
-            writeReg(rangefinder->busDev, 0x80, 0x00);
-
-            uint16_t osc_calibrate_val = readReg16(VL53L0X_REG_OSC_CALIBRATE_VAL);
-
-            if (osc_calibrate_val != 0) {
-                writeReg32(rangefinder->busDev, VL53L0X_REG_SYSTEM_INTERMEASUREMENT_PERIOD, 50 * osc_calibrate_val);
-            }
-            else {
-                writeReg32(rangefinder->busDev, VL53L0X_REG_SYSTEM_INTERMEASUREMENT_PERIOD, 50);
-            }
-
-            writeReg(rangefinder->busDev, VL53L0X_REG_SYSRANGE_START, 0x02); // VL53L0X_REG_SYSRANGE_MODE_BACKTOBACK
 
-            startTimeout();
-            measSteps = MEASUREMENT_READ;
-            break;
-
-        case MEASUREMENT_READ:
-        default:
-            if ((readReg(rangefinder->busDev, VL53L0X_REG_RESULT_INTERRUPT_STATUS) & 0x07) == 0) {
-                if (checkTimeoutExpired()) {
-                    lastMeasurementCm = RANGEFINDER_OUT_OF_RANGE;
-
-                    // Restart timeout
-                    startTimeout();
-                    measSteps = MEASUREMENT_READ;
-                }
-            }
-            else {
-                // assumptions: Linearity Corrective Gain is 1000 (default);
-                uint16_t raw = readReg16(rangefinder->busDev, VL53L0X_REG_RESULT_RANGE_STATUS + 10);
-                writeReg(rangefinder->busDev, VL53L0X_REG_SYSTEM_INTERRUPT_CLEAR, 0x01);
-
-                lastMeasurementCm = raw / 10;
-
-                // Restart timeout
-                startTimeout();
-                measSteps = MEASUREMENT_READ;
-            }
-            break;
+    if (checkTimeoutExpired()) {
+        lastMeasurementCm = RANGEFINDER_OUT_OF_RANGE;
+        startContinuous(rangefinder->busDev);
     }
-#endif
 }
 
 int32_t vl53l0x_GetDistance(rangefinderDev_t *dev)
@@ -1151,7 +1098,10 @@ static bool deviceDetect(busDevice_t * busDev)
     for (int retry = 0; retry < 5; retry++) {
         uint8_t model_id;
 
-        delay(150);
+        // Only wait for a sensor that hasn't answered yet
+        if (retry > 0) {
+            delay(150);
+        }
 
         bool ack = busRead(busDev, VL53L0X_REG_IDENTIFICATION_MODEL_ID, &model_id);
         if (ack && model_id == 0xEE) {
@@ -1175,7 +1125,8 @@ bool vl53l0xDetect(rangefinderDev_t * rangefinder)
         return false;
     }
 
-    rangefinder->delayMs = RANGEFINDER_VL53L0X_TASK_PERIOD_MS;
+    // GPIO1 is cheap to poll, a result is then picked up soon after it is ready
+    rangefinder->delayMs = rangefinder->busDev->irqPin ? VL53L0X_DATA_READY_POLL_MS : RANGEFINDER_VL53L0X_TASK_PERIOD_MS;
     rangefinder->maxRangeCm = VL53L0X_MAX_RANGE_CM;
     rangefinder->detectionConeDeciDegrees = VL53L0X_DETECTION_CONE_DECIDEGREES;
     rangefinder->detectionConeExtendedDeciDegrees = VL53L0X_DETECTION_CONE_DECIDEGREES;
@@ -110,6 +110,13 @@
 #define VL53L1X_MAX_RANGE_CM                                (300)
 #define VL53L1X_DETECTION_CONE_DECIDEGREES                  (270)
 #define VL53L1X_TIMING_BUDGET                               (33)
+#define VL53L1X_DATA_READY_POLL_MS                          (10)    // GPIO1 is polled without bus traffic
+#define VL53L1X_INIT_TIMEOUT_MS                             (500)
+
+// Burst read of the result block starting at RESULT__RANGE_STATUS
+#define VL53L1X_RESULT_BLOCK_SIZE                           (15)
+#define VL53L1X_RESULT_STREAM_COUNT                         (2)     // RESULT__STREAM_COUNT, 0x008B
+#define VL53L1X_RESULT_RANGE_MM                             (13)    // RESULT__FINAL_CROSSTALK_CORRECTED_RANGE_MM_SD0, 0x0096
 
 #define VL53L1X_IMPLEMENTATION_VER_MAJOR       3
 #define VL53L1X_IMPLEMENTATION_VER_MINOR       4
@@ -449,7 +456,7 @@ static VL53L1X_ERROR VL53L1X_SetInterMeasurementInMs(busDevice_t * dev,
 /**
  * @brief This function returns the distance measured by the sensor in mm
  */
-static VL53L1X_ERROR VL53L1X_GetDistance(busDevice_t * dev, uint16_t *distance);
+// static VL53L1X_ERROR VL53L1X_GetDistance(busDevice_t * dev, uint16_t *distance);
 
 /**
  * @brief This function returns the returned signal per SPAD in kcps/SPAD.
@@ -723,6 +730,8 @@ static int32_t lastMeasurementCm = RANGEFINDER_OUT_OF_RANGE;
 static bool lastMeasurementIsNew = false;
 static bool isInitialized = false;
 static bool isResponding = true;
+static uint8_t interruptPolarity;
+static uint8_t lastStreamCount;
 
 #define _I2CWrite(dev, data, size) \
     (busWriteBuf(dev, 0xFF, data, size) ? 0 : -1)
@@ -920,9 +929,13 @@ VL53L1X_ERROR VL53L1X_SensorInit(busDevice_t * dev)
         status = VL53L1_WrByte(dev, Addr, VL51L1X_DEFAULT_CONFIGURATION[Addr - 0x2D]);
     }
     status = VL53L1X_StartRanging(dev);
+    const timeMs_t startMs = millis();
     tmp  = 0;
     while(tmp==0){
             status = VL53L1X_CheckForDataReady(dev, &tmp);
+            if (status != 0 || millis() - startMs > VL53L1X_INIT_TIMEOUT_MS) {
+                return VL53L1_ERROR_TIME_OUT;
+            }
     }
     status = VL53L1X_ClearInterrupt(dev);
     status = VL53L1X_StopRanging(dev);
@@ -1232,16 +1245,16 @@ static VL53L1X_ERROR VL53L1X_SetInterMeasurementInMs(busDevice_t * dev, uint32_t
 //     return status;
 // }
 
-static VL53L1X_ERROR VL53L1X_GetDistance(busDevice_t * dev, uint16_t *distance)
-{
-    VL53L1X_ERROR status = 0;
-    uint16_t tmp;
+// static VL53L1X_ERROR VL53L1X_GetDistance(busDevice_t * dev, uint16_t *distance)
+// {
+//     VL53L1X_ERROR status = 0;
+//     uint16_t tmp;
 
-    status = (VL53L1_RdWord(dev,
-            VL53L1_RESULT__FINAL_CROSSTALK_CORRECTED_RANGE_MM_SD0, &tmp));
-    *distance = tmp;
-    return status;
-}
+//     status = (VL53L1_RdWord(dev,
+//             VL53L1_RESULT__FINAL_CROSSTALK_CORRECTED_RANGE_MM_SD0, &tmp));
+//     *distance = tmp;
+//     return status;
+// }
 
 // VL53L1X_ERROR VL53L1X_GetSignalPerSpad(busDevice_t * dev, uint16_t *signalRate)
 // {
@@ -1606,32 +1619,66 @@ static VL53L1X_ERROR VL53L1X_GetDistance(busDevice_t * dev, uint16_t *distance)
 static void vl53l1x_Init(rangefinderDev_t * rangefinder)
 {
     VL53L1X_ERROR status = VL53L1_ERROR_NONE;
+    uint8_t result[VL53L1X_RESULT_BLOCK_SIZE];
+
     isInitialized = false;
     status = VL53L1X_SensorInit(rangefinder->busDev);
     if (status == VL53L1_ERROR_NONE) {
         VL53L1X_SetDistanceMode(rangefinder->busDev, 2); /* 1=short, 2=long */
         VL53L1X_SetTimingBudgetInMs(rangefinder->busDev, 33); /* in ms possible values [20, 50, 100, 200, 500] */
         VL53L1X_SetInterMeasurementInMs(rangefinder->busDev, RANGEFINDER_VL53L1X_TASK_PERIOD_MS); /* in ms, IM must be > = TB */
+        status = VL53L1X_GetInterruptPolarity(rangefinder->busDev, &interruptPolarity);
+    }
+    if (status == VL53L1_ERROR_NONE) {
         status = VL53L1X_StartRanging(rangefinder->busDev);
     }
+    if (status == VL53L1_ERROR_NONE) {
+        // Stream count of the results from before ranging was started
+        status = VL53L1_ReadMulti(rangefinder->busDev, VL53L1_RESULT__RANGE_STATUS, result, sizeof(result));
+        lastStreamCount = result[VL53L1X_RESULT_STREAM_COUNT];
+    }
+
+    if (rangefinder->busDev->irqPin) {
+        IOInit(rangefinder->busDev->irqPin, OWNER_RANGEFINDER, RESOURCE_INPUT, 0);
+        IOConfigGPIO(rangefinder->busDev->irqPin, IOCFG_IPU);
+    }
+
     isInitialized = (status == VL53L1_ERROR_NONE);
 }
 
+/*
+ * The sensor ranges on its own, an update only picks up a finished result. Status and range come in
+ * one burst read of the result block, the stream count tells a new result from the one already seen.
+ * The interrupt is cleared only when a result was taken. With GPIO1 wired up an update without a new
+ * result doesn't touch the bus at all.
+ */
 void vl53l1x_Update(rangefinderDev_t * rangefinder)
 {
-    uint16_t Distance;
-    uint8_t dataReady;
+    uint8_t result[VL53L1X_RESULT_BLOCK_SIZE];
 
     if (!isInitialized) {
         return;
     }
 
-    VL53L1X_CheckForDataReady(rangefinder->busDev, &dataReady);
-    if (dataReady != 0) {
-        VL53L1X_GetDistance(rangefinder->busDev, &Distance);
-        lastMeasurementCm = Distance / 10;
+    const bool hasDataReadyPin = (rangefinder->busDev->irqPin != IO_NONE);
+    if (hasDataReadyPin && IORead(rangefinder->busDev->irqPin) != interruptPolarity) {
+        return;
+    }
+
+    isResponding = (VL53L1_ReadMulti(rangefinder->busDev, VL53L1_RESULT__RANGE_STATUS, result, sizeof(result)) == VL53L1_ERROR_NONE);
+    if (!isResponding) {
+        return;
+    }
+
+    if (result[VL53L1X_RESULT_STREAM_COUNT] != lastStreamCount) {
+        lastStreamCount = result[VL53L1X_RESULT_STREAM_COUNT];
+        lastMeasurementCm = ((uint16_t)result[VL53L1X_RESULT_RANGE_MM] << 8 | result[VL53L1X_RESULT_RANGE_MM + 1]) / 10;
         lastMeasurementIsNew = true;
     }
+    else if (!hasDataReadyPin) {
+        return;
+    }
+
     VL53L1X_ClearInterrupt(rangefinder->busDev);
 }
 
@@ -1658,7 +1705,10 @@ static bool deviceDetect(busDevice_t * busDev)
     for (int retry = 0; retry < 5; retry++) {
         uint8_t model_id;
 
-        delay(150);
+        // Give a sensor that doesn't answer yet time to boot
+        if (retry > 0) {
+            delay(150);
+        }
 
         VL53L1X_ERROR err = VL53L1_RdByte(busDev, 0x010F, &model_id);
         if (err == 0 && model_id == 0xEA) {
@@ -1681,7 +1731,8 @@ bool vl53l1xDetect(rangefinderDev_t * rangefinder)
         return false;
     }
 
-    rangefinder->delayMs = RANGEFINDER_VL53L1X_TASK_PERIOD_MS;
+    // GPIO1 is cheap to poll, a result is then picked up soon after it is ready
+    rangefinder->delayMs = rangefinder->busDev->irqPin ? VL53L1X_DATA_READY_POLL_MS : RANGEFINDER_VL53L1X_TASK_PERIOD_MS;
     rangefinder->maxRangeCm = VL53L1X_MAX_RANGE_CM;
     rangefinder->detectionConeDeciDegrees = VL53L1X_DETECTION_CONE_DECIDEGREES;
     rangefinder->detectionConeExtendedDeciDegrees = VL53L1X_DETECTION_CONE_DECIDEGREES;
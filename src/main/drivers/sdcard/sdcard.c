@@ -91,6 +91,8 @@ void sdcard_init(void)
     sdcardVTable = &sdcardSpiVTable;
 #elif defined(USE_SDCARD_SDIO)
     sdcardVTable = &sdcardSdioVTable;
+#elif defined(USE_SDCARD_FILE)
+    sdcardVTable = &sdcardFileVTable;
 #endif
 
     if (sdcardVTable) {
@@ -162,4 +164,13 @@ const sdcardMetadata_t* sdcard_getMetadata(void)
     }
 }
 
+const sdcardStats_t* sdcard_getStats(void)
+{
+    if (sdcardVTable && sdcardVTable->getStats) {
+        return sdcardVTable->getStats();
+    } else {
+        return NULL;
+    }
+}
+
 #endif
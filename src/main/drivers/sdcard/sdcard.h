@@ -48,6 +48,21 @@ typedef enum {
     SDCARD_OPERATION_FAILURE
 } sdcardOperationStatus_e;
 
+/*
+ * Busy periods are timed from the card accepting a block (or the stop token of a multi-block write) to
+ * the poll that finds it idle again, so they are accurate to the period of sdcard_poll().
+ */
+typedef struct sdcardStats_s {
+    uint32_t blocksRead;
+    uint32_t blocksWritten;
+    uint32_t queuedWrites;          // Blocks accepted while the card was still busy with the previous one
+    uint32_t busyRejects;           // Operations refused because the card was busy
+    uint32_t busyPeriods;
+    uint32_t busyTimeUs;            // Total time of those busy periods
+    uint32_t busyMaxUs;             // Longest of them
+    uint32_t busyPolls;             // Bus transactions spent polling a busy card
+} sdcardStats_t;
+
 typedef void(*sdcard_operationCompleteCallback_c)(sdcardBlockOperation_e operation, uint32_t blockIndex, uint8_t *buffer, uint32_t callbackData);
 
 void sdcard_init(void);
@@ -66,3 +81,5 @@ bool sdcard_isFunctional(void);
 
 bool sdcard_poll(void);
 const sdcardMetadata_t* sdcard_getMetadata(void);
+// NULL if the driver doesn't keep statistics
+const sdcardStats_t* sdcard_getStats(void);
@@ -0,0 +1,326 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SD card backed by a disk image file on the host, for SITL and unit tests. The card follows the same
+ * state machine as the SPI driver (including multi-block writes) and stays busy for a configurable time
+ * after every operation, so asyncfatfs sees a card with realistic latencies.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "platform.h"
+
+#if defined(USE_SDCARD) && defined(USE_SDCARD_FILE)
+
+#include "common/utils.h"
+
+#include "drivers/time.h"
+
+#include "drivers/sdcard/sdcard.h"
+#include "drivers/sdcard/sdcard_impl.h"
+#include "drivers/sdcard/sdcard_file.h"
+
+static FILE *imageFd = NULL;
+static char imagePath[260] = SDCARD_FILE_DEFAULT_PATH;
+
+static sdcardFileTiming_t timing = {
+    .readBlockUs = 250,
+    .writeBlockUs = 1500,
+    .multiWriteBlockUs = 250,
+    .multiWriteStopUs = 1000,
+};
+
+static sdcardFileStats_t stats;
+
+static timeUs_t busyStartUs;
+static timeUs_t busyUntilUs;
+
+bool sdcardFileSetPath(const char *path)
+{
+    if (!path || strlen(path) >= sizeof(imagePath)) {
+        return false;
+    }
+
+    strcpy(imagePath, path);
+    return true;
+}
+
+void sdcardFileSetTiming(const sdcardFileTiming_t *newTiming)
+{
+    timing = *newTiming;
+}
+
+const sdcardFileStats_t *sdcardFileGetStats(void)
+{
+    return &stats;
+}
+
+void sdcardFileResetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+static void sdcardFile_setBusy(sdcardState_e state, uint32_t durationUs)
+{
+    sdcard.state = state;
+    busyStartUs = micros();
+    busyUntilUs = busyStartUs + durationUs;
+}
+
+static bool sdcardFile_busyElapsed(void)
+{
+    const timeUs_t currentTimeUs = micros();
+
+    if (cmpTimeUs(currentTimeUs, busyUntilUs) < 0) {
+        return false;
+    }
+
+    stats.busyTimeUs += busyUntilUs - busyStartUs;
+    return true;
+}
+
+static bool sdcardFile_transfer(uint32_t blockIndex, uint8_t *buffer, bool write)
+{
+    if (blockIndex >= sdcard.metadata.numBlocks || fseek(imageFd, (long)blockIndex * SDCARD_BLOCK_SIZE, SEEK_SET) != 0) {
+        return false;
+    }
+
+    if (write) {
+        return fwrite(buffer, SDCARD_BLOCK_SIZE, 1, imageFd) == 1;
+    } else {
+        return fread(buffer, SDCARD_BLOCK_SIZE, 1, imageFd) == 1;
+    }
+}
+
+static bool sdcardFile_isReady(void)
+{
+    return sdcard.state == SDCARD_STATE_READY || sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+}
+
+/**
+ * Send the stop-transmission token to complete a multi-block write. The card is busy for a while afterwards.
+ */
+static sdcardOperationStatus_e sdcardFile_endWriteBlocks(void)
+{
+    sdcard.multiWriteBlocksRemain = 0;
+
+    if (timing.multiWriteStopUs == 0) {
+        sdcard.state = SDCARD_STATE_READY;
+        return SDCARD_OPERATION_SUCCESS;
+    }
+
+    sdcardFile_setBusy(SDCARD_STATE_STOPPING_MULTIPLE_BLOCK_WRITE, timing.multiWriteStopUs);
+    return SDCARD_OPERATION_IN_PROGRESS;
+}
+
+static bool sdcardFile_poll(void)
+{
+    if (!imageFd) {
+        return false;
+    }
+
+    switch (sdcard.state) {
+        case SDCARD_STATE_READING:
+            if (sdcardFile_busyElapsed()) {
+                sdcard.state = SDCARD_STATE_READY;
+
+                if (sdcard.pendingOperation.callback) {
+                    sdcard.pendingOperation.callback(
+                        SDCARD_BLOCK_OPERATION_READ,
+                        sdcard.pendingOperation.blockIndex,
+                        sdcard.pendingOperation.buffer,
+                        sdcard.pendingOperation.callbackData
+                    );
+                }
+            }
+        break;
+
+        case SDCARD_STATE_WAITING_FOR_WRITE:
+            if (sdcardFile_busyElapsed()) {
+                // Still more blocks left to write in a multi-block chain?
+                if (sdcard.multiWriteBlocksRemain > 1) {
+                    sdcard.multiWriteBlocksRemain--;
+                    sdcard.multiWriteNextBlock++;
+                    sdcard.state = SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+                } else if (sdcard.multiWriteBlocksRemain == 1) {
+                    sdcardFile_endWriteBlocks();
+                } else {
+                    sdcard.state = SDCARD_STATE_READY;
+                }
+            }
+        break;
+
+        case SDCARD_STATE_STOPPING_MULTIPLE_BLOCK_WRITE:
+            if (sdcardFile_busyElapsed()) {
+                sdcard.state = SDCARD_STATE_READY;
+            }
+        break;
+
+        default:
+            ;
+    }
+
+    return sdcardFile_isReady();
+}
+
+static sdcardOperationStatus_e sdcardFile_writeBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData)
+{
+    UNUSED(callback);
+    UNUSED(callbackData);
+
+    uint32_t busyUs;
+
+    switch (sdcard.state) {
+        case SDCARD_STATE_WRITING_MULTIPLE_BLOCKS:
+            // Do we need to cancel the previous multi-block write?
+            if (blockIndex != sdcard.multiWriteNextBlock) {
+                if (sdcardFile_endWriteBlocks() != SDCARD_OPERATION_SUCCESS) {
+                    stats.busyRejects++;
+                    return SDCARD_OPERATION_BUSY;
+                }
+                busyUs = timing.writeBlockUs;
+            } else {
+                busyUs = timing.multiWriteBlockUs;
+            }
+        break;
+        case SDCARD_STATE_READY:
+            busyUs = timing.writeBlockUs;
+        break;
+        default:
+            stats.busyRejects++;
+            return SDCARD_OPERATION_BUSY;
+    }
+
+    if (!sdcardFile_transfer(blockIndex, buffer, true)) {
+        return SDCARD_OPERATION_FAILURE;
+    }
+
+    stats.blocksWritten++;
+
+    // The buffer has been consumed straight away, the card is only busy programming it afterwards
+    sdcardFile_setBusy(SDCARD_STATE_WAITING_FOR_WRITE, busyUs);
+
+    return SDCARD_OPERATION_SUCCESS;
+}
+
+static sdcardOperationStatus_e sdcardFile_beginWriteBlocks(uint32_t blockIndex, uint32_t blockCount)
+{
+    if (sdcard.state != SDCARD_STATE_READY) {
+        if (sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS) {
+            if (blockIndex == sdcard.multiWriteNextBlock) {
+                // Assume that the caller wants to continue the multi-block write they already have in progress!
+                return SDCARD_OPERATION_SUCCESS;
+            } else if (sdcardFile_endWriteBlocks() != SDCARD_OPERATION_SUCCESS) {
+                stats.busyRejects++;
+                return SDCARD_OPERATION_BUSY;
+            }
+        } else {
+            stats.busyRejects++;
+            return SDCARD_OPERATION_BUSY;
+        }
+    }
+
+    sdcard.state = SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+    sdcard.multiWriteBlocksRemain = blockCount;
+    sdcard.multiWriteNextBlock = blockIndex;
+
+    stats.multiBlockWrites++;
+
+    return SDCARD_OPERATION_SUCCESS;
+}
+
+static bool sdcardFile_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_operationCompleteCallback_c callback, uint32_t callbackData)
+{
+    if (sdcard.state != SDCARD_STATE_READY) {
+        if (sdcard.state != SDCARD_STATE_WRITING_MULTIPLE_BLOCKS || sdcardFile_endWriteBlocks() != SDCARD_OPERATION_SUCCESS) {
+            stats.busyRejects++;
+            return false;
+        }
+    }
+
+    if (!sdcardFile_transfer(blockIndex, buffer, false)) {
+        return false;
+    }
+
+    stats.blocksRead++;
+
+    sdcard.pendingOperation.buffer = buffer;
+    sdcard.pendingOperation.blockIndex = blockIndex;
+    sdcard.pendingOperation.callback = callback;
+    sdcard.pendingOperation.callbackData = callbackData;
+
+    sdcardFile_setBusy(SDCARD_STATE_READING, timing.readBlockUs);
+
+    return true;
+}
+
+static bool sdcardFile_isFunctional(void)
+{
+    return sdcard.state != SDCARD_STATE_NOT_PRESENT;
+}
+
+static bool sdcardFile_isInitialized(void)
+{
+    return sdcard.state >= SDCARD_STATE_READY;
+}
+
+static const sdcardMetadata_t* sdcardFile_getMetadata(void)
+{
+    return &sdcard.metadata;
+}
+
+static void sdcardFile_init(void)
+{
+    memset(&sdcard.metadata, 0, sizeof(sdcard.metadata));
+    sdcard.multiWriteBlocksRemain = 0;
+
+    if (imageFd) {
+        fclose(imageFd);
+    }
+
+    imageFd = fopen(imagePath, "r+b");
+    if (!imageFd) {
+        fprintf(stderr, "[SDCARD] Unable to open image '%s'\n", imagePath);
+        sdcard.state = SDCARD_STATE_NOT_PRESENT;
+        return;
+    }
+
+    fseek(imageFd, 0, SEEK_END);
+    sdcard.metadata.numBlocks = ftell(imageFd) / SDCARD_BLOCK_SIZE;
+    strcpy(sdcard.metadata.productName, "FILE");
+
+    fprintf(stderr, "[SDCARD] Loaded '%s' (%u blocks)\n", imagePath, (unsigned)sdcard.metadata.numBlocks);
+
+    sdcard.state = SDCARD_STATE_READY;
+}
+
+sdcardVTable_t sdcardFileVTable = {
+    .init = &sdcardFile_init,
+    .readBlock = &sdcardFile_readBlock,
+    .beginWriteBlocks = &sdcardFile_beginWriteBlocks,
+    .writeBlock = &sdcardFile_writeBlock,
+    .poll = &sdcardFile_poll,
+    .isFunctional = &sdcardFile_isFunctional,
+    .isInitialized = &sdcardFile_isInitialized,
+    .getMetadata = &sdcardFile_getMetadata,
+};
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SDCARD_FILE_DEFAULT_PATH "sdcard.img"
+
+/*
+ * Simulated card latencies. The card is busy for this long after accepting each operation, which lets the
+ * filesystem be benchmarked against a realistic card instead of an infinitely fast disk.
+ */
+typedef struct sdcardFileTiming_s {
+    uint32_t readBlockUs;           // Time to fetch a single block
+    uint32_t writeBlockUs;          // Busy time after a single block write
+    uint32_t multiWriteBlockUs;     // Busy time after each block of a multi-block write
+    uint32_t multiWriteStopUs;      // Busy time after the stop token that ends a multi-block write
+} sdcardFileTiming_t;
+
+typedef struct sdcardFileStats_s {
+    uint32_t blocksRead;
+    uint32_t blocksWritten;
+    uint32_t multiBlockWrites;      // Number of multi-block writes started
+    uint32_t busyRejects;           // Operations refused because the card was busy
+    uint32_t busyTimeUs;            // Total simulated time the card spent busy
+} sdcardFileStats_t;
+
+bool sdcardFileSetPath(const char *path);
+void sdcardFileSetTiming(const sdcardFileTiming_t *timing);
+const sdcardFileStats_t *sdcardFileGetStats(void);
+void sdcardFileResetStats(void);
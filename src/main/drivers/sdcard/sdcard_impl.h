@@ -54,6 +54,7 @@ typedef struct sdcard_t {
         uint8_t *buffer;
         uint32_t blockIndex;
         uint8_t chunkIndex;
+        bool queued;            // Next block of a multi-block write, waiting for the card to finish the previous one
 
         sdcard_operationCompleteCallback_c callback;
         uint32_t callbackData;
@@ -101,6 +102,7 @@ typedef struct sdcardVTable_s {
     bool (*isFunctional)(void);
     bool (*isInitialized)(void);
     const sdcardMetadata_t* (*getMetadata)(void);
+    const sdcardStats_t* (*getStats)(void);
 } sdcardVTable_t;
 
 #ifdef USE_SDCARD_SPI
@@ -110,3 +112,7 @@ extern sdcardVTable_t sdcardSpiVTable;
 #ifdef USE_SDCARD_SDIO
 extern sdcardVTable_t sdcardSdioVTable;
 #endif
+
+#ifdef USE_SDCARD_FILE
+extern sdcardVTable_t sdcardFileVTable;
+#endif
@@ -20,10 +20,12 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "platform.h"
 
 #include "build/debug.h"
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/time.h"
@@ -48,10 +50,16 @@
 /* Break up 512-byte SD card sectors into chunks of this size to reduce the peak overhead per call to sdcard_poll(). */
 #define SDCARD_BLOCK_CHUNK_SIZE     128
 
+/* A busy card is polled with a single transaction of this many bytes per call to sdcard_poll() */
+#define SDCARD_BUSY_POLL_BYTES      8
+
 #ifndef SDCARD_BUS_SPEED
 #define SDCARD_BUS_SPEED            BUS_SPEED_STANDARD
 #endif
 
+static sdcardStats_t stats;
+static timeUs_t busyStartUs;
+
 static void sdcardSpi_select(void)
 {
     busSelectDevice(sdcard.dev);
@@ -110,16 +118,52 @@ static void sdcardSpi_reset(void)
  */
 static bool sdcardSpi_waitForIdle(int maxBytesToWait)
 {
+    uint8_t response[SDCARD_MAXIMUM_BYTE_DELAY_FOR_CMD_REPLY];
+
+    // The card is usually idle already so look at one byte first, then read the rest in bursts
+    int burst = 1;
+
     while (maxBytesToWait > 0) {
-        uint8_t response;
+        const int count = MIN(burst, maxBytesToWait);
 
-        busTransfer(sdcard.dev, &response, NULL, 1);
+        busTransfer(sdcard.dev, response, NULL, count);
 
-        if (response == 0xFF) {
-            return true;
+        for (int i = 0; i < count; i++) {
+            if (response[i] == 0xFF) {
+                return true;
+            }
         }
 
-        maxBytesToWait--;
+        maxBytesToWait -= count;
+        burst = sizeof(response);
+    }
+
+    return false;
+}
+
+/**
+ * Poll a card that is busy programming a block with a single bus transaction. The card holds its output low until
+ * it's done, the idle bytes that follow in the same burst are harmless.
+ *
+ * Returns true when the card has become idle, the busy period is added to the statistics.
+ */
+static bool sdcardSpi_pollBusy(void)
+{
+    uint8_t response[SDCARD_BUSY_POLL_BYTES];
+
+    busTransfer(sdcard.dev, response, NULL, sizeof(response));
+    stats.busyPolls++;
+
+    for (unsigned i = 0; i < sizeof(response); i++) {
+        if (response[i] == 0xFF) {
+            const uint32_t busyUs = micros() - busyStartUs;
+
+            stats.busyPeriods++;
+            stats.busyTimeUs += busyUs;
+            stats.busyMaxUs = MAX(stats.busyMaxUs, busyUs);
+
+            return true;
+        }
     }
 
     return false;
@@ -254,20 +298,39 @@ typedef enum {
  */
 static sdcardReceiveBlockStatus_e sdcardSpi_receiveDataBlock(uint8_t *buffer, int count)
 {
-    uint8_t dataToken = sdcardSpi_waitForNonIdleByte(8);
+    // Wait for the data token for up to 8 idle bytes in a single burst
+    uint8_t response[SDCARD_MAXIMUM_BYTE_DELAY_FOR_CMD_REPLY + 1];
+    int tokenIndex = 0;
+
+    busTransfer(sdcard.dev, response, NULL, sizeof(response));
 
-    if (dataToken == 0xFF) {
+    while (tokenIndex < (int)sizeof(response) && response[tokenIndex] == 0xFF) {
+        tokenIndex++;
+    }
+
+    if (tokenIndex == (int)sizeof(response)) {
         return SDCARD_RECEIVE_BLOCK_IN_PROGRESS;
     }
 
-    if (dataToken != SDCARD_SINGLE_BLOCK_READ_START_TOKEN) {
+    if (response[tokenIndex] != SDCARD_SINGLE_BLOCK_READ_START_TOKEN) {
         return SDCARD_RECEIVE_ERROR;
     }
 
-    busTransfer(sdcard.dev, buffer, NULL, count);
+    // Bytes clocked in after the token are the start of the block (and maybe its CRC)
+    const int extra = sizeof(response) - tokenIndex - 1;
+    const int received = MIN(extra, count);
+    const int crcReceived = MIN(extra - received, 2);
+
+    memcpy(buffer, &response[tokenIndex + 1], received);
+
+    if (received < count) {
+        busTransfer(sdcard.dev, buffer + received, NULL, count - received);
+    }
 
     // Discard trailing CRC, we don't care
-    busTransfer(sdcard.dev, NULL, NULL, 2);
+    if (crcReceived < 2) {
+        busTransfer(sdcard.dev, NULL, NULL, 2 - crcReceived);
+    }
 
     return SDCARD_RECEIVE_SUCCESS;
 }
@@ -402,11 +465,13 @@ static bool sdcardSpi_setBlockLength(uint32_t blockLen)
 }
 
 /*
- * Returns true if the card is ready to accept read/write commands.
+ * Returns true if the card is ready to accept read/write commands, or at least the next block of a multi-block write
+ * while it's still busy with the previous one.
  */
 static bool sdcardSpi_isReady(void)
 {
-    return sdcard.state == SDCARD_STATE_READY || sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+    return sdcard.state == SDCARD_STATE_READY || sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS
+        || (sdcard.state == SDCARD_STATE_WAITING_FOR_WRITE && sdcard.multiWriteBlocksRemain > 1 && !sdcard.pendingOperation.queued);
 }
 
 /**
@@ -435,6 +500,7 @@ static sdcardOperationStatus_e sdcardSpi_endWriteBlocks(void)
     } else {
         sdcard.state = SDCARD_STATE_STOPPING_MULTIPLE_BLOCK_WRITE;
         sdcard.operationStartTime = millis();
+        busyStartUs = micros();
 
         return SDCARD_OPERATION_IN_PROGRESS;
     }
@@ -548,6 +614,8 @@ static bool sdcardSpi_poll(void)
                     // The SD card is now busy committing that write to the card
                     sdcard.state = SDCARD_STATE_WAITING_FOR_WRITE;
                     sdcard.operationStartTime = millis();
+                    busyStartUs = micros();
+                    stats.blocksWritten++;
 
                     // Since we've transmitted the buffer we can go ahead and tell the caller their operation is complete
                     if (sdcard.pendingOperation.callback) {
@@ -569,14 +637,24 @@ static bool sdcardSpi_poll(void)
             }
         break;
         case SDCARD_STATE_WAITING_FOR_WRITE:
-            if (sdcardSpi_waitForIdle(SDCARD_MAXIMUM_BYTE_DELAY_FOR_CMD_REPLY)) {
+            if (sdcardSpi_pollBusy()) {
                 sdcard.failureCount = 0; // Assume the card is good if it can complete a write
 
                 // Still more blocks left to write in a multi-block chain?
                 if (sdcard.multiWriteBlocksRemain > 1) {
                     sdcard.multiWriteBlocksRemain--;
                     sdcard.multiWriteNextBlock++;
-                    sdcard.state = SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+
+                    if (sdcard.pendingOperation.queued) {
+                        // The caller gave us the next block while the card was busy, start sending it right away
+                        sdcard.pendingOperation.queued = false;
+                        sdcard.pendingOperation.chunkIndex = 1;
+                        sdcard.state = SDCARD_STATE_SENDING_WRITE;
+
+                        sdcardSpi_sendDataBlockBegin(sdcard.pendingOperation.buffer, true);
+                    } else {
+                        sdcard.state = SDCARD_STATE_WRITING_MULTIPLE_BLOCKS;
+                    }
                 } else if (sdcard.multiWriteBlocksRemain == 1) {
                     // This function changes the sd card state for us whether immediately succesful or delayed:
                     if (sdcardSpi_endWriteBlocks() == SDCARD_OPERATION_SUCCESS) {
@@ -593,6 +671,16 @@ static bool sdcardSpi_poll(void)
                  * them to reuse their buffer milliseconds faster than they otherwise would.
                  */
                 sdcardSpi_reset();
+
+                // A block that was queued behind it never made it to the card though
+                if (sdcard.pendingOperation.queued) {
+                    sdcard.pendingOperation.queued = false;
+
+                    if (sdcard.pendingOperation.callback) {
+                        sdcard.pendingOperation.callback(SDCARD_BLOCK_OPERATION_WRITE, sdcard.pendingOperation.blockIndex, NULL, sdcard.pendingOperation.callbackData);
+                    }
+                }
+
                 goto doMore;
             }
         break;
@@ -603,6 +691,7 @@ static bool sdcardSpi_poll(void)
 
                     sdcard.state = SDCARD_STATE_READY;
                     sdcard.failureCount = 0; // Assume the card is good if it can complete a read
+                    stats.blocksRead++;
 
                     if (sdcard.pendingOperation.callback) {
                         sdcard.pendingOperation.callback(
@@ -639,7 +728,7 @@ static bool sdcardSpi_poll(void)
             }
         break;
         case SDCARD_STATE_STOPPING_MULTIPLE_BLOCK_WRITE:
-            if (sdcardSpi_waitForIdle(SDCARD_MAXIMUM_BYTE_DELAY_FOR_CMD_REPLY)) {
+            if (sdcardSpi_pollBusy()) {
                 sdcardSpi_deselect();
 
                 sdcard.state = SDCARD_STATE_READY;
@@ -669,9 +758,9 @@ static bool sdcardSpi_poll(void)
  * buffer pointer will be the same buffer you originally passed in, otherwise the buffer will be set to NULL.
  *
  * Returns:
- *     SDCARD_OPERATION_IN_PROGRESS - Your buffer is currently being transmitted to the card and your callback will be
- *                                    called later to report the completion. The buffer pointer must remain valid until
- *                                    that time.
+ *     SDCARD_OPERATION_IN_PROGRESS - Your buffer is currently being transmitted to the card, or queued behind the
+ *                                    previous block of a multi-block write, and your callback will be called later to
+ *                                    report the completion. The buffer pointer must remain valid until that time.
  *     SDCARD_OPERATION_SUCCESS     - Your buffer has been transmitted to the card now.
  *     SDCARD_OPERATION_BUSY        - The card is already busy and cannot accept your write
  *     SDCARD_OPERATION_FAILURE     - Your write was rejected by the card, card will be reset
@@ -689,12 +778,31 @@ static sdcardOperationStatus_e sdcardSpi_writeBlock(uint32_t blockIndex, uint8_t
                     // Now we've entered the ready state, we can try again
                     goto doMore;
                 } else {
+                    stats.busyRejects++;
                     return SDCARD_OPERATION_BUSY;
                 }
             }
 
             // We're continuing a multi-block write
         break;
+        case SDCARD_STATE_WAITING_FOR_WRITE:
+            /*
+             * The card is still programming the previous block of a multi-block write. Take the next block now so
+             * sdcard_poll() can send it as soon as the card is done, instead of waiting for the caller to retry.
+             */
+            if (!sdcard.pendingOperation.queued && sdcard.multiWriteBlocksRemain > 1 && blockIndex == sdcard.multiWriteNextBlock + 1) {
+                sdcard.pendingOperation.buffer = buffer;
+                sdcard.pendingOperation.blockIndex = blockIndex;
+                sdcard.pendingOperation.callback = callback;
+                sdcard.pendingOperation.callbackData = callbackData;
+                sdcard.pendingOperation.queued = true;
+                stats.queuedWrites++;
+
+                return SDCARD_OPERATION_IN_PROGRESS;
+            }
+
+            stats.busyRejects++;
+            return SDCARD_OPERATION_BUSY;
         case SDCARD_STATE_READY:
             // We're not continuing a multi-block write so we need to send a single-block write command
             sdcardSpi_select();
@@ -711,6 +819,7 @@ static sdcardOperationStatus_e sdcardSpi_writeBlock(uint32_t blockIndex, uint8_t
             }
         break;
         default:
+            stats.busyRejects++;
             return SDCARD_OPERATION_BUSY;
     }
 
@@ -747,9 +856,15 @@ static sdcardOperationStatus_e sdcardSpi_beginWriteBlocks(uint32_t blockIndex, u
                 // Assume that the caller wants to continue the multi-block write they already have in progress!
                 return SDCARD_OPERATION_SUCCESS;
             } else if (sdcardSpi_endWriteBlocks() != SDCARD_OPERATION_SUCCESS) {
+                stats.busyRejects++;
                 return SDCARD_OPERATION_BUSY;
             } // Else we've completed the previous multi-block write and can fall through to start the new one
+        } else if (sdcard.state == SDCARD_STATE_WAITING_FOR_WRITE && sdcard.multiWriteBlocksRemain > 1
+                && blockIndex == sdcard.multiWriteNextBlock + 1) {
+            // The previous block of the multi-block write is still being programmed, the caller can queue this one
+            return SDCARD_OPERATION_SUCCESS;
         } else {
+            stats.busyRejects++;
             return SDCARD_OPERATION_BUSY;
         }
     }
@@ -792,9 +907,11 @@ static bool sdcardSpi_readBlock(uint32_t blockIndex, uint8_t *buffer, sdcard_ope
     if (sdcard.state != SDCARD_STATE_READY) {
         if (sdcard.state == SDCARD_STATE_WRITING_MULTIPLE_BLOCKS) {
             if (sdcardSpi_endWriteBlocks() != SDCARD_OPERATION_SUCCESS) {
+                stats.busyRejects++;
                 return false;
             }
         } else {
+            stats.busyRejects++;
             return false;
         }
     }
@@ -836,11 +953,19 @@ static const sdcardMetadata_t* sdcardSpi_getMetadata(void)
     return &sdcard.metadata;
 }
 
+static const sdcardStats_t* sdcardSpi_getStats(void)
+{
+    return &stats;
+}
+
 /**
  * Begin the initialization process for the SD card. This must be called first before any other sdcard_ routine.
  */
 void sdcardSpi_init(void)
 {
+    memset(&stats, 0, sizeof(stats));
+    sdcard.pendingOperation.queued = false;
+
     sdcard.dev = busDeviceInit(BUSTYPE_SPI, DEVHW_SDCARD, 0, OWNER_SDCARD);
     if (!sdcard.dev) {
         sdcard.state = SDCARD_STATE_NOT_PRESENT;
@@ -883,6 +1008,7 @@ sdcardVTable_t sdcardSpiVTable = {
     .isFunctional = &sdcardSpi_isFunctional,
     .isInitialized = &sdcardSpi_isInitialized,
     .getMetadata = &sdcardSpi_getMetadata,
+    .getStats = &sdcardSpi_getStats,
 };
 
 #endif
@@ -71,6 +71,51 @@ uint8_t serialRead(serialPort_t *instance)
     return instance->vTable->serialRead(instance);
 }
 
+/*
+ * Parsers take the received bytes as blocks instead of calling serialRead() for each byte:
+ *
+ *     while ((count = serialRxPeek(port, &data)) > 0) {
+ *         ... parse data[0 .. count - 1] ...
+ *         serialRxConsume(port, count);
+ *     }
+ *
+ * At the end of the ring buffer a block stops, the rest is returned by the next call.
+ */
+uint32_t serialRxPeek(serialPort_t *instance, const uint8_t **data)
+{
+    return instance->vTable->serialRxPeek(instance, data);
+}
+
+void serialRxConsume(serialPort_t *instance, uint32_t count)
+{
+    instance->vTable->serialRxConsume(instance, count);
+}
+
+uint32_t serialRxBufferPeek(serialPort_t *instance, const uint8_t **data)
+{
+    const uint32_t head = instance->rxBufferHead;
+    const uint32_t tail = instance->rxBufferTail;
+
+    *data = (const uint8_t *)&instance->rxBuffer[tail];
+
+    if (head >= tail) {
+        return head - tail;
+    } else {
+        return instance->rxBufferSize - tail;
+    }
+}
+
+void serialRxBufferConsume(serialPort_t *instance, uint32_t count)
+{
+    uint32_t tail = instance->rxBufferTail + count;
+
+    if (tail >= instance->rxBufferSize) {
+        tail -= instance->rxBufferSize;
+    }
+
+    instance->rxBufferTail = tail;
+}
+
 void serialSetBaudRate(serialPort_t *instance, uint32_t baudRate)
 {
     instance->vTable->serialSetBaudRate(instance, baudRate);
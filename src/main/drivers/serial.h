@@ -16,6 +16,8 @@
  */
 
 #pragma once
+#include "common/time.h"
+
 #include "drivers/io.h"
 
 typedef struct {
@@ -76,6 +78,9 @@ typedef struct serialPort_s {
     uint32_t txBufferHead;
     uint32_t txBufferTail;
 
+    // Arrival of the first byte received while rxBuffer was empty, by the drivers receiving into rxBuffer
+    timeUs_t rxBufferFirstByteUs;
+
     serialReceiveCallbackPtr rxCallback;
     void *rxCallbackData;
 } serialPort_t;
@@ -88,6 +93,10 @@ struct serialPortVTable {
 
     uint8_t (*serialRead)(serialPort_t *instance);
 
+    // Largest block of received bytes that is contiguous in memory, the bytes stay in the buffer until consumed
+    uint32_t (*serialRxPeek)(serialPort_t *instance, const uint8_t **data);
+    void (*serialRxConsume)(serialPort_t *instance, uint32_t count);
+
     // Specified baud rate may not be allowed by an implementation, use serialGetBaudRate to determine actual baud rate in use.
     void (*serialSetBaudRate)(serialPort_t *instance, uint32_t baudRate);
 
@@ -111,6 +120,11 @@ uint32_t serialRxBytesWaiting(const serialPort_t *instance);
 uint32_t serialTxBytesFree(const serialPort_t *instance);
 void serialWriteBuf(serialPort_t *instance, const uint8_t *data, int count);
 uint8_t serialRead(serialPort_t *instance);
+uint32_t serialRxPeek(serialPort_t *instance, const uint8_t **data);
+void serialRxConsume(serialPort_t *instance, uint32_t count);
+// serialRxPeek/serialRxConsume for ports receiving into rxBuffer
+uint32_t serialRxBufferPeek(serialPort_t *instance, const uint8_t **data);
+void serialRxBufferConsume(serialPort_t *instance, uint32_t count);
 void serialSetBaudRate(serialPort_t *instance, uint32_t baudRate);
 void serialSetMode(serialPort_t *instance, portMode_t mode);
 bool isSerialTransmitBufferEmpty(const serialPort_t *instance);
@@ -37,6 +37,7 @@
 
 #include "drivers/nvic.h"
 #include "drivers/io.h"
+#include "drivers/time.h"
 #include "drivers/timer.h"
 
 #include "serial.h"
@@ -450,6 +451,9 @@ void extractAndStoreRxByte(softSerial_t *softSerial)
     if (softSerial->port.rxCallback) {
         softSerial->port.rxCallback(rxByte, softSerial->port.rxCallbackData);
     } else {
+        if (softSerial->port.rxBufferHead == softSerial->port.rxBufferTail) {
+            softSerial->port.rxBufferFirstByteUs = microsISR();
+        }
         softSerial->port.rxBuffer[softSerial->port.rxBufferHead] = rxByte;
         softSerial->port.rxBufferHead = (softSerial->port.rxBufferHead + 1) % softSerial->port.rxBufferSize;
     }
@@ -599,6 +603,15 @@ uint8_t softSerialReadByte(serialPort_t *instance)
     return ch;
 }
 
+static uint32_t softSerialRxPeek(serialPort_t *instance, const uint8_t **data)
+{
+    if ((instance->mode & MODE_RX) == 0) {
+        return 0;
+    }
+
+    return serialRxBufferPeek(instance, data);
+}
+
 void softSerialWriteByte(serialPort_t *s, uint8_t ch)
 {
     if ((s->mode & MODE_TX) == 0) {
@@ -633,6 +646,8 @@ static const struct serialPortVTable softSerialVTable = {
     .serialTotalRxWaiting = softSerialRxBytesWaiting,
     .serialTotalTxFree = softSerialTxBytesFree,
     .serialRead = softSerialReadByte,
+    .serialRxPeek = softSerialRxPeek,
+    .serialRxConsume = serialRxBufferConsume,
     .serialSetBaudRate = softSerialSetBaudRate,
     .isSerialTransmitBufferEmpty = isSoftSerialTransmitBufferEmpty,
     .setMode = softSerialSetMode,
@@ -32,20 +32,46 @@
 #if defined(SITL_BUILD)
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <errno.h>
 
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define USE_TCP_EPOLL
+#else
+#include <poll.h>
+#endif
+
+#include "common/maths.h"
 #include "common/utils.h"
 
 #include "drivers/serial.h"
 #include "drivers/serial_tcp.h"
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Waiting for the I/O thread to make room in a full tx buffer
+#define TCP_TX_WAIT_US  100
+
 static const struct serialPortVTable tcpVTable[];
 static tcpPort_t tcpPorts[SERIAL_PORT_COUNT];
 
+static pthread_t tcpIoThread;
+static bool tcpIoThreadStarted = false;
+static bool tcpIoThreadStop = false;
+static uint16_t tcpPortOffset = 0;
+static int tcpWakeFds[2] = { -1, -1 };
+#ifdef USE_TCP_EPOLL
+static int tcpEpollFd = -1;
+#endif
+
 static int lookup_address (char *name, int port, int type, struct sockaddr *addr, socklen_t* len )
 {
     struct addrinfo *servinfo, *p;
@@ -106,13 +132,350 @@ static char *tcpGetAddressString(struct sockaddr *addr)
     return (char *)res;
 }
 
-static void *tcpReceiveThread(void* arg)
+/*
+ * Ring buffers with one producer and one consumer thread. Head is only written by the producer and tail by the
+ * consumer, the acquire/release pairs make the data visible before the index that publishes it.
+ */
+static uint32_t tcpRingCount(uint32_t head, uint32_t tail, uint32_t size)
+{
+    return (head >= tail) ? head - tail : size + head - tail;
+}
+
+static uint32_t tcpRxCount(const tcpPort_t *port)
+{
+    const uint32_t head = __atomic_load_n(&port->serialPort.rxBufferHead, __ATOMIC_ACQUIRE);
+    const uint32_t tail = __atomic_load_n(&port->serialPort.rxBufferTail, __ATOMIC_RELAXED);
+    return tcpRingCount(head, tail, port->serialPort.rxBufferSize);
+}
+
+static uint32_t tcpTxFree(const tcpPort_t *port)
 {
-    tcpPort_t *port = (tcpPort_t*)arg;
-    while(tcpReceive(port) >= 0)
+    const uint32_t head = __atomic_load_n(&port->serialPort.txBufferHead, __ATOMIC_RELAXED);
+    const uint32_t tail = __atomic_load_n(&port->serialPort.txBufferTail, __ATOMIC_ACQUIRE);
+    return port->serialPort.txBufferSize - 1 - tcpRingCount(head, tail, port->serialPort.txBufferSize);
+}
+
+static bool tcpClientConnected(const tcpPort_t *port)
+{
+    return __atomic_load_n(&port->isClientConnected, __ATOMIC_ACQUIRE);
+}
+
+static void tcpWakeIoThread(void)
+{
+    const uint8_t wake = 0;
+    // A full pipe already has a wakeup pending
+    if (write(tcpWakeFds[1], &wake, 1) < 0 && errno != EAGAIN) {
+        fprintf(stderr, "[SOCKET] Unable to wake I/O thread: %s\n", strerror(errno));
+    }
+}
+
+/*
+ * Sockets the I/O thread waits on: the listening one until a client connects, then the client, also for writing
+ * while sending is blocked. Tokens are the port index, or SERIAL_PORT_COUNT for the wakeup pipe.
+ */
+static void tcpGetInterest(const tcpPort_t *port, int *fd, bool *writable)
+{
+    if (!port->isInitalized) {
+        *fd = -1;
+    } else if (port->isClientConnected) {
+        *fd = port->clientSocketFd;
+    } else {
+        *fd = port->socketFd;
+    }
+    *writable = port->isClientConnected && port->txBlocked;
+}
+
+#ifdef USE_TCP_EPOLL
+static void tcpWatch(int op, int fd, uint32_t token, bool writable)
+{
+    struct epoll_event event = {
+        .events = EPOLLIN | (writable ? EPOLLOUT : 0),
+        .data.u32 = token,
+    };
+
+    if (epoll_ctl(tcpEpollFd, op, fd, &event) < 0) {
+        fprintf(stderr, "[SOCKET] epoll_ctl: %s\n", strerror(errno));
+    }
+}
+#endif
+
+// Called by the I/O thread after changing the state of a port, and once when the port is opened
+static void tcpUpdateInterest(tcpPort_t *port, int previousFd, bool previousWritable)
+{
+    int fd;
+    bool writable;
+    tcpGetInterest(port, &fd, &writable);
+
+#ifdef USE_TCP_EPOLL
+    if (fd != previousFd) {
+        // Closed sockets leave the epoll set by themselves
+        if (previousFd >= 0 && previousFd != port->clientSocketFd) {
+            epoll_ctl(tcpEpollFd, EPOLL_CTL_DEL, previousFd, NULL);
+        }
+        if (fd >= 0) {
+            tcpWatch(EPOLL_CTL_ADD, fd, port - tcpPorts, writable);
+        }
+    } else if (fd >= 0 && writable != previousWritable) {
+        tcpWatch(EPOLL_CTL_MOD, fd, port - tcpPorts, writable);
+    }
+#else
+    // The poll set is rebuilt on every wait
+    UNUSED(port);
+    UNUSED(fd);
+    UNUSED(writable);
+    UNUSED(previousFd);
+    UNUSED(previousWritable);
+#endif
+}
+
+static void tcpAccept(tcpPort_t *port)
+{
+    socklen_t addrLen = sizeof(struct sockaddr_storage);
+    const int clientSocketFd = accept(port->socketFd, (struct sockaddr*)&port->clientAddress, &addrLen);
+    if (clientSocketFd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            fprintf(stderr, "[SOCKET] Can't accept connection.\n");
+        }
+        return;
+    }
+
+    fcntl(clientSocketFd, F_SETFL, fcntl(clientSocketFd, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(clientSocketFd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+    // Whatever was written while nobody was connected is not for this client
+    __atomic_store_n(&port->serialPort.txBufferTail, __atomic_load_n(&port->serialPort.txBufferHead, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+
+    fprintf(stderr, "[SOCKET] %s connected to UART%d\n", tcpGetAddressString((struct sockaddr *)&port->clientAddress), port->id);
+
+    const int previousFd = port->socketFd;
+    port->clientSocketFd = clientSocketFd;
+    port->txBlocked = false;
+    __atomic_store_n(&port->isClientConnected, true, __ATOMIC_RELEASE);
+    tcpUpdateInterest(port, previousFd, false);
+}
+
+static void tcpDisconnect(tcpPort_t *port)
+{
+    fprintf(stderr, "[SOCKET] %s disconnected from UART%d\n", tcpGetAddressString((struct sockaddr *)&port->clientAddress), port->id);
+
+    const int previousFd = port->clientSocketFd;
+    const bool previousWritable = port->txBlocked;
+
+    __atomic_store_n(&port->isClientConnected, false, __ATOMIC_RELEASE);
+    close(port->clientSocketFd);
+    memset(&port->clientAddress, 0, sizeof(port->clientAddress));
+    port->txBlocked = false;
+
+    tcpUpdateInterest(port, previousFd, previousWritable);
+}
+
+static void tcpReceive(tcpPort_t *port)
+{
+    uint8_t buffer[TCP_BUFFER_SIZE];
+    const ssize_t recvSize = recv(port->clientSocketFd, buffer, TCP_BUFFER_SIZE, 0);
+
+    // recv() under cygwin does not recognise the closed connection under certain circumstances, but returns ECONNRESET as an error.
+    if (recvSize == 0 || (recvSize < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        tcpDisconnect(port);
+        return;
+    }
+
+    if (port->serialPort.rxCallback) {
+        for (ssize_t i = 0; i < recvSize; i++) {
+            port->serialPort.rxCallback((uint16_t)buffer[i], port->serialPort.rxCallbackData);
+        }
+        return;
+    }
+
+    const uint32_t size = port->serialPort.rxBufferSize;
+    uint32_t head = port->serialPort.rxBufferHead;
+    if (head == __atomic_load_n(&port->serialPort.rxBufferTail, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&port->serialPort.rxBufferFirstByteUs, micros(), __ATOMIC_RELAXED);
+    }
+    for (ssize_t i = 0; i < recvSize; i++) {
+        const uint32_t next = (head + 1) % size;
+        if (next == __atomic_load_n(&port->serialPort.rxBufferTail, __ATOMIC_ACQUIRE)) {
+            // Nobody is reading, drop what doesn't fit
+            break;
+        }
+        port->serialPort.rxBuffer[head] = buffer[i];
+        head = next;
+    }
+    __atomic_store_n(&port->serialPort.rxBufferHead, head, __ATOMIC_RELEASE);
+}
+
+// Sends as much of the tx buffer as the socket takes, the wrapped part in the same call
+static void tcpSend(tcpPort_t *port)
+{
+    const uint32_t size = port->serialPort.txBufferSize;
+    const uint32_t head = __atomic_load_n(&port->serialPort.txBufferHead, __ATOMIC_ACQUIRE);
+    const uint32_t tail = port->serialPort.txBufferTail;
+    const bool previousWritable = port->txBlocked;
+
+    if (head != tail) {
+        struct iovec iov[2];
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 1 };
+
+        iov[0].iov_base = (void *)&port->serialPort.txBuffer[tail];
+        if (head > tail) {
+            iov[0].iov_len = head - tail;
+        } else {
+            iov[0].iov_len = size - tail;
+            iov[1].iov_base = (void *)port->serialPort.txBuffer;
+            iov[1].iov_len = head;
+            msg.msg_iovlen = head ? 2 : 1;
+        }
+
+        const ssize_t sent = sendmsg(port->clientSocketFd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                tcpDisconnect(port);
+                return;
+            }
+        } else {
+            __atomic_store_n(&port->serialPort.txBufferTail, (tail + sent) % size, __ATOMIC_RELEASE);
+        }
+    }
+
+    // Wait for the socket to drain if some is left, otherwise for the next flush
+    port->txBlocked = __atomic_load_n(&port->serialPort.txBufferTail, __ATOMIC_RELAXED) != head;
+    if (port->txBlocked != previousWritable) {
+        tcpUpdateInterest(port, port->clientSocketFd, previousWritable);
+    }
+}
+
+static void tcpHandleEvent(tcpPort_t *port, bool readable, bool writable)
+{
+    if (!port->isClientConnected) {
+        if (readable) {
+            tcpAccept(port);
+        }
+        return;
+    }
+
+    if (readable) {
+        tcpReceive(port);
+    }
+    if (writable && port->isClientConnected) {
+        tcpSend(port);
+    }
+}
+
+static void tcpHandleWakeup(void)
+{
+    uint8_t buffer[64];
+    while (read(tcpWakeFds[0], buffer, sizeof(buffer)) > 0) {
         ;
+    }
+
+    for (int i = 0; i < SERIAL_PORT_COUNT; i++) {
+        tcpPort_t *port = &tcpPorts[i];
+        if (port->isInitalized && port->isClientConnected && !port->txBlocked) {
+            tcpSend(port);
+        }
+    }
+}
+
+static void *tcpIoThreadLoop(void *arg)
+{
+    UNUSED(arg);
+
+    while (!__atomic_load_n(&tcpIoThreadStop, __ATOMIC_ACQUIRE)) {
+#ifdef USE_TCP_EPOLL
+        struct epoll_event events[SERIAL_PORT_COUNT + 1];
+        const int count = epoll_wait(tcpEpollFd, events, ARRAYLEN(events), -1);
+        if (count < 0 && errno != EINTR) {
+            fprintf(stderr, "[SOCKET] epoll_wait: %s\n", strerror(errno));
+            return NULL;
+        }
+
+        for (int i = 0; i < count; i++) {
+            const uint32_t token = events[i].data.u32;
+            const bool readable = events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR);
+            const bool writable = events[i].events & EPOLLOUT;
+
+            if (token == SERIAL_PORT_COUNT) {
+                tcpHandleWakeup();
+            } else {
+                tcpHandleEvent(&tcpPorts[token], readable, writable);
+            }
+        }
+#else
+        struct pollfd fds[SERIAL_PORT_COUNT + 1];
+        int tokens[SERIAL_PORT_COUNT + 1];
+        nfds_t count = 0;
+
+        fds[count] = (struct pollfd){ .fd = tcpWakeFds[0], .events = POLLIN };
+        tokens[count++] = SERIAL_PORT_COUNT;
+
+        for (int i = 0; i < SERIAL_PORT_COUNT; i++) {
+            int fd;
+            bool writable;
+            tcpGetInterest(&tcpPorts[i], &fd, &writable);
+            if (fd >= 0) {
+                fds[count] = (struct pollfd){ .fd = fd, .events = POLLIN | (writable ? POLLOUT : 0) };
+                tokens[count++] = i;
+            }
+        }
+
+        if (poll(fds, count, -1) < 0 && errno != EINTR) {
+            fprintf(stderr, "[SOCKET] poll: %s\n", strerror(errno));
+            return NULL;
+        }
+
+        for (nfds_t i = 0; i < count; i++) {
+            const bool readable = fds[i].revents & (POLLIN | POLLHUP | POLLERR);
+            const bool writable = fds[i].revents & POLLOUT;
+
+            if (!readable && !writable) {
+                continue;
+            }
+            if (tokens[i] == SERIAL_PORT_COUNT) {
+                tcpHandleWakeup();
+            } else {
+                tcpHandleEvent(&tcpPorts[tokens[i]], readable, writable);
+            }
+        }
+#endif
+    }
+
     return NULL;
 }
+
+static bool tcpStartIoThread(void)
+{
+    if (tcpIoThreadStarted) {
+        return true;
+    }
+
+    if (pipe(tcpWakeFds) < 0) {
+        fprintf(stderr, "[SOCKET] Unable to create wakeup pipe\n");
+        return false;
+    }
+    fcntl(tcpWakeFds[0], F_SETFL, fcntl(tcpWakeFds[0], F_GETFL, 0) | O_NONBLOCK);
+    fcntl(tcpWakeFds[1], F_SETFL, fcntl(tcpWakeFds[1], F_GETFL, 0) | O_NONBLOCK);
+
+#ifdef USE_TCP_EPOLL
+    tcpEpollFd = epoll_create1(0);
+    if (tcpEpollFd < 0) {
+        fprintf(stderr, "[SOCKET] Unable to create epoll instance\n");
+        return false;
+    }
+    tcpWatch(EPOLL_CTL_ADD, tcpWakeFds[0], SERIAL_PORT_COUNT, false);
+#endif
+
+    if (pthread_create(&tcpIoThread, NULL, tcpIoThreadLoop, NULL) != 0) {
+        fprintf(stderr, "[SOCKET] Unable to create I/O thread\n");
+        return false;
+    }
+
+    tcpIoThreadStarted = true;
+    return true;
+}
+
 static tcpPort_t *tcpReConfigure(tcpPort_t *port, uint32_t id)
 {
     socklen_t sockaddrlen;
@@ -120,11 +483,10 @@ static tcpPort_t *tcpReConfigure(tcpPort_t *port, uint32_t id)
         return port;
     }
 
-    if (pthread_mutex_init(&port->receiveMutex, NULL) != 0){
+    if (!tcpStartIoThread()) {
         return NULL;
     }
-
-    uint16_t tcpPort = BASE_IP_ADDRESS + id - 1;
+    uint16_t tcpPort = BASE_IP_ADDRESS + tcpPortOffset + id - 1;
     if (lookup_address(NULL, tcpPort, SOCK_STREAM, (struct sockaddr*)&port->sockAddress, &sockaddrlen) != 0) {
 	    return NULL;
     }
@@ -172,65 +534,14 @@ static tcpPort_t *tcpReConfigure(tcpPort_t *port, uint32_t id)
     fprintf(stderr, "[SOCKET] Bind TCP %s port %d to UART%d\n",
 	    tcpGetAddressString((struct sockaddr*)&port->sockAddress), tcpPort, id);
 
-    return port;
-}
-
-int tcpReceive(tcpPort_t *port)
-{
-
-    if (!port->isClientConnected) {
+    // Hand the listening socket to the I/O thread
+    port->serialPort.txBuffer = port->txBuffer;
+    port->serialPort.txBufferSize = TCP_TX_BUFFER_SIZE;
+    port->serialPort.txBufferHead = port->serialPort.txBufferTail = 0;
+    tcpUpdateInterest(port, -1, false);
+    tcpWakeIoThread();
 
-        fd_set fds;
-
-        FD_ZERO(&fds);
-        FD_SET(port->socketFd, &fds);
-
-        if (select(port->socketFd + 1, &fds, NULL, NULL, NULL) < 0) {
-            fprintf(stderr, "[SOCKET] Unable to wait for connection.\n");
-            return -1;
-        }
-
-	    socklen_t addrLen = sizeof(struct sockaddr_storage);
-        port->clientSocketFd = accept(port->socketFd,(struct sockaddr*)&port->clientAddress, &addrLen);
-        if (port->clientSocketFd < 1) {
-            fprintf(stderr, "[SOCKET] Can't accept connection.\n");
-            return -1;
-        }
-
-       fprintf(stderr, "[SOCKET] %s connected to UART%d\n", tcpGetAddressString((struct sockaddr *)&port->clientAddress), port->id);
-        port->isClientConnected = true;
-    }
-
-    uint8_t buffer[TCP_BUFFER_SIZE];
-    ssize_t recvSize = recv(port->clientSocketFd, buffer, TCP_BUFFER_SIZE, 0);
-
-    // recv() under cygwin does not recognise the closed connection under certain circumstances, but returns ECONNRESET as an error.
-    if (port->isClientConnected && (recvSize == 0 || ( recvSize == -1 && errno == ECONNRESET))) {
-       fprintf(stderr, "[SOCKET] %s disconnected from UART%d\n", tcpGetAddressString((struct sockaddr *)&port->clientAddress), port->id);
-       close(port->clientSocketFd);
-       memset(&port->clientAddress, 0, sizeof(port->clientAddress));
-       port->isClientConnected = false;
-
-       return 0;
-    }
-
-    for (ssize_t i = 0; i < recvSize; i++) {
-
-        if (port->serialPort.rxCallback) {
-            port->serialPort.rxCallback((uint16_t)buffer[i], port->serialPort.rxCallbackData);
-        } else {
-            pthread_mutex_lock(&port->receiveMutex);
-            port->serialPort.rxBuffer[port->serialPort.rxBufferHead] = buffer[i];
-            port->serialPort.rxBufferHead = (port->serialPort.rxBufferHead + 1) % port->serialPort.rxBufferSize;
-            pthread_mutex_unlock(&port->receiveMutex);
-        }
-    }
-
-    if (recvSize < 0) {
-        recvSize = 0;
-    }
-
-    return (int)recvSize;
+    return port;
 }
 
 serialPort_t *tcpOpen(USART_TypeDef *USARTx, serialReceiveCallbackPtr callback, void *rxCallbackData, uint32_t baudRate, portMode_t mode, portOptions_t options)
@@ -259,37 +570,66 @@ serialPort_t *tcpOpen(USART_TypeDef *USARTx, serialReceiveCallbackPtr callback,
     port->serialPort.baudRate = baudRate;
     port->serialPort.options = options;
 
-    int err = pthread_create(&port->receiveThread, NULL, tcpReceiveThread, (void*)port);
-    if (err < 0){
-        fprintf(stderr, "[SOCKET] Unable to create receive thread for UART%d\n", id);
-        return NULL;
-    }
     return (serialPort_t*)port;
 }
 
 uint8_t tcpRead(serialPort_t *instance)
 {
-    uint8_t ch;
     tcpPort_t *port = (tcpPort_t*)instance;
-    pthread_mutex_lock(&port->receiveMutex);
+    const uint32_t tail = port->serialPort.rxBufferTail;
 
-    ch = port->serialPort.rxBuffer[port->serialPort.rxBufferTail];
-    port->serialPort.rxBufferTail = (port->serialPort.rxBufferTail + 1) % port->serialPort.rxBufferSize;
-
-    pthread_mutex_unlock(&port->receiveMutex);
+    const uint8_t ch = port->serialPort.rxBuffer[tail];
+    __atomic_store_n(&port->serialPort.rxBufferTail, (tail + 1) % port->serialPort.rxBufferSize, __ATOMIC_RELEASE);
 
     return ch;
 }
 
+static uint32_t tcpRxPeek(serialPort_t *instance, const uint8_t **data)
+{
+    tcpPort_t *port = (tcpPort_t*)instance;
+    const uint32_t head = __atomic_load_n(&port->serialPort.rxBufferHead, __ATOMIC_ACQUIRE);
+    const uint32_t tail = port->serialPort.rxBufferTail;
+
+    *data = (const uint8_t *)&port->serialPort.rxBuffer[tail];
+
+    return head >= tail ? head - tail : port->serialPort.rxBufferSize - tail;
+}
+
+static void tcpRxConsume(serialPort_t *instance, uint32_t count)
+{
+    tcpPort_t *port = (tcpPort_t*)instance;
+
+    __atomic_store_n(&port->serialPort.rxBufferTail, (port->serialPort.rxBufferTail + count) % port->serialPort.rxBufferSize, __ATOMIC_RELEASE);
+}
+
 void tcpWritBuf(serialPort_t *instance, const void *data, int count)
 {
     tcpPort_t *port = (tcpPort_t*)instance;
+    const uint8_t *src = data;
+    const uint32_t size = port->serialPort.txBufferSize;
 
-    if (!port->isClientConnected) {
-        return;
-    }
+    while (count > 0 && tcpClientConnected(port)) {
+        const uint32_t txFree = tcpTxFree(port);
+
+        if (txFree == 0) {
+            // Same as a blocking send() would do, wait for the client to take some
+            tcpWakeIoThread();
+            usleep(TCP_TX_WAIT_US);
+            continue;
+        }
+
+        uint32_t head = port->serialPort.txBufferHead;
+        const uint32_t chunk = MIN((uint32_t)count, txFree);
+        for (uint32_t i = 0; i < chunk; i++) {
+            port->serialPort.txBuffer[head] = src[i];
+            head = (head + 1) % size;
+        }
+        __atomic_store_n(&port->serialPort.txBufferHead, head, __ATOMIC_RELEASE);
 
-    send(port->clientSocketFd, data, count, 0);
+        src += chunk;
+        count -= chunk;
+        port->txPending = true;
+    }
 }
 
 void tcpWrite(serialPort_t *instance, uint8_t ch)
@@ -297,30 +637,32 @@ void tcpWrite(serialPort_t *instance, uint8_t ch)
     tcpWritBuf(instance, (void*)&ch, 1);
 }
 
-uint32_t tcpTotalRxBytesWaiting(const serialPort_t *instance)
+void tcpFlushAll(void)
 {
-    tcpPort_t *port = (tcpPort_t*)instance;
-    uint32_t count;
-
-    pthread_mutex_lock(&port->receiveMutex);
+    bool wake = false;
 
-    if (port->serialPort.rxBufferHead >= port->serialPort.rxBufferTail) {
-        count = port->serialPort.rxBufferHead - port->serialPort.rxBufferTail;
-    } else {
-        count = port->serialPort.rxBufferSize + port->serialPort.rxBufferHead - port->serialPort.rxBufferTail;
+    for (int i = 0; i < SERIAL_PORT_COUNT; i++) {
+        wake |= tcpPorts[i].txPending;
+        tcpPorts[i].txPending = false;
     }
 
-    pthread_mutex_unlock(&port->receiveMutex);
+    // One wakeup sends everything written by this pass of the main loop
+    if (wake) {
+        tcpWakeIoThread();
+    }
+}
 
-    return count;
+uint32_t tcpTotalRxBytesWaiting(const serialPort_t *instance)
+{
+    return tcpRxCount((const tcpPort_t*)instance);
 }
 
 uint32_t tcpTotalTxBytesFree(const serialPort_t *instance)
 {
-    tcpPort_t *port = (tcpPort_t*)instance;
+    const tcpPort_t *port = (const tcpPort_t*)instance;
 
-    if (port->isClientConnected) {
-        return TCP_MAX_PACKET_SIZE;
+    if (tcpClientConnected(port)) {
+        return tcpTxFree(port);
     } else {
         return 0;
     }
@@ -328,14 +670,73 @@ uint32_t tcpTotalTxBytesFree(const serialPort_t *instance)
 
 bool isTcpTransmitBufferEmpty(const serialPort_t *instance)
 {
-    UNUSED(instance);
+    tcpPort_t *port = (tcpPort_t*)instance;
 
-    return true;
+    if (!tcpClientConnected(port) || __atomic_load_n(&port->serialPort.txBufferTail, __ATOMIC_ACQUIRE) == port->serialPort.txBufferHead) {
+        return true;
+    }
+
+    // Callers wait for this to become true, send now instead of at the end of the pass
+    if (port->txPending) {
+        port->txPending = false;
+        tcpWakeIoThread();
+    }
+
+    return false;
 }
 
 bool tcpIsConnected(const serialPort_t *instance)
 {
-    return ((tcpPort_t*)instance)->isClientConnected;
+    return tcpClientConnected((const tcpPort_t*)instance);
+}
+
+void tcpDrainAll(timeMs_t timeoutMs)
+{
+    tcpFlushAll();
+
+    for (timeMs_t waitedMs = 0; waitedMs < timeoutMs; waitedMs++) {
+        bool empty = true;
+        for (int i = 0; i < SERIAL_PORT_COUNT; i++) {
+            empty &= !tcpPorts[i].isInitalized || isTcpTransmitBufferEmpty(&tcpPorts[i].serialPort);
+        }
+        if (empty) {
+            return;
+        }
+        usleep(1000);
+    }
+}
+
+void tcpSetPortOffset(uint16_t offset)
+{
+    tcpPortOffset = offset;
+}
+
+void tcpCloseAll(void)
+{
+    if (tcpIoThreadStarted) {
+        __atomic_store_n(&tcpIoThreadStop, true, __ATOMIC_RELEASE);
+        tcpWakeIoThread();
+        pthread_join(tcpIoThread, NULL);
+        tcpIoThreadStarted = false;
+
+        close(tcpWakeFds[0]);
+        close(tcpWakeFds[1]);
+#ifdef USE_TCP_EPOLL
+        close(tcpEpollFd);
+#endif
+    }
+
+    for (int i = 0; i < SERIAL_PORT_COUNT; i++) {
+        tcpPort_t *port = &tcpPorts[i];
+        if (port->isInitalized) {
+            if (port->isClientConnected) {
+                close(port->clientSocketFd);
+                port->isClientConnected = false;
+            }
+            close(port->socketFd);
+            port->isInitalized = false;
+        }
+    }
 }
 
 void tcpSetBaudRate(serialPort_t *instance, uint32_t baudRate)
@@ -357,6 +758,8 @@ static const struct serialPortVTable tcpVTable[] = {
         .serialTotalRxWaiting = tcpTotalRxBytesWaiting,
         .serialTotalTxFree = tcpTotalTxBytesFree,
         .serialRead = tcpRead,
+        .serialRxPeek = tcpRxPeek,
+        .serialRxConsume = tcpRxConsume,
         .serialSetBaudRate = tcpSetBaudRate,
         .isSerialTransmitBufferEmpty = isTcpTransmitBufferEmpty,
         .setMode = tcpSetMode,
@@ -26,29 +26,43 @@
 #include <netinet/in.h>
 #include <netdb.h>
 
+#include "drivers/time.h"
+
 #define BASE_IP_ADDRESS 5760
 #define TCP_BUFFER_SIZE 2048
+#define TCP_TX_BUFFER_SIZE 65536
 #define TCP_MAX_PACKET_SIZE 65535
 
+/*
+ * All UART sockets are served by one I/O thread. Received bytes go to rxBuffer (or the rx callback, called from the
+ * I/O thread), written ones to txBuffer. Each buffer has one producer and one consumer thread and needs no lock.
+ * Writes are sent in one go by tcpFlushAll(), at the end of every pass of the main loop.
+ */
 typedef struct
 {
     serialPort_t serialPort;
 
     uint8_t rxBuffer[TCP_BUFFER_SIZE];
+    uint8_t txBuffer[TCP_TX_BUFFER_SIZE];
 
     uint8_t id;
     bool isInitalized;
-    pthread_mutex_t receiveMutex;
-    pthread_t receiveThread;
     int socketFd;
     int clientSocketFd;
     struct sockaddr_storage sockAddress;
     struct sockaddr_storage clientAddress;
-    bool isClientConnected;
+    bool isClientConnected;     // Written by the I/O thread only
+    bool txPending;             // Main loop only, data written since the last flush
+    bool txBlocked;             // I/O thread only, socket buffer full, waiting to be writable
 } tcpPort_t;
 
 
 serialPort_t *tcpOpen(USART_TypeDef *USARTx, serialReceiveCallbackPtr callback, void *rxCallbackData, uint32_t baudRate, portMode_t mode, portOptions_t options);
 
-void tcpSend(tcpPort_t *port);
-int tcpReceive(tcpPort_t *port);
+void tcpFlushAll(void);
+// Sends what is left in the tx buffers, before a reset
+void tcpDrainAll(timeMs_t timeoutMs);
+// Moves all ports up from BASE_IP_ADDRESS, before they are opened
+void tcpSetPortOffset(uint16_t offset);
+// Stops the I/O thread and closes all sockets
+void tcpCloseAll(void);
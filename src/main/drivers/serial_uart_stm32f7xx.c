@@ -261,6 +261,9 @@ void uartIrqHandler(uartPort_t *s)
         if (s->port.rxCallback) {
             s->port.rxCallback(rbyte, s->port.rxCallbackData);
         } else {
+            if (s->port.rxBufferHead == s->port.rxBufferTail) {
+                s->port.rxBufferFirstByteUs = microsISR();
+            }
             s->port.rxBuffer[s->port.rxBufferHead] = rbyte;
             s->port.rxBufferHead = (s->port.rxBufferHead + 1) % s->port.rxBufferSize;
         }
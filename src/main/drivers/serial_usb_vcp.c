@@ -92,6 +92,20 @@ static uint8_t usbVcpRead(serialPort_t *instance)
     }
 }
 
+static uint32_t usbVcpRxPeek(serialPort_t *instance, const uint8_t **data)
+{
+    UNUSED(instance);
+
+    return CDC_Receive_Peek(data);
+}
+
+static void usbVcpRxConsume(serialPort_t *instance, uint32_t count)
+{
+    UNUSED(instance);
+
+    CDC_Receive_Consume(count);
+}
+
 static bool usbVcpIsConnected(const serialPort_t *instance)
 {
     (void)instance;
@@ -181,6 +195,8 @@ static const struct serialPortVTable usbVTable[] = {
         .serialTotalRxWaiting = usbVcpAvailable,
         .serialTotalTxFree = usbTxBytesFree,
         .serialRead = usbVcpRead,
+        .serialRxPeek = usbVcpRxPeek,
+        .serialRxConsume = usbVcpRxConsume,
         .serialSetBaudRate = usbVcpSetBaudRate,
         .isSerialTransmitBufferEmpty = isUsbVcpTransmitBufferEmpty,
         .setMode = usbVcpSetMode,
@@ -417,6 +417,27 @@ static uint8_t usbVcpRead(serialPort_t *instance)
    return APP_Rx_Buffer[APP_Rx_ptr_out++];
 }
 
+static uint32_t usbVcpRxPeek(serialPort_t *instance, const uint8_t **data)
+{
+    UNUSED(instance);
+
+    // Same as usbVcpRead(), fill the cache when it is empty
+    if ((APP_Rx_ptr_in == 0) || (APP_Rx_ptr_out == APP_Rx_ptr_in)) {
+        APP_Rx_ptr_out = 0;
+        APP_Rx_ptr_in = usb_vcp_get_rxdata(&otg_core_struct.dev, APP_Rx_Buffer);
+    }
+
+    *data = &APP_Rx_Buffer[APP_Rx_ptr_out];
+    return APP_Rx_ptr_in - APP_Rx_ptr_out;
+}
+
+static void usbVcpRxConsume(serialPort_t *instance, uint32_t count)
+{
+    UNUSED(instance);
+
+    APP_Rx_ptr_out += count;
+}
+
 // Write buffer data to vpc 
 static void usbVcpWriteBuf(serialPort_t *instance, const void *data, int count)
 {
@@ -501,6 +522,8 @@ static const struct serialPortVTable usbVTable[] = {
         .serialTotalRxWaiting = usbVcpAvailable,
         .serialTotalTxFree = usbTxBytesFree,
         .serialRead = usbVcpRead,
+        .serialRxPeek = usbVcpRxPeek,
+        .serialRxConsume = usbVcpRxConsume,
         .serialSetBaudRate = usbVcpSetBaudRate,
         .isSerialTransmitBufferEmpty = isUsbVcpTransmitBufferEmpty,
         .setMode = usbVcpSetMode,
@@ -287,3 +287,15 @@ bool timerPWMDMAInProgress(TCH_t * tch)
 {
     return tch->dmaState != TCH_DMA_IDLE;
 }
+
+#ifdef USE_DSHOT_BIDIR
+bool timerPWMConfigChannelDMACapture(TCH_t * tch, void * captureBuffer, uint32_t captureElementCount)
+{
+    return impl_timerPWMConfigChannelDMACapture(tch, captureBuffer, captureElementCount);
+}
+
+uint32_t timerPWMStopDMACapture(TCH_t * tch)
+{
+    return impl_timerPWMStopDMACapture(tch);
+}
+#endif
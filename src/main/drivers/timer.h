@@ -149,6 +149,12 @@ typedef struct TCH_s {
     DMA_t                           dma;            // Timer channel DMA handle
     volatile tchDmaState_e          dmaState;
     void *                          dmaBuffer;
+#ifdef USE_DSHOT_BIDIR
+    void *                          dmaCaptureBuffer;       // Edges on the pin after an output burst are captured here
+    uint32_t                        dmaCaptureElementCount;
+    volatile bool                   dmaCaptureActive;
+    uint16_t                        dmaOutputPeriod;        // Timer period to restore when going back to output
+#endif
 } TCH_t;
 
 // Run-time timer context (dynamically allocated), includes 4x TCH
@@ -228,4 +234,12 @@ void timerPWMStartDMA(TCH_t * tch);
 void timerPWMStopDMA(TCH_t * tch);
 bool timerPWMDMAInProgress(TCH_t * tch);
 
+#ifdef USE_DSHOT_BIDIR
+// Inverts the output and captures the timer counter on every edge into captureBuffer once each DMA output burst
+// is done. Elements are of the same size as the output buffer ones.
+bool timerPWMConfigChannelDMACapture(TCH_t * tch, void * captureBuffer, uint32_t captureElementCount);
+// Switches the channel back to output, returns the number of edges captured since the last output burst
+uint32_t timerPWMStopDMACapture(TCH_t * tch);
+#endif
+
 volatile timCCR_t *timerCCR(TCH_t * tch);
@@ -84,3 +84,7 @@ bool impl_timerPWMConfigChannelDMA(TCH_t * tch, void * dmaBuffer, uint8_t dmaBuf
 void impl_timerPWMPrepareDMA(TCH_t * tch, uint32_t dmaBufferElementCount);
 void impl_timerPWMStartDMA(TCH_t * tch);
 void impl_timerPWMStopDMA(TCH_t * tch);
+#ifdef USE_DSHOT_BIDIR
+bool impl_timerPWMConfigChannelDMACapture(TCH_t * tch, void * captureBuffer, uint32_t captureElementCount);
+uint32_t impl_timerPWMStopDMACapture(TCH_t * tch);
+#endif
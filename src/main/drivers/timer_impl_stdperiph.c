@@ -202,7 +202,14 @@ void impl_timerCaptureCompareHandler(TIM_TypeDef *tim, timHardwareContext_t *tim
 
 void impl_timerPWMConfigChannel(TCH_t * tch, uint16_t value)
 {
-    const bool inverted = tch->timHw->output & TIMER_OUTPUT_INVERTED;
+    bool inverted = tch->timHw->output & TIMER_OUTPUT_INVERTED;
+
+#ifdef USE_DSHOT_BIDIR
+    // Bidirectional DShot idles high
+    if (tch->dmaCaptureBuffer) {
+        inverted = !inverted;
+    }
+#endif
 
     TIM_OCInitTypeDef  TIM_OCInitStructure;
 
@@ -266,6 +273,42 @@ void impl_timerChCaptureCompareEnable(TCH_t * tch, bool enable)
     TIM_CCxCmd(tch->timHw->tim, lookupTIMChannelTable[tch->timHw->channelIndex], (enable ? TIM_CCx_Enable : TIM_CCx_Disable));
 }
 
+#ifdef USE_DSHOT_BIDIR
+static void impl_timerDMAStartCapture(TCH_t * tch)
+{
+    TIM_TypeDef * timer = tch->timHw->tim;
+    DMA_Stream_TypeDef * stream = tch->dma->ref;
+    TIM_ICInitTypeDef TIM_ICInitStructure;
+
+    tch->dmaCaptureActive = true;
+
+    // Free running counter while listening. All channels of the timer finish their bursts together, only the
+    // first one to get here restarts the counter.
+    if (timer->ARR != 0xFFFF) {
+        TIM_SetAutoreload(timer, 0xFFFF);
+        TIM_GenerateEvent(timer, TIM_EventSource_Update);
+    }
+
+    TIM_ICStructInit(&TIM_ICInitStructure);
+    TIM_ICInitStructure.TIM_Channel = lookupTIMChannelTable[tch->timHw->channelIndex];
+    TIM_ICInitStructure.TIM_ICPolarity = TIM_ICPolarity_BothEdge;
+    TIM_ICInitStructure.TIM_ICSelection = TIM_ICSelection_DirectTI;
+    TIM_ICInitStructure.TIM_ICPrescaler = TIM_ICPSC_DIV1;
+    TIM_ICInitStructure.TIM_ICFilter = 0;
+    TIM_ICInit(timer, &TIM_ICInitStructure);
+
+    // Stream has to be fully disabled before it can be reprogrammed
+    while (DMA_GetCmdStatus(stream) != DISABLE) {
+    }
+
+    stream->CR &= ~DMA_SxCR_DIR;    // Peripheral to memory
+    DMA_MemoryTargetConfig(stream, (uint32_t)tch->dmaCaptureBuffer, DMA_Memory_0);
+    DMA_SetCurrDataCounter(stream, tch->dmaCaptureElementCount);
+    DMA_Cmd(stream, ENABLE);
+    TIM_DMACmd(timer, lookupDMASourceTable[tch->timHw->channelIndex], ENABLE);
+}
+#endif
+
 static void impl_timerDMA_IRQHandler(DMA_t descriptor)
 {
     if (DMA_GET_FLAG_STATUS(descriptor, DMA_IT_TCIF)) {
@@ -276,6 +319,13 @@ static void impl_timerDMA_IRQHandler(DMA_t descriptor)
         TIM_DMACmd(tch->timHw->tim, lookupDMASourceTable[tch->timHw->channelIndex], DISABLE);
 
         DMA_CLEAR_FLAG(descriptor, DMA_IT_TCIF);
+
+#ifdef USE_DSHOT_BIDIR
+        // Output burst is out, listen for the answer on the same pin. A full capture buffer ends up here as well.
+        if (tch->dmaCaptureBuffer && !tch->dmaCaptureActive) {
+            impl_timerDMAStartCapture(tch);
+        }
+#endif
     }
 }
 
@@ -354,6 +404,8 @@ bool impl_timerPWMConfigChannelDMA(TCH_t * tch, void * dmaBuffer, uint8_t dmaBuf
     DMA_Init(tch->dma->ref, &DMA_InitStructure);
     DMA_ITConfig(tch->dma->ref, DMA_IT_TC, ENABLE);
 
+    tch->dmaBuffer = dmaBuffer;
+
     return true;
 }
 
@@ -410,3 +462,58 @@ void impl_timerPWMStopDMA(TCH_t * tch)
     TIM_DMACmd(tch->timHw->tim, lookupDMASourceTable[tch->timHw->channelIndex], DISABLE);
     TIM_Cmd(tch->timHw->tim, ENABLE);
 }
+
+#ifdef USE_DSHOT_BIDIR
+bool impl_timerPWMConfigChannelDMACapture(TCH_t * tch, void * captureBuffer, uint32_t captureElementCount)
+{
+    // Complementary outputs can't capture, output DMA has to be set up already
+    if ((tch->timHw->output & TIMER_OUTPUT_N_CHANNEL) || tch->dma == NULL || tch->dmaBuffer == NULL) {
+        return false;
+    }
+
+    tch->dmaCaptureBuffer = captureBuffer;
+    tch->dmaCaptureElementCount = captureElementCount;
+    tch->dmaCaptureActive = false;
+    tch->dmaOutputPeriod = tch->timHw->tim->ARR;
+
+    // Apply the inverted polarity
+    impl_timerPWMConfigChannel(tch, 0);
+
+    return true;
+}
+
+uint32_t impl_timerPWMStopDMACapture(TCH_t * tch)
+{
+    TIM_TypeDef * timer = tch->timHw->tim;
+    DMA_Stream_TypeDef * stream = tch->dma->ref;
+
+    ATOMIC_BLOCK(NVIC_PRIO_MAX) {
+        DMA_Cmd(stream, DISABLE);
+        TIM_DMACmd(timer, lookupDMASourceTable[tch->timHw->channelIndex], DISABLE);
+        DMA_CLEAR_FLAG(tch->dma, DMA_IT_TCIF);
+    }
+
+    if (!tch->dmaCaptureActive) {
+        return 0;
+    }
+
+    while (DMA_GetCmdStatus(stream) != DISABLE) {
+    }
+
+    const uint32_t captured = tch->dmaCaptureElementCount - DMA_GetCurrDataCounter(stream);
+    tch->dmaCaptureActive = false;
+
+    // Back to output compare, TIM_OCxInit() disables the channel while switching
+    impl_timerPWMConfigChannel(tch, 0);
+
+    if (timer->ARR != tch->dmaOutputPeriod) {
+        TIM_SetAutoreload(timer, tch->dmaOutputPeriod);
+        TIM_GenerateEvent(timer, TIM_EventSource_Update);
+    }
+
+    stream->CR |= DMA_DIR_MemoryToPeripheral;
+    DMA_MemoryTargetConfig(stream, (uint32_t)tch->dmaBuffer, DMA_Memory_0);
+
+    return captured;
+}
+#endif
@@ -53,6 +53,7 @@ bool cliMode = false;
 #include "drivers/accgyro/accgyro.h"
 #include "drivers/pwm_mapping.h"
 #include "drivers/buf_writer.h"
+#include "drivers/dshot_bidir.h"
 #include "drivers/bus_i2c.h"
 #include "drivers/compass/compass.h"
 #include "drivers/flash.h"
@@ -99,6 +100,7 @@ bool cliMode = false;
 #include "navigation/navigation_private.h"
 
 #include "rx/rx.h"
+#include "rx/rx_latency.h"
 #include "rx/spektrum.h"
 #include "rx/srxl2.h"
 
@@ -731,6 +733,7 @@ static void cliAux(char *cmdline)
             if (validArgumentCount != 4) {
                 memset(mac, 0, sizeof(modeActivationCondition_t));
             }
+            updateUsedModeActivationConditionFlags();
         } else {
             cliShowArgumentRangeError("index", 0, MAX_MODE_ACTIVATION_CONDITION_COUNT - 1);
         }
@@ -1031,6 +1034,7 @@ static void cliAdjustmentRange(char *cmdline)
                 memset(ar, 0, sizeof(adjustmentRange_t));
                 cliShowParseError();
             }
+            updateUsedAdjustmentRanges();
         } else {
             cliShowArgumentRangeError("index", 0, MAX_ADJUSTMENT_RANGE_COUNT - 1);
         }
@@ -2277,6 +2281,19 @@ static void cliSdInfo(char *cmdline)
         break;
     }
     cliPrintLinefeed();
+
+    const sdcardStats_t *stats = sdcard_getStats();
+
+    if (stats) {
+        cliPrintLinef("Blocks: %u read, %u written, %u queued while busy, %u busy rejects",
+            stats->blocksRead, stats->blocksWritten, stats->queuedWrites, stats->busyRejects);
+        cliPrintLinef("Busy: %u times, avg %uus, max %uus, %u polls",
+            stats->busyPeriods,
+            stats->busyPeriods ? stats->busyTimeUs / stats->busyPeriods : 0,
+            stats->busyMaxUs,
+            stats->busyPolls
+        );
+    }
 }
 
 #endif
@@ -3274,6 +3291,18 @@ static const char * getBatteryStateString(void)
     return batteryStateStrings[getBatteryState()];
 }
 
+static const char *cliRxProtocolName(void)
+{
+    const bool isSerial = rxConfig()->receiverType == RX_TYPE_SERIAL;
+    const setting_t *setting = settingFind(isSerial ? "serialrx_provider" : "receiver_type");
+    const unsigned index = isSerial ? rxConfig()->serialrx_provider : rxConfig()->receiverType;
+
+    if (!setting || index >= settingLookupTable(setting)->valueCount) {
+        return "unknown";
+    }
+    return settingLookupTable(setting)->values[index];
+}
+
 static void cliStatus(char *cmdline)
 {
     UNUSED(cmdline);
@@ -3379,6 +3408,22 @@ static void cliStatus(char *cmdline)
     cliPrintLinef("Stack size: %d, Stack address: 0x%x, Heap available: %d", stackTotalSize(), stackHighMem(), memGetAvailableBytes());
 
     cliPrintLinef("I2C Errors: %d, config size: %d, max available config: %d", i2cErrorCounter, getEEPROMConfigSize(), &__config_end - &__config_start);
+#endif
+    const configSaveStats_t *saveStats = getEEPROMSaveStats();
+    cliPrintLinef("Config saves: %d (%d compactions), last: %d us, %d bytes, %d records%s, max: %d us",
+        saveStats->saveCount, saveStats->compactionCount, saveStats->lastDurationUs, saveStats->lastBytesWritten,
+        saveStats->lastRecordsWritten, saveStats->lastSaveCompacted ? " (compacted)" : "", saveStats->maxDurationUs);
+#ifdef USE_DSHOT_BIDIR
+    if (dshotBidirIsEnabled()) {
+        dshotBidirStats_t dshotStats;
+        dshotBidirGetStats(&dshotStats);
+        const uint32_t errorPermille = dshotStats.frameCount ? (uint64_t)dshotStats.errorCount * 1000 / dshotStats.frameCount : 0;
+        cliPrintLinef("DShot telemetry: %u frames, %u errors (%u.%u%%)", dshotStats.frameCount, dshotStats.errorCount, errorPermille / 10, errorPermille % 10);
+        for (int i = 0; i < getMotorCount(); i++) {
+            dshotBidirGetMotorStats(i, &dshotStats);
+            cliPrintLinef("  motor %d: %u eRPM, %u errors", i + 1, dshotBidirGetMotorErpm(i), dshotStats.errorCount);
+        }
+    }
 #endif
 #if defined(USE_ADC) && !defined(SITL_BUILD)
     static char * adcFunctions[] = { "BATTERY", "RSSI", "CURRENT", "AIRSPEED" };
@@ -3410,6 +3455,16 @@ static void cliStatus(char *cmdline)
     const int rxRate = getTaskDeltaTime(TASK_RX) == 0 ? 0 : (int)(1000000.0f / ((float)getTaskDeltaTime(TASK_RX)));
     const int systemRate = getTaskDeltaTime(TASK_SYSTEM) == 0 ? 0 : (int)(1000000.0f / ((float)getTaskDeltaTime(TASK_SYSTEM)));
     cliPrintLinef(", cycle time: %d, PID rate: %d, RX rate: %d, System rate: %d",  (uint16_t)cycleTime, pidRate, rxRate, systemRate);
+
+    rxLatencyStats_t rxLatencyStats;
+    rxLatencyGetStats(&rxLatencyStats);
+    cliPrintLinef("RX latency (%s): min %u, avg %u, p99 %u, max %u us over %u frames", cliRxProtocolName(),
+        (unsigned)rxLatencyStats.minUs, (unsigned)rxLatencyStats.avgUs, (unsigned)rxLatencyStats.p99Us,
+        (unsigned)rxLatencyStats.maxUs, (unsigned)rxLatencyStats.sampleCount);
+#ifdef USE_GPS
+    cliPrintLinef("GPS latency: last %u, avg %u, max %u us", (unsigned)gpsStats.latencyUs, (unsigned)gpsStats.latencyAvgUs,
+        (unsigned)gpsStats.latencyMaxUs);
+#endif
 #if !defined(CLI_MINIMAL_VERBOSITY)
     cliPrint("Arming disabled flags:");
     uint32_t flags = armingFlags & ARMING_DISABLED_ALL_FLAGS;
@@ -3971,111 +4026,137 @@ static void cliHelp(char *cmdline)
     }
 }
 
-void cliProcess(void)
+// Returns false once the CLI has been left
+static bool cliProcessChar(uint8_t c)
 {
-    if (!cliWriter) {
-        return;
-    }
-
-    // Be a little bit tricky.  Flush the last inputs buffer, if any.
-    bufWriterFlush(cliWriter);
-
-    while (serialRxBytesWaiting(cliPort)) {
-        uint8_t c = serialRead(cliPort);
-        if (c == '\t' || c == '?') {
-            // do tab completion
-            const clicmd_t *cmd, *pstart = NULL, *pend = NULL;
-            uint32_t i = bufferIndex;
-            for (cmd = cmdTable; cmd < cmdTable + ARRAYLEN(cmdTable); cmd++) {
-                if (bufferIndex && (sl_strncasecmp(cliBuffer, cmd->name, bufferIndex) != 0))
-                    continue;
-                if (!pstart)
-                    pstart = cmd;
-                pend = cmd;
-            }
-            if (pstart) {    /* Buffer matches one or more commands */
-                for (; ; bufferIndex++) {
-                    if (pstart->name[bufferIndex] != pend->name[bufferIndex])
-                        break;
-                    if (!pstart->name[bufferIndex] && bufferIndex < sizeof(cliBuffer) - 2) {
-                        /* Unambiguous -- append a space */
-                        cliBuffer[bufferIndex++] = ' ';
-                        cliBuffer[bufferIndex] = '\0';
-                        break;
-                    }
-                    cliBuffer[bufferIndex] = pstart->name[bufferIndex];
+    if (c == '\t' || c == '?') {
+        // do tab completion
+        const clicmd_t *cmd, *pstart = NULL, *pend = NULL;
+        uint32_t i = bufferIndex;
+        for (cmd = cmdTable; cmd < cmdTable + ARRAYLEN(cmdTable); cmd++) {
+            if (bufferIndex && (sl_strncasecmp(cliBuffer, cmd->name, bufferIndex) != 0))
+                continue;
+            if (!pstart)
+                pstart = cmd;
+            pend = cmd;
+        }
+        if (pstart) {    /* Buffer matches one or more commands */
+            for (; ; bufferIndex++) {
+                if (pstart->name[bufferIndex] != pend->name[bufferIndex])
+                    break;
+                if (!pstart->name[bufferIndex] && bufferIndex < sizeof(cliBuffer) - 2) {
+                    /* Unambiguous -- append a space */
+                    cliBuffer[bufferIndex++] = ' ';
+                    cliBuffer[bufferIndex] = '\0';
+                    break;
                 }
+                cliBuffer[bufferIndex] = pstart->name[bufferIndex];
             }
-            if (!bufferIndex || pstart != pend) {
-                /* Print list of ambiguous matches */
-                cliPrint("\r\033[K");
-                for (cmd = pstart; cmd <= pend; cmd++) {
-                    cliPrint(cmd->name);
-                    cliWrite('\t');
-                }
-                cliPrompt();
-                i = 0;    /* Redraw prompt */
+        }
+        if (!bufferIndex || pstart != pend) {
+            /* Print list of ambiguous matches */
+            cliPrint("\r\033[K");
+            for (cmd = pstart; cmd <= pend; cmd++) {
+                cliPrint(cmd->name);
+                cliWrite('\t');
             }
-            for (; i < bufferIndex; i++)
-                cliWrite(cliBuffer[i]);
-        } else if (!bufferIndex && c == 4) {   // CTRL-D
-            cliExit(cliBuffer);
-            return;
-        } else if (c == 12) {                  // NewPage / CTRL-L
-            // clear screen
-            cliPrint("\033[2J\033[1;1H");
             cliPrompt();
-        } else if (bufferIndex && (c == '\n' || c == '\r')) {
-            // enter pressed
-            cliPrintLinefeed();
+            i = 0;    /* Redraw prompt */
+        }
+        for (; i < bufferIndex; i++)
+            cliWrite(cliBuffer[i]);
+    } else if (!bufferIndex && c == 4) {   // CTRL-D
+        cliExit(cliBuffer);
+        return false;
+    } else if (c == 12) {                  // NewPage / CTRL-L
+        // clear screen
+        cliPrint("\033[2J\033[1;1H");
+        cliPrompt();
+    } else if (bufferIndex && (c == '\n' || c == '\r')) {
+        // enter pressed
+        cliPrintLinefeed();
 
-            // Strip comment starting with # from line
-            char *p = cliBuffer;
-            p = strchr(p, '#');
-            if (NULL != p) {
-                bufferIndex = (uint32_t)(p - cliBuffer);
-            }
+        // Strip comment starting with # from line
+        char *p = cliBuffer;
+        p = strchr(p, '#');
+        if (NULL != p) {
+            bufferIndex = (uint32_t)(p - cliBuffer);
+        }
 
-            // Strip trailing whitespace
-            while (bufferIndex > 0 && cliBuffer[bufferIndex - 1] == ' ') {
-                bufferIndex--;
-            }
+        // Strip trailing whitespace
+        while (bufferIndex > 0 && cliBuffer[bufferIndex - 1] == ' ') {
+            bufferIndex--;
+        }
 
-            // Process non-empty lines
-            if (bufferIndex > 0) {
-                cliBuffer[bufferIndex] = 0; // null terminate
+        // Process non-empty lines
+        if (bufferIndex > 0) {
+            cliBuffer[bufferIndex] = 0; // null terminate
 
-                const clicmd_t *cmd;
-                for (cmd = cmdTable; cmd < cmdTable + ARRAYLEN(cmdTable); cmd++) {
-                    if (!sl_strncasecmp(cliBuffer, cmd->name, strlen(cmd->name))   // command names match
-                       && !sl_isalnum((unsigned)cliBuffer[strlen(cmd->name)]))    // next characted in bufffer is not alphanumeric (command is correctly terminated)
-                        break;
-                }
-                if (cmd < cmdTable + ARRAYLEN(cmdTable))
-                    cmd->func(cliBuffer + strlen(cmd->name) + 1);
-                else
-                    cliPrintError("Unknown command, try 'help'");
-                bufferIndex = 0;
+            const clicmd_t *cmd;
+            for (cmd = cmdTable; cmd < cmdTable + ARRAYLEN(cmdTable); cmd++) {
+                if (!sl_strncasecmp(cliBuffer, cmd->name, strlen(cmd->name))   // command names match
+                   && !sl_isalnum((unsigned)cliBuffer[strlen(cmd->name)]))    // next characted in bufffer is not alphanumeric (command is correctly terminated)
+                    break;
             }
+            if (cmd < cmdTable + ARRAYLEN(cmdTable))
+                cmd->func(cliBuffer + strlen(cmd->name) + 1);
+            else
+                cliPrintError("Unknown command, try 'help'");
+            bufferIndex = 0;
+        }
 
-            ZERO_FARRAY(cliBuffer);
+        ZERO_FARRAY(cliBuffer);
 
-            // 'exit' will reset this flag, so we don't need to print prompt again
-            if (!cliMode)
-                return;
+        // 'exit' will reset this flag, so we don't need to print prompt again
+        if (!cliMode)
+            return false;
 
-            cliPrompt();
-        } else if (c == 127) {
-            // backspace
-            if (bufferIndex) {
-                cliBuffer[--bufferIndex] = 0;
-                cliPrint("\010 \010");
+        cliPrompt();
+    } else if (c == 127) {
+        // backspace
+        if (bufferIndex) {
+            cliBuffer[--bufferIndex] = 0;
+            cliPrint("\010 \010");
+        }
+    } else if (bufferIndex < sizeof(cliBuffer) && c >= 32 && c <= 126) {
+        if (!bufferIndex && c == ' ')
+            return true; // Ignore leading spaces
+        cliBuffer[bufferIndex++] = c;
+        cliWrite(c);
+    }
+
+    return true;
+}
+
+void cliProcess(void)
+{
+    if (!cliWriter) {
+        return;
+    }
+
+    // Be a little bit tricky.  Flush the last inputs buffer, if any.
+    bufWriterFlush(cliWriter);
+
+    const uint8_t *data;
+    uint32_t count;
+    while ((count = serialRxPeek(cliPort, &data)) > 0) {
+        uint32_t processed = 0;
+        bool controlChar = false;
+
+        // Control characters may run a command, which can use the port itself. Everything up to them is consumed first.
+        while (processed < count && !controlChar) {
+            const uint8_t c = data[processed++];
+            controlChar = c < 32;
+            if (!controlChar) {
+                cliProcessChar(c);
             }
-        } else if (bufferIndex < sizeof(cliBuffer) && c >= 32 && c <= 126) {
-            if (!bufferIndex && c == ' ')
-                continue; // Ignore leading spaces
-            cliBuffer[bufferIndex++] = c;
-            cliWrite(c);
+        }
+
+        const uint8_t lastChar = data[processed - 1];
+        serialRxConsume(cliPort, processed);
+
+        if (controlChar && !cliProcessChar(lastChar)) {
+            return;
         }
     }
 }
@@ -132,7 +132,7 @@ PG_RESET_TEMPLATE(beeperConfig_t, beeperConfig,
                   .pwmMode = SETTING_BEEPER_PWM_MODE_DEFAULT,
 );
 
-PG_REGISTER_WITH_RESET_TEMPLATE(adcChannelConfig_t, adcChannelConfig, PG_ADC_CHANNEL_CONFIG, 0);
+PG_REGISTER_WITH_RESET_TEMPLATE(adcChannelConfig_t, adcChannelConfig, PG_ADC_CHANNEL_CONFIG, 1);
 
 PG_RESET_TEMPLATE(adcChannelConfig_t, adcChannelConfig,
     .adcFunctionChannel = {
@@ -140,7 +140,8 @@ PG_RESET_TEMPLATE(adcChannelConfig_t, adcChannelConfig,
         [ADC_RSSI]      = RSSI_ADC_CHANNEL,
         [ADC_CURRENT]   = CURRENT_METER_ADC_CHANNEL,
         [ADC_AIRSPEED]  = AIRSPEED_ADC_CHANNEL,
-    }
+    },
+    .outputRateHz = SETTING_ADC_OUTPUT_RATE_HZ_DEFAULT,
 );
 
 #define SAVESTATE_NONE 0
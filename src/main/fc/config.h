@@ -98,6 +98,7 @@ PG_DECLARE(beeperConfig_t, beeperConfig);
 
 typedef struct adcChannelConfig_s {
     uint8_t adcFunctionChannel[ADC_FUNCTION_COUNT];
+    uint16_t outputRateHz;
 } adcChannelConfig_t;
 
 PG_DECLARE(adcChannelConfig_t, adcChannelConfig);
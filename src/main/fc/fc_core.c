@@ -24,6 +24,7 @@
 #include "blackbox/blackbox.h"
 
 #include "build/debug.h"
+#include "build/trace.h"
 
 #include "common/maths.h"
 #include "common/axis.h"
@@ -86,6 +87,7 @@
 #include "flight/pid.h"
 #include "flight/imu.h"
 #include "flight/rate_dynamics.h"
+#include "flight/rpm_filter.h"
 
 #include "flight/failsafe.h"
 #include "flight/power_limits.h"
@@ -821,6 +823,8 @@ void FAST_CODE taskGyro(timeUs_t currentTimeUs) {
     // To make busy-waiting timeout work we need to account for time spent within busy-waiting loop
     const timeDelta_t currentDeltaTime = getTaskDeltaTime(TASK_SELF);
 
+    TRACE_BEGIN(TRACE_EVENT_GYRO, 0);
+
     /* Update actual hardware readings */
     gyroUpdate();
 
@@ -829,6 +833,8 @@ void FAST_CODE taskGyro(timeUs_t currentTimeUs) {
         opflowGyroUpdateCallback(currentDeltaTime);
     }
 #endif
+
+    TRACE_END(TRACE_EVENT_GYRO, 0);
 }
 
 static float calculateThrottleTiltCompensationFactor(uint8_t throttleTiltCompensationStrength)
@@ -843,7 +849,8 @@ static float calculateThrottleTiltCompensationFactor(uint8_t throttleTiltCompens
 
 void taskMainPidLoop(timeUs_t currentTimeUs)
 {
-  
+    TRACE_BEGIN(TRACE_EVENT_PID_LOOP, 0);
+
     cycleTime = getTaskDeltaTime(TASK_SELF);
     dT = (float)cycleTime * 0.000001f;//周期 △T，用于PID计算
     // armingFlags = (1 << 2);
@@ -863,6 +870,10 @@ void taskMainPidLoop(timeUs_t currentTimeUs)
     if (lockMainPID()) {
 #endif
 
+#ifdef USE_RPM_FILTER
+    rpmFilterLoopUpdate();
+#endif
+
     gyroFilter();
 
     imuUpdateAccelerometer();
@@ -885,8 +896,7 @@ void taskMainPidLoop(timeUs_t currentTimeUs)
     }
     isRXDataNew = false;
 
-    updatePositionEstimator();
-    applyWaypointNavigationAndAltitudeHold();
+    applyNavigationControllerOutput();
 
     // Apply throttle tilt compensation
     if (!STATE(FIXED_WING_LEGACY)) {
@@ -958,6 +968,8 @@ void taskMainPidLoop(timeUs_t currentTimeUs)
         blackboxUpdate(micros());
     }
 #endif
+
+    TRACE_END(TRACE_EVENT_PID_LOOP, 0);
 }
 
 // This function is called in a busy-loop, everything called from here should do it's own
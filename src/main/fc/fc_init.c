@@ -443,6 +443,7 @@ void init(void)
 #ifdef USE_ADC
     drv_adc_config_t adc_params;
     memset(&adc_params, 0, sizeof(adc_params));
+    adc_params.outputRateHz = adcChannelConfig()->outputRateHz;
 
     // Allocate and initialize ADC channels if features are configured - can't rely on sensor detection here, it's done later
     if (feature(FEATURE_VBAT)) {
@@ -693,9 +694,10 @@ void init(void)
 
 #ifdef USE_RPM_FILTER
     disableRpmFilters();
-    if (STATE(ESC_SENSOR_ENABLED) && (rpmFilterConfig()->gyro_filter_enabled || rpmFilterConfig()->dterm_filter_enabled)) {
+    if (rpmFilterConfig()->gyro_filter_enabled || rpmFilterConfig()->dterm_filter_enabled) {
         rpmFiltersInit();
-        setTaskEnabled(TASK_RPM_FILTER, true);
+        // Bidirectional DShot telemetry is picked up by the PID loop itself
+        setTaskEnabled(TASK_RPM_FILTER, rpmFilterGetSource() == RPM_FILTER_SOURCE_ESC_SENSOR);
     }
 #endif
 
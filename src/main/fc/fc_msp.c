@@ -27,6 +27,7 @@
 #include "blackbox/blackbox.h"
 
 #include "build/debug.h"
+#include "build/trace.h"
 #include "build/version.h"
 
 #include "common/axis.h"
@@ -73,6 +74,7 @@
 #include "fc/settings.h"
 
 #include "flight/failsafe.h"
+#include "flight/gyro_spectrum.h"
 #include "flight/imu.h"
 #include "flight/mixer.h"
 #include "flight/pid.h"
@@ -104,6 +106,7 @@
 
 #include "rx/rx.h"
 #include "rx/msp.h"
+#include "rx/rx_latency.h"
 
 #include "scheduler/scheduler.h"
 
@@ -923,6 +926,9 @@ static bool mspFcProcessOutCommand(uint16_t cmdMSP, sbuf_t *dst, mspPostProcessF
         sbufWriteU16(dst, gpsSol.hdop);
         sbufWriteU16(dst, gpsSol.eph);
         sbufWriteU16(dst, gpsSol.epv);
+        sbufWriteU32(dst, gpsStats.latencyUs);
+        sbufWriteU32(dst, gpsStats.latencyAvgUs);
+        sbufWriteU32(dst, gpsStats.latencyMaxUs);
         break;
 #endif
     case MSP_DEBUG:
@@ -1570,6 +1576,21 @@ static bool mspFcProcessOutCommand(uint16_t cmdMSP, sbuf_t *dst, mspPostProcessF
         break;
 #endif
 
+    case MSP2_INAV_RX_LATENCY:
+        {
+            rxLatencyStats_t stats;
+            rxLatencyGetStats(&stats);
+
+            sbufWriteU8(dst, rxConfig()->receiverType);
+            sbufWriteU8(dst, rxConfig()->serialrx_provider);
+            sbufWriteU32(dst, stats.sampleCount);
+            sbufWriteU16(dst, MIN(stats.minUs, (uint32_t)UINT16_MAX));
+            sbufWriteU16(dst, MIN(stats.avgUs, (uint32_t)UINT16_MAX));
+            sbufWriteU16(dst, MIN(stats.p99Us, (uint32_t)UINT16_MAX));
+            sbufWriteU16(dst, MIN(stats.maxUs, (uint32_t)UINT16_MAX));
+        }
+        break;
+
     default:
         return false;
     }
@@ -1654,6 +1675,76 @@ static void mspFcDataFlashReadCommand(sbuf_t *dst, sbuf_t *src)
 }
 #endif
 
+#ifdef USE_DYNAMIC_FILTERS
+static void mspFcGyroSpectrumCommand(sbuf_t *dst, sbuf_t *src)
+{
+    // Request payload:
+    //  uint8_t     - throttle bin (optional, 0 if omitted)
+    uint8_t throttleBin = 0;
+    if (sbufBytesRemaining(src) >= 1) {
+        throttleBin = sbufReadU8(src);
+    }
+
+    // Reply:
+    //  uint16_t    - FFT sampling rate in Hz, bins are sampling rate / 2 / bin count wide
+    //  uint8_t     - bin count
+    //  uint8_t     - throttle bin count
+    //  uint8_t     - throttle bin sent
+    //  followed by roll, pitch and yaw, each uint32_t FFT count and an uint16_t amplitude per bin in 0.01 deg/s
+    const uint8_t throttleBins = gyroSpectrumGetThrottleBins();
+    throttleBin = MIN(throttleBin, throttleBins - 1);
+
+    sbufWriteU16(dst, gyroSpectrumGetSampleRateHz());
+    sbufWriteU8(dst, GYRO_SPECTRUM_BIN_COUNT);
+    sbufWriteU8(dst, throttleBins);
+    sbufWriteU8(dst, throttleBin);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const gyroSpectrum_t *spectrum = gyroSpectrumGet(axis, throttleBin);
+        sbufWriteU32(dst, spectrum->count);
+        for (int bin = 0; bin < GYRO_SPECTRUM_BIN_COUNT; bin++) {
+            sbufWriteU16(dst, constrainf(spectrum->amplitude[bin] * 100.0f, 0, UINT16_MAX));
+        }
+    }
+}
+#endif
+
+#ifdef USE_TRACE
+static void mspFcTraceCommand(sbuf_t *dst, sbuf_t *src)
+{
+    // Request payload:
+    //  uint32_t    - sequence number of the first event wanted (optional, oldest available event if omitted)
+    const uint32_t tail = traceGetTail();
+    uint32_t sequence = tail;
+    if (sbufBytesRemaining(src) >= 4) {
+        sequence = MAX(sbufReadU32(src), tail);
+    }
+
+    // Reply:
+    //  uint32_t    - sequence number of the next event to be recorded
+    //  uint16_t    - size of the trace buffer in events
+    //  uint32_t    - sequence number of the first event sent
+    //  followed by as many events as fit, each uint32_t timeUs, uint8_t id, uint8_t phase, uint16_t arg
+    const uint32_t head = traceGetHead();
+    sbufWriteU32(dst, head);
+    sbufWriteU16(dst, TRACE_BUFFER_SIZE);
+
+    // Skip over any events which get overwritten before we can copy them out
+    traceEvent_t event;
+    while (sequence < head && !traceGetEvent(sequence, &event)) {
+        sequence++;
+    }
+    sbufWriteU32(dst, sequence);
+
+    for (; sequence < head && sbufBytesRemaining(dst) >= 8 && traceGetEvent(sequence, &event); sequence++) {
+        sbufWriteU32(dst, event.timeUs);
+        sbufWriteU8(dst, event.id);
+        sbufWriteU8(dst, event.phase);
+        sbufWriteU16(dst, event.arg);
+    }
+}
+#endif
+
 static mspResult_e mspFcProcessInCommand(uint16_t cmdMSP, sbuf_t *src)
 {
     uint8_t tmp_u8;
@@ -1755,6 +1846,8 @@ static mspResult_e mspFcProcessInCommand(uint16_t cmdMSP, sbuf_t *src)
                 adjRange->range.endStep = sbufReadU8(src);
                 adjRange->adjustmentFunction = sbufReadU8(src);
                 adjRange->auxSwitchChannelIndex = sbufReadU8(src);
+
+                updateUsedAdjustmentRanges();
             } else {
                 return MSP_RESULT_ERROR;
             }
@@ -2787,6 +2880,16 @@ static mspResult_e mspFcProcessInCommand(uint16_t cmdMSP, sbuf_t *src)
         break;
 #endif
 
+#ifdef USE_DYNAMIC_FILTERS
+    case MSP2_INAV_SET_GYRO_SPECTRUM:
+        // Clears the spectrum and sets the number of throttle bins to split it into
+        if (dataSize == 1) {
+            gyroSpectrumReset(sbufReadU8(src));
+        } else
+            return MSP_RESULT_ERROR;
+        break;
+#endif
+
 #ifdef NAV_NON_VOLATILE_WAYPOINT_STORAGE
     case MSP_WP_MISSION_LOAD:
         sbufReadU8Safe(NULL, src);    // Mission ID (reserved)
@@ -3474,6 +3577,20 @@ bool mspFCProcessInOutCommand(uint16_t cmdMSP, sbuf_t *dst, sbuf_t *src, mspResu
         break;
 #endif
 
+#ifdef USE_DYNAMIC_FILTERS
+    case MSP2_INAV_GYRO_SPECTRUM:
+        mspFcGyroSpectrumCommand(dst, src);
+        *ret = MSP_RESULT_ACK;
+        break;
+#endif
+
+#ifdef USE_TRACE
+    case MSP2_INAV_TRACE:
+        mspFcTraceCommand(dst, src);
+        *ret = MSP_RESULT_ACK;
+        break;
+#endif
+
 #ifdef USE_SIMULATOR
     case MSP_SIMULATOR:
 		tmp_u8 = sbufReadU8(src); // Get the Simulator MSP version
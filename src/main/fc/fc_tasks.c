@@ -314,6 +314,14 @@ void taskUpdateOsd(timeUs_t currentTimeUs)
 }
 #endif
 
+void taskUpdateNavigation(timeUs_t currentTimeUs)
+{
+    UNUSED(currentTimeUs);
+
+    updatePositionEstimator();
+    updateNavigationControllers();
+}
+
 void taskUpdateAux(timeUs_t currentTimeUs)
 {
     updatePIDCoefficients();
@@ -426,6 +434,8 @@ void fcTasksInit(void) //将有效的任务添加到队列中，如果没有空
     setTaskEnabled(TASK_BATTERY, feature(FEATURE_VBAT) || isAmperageConfigured());
     setTaskEnabled(TASK_TEMPERATURE, true);
     setTaskEnabled(TASK_RX, true);
+    rescheduleTask(TASK_NAVIGATION, TASK_PERIOD_HZ(navConfig()->general.loop_hz));
+    setTaskEnabled(TASK_NAVIGATION, true);
 #ifdef USE_GPS
     setTaskEnabled(TASK_GPS, feature(FEATURE_GPS));
 #endif
@@ -557,6 +567,13 @@ cfTask_t cfTasks[TASK_COUNT] = {
         .staticPriority = TASK_PRIORITY_HIGH,
     },
 
+    [TASK_NAVIGATION] = {
+        .taskName = "NAVIGATION",
+        .taskFunc = taskUpdateNavigation,
+        .desiredPeriod = TASK_PERIOD_HZ(100),
+        .staticPriority = TASK_PRIORITY_HIGH,
+    },
+
 #ifdef USE_GPS
     [TASK_GPS] = {
         .taskName = "GPS",
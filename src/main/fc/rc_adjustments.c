@@ -309,6 +309,14 @@ static const adjustmentConfig_t defaultAdjustmentConfigs[ADJUSTMENT_FUNCTION_COU
 
 static adjustmentState_t adjustmentStates[MAX_SIMULTANEOUS_ADJUSTMENT_COUNT];
 
+STATIC_ASSERT(MAX_ADJUSTMENT_RANGE_COUNT <= AUX_RANGE_TABLE_MAX_RANGES, too_many_adjustment_ranges);
+
+static uint8_t adjustmentRangeBoundaryStep[AUX_RANGE_TABLE_BOUNDARY_COUNT(MAX_ADJUSTMENT_RANGE_COUNT)];
+static auxRangeMask_t adjustmentRangeBoundaryMask[AUX_RANGE_TABLE_BOUNDARY_COUNT(MAX_ADJUSTMENT_RANGE_COUNT)];
+static auxRangeTable_t adjustmentRangeTable;     // Bit i is adjustmentRanges(i)
+static bool adjustmentStatesNeedUpdate = true;
+static bool adjustmentRxDataUsable = false;
+
 static void configureAdjustment(uint8_t index, uint8_t auxSwitchChannelIndex, const adjustmentConfig_t *adjustmentConfig)
 {
     adjustmentState_t * const adjustmentState = &adjustmentStates[index];
@@ -704,10 +712,46 @@ void processRcAdjustments(controlRateConfig_t *controlRateConfig, bool canUseRxD
 void resetAdjustmentStates(void)
 {
     memset(adjustmentStates, 0, sizeof(adjustmentStates));
+    updateUsedAdjustmentRanges();
+}
+
+void updateUsedAdjustmentRanges(void)
+{
+    auxRange_t ranges[MAX_ADJUSTMENT_RANGE_COUNT];
+
+    for (int index = 0; index < MAX_ADJUSTMENT_RANGE_COUNT; index++) {
+        const adjustmentRange_t * const adjustmentRange = adjustmentRanges(index);
+
+        ranges[index].auxChannelIndex = adjustmentRange->auxChannelIndex;
+        ranges[index].range = adjustmentRange->range;
+        if (adjustmentRange->adjustmentFunction == ADJUSTMENT_NONE) {
+            // Range not set up, never active
+            ranges[index].range.startStep = ranges[index].range.endStep = 0;
+        }
+    }
+
+    if (!adjustmentRangeTable.boundaryStep) {
+        auxRangeTableInit(&adjustmentRangeTable, adjustmentRangeBoundaryStep, adjustmentRangeBoundaryMask, ARRAYLEN(adjustmentRangeBoundaryStep));
+    }
+    auxRangeTableCompile(&adjustmentRangeTable, ranges, MAX_ADJUSTMENT_RANGE_COUNT);
+    adjustmentStatesNeedUpdate = true;
 }
 
 void updateAdjustmentStates(bool canUseRxData)
 {
+    /*
+     * Slots change only when a range becomes active or inactive. A slot freed by one range can be taken by another
+     * range that is already active, that takes one more pass.
+     */
+    if (!auxRangeTableUpdate(&adjustmentRangeTable) && !adjustmentStatesNeedUpdate && canUseRxData == adjustmentRxDataUsable) {
+        return;
+    }
+
+    adjustmentStatesNeedUpdate = false;
+    adjustmentRxDataUsable = canUseRxData;
+
+    const auxRangeMask_t activeRanges = canUseRxData ? auxRangeTableGetActive(&adjustmentRangeTable) : 0;
+
     for (int index = 0; index < MAX_ADJUSTMENT_RANGE_COUNT; index++) {
         const adjustmentRange_t * const adjustmentRange = adjustmentRanges(index);
         if (adjustmentRange->adjustmentFunction == ADJUSTMENT_NONE) {
@@ -717,13 +761,14 @@ void updateAdjustmentStates(bool canUseRxData)
         const adjustmentConfig_t *adjustmentConfig = &defaultAdjustmentConfigs[adjustmentRange->adjustmentFunction - ADJUSTMENT_FUNCTION_CONFIG_INDEX_OFFSET];
         adjustmentState_t * const adjustmentState = &adjustmentStates[adjustmentRange->adjustmentIndex];
 
-        if (canUseRxData && isRangeActive(adjustmentRange->auxChannelIndex, &adjustmentRange->range)) {
+        if (activeRanges & ((auxRangeMask_t)1 << index)) {
             if (!adjustmentState->config) {
                 configureAdjustment(adjustmentRange->adjustmentIndex, adjustmentRange->auxSwitchChannelIndex, adjustmentConfig);
             }
         } else {
             if (adjustmentState->config == adjustmentConfig) {
                 adjustmentState->config = NULL;
+                adjustmentStatesNeedUpdate = true;
             }
         }
     }
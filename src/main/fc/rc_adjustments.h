@@ -143,6 +143,7 @@ typedef struct adjustmentState_s {
 PG_DECLARE_ARRAY(adjustmentRange_t, MAX_ADJUSTMENT_RANGE_COUNT, adjustmentRanges);
 
 void resetAdjustmentStates(void);
+void updateUsedAdjustmentRanges(void);
 void updateAdjustmentStates(bool canUseRxData);
 struct controlRateConfig_s;
 void processRcAdjustments(struct controlRateConfig_s *controlRateConfig, bool canUseRxData);
@@ -38,9 +38,22 @@
 
 #include "rx/rx.h"
 
+STATIC_ASSERT(MAX_MODE_ACTIVATION_CONDITION_COUNT <= AUX_RANGE_TABLE_MAX_RANGES, too_many_mode_activation_conditions);
+
 static uint8_t specifiedConditionCountPerMode[CHECKBOX_ITEM_COUNT];
 static bool isUsingNAVModes = false;
 
+static uint8_t modeRangeBoundaryStep[AUX_RANGE_TABLE_BOUNDARY_COUNT(MAX_MODE_ACTIVATION_CONDITION_COUNT)];
+static auxRangeMask_t modeRangeBoundaryMask[AUX_RANGE_TABLE_BOUNDARY_COUNT(MAX_MODE_ACTIVATION_CONDITION_COUNT)];
+static auxRangeTable_t modeRangeTable;
+
+// Modes with conditions and the conditions of each, bit i is modeActivationConditions(i)
+static uint8_t usedModeCount;
+static uint8_t usedModeId[MAX_MODE_ACTIVATION_CONDITION_COUNT];
+static auxRangeMask_t usedModeConditionMask[MAX_MODE_ACTIVATION_CONDITION_COUNT];
+static bool modesNeedUpdate = true;
+static modeActivationOperator_e lastModeActivationOperator;
+
 boxBitmask_t rcModeActivationMask; // one bit per mode defined in boxId_e
 
 // TODO(alberto): It looks like we can now safely remove this assert, since everything
@@ -151,43 +164,137 @@ bool isRangeActive(uint8_t auxChannelIndex, const channelRange_t *range)
             channelValue < CHANNEL_RANGE_MIN + (range->endStep * CHANNEL_RANGE_STEP_WIDTH));
 }
 
-void updateActivatedModes(void)
+static int16_t channelValueToStep(int16_t channelValue)
 {
-    // Disable all modes to begin with
-    boxBitmask_t newMask;
-    memset(&newMask, 0, sizeof(newMask));
+    return channelValue < CHANNEL_RANGE_MIN ? -1 : (channelValue - CHANNEL_RANGE_MIN) / CHANNEL_RANGE_STEP_WIDTH;
+}
 
-    // Unfortunately for AND logic it's not enough to simply check if any of the specified channel range conditions are valid for a mode.
-    // We need to count the total number of conditions specified for each mode, and check that all those conditions are currently valid.
-    uint8_t activeConditionCountPerMode[CHECKBOX_ITEM_COUNT];
-    memset(activeConditionCountPerMode, 0, CHECKBOX_ITEM_COUNT);
+void auxRangeTableInit(auxRangeTable_t *table, uint8_t *boundaryStep, auxRangeMask_t *boundaryMask, uint8_t boundaryCapacity)
+{
+    memset(table, 0, sizeof(*table));
+    table->boundaryStep = boundaryStep;
+    table->boundaryMask = boundaryMask;
+    table->boundaryCapacity = boundaryCapacity;
+}
 
-    for (int index = 0; index < MAX_MODE_ACTIVATION_CONDITION_COUNT; index++) {
-        if (isRangeActive(modeActivationConditions(index)->auxChannelIndex, &modeActivationConditions(index)->range)) {
-            // Increment the number of valid conditions for this mode
-            activeConditionCountPerMode[modeActivationConditions(index)->modeId]++;
-        }
-    }
+void auxRangeTableCompile(auxRangeTable_t *table, const auxRange_t *ranges, uint8_t rangeCount)
+{
+    table->activeMask = 0;
+    table->channelCount = 0;
+    table->boundaryCount = 0;
+
+    for (int auxChannelIndex = 0; auxChannelIndex < MAX_AUX_CHANNEL_COUNT; auxChannelIndex++) {
+        uint8_t * const steps = &table->boundaryStep[table->boundaryCount];
+        uint8_t boundaryCount = 0;
+
+        // Start and end steps of the ranges of this channel, sorted and without duplicates
+        for (int index = 0; index < rangeCount; index++) {
+            if (ranges[index].auxChannelIndex != auxChannelIndex || !IS_RANGE_USABLE(&ranges[index].range)) {
+                continue;
+            }
 
-    // Now see which modes should be enabled
-    for (int modeIndex = 0; modeIndex < CHECKBOX_ITEM_COUNT; modeIndex++) {
-        // only modes with conditions specified are considered
-        if (specifiedConditionCountPerMode[modeIndex] > 0) {
-            // For AND logic, the specified condition count and valid condition count must be the same.
-            // For OR logic, the valid condition count must be greater than zero.
-
-            if (modeActivationOperatorConfig()->modeActivationOperator == MODE_OPERATOR_AND) {
-                // AND the conditions
-                if (activeConditionCountPerMode[modeIndex] == specifiedConditionCountPerMode[modeIndex]) {
-                    bitArraySet(newMask.bits, modeIndex);
+            const uint8_t rangeSteps[2] = { ranges[index].range.startStep, ranges[index].range.endStep };
+            for (int i = 0; i < 2; i++) {
+                int position = 0;
+                while (position < boundaryCount && steps[position] < rangeSteps[i]) {
+                    position++;
+                }
+                if (position < boundaryCount && steps[position] == rangeSteps[i]) {
+                    continue;
                 }
+                if (table->boundaryCount + boundaryCount >= table->boundaryCapacity) {
+                    continue;
+                }
+                memmove(&steps[position + 1], &steps[position], boundaryCount - position);
+                steps[position] = rangeSteps[i];
+                boundaryCount++;
             }
-            else {
-                // OR the conditions
-                if (activeConditionCountPerMode[modeIndex] > 0) {
-                    bitArraySet(newMask.bits, modeIndex);
+        }
+
+        if (boundaryCount == 0) {
+            continue;
+        }
+
+        for (int boundary = 0; boundary < boundaryCount; boundary++) {
+            auxRangeMask_t mask = 0;
+            for (int index = 0; index < rangeCount; index++) {
+                const channelRange_t *range = &ranges[index].range;
+                if (ranges[index].auxChannelIndex == auxChannelIndex && range->startStep <= steps[boundary] && steps[boundary] < range->endStep) {
+                    mask |= (auxRangeMask_t)1 << index;
                 }
             }
+            table->boundaryMask[table->boundaryCount + boundary] = mask;
+        }
+
+        auxRangeChannel_t *channel = &table->channels[table->channelCount++];
+        channel->auxChannelIndex = auxChannelIndex;
+        channel->firstBoundary = table->boundaryCount;
+        channel->boundaryCount = boundaryCount;
+        channel->activeMask = 0;
+        // Empty interval, the first update looks the channel up
+        channel->lowStep = 0;
+        channel->highStep = 0;
+
+        table->boundaryCount += boundaryCount;
+    }
+}
+
+bool auxRangeTableUpdate(auxRangeTable_t *table)
+{
+    bool changed = false;
+
+    for (int index = 0; index < table->channelCount; index++) {
+        auxRangeChannel_t *channel = &table->channels[index];
+        const int16_t step = channelValueToStep(rxGetChannelValue(channel->auxChannelIndex + NON_AUX_CHANNEL_COUNT));
+
+        if (step >= channel->lowStep && step < channel->highStep) {
+            continue;
+        }
+
+        const uint8_t *steps = &table->boundaryStep[channel->firstBoundary];
+        int boundary = 0;
+        while (boundary < channel->boundaryCount && steps[boundary] <= step) {
+            boundary++;
+        }
+
+        // The channel value is between boundaries boundary - 1 and boundary
+        channel->lowStep = boundary > 0 ? steps[boundary - 1] : INT16_MIN;
+        channel->highStep = boundary < channel->boundaryCount ? steps[boundary] : INT16_MAX;
+
+        const auxRangeMask_t mask = boundary > 0 ? table->boundaryMask[channel->firstBoundary + boundary - 1] : 0;
+        if (mask != channel->activeMask) {
+            table->activeMask = (table->activeMask & ~channel->activeMask) | mask;
+            channel->activeMask = mask;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+void updateActivatedModes(void)
+{
+    const modeActivationOperator_e modeActivationOperator = modeActivationOperatorConfig()->modeActivationOperator;
+
+    // Only the channels that moved out of their interval are looked at, modes change only if a condition did
+    if (!auxRangeTableUpdate(&modeRangeTable) && !modesNeedUpdate && modeActivationOperator == lastModeActivationOperator) {
+        return;
+    }
+
+    modesNeedUpdate = false;
+    lastModeActivationOperator = modeActivationOperator;
+
+    boxBitmask_t newMask;
+    memset(&newMask, 0, sizeof(newMask));
+
+    const auxRangeMask_t activeConditions = auxRangeTableGetActive(&modeRangeTable);
+
+    for (int index = 0; index < usedModeCount; index++) {
+        const auxRangeMask_t conditions = usedModeConditionMask[index];
+        // For AND logic all conditions of the mode must be valid, for OR logic any of them
+        const bool isActive = modeActivationOperator == MODE_OPERATOR_AND ? (activeConditions & conditions) == conditions : (activeConditions & conditions) != 0;
+        if (isActive) {
+            bitArraySet(newMask.bits, usedModeId[index]);
         }
     }
 
@@ -196,12 +303,42 @@ void updateActivatedModes(void)
 
 void updateUsedModeActivationConditionFlags(void)
 {
+    auxRange_t ranges[MAX_MODE_ACTIVATION_CONDITION_COUNT];
+
     memset(specifiedConditionCountPerMode, 0, CHECKBOX_ITEM_COUNT);
+    usedModeCount = 0;
+
     for (int index = 0; index < MAX_MODE_ACTIVATION_CONDITION_COUNT; index++) {
-        if (IS_RANGE_USABLE(&modeActivationConditions(index)->range)) {
-            specifiedConditionCountPerMode[modeActivationConditions(index)->modeId]++;
+        const modeActivationCondition_t *condition = modeActivationConditions(index);
+        const bool isUsable = IS_RANGE_USABLE(&condition->range) && condition->modeId < CHECKBOX_ITEM_COUNT;
+
+        ranges[index].auxChannelIndex = condition->auxChannelIndex;
+        ranges[index].range = condition->range;
+        if (!isUsable) {
+            // Never active
+            ranges[index].range.startStep = ranges[index].range.endStep = 0;
+            continue;
+        }
+
+        specifiedConditionCountPerMode[condition->modeId]++;
+
+        int modeIndex = 0;
+        while (modeIndex < usedModeCount && usedModeId[modeIndex] != condition->modeId) {
+            modeIndex++;
         }
+        if (modeIndex == usedModeCount) {
+            usedModeId[usedModeCount] = condition->modeId;
+            usedModeConditionMask[usedModeCount] = 0;
+            usedModeCount++;
+        }
+        usedModeConditionMask[modeIndex] |= (auxRangeMask_t)1 << index;
+    }
+
+    if (!modeRangeTable.boundaryStep) {
+        auxRangeTableInit(&modeRangeTable, modeRangeBoundaryStep, modeRangeBoundaryMask, ARRAYLEN(modeRangeBoundaryStep));
     }
+    auxRangeTableCompile(&modeRangeTable, ranges, MAX_MODE_ACTIVATION_CONDITION_COUNT);
+    modesNeedUpdate = true;
 
     isUsingNAVModes = isModeActivationConditionPresent(BOXNAVPOSHOLD) ||
                         isModeActivationConditionPresent(BOXNAVRTH) ||
@@ -18,11 +18,14 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "common/bitarray.h"
 
 #include "config/parameter_group.h"
 
+#include "rx/rx.h"
+
 #define BOXID_NONE 255
 
 typedef enum {
@@ -122,6 +125,53 @@ typedef struct modeActivationOperatorConfig_s {
     modeActivationOperator_e modeActivationOperator;
 } modeActivationOperatorConfig_t;
 
+/*
+ * Ranges on the aux channels, compiled into a sorted table of step boundaries per channel. A channel is looked up
+ * again only once its value leaves the interval between two boundaries it was in, the active ranges are kept as a
+ * bitmask with one bit per range.
+ */
+#define AUX_RANGE_TABLE_MAX_RANGES  64
+
+typedef uint64_t auxRangeMask_t;
+
+typedef struct auxRange_s {
+    uint8_t auxChannelIndex;
+    channelRange_t range;
+} auxRange_t;
+
+typedef struct auxRangeChannel_s {
+    auxRangeMask_t activeMask;      // Ranges of this channel the channel value is in
+    int16_t lowStep;                // Interval of steps the channel value is in, the channel is looked up again outside of it
+    int16_t highStep;
+    uint8_t auxChannelIndex;
+    uint8_t firstBoundary;
+    uint8_t boundaryCount;
+} auxRangeChannel_t;
+
+typedef struct auxRangeTable_s {
+    auxRangeMask_t activeMask;
+    auxRangeChannel_t channels[MAX_AUX_CHANNEL_COUNT];
+    uint8_t channelCount;
+    uint8_t boundaryCount;
+    uint8_t boundaryCapacity;
+    uint8_t *boundaryStep;          // Ascending per channel
+    auxRangeMask_t *boundaryMask;   // Ranges active from a boundary up to the next one of the channel
+} auxRangeTable_t;
+
+// Storage for the boundaries of rangeCount ranges
+#define AUX_RANGE_TABLE_BOUNDARY_COUNT(rangeCount) (2 * (rangeCount))
+
+void auxRangeTableInit(auxRangeTable_t *table, uint8_t *boundaryStep, auxRangeMask_t *boundaryMask, uint8_t boundaryCapacity);
+// Range i of ranges is bit i of the active mask. Unusable ranges are never active.
+void auxRangeTableCompile(auxRangeTable_t *table, const auxRange_t *ranges, uint8_t rangeCount);
+// Looks up the channels whose value left its interval, returns true if the active ranges changed
+bool auxRangeTableUpdate(auxRangeTable_t *table);
+
+static inline auxRangeMask_t auxRangeTableGetActive(const auxRangeTable_t *table)
+{
+    return table->activeMask;
+}
+
 PG_DECLARE_ARRAY(modeActivationCondition_t, MAX_MODE_ACTIVATION_CONDITION_COUNT, modeActivationConditions);
 PG_DECLARE(modeActivationOperatorConfig_t, modeActivationOperatorConfig);
 
@@ -52,6 +52,8 @@
 
 static pt3Filter_t rcSmoothFilter[4];
 static float rcStickUnfiltered[4];
+static float rcStickSlope[4];       // Change per microsecond between the last two RC frames, for extrapolation
+static timeUs_t rcFrameTimeUs;
 static uint16_t rcUpdateFrequency;
 
 uint16_t getRcUpdateFrequency(void) {
@@ -77,8 +79,6 @@ static int32_t applyRcUpdateFrequencyMedianFilter(int32_t newReading)
 
 void rcInterpolationApply(bool isRXDataNew, timeUs_t currentTimeUs)
 {
-    // Compute the RC update frequency
-    static timeUs_t previousRcData;
     static int filterFrequency;
     static bool initDone = false;
 
@@ -97,50 +97,72 @@ void rcInterpolationApply(bool isRXDataNew, timeUs_t currentTimeUs)
             initDone = true;
         }
 
+        /*
+         * The RC update rate and the stick movement are taken from the times the receiver frames arrived, not from when the
+         * RX task picked them up. The RX task also runs without a new frame, that doesn't count as an update.
+         */
+        const timeUs_t frameTimeUs = rxGetFrameTimeUs();
+        const timeDelta_t frameIntervalUs = cmpTimeUs(frameTimeUs, rcFrameTimeUs);
+        const bool isNewFrame = rcFrameTimeUs != 0 && frameIntervalUs > 0;
+        const bool extrapolate = isNewFrame && rxConfig()->rcFilterExtrapolation && !FLIGHT_MODE(FAILSAFE_MODE);
+
         for (int stick = 0; stick < 4; stick++) {
+            rcStickSlope[stick] = extrapolate ? (rcCommand[stick] - rcStickUnfiltered[stick]) / frameIntervalUs : 0.0f;
             rcStickUnfiltered[stick] = rcCommand[stick];
         }
-    }
 
-    // Don't filter if not initialized
-    if (!initDone) {
-        return;
-    }
+        if (isNewFrame) {
+            rcUpdateFrequency = applyRcUpdateFrequencyMedianFilter(1.0f / (frameIntervalUs * 0.000001f));
 
-    if (isRXDataNew) {
-        const timeDelta_t delta = cmpTimeUs(currentTimeUs, previousRcData);
-        rcUpdateFrequency = applyRcUpdateFrequencyMedianFilter(1.0f / (delta * 0.000001f));
-        previousRcData = currentTimeUs;
+            /*
+             * If auto smoothing is enabled, update the filters
+             */
+            if (rxConfig()->autoSmooth) {
+                const int nyquist = rcUpdateFrequency / 2;
 
-        /*
-         * If auto smoothing is enabled, update the filters
-         */
-        if (rxConfig()->autoSmooth) {
-            const int nyquist = rcUpdateFrequency / 2;
-
-            int newFilterFrequency = scaleRange(
-                rxConfig()->autoSmoothFactor,
-                1,
-                100,
-                nyquist,
-                rcUpdateFrequency / 10
-            );
-            
-            // Do not allow filter frequency to go below RC_INTERPOLATION_MIN_FREQUENCY or above nuyquist frequency.
-            newFilterFrequency = constrain(newFilterFrequency, RC_INTERPOLATION_MIN_FREQUENCY, nyquist);
-
-            if (newFilterFrequency != filterFrequency) {
-
-                for (int stick = 0; stick < 4; stick++) {
-                    pt3FilterUpdateCutoff(&rcSmoothFilter[stick], pt3FilterGain(newFilterFrequency, dT));
+                int newFilterFrequency = scaleRange(
+                    rxConfig()->autoSmoothFactor,
+                    1,
+                    100,
+                    nyquist,
+                    rcUpdateFrequency / 10
+                );
+
+                // Do not allow filter frequency to go below RC_INTERPOLATION_MIN_FREQUENCY or above nuyquist frequency.
+                newFilterFrequency = constrain(newFilterFrequency, RC_INTERPOLATION_MIN_FREQUENCY, nyquist);
+
+                if (newFilterFrequency != filterFrequency) {
+
+                    for (int stick = 0; stick < 4; stick++) {
+                        pt3FilterUpdateCutoff(&rcSmoothFilter[stick], pt3FilterGain(newFilterFrequency, dT));
+                    }
+                    filterFrequency = newFilterFrequency;
                 }
-                filterFrequency = newFilterFrequency;
             }
         }
 
+        rcFrameTimeUs = frameTimeUs;
     }
 
+    // Don't filter if not initialized
+    if (!initDone) {
+        return;
+    }
+
+    // Extrapolate at most one RC frame period past the last frame, the sticks are held after that
+    const timeDelta_t framePeriodUs = rcUpdateFrequency ? 1000000 / rcUpdateFrequency : 0;
+    const timeDelta_t frameAgeUs = constrain(cmpTimeUs(currentTimeUs, rcFrameTimeUs), 0, framePeriodUs);
+
     for (int stick = 0; stick < 4; stick++) {
-        rcCommand[stick] = pt3FilterApply(&rcSmoothFilter[stick], rcStickUnfiltered[stick]);
+        float stickValue = rcStickUnfiltered[stick] + rcStickSlope[stick] * frameAgeUs;
+
+        // A step into full deflection is not carried on past the end of the rcCommand range
+        if (stick == THROTTLE) {
+            stickValue = constrainf(stickValue, getThrottleIdleValue(), motorConfig()->maxthrottle);
+        } else {
+            stickValue = constrainf(stickValue, -500, 500);
+        }
+
+        rcCommand[stick] = pt3FilterApply(&rcSmoothFilter[stick], stickValue);
     }
 }
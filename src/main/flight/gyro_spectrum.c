@@ -0,0 +1,84 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_DYNAMIC_FILTERS
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "flight/gyro_spectrum.h"
+
+static gyroSpectrum_t gyroSpectrum[GYRO_SPECTRUM_MAX_THROTTLE_BINS][XYZ_AXIS_COUNT];
+static uint8_t gyroSpectrumThrottleBins = 1;
+static uint16_t gyroSpectrumSampleRateHz;
+static float gyroSpectrumAmplitudeScale;
+
+void gyroSpectrumInit(uint16_t sampleRateHz, uint8_t windowSize)
+{
+    gyroSpectrumSampleRateHz = sampleRateHz;
+    // Single sided spectrum, twice the magnitude over the Hann window gain of N / 2
+    gyroSpectrumAmplitudeScale = 4.0f / windowSize;
+    gyroSpectrumReset(gyroSpectrumThrottleBins);
+}
+
+void gyroSpectrumReset(uint8_t throttleBins)
+{
+    memset(gyroSpectrum, 0, sizeof(gyroSpectrum));
+    gyroSpectrumThrottleBins = constrain(throttleBins, 1, GYRO_SPECTRUM_MAX_THROTTLE_BINS);
+}
+
+void gyroSpectrumAccumulate(int axis, const float *magnitude, int throttlePercent)
+{
+    const int throttleBin = constrain(throttlePercent, 0, 99) * gyroSpectrumThrottleBins / 100;
+    gyroSpectrum_t *spectrum = &gyroSpectrum[throttleBin][axis];
+
+    spectrum->count++;
+
+    // Running mean, no sum to lose precision in on long flights
+    const float k = 1.0f / MIN(spectrum->count, (uint32_t)GYRO_SPECTRUM_MAX_AVERAGE);
+
+    for (int bin = 0; bin < GYRO_SPECTRUM_BIN_COUNT; bin++) {
+        spectrum->amplitude[bin] += (magnitude[bin] * gyroSpectrumAmplitudeScale - spectrum->amplitude[bin]) * k;
+    }
+}
+
+uint16_t gyroSpectrumGetSampleRateHz(void)
+{
+    return gyroSpectrumSampleRateHz;
+}
+
+uint8_t gyroSpectrumGetThrottleBins(void)
+{
+    return gyroSpectrumThrottleBins;
+}
+
+const gyroSpectrum_t *gyroSpectrumGet(int axis, uint8_t throttleBin)
+{
+    if (axis < 0 || axis >= XYZ_AXIS_COUNT || throttleBin >= gyroSpectrumThrottleBins) {
+        return NULL;
+    }
+
+    return &gyroSpectrum[throttleBin][axis];
+}
+
+#endif
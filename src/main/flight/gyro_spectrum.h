@@ -0,0 +1,47 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common/axis.h"
+
+/*
+ * Averaged gyro spectrum, built from the FFTs the dynamic notch analyser computes anyway. Each axis can be split
+ * into throttle bins so the noise at hover and at full throttle doesn't end up in the same average.
+ */
+
+#define GYRO_SPECTRUM_BIN_COUNT             32      // FFT_WINDOW_SIZE / 2
+#define GYRO_SPECTRUM_MAX_THROTTLE_BINS     4
+// Past this many FFTs the average turns into a moving one, so it keeps following changes
+#define GYRO_SPECTRUM_MAX_AVERAGE           4096
+
+typedef struct gyroSpectrum_s {
+    float amplitude[GYRO_SPECTRUM_BIN_COUNT];   // deg/s, amplitude of a sine in the middle of the bin
+    uint32_t count;                             // FFTs accumulated
+} gyroSpectrum_t;
+
+void gyroSpectrumInit(uint16_t sampleRateHz, uint8_t windowSize);
+void gyroSpectrumReset(uint8_t throttleBins);
+// Magnitudes of the GYRO_SPECTRUM_BIN_COUNT bins of a Hann windowed FFT
+void gyroSpectrumAccumulate(int axis, const float *magnitude, int throttlePercent);
+
+uint16_t gyroSpectrumGetSampleRateHz(void);
+uint8_t gyroSpectrumGetThrottleBins(void);
+const gyroSpectrum_t *gyroSpectrumGet(int axis, uint8_t throttleBin);
@@ -42,6 +42,10 @@
 
 #include "sensors/gyro.h"
 #include "fc/config.h"
+#include "fc/runtime_config.h"
+
+#include "flight/gyro_spectrum.h"
+#include "flight/mixer.h"
 
 #include "gyroanalyse.h"
 
@@ -69,6 +73,8 @@ enum {
  */
 #define FFT_SAMPLING_DENOMINATOR 2
 
+STATIC_ASSERT(FFT_BIN_COUNT == GYRO_SPECTRUM_BIN_COUNT, gyro_spectrum_bin_count_mismatch);
+
 void gyroDataAnalyseStateInit(
     gyroAnalyseState_t *state, 
     uint16_t minFrequency,
@@ -87,6 +93,7 @@ void gyroDataAnalyseStateInit(
     }
 
     arm_rfft_fast_init_f32(&state->fftInstance, FFT_WINDOW_SIZE);
+    gyroSpectrumInit(state->fftSamplingRateHz, FFT_WINDOW_SIZE);
 
     // Frequency filter is executed every 12 cycles. 4 steps per cycle, 3 axises
     const uint32_t filterUpdateUs = targetLooptimeUs * STEP_COUNT * XYZ_AXIS_COUNT;
@@ -179,6 +186,11 @@ static NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state)
             // 8us
             arm_cmplx_mag_f32(state->rfftData, state->fftData, FFT_BIN_COUNT);
 
+            // Spectrum for tuning comes for free, only while flying so the ground doesn't dilute it
+            if (ARMING_FLAG(ARMED)) {
+                gyroSpectrumAccumulate(state->updateAxis, state->fftData, getThrottlePercent(true));
+            }
+
             //Zero the data structure
             for (int i = 0; i < DYN_NOTCH_PEAK_COUNT; i++) {
                 state->peaks[i].bin = 0;
@@ -20,6 +20,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <math.h>
+#include <string.h>
 
 #include "platform.h"
 
@@ -111,7 +112,21 @@ FASTRAM bool gpsHeadingInitialized;
 
 FASTRAM bool imuUpdated = false;
 
-PG_REGISTER_WITH_RESET_TEMPLATE(imuConfig_t, imuConfig, PG_IMU_CONFIG, 2);
+/*
+ * Delta angle accumulator for decimated AHRS updates. Gyro samples are integrated every loop into a rotation vector
+ * together with a coning correction term, so several loops worth of rotation can be applied to the quaternion in one
+ * step without losing the non-commutative part of the motion.
+ */
+typedef struct imuDeltaAngle_s {
+    fpVector3_t alpha;              // Integrated rotation vector [rad]
+    fpVector3_t beta;               // Coning correction [rad]
+    fpVector3_t lastDeltaAlpha;
+    float dt;                       // Time covered by the accumulator [s]
+} imuDeltaAngle_t;
+
+STATIC_FASTRAM imuDeltaAngle_t imuDeltaAngle;
+
+PG_REGISTER_WITH_RESET_TEMPLATE(imuConfig_t, imuConfig, PG_IMU_CONFIG, 3);
 
 PG_RESET_TEMPLATE(imuConfig_t, imuConfig,
     .dcm_kp_acc = SETTING_AHRS_DCM_KP_DEFAULT,                   // 0.20 * 10000
@@ -122,7 +137,8 @@ PG_RESET_TEMPLATE(imuConfig_t, imuConfig,
     .acc_ignore_rate = SETTING_AHRS_ACC_IGNORE_RATE_DEFAULT,
     .acc_ignore_slope = SETTING_AHRS_ACC_IGNORE_SLOPE_DEFAULT,
     .gps_yaw_windcomp = SETTING_AHRS_GPS_YAW_WINDCOMP_DEFAULT,
-    .inertia_comp_method = SETTING_AHRS_INERTIA_COMP_METHOD_DEFAULT
+    .inertia_comp_method = SETTING_AHRS_INERTIA_COMP_METHOD_DEFAULT,
+    .ahrs_update_hz = SETTING_AHRS_UPDATE_HZ_DEFAULT
 );
 
 STATIC_UNIT_TESTED void imuComputeRotationMatrix(void)
@@ -158,6 +174,7 @@ void imuConfigure(void)
     imuRuntimeConfig.dcm_kp_mag = imuConfig()->dcm_kp_mag / 10000.0f;
     imuRuntimeConfig.dcm_ki_mag = imuConfig()->dcm_ki_mag / 10000.0f;
     imuRuntimeConfig.small_angle = imuConfig()->small_angle;
+    imuRuntimeConfig.ahrs_update_interval = imuConfig()->ahrs_update_hz ? 1.0f / imuConfig()->ahrs_update_hz : 0.0f;
 }
 
 void imuInit(void)
@@ -185,6 +202,8 @@ void imuInit(void)
     quaternionInitUnit(&orientation);
     imuComputeRotationMatrix();
 
+    memset(&imuDeltaAngle, 0, sizeof(imuDeltaAngle));
+
     // Initialize rotation rate filter
     pt1FilterReset(&rotRateFilterX, 0);
     pt1FilterReset(&rotRateFilterY, 0);
@@ -660,7 +679,7 @@ static void imuCalculateTurnRateacceleration(fpVector3_t *vEstcentrifugalAccelBF
     lastspeed = currentspeed;
 }
 
-static void imuCalculateEstimatedAttitude(float dT)
+static void imuCalculateEstimatedAttitude(float dT, const fpVector3_t * gyroBF)
 {
 #if defined(USE_MAG)
     const bool canUseMAG = sensors(SENSOR_MAG) && compassIsHealthy();
@@ -760,7 +779,7 @@ static void imuCalculateEstimatedAttitude(float dT)
 
     const float magWeight = imuGetPGainScaleFactor() * 1.0f;
     fpVector3_t measuredMagBF = {.v = {mag.magADC[X], mag.magADC[Y], mag.magADC[Z]}};
-    imuMahonyAHRSupdate(dT, &imuMeasuredRotationBF,
+    imuMahonyAHRSupdate(dT, gyroBF,
                             useAcc ? &compansatedGravityBF : NULL,
                             useMag ? &measuredMagBF : NULL,
                             useCOG, courseOverGround,
@@ -791,6 +810,41 @@ void imuCheckVibrationLevels(void)
     // DEBUG_VIBE values 4-7 are used by NAV estimator
 }
 
+static void imuAccumulateDeltaAngle(const fpVector3_t * gyroBF, float dT)
+{
+    fpVector3_t deltaAlpha;
+    fpVector3_t vTmp;
+
+    // Same rectangular integration the per-loop update uses
+    vectorScale(&deltaAlpha, gyroBF, dT);
+
+    // Coning correction: beta += 1/2 * (alpha + 1/6 * lastDeltaAlpha) x deltaAlpha
+    vectorScale(&vTmp, &imuDeltaAngle.lastDeltaAlpha, 1.0f / 6.0f);
+    vectorAdd(&vTmp, &vTmp, &imuDeltaAngle.alpha);
+    vectorCrossProduct(&vTmp, &vTmp, &deltaAlpha);
+    vectorScale(&vTmp, &vTmp, 0.5f);
+    vectorAdd(&imuDeltaAngle.beta, &imuDeltaAngle.beta, &vTmp);
+
+    vectorAdd(&imuDeltaAngle.alpha, &imuDeltaAngle.alpha, &deltaAlpha);
+    imuDeltaAngle.lastDeltaAlpha = deltaAlpha;
+    imuDeltaAngle.dt += dT;
+}
+
+static float imuConsumeDeltaAngle(fpVector3_t * avgRateBF)
+{
+    const float dT = imuDeltaAngle.dt;
+
+    // The AHRS integrates rate * dT, feed it the rate which yields the coning compensated rotation over the whole interval
+    vectorAdd(avgRateBF, &imuDeltaAngle.alpha, &imuDeltaAngle.beta);
+    vectorScale(avgRateBF, avgRateBF, dT > 0 ? 1.0f / dT : 0.0f);
+
+    imuDeltaAngle.alpha = (fpVector3_t){ .v = { 0.0f, 0.0f, 0.0f } };
+    imuDeltaAngle.beta = (fpVector3_t){ .v = { 0.0f, 0.0f, 0.0f } };
+    imuDeltaAngle.dt = 0.0f;
+
+    return dT;
+}
+
 void imuUpdateAttitude(timeUs_t currentTimeUs)
 {
     /* Calculate dT */
@@ -801,8 +855,27 @@ void imuUpdateAttitude(timeUs_t currentTimeUs)
     if (sensors(SENSOR_ACC) && isAccelUpdatedAtLeastOnce) {
         gyroGetMeasuredRotationRate(&imuMeasuredRotationBF);    // Calculate gyro rate in body frame in rad/s
         accGetMeasuredAcceleration(&imuMeasuredAccelBF);  // Calculate accel in body frame in cm/s/s
-        imuCheckVibrationLevels();
-        imuCalculateEstimatedAttitude(dT);  // Update attitude estimate
+
+        if (imuRuntimeConfig.ahrs_update_interval > 0.0f) {
+            // Decimated mode - only integrate the gyro here, the full update (sensor fusion, quaternion normalization,
+            // rotation matrix and Euler angles) runs once per AHRS interval
+            imuAccumulateDeltaAngle(&imuMeasuredRotationBF, dT);
+
+            // Run the update on the loop closest to the interval rather than the first one past it
+            if (imuDeltaAngle.dt + 0.5f * dT < imuRuntimeConfig.ahrs_update_interval) {
+                return;
+            }
+
+            fpVector3_t avgRotationBF;
+            const float ahrsDT = imuConsumeDeltaAngle(&avgRotationBF);
+
+            imuCheckVibrationLevels();
+            imuCalculateEstimatedAttitude(ahrsDT, &avgRotationBF);
+        }
+        else {
+            imuCheckVibrationLevels();
+            imuCalculateEstimatedAttitude(dT, &imuMeasuredRotationBF);  // Update attitude estimate
+        }
     } else {
         acc.accADCf[X] = 0.0f;
         acc.accADCf[Y] = 0.0f;
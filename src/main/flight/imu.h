@@ -54,6 +54,7 @@ typedef struct imuConfig_s {
     uint8_t acc_ignore_slope;
     uint8_t gps_yaw_windcomp;
     uint8_t inertia_comp_method;
+    uint16_t ahrs_update_hz;                // AHRS update rate, gyro is integrated every loop in between. 0 - update every loop
 } imuConfig_t;
 
 PG_DECLARE(imuConfig_t, imuConfig);
@@ -64,6 +65,7 @@ typedef struct imuRuntimeConfig_s {
     float dcm_kp_mag;
     float dcm_ki_mag;
     uint8_t small_angle;
+    float ahrs_update_interval;             // s, 0 - update every loop
 } imuRuntimeConfig_t;
 
 typedef enum
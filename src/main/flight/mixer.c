@@ -46,12 +46,14 @@
 #include "flight/failsafe.h"
 #include "flight/imu.h"
 #include "flight/mixer.h"
+#include "flight/mixer_kernels.h"
 #include "flight/pid.h"
 #include "flight/servos.h"
 
 #include "navigation/navigation.h"
 
 #include "rx/rx.h"
+#include "rx/rx_latency.h"
 
 #include "sensors/battery.h"
 
@@ -61,6 +63,7 @@ static float motorMixRange;
 static float mixerScale = 1.0f;
 static EXTENDED_FASTRAM motorMixer_t currentMixer[MAX_SUPPORTED_MOTORS];
 static EXTENDED_FASTRAM uint8_t motorCount = 0;
+static EXTENDED_FASTRAM mixerKernelFnPtr mixerKernelFn = mixerKernelGeneric;
 EXTENDED_FASTRAM int mixerThrottleCommand;
 static EXTENDED_FASTRAM int throttleIdleValue = 0;
 static EXTENDED_FASTRAM int motorValueWhenStopped = 0;
@@ -91,7 +94,7 @@ PG_RESET_TEMPLATE(mixerConfig_t, mixerConfig,
     .outputMode = SETTING_OUTPUT_MODE_DEFAULT,
 );
 
-PG_REGISTER_WITH_RESET_TEMPLATE(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 9);
+PG_REGISTER_WITH_RESET_TEMPLATE(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 10);
 
 PG_RESET_TEMPLATE(motorConfig_t, motorConfig,
     .motorPwmProtocol = SETTING_MOTOR_PWM_PROTOCOL_DEFAULT,
@@ -99,6 +102,9 @@ PG_RESET_TEMPLATE(motorConfig_t, motorConfig,
     .maxthrottle = SETTING_MAX_THROTTLE_DEFAULT,
     .mincommand = SETTING_MIN_COMMAND_DEFAULT,
     .motorPoleCount = SETTING_MOTOR_POLES_DEFAULT,            // Most brushless motors that we use are 14 poles
+#ifdef USE_DSHOT_BIDIR
+    .dshotBidir = SETTING_DSHOT_BIDIR_DEFAULT,
+#endif
 );
 
 PG_REGISTER_ARRAY(motorMixer_t, MAX_SUPPORTED_MOTORS, primaryMotorMixer, PG_MOTOR_MIXER, 0);
@@ -189,6 +195,7 @@ void mixerInit(void)
 {
     computeMotorCount();
     loadPrimaryMotorMixer();
+    mixerKernelFn = mixerKernelGet(mixerKernelDetect(currentMixer, motorCount));
     // in 3D mode, mixer gain has to be halved
     if (feature(FEATURE_REVERSIBLE_MOTORS)) {
         mixerScale = 0.5f;
@@ -422,6 +429,15 @@ void FAST_CODE writeMotors(void)
         pwmWriteMotor(i, motorValue);
     }
 #endif
+
+    rxLatencyMotorsMixed();
+#if !defined(SITL_BUILD) && defined(USE_DSHOT)
+    // DShot frames only go out from pwmCompleteMotorUpdate(), analog outputs take the new values right away
+    if (!isMotorProtocolDigital())
+#endif
+    {
+        rxLatencyMotorsUpdated(micros());
+    }
 }
 
 void writeAllMotors(int16_t mc)
@@ -470,7 +486,7 @@ void FAST_CODE mixTable()
     }
 #endif
 
-    int16_t input[3];   // RPY, range [-500:+500]
+    float input[3];   // RPY, range [-500:+500]
     // Allow direct stick input to motors in passthrough mode on airplanes
     if (STATE(FIXED_WING_LEGACY) && FLIGHT_MODE(MANUAL_MODE)) {
         // Direct passthru from RX
@@ -484,23 +500,25 @@ void FAST_CODE mixTable()
         input[YAW] = axisPID[YAW];
     }
 
+    // mixerScale is 1 or 0.5, scaling the input instead of every motor gives the same result
+    input[ROLL] *= mixerScale;
+    input[PITCH] *= mixerScale;
+    input[YAW] *= -motorYawMultiplier * mixerScale;
+
     // Initial mixer concept by bdoiron74 reused and optimized for Air Mode
-    int16_t rpyMix[MAX_SUPPORTED_MOTORS];
-    int16_t rpyMixMax = 0; // assumption: symetrical about zero.
-    int16_t rpyMixMin = 0;
+    float rpyMix[MAX_SUPPORTED_MOTORS];
+    float rpyMixMax = 0; // assumption: symetrical about zero.
+    float rpyMixMin = 0;
 
     // motors for non-servo mixes
-    for (int i = 0; i < motorCount; i++) {
-        rpyMix[i] =
-            (input[PITCH] * currentMixer[i].pitch +
-            input[ROLL] * currentMixer[i].roll +
-            -motorYawMultiplier * input[YAW] * currentMixer[i].yaw) * mixerScale;
+    mixerKernelFn(currentMixer, motorCount, input, rpyMix);
 
+    for (int i = 0; i < motorCount; i++) {
         if (rpyMix[i] > rpyMixMax) rpyMixMax = rpyMix[i];
         if (rpyMix[i] < rpyMixMin) rpyMixMin = rpyMix[i];
     }
 
-    int16_t rpyMixRange = rpyMixMax - rpyMixMin;
+    float rpyMixRange = rpyMixMax - rpyMixMin;
     int16_t throttleRange;
     int16_t throttleMin, throttleMax;
 
@@ -568,7 +586,7 @@ void FAST_CODE mixTable()
     throttleRange = throttleMax - throttleMin;
 
     #define THROTTLE_CLIPPING_FACTOR    0.33f
-    motorMixRange = (float)rpyMixRange / (float)throttleRange;
+    motorMixRange = rpyMixRange / (float)throttleRange;
     if (motorMixRange > 1.0f) {
         for (int i = 0; i < motorCount; i++) {
             rpyMix[i] /= motorMixRange;
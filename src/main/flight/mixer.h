@@ -90,6 +90,7 @@ typedef struct motorConfig_s {
     uint8_t  motorPwmProtocol;
     uint16_t digitalIdleOffsetValue;
     uint8_t motorPoleCount;                 // Magnetic poles in the motors for calculating actual RPM from eRPM provided by ESC telemetry
+    uint8_t dshotBidir;                     // Inverted DShot with eRPM telemetry on the motor signal wire
 } motorConfig_t;
 
 PG_DECLARE(motorConfig_t, motorConfig);
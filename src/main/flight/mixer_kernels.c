@@ -0,0 +1,225 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "platform.h"
+
+#include "common/axis.h"
+#include "common/utils.h"
+
+#include "flight/mixer_kernels.h"
+
+/*
+ * MSP carries the coefficients in steps of 0.001, values like 0.866025 don't arrive exactly. These are
+ * matched with a tolerance and the kernels take them from the mixer, everything else has to match exactly.
+ */
+#define MIXER_KERNEL_COEFFICIENT_TOLERANCE  0.01f
+
+typedef struct mixerKernelLayout_s {
+    uint8_t motorCount;
+    const motorMixer_t *mixer;
+    mixerKernelFnPtr kernelFn;
+} mixerKernelLayout_t;
+
+/*
+ * Every kernel adds pitch, roll and yaw in that order, like the generic one. Multiplying by 0.5 or 1 and adding a
+ * negated value are exact and terms with a zero coefficient don't change the sum, so the results are the same.
+ */
+
+static const motorMixer_t mixerQuadX[] = {
+    { 1.0f, -1.0f,  1.0f, -1.0f },          // REAR_R
+    { 1.0f, -1.0f, -1.0f,  1.0f },          // FRONT_R
+    { 1.0f,  1.0f,  1.0f,  1.0f },          // REAR_L
+    { 1.0f,  1.0f, -1.0f, -1.0f },          // FRONT_L
+};
+
+static void FAST_CODE mixerKernelQuadX(const motorMixer_t *mixer, uint8_t motorCount, const float *input, float *rpyMix)
+{
+    UNUSED(mixer);
+    UNUSED(motorCount);
+
+    const float pitch = input[FD_PITCH];
+    const float roll = input[FD_ROLL];
+    const float yaw = input[FD_YAW];
+
+    rpyMix[0] = (pitch - roll) - yaw;
+    rpyMix[1] = (-pitch - roll) + yaw;
+    rpyMix[2] = (pitch + roll) + yaw;
+    rpyMix[3] = (-pitch + roll) - yaw;
+}
+
+static const motorMixer_t mixerHexX[] = {
+    { 1.0f, -0.5f,  0.866025f,  1.0f },     // REAR_R
+    { 1.0f, -0.5f, -0.866025f,  1.0f },     // FRONT_R
+    { 1.0f,  0.5f,  0.866025f, -1.0f },     // REAR_L
+    { 1.0f,  0.5f, -0.866025f, -1.0f },     // FRONT_L
+    { 1.0f, -1.0f,  0.0f,      -1.0f },     // RIGHT
+    { 1.0f,  1.0f,  0.0f,       1.0f },     // LEFT
+};
+
+static void FAST_CODE mixerKernelHexX(const motorMixer_t *mixer, uint8_t motorCount, const float *input, float *rpyMix)
+{
+    UNUSED(motorCount);
+
+    const float rear = input[FD_PITCH] * mixer[0].pitch;
+    const float front = input[FD_PITCH] * mixer[1].pitch;
+    const float roll = input[FD_ROLL] * 0.5f;
+    const float yaw = input[FD_YAW];
+
+    rpyMix[0] = (rear - roll) + yaw;
+    rpyMix[1] = (front - roll) + yaw;
+    rpyMix[2] = (rear + roll) - yaw;
+    rpyMix[3] = (front + roll) - yaw;
+    rpyMix[4] = -input[FD_ROLL] - yaw;
+    rpyMix[5] = input[FD_ROLL] + yaw;
+}
+
+static const motorMixer_t mixerOctoX8[] = {
+    { 1.0f, -1.0f,  1.0f, -1.0f },          // REAR_R
+    { 1.0f, -1.0f, -1.0f,  1.0f },          // FRONT_R
+    { 1.0f,  1.0f,  1.0f,  1.0f },          // REAR_L
+    { 1.0f,  1.0f, -1.0f, -1.0f },          // FRONT_L
+    { 1.0f, -1.0f,  1.0f,  1.0f },          // UNDER_REAR_R
+    { 1.0f, -1.0f, -1.0f, -1.0f },          // UNDER_FRONT_R
+    { 1.0f,  1.0f,  1.0f, -1.0f },          // UNDER_REAR_L
+    { 1.0f,  1.0f, -1.0f,  1.0f },          // UNDER_FRONT_L
+};
+
+static void FAST_CODE mixerKernelOctoX8(const motorMixer_t *mixer, uint8_t motorCount, const float *input, float *rpyMix)
+{
+    UNUSED(mixer);
+    UNUSED(motorCount);
+
+    const float yaw = input[FD_YAW];
+
+    // Stacked motors share pitch and roll, only the yaw direction differs
+    const float rearRight = input[FD_PITCH] - input[FD_ROLL];
+    const float frontRight = -input[FD_PITCH] - input[FD_ROLL];
+    const float rearLeft = input[FD_PITCH] + input[FD_ROLL];
+    const float frontLeft = -input[FD_PITCH] + input[FD_ROLL];
+
+    rpyMix[0] = rearRight - yaw;
+    rpyMix[1] = frontRight + yaw;
+    rpyMix[2] = rearLeft + yaw;
+    rpyMix[3] = frontLeft - yaw;
+    rpyMix[4] = rearRight + yaw;
+    rpyMix[5] = frontRight - yaw;
+    rpyMix[6] = rearLeft - yaw;
+    rpyMix[7] = frontLeft + yaw;
+}
+
+static const motorMixer_t mixerTri[] = {
+    { 1.0f,  0.0f,  1.333333f, 0.0f },      // REAR
+    { 1.0f, -1.0f, -0.666667f, 0.0f },      // RIGHT
+    { 1.0f,  1.0f, -0.666667f, 0.0f },      // LEFT
+};
+
+static void FAST_CODE mixerKernelTri(const motorMixer_t *mixer, uint8_t motorCount, const float *input, float *rpyMix)
+{
+    UNUSED(motorCount);
+
+    // Yaw is on the tail servo
+    const float front = input[FD_PITCH] * mixer[1].pitch;
+
+    rpyMix[0] = input[FD_PITCH] * mixer[0].pitch;
+    rpyMix[1] = front - input[FD_ROLL];
+    rpyMix[2] = front + input[FD_ROLL];
+}
+
+static const mixerKernelLayout_t mixerKernelLayouts[MIXER_KERNEL_COUNT] = {
+    [MIXER_KERNEL_GENERIC]  = { 0, NULL, mixerKernelGeneric },
+    [MIXER_KERNEL_QUAD_X]   = { ARRAYLEN(mixerQuadX), mixerQuadX, mixerKernelQuadX },
+    [MIXER_KERNEL_HEX_X]    = { ARRAYLEN(mixerHexX), mixerHexX, mixerKernelHexX },
+    [MIXER_KERNEL_OCTO_X8]  = { ARRAYLEN(mixerOctoX8), mixerOctoX8, mixerKernelOctoX8 },
+    [MIXER_KERNEL_TRI]      = { ARRAYLEN(mixerTri), mixerTri, mixerKernelTri },
+};
+
+static bool isExactCoefficient(float value)
+{
+    return value == 0.0f || fabsf(value) == 0.5f || fabsf(value) == 1.0f;
+}
+
+static bool mixerCoefficientMatches(const motorMixer_t *mixer, const motorMixer_t *layout, uint8_t motor, int axis)
+{
+    const float *values = &mixer[motor].roll;
+    const float *nominal = &layout[motor].roll;
+
+    if (isExactCoefficient(nominal[axis])) {
+        return values[axis] == nominal[axis];
+    }
+
+    if (fabsf(values[axis] - nominal[axis]) > MIXER_KERNEL_COEFFICIENT_TOLERANCE) {
+        return false;
+    }
+
+    /*
+     * A kernel uses a single value for all motors sharing the nominal one, they have to be the same. Positive and
+     * negative ones may differ, the encoding truncates 0.866025 to 0.866 and -0.866025 to -0.867.
+     */
+    for (int i = 0; i < motor; i++) {
+        const float *previousValues = &mixer[i].roll;
+        const float *previousNominal = &layout[i].roll;
+
+        if (previousNominal[axis] == nominal[axis]) {
+            return values[axis] == previousValues[axis];
+        }
+    }
+
+    return true;
+}
+
+mixerKernel_e mixerKernelDetect(const motorMixer_t *mixer, uint8_t motorCount)
+{
+    for (int kernel = MIXER_KERNEL_GENERIC + 1; kernel < MIXER_KERNEL_COUNT; kernel++) {
+        const mixerKernelLayout_t *layout = &mixerKernelLayouts[kernel];
+
+        if (layout->motorCount != motorCount) {
+            continue;
+        }
+
+        bool matches = true;
+        for (int motor = 0; motor < motorCount && matches; motor++) {
+            for (int axis = 0; axis < XYZ_AXIS_COUNT && matches; axis++) {
+                matches = mixerCoefficientMatches(mixer, layout->mixer, motor, axis);
+            }
+        }
+
+        if (matches) {
+            return kernel;
+        }
+    }
+
+    return MIXER_KERNEL_GENERIC;
+}
+
+mixerKernelFnPtr mixerKernelGet(mixerKernel_e kernel)
+{
+    return mixerKernelLayouts[kernel < MIXER_KERNEL_COUNT ? kernel : MIXER_KERNEL_GENERIC].kernelFn;
+}
+
+void FAST_CODE mixerKernelGeneric(const motorMixer_t *mixer, uint8_t motorCount, const float *input, float *rpyMix)
+{
+    for (int i = 0; i < motorCount; i++) {
+        rpyMix[i] =
+            input[FD_PITCH] * mixer[i].pitch +
+            input[FD_ROLL] * mixer[i].roll +
+            input[FD_YAW] * mixer[i].yaw;
+    }
+}
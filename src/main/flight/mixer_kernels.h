@@ -0,0 +1,45 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "flight/mixer.h"
+
+/*
+ * Roll/pitch/yaw part of the motor mix. The generic kernel multiplies by the mixer matrix, the specialised ones are
+ * selected when the motor mixer is one of the Configurator presets and have the coefficients built in. Given the
+ * same input all kernels give bit identical results.
+ */
+
+typedef enum {
+    MIXER_KERNEL_GENERIC = 0,
+    MIXER_KERNEL_QUAD_X,
+    MIXER_KERNEL_HEX_X,
+    MIXER_KERNEL_OCTO_X8,
+    MIXER_KERNEL_TRI,
+    MIXER_KERNEL_COUNT
+} mixerKernel_e;
+
+// input[] is in RPY order, already scaled and with the yaw direction applied
+typedef void (*mixerKernelFnPtr)(const motorMixer_t *mixer, uint8_t motorCount, const float *input, float *rpyMix);
+
+mixerKernel_e mixerKernelDetect(const motorMixer_t *mixer, uint8_t motorCount);
+mixerKernelFnPtr mixerKernelGet(mixerKernel_e kernel);
+
+void mixerKernelGeneric(const motorMixer_t *mixer, uint8_t motorCount, const float *input, float *rpyMix);
@@ -35,9 +35,11 @@
 #include "common/utils.h"
 #include "common/maths.h"
 #include "common/filter.h"
+#include "drivers/dshot_bidir.h"
 #include "flight/mixer.h"
 #include "sensors/esc_sensor.h"
 #include "fc/config.h"
+#include "fc/runtime_config.h"
 #include "fc/settings.h"
 
 #ifdef USE_RPM_FILTER
@@ -66,7 +68,9 @@ typedef struct
 typedef float (*rpmFilterApplyFnPtr)(rpmFilterBank_t *filter, uint8_t axis, float input);
 typedef void (*rpmFilterUpdateFnPtr)(rpmFilterBank_t *filterBank, uint8_t motor, float baseFrequency);
 
+static EXTENDED_FASTRAM rpmFilterSource_e rpmSource;
 static EXTENDED_FASTRAM pt1Filter_t motorFrequencyFilter[MAX_SUPPORTED_MOTORS];
+static EXTENDED_FASTRAM float motorFrequency[MAX_SUPPORTED_MOTORS];
 static EXTENDED_FASTRAM rpmFilterBank_t gyroRpmFilters;
 static EXTENDED_FASTRAM rpmFilterApplyFnPtr rpmGyroApplyFn;
 static EXTENDED_FASTRAM rpmFilterUpdateFnPtr rpmGyroUpdateFn;
@@ -159,13 +163,34 @@ void rpmFilterUpdate(rpmFilterBank_t *filterBank, uint8_t motor, float baseFrequ
 
 void rpmFiltersInit(void)
 {
+    rpmSource = RPM_FILTER_SOURCE_NONE;
+#ifdef USE_ESC_SENSOR
+    if (STATE(ESC_SENSOR_ENABLED)) {
+        rpmSource = RPM_FILTER_SOURCE_ESC_SENSOR;
+    }
+#endif
+#ifdef USE_DSHOT_BIDIR
+    // Every motor update brings a fresh eRPM, no need to poll the ESCs one by one
+    if (dshotBidirIsEnabled()) {
+        rpmSource = RPM_FILTER_SOURCE_DSHOT;
+    }
+#endif
+
+    // DShot telemetry is picked up every PID loop, ESC sensor data by the RPM filter task
+    const float updateRateUs = (rpmSource == RPM_FILTER_SOURCE_DSHOT) ? getLooptime() : RPM_FILTER_UPDATE_RATE_US;
+
     for (uint8_t i = 0; i < MAX_SUPPORTED_MOTORS; i++)
     {
-        pt1FilterInit(&motorFrequencyFilter[i], RPM_FILTER_RPM_LPF_HZ, US2S(RPM_FILTER_UPDATE_RATE_US));
+        pt1FilterInit(&motorFrequencyFilter[i], RPM_FILTER_RPM_LPF_HZ, US2S(updateRateUs));
+        motorFrequency[i] = 0;
     }
 
     rpmGyroUpdateFn = (rpmFilterUpdateFnPtr)nullRpmFilterUpdate;
 
+    if (rpmSource == RPM_FILTER_SOURCE_NONE) {
+        return;
+    }
+
     if (rpmFilterConfig()->gyro_filter_enabled)
     {
         rpmFilterInit(
@@ -178,23 +203,62 @@ void rpmFiltersInit(void)
     }
 }
 
-void rpmFilterUpdateTask(timeUs_t currentTimeUs)
+static float rpmFilterGetMotorRpm(uint8_t motor)
 {
-    UNUSED(currentTimeUs);
+#ifdef USE_DSHOT_BIDIR
+    if (rpmSource == RPM_FILTER_SOURCE_DSHOT) {
+        return dshotBidirGetMotorErpm(motor) / (motorConfig()->motorPoleCount / 2.0f);
+    }
+#endif
+#ifdef USE_ESC_SENSOR
+    if (rpmSource == RPM_FILTER_SOURCE_ESC_SENSOR) {
+        return getEscTelemetry(motor)->rpm;
+    }
+#endif
+    UNUSED(motor);
+    return 0;
+}
 
+static void rpmFilterUpdateMotors(void)
+{
     uint8_t motorCount = getMotorCount();
     /*
-     * For each motor, read ERPM, filter it and update motor frequency
+     * For each motor, read RPM, filter it and update motor frequency
      */
     for (uint8_t i = 0; i < motorCount; i++)
     {
-        const escSensorData_t *escState = getEscTelemetry(i); //Get ESC telemetry
-        const float baseFrequency = pt1FilterApply(&motorFrequencyFilter[i], escState->rpm * HZ_TO_RPM); //Filter motor frequency
+        motorFrequency[i] = pt1FilterApply(&motorFrequencyFilter[i], rpmFilterGetMotorRpm(i) * HZ_TO_RPM); //Filter motor frequency
 
-        rpmGyroUpdateFn(&gyroRpmFilters, i, baseFrequency);
+        rpmGyroUpdateFn(&gyroRpmFilters, i, motorFrequency[i]);
     }
 }
 
+void rpmFilterUpdateTask(timeUs_t currentTimeUs)
+{
+    UNUSED(currentTimeUs);
+
+    if (rpmSource == RPM_FILTER_SOURCE_ESC_SENSOR) {
+        rpmFilterUpdateMotors();
+    }
+}
+
+void rpmFilterLoopUpdate(void)
+{
+    if (rpmSource == RPM_FILTER_SOURCE_DSHOT) {
+        rpmFilterUpdateMotors();
+    }
+}
+
+rpmFilterSource_e rpmFilterGetSource(void)
+{
+    return rpmSource;
+}
+
+float rpmFilterGetMotorFrequency(uint8_t motor)
+{
+    return motor < MAX_SUPPORTED_MOTORS ? motorFrequency[motor] : 0;
+}
+
 float rpmFilterGyroApply(uint8_t axis, float input)
 {
     return rpmGyroApplyFn(&gyroRpmFilters, axis, input);
@@ -43,10 +43,20 @@ typedef struct rpmFilterConfig_s {
 
 PG_DECLARE(rpmFilterConfig_t, rpmFilterConfig);
 
+typedef enum {
+    RPM_FILTER_SOURCE_NONE = 0,
+    RPM_FILTER_SOURCE_ESC_SENSOR,       // ESC telemetry over UART, polled by TASK_RPM_FILTER
+    RPM_FILTER_SOURCE_DSHOT,            // Bidirectional DShot, fresh every motor update
+} rpmFilterSource_e;
+
 #define RPM_FILTER_UPDATE_RATE_HZ 500
 #define RPM_FILTER_UPDATE_RATE_US (1000000.0f / RPM_FILTER_UPDATE_RATE_HZ)
 
 void disableRpmFilters(void);
 void rpmFiltersInit(void);
 void rpmFilterUpdateTask(timeUs_t currentTimeUs);
+// Called every PID loop before the gyro is filtered
+void rpmFilterLoopUpdate(void);
+rpmFilterSource_e rpmFilterGetSource(void);
+float rpmFilterGetMotorFrequency(uint8_t motor);
 float rpmFilterGyroApply(uint8_t axis, float input);
\ No newline at end of file
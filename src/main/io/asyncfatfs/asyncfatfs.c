@@ -19,6 +19,8 @@
 
 #include <platform.h>
 
+#include "build/trace.h"
+
 #include "common/time.h"
 #include "common/utils.h"
 
@@ -38,7 +40,27 @@
     #define ONLY_EXPOSE_FOR_TESTING static
 #endif
 
+/*
+ * Number of 512-byte sectors in the cache. Targets with plenty of RAM may override this to absorb longer card busy
+ * periods without stalling the writer.
+ */
+#ifndef AFATFS_NUM_CACHE_SECTORS
+#if defined(STM32H7)
+#define AFATFS_NUM_CACHE_SECTORS 32
+#else
 #define AFATFS_NUM_CACHE_SECTORS 8
+#endif
+#endif
+
+/*
+ * The first AFATFS_NUM_METADATA_CACHE_SECTORS entries of the cache form a pool which is reserved for FAT and
+ * directory sectors. File data may never be allocated there, so streaming a large file can't evict the metadata
+ * that the next supercluster append is going to need (which would otherwise have to be read back from the card,
+ * interrupting the multi-block write).
+ */
+#ifndef AFATFS_NUM_METADATA_CACHE_SECTORS
+#define AFATFS_NUM_METADATA_CACHE_SECTORS MAX(AFATFS_NUM_CACHE_SECTORS / 4, 2)
+#endif
 
 // FAT filesystems are allowed to differ from these parameters, but we choose not to support those weird filesystems:
 #define AFATFS_SECTOR_SIZE  512
@@ -53,7 +75,17 @@
  * How many blocks will we write in a row before we bother using the SDcard's multiple block write method?
  * If this define is omitted, this disables multi-block write.
  */
+#ifndef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
 #define AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT 4
+#endif
+
+/*
+ * While a multi-block write is streaming, flushes of other dirty sectors (which would end the multi-block write on
+ * the card) are postponed for up to this many flush attempts, waiting for the writer to finish the next sector.
+ */
+#ifndef AFATFS_MAX_DEFERRED_FLUSHES
+#define AFATFS_MAX_DEFERRED_FLUSHES 32
+#endif
 
 #define AFATFS_FILES_PER_DIRECTORY_SECTOR (AFATFS_SECTOR_SIZE / sizeof(fatDirectoryEntry_t))
 
@@ -83,6 +115,8 @@
 #define AFATFS_CACHE_DISCARDABLE  8
 // Increase the retain counter of the cache sector to prevent it from being discarded when in the in-sync state
 #define AFATFS_CACHE_RETAIN       16
+// The sector holds file contents rather than FAT/directory metadata, so it must be allocated outside the metadata pool
+#define AFATFS_CACHE_FILE_DATA    32
 
 // Turn the largest free block on the disk into one contiguous file for efficient fragment-free allocation
 #define AFATFS_USE_FREEFILE
@@ -194,6 +228,9 @@ typedef struct afatfsCacheBlockDescriptor_t {
      * is overridden by the locked and retainCount flags.
      */
     unsigned discardable:1;
+
+    // This block holds file contents rather than FAT/directory metadata
+    unsigned fileData:1;
 } afatfsCacheBlockDescriptor_t;
 
 typedef enum {
@@ -446,6 +483,15 @@ typedef struct afatfs_t {
     int cacheDirtyEntries; // The number of cache entries in the AFATFS_CACHE_STATE_DIRTY state
     bool cacheFlushInProgress;
 
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+    // The multi-block write that the card is currently streaming (if blocksRemain is non-zero)
+    struct {
+        uint32_t nextSector;
+        uint32_t blocksRemain;
+        uint8_t deferredFlushes;
+    } multiBlockWrite;
+#endif
+
     afatfsFile_t openFiles[AFATFS_MAX_OPEN_FILES];
 
 #ifdef AFATFS_USE_FREEFILE
@@ -489,6 +535,9 @@ typedef struct afatfs_t {
 static uint8_t afatfs_cache[AFATFS_SECTOR_SIZE * AFATFS_NUM_CACHE_SECTORS] __attribute__((aligned(32)));
 #endif
 
+STATIC_ASSERT(AFATFS_NUM_CACHE_SECTORS <= INT8_MAX, afatfs_cache_index_must_fit_in_int8);
+STATIC_ASSERT(AFATFS_NUM_METADATA_CACHE_SECTORS < AFATFS_NUM_CACHE_SECTORS, afatfs_cache_needs_room_for_file_data);
+
 static afatfs_t afatfs;
 
 static void afatfs_fileOperationContinue(afatfsFile_t *file);
@@ -617,6 +666,7 @@ static void afatfs_cacheSectorInit(afatfsCacheBlockDescriptor_t *descriptor, uin
     descriptor->locked = locked;
     descriptor->retainCount = 0;
     descriptor->discardable = 0;
+    descriptor->fileData = 0;
 }
 
 /**
@@ -676,6 +726,32 @@ static void afatfs_sdcardWriteComplete(sdcardBlockOperation_e operation, uint32_
     }
 }
 
+/**
+ * Keep track of the card's multi-block write after a block with the given index was accepted for writing. Writing any
+ * block other than the next one in the sequence ends the multi-block write.
+ */
+static void afatfs_multiBlockWriteAdvance(uint32_t sectorIndex)
+{
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+    if (afatfs.multiBlockWrite.blocksRemain > 0 && afatfs.multiBlockWrite.nextSector == sectorIndex) {
+        afatfs.multiBlockWrite.nextSector++;
+        afatfs.multiBlockWrite.blocksRemain--;
+    } else {
+        afatfs.multiBlockWrite.blocksRemain = 0;
+    }
+    afatfs.multiBlockWrite.deferredFlushes = 0;
+
+    // The pre-erase hint only applies to the write that has just begun, a later rewrite of this sector stands alone
+    for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+        if (afatfs.cacheDescriptor[i].sectorIndex == sectorIndex && !afatfs.cacheDescriptor[i].fileData) {
+            afatfs.cacheDescriptor[i].consecutiveEraseBlockCount = 0;
+        }
+    }
+#else
+    UNUSED(sectorIndex);
+#endif
+}
+
 /**
  * Attempt to flush the dirty cache entry with the given index to the SDcard.
  */
@@ -685,7 +761,14 @@ static void afatfs_cacheFlushSector(int cacheIndex)
 
 #ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
     if (cacheDescriptor->consecutiveEraseBlockCount) {
-        sdcard_beginWriteBlocks(cacheDescriptor->sectorIndex, cacheDescriptor->consecutiveEraseBlockCount);
+        if (sdcard_beginWriteBlocks(cacheDescriptor->sectorIndex, cacheDescriptor->consecutiveEraseBlockCount) != SDCARD_OPERATION_SUCCESS) {
+            // The card may have ended the multi-block write we had going in order to start this one
+            afatfs.multiBlockWrite.blocksRemain = 0;
+        } else if (afatfs.multiBlockWrite.blocksRemain == 0 || afatfs.multiBlockWrite.nextSector != cacheDescriptor->sectorIndex) {
+            // The card started a new multi-block write rather than continuing the one we already had going
+            afatfs.multiBlockWrite.nextSector = cacheDescriptor->sectorIndex;
+            afatfs.multiBlockWrite.blocksRemain = cacheDescriptor->consecutiveEraseBlockCount;
+        }
     }
 #endif
 
@@ -695,15 +778,25 @@ static void afatfs_cacheFlushSector(int cacheIndex)
             afatfs.cacheDirtyEntries--;
             cacheDescriptor->state = AFATFS_CACHE_STATE_WRITING;
             afatfs.cacheFlushInProgress = true;
+            afatfs_multiBlockWriteAdvance(cacheDescriptor->sectorIndex);
             break;
 
         case SDCARD_OPERATION_SUCCESS:
             // Buffer is already transmitted
             afatfs.cacheDirtyEntries--;
             cacheDescriptor->state = AFATFS_CACHE_STATE_IN_SYNC;
+            afatfs_multiBlockWriteAdvance(cacheDescriptor->sectorIndex);
             break;
 
         case SDCARD_OPERATION_BUSY:
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+            // Writing out of sequence makes the card end the multi-block write we had going, even if it can't accept the block yet
+            if (afatfs.multiBlockWrite.nextSector != cacheDescriptor->sectorIndex) {
+                afatfs.multiBlockWrite.blocksRemain = 0;
+            }
+#endif
+            break;
+
         case SDCARD_OPERATION_FAILURE:
         default:
             ;
@@ -726,24 +819,66 @@ static afatfsCacheBlockDescriptor_t* afatfs_findCacheSector(uint32_t sectorIndex
 }
 
 /**
- * Find or allocate a cache sector for the given sector index on disk. Returns a block which matches one of these
- * conditions (in descending order of preference):
+ * Find a cache entry within the index range [firstIndex, lastIndex) which can be (re)allocated to hold a new sector.
+ * Returns a block which matches one of these conditions (in descending order of preference):
  *
- * - The requested sector that already exists in the cache
  * - The index of an empty sector
  * - The index of a synced discardable sector
  * - The index of the oldest synced sector
  *
- * Otherwise it returns -1 to signal failure (cache is full!)
+ * Otherwise it returns -1 (that part of the cache is full!)
  */
-static int afatfs_allocateCacheSector(uint32_t sectorIndex)
+static int afatfs_findEvictableCacheSector(int firstIndex, int lastIndex)
 {
-    int allocateIndex;
     int emptyIndex = -1, discardableIndex = -1;
 
     uint32_t oldestSyncedSectorLastUse = 0xFFFFFFFF;
     int oldestSyncedSectorIndex = -1;
 
+    for (int i = firstIndex; i < lastIndex; i++) {
+        switch (afatfs.cacheDescriptor[i].state) {
+            case AFATFS_CACHE_STATE_EMPTY:
+                emptyIndex = i;
+            break;
+            case AFATFS_CACHE_STATE_IN_SYNC:
+                // Is this a synced sector that we could evict from the cache?
+                if (!afatfs.cacheDescriptor[i].locked && afatfs.cacheDescriptor[i].retainCount == 0) {
+                    if (afatfs.cacheDescriptor[i].discardable) {
+                        discardableIndex = i;
+                    } else if (afatfs.cacheDescriptor[i].accessTimestamp < oldestSyncedSectorLastUse) {
+                        // This is older than last block we decided to evict, so evict this one in preference
+                        oldestSyncedSectorLastUse = afatfs.cacheDescriptor[i].accessTimestamp;
+                        oldestSyncedSectorIndex = i;
+                    }
+                }
+            break;
+            default:
+                ;
+        }
+    }
+
+    if (emptyIndex > -1) {
+        return emptyIndex;
+    } else if (discardableIndex > -1) {
+        return discardableIndex;
+    } else {
+        return oldestSyncedSectorIndex;
+    }
+}
+
+/**
+ * Find or allocate a cache sector for the given sector index on disk. Returns the requested sector if it already
+ * exists in the cache, otherwise a newly allocated entry chosen by afatfs_findEvictableCacheSector().
+ *
+ * File data is only ever allocated outside of the metadata pool. FAT and directory sectors prefer the metadata pool
+ * but may overflow into the rest of the cache.
+ *
+ * Otherwise it returns -1 to signal failure (cache is full!)
+ */
+static int afatfs_allocateCacheSector(uint32_t sectorIndex, bool fileData)
+{
+    int allocateIndex = -1;
+
     if (
         !afatfs_assert(
             afatfs.numClusters == 0 // We're unable to check sector bounds during startup since we haven't read volume label yet
@@ -760,53 +895,82 @@ static int afatfs_allocateCacheSector(uint32_t sectorIndex)
              * empty case. (Sectors marked as empty should be treated as if they don't have a block index assigned)
              */
             if (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_EMPTY) {
-                emptyIndex = i;
-                break;
+                if (allocateIndex == -1 && (!fileData || i >= AFATFS_NUM_METADATA_CACHE_SECTORS)) {
+                    allocateIndex = i;
+                }
+                continue;
             }
 
             // Bump the last access time
             afatfs.cacheDescriptor[i].accessTimestamp = ++afatfs.cacheTimer;
             return i;
         }
+    }
 
-        switch (afatfs.cacheDescriptor[i].state) {
-            case AFATFS_CACHE_STATE_EMPTY:
-                emptyIndex = i;
-            break;
-            case AFATFS_CACHE_STATE_IN_SYNC:
-                // Is this a synced sector that we could evict from the cache?
-                if (!afatfs.cacheDescriptor[i].locked && afatfs.cacheDescriptor[i].retainCount == 0) {
-                    if (afatfs.cacheDescriptor[i].discardable) {
-                        discardableIndex = i;
-                    } else if (afatfs.cacheDescriptor[i].accessTimestamp < oldestSyncedSectorLastUse) {
-                        // This is older than last block we decided to evict, so evict this one in preference
-                        oldestSyncedSectorLastUse = afatfs.cacheDescriptor[i].accessTimestamp;
-                        oldestSyncedSectorIndex = i;
-                    }
-                }
-            break;
-            default:
-                ;
-        }
+    if (allocateIndex == -1 && !fileData) {
+        allocateIndex = afatfs_findEvictableCacheSector(0, AFATFS_NUM_METADATA_CACHE_SECTORS);
     }
 
-    if (emptyIndex > -1) {
-        allocateIndex = emptyIndex;
-    } else if (discardableIndex > -1) {
-        allocateIndex = discardableIndex;
-    } else if (oldestSyncedSectorIndex > -1) {
-        allocateIndex = oldestSyncedSectorIndex;
-    } else {
-        allocateIndex = -1;
+    if (allocateIndex == -1) {
+        allocateIndex = afatfs_findEvictableCacheSector(AFATFS_NUM_METADATA_CACHE_SECTORS, AFATFS_NUM_CACHE_SECTORS);
     }
 
     if (allocateIndex > -1) {
         afatfs_cacheSectorInit(&afatfs.cacheDescriptor[allocateIndex], sectorIndex, false);
+        afatfs.cacheDescriptor[allocateIndex].fileData = fileData;
     }
 
     return allocateIndex;
 }
 
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+/**
+ * Find the cache entry of the given dirty metadata sector that could be flushed right now, or -1 if there isn't one.
+ */
+static int afatfs_findFlushableMetadataSector(uint32_t sectorIndex)
+{
+    for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+        if (afatfs.cacheDescriptor[i].sectorIndex == sectorIndex && afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY
+            && !afatfs.cacheDescriptor[i].locked && !afatfs.cacheDescriptor[i].fileData
+        ) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * FAT sectors tend to be dirtied in runs (e.g. the same region of both FATs during a supercluster append). Rewind to
+ * the start of the run of flushable dirty metadata sectors that the given sector belongs to, and mark the run so that
+ * it'll be flushed as a single multi-block write instead of one slow single-block write per sector.
+ *
+ * Returns the cache index of the first sector of the run.
+ */
+static int afatfs_prepareMetadataRunFlush(int cacheIndex)
+{
+    int firstIndex = cacheIndex;
+    uint32_t firstSector = afatfs.cacheDescriptor[cacheIndex].sectorIndex;
+
+    for (int prevIndex; firstSector > 0 && (prevIndex = afatfs_findFlushableMetadataSector(firstSector - 1)) > -1; ) {
+        firstIndex = prevIndex;
+        firstSector--;
+    }
+
+    uint16_t runLength = 1;
+
+    while (runLength < UINT16_MAX && afatfs_findFlushableMetadataSector(firstSector + runLength) > -1) {
+        runLength++;
+    }
+
+    if (runLength > 1) {
+        afatfs.cacheDescriptor[firstIndex].consecutiveEraseBlockCount = runLength;
+    }
+
+    return firstIndex;
+}
+#endif
+
 /**
  * Attempt to flush dirty cache pages out to the sdcard, returning true if all flushable data has been flushed.
  */
@@ -826,6 +990,48 @@ bool afatfs_flush(void)
             }
         }
 
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+        /*
+         * Flushing any sector other than the next one of the card's open multi-block write would end that write, so
+         * keep the stream going whenever we can. If the writer is still filling the next sector, hold back the dirty
+         * FAT/directory sectors for a while (as long as they still fit in the metadata pool) so that they get flushed
+         * together in one interruption of the stream instead of one interruption each.
+         */
+        if (afatfs.multiBlockWrite.blocksRemain > 0
+            && (earliestSectorIndex == -1 || afatfs.cacheDescriptor[earliestSectorIndex].sectorIndex != afatfs.multiBlockWrite.nextSector)
+        ) {
+            int dirtyMetadataSectors = 0;
+            int nextSectorIndex = -1;
+
+            for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+                if (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_DIRTY) {
+                    if (afatfs.cacheDescriptor[i].sectorIndex == afatfs.multiBlockWrite.nextSector) {
+                        nextSectorIndex = i;
+                    } else if (!afatfs.cacheDescriptor[i].fileData) {
+                        dirtyMetadataSectors++;
+                    }
+                }
+            }
+
+            if (nextSectorIndex > -1) {
+                if (!afatfs.cacheDescriptor[nextSectorIndex].locked) {
+                    earliestSectorIndex = nextSectorIndex;
+                } else if (dirtyMetadataSectors < AFATFS_NUM_METADATA_CACHE_SECTORS
+                    && afatfs.multiBlockWrite.deferredFlushes < AFATFS_MAX_DEFERRED_FLUSHES
+                ) {
+                    afatfs.multiBlockWrite.deferredFlushes++;
+                    return false;
+                }
+            }
+        }
+
+        if (earliestSectorIndex > -1 && !afatfs.cacheDescriptor[earliestSectorIndex].fileData
+            && afatfs.cacheDescriptor[earliestSectorIndex].consecutiveEraseBlockCount == 0
+        ) {
+            earliestSectorIndex = afatfs_prepareMetadataRunFlush(earliestSectorIndex);
+        }
+#endif
+
         if (earliestSectorIndex > -1) {
             afatfs_cacheFlushSector(earliestSectorIndex);
 
@@ -904,7 +1110,7 @@ static afatfsOperationStatus_e afatfs_cacheSector(uint32_t physicalSectorIndex,
         return AFATFS_OPERATION_FAILURE;
     }
 
-    int cacheSectorIndex = afatfs_allocateCacheSector(physicalSectorIndex);
+    int cacheSectorIndex = afatfs_allocateCacheSector(physicalSectorIndex, (sectorFlags & AFATFS_CACHE_FILE_DATA) != 0);
 
     if (cacheSectorIndex == -1) {
         // We don't have enough free cache to service this request right now, try again later
@@ -920,6 +1126,10 @@ static afatfsOperationStatus_e afatfs_cacheSector(uint32_t physicalSectorIndex,
             if ((sectorFlags & AFATFS_CACHE_READ) != 0) {
                 if (sdcard_readBlock(physicalSectorIndex, afatfs_cacheSectorGetMemory(cacheSectorIndex), afatfs_sdcardReadComplete, 0)) {
                     afatfs.cacheDescriptor[cacheSectorIndex].state = AFATFS_CACHE_STATE_READING;
+#ifdef AFATFS_MIN_MULTIPLE_BLOCK_WRITE_COUNT
+                    // Reads terminate any multi-block write on the card
+                    afatfs.multiBlockWrite.blocksRemain = 0;
+#endif
                 }
                 return AFATFS_OPERATION_IN_PROGRESS;
             }
@@ -1787,6 +1997,14 @@ static bool afatfs_isEndOfAllocatedFile(afatfsFilePtr_t file)
     }
 }
 
+/**
+ * Get the cache flags which describe the kind of sectors that the contents of the given file occupy.
+ */
+static uint8_t afatfs_fileCacheFlags(afatfsFilePtr_t file)
+{
+    return file->type == AFATFS_FILE_TYPE_NORMAL ? AFATFS_CACHE_FILE_DATA : 0;
+}
+
 /**
  * Take a lock on the sector at the current file cursor position.
  *
@@ -1818,7 +2036,7 @@ static uint8_t* afatfs_fileRetainCursorSectorForRead(afatfsFilePtr_t file)
         afatfsOperationStatus_e status = afatfs_cacheSector(
             physicalSector,
             &result,
-            AFATFS_CACHE_READ | AFATFS_CACHE_RETAIN,
+            AFATFS_CACHE_READ | AFATFS_CACHE_RETAIN | afatfs_fileCacheFlags(file),
             0
         );
 
@@ -1863,7 +2081,7 @@ static uint8_t* afatfs_fileLockCursorSectorForWrite(afatfsFilePtr_t file)
         }
 
         uint32_t physicalSector = afatfs_fileGetCursorPhysicalSector(file);
-        uint8_t cacheFlags = AFATFS_CACHE_WRITE | AFATFS_CACHE_LOCK;
+        uint8_t cacheFlags = AFATFS_CACHE_WRITE | AFATFS_CACHE_LOCK | afatfs_fileCacheFlags(file);
         uint32_t cursorOffsetInSector = file->cursorOffset % AFATFS_SECTOR_SIZE;
         uint32_t offsetOfStartOfSector = file->cursorOffset & ~((uint32_t) AFATFS_SECTOR_SIZE - 1);
         uint32_t offsetOfEndOfSector = offsetOfStartOfSector + AFATFS_SECTOR_SIZE;
@@ -1884,6 +2102,18 @@ static uint8_t* afatfs_fileLockCursorSectorForWrite(afatfsFilePtr_t file)
             uint32_t cursorOffsetInSupercluster = file->cursorOffset & (afatfs_superClusterSize() - 1);
 
             eraseBlockCount = afatfs_fatEntriesPerSector() * afatfs.sectorsPerCluster - cursorOffsetInSupercluster / AFATFS_SECTOR_SIZE;
+
+#ifdef AFATFS_USE_FREEFILE
+            /*
+             * The next supercluster of the file will be carved from the start of the freefile, so if that immediately
+             * follows this supercluster we can keep the same multi-block write streaming across the boundary.
+             */
+            uint32_t superclusterEndCluster = (file->cursorCluster / afatfs_fatEntriesPerSector() + 1) * afatfs_fatEntriesPerSector();
+
+            if (afatfs.freeFile.type != AFATFS_FILE_TYPE_NONE && afatfs.freeFile.firstCluster == superclusterEndCluster) {
+                eraseBlockCount += afatfs.freeFile.logicalSize / AFATFS_SECTOR_SIZE;
+            }
+#endif
         } else {
             eraseBlockCount = 0;
         }
@@ -3593,8 +3823,36 @@ static void afatfs_initContinue(void)
  * Check to see if there are any pending operations on the filesystem and perform a little work (without waiting on the
  * sdcard). You must call this periodically.
  */
+#ifdef USE_TRACE
+/**
+ * Returns true if the filesystem has some work in progress (as opposed to idle polls of the main loop).
+ */
+static bool afatfs_isBusy(void)
+{
+    if (afatfs.cacheDirtyEntries > 0 || afatfs.cacheFlushInProgress || afatfs.filesystemState == AFATFS_FILESYSTEM_STATE_INITIALIZATION
+        || afatfs_fileIsBusy(&afatfs.currentDirectory)) {
+        return true;
+    }
+
+    for (int i = 0; i < AFATFS_MAX_OPEN_FILES; i++) {
+        if (afatfs_fileIsBusy(&afatfs.openFiles[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+#endif
+
 void afatfs_poll(void)
 {
+#ifdef USE_TRACE
+    const bool traced = afatfs_isBusy();
+    if (traced) {
+        TRACE_BEGIN(TRACE_EVENT_AFATFS_POLL, 0);
+    }
+#endif
+
     // Only attempt to continue FS operations if the card is present & ready, otherwise we would just be wasting time
     if (sdcard_poll()) {
         afatfs_flush();
@@ -3610,6 +3868,12 @@ void afatfs_poll(void)
                 ;
         }
     }
+
+#ifdef USE_TRACE
+    if (traced) {
+        TRACE_END(TRACE_EVENT_AFATFS_POLL, 0);
+    }
+#endif
 }
 
 afatfsFilesystemState_e afatfs_getFilesystemState(void)
@@ -3699,7 +3963,9 @@ bool afatfs_destroy(bool dirty)
 uint32_t afatfs_getFreeBufferSpace(void)
 {
     uint32_t result = 0;
-    for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
+
+    // Only the part of the cache outside the metadata pool can accept file data
+    for (int i = AFATFS_NUM_METADATA_CACHE_SECTORS; i < AFATFS_NUM_CACHE_SECTORS; i++) {
         if (!afatfs.cacheDescriptor[i].locked && (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_EMPTY || afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_IN_SYNC)) {
             result += AFATFS_SECTOR_SIZE;
         }
@@ -28,12 +28,14 @@
 #include "drivers/display.h"
 #include "drivers/display_canvas.h"
 #include "drivers/display_font_metadata.h"
+#include "drivers/display_list.h"
 #include "drivers/display_widgets.h"
 
 #include "io/displayport_frsky_osd.h"
 #include "io/frsky_osd.h"
 
 static displayPort_t frskyOSDDisplayPort;
+static displayList_t frskyOSDDisplayList;
 
 static int grab(displayPort_t *displayPort)
 {
@@ -51,6 +53,7 @@ static int clearScreen(displayPort_t *displayPort)
 {
     UNUSED(displayPort);
     frskyOSDClearScreen();
+    displayListInvalidate(&frskyOSDDisplayList);
     return 0;
 }
 
@@ -173,6 +176,7 @@ static void beginTransaction(displayPort_t *instance, displayTransactionOption_e
     }
     if (opts & DISPLAY_TRANSACTION_OPT_RESET_DRAWING) {
         frskyOpts |= FRSKY_OSD_TRANSACTION_OPT_RESET_DRAWING;
+        displayListResetDrawing(&frskyOSDDisplayList);
     }
 
     frskyOSDBeginTransaction(frskyOpts);
@@ -601,6 +605,8 @@ static bool getCanvas(displayCanvas_t *canvas, const displayPort_t *instance)
     canvas->vTable = &frskyOSDCanvasVTable;
     canvas->width = frskyOSDGetPixelWidth();
     canvas->height = frskyOSDGetPixelHeight();
+    // Every primitive is a command on the UART, only the widgets which changed are sent
+    displayListInit(&frskyOSDDisplayList, canvas);
     return true;
 }
 
@@ -144,8 +144,34 @@ void gpsSetProtocolTimeout(timeMs_t timeoutMs)
     gpsState.timeoutMs = timeoutMs;
 }
 
+static void gpsUpdateLatency(timeUs_t currentTimeUs)
+{
+    const timeDelta_t latencyUs = cmpTimeUs(currentTimeUs, gpsSol.arrivalTimeUs);
+
+    if (latencyUs < 0) {
+        return;
+    }
+
+    gpsStats.latencyUs = latencyUs;
+    gpsStats.latencyMaxUs = MAX(gpsStats.latencyMaxUs, gpsStats.latencyUs);
+
+    if (gpsStats.latencyAvgUs == 0) {
+        gpsStats.latencyAvgUs = latencyUs;
+    } else {
+        // Moving average over about 16 solutions
+        gpsStats.latencyAvgUs += (latencyUs - (int32_t)gpsStats.latencyAvgUs) / 16;
+    }
+}
+
 void gpsProcessNewSolutionData(void)
 {
+    const timeUs_t currentTimeUs = micros();
+
+    // Providers without a receive timestamp deliver solutions as they arrive
+    if (gpsSol.arrivalTimeUs == 0) {
+        gpsSol.arrivalTimeUs = currentTimeUs;
+    }
+
     // Set GPS fix flag only if we have 3D fix
     if (gpsSol.fixType == GPS_FIX_3D && gpsSol.numSat >= gpsConfig()->gpsMinSats) {
         ENABLE_STATE(GPS_FIX);
@@ -162,7 +188,9 @@ void gpsProcessNewSolutionData(void)
     sensorsSet(SENSOR_GPS);
 
     // Pass on GPS update to NAV and IMU
+    gpsUpdateLatency(currentTimeUs);
     onNewGPSData();
+    gpsSol.arrivalTimeUs = 0;
 
     // Update time
     gpsUpdateTime();
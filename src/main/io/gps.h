@@ -140,6 +140,8 @@ typedef struct gpsSolutionData_s {
 
     dateTime_t time; // GPS time in UTC
 
+    timeUs_t arrivalTimeUs; // Arrival of the first byte of the solution, 0 if the provider doesn't know
+
 } gpsSolutionData_t;
 
 typedef struct {
@@ -147,6 +149,9 @@ typedef struct {
     uint32_t    errors;                // gps error counter - crc error/lost of data/sync etc..
     uint32_t    timeouts;
     uint32_t    packetCount;
+    uint32_t    latencyUs;             // from the arrival of the last solution to the position estimator
+    uint32_t    latencyAvgUs;
+    uint32_t    latencyMaxUs;
 } gpsStatistics_t;
 
 extern gpsSolutionData_t gpsSol;
@@ -273,14 +273,21 @@ STATIC_PROTOTHREAD(gpsProtocolReceiverThread)
         ptWait(serialRxBytesWaiting(gpsState.gpsPort));
 
         // Consume bytes until buffer empty of until we have full message received
-        while (serialRxBytesWaiting(gpsState.gpsPort)) {
-            uint8_t newChar = serialRead(gpsState.gpsPort);
-            if (gpsNewFrameNMEA(newChar)) {
-                gpsSol.flags.validVelNE = false;
-                gpsSol.flags.validVelD = false;
-                ptSemaphoreSignal(semNewDataReady);
-                break;
+        const uint8_t *data;
+        uint32_t count;
+        bool newFrame = false;
+        while (!newFrame && (count = serialRxPeek(gpsState.gpsPort, &data)) > 0) {
+            uint32_t processed = 0;
+            while (processed < count && !newFrame) {
+                newFrame = gpsNewFrameNMEA(data[processed++]);
             }
+            serialRxConsume(gpsState.gpsPort, processed);
+        }
+
+        if (newFrame) {
+            gpsSol.flags.validVelNE = false;
+            gpsSol.flags.validVelD = false;
+            ptSemaphoreSignal(semNewDataReady);
         }
     }
 
@@ -368,6 +368,12 @@ static bool _new_position;
 // do we have new speed information?
 static bool _new_speed;
 
+// Arrival of the bytes being parsed, of the frame being received and of the first NAV frame of the next solution
+static timeUs_t _rx_time_us;
+static timeUs_t _frame_start_us;
+static timeUs_t _solution_start_us;
+static bool _solution_started;
+
 // Need this to determine if Galileo capable only
 static bool capGalileo;
 
@@ -720,6 +726,8 @@ static bool gpsParceFrameUBLOX(void)
     // this ensures we don't use stale data
     if (_new_position && _new_speed) {
         _new_speed = _new_position = false;
+        gpsSol.arrivalTimeUs = _solution_start_us;
+        _solution_started = false;
         return true;
     }
 
@@ -734,6 +742,7 @@ static bool gpsNewFrameUBLOX(uint8_t data)
         case 0: // Sync char 1 (0xB5)
             if (PREAMBLE1 == data) {
                 _skip_packet = false;
+                _frame_start_us = _rx_time_us;
                 _step++;
             }
             break;
@@ -808,6 +817,12 @@ static bool gpsNewFrameUBLOX(uint8_t data)
                 break;
             }
 
+            // The solution starts with the first NAV message of an epoch
+            if (_class == CLASS_NAV && !_solution_started) {
+                _solution_start_us = _frame_start_us;
+                _solution_started = true;
+            }
+
             if (gpsParceFrameUBLOX()) {
                 parsed = true;
             }
@@ -973,6 +988,27 @@ STATIC_PROTOTHREAD(gpsConfigure)
 
 static ptSemaphore_t semNewDataReady;
 
+// Consumes bytes until the buffer is empty or a solution is complete
+static bool gpsReceiveUBLOX(void)
+{
+    const uint8_t *data;
+    uint32_t count;
+    bool newSolution = false;
+
+    while (!newSolution && (count = serialRxPeek(gpsState.gpsPort, &data)) > 0) {
+        // The driver only knows when the oldest byte in the buffer arrived, the others came after it
+        _rx_time_us = gpsState.gpsPort->rxBufferFirstByteUs;
+
+        uint32_t processed = 0;
+        while (processed < count && !newSolution) {
+            newSolution = gpsNewFrameUBLOX(data[processed++]);
+        }
+        serialRxConsume(gpsState.gpsPort, processed);
+    }
+
+    return newSolution;
+}
+
 STATIC_PROTOTHREAD(gpsProtocolReceiverThread)
 {
     ptBegin(gpsProtocolReceiverThread);
@@ -981,13 +1017,10 @@ STATIC_PROTOTHREAD(gpsProtocolReceiverThread)
         // Wait until there are bytes to consume
         ptWait(serialRxBytesWaiting(gpsState.gpsPort));
 
-        // Consume bytes until buffer empty of until we have full message received
-        while (serialRxBytesWaiting(gpsState.gpsPort)) {
-            uint8_t newChar = serialRead(gpsState.gpsPort);
-            if (gpsNewFrameUBLOX(newChar)) {
-                ptSemaphoreSignal(semNewDataReady);
-                break;
-            }
+        if (gpsReceiveUBLOX()) {
+            // Let the state thread process the solution before the next one overwrites it
+            ptSemaphoreSignal(semNewDataReady);
+            ptYield();
         }
     }
 
@@ -1060,6 +1093,7 @@ STATIC_PROTOTHREAD(gpsProtocolStateThread)
 
 void gpsRestartUBLOX(void)
 {
+    _solution_started = false;
     ptSemaphoreInit(semNewDataReady);
     ptRestart(ptGetHandle(gpsProtocolReceiverThread));
     ptRestart(ptGetHandle(gpsProtocolStateThread));
@@ -1067,9 +1101,11 @@ void gpsRestartUBLOX(void)
 
 void gpsHandleUBLOX(void)
 {
-    // Run the protocol threads
-    gpsProtocolReceiverThread();
-    gpsProtocolStateThread();
+    // Run the protocol threads until everything received is parsed, the receiver stops at each complete solution
+    do {
+        gpsProtocolReceiverThread();
+        gpsProtocolStateThread();
+    } while (!semNewDataReady && serialRxBytesWaiting(gpsState.gpsPort));
 
     // If thread stopped - signal communication loss and restart
     if (ptIsStopped(ptGetHandle(gpsProtocolReceiverThread)) || ptIsStopped(ptGetHandle(gpsProtocolStateThread))) {
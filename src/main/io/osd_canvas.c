@@ -46,6 +46,7 @@
 
 #include "drivers/display.h"
 #include "drivers/display_canvas.h"
+#include "drivers/display_list.h"
 #include "drivers/display_widgets.h"
 #include "drivers/osd.h"
 #include "drivers/osd_symbols.h"
@@ -58,6 +59,17 @@
 
 #define OSD_CANVAS_VARIO_ARROWS_PER_SLOT 2.0f
 
+// Widgets drawn with primitives, only sent again when they change
+typedef enum {
+    OSD_CANVAS_GROUP_VARIO,
+    OSD_CANVAS_GROUP_DIR_ARROW,
+    OSD_CANVAS_GROUP_ARTIFICIAL_HORIZON,
+    OSD_CANVAS_GROUP_HEADING_GRAPH,
+    OSD_CANVAS_GROUP_COUNT,
+} osdCanvasGroup_e;
+
+STATIC_ASSERT(OSD_CANVAS_GROUP_COUNT <= DISPLAY_LIST_MAX_GROUPS, too_many_osd_canvas_groups);
+
 static void osdCanvasVarioRect(int *y, int *h, displayCanvas_t *canvas, int midY, float zvel)
 {
     int maxHeight = ceilf(OSD_VARIO_HEIGHT_ROWS /OSD_CANVAS_VARIO_ARROWS_PER_SLOT) * canvas->gridElementHeight;
@@ -96,6 +108,8 @@ void osdCanvasDrawVario(displayPort_t *display, displayCanvas_t *canvas, const o
     int y;
     int h;
 
+    displayCanvasBeginGroup(canvas, OSD_CANVAS_GROUP_VARIO);
+
     osdCanvasVarioRect(&y, &h, canvas, midY, zvel);
 
     if (signbit(prev) != signbit(zvel) || fabsf(prev) > fabsf(zvel)) {
@@ -117,6 +131,8 @@ void osdCanvasDrawVario(displayPort_t *display, displayCanvas_t *canvas, const o
             displayCanvasDrawCharacter(canvas, x, yy, SYM_VARIO_DOWN_2A, DISPLAY_CANVAS_BITMAP_OPT_ERASE_TRANSPARENT);
         }
     }
+
+    displayCanvasEndGroup(canvas);
     prev = zvel;
 }
 
@@ -138,6 +154,8 @@ void osdCanvasDrawDirArrow(displayPort_t *display, displayCanvas_t *canvas, cons
     int py;
     osdDrawPointGetPixels(&px, &py, display, canvas, p);
 
+    displayCanvasBeginGroup(canvas, OSD_CANVAS_GROUP_DIR_ARROW);
+
     displayCanvasClearRect(canvas, px - overflow, py, canvas->gridElementWidth + overflow * 2, canvas->gridElementHeight);
 
     displayCanvasSetFillColor(canvas, DISPLAY_CANVAS_COLOR_WHITE);
@@ -155,6 +173,8 @@ void osdCanvasDrawDirArrow(displayPort_t *display, displayCanvas_t *canvas, cons
     displayCanvasMoveToPoint(canvas, -width, bottom - 1);
     displayCanvasStrokeLineToPoint(canvas, 0, topInset);
     displayCanvasStrokeLineToPoint(canvas, width, bottom - 1);
+
+    displayCanvasEndGroup(canvas);
 }
 
 static void osdDrawArtificialHorizonLevelLine(displayCanvas_t *canvas, int width, int pos, int margin)
@@ -412,7 +432,13 @@ void osdCanvasDrawArtificialHorizon(displayPort_t *display, displayCanvas_t *can
     float totalError = fabsf(prevPitchAngle - pitchAngle) + fabsf(prevRollAngle - rollAngle);
     if ((now > nextDrawMinMs && totalError > 0.05f)|| now > nextDrawMaxMs) {
 
+        if (now > nextDrawMaxMs) {
+            // Periodic redraw, repairs whatever was drawn over the AHI
+            displayCanvasInvalidateGroup(canvas, OSD_CANVAS_GROUP_ARTIFICIAL_HORIZON);
+        }
+
         if (!osdCanvasDrawArtificialHorizonWidget(display, canvas, p, pitchAngle, rollAngle)) {
+            displayCanvasBeginGroup(canvas, OSD_CANVAS_GROUP_ARTIFICIAL_HORIZON);
             switch ((osd_ahi_style_e)osdConfig()->ahi_style) {
                 case OSD_AHI_STYLE_DEFAULT:
                 {
@@ -427,6 +453,7 @@ void osdCanvasDrawArtificialHorizon(displayPort_t *display, displayCanvas_t *can
                     osdDrawArtificialHorizonLine(canvas, pitchAngle, rollAngle, false);
                     break;
             }
+            displayCanvasEndGroup(canvas);
         }
 
         prevPitchAngle = pitchAngle;
@@ -477,6 +504,8 @@ void osdCanvasDrawHeadingGraph(displayPort_t *display, displayCanvas_t *canvas,
     int rw = OSD_HEADING_GRAPH_WIDTH * canvas->gridElementWidth;
     int rh = canvas->gridElementHeight;
 
+    displayCanvasBeginGroup(canvas, OSD_CANVAS_GROUP_HEADING_GRAPH);
+
     displayCanvasClipToRect(canvas, px, py, rw, rh);
 
     int idx = heading / OSD_HEADING_GRAPH_DECIDEGREES_PER_CHAR;
@@ -493,6 +522,8 @@ void osdCanvasDrawHeadingGraph(displayPort_t *display, displayCanvas_t *canvas,
     displayCanvasSetFillColor(canvas, DISPLAY_CANVAS_COLOR_WHITE);
     int rmx = px + rw / 2;
     displayCanvasFillStrokeTriangle(canvas, rmx - 2, py - 1, rmx + 2, py - 1, rmx, py + 1);
+
+    displayCanvasEndGroup(canvas);
 }
 
 static int32_t osdCanvasSidebarGetValue(osd_sidebar_scroll_e scroll)
@@ -22,11 +22,17 @@
 #include "build/debug.h"
 #include "drivers/serial.h"
 #include "drivers/serial_softserial.h"
+#if defined(SITL_BUILD)
+#include "drivers/serial_tcp.h"
+#endif
 
 #include "fc/fc_init.h"
 
 #include "scheduler/scheduler.h"
 
+// Built as a vehicle module the fleet host runs the main loop, see target/SITL/vehicle.c
+#if !defined(SITL_VEHICLE)
+
 #ifdef SOFTSERIAL_LOOPBACK
 serialPort_t *loopbackPort;
 #endif
@@ -67,5 +73,11 @@ int main(void)
     while (true) {
         scheduler();
         processLoopback();
+#if defined(SITL_BUILD)
+        // Everything the pass wrote goes out together
+        tcpFlushAll();
+#endif
     }
 }
+
+#endif
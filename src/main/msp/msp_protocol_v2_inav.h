@@ -89,3 +89,8 @@
 #define MSP2_INAV_LED_STRIP_CONFIG_EX           0x2048
 #define MSP2_INAV_SET_LED_STRIP_CONFIG_EX       0x2049
 
+#define MSP2_INAV_TRACE                         0x2050
+#define MSP2_INAV_RX_LATENCY                    0x2051
+#define MSP2_INAV_GYRO_SPECTRUM                 0x2052
+#define MSP2_INAV_SET_GYRO_SPECTRUM             0x2053
+
@@ -469,14 +469,22 @@ void mspSerialProcessOnePort(mspPort_t * const mspPort, mspEvaluateNonMspData_e
         mspPort->pendingRequest = MSP_PENDING_NONE;
 
         // Process incoming bytes
-        while (serialRxBytesWaiting(mspPort->port)) {
-            const uint8_t c = serialRead(mspPort->port);
-            const bool consumed = mspSerialProcessReceivedData(mspPort, c);
+        const uint8_t *data;
+        uint32_t count;
+        while ((count = serialRxPeek(mspPort->port, &data)) > 0) {
+            uint32_t processed = 0;
 
-            if (!consumed && evaluateNonMspData == MSP_EVALUATE_NON_MSP_DATA) {
-                mspEvaluateNonMspData(mspPort, c);
+            while (processed < count && mspPort->c_state != MSP_COMMAND_RECEIVED) {
+                const uint8_t c = data[processed++];
+                const bool consumed = mspSerialProcessReceivedData(mspPort, c);
+
+                if (!consumed && evaluateNonMspData == MSP_EVALUATE_NON_MSP_DATA) {
+                    mspEvaluateNonMspData(mspPort, c);
+                }
             }
 
+            serialRxConsume(mspPort->port, processed);
+
             if (mspPort->c_state == MSP_COMMAND_RECEIVED) {
                 mspPostProcessFn = mspSerialProcessReceivedCommand(mspPort, mspProcessCommandFn);
                 break; // process one command at a time so as not to block.
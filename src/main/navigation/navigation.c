@@ -99,7 +99,7 @@ STATIC_ASSERT(NAV_MAX_WAYPOINTS < 254, NAV_MAX_WAYPOINTS_exceeded_allowable_rang
 PG_REGISTER_ARRAY(navWaypoint_t, NAV_MAX_WAYPOINTS, nonVolatileWaypointList, PG_WAYPOINT_MISSION_STORAGE, 2);
 #endif
 
-PG_REGISTER_WITH_RESET_TEMPLATE(navConfig_t, navConfig, PG_NAV_CONFIG, 3);
+PG_REGISTER_WITH_RESET_TEMPLATE(navConfig_t, navConfig, PG_NAV_CONFIG, 4);
 
 PG_RESET_TEMPLATE(navConfig_t, navConfig,
     .general = {
@@ -154,6 +154,7 @@ PG_RESET_TEMPLATE(navConfig_t, navConfig,
         .waypoint_enforce_altitude = SETTING_NAV_WP_ENFORCE_ALTITUDE_DEFAULT,                   // Forces set wp altitude to be achieved
         .land_detect_sensitivity = SETTING_NAV_LAND_DETECT_SENSITIVITY_DEFAULT,                 // Changes sensitivity of landing detection
         .auto_disarm_delay = SETTING_NAV_AUTO_DISARM_DELAY_DEFAULT,                             // 2000 ms - time delay to disarm when auto disarm after landing enabled
+        .loop_hz = SETTING_NAV_LOOP_HZ_DEFAULT,                                                 // Rate of the position estimator and navigation controllers
     },
 
     // MC-specific
@@ -3566,6 +3567,64 @@ void applyWaypointNavigationAndAltitudeHold(void)
     navTargetPosition[Z] = lrintf(posControl.desiredState.pos.z);
 }
 
+/*-----------------------------------------------------------
+ * Navigation controllers run from their own task at a lower rate than the PID loop. The PID loop publishes
+ * the pilot's rcCommand, the controllers run against that and publish the axes they took over through a
+ * double buffer which the PID loop only reads.
+ *-----------------------------------------------------------*/
+typedef struct navControllerOutput_s {
+    int16_t rcCommand[4];
+    uint8_t rcCommandMask;      // Bit per rcCommand axis written by the controllers
+} navControllerOutput_t;
+
+static navControllerOutput_t navControllerOutput[2];
+static volatile uint8_t navControllerOutputIndex;
+static int16_t navPilotRcCommand[4];
+
+static uint8_t navRcCommandWrittenMask;
+
+// Controllers set their rcCommand output through here, only the axes written in a cycle are taken over from the sticks
+void navSetRcCommand(uint8_t axis, int16_t value)
+{
+    rcCommand[axis] = value;
+    navRcCommandWrittenMask |= (1 << axis);
+}
+
+void updateNavigationControllers(void)
+{
+    int16_t loopRcCommand[4];
+
+    // Controllers read rcCommand directly, let them work on the pilot input seen by the PID loop
+    memcpy(loopRcCommand, rcCommand, sizeof(loopRcCommand));
+    memcpy(rcCommand, navPilotRcCommand, sizeof(navPilotRcCommand));
+    navRcCommandWrittenMask = 0;
+
+    applyWaypointNavigationAndAltitudeHold();
+
+    navControllerOutput_t *output = &navControllerOutput[navControllerOutputIndex ^ 1];
+    memcpy(output->rcCommand, rcCommand, sizeof(output->rcCommand));
+    output->rcCommandMask = ARMING_FLAG(ARMED) ? navRcCommandWrittenMask : 0;
+    navControllerOutputIndex ^= 1;
+
+    memcpy(rcCommand, loopRcCommand, sizeof(loopRcCommand));
+}
+
+void applyNavigationControllerOutput(void)
+{
+    memcpy(navPilotRcCommand, rcCommand, sizeof(navPilotRcCommand));
+
+    if (!ARMING_FLAG(ARMED) || posControl.navState == NAV_STATE_IDLE) {
+        return;
+    }
+
+    const navControllerOutput_t *output = &navControllerOutput[navControllerOutputIndex];
+    for (int axis = 0; axis < 4; axis++) {
+        if (output->rcCommandMask & (1 << axis)) {
+            rcCommand[axis] = output->rcCommand[axis];
+        }
+    }
+}
+
 /*-----------------------------------------------------------
  * Set CF's FLIGHT_MODE from current NAV_MODE
  *-----------------------------------------------------------*/
@@ -112,6 +112,11 @@ typedef enum {
     NAV_RESET_ON_EACH_ARM,
 } nav_reset_type_e;
 
+typedef enum {
+    NAV_ESTIMATOR_COMPLEMENTARY = 0,
+    NAV_ESTIMATOR_EKF,
+} navEstimatorType_e;
+
 typedef enum {
     NAV_RTH_ALLOW_LANDING_NEVER = 0,
     NAV_RTH_ALLOW_LANDING_ALWAYS = 1,
@@ -209,6 +214,10 @@ typedef struct positionEstimationConfig_s {
     float baro_epv;     // Baro position error
 
     uint8_t use_gps_no_baro;
+
+    uint8_t estimator_type;     // navEstimatorType_e
+    float ekf_acc_noise;        // Acceleration noise assumed by the EKF (cm/s/s)
+    uint16_t ekf_gps_delay;     // GPS measurement to arrival of its solution (ms)
 } positionEstimationConfig_t;
 
 PG_DECLARE(positionEstimationConfig_t, positionEstimationConfig);
@@ -265,6 +274,7 @@ typedef struct navConfig_s {
         uint16_t waypoint_enforce_altitude;         // Forces waypoint altitude to be achieved
         uint8_t  land_detect_sensitivity;           // Sensitivity of landing detector
         uint16_t auto_disarm_delay;                 // safety time delay for landing detector
+        uint16_t loop_hz;                           // Rate of the navigation task
     } general;
 
     struct {
@@ -488,6 +498,8 @@ void updatePositionEstimator_PitotTopic(timeUs_t currentTimeUs);
 void updateWaypointsAndNavigationMode(void);
 void updatePositionEstimator(void);
 void applyWaypointNavigationAndAltitudeHold(void);
+void updateNavigationControllers(void);
+void applyNavigationControllerOutput(void);
 
 /* Functions to signal navigation requirements to main loop */
 bool navigationRequiresAngleMode(void);
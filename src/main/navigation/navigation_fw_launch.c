@@ -242,11 +242,11 @@ static bool isThrottleIdleEnabled(void)
 static void applyThrottleIdleLogic(bool forceMixerIdle)
 {
     if (isThrottleIdleEnabled() && !forceMixerIdle) {
-        rcCommand[THROTTLE] = currentBatteryProfile->nav.fw.launch_idle_throttle;
+        navSetRcCommand(THROTTLE, currentBatteryProfile->nav.fw.launch_idle_throttle);
     }
     else {
         ENABLE_STATE(NAV_MOTOR_STOP_OR_IDLE);           // If MOTOR_STOP is enabled mixer will keep motor stopped
-        rcCommand[THROTTLE] = getThrottleIdleValue();   // If MOTOR_STOP is disabled, motors will spin given throttle value
+        navSetRcCommand(THROTTLE, getThrottleIdleValue());   // If MOTOR_STOP is disabled, motors will spin given throttle value
     }
 }
 
@@ -278,12 +278,12 @@ static void resetPidsIfNeeded(void) {
 static void updateRcCommand(void)
 {
     // lock roll and yaw and apply needed pitch angle
-    rcCommand[ROLL] = 0;
-    rcCommand[PITCH] = pidAngleToRcCommand(-DEGREES_TO_DECIDEGREES(fwLaunch.pitchAngle), pidProfile()->max_angle_inclination[FD_PITCH]);
+    navSetRcCommand(ROLL, 0);
+    navSetRcCommand(PITCH, pidAngleToRcCommand(-DEGREES_TO_DECIDEGREES(fwLaunch.pitchAngle), pidProfile()->max_angle_inclination[FD_PITCH]));
     //pidProfile()->max_angle_inclination[FD_PITCH] 返回的是一个值 pidProfile_ProfileCurrent
     //PG_DECLARE_PROFILE(pidProfile_t, pidProfile);
     //extern _type *_name ## _ProfileCurrent; --> extern pidProfile_t pidProfile_ProfileCurrent
-    rcCommand[YAW] = 0;
+    navSetRcCommand(YAW, 0);
 }
 
 /* onEntry state handlers */
@@ -340,7 +340,7 @@ static fixedWingLaunchEvent_t fwLaunchState_FW_LAUNCH_STATE_MOTOR_IDLE(timeUs_t
         return FW_LAUNCH_EVENT_SUCCESS;
     }
     else {
-        rcCommand[THROTTLE] = scaleRangef(elapsedTimeMs, 0.0f, LAUNCH_MOTOR_IDLE_SPINUP_TIME, getThrottleIdleValue(), currentBatteryProfile->nav.fw.launch_idle_throttle);
+        navSetRcCommand(THROTTLE, scaleRangef(elapsedTimeMs, 0.0f, LAUNCH_MOTOR_IDLE_SPINUP_TIME, getThrottleIdleValue(), currentBatteryProfile->nav.fw.launch_idle_throttle));
         fwLaunch.pitchAngle = scaleRangef(elapsedTimeMs, 0.0f, LAUNCH_MOTOR_IDLE_SPINUP_TIME, 0, navConfig()->fw.launch_climb_angle);
     }
 
@@ -410,12 +410,12 @@ static fixedWingLaunchEvent_t fwLaunchState_FW_LAUNCH_STATE_MOTOR_SPINUP(timeUs_
     const uint16_t launchThrottle = constrain(currentBatteryProfile->nav.fw.launch_throttle, getThrottleIdleValue(), motorConfig()->maxthrottle);
 
     if (elapsedTimeMs > motorSpinUpMs) {
-        rcCommand[THROTTLE] = launchThrottle;
+        navSetRcCommand(THROTTLE, launchThrottle);
         return FW_LAUNCH_EVENT_SUCCESS;
     }
     else {
         const uint16_t minIdleThrottle = MAX(getThrottleIdleValue(), currentBatteryProfile->nav.fw.launch_idle_throttle);
-        rcCommand[THROTTLE] = scaleRangef(elapsedTimeMs, 0.0f, motorSpinUpMs,  minIdleThrottle, launchThrottle);
+        navSetRcCommand(THROTTLE, scaleRangef(elapsedTimeMs, 0.0f, motorSpinUpMs,  minIdleThrottle, launchThrottle));
     }
 
     return FW_LAUNCH_EVENT_NONE;
@@ -441,7 +441,7 @@ static fixedWingLaunchEvent_t fwLaunchState_FW_LAUNCH_STATE_IN_PROGRESS(timeUs_t
         }
     } else {
         initialTime = navConfig()->fw.launch_motor_timer + navConfig()->fw.launch_motor_spinup_time;
-        rcCommand[THROTTLE] = constrain(currentBatteryProfile->nav.fw.launch_throttle, getThrottleIdleValue(), motorConfig()->maxthrottle);
+        navSetRcCommand(THROTTLE, constrain(currentBatteryProfile->nav.fw.launch_throttle, getThrottleIdleValue(), motorConfig()->maxthrottle));
     }
 
     if (isLaunchMaxAltitudeReached()) {
@@ -472,7 +472,7 @@ static fixedWingLaunchEvent_t fwLaunchState_FW_LAUNCH_STATE_FINISH(timeUs_t curr
         // Do the same for throttle when manual launch throttle isn't used
         if (!navConfig()->fw.launch_manual_throttle) {
             const uint16_t launchThrottle = constrain(currentBatteryProfile->nav.fw.launch_throttle, getThrottleIdleValue(), motorConfig()->maxthrottle);
-            rcCommand[THROTTLE] = scaleRangef(elapsedTimeMs, 0.0f, endTimeMs, launchThrottle, rcCommand[THROTTLE]);
+            navSetRcCommand(THROTTLE, scaleRangef(elapsedTimeMs, 0.0f, endTimeMs, launchThrottle, rcCommand[THROTTLE]));
         }
         fwLaunch.pitchAngle = scaleRangef(elapsedTimeMs, 0.0f, endTimeMs, navConfig()->fw.launch_climb_angle, rcCommand[PITCH]);
     }
@@ -277,7 +277,7 @@ static void applyMulticopterAltitudeController(timeUs_t currentTimeUs)
     }
 
     // Update throttle controller
-    rcCommand[THROTTLE] = posControl.rcAdjustment[THROTTLE];
+    navSetRcCommand(THROTTLE, posControl.rcAdjustment[THROTTLE]);
 
     // Save processed throttle for future use
     rcCommandAdjustedThrottle = rcCommand[THROTTLE];
@@ -704,8 +704,8 @@ static void applyMulticopterPositionController(timeUs_t currentTimeUs)
     }
 
     if (!bypassPositionController) {
-        rcCommand[PITCH] = pidAngleToRcCommand(posControl.rcAdjustment[PITCH], pidProfile()->max_angle_inclination[FD_PITCH]);
-        rcCommand[ROLL] = pidAngleToRcCommand(posControl.rcAdjustment[ROLL], pidProfile()->max_angle_inclination[FD_ROLL]);
+        navSetRcCommand(PITCH, pidAngleToRcCommand(posControl.rcAdjustment[PITCH], pidProfile()->max_angle_inclination[FD_PITCH]));
+        navSetRcCommand(ROLL, pidAngleToRcCommand(posControl.rcAdjustment[ROLL], pidProfile()->max_angle_inclination[FD_ROLL]));
     }
 }
 
@@ -821,15 +821,15 @@ static void applyMulticopterEmergencyLandingController(timeUs_t currentTimeUs)
     static timeUs_t previousTimePositionUpdate = 0;
 
     /* Attempt to stabilise */
-    rcCommand[YAW] = 0;
+    navSetRcCommand(YAW, 0);
 
     if ((posControl.flags.estAltStatus < EST_USABLE)) {
         /* Sensors has gone haywire, attempt to land regardless */
         if (failsafeConfig()->failsafe_procedure == FAILSAFE_PROCEDURE_DROP_IT) {
-            rcCommand[THROTTLE] = getThrottleIdleValue();
+            navSetRcCommand(THROTTLE, getThrottleIdleValue());
         }
         else {
-            rcCommand[THROTTLE] = currentBatteryProfile->failsafe_throttle;
+            navSetRcCommand(THROTTLE, currentBatteryProfile->failsafe_throttle);
         }
 
         return;
@@ -856,14 +856,14 @@ static void applyMulticopterEmergencyLandingController(timeUs_t currentTimeUs)
     }
 
     // Update throttle controller
-    rcCommand[THROTTLE] = posControl.rcAdjustment[THROTTLE];
+    navSetRcCommand(THROTTLE, posControl.rcAdjustment[THROTTLE]);
 
     // Hold position if possible
     if ((posControl.flags.estPosStatus >= EST_USABLE)) {
         applyMulticopterPositionController(currentTimeUs);
     } else {
-        rcCommand[ROLL] = 0;
-        rcCommand[PITCH] = 0;
+        navSetRcCommand(ROLL, 0);
+        navSetRcCommand(PITCH, 0);
     }
 }
 
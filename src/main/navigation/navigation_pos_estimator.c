@@ -55,7 +55,7 @@
 
 navigationPosEstimator_t posEstimator;
 
-PG_REGISTER_WITH_RESET_TEMPLATE(positionEstimationConfig_t, positionEstimationConfig, PG_POSITION_ESTIMATION_CONFIG, 5);
+PG_REGISTER_WITH_RESET_TEMPLATE(positionEstimationConfig_t, positionEstimationConfig, PG_POSITION_ESTIMATION_CONFIG, 6);
 
 PG_RESET_TEMPLATE(positionEstimationConfig_t, positionEstimationConfig,
         // Inertial position estimator parameters
@@ -91,7 +91,13 @@ PG_RESET_TEMPLATE(positionEstimationConfig_t, positionEstimationConfig,
         .w_acc_bias = SETTING_INAV_W_ACC_BIAS_DEFAULT,
 
         .max_eph_epv = SETTING_INAV_MAX_EPH_EPV_DEFAULT,
-        .baro_epv = SETTING_INAV_BARO_EPV_DEFAULT
+        .baro_epv = SETTING_INAV_BARO_EPV_DEFAULT,
+
+#if defined(USE_POS_ESTIMATOR_EKF)
+        .estimator_type = SETTING_INAV_ESTIMATOR_DEFAULT,
+        .ekf_acc_noise = SETTING_INAV_EKF_ACC_NOISE_DEFAULT,
+        .ekf_gps_delay = SETTING_INAV_EKF_GPS_DELAY_DEFAULT,
+#endif
 );
 
 #define resetTimer(tim, currentTimeUs) { (tim)->deltaTime = 0; (tim)->lastTriggeredTime = currentTimeUs; }
@@ -282,6 +288,7 @@ void onNewGPSData(void)
 
                 /* Indicate a last valid reading of Pos/Vel */
                 posEstimator.gps.lastUpdateTime = currentTimeUs;
+                posEstimator.gps.arrivalTime = gpsSol.arrivalTimeUs ? gpsSol.arrivalTimeUs : currentTimeUs;
             }
 
             previousLat = gpsSol.llh.lat;
@@ -317,6 +324,7 @@ void updatePositionEstimator_BaroTopic(timeUs_t currentTimeUs)
         const timeUs_t baroDtUs = currentTimeUs - posEstimator.baro.lastUpdateTime;
 
         posEstimator.baro.alt = newBaroAlt - initialBaroAltitudeOffset;
+        posEstimator.baro.rawAlt = posEstimator.baro.alt;
         posEstimator.baro.epv = positionEstimationConfig()->baro_epv;
         posEstimator.baro.lastUpdateTime = currentTimeUs;
 
@@ -553,6 +561,83 @@ static void estimationPredict(estimationContext_t * ctx)
     }
 }
 
+static void estimationUpdateHistory(const estimationContext_t * ctx, timeUs_t currentTimeUs)
+{
+    navPositionEstimatorHISTORY_t * history = &posEstimator.history;
+
+    vectorAdd(&history->posCorrSum, &history->posCorrSum, &ctx->estPosCorr);
+    vectorAdd(&history->velCorrSum, &history->velCorrSum, &ctx->estVelCorr);
+
+    const navPositionEstimatorHistorySample_t * newest = &history->samples[(history->head + INAV_HISTORY_SAMPLES - 1) % INAV_HISTORY_SAMPLES];
+    if (history->count > 0 && cmpTimeUs(currentTimeUs, newest->time) < INAV_HISTORY_INTERVAL_US) {
+        return;
+    }
+
+    navPositionEstimatorHistorySample_t * sample = &history->samples[history->head];
+    sample->time = currentTimeUs;
+    vectorSub(&sample->pos, &posEstimator.est.pos, &history->posCorrSum);
+    vectorSub(&sample->vel, &posEstimator.est.vel, &history->velCorrSum);
+
+    history->head = (history->head + 1) % INAV_HISTORY_SAMPLES;
+    history->count = MIN(history->count + 1, INAV_HISTORY_SAMPLES);
+}
+
+static void estimationResetHistory(void)
+{
+    memset(&posEstimator.history, 0, sizeof(posEstimator.history));
+}
+
+/*
+ * Moves the GPS measurement forward from its arrival to now by what the estimate predicted in between, comparing it
+ * to the current estimate then compares the measurement to the estimate at the time it was taken. Arrivals older than
+ * the history are moved forward by what the history covers.
+ */
+static void estimationCompensateGpsDelay(estimationContext_t * ctx, timeUs_t currentTimeUs)
+{
+    const navPositionEstimatorHISTORY_t * history = &posEstimator.history;
+
+    ctx->gpsPos = posEstimator.gps.pos;
+    ctx->gpsVel = posEstimator.gps.vel;
+
+    // The uncorrected estimate of now is the newer end of the first interval
+    fpVector3_t nowPos;
+    fpVector3_t nowVel;
+    vectorSub(&nowPos, &posEstimator.est.pos, &history->posCorrSum);
+    vectorSub(&nowVel, &posEstimator.est.vel, &history->velCorrSum);
+
+    timeUs_t newerTime = currentTimeUs;
+    fpVector3_t newerPos = nowPos;
+    fpVector3_t newerVel = nowVel;
+
+    for (int i = 1; i <= history->count; i++) {
+        const navPositionEstimatorHistorySample_t * older = &history->samples[(history->head + INAV_HISTORY_SAMPLES - i) % INAV_HISTORY_SAMPLES];
+
+        if (cmpTimeUs(posEstimator.gps.arrivalTime, older->time) >= 0 || i == history->count) {
+            const timeDelta_t intervalUs = cmpTimeUs(newerTime, older->time);
+            const float k = intervalUs > 0 ? constrainf((float)cmpTimeUs(posEstimator.gps.arrivalTime, older->time) / intervalUs, 0.0f, 1.0f) : 0.0f;
+
+            fpVector3_t pastPos;
+            fpVector3_t pastVel;
+            vectorSub(&pastPos, &newerPos, &older->pos);
+            vectorScale(&pastPos, &pastPos, k);
+            vectorAdd(&pastPos, &pastPos, &older->pos);
+            vectorSub(&pastVel, &newerVel, &older->vel);
+            vectorScale(&pastVel, &pastVel, k);
+            vectorAdd(&pastVel, &pastVel, &older->vel);
+
+            vectorSub(&nowPos, &nowPos, &pastPos);
+            vectorSub(&nowVel, &nowVel, &pastVel);
+            vectorAdd(&ctx->gpsPos, &ctx->gpsPos, &nowPos);
+            vectorAdd(&ctx->gpsVel, &ctx->gpsVel, &nowVel);
+            return;
+        }
+
+        newerTime = older->time;
+        newerPos = older->pos;
+        newerVel = older->vel;
+    }
+}
+
 static bool estimationCalculateCorrection_Z(estimationContext_t * ctx)
 {
     DEBUG_SET(DEBUG_ALTITUDE, 0, posEstimator.est.pos.z);       // Position estimate
@@ -596,7 +681,7 @@ static bool estimationCalculateCorrection_Z(estimationContext_t * ctx)
         // If GPS is available - also use GPS climb rate
         if (ctx->newFlags & EST_GPS_Z_VALID) {
             // Trust GPS velocity only if residual/error is less than 2.5 m/s, scale weight according to gaussian distribution
-            const float gpsRocResidual = posEstimator.gps.vel.z - posEstimator.est.vel.z;
+            const float gpsRocResidual = ctx->gpsVel.z - posEstimator.est.vel.z;
             const float gpsRocScaler = bellCurve(gpsRocResidual, 250.0f);
             ctx->estVelCorr.z += gpsRocResidual * positionEstimationConfig()->w_z_gps_v * gpsRocScaler * ctx->dt;
         }
@@ -614,17 +699,17 @@ static bool estimationCalculateCorrection_Z(estimationContext_t * ctx)
         // If baro is not available - use GPS Z for correction on a plane
         // Reset current estimate to GPS altitude if estimate not valid
         if (!(ctx->newFlags & EST_Z_VALID)) {
-            ctx->estPosCorr.z += posEstimator.gps.pos.z - posEstimator.est.pos.z;
-            ctx->estVelCorr.z += posEstimator.gps.vel.z - posEstimator.est.vel.z;
+            ctx->estPosCorr.z += ctx->gpsPos.z - posEstimator.est.pos.z;
+            ctx->estVelCorr.z += ctx->gpsVel.z - posEstimator.est.vel.z;
             ctx->newEPV = posEstimator.gps.epv;
         }
         else {
             // Altitude
-            const float gpsAltResudual = posEstimator.gps.pos.z - posEstimator.est.pos.z;
+            const float gpsAltResudual = ctx->gpsPos.z - posEstimator.est.pos.z;
 
             ctx->estPosCorr.z += gpsAltResudual * positionEstimationConfig()->w_z_gps_p * ctx->dt;
             ctx->estVelCorr.z += gpsAltResudual * sq(positionEstimationConfig()->w_z_gps_p) * ctx->dt;
-            ctx->estVelCorr.z += (posEstimator.gps.vel.z - posEstimator.est.vel.z) * positionEstimationConfig()->w_z_gps_v * ctx->dt;
+            ctx->estVelCorr.z += (ctx->gpsVel.z - posEstimator.est.vel.z) * positionEstimationConfig()->w_z_gps_v * ctx->dt;
             ctx->newEPV = updateEPE(posEstimator.est.epv, ctx->dt, MAX(posEstimator.gps.epv, gpsAltResudual), positionEstimationConfig()->w_z_gps_p);
 
             // Accelerometer bias
@@ -642,17 +727,17 @@ static bool estimationCalculateCorrection_XY_GPS(estimationContext_t * ctx)
     if (ctx->newFlags & EST_GPS_XY_VALID) {
         /* If GPS is valid and our estimate is NOT valid - reset it to GPS coordinates and velocity */
         if (!(ctx->newFlags & EST_XY_VALID)) {
-            ctx->estPosCorr.x += posEstimator.gps.pos.x - posEstimator.est.pos.x;
-            ctx->estPosCorr.y += posEstimator.gps.pos.y - posEstimator.est.pos.y;
-            ctx->estVelCorr.x += posEstimator.gps.vel.x - posEstimator.est.vel.x;
-            ctx->estVelCorr.y += posEstimator.gps.vel.y - posEstimator.est.vel.y;
+            ctx->estPosCorr.x += ctx->gpsPos.x - posEstimator.est.pos.x;
+            ctx->estPosCorr.y += ctx->gpsPos.y - posEstimator.est.pos.y;
+            ctx->estVelCorr.x += ctx->gpsVel.x - posEstimator.est.vel.x;
+            ctx->estVelCorr.y += ctx->gpsVel.y - posEstimator.est.vel.y;
             ctx->newEPH = posEstimator.gps.eph;
         }
         else {
-            const float gpsPosXResidual = posEstimator.gps.pos.x - posEstimator.est.pos.x;
-            const float gpsPosYResidual = posEstimator.gps.pos.y - posEstimator.est.pos.y;
-            const float gpsVelXResidual = posEstimator.gps.vel.x - posEstimator.est.vel.x;
-            const float gpsVelYResidual = posEstimator.gps.vel.y - posEstimator.est.vel.y;
+            const float gpsPosXResidual = ctx->gpsPos.x - posEstimator.est.pos.x;
+            const float gpsPosYResidual = ctx->gpsPos.y - posEstimator.est.pos.y;
+            const float gpsVelXResidual = ctx->gpsVel.x - posEstimator.est.vel.x;
+            const float gpsVelYResidual = ctx->gpsVel.y - posEstimator.est.vel.y;
             const float gpsPosResidualMag = calc_length_pythagorean_2D(gpsPosXResidual, gpsPosYResidual);
 
             //const float gpsWeightScaler = scaleRangef(bellCurve(gpsPosResidualMag, INAV_GPS_ACCEPTANCE_EPE), 0.0f, 1.0f, 0.1f, 1.0f);
@@ -701,6 +786,85 @@ static void estimationCalculateGroundCourse(timeUs_t currentTimeUs)
     }
 }
 
+#if defined(USE_POS_ESTIMATOR_EKF)
+/*
+ * Hands new GPS and baro readings to the EKF with the time they were taken and takes the estimate of now from it,
+ * in place of the prediction and corrections of the complementary filter. The baro goes in without averaging, the
+ * filter weighs it by baro_epv.
+ */
+static void estimationUpdateEkf(estimationContext_t * ctx, timeUs_t currentTimeUs)
+{
+    navPositionEstimatorEKF_t * ekf = &posEstimator.ekf;
+
+    if (!ekf->active) {
+        posEkfInit(&ekf->filter, positionEstimationConfig()->ekf_acc_noise, INAV_EKF_BIAS_NOISE);
+        ekf->gpsUpdateTime = posEstimator.gps.lastUpdateTime;
+        ekf->baroUpdateTime = posEstimator.baro.lastUpdateTime;
+        ekf->active = true;
+    }
+
+    const bool useBaro = ctx->newFlags & EST_BARO_VALID;
+
+    if ((ctx->newFlags & EST_GPS_XY_VALID) && posEstimator.gps.lastUpdateTime != ekf->gpsUpdateTime) {
+        // The arrival is the first byte of the solution, the receiver measured before it worked the solution out
+        const timeUs_t gpsTime = posEstimator.gps.arrivalTime - MS2US(positionEstimationConfig()->ekf_gps_delay);
+        const float velVariance = sq(MAX(posEstimator.gps.eph / 4, INAV_EKF_GPS_MIN_VEL_STD));
+
+        for (int axis = X; axis <= Y; axis++) {
+            posEkfAddMeasurement(&ekf->filter, gpsTime, axis, POS_EKF_POS, posEstimator.gps.pos.v[axis], sq(posEstimator.gps.eph));
+            posEkfAddMeasurement(&ekf->filter, gpsTime, axis, POS_EKF_VEL, posEstimator.gps.vel.v[axis], velVariance);
+        }
+
+        if (ctx->newFlags & EST_GPS_Z_VALID) {
+            // Same choice of altitude source as the complementary filter
+            if (!useBaro && (STATE(FIXED_WING_LEGACY) || positionEstimationConfig()->use_gps_no_baro)) {
+                posEkfAddMeasurement(&ekf->filter, gpsTime, Z, POS_EKF_POS, posEstimator.gps.pos.z, sq(posEstimator.gps.epv));
+            }
+            posEkfAddMeasurement(&ekf->filter, gpsTime, Z, POS_EKF_VEL, posEstimator.gps.vel.z, sq(MAX(posEstimator.gps.epv / 4, INAV_EKF_GPS_MIN_VEL_STD)));
+        }
+    }
+    ekf->gpsUpdateTime = posEstimator.gps.lastUpdateTime;
+
+    if (useBaro && posEstimator.baro.lastUpdateTime != ekf->baroUpdateTime) {
+        posEkfAddMeasurement(&ekf->filter, posEstimator.baro.lastUpdateTime, Z, POS_EKF_POS, posEstimator.baro.rawAlt, sq(posEstimator.baro.epv));
+    }
+    ekf->baroUpdateTime = posEstimator.baro.lastUpdateTime;
+
+    fpVector3_t accelNEU;
+    vectorScale(&accelNEU, &posEstimator.imu.accelNEU, navGetAccelerometerWeight());
+    if (!navIsHeadingUsable()) {
+        accelNEU.x = 0.0f;
+        accelNEU.y = 0.0f;
+    }
+
+    posEkfUpdate(&ekf->filter, currentTimeUs, &accelNEU);
+
+    for (int axis = X; axis <= Z; axis++) {
+        if (posEkfIsAxisValid(&ekf->filter, axis)) {
+            posEstimator.est.pos.v[axis] = ekf->filter.pos.v[axis];
+            posEstimator.est.vel.v[axis] = ekf->filter.vel.v[axis];
+        }
+        else {
+            posEstimator.est.vel.v[axis] = 0.0f;
+        }
+    }
+
+    if (posEkfIsAxisValid(&ekf->filter, X) && posEkfIsAxisValid(&ekf->filter, Y)) {
+        ctx->newEPH = sqrtf(MAX(ekf->filter.posVariance[X], ekf->filter.posVariance[Y]));
+    }
+    else {
+        ctx->newEPH = positionEstimationConfig()->max_eph_epv + 0.001f;
+    }
+
+    if (posEkfIsAxisValid(&ekf->filter, Z)) {
+        ctx->newEPV = sqrtf(ekf->filter.posVariance[Z]);
+    }
+    else {
+        ctx->newEPV = positionEstimationConfig()->max_eph_epv + 0.001f;
+    }
+}
+#endif
+
 /**
  * Calculate next estimate using IMU and apply corrections from reference sensors (GPS, BARO etc)
  *  Function is called at main loop rate
@@ -718,6 +882,10 @@ static void updateEstimatedTopic(timeUs_t currentTimeUs)
         posEstimator.est.eph = positionEstimationConfig()->max_eph_epv + 0.001f;
         posEstimator.est.epv = positionEstimationConfig()->max_eph_epv + 0.001f;
         posEstimator.flags = 0;
+        estimationResetHistory();
+#if defined(USE_POS_ESTIMATOR_EKF)
+        posEstimator.ekf.active = false;
+#endif
         return;
     }
 
@@ -732,9 +900,30 @@ static void updateEstimatedTopic(timeUs_t currentTimeUs)
     /* AGL estimation - separate process, decouples from Z coordinate */
     estimationCalculateAGL(&ctx);
 
+#if defined(USE_POS_ESTIMATOR_EKF)
+    if (positionEstimationConfig()->estimator_type == NAV_ESTIMATOR_EKF) {
+        estimationUpdateEkf(&ctx, currentTimeUs);
+        estimationCalculateGroundCourse(currentTimeUs);
+
+        posEstimator.est.eph = ctx.newEPH;
+        posEstimator.est.epv = ctx.newEPV;
+        posEstimator.flags = ctx.newFlags;
+        return;
+    }
+
+    // History wasn't kept while the EKF ran
+    if (posEstimator.ekf.active) {
+        posEstimator.ekf.active = false;
+        estimationResetHistory();
+    }
+#endif
+
     /* Prediction stage: X,Y,Z */
     estimationPredict(&ctx);
 
+    /* Compare GPS to the estimate at the time it was received */
+    estimationCompensateGpsDelay(&ctx, currentTimeUs);
+
     /* Correction stage: Z */
     const bool estZCorrectOk =
         estimationCalculateCorrection_Z(&ctx);
@@ -758,6 +947,7 @@ static void updateEstimatedTopic(timeUs_t currentTimeUs)
     // Apply corrections
     vectorAdd(&posEstimator.est.pos, &posEstimator.est.pos, &ctx.estPosCorr);
     vectorAdd(&posEstimator.est.vel, &posEstimator.est.vel, &ctx.estVelCorr);
+    estimationUpdateHistory(&ctx, currentTimeUs);
 
     /* Correct accelerometer bias */
     if (positionEstimationConfig()->w_acc_bias > 0.0f) {
@@ -879,6 +1069,10 @@ void initializePositionEstimator(void)
 
     posEstimator.imu.accWeightFactor = 0;
 
+    estimationResetHistory();
+#if defined(USE_POS_ESTIMATOR_EKF)
+    posEstimator.ekf.active = false;
+#endif
     restartGravityCalibration();
 
     for (axis = 0; axis < 3; axis++) {
@@ -0,0 +1,281 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+#include "platform.h"
+
+#if defined(USE_POS_ESTIMATOR_EKF)
+
+#include "common/maths.h"
+
+#include "navigation/navigation_pos_estimator_ekf.h"
+
+#define POS_EKF_INIT_VEL_STD        500.0f          // cm/s
+#define POS_EKF_INIT_BIAS_STD       50.0f           // cm/s/s
+#define POS_EKF_MAX_POS_VARIANCE    sq(10000.0f)    // Axis is started again by the next position measurement
+#define POS_EKF_MAX_DT              0.1f            // Longer gaps between updates are not integrated
+
+void posEkfInit(posEkf_t *ekf, float accNoise, float biasNoise)
+{
+    memset(ekf, 0, sizeof(*ekf));
+    ekf->accVariance = sq(accNoise);
+    ekf->biasVariance = sq(biasNoise);
+}
+
+bool posEkfIsAxisValid(const posEkf_t *ekf, uint8_t axis)
+{
+    return ekf->axis[axis].valid;
+}
+
+/*
+ * x = F x, P = F P F' + Q with F = [1 dt -dt^2/2; 0 1 -dt; 0 0 1]. The products are written out, which
+ * leaves out the multiplications by the zeros and ones of F.
+ */
+static void posEkfPredictAxis(posEkf_t *ekf, posEkfAxis_t *axis, float dt, float velDelta)
+{
+    const float h = dt * dt / 2;
+    const float dv = velDelta - axis->x[POS_EKF_BIAS] * dt;
+
+    axis->x[POS_EKF_POS] += (axis->x[POS_EKF_VEL] + dv / 2) * dt;
+    axis->x[POS_EKF_VEL] += dv;
+
+    float (*P)[POS_EKF_STATE_COUNT] = axis->P;
+
+    // Rows of F P
+    const float r0[3] = {
+        P[0][0] + dt * P[1][0] - h * P[2][0],
+        P[0][1] + dt * P[1][1] - h * P[2][1],
+        P[0][2] + dt * P[1][2] - h * P[2][2],
+    };
+    const float r1[3] = {
+        P[1][0] - dt * P[2][0],
+        P[1][1] - dt * P[2][1],
+        P[1][2] - dt * P[2][2],
+    };
+
+    const float q = ekf->accVariance * dt;
+
+    P[0][0] = r0[0] + dt * r0[1] - h * r0[2] + q * dt * dt / 3;
+    P[0][1] = P[1][0] = r0[1] - dt * r0[2] + q * dt / 2;
+    P[0][2] = P[2][0] = r0[2];
+    P[1][1] = r1[1] - dt * r1[2] + q;
+    P[1][2] = P[2][1] = r1[2];
+    P[2][2] += ekf->biasVariance * dt;
+
+    if (P[0][0] > POS_EKF_MAX_POS_VARIANCE) {
+        axis->valid = false;
+    }
+}
+
+static void posEkfResetState(posEkfAxis_t *axis, posEkfState_e state, float value, float variance)
+{
+    axis->x[state] = value;
+    for (int i = 0; i < POS_EKF_STATE_COUNT; i++) {
+        axis->P[state][i] = 0;
+        axis->P[i][state] = 0;
+    }
+    axis->P[state][state] = variance;
+}
+
+static void posEkfStartAxis(posEkfAxis_t *axis, float pos, float variance)
+{
+    memset(axis, 0, sizeof(*axis));
+    axis->valid = true;
+    axis->x[POS_EKF_POS] = pos;
+    axis->P[POS_EKF_POS][POS_EKF_POS] = variance;
+    axis->P[POS_EKF_VEL][POS_EKF_VEL] = sq(POS_EKF_INIT_VEL_STD);
+    axis->P[POS_EKF_BIAS][POS_EKF_BIAS] = sq(POS_EKF_INIT_BIAS_STD);
+}
+
+/*
+ * Scalar update with H picking one state: K = P H' / (H P H' + R) is a column of P over a scalar
+ * and the new covariance P - K H P is symmetric without the Joseph form.
+ */
+static void posEkfFuse(posEkf_t *ekf, const posEkfMeasurement_t *measurement)
+{
+    posEkfAxis_t *axis = &ekf->axis[measurement->axis];
+    const int s = measurement->state;
+
+    if (!axis->valid) {
+        if (s == POS_EKF_POS) {
+            posEkfStartAxis(axis, measurement->value, measurement->variance);
+            ekf->stats.resets++;
+        }
+        return;
+    }
+
+    const float innovation = measurement->value - axis->x[s];
+    const float innovationVariance = axis->P[s][s] + measurement->variance;
+
+    if (sq(innovation) > sq(POS_EKF_GATE_SIGMA) * innovationVariance) {
+        ekf->stats.rejected++;
+        if (++axis->rejects[s] >= POS_EKF_MAX_REJECTS) {
+            posEkfResetState(axis, s, measurement->value, measurement->variance);
+            axis->rejects[s] = 0;
+            ekf->stats.resets++;
+        }
+        return;
+    }
+
+    axis->rejects[s] = 0;
+
+    float Ps[POS_EKF_STATE_COUNT];
+    for (int i = 0; i < POS_EKF_STATE_COUNT; i++) {
+        Ps[i] = axis->P[s][i];
+    }
+
+    for (int i = 0; i < POS_EKF_STATE_COUNT; i++) {
+        const float k = Ps[i] / innovationVariance;
+        axis->x[i] += k * innovation;
+        for (int j = 0; j < POS_EKF_STATE_COUNT; j++) {
+            axis->P[i][j] -= k * Ps[j];
+        }
+    }
+
+    ekf->stats.fused++;
+}
+
+static void posEkfFuseMeasurements(posEkf_t *ekf)
+{
+    int kept = 0;
+
+    for (int i = 0; i < ekf->measurementCount; i++) {
+        const posEkfMeasurement_t *measurement = &ekf->measurements[i];
+
+        if (cmpTimeUs(measurement->time, ekf->time) <= 0) {
+            posEkfFuse(ekf, measurement);
+        } else {
+            ekf->measurements[kept++] = *measurement;
+        }
+    }
+
+    ekf->measurementCount = kept;
+}
+
+void posEkfAddMeasurement(posEkf_t *ekf, timeUs_t measurementTime, uint8_t axis, posEkfState_e state, float value, float variance)
+{
+    if (ekf->measurementCount == POS_EKF_MEASUREMENTS) {
+        memmove(&ekf->measurements[0], &ekf->measurements[1], sizeof(ekf->measurements[0]) * (POS_EKF_MEASUREMENTS - 1));
+        ekf->measurementCount--;
+        ekf->stats.dropped++;
+    }
+
+    // Older than the filter, fused with the next sample
+    if (ekf->started && cmpTimeUs(measurementTime, ekf->time) < 0) {
+        measurementTime = ekf->time;
+    }
+
+    posEkfMeasurement_t *measurement = &ekf->measurements[ekf->measurementCount++];
+    measurement->time = measurementTime;
+    measurement->value = value;
+    measurement->variance = MAX(variance, 1.0f);
+    measurement->axis = axis;
+    measurement->state = state;
+}
+
+// Moves the filter to the end of the oldest sample and fuses what was measured until then
+static void posEkfAdvance(posEkf_t *ekf)
+{
+    const posEkfImuSample_t *sample = &ekf->samples[(ekf->head + POS_EKF_HISTORY_SAMPLES - ekf->count) % POS_EKF_HISTORY_SAMPLES];
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        if (ekf->axis[axis].valid) {
+            posEkfPredictAxis(ekf, &ekf->axis[axis], sample->dt, sample->velDelta[axis]);
+        }
+    }
+
+    ekf->time = sample->time;
+    ekf->count--;
+
+    posEkfFuseMeasurements(ekf);
+}
+
+static void posEkfPredictOutput(posEkf_t *ekf)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const posEkfAxis_t *state = &ekf->axis[axis];
+        const float bias = state->x[POS_EKF_BIAS];
+        float pos = state->x[POS_EKF_POS];
+        float vel = state->x[POS_EKF_VEL];
+        float t = 0;
+
+        for (int i = ekf->count; i >= 0; i--) {
+            const posEkfImuSample_t *sample = i > 0 ? &ekf->samples[(ekf->head + POS_EKF_HISTORY_SAMPLES - i) % POS_EKF_HISTORY_SAMPLES] : &ekf->current;
+            const float dv = sample->velDelta[axis] - bias * sample->dt;
+            pos += (vel + dv / 2) * sample->dt;
+            vel += dv;
+            t += sample->dt;
+        }
+
+        ekf->pos.v[axis] = pos;
+        ekf->vel.v[axis] = vel;
+
+        // Position row of F over the history, [1 t -t^2/2]
+        const float f2 = -t * t / 2;
+        ekf->posVariance[axis] = state->P[0][0] + 2 * t * state->P[0][1] + 2 * f2 * state->P[0][2] +
+                                 t * t * state->P[1][1] + 2 * t * f2 * state->P[1][2] + f2 * f2 * state->P[2][2] +
+                                 ekf->accVariance * t * t * t / 3;
+    }
+}
+
+void posEkfUpdate(posEkf_t *ekf, timeUs_t currentTimeUs, const fpVector3_t *accelNEU)
+{
+    if (!ekf->started) {
+        ekf->started = true;
+        ekf->time = currentTimeUs;
+        ekf->lastUpdateTime = currentTimeUs;
+    }
+
+    const float dt = US2S(cmpTimeUs(currentTimeUs, ekf->lastUpdateTime));
+    ekf->lastUpdateTime = currentTimeUs;
+
+    if (dt > 0 && dt < POS_EKF_MAX_DT) {
+        ekf->current.dt += dt;
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            ekf->current.velDelta[axis] += accelNEU->v[axis] * dt;
+        }
+    }
+
+    ekf->current.time = currentTimeUs;
+
+    if (ekf->current.dt >= US2S(POS_EKF_SAMPLE_US)) {
+        if (ekf->count == POS_EKF_HISTORY_SAMPLES) {
+            posEkfAdvance(ekf);
+        }
+
+        ekf->samples[ekf->head] = ekf->current;
+        ekf->head = (ekf->head + 1) % POS_EKF_HISTORY_SAMPLES;
+        ekf->count++;
+        memset(&ekf->current, 0, sizeof(ekf->current));
+    }
+
+    while (ekf->count > 0) {
+        const posEkfImuSample_t *oldest = &ekf->samples[(ekf->head + POS_EKF_HISTORY_SAMPLES - ekf->count) % POS_EKF_HISTORY_SAMPLES];
+        if (cmpTimeUs(currentTimeUs, oldest->time) < POS_EKF_HORIZON_US) {
+            break;
+        }
+        posEkfAdvance(ekf);
+    }
+
+    posEkfPredictOutput(ekf);
+}
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/axis.h"
+#include "common/time.h"
+#include "common/vector.h"
+
+/*
+ * Error-state Kalman filter for position and velocity on a delayed time horizon.
+ *
+ * Attitude comes from the AHRS, so the acceleration is already in the earth frame and the axes don't
+ * couple: each axis has its own position, velocity and acceleration bias with a 3x3 covariance, and
+ * every measurement is a scalar update of one state - no matrix is ever inverted.
+ *
+ * Acceleration is kept in a history of 10ms samples and the filter runs POS_EKF_HORIZON_US behind
+ * it, so a measurement is fused when the filter reaches the time it was taken rather than when it
+ * arrived. The estimate of now is predicted from the filter forward through the history on each update.
+ */
+
+#define POS_EKF_SAMPLE_US           10000   // Acceleration history, one sample every 10ms
+#define POS_EKF_HISTORY_SAMPLES     24
+#define POS_EKF_HORIZON_US          200000  // Measurements up to this old are fused at the time they were taken
+#define POS_EKF_MEASUREMENTS        40      // Waiting for the filter to reach their time, a horizon of 10Hz GPS and 50Hz baro fits twice over
+
+#define POS_EKF_GATE_SIGMA          5.0f    // Innovations larger than this are rejected...
+#define POS_EKF_MAX_REJECTS         10      // ...until this many in a row, then the state is reset to the measurement
+
+typedef enum {
+    POS_EKF_POS = 0,    // cm
+    POS_EKF_VEL,        // cm/s
+    POS_EKF_BIAS,       // Acceleration bias, earth frame (cm/s/s)
+    POS_EKF_STATE_COUNT
+} posEkfState_e;
+
+typedef struct {
+    timeUs_t    time;                       // End of the sample
+    float       dt;
+    float       velDelta[XYZ_AXIS_COUNT];   // Integrated acceleration (cm/s)
+} posEkfImuSample_t;
+
+typedef struct {
+    timeUs_t    time;           // When the measurement was taken
+    float       value;
+    float       variance;
+    uint8_t     axis;
+    uint8_t     state;          // Measured state, POS_EKF_POS or POS_EKF_VEL
+} posEkfMeasurement_t;
+
+typedef struct {
+    bool        valid;          // Initialised by a position measurement
+    float       x[POS_EKF_STATE_COUNT];
+    float       P[POS_EKF_STATE_COUNT][POS_EKF_STATE_COUNT];
+    uint8_t     rejects[POS_EKF_BIAS];
+} posEkfAxis_t;
+
+typedef struct {
+    uint32_t    fused;
+    uint32_t    rejected;
+    uint32_t    resets;
+    uint32_t    dropped;        // Measurement buffer was full
+} posEkfStats_t;
+
+typedef struct {
+    float       accVariance;    // Acceleration noise density, (cm/s/s)^2 per Hz
+    float       biasVariance;   // Bias random walk, (cm/s/s)^2 per second
+
+    posEkfAxis_t axis[XYZ_AXIS_COUNT];
+    timeUs_t    time;           // Of the filter state
+    timeUs_t    lastUpdateTime;
+    bool        started;
+
+    posEkfImuSample_t samples[POS_EKF_HISTORY_SAMPLES];
+    uint8_t     head;           // Next sample to write
+    uint8_t     count;
+    posEkfImuSample_t current;  // Being integrated, not in the history yet
+
+    posEkfMeasurement_t measurements[POS_EKF_MEASUREMENTS];
+    uint8_t     measurementCount;
+
+    // Estimate of now
+    fpVector3_t pos;
+    fpVector3_t vel;
+    float       posVariance[XYZ_AXIS_COUNT];
+
+    posEkfStats_t stats;
+} posEkf_t;
+
+void posEkfInit(posEkf_t *ekf, float accNoise, float biasNoise);
+// Queues a measurement taken at measurementTime, fused once the filter gets there
+void posEkfAddMeasurement(posEkf_t *ekf, timeUs_t measurementTime, uint8_t axis, posEkfState_e state, float value, float variance);
+// Adds the acceleration since the last update, moves the filter on and predicts the estimate of now
+void posEkfUpdate(posEkf_t *ekf, timeUs_t currentTimeUs, const fpVector3_t *accelNEU);
+bool posEkfIsAxisValid(const posEkf_t *ekf, uint8_t axis);
@@ -25,6 +25,8 @@
 #include "common/filter.h"
 #include "common/calibration.h"
 
+#include "navigation/navigation_pos_estimator_ekf.h"
+
 #include "sensors/sensors.h"
 
 #define INAV_GPS_DEFAULT_EPH                200.0f  // 2m GPS HDOP  (gives about 1.6s of dead-reckoning if GPS is temporary lost)
@@ -41,6 +43,12 @@
 #define INAV_PITOT_UPDATE_RATE              10
 #define INAV_COG_UPDATE_RATE_HZ             20      // ground course update rate
 
+#define INAV_HISTORY_INTERVAL_US            10000   // Estimate history for GPS delay compensation, one sample every 10ms
+#define INAV_HISTORY_SAMPLES                16      // Compensate up to 150ms
+
+#define INAV_EKF_BIAS_NOISE                 1.0f    // Acceleration bias random walk (cm/s/s per sqrt(s))
+#define INAV_EKF_GPS_MIN_VEL_STD            50.0f   // cm/s, GPS velocity error is taken as a quarter of EPH/EPV but not below this
+
 #define INAV_GPS_TIMEOUT_MS                 1500    // GPS timeout
 #define INAV_BARO_TIMEOUT_MS                200     // Baro timeout
 #define INAV_SURFACE_TIMEOUT_MS             400     // Surface timeout    (missed 3 readings in a row)
@@ -70,6 +78,7 @@ typedef struct {
     bool        glitchDetected;
     bool        glitchRecovery;
 #endif
+    timeUs_t    arrivalTime;    // Arrival of the solution (us)
     fpVector3_t pos;            // GPS position in NEU coordinate system (cm)
     fpVector3_t vel;            // GPS velocity (cms)
     float       eph;
@@ -80,6 +89,7 @@ typedef struct {
     timeUs_t    lastUpdateTime; // Last update time (us)
     pt1Filter_t avgFilter;
     float       alt;            // Raw barometric altitude (cm)
+    float       rawAlt;         // Before averaging
     float       epv;
 } navPositionEstimatorBARO_t;
 
@@ -140,6 +150,34 @@ typedef struct {
     zeroCalibrationScalar_t gravityCalibration;
 } navPosisitonEstimatorIMU_t;
 
+typedef struct {
+    timeUs_t    time;
+    fpVector3_t pos;            // Estimate less the corrections applied up to this sample
+    fpVector3_t vel;
+} navPositionEstimatorHistorySample_t;
+
+/*
+ * GPS measurements are compared to the estimate at the time they were taken. The samples leave out corrections, adding
+ * the corrections applied until now gives the past estimate as if the corrections since had already been made then.
+ * That way a GPS measurement isn't corrected for again while it's being used.
+ */
+typedef struct {
+    navPositionEstimatorHistorySample_t samples[INAV_HISTORY_SAMPLES];
+    uint8_t     head;           // Next sample to write
+    uint8_t     count;
+    fpVector3_t posCorrSum;     // Corrections applied to the estimate
+    fpVector3_t velCorrSum;
+} navPositionEstimatorHISTORY_t;
+
+#if defined(USE_POS_ESTIMATOR_EKF)
+typedef struct {
+    bool        active;
+    timeUs_t    gpsUpdateTime;  // Of the last GPS and baro readings given to the filter
+    timeUs_t    baroUpdateTime;
+    posEkf_t    filter;
+} navPositionEstimatorEKF_t;
+#endif
+
 typedef enum {
     EST_GPS_XY_VALID            = (1 << 0),
     EST_GPS_Z_VALID             = (1 << 1),
@@ -172,6 +210,10 @@ typedef struct {
 
     // Estimate
     navPositionEstimatorESTIMATE_t  est;
+    navPositionEstimatorHISTORY_t   history;
+#if defined(USE_POS_ESTIMATOR_EKF)
+    navPositionEstimatorEKF_t       ekf;
+#endif
 
     // Extra state variables
     navPositionEstimatorSTATE_t state;
@@ -185,6 +227,8 @@ typedef struct {
     fpVector3_t estPosCorr;
     fpVector3_t estVelCorr;
     fpVector3_t accBiasCorr;
+    fpVector3_t gpsPos;         // GPS position and velocity moved forward to now by the estimate
+    fpVector3_t gpsVel;
 } estimationContext_t;
 
 extern navigationPosEstimator_t posEstimator;
@@ -111,8 +111,8 @@ void applyRoverBoatPositionController(timeUs_t currentTimeUs)
 void applyRoverBoatPitchRollThrottleController(navigationFSMStateFlags_t navStateFlags, timeUs_t currentTimeUs)
 {
     UNUSED(currentTimeUs);
-    rcCommand[ROLL] = 0;
-    rcCommand[PITCH] = 0;
+    navSetRcCommand(ROLL, 0);
+    navSetRcCommand(PITCH, 0);
 
     if (navStateFlags & NAV_CTL_POS) {
 
@@ -120,14 +120,14 @@ void applyRoverBoatPitchRollThrottleController(navigationFSMStateFlags_t navStat
             /*
              * When WP mission is done, stop the motors
              */
-            rcCommand[YAW] = 0;
-            rcCommand[THROTTLE] = feature(FEATURE_REVERSIBLE_MOTORS) ? reversibleMotorsConfig()->neutral : motorConfig()->mincommand;
+            navSetRcCommand(YAW, 0);
+            navSetRcCommand(THROTTLE, feature(FEATURE_REVERSIBLE_MOTORS) ? reversibleMotorsConfig()->neutral : motorConfig()->mincommand);
         } else {
             if (isYawAdjustmentValid) {
-                rcCommand[YAW] = posControl.rcAdjustment[YAW];
+                navSetRcCommand(YAW, posControl.rcAdjustment[YAW]);
             }
 
-            rcCommand[THROTTLE] = constrain(currentBatteryProfile->nav.fw.cruise_throttle, motorConfig()->mincommand, motorConfig()->maxthrottle);
+            navSetRcCommand(THROTTLE, constrain(currentBatteryProfile->nav.fw.cruise_throttle, motorConfig()->mincommand, motorConfig()->maxthrottle));
         }
     }
 }
@@ -135,10 +135,10 @@ void applyRoverBoatPitchRollThrottleController(navigationFSMStateFlags_t navStat
 void applyRoverBoatNavigationController(navigationFSMStateFlags_t navStateFlags, timeUs_t currentTimeUs)
 {
     if (navStateFlags & NAV_CTL_EMERG) {
-        rcCommand[ROLL] = 0;
-        rcCommand[PITCH] = 0;
-        rcCommand[YAW] = 0;
-        rcCommand[THROTTLE] = currentBatteryProfile->failsafe_throttle;
+        navSetRcCommand(ROLL, 0);
+        navSetRcCommand(PITCH, 0);
+        navSetRcCommand(YAW, 0);
+        navSetRcCommand(THROTTLE, currentBatteryProfile->failsafe_throttle);
     } else if (navStateFlags & NAV_CTL_POS) {
         applyRoverBoatPositionController(currentTimeUs);
         applyRoverBoatPitchRollThrottleController(navStateFlags, currentTimeUs);
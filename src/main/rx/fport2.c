@@ -158,6 +158,7 @@ typedef struct {
 typedef struct fportBuffer_s {
     uint8_t data[sizeof(fportFrame_t)+1]; // +1 for CRC
     uint8_t length;
+    timeUs_t frameEndUs;
 } fportBuffer_t;
 
 typedef struct {
@@ -170,6 +171,7 @@ static volatile uint8_t rxBufferWriteIndex = 0;
 static volatile uint8_t rxBufferReadIndex = 0;
 
 static serialPort_t *fportPort;
+static timeUs_t rcFrameTimeUs = 0;
 
 #ifdef USE_TELEMETRY_SMARTPORT
 static smartPortPayload_t *mspPayload = NULL;
@@ -271,6 +273,7 @@ static void fportDataReceive(uint16_t byte, void *callback_data)
 
         case FS_CONTROL_FRAME_DATA: {
             if (writeBuffer(byte) > controlFrameSize) {
+                rxBuffer[rxBufferWriteIndex].frameEndUs = currentTimeUs;
                 nextWriteBuffer();
                 state = FS_DOWNLINK_FRAME_START;
             }
@@ -363,6 +366,7 @@ static uint8_t frameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
                             result = sbusChannelsDecode(rxRuntimeConfig, &frame->control.rc.channels);
                             lqTrackerSet(rxRuntimeConfig->lqTracker, scaleRange(frame->control.rc.rssi, 0, 100, 0, RSSI_MAX_VALUE));
                             frameReceivedTimestamp = currentTimeUs;
+                            rcFrameTimeUs = rxBuffer[rxBufferReadIndex].frameEndUs;
 #if defined(USE_TELEMETRY_SMARTPORT)
                             otaMode = false;
 #endif
@@ -531,6 +535,12 @@ static uint8_t frameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
     return result;
 }
 
+static timeUs_t frameTimeUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+    return rcFrameTimeUs;
+}
+
 static bool processFrame(const rxRuntimeConfig_t *rxRuntimeConfig)
 {
     UNUSED(rxRuntimeConfig);
@@ -639,6 +649,7 @@ bool fport2RxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig
     rxRuntimeConfig->channelCount = SBUS_MAX_CHANNEL;
     rxRuntimeConfig->rcFrameStatusFn = frameStatus;
     rxRuntimeConfig->rcProcessFrameFn = processFrame;
+    rxRuntimeConfig->rcFrameTimeUsFn = frameTimeUs;
 
     const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
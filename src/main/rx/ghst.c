@@ -83,6 +83,7 @@ typedef struct ghstFailsafeTracker_s {
 static serialPort_t *serialPort;
 static timeUs_t ghstRxFrameStartAtUs = 0;
 static timeUs_t ghstRxFrameEndAtUs = 0;
+static timeUs_t ghstRcFrameTimeUs = 0;
 static uint8_t telemetryBuf[GHST_FRAME_SIZE_MAX];
 static uint8_t telemetryBufLen = 0;
 static ghstFailsafeTracker_t ghstFsTracker[GHST_UL_RC_CHANS_FRAME_COUNT];
@@ -254,6 +255,7 @@ uint8_t ghstFrameStatus(rxRuntimeConfig_t *rxRuntimeState)
         const int fullFrameLength = ghstValidatedFrame.frame.len + GHST_FRAME_LENGTH_ADDRESS + GHST_FRAME_LENGTH_FRAMELENGTH;
         if (crc == ghstValidatedFrame.bytes[fullFrameLength - 1] && ghstValidatedFrame.frame.addr == GHST_ADDR_FC) {
             ghstValidatedFrameAvailable = true;
+            ghstRcFrameTimeUs = ghstRxFrameEndAtUs;
             return ghstFailsafeFlag | RX_FRAME_COMPLETE | RX_FRAME_PROCESSING_REQUIRED;            // request callback through ghstProcessFrame to do the decoding  work
         }
 
@@ -267,6 +269,12 @@ uint8_t ghstFrameStatus(rxRuntimeConfig_t *rxRuntimeState)
     return ghstFailsafeFlag | RX_FRAME_PENDING;
 }
 
+static timeUs_t ghstFrameTimeUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+    return ghstRcFrameTimeUs;
+}
+
 static bool ghstProcessFrame(const rxRuntimeConfig_t *rxRuntimeConfig)
 {
     // Assume that the only way we get here is if ghstFrameStatus returned RX_FRAME_PROCESSING_REQUIRED, which indicates that the CRC
@@ -350,6 +358,7 @@ bool ghstRxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeState)
     rxRuntimeState->rcReadRawFn = ghstReadRawRC;
     rxRuntimeState->rcFrameStatusFn = ghstFrameStatus;
     rxRuntimeState->rcProcessFrameFn = ghstProcessFrame;
+    rxRuntimeState->rcFrameTimeUsFn = ghstFrameTimeUs;
 
     const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
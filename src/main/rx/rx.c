@@ -50,6 +50,7 @@
 #include "io/serial.h"
 
 #include "rx/rx.h"
+#include "rx/rx_latency.h"
 #include "rx/crsf.h"
 #include "rx/ibus.h"
 #include "rx/jetiexbus.h"
@@ -90,6 +91,9 @@ static uint8_t rxChannelCount;
 
 static timeUs_t rxNextUpdateAtUs = 0;
 static timeUs_t needRxSignalBefore = 0;
+static timeUs_t rxFrameTimeUs = 0;
+static bool rxFrameTimePending = false;
+static timeUs_t rxChannelsFrameTimeUs = 0;
 static bool isRxSuspended = false;
 
 static rcChannel_t rcChannels[MAX_SUPPORTED_RC_CHANNEL_COUNT];
@@ -98,7 +102,7 @@ rxLinkStatistics_t rxLinkStatistics;
 rxRuntimeConfig_t rxRuntimeConfig;
 static uint8_t rcSampleIndex = 0;
 
-PG_REGISTER_WITH_RESET_TEMPLATE(rxConfig_t, rxConfig, PG_RX_CONFIG, 12);
+PG_REGISTER_WITH_RESET_TEMPLATE(rxConfig_t, rxConfig, PG_RX_CONFIG, 13);
 
 #ifndef SERIALRX_PROVIDER
 #define SERIALRX_PROVIDER 0
@@ -129,6 +133,7 @@ PG_RESET_TEMPLATE(rxConfig_t, rxConfig,
     .rcFilterFrequency = SETTING_RC_FILTER_LPF_HZ_DEFAULT,
     .autoSmooth = SETTING_RC_FILTER_AUTO_DEFAULT,
     .autoSmoothFactor = SETTING_RC_FILTER_SMOOTHING_FACTOR_DEFAULT,
+    .rcFilterExtrapolation = SETTING_RC_FILTER_EXTRAPOLATION_DEFAULT,
 #if defined(USE_RX_MSP) && defined(USE_MSP_RC_OVERRIDE)
     .mspOverrideChannels = SETTING_MSP_OVERRIDE_CHANNELS_DEFAULT,
 #endif
@@ -268,8 +273,10 @@ void rxInit(void)
     rxRuntimeConfig.lqTracker = &rxLQTracker;
     rxRuntimeConfig.rcReadRawFn = nullReadRawRC;
     rxRuntimeConfig.rcFrameStatusFn = nullFrameStatus;
+    rxRuntimeConfig.rcFrameTimeUsFn = NULL;
     rxRuntimeConfig.rxSignalTimeout = DELAY_10_HZ;
     rcSampleIndex = 0;
+    rxLatencyReset();
 
     timeMs_t nowMs = millis();
 
@@ -390,6 +397,11 @@ bool rxAreFlightChannelsValid(void)
     return rxFlightChannelsValid;
 }
 
+timeUs_t rxGetFrameTimeUs(void)
+{
+    return rxChannelsFrameTimeUs;
+}
+
 void suspendRxSignal(void)
 {
     failsafeOnRxSuspend();
@@ -419,6 +431,9 @@ bool rxUpdateCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTime)
         rxSignalReceived = (frameStatus & RX_FRAME_FAILSAFE) == 0;
         needRxSignalBefore = currentTimeUs + rxRuntimeConfig.rxSignalTimeout;
         rxDataProcessingRequired = true;
+
+        rxFrameTimeUs = rxRuntimeConfig.rcFrameTimeUsFn ? rxRuntimeConfig.rcFrameTimeUsFn(&rxRuntimeConfig) : currentTimeUs;
+        rxFrameTimePending = true;
     }
     else if ((frameStatus & RX_FRAME_FAILSAFE) && rxSignalReceived) {
         // All other receiver statuses are allowed to report failsafe, but not allowed to leave it
@@ -469,6 +484,7 @@ bool calculateRxChannelsAndUpdateFailsafe(timeUs_t currentTimeUs)
 
     // If RX is suspended, do not process any data
     if (isRxSuspended) {
+        rxFrameTimePending = false;
         return true;
     }
 
@@ -510,7 +526,13 @@ bool calculateRxChannelsAndUpdateFailsafe(timeUs_t currentTimeUs)
         for (int channel = 0; channel < rxChannelCount; channel++) {
             rcChannels[channel].data = rcStaging[channel];
         }
+
+        if (rxFrameTimePending) {
+            rxChannelsFrameTimeUs = rxFrameTimeUs;
+            rxLatencyFrameReceived(rxFrameTimeUs);
+        }
     }
+    rxFrameTimePending = false;
 
 #if defined(USE_RX_MSP) && defined(USE_MSP_RC_OVERRIDE)
     if (IS_RC_MODE_ACTIVE(BOXMSPRCOVERRIDE) && !mspOverrideIsInFailsafe()) {
@@ -0,0 +1,139 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/maths.h"
+
+#include "rx/rx_latency.h"
+
+typedef struct rxLatencyState_s {
+    timeUs_t receivedFrameTimeUs;       // Frame whose channel values haven't reached the mixer yet
+    timeUs_t mixedFrameTimeUs;          // Frame whose motor outputs haven't been sent yet
+    bool receivedFramePending;
+    bool mixedFramePending;
+
+    uint32_t sampleCount;
+    uint64_t sumUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint16_t histogram[RX_LATENCY_BIN_COUNT];
+    uint32_t histogramCount;
+} rxLatencyState_t;
+
+static rxLatencyState_t rxLatency;
+
+void rxLatencyReset(void)
+{
+    memset(&rxLatency, 0, sizeof(rxLatency));
+}
+
+void rxLatencyFrameReceived(timeUs_t frameTimeUs)
+{
+    // A frame which didn't make it to the mixer before the next one arrived never influences the motors on its own
+    rxLatency.receivedFrameTimeUs = frameTimeUs;
+    rxLatency.receivedFramePending = true;
+}
+
+void rxLatencyMotorsMixed(void)
+{
+    if (!rxLatency.receivedFramePending) {
+        return;
+    }
+
+    // If the previous mix hasn't gone out yet the older frame is measured, the next motor update is its first one too
+    if (!rxLatency.mixedFramePending) {
+        rxLatency.mixedFrameTimeUs = rxLatency.receivedFrameTimeUs;
+        rxLatency.mixedFramePending = true;
+    }
+
+    rxLatency.receivedFramePending = false;
+}
+
+static void rxLatencyRecord(uint32_t latencyUs)
+{
+    rxLatency.sampleCount++;
+    rxLatency.sumUs += latencyUs;
+    rxLatency.minUs = (rxLatency.sampleCount == 1) ? latencyUs : MIN(rxLatency.minUs, latencyUs);
+    rxLatency.maxUs = MAX(rxLatency.maxUs, latencyUs);
+
+    const uint32_t bin = MIN(latencyUs / RX_LATENCY_BIN_US, (uint32_t)RX_LATENCY_BIN_COUNT - 1);
+
+    if (rxLatency.histogram[bin] == UINT16_MAX) {
+        // Halve all bins to keep the shape of the distribution while making room for new samples
+        rxLatency.histogramCount = 0;
+        for (int i = 0; i < RX_LATENCY_BIN_COUNT; i++) {
+            rxLatency.histogram[i] /= 2;
+            rxLatency.histogramCount += rxLatency.histogram[i];
+        }
+    }
+
+    rxLatency.histogram[bin]++;
+    rxLatency.histogramCount++;
+}
+
+void rxLatencyMotorsUpdated(timeUs_t currentTimeUs)
+{
+    if (!rxLatency.mixedFramePending) {
+        return;
+    }
+
+    rxLatency.mixedFramePending = false;
+
+    const timeDelta_t latencyUs = cmpTimeUs(currentTimeUs, rxLatency.mixedFrameTimeUs);
+    if (latencyUs >= 0) {
+        rxLatencyRecord(latencyUs);
+    }
+}
+
+static uint32_t rxLatencyPercentile(unsigned percent)
+{
+    const uint32_t threshold = (rxLatency.histogramCount * percent + 99) / 100;
+    uint32_t count = 0;
+
+    for (int i = 0; i < RX_LATENCY_BIN_COUNT - 1; i++) {
+        count += rxLatency.histogram[i];
+        if (count >= threshold) {
+            // Upper edge of the bin, a bin can't tell us anything better than that
+            return MIN((uint32_t)(i + 1) * RX_LATENCY_BIN_US, rxLatency.maxUs);
+        }
+    }
+
+    return rxLatency.maxUs;
+}
+
+void rxLatencyGetStats(rxLatencyStats_t *stats)
+{
+    stats->sampleCount = rxLatency.sampleCount;
+
+    if (rxLatency.sampleCount == 0) {
+        stats->minUs = 0;
+        stats->avgUs = 0;
+        stats->p99Us = 0;
+        stats->maxUs = 0;
+        return;
+    }
+
+    stats->minUs = rxLatency.minUs;
+    stats->avgUs = rxLatency.sumUs / rxLatency.sampleCount;
+    stats->p99Us = MAX(rxLatencyPercentile(99), rxLatency.minUs);
+    stats->maxUs = rxLatency.maxUs;
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common/time.h"
+
+/*
+ * Stick-to-motor latency. A frame is timestamped by the receiver driver when its last byte arrives, the timestamp
+ * follows the channel values into rcCommand and the mixer, and the latency is recorded when the first motor update
+ * computed from it actually goes out to the ESCs.
+ */
+
+#define RX_LATENCY_BIN_US       50
+#define RX_LATENCY_BIN_COUNT    100     // Anything above 5ms ends up in the last bin
+
+typedef struct rxLatencyStats_s {
+    uint32_t sampleCount;
+    uint32_t minUs;
+    uint32_t avgUs;
+    uint32_t p99Us;
+    uint32_t maxUs;
+} rxLatencyStats_t;
+
+void rxLatencyReset(void);
+
+// New channel values from a frame received at frameTimeUs have been stored
+void rxLatencyFrameReceived(timeUs_t frameTimeUs);
+// The mixer has computed motor outputs from the latest channel values
+void rxLatencyMotorsMixed(void);
+// Motor outputs computed by the last mix have been sent to the ESCs
+void rxLatencyMotorsUpdated(timeUs_t currentTimeUs);
+
+void rxLatencyGetStats(rxLatencyStats_t *stats);
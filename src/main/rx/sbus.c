@@ -64,6 +64,8 @@ typedef struct sbusFrameData_s {
     uint8_t buffer[SBUS_FRAME_SIZE];
     uint8_t position;
     timeUs_t lastActivityTimeUs;
+    volatile timeUs_t frameDoneTimeUs;
+    timeUs_t rcFrameTimeUs;
 } sbusFrameData_t;
 
 // Receive ISR callback
@@ -118,6 +120,7 @@ static void sbusDataReceive(uint16_t c, void *data)
                 if (!sbusFrameData->frameDone && frameValid) {
 
                     memcpy((void *)&sbusFrameData->frame, (void *)&sbusFrameData->buffer[0], SBUS_FRAME_SIZE);
+                    sbusFrameData->frameDoneTimeUs = currentTimeUs;
                     sbusFrameData->frameDone = true;
                 }
             }
@@ -140,6 +143,7 @@ static uint8_t sbusFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
 
     // Decode channel data and store return value
     const uint8_t retValue = sbusChannelsDecode(rxRuntimeConfig, (void *)&sbusFrameData->frame.channels);
+    sbusFrameData->rcFrameTimeUs = sbusFrameData->frameDoneTimeUs;
 
     // Reset the frameDone flag - tell ISR that we're ready to receive next frame
     sbusFrameData->frameDone = false;
@@ -152,6 +156,12 @@ static uint8_t sbusFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
     return retValue;
 }
 
+static timeUs_t sbusFrameTimeUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    const sbusFrameData_t *sbusFrameData = rxRuntimeConfig->frameData;
+    return sbusFrameData->rcFrameTimeUs;
+}
+
 static bool sbusInitEx(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig, uint32_t sbusBaudRate)
 {
     static uint16_t sbusChannelData[SBUS_MAX_CHANNEL];
@@ -165,6 +175,7 @@ static bool sbusInitEx(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeC
     rxRuntimeConfig->channelCount = SBUS_MAX_CHANNEL;
 
     rxRuntimeConfig->rcFrameStatusFn = sbusFrameStatus;
+    rxRuntimeConfig->rcFrameTimeUsFn = sbusFrameTimeUs;
 
     const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
@@ -26,11 +26,14 @@
 
 #include "common/utils.h"
 
+#include "drivers/time.h"
+
 #include "rx/rx.h"
 #include "rx/sim.h"
 
 static uint16_t channels[MAX_SUPPORTED_RC_CHANNEL_COUNT];
 static bool hasNewData = false;
+static timeUs_t frameTimeUs = 0;
 
 static uint16_t rxSimReadRawRC(const rxRuntimeConfig_t *rxRuntimeConfigPtr, uint8_t chan)
 {
@@ -44,6 +47,7 @@ void rxSimSetChannelValue(uint16_t* values, uint8_t count)
         channels[i] = values[i];
     }
 
+    frameTimeUs = micros();
     hasNewData = true;
 }
 
@@ -59,6 +63,12 @@ static uint8_t rxSimFrameStatus(rxRuntimeConfig_t *rxRuntimeConfig)
     return RX_FRAME_COMPLETE;
 }
 
+static timeUs_t rxSimFrameTimeUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+    return frameTimeUs;
+}
+
 void rxSimInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 {
     UNUSED(rxConfig);
@@ -67,5 +77,6 @@ void rxSimInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
     rxRuntimeConfig->rxSignalTimeout = DELAY_5_HZ;
     rxRuntimeConfig->rcReadRawFn = rxSimReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = rxSimFrameStatus;
+    rxRuntimeConfig->rcFrameTimeUsFn = rxSimFrameTimeUs;
 }
 #endif
@@ -95,6 +95,8 @@ static uint32_t fullTimeoutTimestamp = 0;
 static uint32_t lastValidPacketTimestamp = 0;
 static volatile uint32_t lastReceiveTimestamp = 0;
 static volatile uint32_t lastIdleTimestamp = 0;
+static uint32_t processBufferEndTimestamp = 0;
+static uint32_t rcFrameTimestamp = 0;
 
 struct rxBuf readBuffer[2];
 struct rxBuf* readBufferPtr = &readBuffer[0];
@@ -275,6 +277,7 @@ void srxl2Process(rxRuntimeConfig_t *rxRuntimeConfig)
 
     //Packet is valid only after ID and CRC check out
     lastValidPacketTimestamp = micros();
+    rcFrameTimestamp = processBufferEndTimestamp;
 
     if (srxl2ProcessPacket(&processBufferPtr->packet.header, rxRuntimeConfig)) {
         return;
@@ -321,6 +324,8 @@ static void srxl2Idle(void)
             readBufferPtr = &readBuffer[1];
         }
         processBufferPtr->len = readBufferIdx;
+        // Idle is polled, the packet ended with its last byte
+        processBufferEndTimestamp = lastReceiveTimestamp;
     }
 
     readBufferIdx = 0;
@@ -478,6 +483,12 @@ void srxl2RxWriteData(const void *data, int len)
     writeBufferIdx = len;
 }
 
+static timeUs_t srxl2FrameTimeUs(const rxRuntimeConfig_t *rxRuntimeConfig)
+{
+    UNUSED(rxRuntimeConfig);
+    return rcFrameTimestamp;
+}
+
 bool srxl2RxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
 {
     static uint16_t channelData[SRXL2_MAX_CHANNELS];
@@ -493,6 +504,7 @@ bool srxl2RxInit(const rxConfig_t *rxConfig, rxRuntimeConfig_t *rxRuntimeConfig)
     rxRuntimeConfig->rcReadRawFn = srxl2ReadRawRC;
     rxRuntimeConfig->rcFrameStatusFn = srxl2FrameStatus;
     rxRuntimeConfig->rcProcessFrameFn = srxl2ProcessFrame;
+    rxRuntimeConfig->rcFrameTimeUsFn = srxl2FrameTimeUs;
 
     const serialPortConfig_t *portConfig = findSerialPortConfig(FUNCTION_RX_SERIAL);
     if (!portConfig) {
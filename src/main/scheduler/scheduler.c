@@ -25,6 +25,7 @@
 
 #include "build/build_config.h"
 #include "build/debug.h"
+#include "build/trace.h"
 
 #include "common/maths.h"
 #include "common/time.h"
@@ -188,6 +189,11 @@ timeDelta_t getTaskDeltaTime(cfTaskId_e taskId)
     }
 }
 
+bool schedulerLastPassWasIdle(void)
+{
+    return currentTask == NULL;
+}
+
 void schedulerResetTaskStatistics(cfTaskId_e taskId)
 {
     if (taskId == TASK_SELF) {
@@ -274,14 +280,19 @@ void FAST_CODE NOINLINE scheduler(void)
     currentTask = selectedTask;
 
     if (selectedTask) {
-        // Found a task that should be run
+        // Found a task that should be run. Idle passes aren't traced, they would flood the trace buffer
+        TRACE_BEGIN_AT(TRACE_EVENT_SCHEDULER, 0, currentTimeUs);
+        TRACE_END(TRACE_EVENT_SCHEDULER, 0);
+
         selectedTask->taskLatestDeltaTime = (timeDelta_t)(currentTimeUs - selectedTask->lastExecutedAt);
         selectedTask->lastExecutedAt = currentTimeUs;
         selectedTask->dynamicPriority = 0;
 
         // Execute task
         const timeUs_t currentTimeBeforeTaskCall = micros();
+        TRACE_BEGIN(TRACE_EVENT_TASK, selectedTask - cfTasks);
         selectedTask->taskFunc(currentTimeBeforeTaskCall);
+        TRACE_END(TRACE_EVENT_TASK, selectedTask - cfTasks);
         const timeUs_t taskExecutionTime = micros() - currentTimeBeforeTaskCall;
         selectedTask->movingSumExecutionTime += taskExecutionTime - selectedTask->movingSumExecutionTime / TASK_MOVING_SUM_COUNT;
         selectedTask->totalExecutionTime += taskExecutionTime;   // time consumed by scheduler + task
@@ -54,6 +54,7 @@ typedef enum {
     TASK_PID,
     TASK_GYRO,
     TASK_RX,
+    TASK_NAVIGATION,
     TASK_SERIAL,
     TASK_BATTERY,
     TASK_TEMPERATURE,
@@ -163,6 +164,8 @@ void rescheduleTask(cfTaskId_e taskId, timeDelta_t newPeriodUs);
 void setTaskEnabled(cfTaskId_e taskId, bool newEnabledState);
 timeDelta_t getTaskDeltaTime(cfTaskId_e taskId);
 void schedulerResetTaskStatistics(cfTaskId_e taskId);
+// The last pass found no task to run
+bool schedulerLastPassWasIdle(void);
 
 void schedulerInit(void);
 void scheduler(void);
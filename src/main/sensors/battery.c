@@ -448,8 +448,8 @@ bool isBatteryVoltageConfigured(void)
 #ifdef USE_ADC
 uint16_t getVBatSample(void) {
     // calculate battery voltage based on ADC reading
-    // result is Vbatt in 0.01V steps. 3.3V = ADC Vref, 0xFFF = 12bit adc, 1100 = 11:1 voltage divider (10k:1k)
-    return (uint64_t)adcGetChannel(ADC_BATTERY) * batteryMetersConfig()->voltage.scale * ADCVREF / (0xFFF * 1000);
+    // result is Vbatt in 0.01V steps. 3.3V = ADC Vref, ADC_HIGHRES_MAX = oversampled 12bit adc, 1100 = 11:1 voltage divider (10k:1k)
+    return (uint64_t)adcGetChannelHighRes(ADC_BATTERY) * batteryMetersConfig()->voltage.scale * ADCVREF / (ADC_HIGHRES_MAX * 1000);
 }
 #endif
 
@@ -523,7 +523,7 @@ int16_t getAmperage(void)
 
 int16_t getAmperageSample(void)
 {
-    int32_t microvolts = ((uint32_t)adcGetChannel(ADC_CURRENT) * ADCVREF * 100) / 0xFFF * 10 - (int32_t)batteryMetersConfig()->current.offset * 100;
+    int32_t microvolts = (int64_t)adcGetChannelHighRes(ADC_CURRENT) * ADCVREF * 1000 / ADC_HIGHRES_MAX - (int32_t)batteryMetersConfig()->current.offset * 100;
     return microvolts / batteryMetersConfig()->current.scale; // current in 0.01A steps
 }
 
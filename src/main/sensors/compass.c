@@ -23,6 +23,7 @@
 #include "build/debug.h"
 
 #include "common/axis.h"
+#include "common/ellipsoid_fit.h"
 #include "common/maths.h"
 #include "common/utils.h"
 
@@ -64,7 +65,7 @@ mag_t mag;                   // mag access functions
 
 #ifdef USE_MAG
 
-PG_REGISTER_WITH_RESET_TEMPLATE(compassConfig_t, compassConfig, PG_COMPASS_CONFIG, 6);
+PG_REGISTER_WITH_RESET_TEMPLATE(compassConfig_t, compassConfig, PG_COMPASS_CONFIG, 7);
 
 PG_RESET_TEMPLATE(compassConfig_t, compassConfig,
     .mag_align = SETTING_ALIGN_MAG_DEFAULT,
@@ -78,6 +79,10 @@ PG_RESET_TEMPLATE(compassConfig_t, compassConfig,
     .pitchDeciDegrees = SETTING_ALIGN_MAG_PITCH_DEFAULT,
     .yawDeciDegrees = SETTING_ALIGN_MAG_YAW_DEFAULT,
     .magGain = {SETTING_MAGGAIN_X_DEFAULT, SETTING_MAGGAIN_Y_DEFAULT, SETTING_MAGGAIN_Z_DEFAULT},
+#ifdef USE_MAG_ELLIPSOID_CALIBRATION
+    .magCrossGain = {SETTING_MAGCROSS_XY_DEFAULT, SETTING_MAGCROSS_XZ_DEFAULT, SETTING_MAGCROSS_YZ_DEFAULT},
+    .magInflightCalibration = SETTING_MAG_INFLIGHT_CALIBRATION_DEFAULT,
+#endif
 );
 
 static bool magUpdatedAtLeastOnce = false;
@@ -354,6 +359,99 @@ bool compassIsCalibrationComplete(void)
     }
 }
 
+#ifdef USE_MAG_ELLIPSOID_CALIBRATION
+static ellipsoidFit_t magFit;
+static bool magFitRunning = false;
+static bool magFitApplied = false;    // In-flight calibration is done once per boot
+
+// magCrossGain holds XY, XZ and YZ
+#define MAG_CROSS_GAIN_INDEX(i, j)  ((i) + (j) - 1)
+#define MAG_CROSS_GAIN_SCALE        10000.0f
+
+static void compassStartEllipsoidFit(void)
+{
+    const fpVector3_t reference = {
+        .x = compassConfig()->magZero.raw[X],
+        .y = compassConfig()->magZero.raw[Y],
+        .z = compassConfig()->magZero.raw[Z],
+    };
+
+    ellipsoidFitInit(&magFit, &reference);
+    magFitRunning = true;
+}
+
+static void compassPushEllipsoidFitSample(void)
+{
+    const fpVector3_t sample = {
+        .x = mag.magADC[X],
+        .y = mag.magADC[Y],
+        .z = mag.magADC[Z],
+    };
+
+    ellipsoidFitPushSample(&magFit, &sample);
+}
+
+/*
+ * The fitted soft-iron matrix W is symmetric, stored as W = D^-1/2 (I + C) D^-1/2 with D the diagonal
+ * of axis gains and C the cross gains, so without cross gains it's the per-axis scaling of before.
+ */
+static bool compassApplyEllipsoidFit(void)
+{
+    fpVector3_t offset;
+    fpMat3_t softIron;
+
+    magFitRunning = false;
+
+    if (!ellipsoidFitGetResult(&magFit, &offset, &softIron)) {
+        return false;
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        compassConfigMutable()->magZero.raw[axis] = constrain(lrintf(offset.v[axis]), INT16_MIN, INT16_MAX);
+        compassConfigMutable()->magGain[axis] = constrain(lrintf(1.0f / softIron.m[axis][axis]), 1, INT16_MAX);
+    }
+
+    for (int i = 0; i < XYZ_AXIS_COUNT; i++) {
+        for (int j = i + 1; j < XYZ_AXIS_COUNT; j++) {
+            const float cross = softIron.m[i][j] / sqrtf(softIron.m[i][i] * softIron.m[j][j]);
+            compassConfigMutable()->magCrossGain[MAG_CROSS_GAIN_INDEX(i, j)] = lrintf(cross * MAG_CROSS_GAIN_SCALE);
+        }
+    }
+
+    return true;
+}
+
+static bool compassApplySoftIron(void)
+{
+    const int16_t *crossGain = compassConfig()->magCrossGain;
+    const int16_t *gain = compassConfig()->magGain;
+
+    if ((crossGain[0] == 0 && crossGain[1] == 0 && crossGain[2] == 0) || gain[X] <= 0 || gain[Y] <= 0 || gain[Z] <= 0) {
+        return false;
+    }
+
+    float scaled[XYZ_AXIS_COUNT];
+    float gainSqrt[XYZ_AXIS_COUNT];
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gainSqrt[axis] = sqrtf(gain[axis]);
+        scaled[axis] = (mag.magADC[axis] - compassConfig()->magZero.raw[axis]) / gainSqrt[axis];
+    }
+
+    for (int i = 0; i < XYZ_AXIS_COUNT; i++) {
+        float sum = scaled[i];
+        for (int j = 0; j < XYZ_AXIS_COUNT; j++) {
+            if (j != i) {
+                sum += crossGain[MAG_CROSS_GAIN_INDEX(i, j)] / MAG_CROSS_GAIN_SCALE * scaled[j];
+            }
+        }
+        mag.magADC[i] = lrintf(sum * 1024 / gainSqrt[i]);
+    }
+
+    return true;
+}
+#endif
+
 void compassUpdate(timeUs_t currentTimeUs)
 {
 #ifdef USE_SIMULATOR
@@ -401,8 +499,15 @@ void compassUpdate(timeUs_t currentTimeUs)
             compassConfigMutable()->magGain[axis] = 1024;
             magPrev[axis] = 0;
             magAxisDeviation[axis] = 0;  // Gain is based on the biggest absolute deviation from the mag zero point. Gain computation starts at 0
+#ifdef USE_MAG_ELLIPSOID_CALIBRATION
+            compassConfigMutable()->magCrossGain[axis] = 0;
+#endif
         }
 
+#ifdef USE_MAG_ELLIPSOID_CALIBRATION
+        compassStartEllipsoidFit();
+#endif
+
         beeper(BEEPER_ACTION_SUCCESS);
 
         sensorCalibrationResetState(&calState);
@@ -428,6 +533,10 @@ void compassUpdate(timeUs_t currentTimeUs)
             }
 
             // sqrtf(diffMag / avgMag) is a rough approximation of tangent of angle between magADC and magPrev. tan(8 deg) = 0.14
+#ifdef USE_MAG_ELLIPSOID_CALIBRATION
+            compassPushEllipsoidFitSample();
+#endif
+
             if ((avgMag > 0.01f) && ((diffMag / avgMag) > (0.14f * 0.14f))) {
                 sensorCalibrationPushSampleForOffsetCalculation(&calState, mag.magADC);
 
@@ -436,20 +545,26 @@ void compassUpdate(timeUs_t currentTimeUs)
                 }
             }
         } else {
-            float magZerof[3];
-            sensorCalibrationSolveForOffset(&calState, magZerof);
+#ifdef USE_MAG_ELLIPSOID_CALIBRATION
+            // The ellipsoid also corrects soft iron, offsets and gains of a sphere are only used if it didn't converge
+            if (!compassApplyEllipsoidFit())
+#endif
+            {
+                float magZerof[3];
+                sensorCalibrationSolveForOffset(&calState, magZerof);
 
-            for (int axis = 0; axis < 3; axis++) {
-                compassConfigMutable()->magZero.raw[axis] = lrintf(magZerof[axis]);
-            }
+                for (int axis = 0; axis < 3; axis++) {
+                    compassConfigMutable()->magZero.raw[axis] = lrintf(magZerof[axis]);
+                }
 
-            /*
-             * Scale calibration
-             * We use max absolute value of each axis as scale calibration with constant 1024 as base
-             * It is dirty, but worth checking if this will solve the problem of changing mag vector when UAV is tilted
-             */
-            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-                compassConfigMutable()->magGain[axis] = ABS(magAxisDeviation[axis] - compassConfig()->magZero.raw[axis]);
+                /*
+                 * Scale calibration
+                 * We use max absolute value of each axis as scale calibration with constant 1024 as base
+                 * It is dirty, but worth checking if this will solve the problem of changing mag vector when UAV is tilted
+                 */
+                for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                    compassConfigMutable()->magGain[axis] = ABS(magAxisDeviation[axis] - compassConfig()->magZero.raw[axis]);
+                }
             }
 
             calStartedAt = 0;
@@ -457,8 +572,27 @@ void compassUpdate(timeUs_t currentTimeUs)
         }
     }
     else {
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            mag.magADC[axis] = (mag.magADC[axis] - compassConfig()->magZero.raw[axis]) * 1024 / compassConfig()->magGain[axis];
+#ifdef USE_MAG_ELLIPSOID_CALIBRATION
+        // Raw samples at the task rate while armed, applied once converged and saved after disarming
+        if (compassConfig()->magInflightCalibration && ARMING_FLAG(ARMED) && !magFitApplied) {
+            if (!magFitRunning) {
+                compassStartEllipsoidFit();
+            }
+
+            compassPushEllipsoidFitSample();
+
+            if (ellipsoidFitIsConverged(&magFit) && compassApplyEllipsoidFit()) {
+                magFitApplied = true;
+                saveConfig();
+            }
+        }
+
+        if (!compassApplySoftIron())
+#endif
+        {
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                mag.magADC[axis] = (mag.magADC[axis] - compassConfig()->magZero.raw[axis]) * 1024 / compassConfig()->magGain[axis];
+            }
         }
     }
 
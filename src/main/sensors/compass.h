@@ -63,6 +63,10 @@ typedef struct compassConfig_s {
     uint8_t mag_hardware;                   // Which mag hardware to use on boards with more than one device
     flightDynamicsTrims_t magZero;
     int16_t magGain[XYZ_AXIS_COUNT];
+#ifdef USE_MAG_ELLIPSOID_CALIBRATION
+    int16_t magCrossGain[XYZ_AXIS_COUNT];   // Soft-iron coupling of XY, XZ and YZ (1/10000 of the geometric mean of the two gains)
+    uint8_t magInflightCalibration;         // Fit an ellipsoid in flight and use it once it's converged
+#endif
 #ifdef USE_DUAL_MAG
     uint8_t mag_to_use;
 #endif
@@ -25,6 +25,8 @@
 #include "build/build_config.h"
 #include "build/debug.h"
 
+#include "blackbox/blackbox_gyro_capture.h"
+
 #include "common/axis.h"
 #include "common/calibration.h"
 #include "common/filter.h"
@@ -536,6 +538,12 @@ void FAST_CODE NOINLINE gyroUpdate()
 
         gyro.gyroADCf[axis] = gyroADCf;
     }
+
+#ifdef USE_BLACKBOX
+    if (gyroCaptureIsRunning()) {
+        gyroCapturePush(gyroCaptureGetSource() == GYRO_CAPTURE_RAW ? gyro.gyroRaw : gyro.gyroADCf);
+    }
+#endif
 }
 
 bool gyroReadTemperature(void)
@@ -0,0 +1,610 @@
+/*
+ * This file is part of INAV Project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 3, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ */
+
+/*
+ * SITL fleet host. Runs many SITL vehicles in one process: the vehicle module is loaded once per vehicle, each loaded
+ * copy has its own firmware state, time base, config file and TCP ports. A pool of worker threads runs the main loops,
+ * a vehicle is run until its scheduler finds nothing to do and the worker moves on to the next one. Workers sleep
+ * when no vehicle had anything to do.
+ *
+ * The module is copied to a temporary file for every load, the dynamic loader maps a file only once however often it
+ * is opened.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <link.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "target/SITL/vehicle.h"
+
+#define FLEET_PASSES_PER_RUN    64      // Upper limit for one turn of a vehicle, if it always has a task to run
+#define FLEET_DEFAULT_PORT_STEP 10
+#define FLEET_DEFAULT_IDLE_US   100
+#define FLEET_DEFAULT_REPORT_S  10
+#define FLEET_ARG_LENGTH        PATH_MAX
+
+typedef struct fleetVehicle_s {
+    int index;
+    int argc;
+    char **argv;
+
+    void *handle;
+    unsigned generation;
+    sitlVehicleRunFn run;
+    sitlVehicleStopFn stop;
+    sitlVehicleGetStatsFn getStats;
+    sitlVehicleState_e state;
+    bool busy;                      // Taken by the worker running the vehicle, or the report
+
+    size_t codeBytes;               // Executable segments of the module
+    size_t dataBytes;               // Writable segments, .data and .bss
+    long rssBytes;                  // RSS growth while the vehicle was loaded and initialised the first time
+    unsigned resets;
+
+    sitlVehicleStats_t lastStats;   // At the last report
+} fleetVehicle_t;
+
+static fleetVehicle_t *vehicles;
+static int vehicleCount;
+static int workerCount;
+static unsigned idleSleepUs = FLEET_DEFAULT_IDLE_US;
+
+static char modulePath[PATH_MAX];
+static char tempDir[PATH_MAX];
+
+// Vehicle initialisation uses getopt() and strtok(), whose state is shared by all vehicles
+static pthread_mutex_t initLock = PTHREAD_MUTEX_INITIALIZER;
+
+static volatile sig_atomic_t stopRequested = false;
+static bool workersStop = false;
+
+static void handleSignal(int signal)
+{
+    (void)signal;
+    stopRequested = true;
+}
+
+static double monotonicSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static long readStatusValue(const char *key)
+{
+    FILE *file = fopen("/proc/self/status", "r");
+    if (!file) {
+        return 0;
+    }
+
+    char line[256];
+    long value = 0;
+    const size_t keyLength = strlen(key);
+    while (fgets(line, sizeof(line), file)) {
+        if (!strncmp(line, key, keyLength) && line[keyLength] == ':') {
+            value = strtol(line + keyLength + 1, NULL, 10);
+            break;
+        }
+    }
+    fclose(file);
+
+    return value;
+}
+
+static long residentBytes(void)
+{
+    return readStatusValue("VmRSS") * 1024;
+}
+
+static bool copyFile(const char *from, const char *to)
+{
+    const int in = open(from, O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+    const int out = open(to, O_WRONLY | O_CREAT | O_TRUNC, 0700);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
+
+    char buffer[65536];
+    ssize_t count;
+    bool ok = true;
+    while ((count = read(in, buffer, sizeof(buffer))) > 0) {
+        if (write(out, buffer, count) != count) {
+            ok = false;
+            break;
+        }
+    }
+
+    close(in);
+    close(out);
+    return ok && count == 0;
+}
+
+typedef struct segmentSizes_s {
+    ElfW(Addr) base;
+    size_t codeBytes;
+    size_t dataBytes;
+} segmentSizes_t;
+
+static int addSegmentSizes(struct dl_phdr_info *info, size_t size, void *data)
+{
+    (void)size;
+    segmentSizes_t *sizes = data;
+
+    if (info->dlpi_addr != sizes->base) {
+        return 0;
+    }
+
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *header = &info->dlpi_phdr[i];
+        if (header->p_type != PT_LOAD) {
+            continue;
+        }
+        // The parameter group registry is writable and in the same segment as the code
+        if (header->p_flags & PF_X) {
+            sizes->codeBytes += header->p_memsz;
+        } else if (header->p_flags & PF_W) {
+            sizes->dataBytes += header->p_memsz;
+        }
+    }
+
+    return 1;
+}
+
+static void *findSymbol(fleetVehicle_t *vehicle, const char *name)
+{
+    void *symbol = dlsym(vehicle->handle, name);
+    if (!symbol) {
+        fprintf(stderr, "[FLEET] Vehicle %d: %s not found in %s\n", vehicle->index, name, modulePath);
+    }
+    return symbol;
+}
+
+static void closeVehicleModule(fleetVehicle_t *vehicle)
+{
+    dlclose(vehicle->handle);
+    vehicle->handle = NULL;
+    vehicle->run = NULL;
+    vehicle->stop = NULL;
+    vehicle->getStats = NULL;
+}
+
+static bool loadVehicle(fleetVehicle_t *vehicle)
+{
+    char path[PATH_MAX + 32];
+    snprintf(path, sizeof(path), "%s/vehicle_%d_%u.so", tempDir, vehicle->index, vehicle->generation++);
+
+    if (!copyFile(modulePath, path)) {
+        fprintf(stderr, "[FLEET] Unable to copy %s to %s: %s\n", modulePath, path, strerror(errno));
+        return false;
+    }
+
+    const long rssBefore = residentBytes();
+    vehicle->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    // The mapping stays when the file is gone
+    unlink(path);
+    if (!vehicle->handle) {
+        fprintf(stderr, "[FLEET] %s\n", dlerror());
+        return false;
+    }
+
+    sitlVehicleApiVersionFn apiVersion = findSymbol(vehicle, SITL_VEHICLE_API_VERSION_SYMBOL);
+    sitlVehicleInitFn init = findSymbol(vehicle, SITL_VEHICLE_INIT_SYMBOL);
+    vehicle->run = findSymbol(vehicle, SITL_VEHICLE_RUN_SYMBOL);
+    vehicle->stop = findSymbol(vehicle, SITL_VEHICLE_STOP_SYMBOL);
+    vehicle->getStats = findSymbol(vehicle, SITL_VEHICLE_GET_STATS_SYMBOL);
+    if (!apiVersion || !init || !vehicle->run || !vehicle->stop || !vehicle->getStats) {
+        closeVehicleModule(vehicle);
+        return false;
+    }
+    if (apiVersion() != SITL_VEHICLE_API_VERSION) {
+        fprintf(stderr, "[FLEET] %s has API version %d, expected %d\n", modulePath, apiVersion(), SITL_VEHICLE_API_VERSION);
+        closeVehicleModule(vehicle);
+        return false;
+    }
+
+    struct link_map *map;
+    if (dlinfo(vehicle->handle, RTLD_DI_LINKMAP, &map) == 0) {
+        segmentSizes_t sizes = { .base = map->l_addr };
+        dl_iterate_phdr(addSegmentSizes, &sizes);
+        vehicle->codeBytes = sizes.codeBytes;
+        vehicle->dataBytes = sizes.dataBytes;
+    }
+
+    fprintf(stderr, "[FLEET] Starting vehicle %d\n", vehicle->index);
+    pthread_mutex_lock(&initLock);
+    // The vehicle parses its arguments with getopt(), start over
+    optind = 0;
+    vehicle->state = init(vehicle->argc, vehicle->argv);
+    pthread_mutex_unlock(&initLock);
+
+    if (vehicle->state == SITL_VEHICLE_FAILED) {
+        fprintf(stderr, "[FLEET] Vehicle %d failed to start\n", vehicle->index);
+        vehicle->stop();
+        closeVehicleModule(vehicle);
+        return false;
+    }
+
+    if (vehicle->generation == 1) {
+        vehicle->rssBytes = residentBytes() - rssBefore;
+    }
+    memset(&vehicle->lastStats, 0, sizeof(vehicle->lastStats));
+
+    return true;
+}
+
+// Closes the connections and traces of the loaded vehicles, the modules stay mapped until exit
+static void stopVehicles(int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (vehicles[i].handle) {
+            vehicles[i].stop();
+        }
+    }
+}
+
+static void unloadVehicle(fleetVehicle_t *vehicle)
+{
+    vehicle->stop();
+    closeVehicleModule(vehicle);
+}
+
+// Like a reboot of a flight controller, the vehicle starts over with fresh state and the saved config
+static void reloadVehicle(fleetVehicle_t *vehicle)
+{
+    fprintf(stderr, "[FLEET] Vehicle %d reset\n", vehicle->index);
+    unloadVehicle(vehicle);
+    vehicle->resets++;
+
+    if (!loadVehicle(vehicle)) {
+        vehicle->state = SITL_VEHICLE_STOPPED;
+    }
+}
+
+static bool tryTakeVehicle(fleetVehicle_t *vehicle)
+{
+    return !__atomic_exchange_n(&vehicle->busy, true, __ATOMIC_ACQUIRE);
+}
+
+static void releaseVehicle(fleetVehicle_t *vehicle)
+{
+    __atomic_store_n(&vehicle->busy, false, __ATOMIC_RELEASE);
+}
+
+static void *fleetWorker(void *arg)
+{
+    // Workers start at different vehicles and meet less often
+    const int first = (intptr_t)arg * vehicleCount / workerCount;
+
+    while (!__atomic_load_n(&workersStop, __ATOMIC_ACQUIRE)) {
+        bool busy = false;
+
+        for (int n = 0; n < vehicleCount; n++) {
+            fleetVehicle_t *vehicle = &vehicles[(first + n) % vehicleCount];
+            if (!tryTakeVehicle(vehicle)) {
+                continue;
+            }
+
+            if (vehicle->state == SITL_VEHICLE_RUNNING) {
+                bool idle;
+                vehicle->state = vehicle->run(FLEET_PASSES_PER_RUN, &idle);
+                busy |= !idle;
+
+                if (vehicle->state == SITL_VEHICLE_RESET) {
+                    reloadVehicle(vehicle);
+                } else if (vehicle->state == SITL_VEHICLE_STOPPED) {
+                    fprintf(stderr, "[FLEET] Vehicle %d stopped\n", vehicle->index);
+                }
+            }
+
+            releaseVehicle(vehicle);
+        }
+
+        if (!busy) {
+            usleep(idleSleepUs);
+        }
+    }
+
+    return NULL;
+}
+
+static void getVehicleStats(fleetVehicle_t *vehicle, sitlVehicleStats_t *stats)
+{
+    while (!tryTakeVehicle(vehicle)) {
+        sched_yield();
+    }
+
+    if (vehicle->handle) {
+        vehicle->getStats(stats);
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+
+    releaseVehicle(vehicle);
+}
+
+static void printReport(double seconds, bool perVehicle)
+{
+    uint64_t passes = 0;
+    double tasksMin = 1e30, tasksMax = 0, tasksSum = 0;
+    uint32_t deltaMin = UINT32_MAX, deltaMax = 0;
+    uint64_t deltaSum = 0;
+    long rssSum = 0;
+    size_t dataBytes = 0, codeBytes = 0;
+    int running = 0;
+
+    if (perVehicle) {
+        fprintf(stderr, "[FLEET] %8s %10s %10s %8s %8s %6s %6s %10s\n", "vehicle", "passes/s", "tasks/s", "loop us", "pid us", "load", "resets", "RSS KiB");
+    }
+
+    for (int i = 0; i < vehicleCount; i++) {
+        fleetVehicle_t *vehicle = &vehicles[i];
+        sitlVehicleStats_t stats;
+        getVehicleStats(vehicle, &stats);
+
+        // Counters start over when a vehicle is reloaded
+        const uint64_t vehiclePasses = stats.passes >= vehicle->lastStats.passes ? stats.passes - vehicle->lastStats.passes : stats.passes;
+        const uint64_t vehicleTasks = stats.tasks >= vehicle->lastStats.tasks ? stats.tasks - vehicle->lastStats.tasks : stats.tasks;
+        vehicle->lastStats = stats;
+
+        const double tasksPerSecond = vehicleTasks / seconds;
+        passes += vehiclePasses;
+        tasksSum += tasksPerSecond;
+        tasksMin = tasksPerSecond < tasksMin ? tasksPerSecond : tasksMin;
+        tasksMax = tasksPerSecond > tasksMax ? tasksPerSecond : tasksMax;
+        deltaSum += stats.pidDeltaUs;
+        deltaMin = stats.pidDeltaUs < deltaMin ? stats.pidDeltaUs : deltaMin;
+        deltaMax = stats.pidDeltaUs > deltaMax ? stats.pidDeltaUs : deltaMax;
+        rssSum += vehicle->rssBytes;
+        dataBytes = vehicle->dataBytes;
+        codeBytes = vehicle->codeBytes;
+        running += vehicle->state == SITL_VEHICLE_RUNNING;
+
+        if (perVehicle) {
+            fprintf(stderr, "[FLEET] %8d %10.0f %10.0f %8u %8u %5u%% %6u %10ld\n", vehicle->index, vehiclePasses / seconds, tasksPerSecond,
+                stats.looptimeUs, stats.pidDeltaUs, stats.systemLoadPercent, vehicle->resets, vehicle->rssBytes / 1024);
+        }
+    }
+
+    fprintf(stderr, "[FLEET] %d of %d vehicles running on %d workers, %ld threads, RSS %.1f MiB\n",
+        running, vehicleCount, workerCount, readStatusValue("Threads"), residentBytes() / 1048576.0);
+    fprintf(stderr, "[FLEET] Per vehicle: RSS %.0f KiB at start, data+bss %zu KiB, code %zu KiB\n",
+        rssSum / 1024.0 / vehicleCount, dataBytes / 1024, codeBytes / 1024);
+    fprintf(stderr, "[FLEET] Scheduler: %.0f passes/s, tasks/s per vehicle min %.0f avg %.0f max %.0f, PID loop us min %u avg %.0f max %u\n",
+        passes / seconds, tasksMin, tasksSum / vehicleCount, tasksMax, deltaMin, (double)deltaSum / vehicleCount, deltaMax);
+}
+
+// Vehicle arguments, with %d replaced by the vehicle index
+static char *formatVehicleArgument(const char *format, int index)
+{
+    char *argument = malloc(FLEET_ARG_LENGTH);
+    char *out = argument;
+    const char *end = argument + FLEET_ARG_LENGTH - 1;
+
+    for (const char *in = format; *in && out < end; in++) {
+        if (in[0] == '%' && in[1] == 'd') {
+            out += snprintf(out, end - out, "%d", index);
+            in++;
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+
+    return argument;
+}
+
+static void setupVehicleArguments(fleetVehicle_t *vehicle, int portStep, int extraCount, char *extra[])
+{
+    vehicle->argv = calloc(extraCount + 5, sizeof(char *));
+
+    vehicle->argv[vehicle->argc++] = modulePath;
+    // Defaults for the vehicle, the options given for the vehicles come later and take precedence
+    vehicle->argv[vehicle->argc++] = formatVehicleArgument("--path=eeprom_%d.bin", vehicle->index);
+    vehicle->argv[vehicle->argc++] = formatVehicleArgument("--sdcard=sdcard_%d.img", vehicle->index);
+    vehicle->argv[vehicle->argc] = malloc(FLEET_ARG_LENGTH);
+    snprintf(vehicle->argv[vehicle->argc++], FLEET_ARG_LENGTH, "--portoffset=%d", vehicle->index * portStep);
+
+    for (int i = 0; i < extraCount; i++) {
+        vehicle->argv[vehicle->argc++] = formatVehicleArgument(extra[i], vehicle->index);
+    }
+}
+
+// The module is next to the host, inav_x.y.z_SITL_fleet loads inav_x.y.z_SITL_vehicle.so
+static bool findDefaultModule(void)
+{
+    // Room for the suffix
+    char self[PATH_MAX - 16];
+    const ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length < 0) {
+        return false;
+    }
+    self[length] = '\0';
+
+    char *suffix = strstr(self, "_fleet");
+    if (suffix) {
+        *suffix = '\0';
+    }
+    snprintf(modulePath, sizeof(modulePath), "%s_vehicle.so", self);
+
+    return true;
+}
+
+static void printUsage(const char *name)
+{
+    fprintf(stderr, "Usage: %s --vehicles=[count] [options] [-- SITL options]\n", name);
+    fprintf(stderr, "--vehicles=[count]                   Number of vehicles.\n");
+    fprintf(stderr, "--workers=[count]                    Worker threads running the vehicles, default one per CPU.\n");
+    fprintf(stderr, "--portstep=[step]                    TCP port distance between vehicles, default %d. UART1 of vehicle n is on 5760 + n * step.\n", FLEET_DEFAULT_PORT_STEP);
+    fprintf(stderr, "--seconds=[seconds]                  Stop after the given time, default is to run until interrupted.\n");
+    fprintf(stderr, "--report=[seconds]                   Interval of the throughput report, default %d.\n", FLEET_DEFAULT_REPORT_S);
+    fprintf(stderr, "--idle=[us]                          Sleep of a worker that found no vehicle with a task to run, default %d.\n", FLEET_DEFAULT_IDLE_US);
+    fprintf(stderr, "--module=[path]                      Vehicle module, default is the _vehicle.so next to this program.\n");
+    fprintf(stderr, "Options after -- are given to every vehicle like to SITL, %%d is replaced by the vehicle index.\n");
+    fprintf(stderr, "Vehicle n uses eeprom_n.bin and sdcard_n.img unless --path or --sdcard is given.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int portStep = FLEET_DEFAULT_PORT_STEP;
+    double runSeconds = 0;
+    double reportSeconds = FLEET_DEFAULT_REPORT_S;
+    const long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+    static const struct option longOpt[] = {
+        { "vehicles", required_argument, NULL, 'n' },
+        { "workers", required_argument, NULL, 'w' },
+        { "portstep", required_argument, NULL, 'p' },
+        { "seconds", required_argument, NULL, 's' },
+        { "report", required_argument, NULL, 'r' },
+        { "idle", required_argument, NULL, 'i' },
+        { "module", required_argument, NULL, 'm' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int c;
+    while ((c = getopt_long_only(argc, argv, "h", longOpt, NULL)) != -1) {
+        switch (c) {
+        case 'n':
+            vehicleCount = atoi(optarg);
+            break;
+        case 'w':
+            workerCount = atoi(optarg);
+            break;
+        case 'p':
+            portStep = atoi(optarg);
+            break;
+        case 's':
+            runSeconds = atof(optarg);
+            break;
+        case 'r':
+            reportSeconds = atof(optarg);
+            break;
+        case 'i':
+            idleSleepUs = atoi(optarg);
+            break;
+        case 'm':
+            snprintf(modulePath, sizeof(modulePath), "%s", optarg);
+            break;
+        default:
+            printUsage(argv[0]);
+            return c == 'h' ? 0 : 1;
+        }
+    }
+
+    if (vehicleCount < 1 || reportSeconds <= 0 || portStep < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!modulePath[0] && !findDefaultModule()) {
+        fprintf(stderr, "[FLEET] Unable to find the vehicle module, use --module\n");
+        return 1;
+    }
+    if (workerCount < 1) {
+        workerCount = cpuCount > 0 ? cpuCount : 1;
+    }
+    if (workerCount > vehicleCount) {
+        workerCount = vehicleCount;
+    }
+
+    const char *tmp = getenv("TMPDIR");
+    snprintf(tempDir, sizeof(tempDir), "%s/inav_fleet_XXXXXX", tmp ? tmp : "/tmp");
+    if (!mkdtemp(tempDir)) {
+        fprintf(stderr, "[FLEET] Unable to create %s: %s\n", tempDir, strerror(errno));
+        return 1;
+    }
+
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+    // A client closing its connection must not stop all vehicles
+    signal(SIGPIPE, SIG_IGN);
+
+    vehicles = calloc(vehicleCount, sizeof(fleetVehicle_t));
+    const double loadStart = monotonicSeconds();
+    for (int i = 0; i < vehicleCount && !stopRequested; i++) {
+        vehicles[i].index = i;
+        setupVehicleArguments(&vehicles[i], portStep, argc - optind, &argv[optind]);
+        if (!loadVehicle(&vehicles[i])) {
+            stopVehicles(i);
+            rmdir(tempDir);
+            return 1;
+        }
+    }
+    if (stopRequested) {
+        stopVehicles(vehicleCount);
+        rmdir(tempDir);
+        return 1;
+    }
+    fprintf(stderr, "[FLEET] %d vehicles started in %.1f s\n", vehicleCount, monotonicSeconds() - loadStart);
+
+    pthread_t *workers = calloc(workerCount, sizeof(pthread_t));
+    for (int i = 0; i < workerCount; i++) {
+        if (pthread_create(&workers[i], NULL, fleetWorker, (void *)(intptr_t)i) != 0) {
+            fprintf(stderr, "[FLEET] Unable to create worker %d\n", i);
+            return 1;
+        }
+    }
+
+    const double start = monotonicSeconds();
+    double lastReport = start;
+    while (!stopRequested && (runSeconds <= 0 || monotonicSeconds() - start < runSeconds)) {
+        usleep(100000);
+        const double now = monotonicSeconds();
+        if (now - lastReport >= reportSeconds) {
+            printReport(now - lastReport, false);
+            lastReport = now;
+        }
+    }
+
+    __atomic_store_n(&workersStop, true, __ATOMIC_RELEASE);
+    for (int i = 0; i < workerCount; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    printReport(monotonicSeconds() - lastReport, true);
+
+    stopVehicles(vehicleCount);
+    rmdir(tempDir);
+
+    return 0;
+}
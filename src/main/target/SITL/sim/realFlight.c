@@ -71,9 +71,13 @@ static pthread_mutex_t sockmtx = PTHREAD_MUTEX_INITIALIZER;
 
 static soap_client_t *client = NULL;
 static soap_client_t *clientNext = NULL;
+// The server kept the last connection open, no spare connection needed
+static bool keepAlive = false;
+static int rfPort = RF_PORT;
 
 static pthread_t soapThread;
 static pthread_t creationThread;
+static bool threadsStarted = false;
 
 static bool isInitalised = false;
 static bool useImu = false;
@@ -125,22 +129,42 @@ typedef struct
     bool m_anEngineIsRunning;
     bool m_isTouchingGround;
     bool m_flightAxisControllerIsActive;
-    char* m_currentAircraftStatus;
+    char m_currentAircraftStatus[32];
     bool m_resetButtonHasBeenPressed;
 } rfValues_t;
 
 rfValues_t rfValues; 
 
-static void deleteClient(soap_client_t *client)
+static void deleteClient(soap_client_t *cli)
 {
-    soapClientClose(client);
-    free(client);
-    client = NULL;
+    soapClientClose(cli);
+    free(cli);
 }
 
-static void startRequest(char* action, const char* fmt, ...)
+// Leaves sockmtx unlocked if a worker is cancelled while waiting
+static void unlockSockMutex(void *arg)
 {
+    UNUSED(arg);
+    pthread_mutex_unlock(&sockmtx);
+}
+
+// Returns true if a connection of an earlier request is used again
+static bool acquireClient(void)
+{
+    if (client && client->isConnected) {
+        return true;
+    }
+
     pthread_mutex_lock(&sockmtx);
+    pthread_cleanup_push(unlockSockMutex, NULL);
+    if (client) {
+        deleteClient(client);
+        client = NULL;
+    }
+
+    keepAlive = false;
+    pthread_cond_broadcast(&sockcond2);
+
     while (clientNext == NULL) {
         pthread_cond_wait(&sockcond1, &sockmtx);
     }
@@ -149,98 +173,156 @@ static void startRequest(char* action, const char* fmt, ...)
     clientNext = NULL;
 
     pthread_cond_broadcast(&sockcond2);
-    pthread_mutex_unlock(&sockmtx);
+    pthread_cleanup_pop(1);
 
-    va_list va;
-    va_start(va, fmt);
-    soapClientSendRequestVa(client, action, fmt, va);
-    va_end(va);
+    return false;
 }
 
-static char* endRequest(void)
+static void releaseClient(void)
 {
-   char* ret = soapClientReceive(client); 
-   deleteClient(client);
-   return ret;   
-}
-
-// Simple, but fast ;)
-static double getDoubleFromResponse(const char* response, const char* elementName)
-{   
-    if (!response) {
-        return 0;
-    }
-    
-    char* pos = strstr(response, elementName);
-    if (!pos) {
-        return 0;
+    pthread_mutex_lock(&sockmtx);
+    keepAlive = client->isConnected;
+    if (keepAlive && clientNext) {
+        // Spare connection opened before the server was known to keep them open
+        deleteClient(clientNext);
+        clientNext = NULL;
     }
-    return atof(pos + strlen(elementName) + 1);
+    pthread_cond_broadcast(&sockcond2);
+    pthread_mutex_unlock(&sockmtx);
 }
 
-
 /*
-Currently unused
-static bool getBoolFromResponse(const char* response, const char* elementName)
+ * RealFlight closes the connection after every response, a spare one is kept ready by the creation worker. Servers
+ * keeping the connection open are sent all requests on the same one.
+ */
+static char* soapRequest(const char* action, const char* fmt, ...)
 {
-    if (!response) {
-        return false;
-    }
-    
-    char* pos = strstr(response, elementName);
-    if (!pos) {
-        return false;
+    char *response = NULL;
+
+    // The server may have closed a kept connection in the meantime, then try again on a new one
+    for (int attempt = 0; attempt < 2 && !response; attempt++) {
+        const bool reused = acquireClient();
+
+        va_list va;
+        va_start(va, fmt);
+        const bool sent = soapClientSendRequestVa(client, action, fmt, va);
+        va_end(va);
+
+        if (sent) {
+            response = soapClientReceive(client);
+        }
+        releaseClient();
+
+        if (!reused) {
+            break;
+        }
     }
-    return (strncmp(pos + strlen(elementName) + 1, "true", 4) == 0);
+
+    return response;
 }
-*/
 
-static char* getStringFromResponse(const char* response, const char* elementName)
+typedef struct {
+    const char *name;
+    uint8_t nameLength;
+    double *value;
+} rfResponseField_t;
+
+#define RF_RESPONSE_FIELD(name, field) { name, sizeof(name) - 1, &rfValues.field }
+
+// In the order of the ExchangeData response
+static const rfResponseField_t rfResponseFields[] = {
+    RF_RESPONSE_FIELD("m-airspeed-MPS", m_airspeed_MPS),
+    RF_RESPONSE_FIELD("m-altitudeASL-MTR", m_altitudeASL_MTR),
+    RF_RESPONSE_FIELD("m-altitudeAGL-MTR", m_altitudeAGL_MTR),
+    RF_RESPONSE_FIELD("m-groundspeed-MPS", m_groundspeed_MPS),
+    RF_RESPONSE_FIELD("m-pitchRate-DEGpSEC", m_pitchRate_DEGpSEC),
+    RF_RESPONSE_FIELD("m-rollRate-DEGpSEC", m_rollRate_DEGpSEC),
+    RF_RESPONSE_FIELD("m-yawRate-DEGpSEC", m_yawRate_DEGpSEC),
+    RF_RESPONSE_FIELD("m-azimuth-DEG", m_azimuth_DEG),
+    RF_RESPONSE_FIELD("m-inclination-DEG", m_inclination_DEG),
+    RF_RESPONSE_FIELD("m-roll-DEG", m_roll_DEG),
+    RF_RESPONSE_FIELD("m-aircraftPositionX-MTR", m_aircraftPositionX_MTR),
+    RF_RESPONSE_FIELD("m-aircraftPositionY-MTR", m_aircraftPositionY_MTR),
+    RF_RESPONSE_FIELD("m-accelerationBodyAX-MPS2", m_accelerationBodyAX_MPS2),
+    RF_RESPONSE_FIELD("m-accelerationBodyAY-MPS2", m_accelerationBodyAY_MPS2),
+    RF_RESPONSE_FIELD("m-accelerationBodyAZ-MPS2", m_accelerationBodyAZ_MPS2),
+    RF_RESPONSE_FIELD("m-batteryVoltage-VOLTS", m_batteryVoltage_VOLTS),
+    RF_RESPONSE_FIELD("m-batteryCurrentDraw-AMPS", m_batteryCurrentDraw_AMPS),
+};
+
+#define RF_CHANNEL_VALUES_TAG "m-channelValues-0to1"
+#define RF_AIRCRAFT_STATUS_TAG "m-currentAircraftStatus"
+
+static bool isTag(const char *name, size_t nameLength, const char *tag, size_t tagLength)
 {
-    if (!response) {
-        return 0;
-    }
-    
-    char* pos = strstr(response, elementName);
-    if (!pos) {
-        return NULL;
-    }
+    return nameLength == tagLength && memcmp(name, tag, tagLength) == 0;
+}
 
-    pos += strlen(elementName) + 1;
-    char* end = strstr(pos, "</");
-    if (!end) {
-        return NULL;
+static const rfResponseField_t *findResponseField(const char *name, size_t nameLength, unsigned *nextField)
+{
+    // The fields come in a fixed order, the next one usually matches at the first try
+    for (unsigned i = 0; i < ARRAYLEN(rfResponseFields); i++) {
+        const unsigned index = (*nextField + i) % ARRAYLEN(rfResponseFields);
+        const rfResponseField_t *field = &rfResponseFields[index];
+
+        if (isTag(name, nameLength, field->name, field->nameLength)) {
+            *nextField = index + 1;
+            return field;
+        }
     }
-    size_t length = end - pos;
-    char* ret = calloc(length + 1, sizeof(char));
-    strncpy(ret, pos, length);
-    return ret;
+
+    return NULL;
 }
 
-static bool getChannelValues(const char* response, uint16_t* channelValues)
+/*
+ * Single pass over the response, every element is looked at once. Values are converted in place, nothing is
+ * allocated. Elements not in rfResponseFields are skipped.
+ */
+static bool parseExchangeDataResponse(const char *response, uint16_t *channelValues)
 {
-    if (!response) {
-        return false;
-    }
-    
-    const char* channelValueTag = "<m-channelValues-0to1 xsi:type=\"SOAP-ENC:Array\" SOAP-ENC:arrayType=\"xsd:double[12]\">";
-    char* pos = strstr(response, channelValueTag);
-    if (!pos){
-        return false;
-    }
+    unsigned nextField = 0;
+    int channel = -1;
+    int channelCount = 0;
+    const char *pos = response;
+
+    while ((pos = strchr(pos, '<')) != NULL) {
+        pos++;
+
+        // Closing tags, declarations and comments
+        if (*pos == '/' || *pos == '?' || *pos == '!') {
+            continue;
+        }
 
-    pos += strlen(channelValueTag);
-    for (size_t i = 0; i < RF_MAX_CHANNEL_COUNT; i++) {
-        char* end = strstr(pos, "</");
-        if (!end) {
-            return false;
+        const size_t nameLength = strcspn(pos, " />");
+        const char *content = strchr(pos + nameLength, '>');
+        if (!content) {
+            break;
+        }
+        content++;
+
+        if (channel >= 0 && isTag(pos, nameLength, "item", 4)) {
+            if (channel < RF_MAX_CHANNEL_COUNT) {
+                channelValues[channel++] = FLOAT_0_1_TO_PWM(strtof(content, NULL));
+                channelCount = channel;
+            }
+        } else if (isTag(pos, nameLength, RF_CHANNEL_VALUES_TAG, sizeof(RF_CHANNEL_VALUES_TAG) - 1)) {
+            channel = 0;
+        } else if (isTag(pos, nameLength, RF_AIRCRAFT_STATUS_TAG, sizeof(RF_AIRCRAFT_STATUS_TAG) - 1)) {
+            const size_t length = MIN(strcspn(content, "<"), sizeof(rfValues.m_currentAircraftStatus) - 1);
+            memcpy(rfValues.m_currentAircraftStatus, content, length);
+            rfValues.m_currentAircraftStatus[length] = '\0';
+        } else {
+            channel = -1;
+            const rfResponseField_t *field = findResponseField(pos, nameLength, &nextField);
+            if (field) {
+                *field->value = strtod(content, NULL);
+            }
         }
 
-        channelValues[i] = FLOAT_0_1_TO_PWM((float)atof(pos + 6));
-        pos = end + 7;   
+        pos = content;
     }
 
-    return true;
+    return channelCount == RF_MAX_CHANNEL_COUNT;
 }
 
 
@@ -270,61 +352,17 @@ static void exchangeData(void)
         }
     }
 
-    startRequest("ExchangeData", "<ExchangeData><pControlInputs><m-selectedChannels>%u</m-selectedChannels><m-channelValues-0to1><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item></m-channelValues-0to1></pControlInputs></ExchangeData>",
+    char* response = soapRequest("ExchangeData", "<ExchangeData><pControlInputs><m-selectedChannels>%u</m-selectedChannels><m-channelValues-0to1><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item><item>%.4f</item></m-channelValues-0to1></pControlInputs></ExchangeData>",
         0xFFF, servoValues[0], servoValues[1], servoValues[2], servoValues[3], servoValues[4], servoValues[5], servoValues[6], servoValues[7], servoValues[8], servoValues[9], servoValues[10], servoValues[11]);
-    char* response = endRequest();
-
-    //rfValues.m_currentPhysicsTime_SEC = getDoubleFromResponse(response, "m-currentPhysicsTime-SEC");
-    //rfValues.m_currentPhysicsSpeedMultiplier = getDoubleFromResponse(response, "m-currentPhysicsSpeedMultiplier");
-    rfValues.m_airspeed_MPS = getDoubleFromResponse(response, "m-airspeed-MPS");
-    rfValues.m_altitudeASL_MTR = getDoubleFromResponse(response, "m-altitudeASL-MTR");
-    rfValues.m_altitudeAGL_MTR = getDoubleFromResponse(response, "m-altitudeAGL-MTR");
-    rfValues.m_groundspeed_MPS = getDoubleFromResponse(response, "m-groundspeed-MPS");
-    rfValues.m_pitchRate_DEGpSEC = getDoubleFromResponse(response, "m-pitchRate-DEGpSEC");
-    rfValues.m_rollRate_DEGpSEC = getDoubleFromResponse(response, "m-rollRate-DEGpSEC");
-    rfValues.m_yawRate_DEGpSEC = getDoubleFromResponse(response, "m-yawRate-DEGpSEC");
-    rfValues.m_azimuth_DEG = getDoubleFromResponse(response, "m-azimuth-DEG");
-    rfValues.m_inclination_DEG = getDoubleFromResponse(response, "m-inclination-DEG");
-    rfValues.m_roll_DEG = getDoubleFromResponse(response, "m-roll-DEG");
-    //rfValues.m_orientationQuaternion_X = getDoubleFromResponse(response, "m-orientationQuaternion-X");
-    //rfValues.m_orientationQuaternion_Y = getDoubleFromResponse(response, "m-orientationQuaternion-Y");
-    //rfValues.m_orientationQuaternion_Z = getDoubleFromResponse(response, "m-orientationQuaternion-Z");
-    //rfValues.m_orientationQuaternion_W = getDoubleFromResponse(response, "m-orientationQuaternion-W");
-    rfValues.m_aircraftPositionX_MTR = getDoubleFromResponse(response, "m-aircraftPositionX-MTR");
-    rfValues.m_aircraftPositionY_MTR = getDoubleFromResponse(response, "m-aircraftPositionY-MTR");
-    //rfValues.m_velocityWorldU_MPS = getDoubleFromResponse(response, "m-velocityWorldU-MPS");
-    //rfValues.m_velocityWorldV_MPS = getDoubleFromResponse(response, "m-velocityWorldV-MPS");
-    //rfValues.m_velocityWorldW_MPS = getDoubleFromResponse(response, "m-velocityWorldW-MPS");
-    //rfValues.m_velocityBodyU_MPS = getDoubleFromResponse(response, "m-velocityBodyU-MPS");
-    //rfValues.m_velocityBodyV_MPS = getDoubleFromResponse(response, "mm-velocityBodyV-MPS");
-    //rfValues.m_velocityBodyW_MPS = getDoubleFromResponse(response, "m-velocityBodyW-MPS");
-    //rfValues.m_accelerationWorldAX_MPS2 = getDoubleFromResponse(response, "m-accelerationWorldAX-MPS2");
-    //rfValues.m_accelerationWorldAY_MPS2 = getDoubleFromResponse(response, "m-accelerationWorldAY-MPS2");
-    //rfValues.m_accelerationWorldAZ_MPS2 = getDoubleFromResponse(response, "m-accelerationWorldAZ-MPS2");
-    rfValues.m_accelerationBodyAX_MPS2 = getDoubleFromResponse(response, "m-accelerationBodyAX-MPS2");
-    rfValues.m_accelerationBodyAY_MPS2 = getDoubleFromResponse(response, "m-accelerationBodyAY-MPS2");
-    rfValues.m_accelerationBodyAZ_MPS2 = getDoubleFromResponse(response, "m-accelerationBodyAZ-MPS2");
-    //rfValues.m_windX_MPS = getDoubleFromResponse(response, "m-windX-MPS");
-    //rfValues.m_windY_MPS = getDoubleFromResponse(response, "m-windY-MPS");
-    //rfValues.m_windZ_MPSPS = getDoubleFromResponse(response, "m-windZ-MPS");
-    //rfValues.m_propRPM = getDoubleFromResponse(response, "m-propRPM");
-    //rfValues.m_heliMainRotorRPM = getDoubleFromResponse(response, "m-heliMainRotorRPM");
-    rfValues.m_batteryVoltage_VOLTS = getDoubleFromResponse(response, "m-batteryVoltage-VOLTS");
-    rfValues.m_batteryCurrentDraw_AMPS = getDoubleFromResponse(response, "m-batteryCurrentDraw-AMPS");
-    //rfValues.m_batteryRemainingCapacity_MAH = getDoubleFromResponse(response, "m-batteryRemainingCapacity-MAH");
-    //rfValues.m_fuelRemaining_OZ = getDoubleFromResponse(response, "m-fuelRemaining-OZ");
-    //rfValues.m_isLocked = getBoolFromResponse(response, "m-isLocked");
-    //rfValues.m_hasLostComponents = getBoolFromResponse(response, "m-hasLostComponents");
-    //rfValues.m_anEngineIsRunning = getBoolFromResponse(response, "m-anEngineIsRunning");
-    //rfValues.m_isTouchingGround = getBoolFromResponse(response, "m-isTouchingGround");
-    //rfValues.m_flightAxisControllerIsActive= getBoolFromResponse(response, "m-flightAxisControllerIsActive");
-    rfValues.m_currentAircraftStatus = getStringFromResponse(response, "m-currentAircraftStatus");
+    if (!response) {
+        return;
+    }
 
-    
     uint16_t channelValues[RF_MAX_CHANNEL_COUNT];
-    getChannelValues(response, channelValues);
-    rxSimSetChannelValue(channelValues, RF_MAX_CHANNEL_COUNT);
-    
+    if (parseExchangeDataResponse(response, channelValues)) {
+        rxSimSetChannelValue(channelValues, RF_MAX_CHANNEL_COUNT);
+    }
+
     double lat, lon;
     fakeCoords(FAKE_LAT, FAKE_LON, rfValues.m_aircraftPositionX_MTR, -rfValues.m_aircraftPositionY_MTR, &lat, &lon);
     
@@ -363,7 +401,7 @@ static void exchangeData(void)
     int16_t accX = 0;
     int16_t accY = 0;
     int16_t accZ = 0;
-    if (rfValues.m_currentAircraftStatus && strncmp(rfValues.m_currentAircraftStatus, "CAS-WAITINGTOLAUNCH", strlen(rfValues.m_currentAircraftStatus)) == 0) {
+    if (strcmp(rfValues.m_currentAircraftStatus, "CAS-WAITINGTOLAUNCH") == 0) {
         accX = 0;
         accY = 0;
         accZ = (int16_t)(GRAVITY_MSS * 1000.0f);
@@ -407,10 +445,8 @@ static void* soapWorker(void* arg)
     while(true)
     {     
         if (!isInitalised) {
-            startRequest("RestoreOriginalControllerDevice", "<RestoreOriginalControllerDevice><a>1</a><b>2</b></RestoreOriginalControllerDevice>");
-            endRequest();
-            startRequest("InjectUAVControllerInterface", "<InjectUAVControllerInterface><a>1</a><b>2</b></InjectUAVControllerInterface>");
-            endRequest();        
+            soapRequest("RestoreOriginalControllerDevice", "<RestoreOriginalControllerDevice><a>1</a><b>2</b></RestoreOriginalControllerDevice>");
+            soapRequest("InjectUAVControllerInterface", "<InjectUAVControllerInterface><a>1</a><b>2</b></InjectUAVControllerInterface>");
             exchangeData();
             ENABLE_ARMING_FLAG(SIMULATOR_MODE_SITL);
             
@@ -431,18 +467,21 @@ static void* creationWorker(void* arg)
     
     while (true) {
         pthread_mutex_lock(&sockmtx);
-        while (clientNext != NULL) {
+        pthread_cleanup_push(unlockSockMutex, NULL);
+        while (clientNext != NULL || keepAlive) {
             pthread_cond_wait(&sockcond2, &sockmtx);
         }
-        pthread_mutex_unlock(&sockmtx);
-        
+        pthread_cleanup_pop(1);
+
         soap_client_t *cli = malloc(sizeof(soap_client_t));
-        if (!soapClientConnect(cli, ip, RF_PORT)) {
+        if (!soapClientConnect(cli, ip, rfPort)) {
+            free(cli);
+            delay(100);
             continue;
         }
-        
-        clientNext = cli;
+
         pthread_mutex_lock(&sockmtx);
+        clientNext = cli;
         pthread_cond_broadcast(&sockcond1);
         pthread_mutex_unlock(&sockmtx);
     }
@@ -450,12 +489,16 @@ static void* creationWorker(void* arg)
     return NULL;
 }
 
-bool simRealFlightInit(char* ip, uint8_t* mapping, uint8_t mapCount, bool imu)
+bool simRealFlightInit(char* ip, int port, uint8_t* mapping, uint8_t mapCount, bool imu)
 {
     memcpy(pwmMapping, mapping, mapCount);
     mappingCount = mapCount;
     useImu = imu;
 
+    if (port != 0) {
+        rfPort = port;
+    }
+
     if (pthread_create(&soapThread, NULL, soapWorker, NULL) < 0) {
         return false;
     }
@@ -463,6 +506,7 @@ bool simRealFlightInit(char* ip, uint8_t* mapping, uint8_t mapCount, bool imu)
     if (pthread_create(&creationThread, NULL, creationWorker, (void*)ip) < 0) {
         return false;
     }
+    threadsStarted = true;
 
     // Wait until the connection is established, the interface has been initialised 
     // and the first valid packet has been received to avoid problems with the startup calibration.   
@@ -472,3 +516,26 @@ bool simRealFlightInit(char* ip, uint8_t* mapping, uint8_t mapCount, bool imu)
 
     return true;
 }
+
+void simRealFlightClose(void)
+{
+    if (!threadsStarted) {
+        return;
+    }
+
+    // Both workers block in socket calls or condition waits, which are cancellation points
+    pthread_cancel(soapThread);
+    pthread_cancel(creationThread);
+    pthread_join(soapThread, NULL);
+    pthread_join(creationThread, NULL);
+    threadsStarted = false;
+
+    if (client) {
+        deleteClient(client);
+        client = NULL;
+    }
+    if (clientNext) {
+        deleteClient(clientNext);
+        clientNext = NULL;
+    }
+}
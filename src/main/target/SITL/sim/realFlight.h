@@ -26,4 +26,5 @@
 
 #define RF_MAX_PWM_OUTS 12
 
-bool simRealFlightInit(char* ip, uint8_t* mapping, uint8_t mapCount, bool imu);
+bool simRealFlightInit(char* ip, int port, uint8_t* mapping, uint8_t mapCount, bool imu);
+void simRealFlightClose(void);
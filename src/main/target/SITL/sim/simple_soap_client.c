@@ -32,14 +32,20 @@
 #include <string.h>
 #include <sys/socket.h>
 # include <netinet/in.h>
+# include <netinet/tcp.h>
 # include <netdb.h>
 #include <fcntl.h>
 #include <sys/select.h>
 
 #include "simple_soap_client.h"
 
-#define REC_BUF_SIZE 6000
-char recBuffer[REC_BUF_SIZE];
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+#define SOAP_ENVELOPE_START "<soap:Envelope xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" xmlns:soap=\"http://schemas.xmlsoap.org/soap/envelope/\"><soap:Body>"
+#define SOAP_ENVELOPE_END "</soap:Body></soap:Envelope>"
+#define SOAP_HEADER_SPACE 256
 
 bool soapClientConnect(soap_client_t *client, const char *address, int port)
 {
@@ -50,14 +56,19 @@ bool soapClientConnect(soap_client_t *client, const char *address, int port)
 
     int one = 1;
     if (setsockopt(client->sockedFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0) {
+        close(client->sockedFd);
         return false;
     }
 
+    // Requests are written at once and the answer is waited for, nothing to gain from Nagle
+    setsockopt(client->sockedFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
     client->socketAddr.sin_family = AF_INET;
     client->socketAddr.sin_port = htons(port);
     client->socketAddr.sin_addr.s_addr = inet_addr(address);
 
     if (connect(client->sockedFd, (struct sockaddr*)&client->socketAddr, sizeof(client->socketAddr)) < 0) {
+        close(client->sockedFd);
         return false;
     }
 
@@ -69,39 +80,67 @@ bool soapClientConnect(soap_client_t *client, const char *address, int port)
 
 void soapClientClose(soap_client_t *client)
 {
-    close(client->sockedFd);
-    memset(client, 0, sizeof(soap_client_t));
+    if (client->isInitalised) {
+        close(client->sockedFd);
+    }
     client->isConnected = false;
     client->isInitalised = false;
 }
 
-void soapClientSendRequestVa(soap_client_t *client, const char* action, const char *fmt, va_list va)
+bool soapClientSendRequestVa(soap_client_t *client, const char* action, const char *fmt, va_list va)
 {
-     if (!client->isConnected) {
-        return;
+    if (!client->isConnected) {
+        return false;
+    }
+
+    // The body is formatted behind the space left for the HTTP header, which needs its length
+    char *body = client->sendBuffer + SOAP_HEADER_SPACE;
+    const int bodySpace = SOAP_SEND_BUF_SIZE - SOAP_HEADER_SPACE;
+
+    int bodyLength = snprintf(body, bodySpace, SOAP_ENVELOPE_START);
+    bodyLength += vsnprintf(body + bodyLength, bodySpace - bodyLength, fmt, va);
+    if (bodyLength >= bodySpace) {
+        return false;
+    }
+    bodyLength += snprintf(body + bodyLength, bodySpace - bodyLength, SOAP_ENVELOPE_END);
+    if (bodyLength >= bodySpace) {
+        return false;
     }
 
-    char* requestBody;
-    if (vasprintf(&requestBody, fmt, va) < 0) {
-        return;
+    char header[SOAP_HEADER_SPACE];
+    const int headerLength = snprintf(header, sizeof(header), "POST / HTTP/1.1\r\nsoapaction: %s\r\ncontent-length: %d\r\ncontent-type: text/xml;charset='UTF-8'\r\nConnection: Keep-Alive\r\n\r\n",
+        action, bodyLength);
+    if (headerLength >= SOAP_HEADER_SPACE) {
+        return false;
     }
 
-    char* request;
-    if (asprintf(&request, "POST / HTTP/1.1\r\nsoapaction: %s\r\ncontent-length: %u\r\ncontent-type: text/xml;charset='UTF-8'\r\nConnection: Keep-Alive\r\n\r\n<soap:Envelope xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" xmlns:soap=\"http://schemas.xmlsoap.org/soap/envelope/\"><soap:Body>%s</soap:Body></soap:Envelope>",
-         action, (unsigned)strlen(requestBody), requestBody) < 0) {
-            return;
-         }
+    // Header directly in front of the body, one send() for the whole request
+    char *request = body - headerLength;
+    memcpy(request, header, headerLength);
+
+    ssize_t remaining = headerLength + bodyLength;
+    while (remaining > 0) {
+        ssize_t sent = send(client->sockedFd, request, remaining, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            client->isConnected = false;
+            return false;
+        }
+        request += sent;
+        remaining -= sent;
+    }
 
-    send(client->sockedFd, request, strlen(request), 0);
+    return true;
 }
 
-void soapClientSendRequest(soap_client_t *client, const char* action, const char *fmt, ...)
+bool soapClientSendRequest(soap_client_t *client, const char* action, const char *fmt, ...)
 {
     va_list va;
 
     va_start(va, fmt);
-    soapClientSendRequestVa(client, action, fmt, va);
+    bool ret = soapClientSendRequestVa(client, action, fmt, va);
     va_end(va);
+
+    return ret;
 }
 
 static bool soapClientPoll(soap_client_t *client, uint32_t timeout_ms)
@@ -121,49 +160,75 @@ static bool soapClientPoll(soap_client_t *client, uint32_t timeout_ms)
     return true;
 }
 
-
-char* soapClientReceive(soap_client_t *client)
+static bool soapClientKeepsConnection(const char *header)
 {
-     if (!client->isInitalised){
+    if (strcasestr(header, "Connection: close")) {
         return false;
     }
 
-    if (!soapClientPoll(client, 1000)) {
-        return false;
-    }
-
-    ssize_t size = recv(client->sockedFd, recBuffer, REC_BUF_SIZE, 0);
-
-    if (size <= 0) {
-        return NULL;
-    }
-
-    char* pos = strstr(recBuffer, "Content-Length: ");
-    if (!pos) {
-       return NULL;
-    }
+    // HTTP/1.1 keeps the connection unless told otherwise, 1.0 only when asked to
+    return strncmp(header, "HTTP/1.1", 8) == 0 || strcasestr(header, "Connection: keep-alive");
+}
 
-    uint32_t contentLength = strtoul(pos + 16, NULL, 10);
-    char *body = strstr(pos, "\r\n\r\n");
-    if (!body) {
+char* soapClientReceive(soap_client_t *client)
+{
+    if (!client->isConnected) {
         return NULL;
     }
 
-    body += 4;
+    char *recBuffer = client->recBuffer;
+    char *body = NULL;
+    ssize_t size = 0;
+    ssize_t expectedLength = 0;
+    bool keepConnection = false;
 
-    ssize_t expectedLength = contentLength + body - recBuffer;
-    if ((unsigned)expectedLength >= sizeof(recBuffer)) {
-        return NULL;
-    }
+    // Read exactly one response, the connection stays usable for the next one
+    while (!body || size < expectedLength) {
+        if (!soapClientPoll(client, 1000)) {
+            client->isConnected = false;
+            return NULL;
+        }
 
-    while (size < expectedLength){
-        ssize_t size2 = recv(client->sockedFd, &recBuffer[size], sizeof(recBuffer - size + 1), 0);
-        if (size2 <= 0) {
+        ssize_t received = recv(client->sockedFd, &recBuffer[size], SOAP_REC_BUF_SIZE - 1 - size, 0);
+        if (received <= 0) {
+            client->isConnected = false;
             return NULL;
         }
-        size += size2;
+        size += received;
+        recBuffer[size] = '\0';
+
+        if (!body) {
+            char *headerEnd = strstr(recBuffer, "\r\n\r\n");
+            if (!headerEnd) {
+                if (size >= SOAP_REC_BUF_SIZE - 1) {
+                    client->isConnected = false;
+                    return NULL;
+                }
+                continue;
+            }
+
+            *headerEnd = '\0';
+            char *pos = strcasestr(recBuffer, "Content-Length: ");
+            keepConnection = soapClientKeepsConnection(recBuffer);
+            *headerEnd = '\r';
+            if (!pos) {
+                client->isConnected = false;
+                return NULL;
+            }
+
+            body = headerEnd + 4;
+            expectedLength = strtoul(pos + 16, NULL, 10) + body - recBuffer;
+            if (expectedLength >= SOAP_REC_BUF_SIZE) {
+                client->isConnected = false;
+                return NULL;
+            }
+        }
+    }
+
+    recBuffer[expectedLength] = '\0';
+    if (!keepConnection) {
+        client->isConnected = false;
     }
 
-    recBuffer[size] = '\0';
-    return strdup(body);
+    return body;
 }
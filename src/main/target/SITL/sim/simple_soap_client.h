@@ -26,23 +26,21 @@
 #include <netinet/in.h>
 #include <netdb.h>
 
-#define SOAP_REC_BUF_SIZE 256 * 1024
+#define SOAP_REC_BUF_SIZE (16 * 1024)
+#define SOAP_SEND_BUF_SIZE (4 * 1024)
 
 typedef struct {
     int sockedFd;
     struct sockaddr_in socketAddr;
     bool isInitalised;
     bool isConnected;
+    char sendBuffer[SOAP_SEND_BUF_SIZE];
+    char recBuffer[SOAP_REC_BUF_SIZE];
 } soap_client_t;
 
-typedef struct {
-    soap_client_t client;
-    char* content;
-} send_info_t;
-
-
 bool soapClientConnect(soap_client_t *client, const char *address, int port);
 void soapClientClose(soap_client_t *client);
-void soapClientSendRequestVa(soap_client_t *client, const char* action, const char *fmt, va_list va);
-void soapClientSendRequest(soap_client_t *client, const char* action, const char *fmt, ...);
+bool soapClientSendRequestVa(soap_client_t *client, const char* action, const char *fmt, va_list va);
+bool soapClientSendRequest(soap_client_t *client, const char* action, const char *fmt, ...);
+// Returns the body of the response, valid until the next request. isConnected is cleared if the server closed the connection.
 char* soapClientReceive(soap_client_t *client);
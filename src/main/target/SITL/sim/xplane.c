@@ -22,12 +22,15 @@
  * along with this program. If not, see http://www.gnu.org/licenses/.
  */
 
+#define _GNU_SOURCE
+
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <sys/types.h>
@@ -35,6 +38,7 @@
 #include <pthread.h>
 #include <errno.h>
 #include <math.h>
+#include <unistd.h>
 
 #include "platform.h"
 
@@ -61,6 +65,7 @@
 
 #define XP_PORT 49000
 #define XPLANE_JOYSTICK_AXIS_COUNT 8
+#define XP_DREF_PACKET_SIZE 509
 
 
 static uint8_t pwmMapping[XP_MAX_PWM_OUTS];
@@ -68,8 +73,9 @@ static uint8_t mappingCount;
 
 static struct sockaddr_storage serverAddr;
 static socklen_t serverAddrLen;
-static int sockFd;
+static int sockFd = -1;
 static pthread_t listenThread;
+static bool listenThreadStarted = false;
 static bool initalized = false;
 static bool useImu = false;
 
@@ -159,15 +165,85 @@ static void registerDref(dref_t id, char* dref, uint32_t freq)
     sendto(sockFd, (void*)buf, sizeof(buf), 0, (struct sockaddr*)&serverAddr, serverAddrLen);
 }
 
-static void sendDref(char* dref, float value)
+typedef enum
+{
+    XP_CONTROL_OVERRIDE_JOYSTICK,
+    XP_CONTROL_THROTTLE,
+    XP_CONTROL_YOKE_ROLL,
+    XP_CONTROL_YOKE_PITCH,
+    XP_CONTROL_YOKE_HEADING,
+    XP_CONTROL_COWL_FLAP_0,
+    XP_CONTROL_COWL_FLAP_1,
+    XP_CONTROL_COWL_FLAP_2,
+    XP_CONTROL_COWL_FLAP_3,
+    XP_CONTROL_COWL_FLAP_4,
+    XP_CONTROL_COUNT
+} xplaneControl_e;
+
+static const char * const controlDrefs[XP_CONTROL_COUNT] = {
+    [XP_CONTROL_OVERRIDE_JOYSTICK] = "sim/operation/override/override_joystick",
+    [XP_CONTROL_THROTTLE] = "sim/cockpit2/engine/actuators/throttle_ratio_all",
+    [XP_CONTROL_YOKE_ROLL] = "sim/joystick/yoke_roll_ratio",
+    [XP_CONTROL_YOKE_PITCH] = "sim/joystick/yoke_pitch_ratio",
+    [XP_CONTROL_YOKE_HEADING] = "sim/joystick/yoke_heading_ratio",
+    [XP_CONTROL_COWL_FLAP_0] = "sim/cockpit2/engine/actuators/cowl_flap_ratio[0]",
+    [XP_CONTROL_COWL_FLAP_1] = "sim/cockpit2/engine/actuators/cowl_flap_ratio[1]",
+    [XP_CONTROL_COWL_FLAP_2] = "sim/cockpit2/engine/actuators/cowl_flap_ratio[2]",
+    [XP_CONTROL_COWL_FLAP_3] = "sim/cockpit2/engine/actuators/cowl_flap_ratio[3]",
+    [XP_CONTROL_COWL_FLAP_4] = "sim/cockpit2/engine/actuators/cowl_flap_ratio[4]",
+};
+
+// DREF packets are built once, per step only the values are written
+static uint8_t controlPackets[XP_CONTROL_COUNT][XP_DREF_PACKET_SIZE];
+
+static void initControlPackets(void)
 {
-    char buf[509];
-    strcpy(buf, "DREF");
-    memcpy(buf + 5, &value, 4);
-    memset(buf + 9, ' ', sizeof(buf) - 9);
-    strcpy(buf + 9, dref);
+    for (int i = 0; i < XP_CONTROL_COUNT; i++) {
+        uint8_t *buf = controlPackets[i];
+        memset(buf, 0, 9);
+        memcpy(buf, "DREF", 4);
+        memset(buf + 9, ' ', XP_DREF_PACKET_SIZE - 9);
+        strcpy((char*)buf + 9, controlDrefs[i]);
+    }
+}
 
-    sendto(sockFd, (void*)buf, sizeof(buf), 0, (struct sockaddr*)&serverAddr, serverAddrLen);
+/*
+ * X-Plane takes one dataref per DREF packet. All of them are sent with a single sendmmsg() per step, X-Plane
+ * gets them back to back and applies them in the same frame.
+ */
+static void sendControls(const float *values)
+{
+    struct iovec iov[XP_CONTROL_COUNT];
+
+    for (int i = 0; i < XP_CONTROL_COUNT; i++) {
+        memcpy(controlPackets[i] + 5, &values[i], 4);
+        iov[i].iov_base = controlPackets[i];
+        iov[i].iov_len = XP_DREF_PACKET_SIZE;
+    }
+
+#if defined(__linux__)
+    struct mmsghdr msgs[XP_CONTROL_COUNT];
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < XP_CONTROL_COUNT; i++) {
+        msgs[i].msg_hdr.msg_name = &serverAddr;
+        msgs[i].msg_hdr.msg_namelen = serverAddrLen;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent = 0;
+    while (sent < XP_CONTROL_COUNT) {
+        const int ret = sendmmsg(sockFd, &msgs[sent], XP_CONTROL_COUNT - sent, 0);
+        if (ret <= 0) {
+            break;
+        }
+        sent += ret;
+    }
+#else
+    for (int i = 0; i < XP_CONTROL_COUNT; i++) {
+        sendto(sockFd, iov[i].iov_base, iov[i].iov_len, 0, (struct sockaddr*)&serverAddr, serverAddrLen);
+    }
+#endif
 }
 
 static void* listenWorker(void* arg)
@@ -197,16 +273,14 @@ static void* listenWorker(void* arg)
             }
         }
 
-        sendDref("sim/operation/override/override_joystick", 1);
-        sendDref("sim/cockpit2/engine/actuators/throttle_ratio_all", motorValue);
-        sendDref("sim/joystick/yoke_roll_ratio", yokeValues[0]);
-        sendDref("sim/joystick/yoke_pitch_ratio", yokeValues[1]);
-        sendDref("sim/joystick/yoke_heading_ratio", yokeValues[2]);
-        sendDref("sim/cockpit2/engine/actuators/cowl_flap_ratio[0]", 0);
-        sendDref("sim/cockpit2/engine/actuators/cowl_flap_ratio[1]", 0);
-        sendDref("sim/cockpit2/engine/actuators/cowl_flap_ratio[2]", 0);
-        sendDref("sim/cockpit2/engine/actuators/cowl_flap_ratio[3]", 0);
-        sendDref("sim/cockpit2/engine/actuators/cowl_flap_ratio[4]", 0);
+        const float controls[XP_CONTROL_COUNT] = {
+            [XP_CONTROL_OVERRIDE_JOYSTICK] = 1,
+            [XP_CONTROL_THROTTLE] = motorValue,
+            [XP_CONTROL_YOKE_ROLL] = yokeValues[0],
+            [XP_CONTROL_YOKE_PITCH] = yokeValues[1],
+            [XP_CONTROL_YOKE_HEADING] = yokeValues[2],
+        };
+        sendControls(controls);
 
         recvLen = recvfrom(sockFd, buf, sizeof(buf), 0, (struct sockaddr*)&remoteAddr, &slen);
         if (recvLen < 0 && errno != EWOULDBLOCK) {
@@ -556,9 +630,12 @@ bool simXPlaneInit(char* ip, int port, uint8_t* mapping, uint8_t mapCount, bool
         return false;
     }
 
+    initControlPackets();
+
     if (pthread_create(&listenThread, NULL, listenWorker, NULL) < 0) {
         return false;
     }
+    listenThreadStarted = true;
 
     while (!initalized) {
         registerDref(DREF_LATITUDE, "sim/flightmodel/position/latitude", 100);
@@ -596,3 +673,18 @@ bool simXPlaneInit(char* ip, int port, uint8_t* mapping, uint8_t mapCount, bool
 
     return true;
 }
+
+void simXPlaneClose(void)
+{
+    if (listenThreadStarted) {
+        // Blocked in recvfrom() or sendto() most of the time, both are cancellation points
+        pthread_cancel(listenThread);
+        pthread_join(listenThread, NULL);
+        listenThreadStarted = false;
+    }
+
+    if (sockFd >= 0) {
+        close(sockFd);
+        sockFd = -1;
+    }
+}
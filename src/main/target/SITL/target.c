@@ -45,7 +45,12 @@
 #include "drivers/pwm_mapping.h"
 #include "drivers/timer.h"
 #include "drivers/serial.h"
+#include "drivers/serial_tcp.h"
 #include "config/config_streamer.h"
+#include "drivers/sdcard/sdcard_file.h"
+
+#include "target/SITL/trace_chrome.h"
+#include "target/SITL/vehicle.h"
 
 #include "target/SITL/sim/realFlight.h"
 #include "target/SITL/sim/xplane.h"
@@ -86,7 +91,11 @@ void systemInit(void) {
 
     if (pthread_mutex_init(&mainLoopLock, NULL) != 0) {
         fprintf(stderr, "[SYSTEM] Unable to create mainLoop lock.\n");
+#if defined(SITL_VEHICLE)
+        sitlVehicleExit(SITL_VEHICLE_FAILED);
+#else
         exit(1);
+#endif
     }
 
     if (sitlSim != SITL_SIM_NONE) {
@@ -100,7 +109,7 @@ void systemInit(void) {
                 sitlSim = SITL_SIM_NONE;
                 break;
             }
-            if (simRealFlightInit(simIp, pwmMapping, mappingCount, useImu)) {
+            if (simRealFlightInit(simIp, simPort, pwmMapping, mappingCount, useImu)) {
                 fprintf(stderr, "[SIM] Connection with RealFlight successfully established.\n");
             } else {
                 fprintf(stderr, "[SIM] Connection with RealFlight NOT established.\n");
@@ -165,6 +174,9 @@ void printCmdLineOptions(void)
 {
     fprintf(stderr, "Avaiable options:\n");
     fprintf(stderr, "--path=[path]                        Path and filename of eeprom.bin. If not specified 'eeprom.bin' in program directory is used.\n");
+    fprintf(stderr, "--sdcard=[path]                      Path and filename of a FAT formatted SD card image used for blackbox. If not specified 'sdcard.img' in program directory is used.\n");
+    fprintf(stderr, "--portoffset=[offset]                Offset added to the TCP ports of the UARTs, UART1 is on 5760 + offset.\n");
+    fprintf(stderr, "--trace=[path]                       Write a Chrome/Perfetto JSON trace of the main loop to the given file (open it in chrome://tracing or ui.perfetto.dev).\n");
     fprintf(stderr, "--sim=[rf|xp]                        Simulator interface: rf = RealFligt, xp = XPlane. Example: --sim=rf\n");
     fprintf(stderr, "--simip=[ip]                         IP-Address oft the simulator host. If not specified localhost (127.0.0.1) is used.\n");
     fprintf(stderr, "--simport=[port]                     Port oft the simulator host.\n");
@@ -192,6 +204,9 @@ void parseArguments(int argc, char *argv[])
             {"simport", required_argument, 0, 'p'},
             {"help", no_argument, 0, 'h'},
             {"path", required_argument, 0, 'e'},
+            {"sdcard", required_argument, 0, 'd'},
+            {"trace", required_argument, 0, 't'},
+            {"portoffset", required_argument, 0, 'o'},
             {NULL, 0, NULL, 0}
         };
 
@@ -214,7 +229,11 @@ void parseArguments(int argc, char *argv[])
                 if (!parseMapping(optarg) && sitlSim != SITL_SIM_NONE) {
                     fprintf(stderr, "[SIM] Invalid channel mapping string.\n");
                     printCmdLineOptions();
+#if defined(SITL_VEHICLE)
+                    sitlVehicleExit(SITL_VEHICLE_FAILED);
+#else
                     exit(0);
+#endif
                 }
                 break;
             case 'p':
@@ -231,9 +250,31 @@ void parseArguments(int argc, char *argv[])
                     fprintf(stderr, "[EEPROM] Invalid path, using eeprom file in program directory\n.");
                 }
                 break;
+            case 'd':
+                if (!sdcardFileSetPath(optarg)) {
+                    fprintf(stderr, "[SDCARD] Invalid path, using %s in program directory\n.", SDCARD_FILE_DEFAULT_PATH);
+                }
+                break;
+            case 't':
+#if defined(SITL_VEHICLE)
+                // The module can be unloaded before exit, the fleet host closes the trace through sitlVehicleStop()
+                traceChromeInit(optarg);
+#else
+                if (traceChromeInit(optarg)) {
+                    atexit(traceChromeClose);
+                }
+#endif
+                break;
+            case 'o':
+                tcpSetPortOffset(atoi(optarg));
+                break;
             case 'h':
                 printCmdLineOptions();
+#if defined(SITL_VEHICLE)
+                sitlVehicleExit(SITL_VEHICLE_FAILED);
+#else
                 exit(0);
+#endif
                 break;
         }
     }
@@ -284,24 +325,36 @@ void delay(timeMs_t ms)
 void systemReset(void)
 {
     fprintf(stderr, "[SYSTEM] Reset\n");
-#if defined(__CYGWIN__) || defined(__APPLE__) || GCC_MAJOR < 12
+    // The CLI reboot message is still in the tx buffer
+    tcpDrainAll(100);
+#if defined(SITL_VEHICLE)
+    sitlVehicleExit(SITL_VEHICLE_RESET);
+#elif defined(__CYGWIN__) || defined(__APPLE__) || GCC_MAJOR < 12
     for(int j = 3; j < 1024; j++) {
         close(j);
     }
 #else
     closefrom(3);
 #endif
+    traceChromeClose();
     execvp(c_argv[0], c_argv); // restart
 }
 
 void systemResetToBootloader(void)
 {
     fprintf(stderr, "[SYSTEM] Reset to bootloader\n");
+#if defined(SITL_VEHICLE)
+    sitlVehicleExit(SITL_VEHICLE_STOPPED);
+#else
     exit(0);
+#endif
 }
 
 void failureMode(failureMode_e mode) {
     fprintf(stderr, "[SYSTEM] Failure mode %d\n", mode);
+#if defined(SITL_VEHICLE)
+    sitlVehicleExit(SITL_VEHICLE_STOPPED);
+#endif
     while (true) {
         delay(1000);
     };
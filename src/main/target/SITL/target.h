@@ -68,6 +68,16 @@
 #define USE_GPS_FAKE
 #define USE_RANGEFINDER_FAKE
 #define USE_RX_SIM
+#define USE_POS_ESTIMATOR_EKF
+#define USE_MAG_ELLIPSOID_CALIBRATION
+
+// Blackbox to SD card, backed by an image file on the host
+#define USE_SDCARD
+#define USE_SDCARD_FILE
+
+// Event tracer, large enough for the Chrome trace writer thread to keep up
+#define USE_TRACE
+#define TRACE_BUFFER_SIZE 16384
 
 #undef USE_DASHBOARD
 
@@ -0,0 +1,167 @@
+/*
+ * This file is part of INAV Project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 3, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <platform.h>
+
+#ifdef USE_TRACE
+
+#include "build/trace.h"
+
+#include "common/utils.h"
+
+#include "scheduler/scheduler.h"
+
+#include "target/SITL/trace_chrome.h"
+
+#define TRACE_CHROME_POLL_US    20000
+
+static FILE *traceFd = NULL;
+static pthread_t traceThread;
+static volatile bool traceRunning = false;
+
+static uint32_t nextSequence;
+static uint32_t lastTimeUs;
+static uint64_t timeBaseUs;
+
+static const char * const tracePhaseNames[] = { "B", "E", "i" };
+
+static void traceChromeWriteEvent(const traceEvent_t *event)
+{
+    // The tracer keeps 32-bit timestamps, unwrap them here so long sessions stay in order
+    if (event->timeUs < lastTimeUs && lastTimeUs - event->timeUs > UINT32_MAX / 2) {
+        timeBaseUs += (uint64_t)UINT32_MAX + 1;
+    }
+    lastTimeUs = event->timeUs;
+
+    const char *name = traceGetEventName(event->id);
+    const char *category = "fc";
+
+    if (event->id == TRACE_EVENT_TASK) {
+        cfTaskInfo_t taskInfo;
+        getTaskInfo(event->arg, &taskInfo);
+        name = taskInfo.taskName;
+        category = "task";
+    } else if (event->id == TRACE_EVENT_BUS) {
+        category = "bus";
+    }
+
+    fprintf(traceFd, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%llu,\"pid\":1,\"tid\":1",
+        name, category, tracePhaseNames[event->phase], (unsigned long long)(timeBaseUs + event->timeUs));
+
+    if (event->phase == TRACE_PHASE_INSTANT) {
+        fprintf(traceFd, ",\"s\":\"t\"");
+    }
+    if (event->id == TRACE_EVENT_BUS) {
+        fprintf(traceFd, ",\"args\":{\"device\":%u}", event->arg);
+    }
+
+    fprintf(traceFd, "},\n");
+}
+
+static void traceChromeDrain(void)
+{
+    const uint32_t head = traceGetHead();
+    const uint32_t tail = traceGetTail();
+
+    if (nextSequence < tail) {
+        fprintf(stderr, "[TRACE] %u events lost, main loop is outrunning the trace writer\n", (unsigned)(tail - nextSequence));
+        nextSequence = tail;
+    }
+
+    traceEvent_t event;
+    while (nextSequence < head) {
+        if (traceGetEvent(nextSequence, &event)) {
+            traceChromeWriteEvent(&event);
+        } else if (nextSequence >= traceGetTail()) {
+            // Still being recorded, come back for it next time
+            break;
+        }
+        nextSequence++;
+    }
+
+    fflush(traceFd);
+}
+
+static void *traceChromeThread(void *data)
+{
+    UNUSED(data);
+
+    while (traceRunning) {
+        traceChromeDrain();
+        usleep(TRACE_CHROME_POLL_US);
+    }
+
+    return NULL;
+}
+
+bool traceChromeInit(const char *path)
+{
+    traceFd = fopen(path, "w");
+    if (!traceFd) {
+        fprintf(stderr, "[TRACE] Unable to create trace file '%s'\n", path);
+        return false;
+    }
+
+    // JSON array format, Chrome and Perfetto accept the file even if it's cut short by killing SITL
+    fprintf(traceFd, "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"INAV SITL\"}},\n");
+    fprintf(traceFd, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main loop\"}},\n");
+
+    nextSequence = traceGetTail();
+
+    traceRunning = true;
+    if (pthread_create(&traceThread, NULL, traceChromeThread, NULL) != 0) {
+        fprintf(stderr, "[TRACE] Unable to start trace writer\n");
+        traceRunning = false;
+        fclose(traceFd);
+        traceFd = NULL;
+        return false;
+    }
+
+    fprintf(stderr, "[TRACE] Writing Chrome trace to '%s'\n", path);
+    return true;
+}
+
+void traceChromeClose(void)
+{
+    if (!traceRunning) {
+        return;
+    }
+
+    traceRunning = false;
+    pthread_join(traceThread, NULL);
+
+    traceChromeDrain();
+    fprintf(traceFd, "{\"name\":\"trace_end\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%llu,\"pid\":1,\"tid\":1}\n]\n",
+        (unsigned long long)(timeBaseUs + lastTimeUs));
+    fclose(traceFd);
+    traceFd = NULL;
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * This file is part of INAV Project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 3, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <setjmp.h>
+
+#include <platform.h>
+
+#if defined(SITL_VEHICLE)
+
+#include "drivers/serial.h"
+#include "drivers/serial_tcp.h"
+
+#include "fc/config.h"
+#include "fc/fc_init.h"
+
+#include "scheduler/scheduler.h"
+
+#include "target/SITL/trace_chrome.h"
+#include "target/SITL/vehicle.h"
+
+#include "target/SITL/sim/realFlight.h"
+#include "target/SITL/sim/xplane.h"
+
+#define SITL_VEHICLE_EXPORT __attribute__((visibility("default")))
+
+// Where sitlVehicleExit() continues, in the entry point the host called
+static jmp_buf vehicleExitJump;
+static sitlVehicleState_e vehicleState = SITL_VEHICLE_RUNNING;
+
+static uint64_t vehiclePasses;
+static uint64_t vehicleTasks;
+
+void sitlVehicleExit(sitlVehicleState_e state)
+{
+    vehicleState = state;
+    longjmp(vehicleExitJump, 1);
+}
+
+SITL_VEHICLE_EXPORT int sitlVehicleApiVersion(void)
+{
+    return SITL_VEHICLE_API_VERSION;
+}
+
+SITL_VEHICLE_EXPORT sitlVehicleState_e sitlVehicleInit(int argc, char *argv[])
+{
+    if (setjmp(vehicleExitJump)) {
+        return vehicleState;
+    }
+
+    parseArguments(argc, argv);
+    init();
+
+    return vehicleState;
+}
+
+SITL_VEHICLE_EXPORT sitlVehicleState_e sitlVehicleRun(uint32_t maxPasses, bool *idle)
+{
+    *idle = false;
+
+    if (vehicleState != SITL_VEHICLE_RUNNING) {
+        return vehicleState;
+    }
+
+    if (setjmp(vehicleExitJump)) {
+        return vehicleState;
+    }
+
+    for (uint32_t pass = 0; pass < maxPasses; pass++) {
+        scheduler();
+        tcpFlushAll();
+
+        vehiclePasses++;
+        if (schedulerLastPassWasIdle()) {
+            *idle = true;
+            break;
+        }
+        vehicleTasks++;
+    }
+
+    return vehicleState;
+}
+
+SITL_VEHICLE_EXPORT void sitlVehicleStop(void)
+{
+    tcpCloseAll();
+    simXPlaneClose();
+    simRealFlightClose();
+    traceChromeClose();
+}
+
+SITL_VEHICLE_EXPORT void sitlVehicleGetStats(sitlVehicleStats_t *stats)
+{
+    stats->passes = vehiclePasses;
+    stats->tasks = vehicleTasks;
+    stats->looptimeUs = getLooptime();
+    stats->pidDeltaUs = getTaskDeltaTime(TASK_PID);
+    stats->systemLoadPercent = averageSystemLoadPercent;
+}
+
+#endif
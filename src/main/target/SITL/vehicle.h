@@ -0,0 +1,73 @@
+/*
+ * This file is part of INAV Project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 3, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * SITL built as a loadable vehicle module (SITL_VEHICLE) for the fleet host, which runs many vehicles in one process.
+ * All firmware state is private to one loaded copy of the module, the host loads one copy per vehicle and runs the
+ * main loop itself. Only one thread at a time may call into a vehicle.
+ *
+ * Shared between the module and the host, no firmware headers here.
+ */
+
+#define SITL_VEHICLE_API_VERSION    2
+
+typedef enum {
+    SITL_VEHICLE_RUNNING = 0,
+    SITL_VEHICLE_RESET,         // Reboot requested, the host loads the vehicle again
+    SITL_VEHICLE_STOPPED,       // Reset to bootloader or failure mode, the vehicle doesn't run any more
+    SITL_VEHICLE_FAILED,        // Invalid arguments or start up failure, the vehicle couldn't be started
+} sitlVehicleState_e;
+
+typedef struct sitlVehicleStats_s {
+    uint64_t passes;            // Scheduler passes
+    uint64_t tasks;             // Passes that ran a task
+    uint32_t looptimeUs;        // Configured PID loop time
+    uint32_t pidDeltaUs;        // Latest time between two runs of the PID task
+    uint16_t systemLoadPercent;
+} sitlVehicleStats_t;
+
+typedef int (*sitlVehicleApiVersionFn)(void);
+// Takes the SITL command line, returns once the firmware is initialised
+typedef sitlVehicleState_e (*sitlVehicleInitFn)(int argc, char *argv[]);
+// Runs up to maxPasses passes of the main loop, less if a pass finds no task to run. idle is set in that case.
+typedef sitlVehicleState_e (*sitlVehicleRunFn)(uint32_t maxPasses, bool *idle);
+// Stops the threads and closes the sockets of the vehicle, before the module is unloaded
+typedef void (*sitlVehicleStopFn)(void);
+typedef void (*sitlVehicleGetStatsFn)(sitlVehicleStats_t *stats);
+
+#define SITL_VEHICLE_API_VERSION_SYMBOL "sitlVehicleApiVersion"
+#define SITL_VEHICLE_INIT_SYMBOL        "sitlVehicleInit"
+#define SITL_VEHICLE_RUN_SYMBOL         "sitlVehicleRun"
+#define SITL_VEHICLE_STOP_SYMBOL        "sitlVehicleStop"
+#define SITL_VEHICLE_GET_STATS_SYMBOL   "sitlVehicleGetStats"
+
+#if defined(SITL_VEHICLE)
+// Leaves the main loop of the vehicle, called instead of restarting or stopping the process
+void sitlVehicleExit(sitlVehicleState_e state) __attribute__((noreturn));
+#endif
@@ -43,6 +43,7 @@
 #define USE_SERIALRX_FPORT2
 
 //#define USE_DEV_TOOLS           // tools for dev use only. Undefine for release builds.
+//#define USE_TRACE               // Event tracer dumpable over MSP2_INAV_TRACE, see build/trace.h
 
 #define COMMON_DEFAULT_FEATURES (FEATURE_TX_PROF_SEL)
 
@@ -50,7 +51,6 @@
 #define USE_SERVO_SBUS
 #endif
 
-#define USE_ADC_AVERAGING
 #define USE_64BIT_TIME
 #define USE_BLACKBOX
 #define USE_GPS
@@ -191,5 +191,7 @@
 #define USE_SERIALRX_SUMD
 #define USE_TELEMETRY_HOTT
 #define USE_HOTT_TEXTMODE
+#define USE_POS_ESTIMATOR_EKF
+#define USE_MAG_ELLIPSOID_CALIBRATION
 
 #endif
@@ -316,9 +316,12 @@
     #if !defined(VL53L0X_I2C_BUS) && defined(RANGEFINDER_I2C_BUS)
         #define VL53L0X_I2C_BUS RANGEFINDER_I2C_BUS
     #endif
+    #if !defined(VL53L0X_INT_PIN)
+        #define VL53L0X_INT_PIN NONE
+    #endif
 
     #if defined(VL53L0X_I2C_BUS)
-    BUSDEV_REGISTER_I2C(busdev_vl53l0x,     DEVHW_VL53L0X,      VL53L0X_I2C_BUS,    0x29,               NONE,           DEVFLAGS_NONE,  0);
+    BUSDEV_REGISTER_I2C(busdev_vl53l0x,     DEVHW_VL53L0X,      VL53L0X_I2C_BUS,    0x29,               VL53L0X_INT_PIN, DEVFLAGS_NONE,  0);
     #endif
 #endif
 
@@ -326,9 +329,12 @@
     #if !defined(VL53L1X_I2C_BUS) && defined(RANGEFINDER_I2C_BUS)
         #define VL53L1X_I2C_BUS RANGEFINDER_I2C_BUS
     #endif
+    #if !defined(VL53L1X_INT_PIN)
+        #define VL53L1X_INT_PIN NONE
+    #endif
 
     #if defined(VL53L1X_I2C_BUS)
-    BUSDEV_REGISTER_I2C(busdev_vl53l1x,     DEVHW_VL53L1X,      VL53L1X_I2C_BUS,    0x29,               NONE,           DEVFLAGS_USE_RAW_REGISTERS,  0);
+    BUSDEV_REGISTER_I2C(busdev_vl53l1x,     DEVHW_VL53L1X,      VL53L1X_I2C_BUS,    0x29,               VL53L1X_INT_PIN, DEVFLAGS_USE_RAW_REGISTERS,  0);
     #endif
 #endif
 
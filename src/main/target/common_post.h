@@ -48,7 +48,12 @@ extern uint8_t __config_end;
 #define USE_BARO_MSP
 #endif
 
-#ifdef USE_ESC_SENSOR
+// Needs the timer DMA input capture turnaround, only the F4 timer driver has it so far
+#if defined(USE_DSHOT) && defined(STM32F4)
+    #define USE_DSHOT_BIDIR
+#endif
+
+#if defined(USE_ESC_SENSOR) || defined(USE_DSHOT_BIDIR)
     #define USE_RPM_FILTER
 #endif
 
@@ -1067,31 +1067,44 @@ static bool handleIncoming_RC_CHANNELS_OVERRIDE(void) {
     return true;
 }
 
+static bool handleIncomingMAVLinkMessage(void)
+{
+    switch (mavRecvMsg.msgid) {
+        case MAVLINK_MSG_ID_MISSION_CLEAR_ALL:
+            return handleIncoming_MISSION_CLEAR_ALL();
+        case MAVLINK_MSG_ID_MISSION_COUNT:
+            return handleIncoming_MISSION_COUNT();
+        case MAVLINK_MSG_ID_MISSION_ITEM:
+            return handleIncoming_MISSION_ITEM();
+        case MAVLINK_MSG_ID_MISSION_REQUEST_LIST:
+            return handleIncoming_MISSION_REQUEST_LIST();
+        case MAVLINK_MSG_ID_MISSION_REQUEST:
+            return handleIncoming_MISSION_REQUEST();
+        case MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE:
+            return handleIncoming_RC_CHANNELS_OVERRIDE();
+        default:
+            return false;
+    }
+}
+
 static bool processMAVLinkIncomingTelemetry(void)
 {
-    while (serialRxBytesWaiting(mavlinkPort) > 0) {
+    const uint8_t *data;
+    uint32_t count;
+
+    while ((count = serialRxPeek(mavlinkPort, &data)) > 0) {
+        uint32_t processed = 0;
+        bool messageReceived = false;
+
+        while (processed < count && !messageReceived) {
+            messageReceived = mavlink_parse_char(0, data[processed++], &mavRecvMsg, &mavRecvStatus) == MAVLINK_FRAMING_OK;
+        }
+
+        serialRxConsume(mavlinkPort, processed);
+
         // Limit handling to one message per cycle
-        char c = serialRead(mavlinkPort);
-        uint8_t result = mavlink_parse_char(0, c, &mavRecvMsg, &mavRecvStatus);
-        if (result == MAVLINK_FRAMING_OK) {
-            switch (mavRecvMsg.msgid) {
-                case MAVLINK_MSG_ID_HEARTBEAT:
-                    break;
-                case MAVLINK_MSG_ID_MISSION_CLEAR_ALL:
-                    return handleIncoming_MISSION_CLEAR_ALL();
-                case MAVLINK_MSG_ID_MISSION_COUNT:
-                    return handleIncoming_MISSION_COUNT();
-                case MAVLINK_MSG_ID_MISSION_ITEM:
-                    return handleIncoming_MISSION_ITEM();
-                case MAVLINK_MSG_ID_MISSION_REQUEST_LIST:
-                    return handleIncoming_MISSION_REQUEST_LIST();
-                case MAVLINK_MSG_ID_MISSION_REQUEST:
-                    return handleIncoming_MISSION_REQUEST();
-                case MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE:
-                    return handleIncoming_RC_CHANNELS_OVERRIDE();
-                default:
-                    return false;
-            }
+        if (messageReceived && mavRecvMsg.msgid != MAVLINK_MSG_ID_HEARTBEAT) {
+            return handleIncomingMAVLinkMessage();
         }
     }
 
@@ -275,9 +275,23 @@ uint32_t CDC_Send_FreeBytes(void)
  * Output         : None.
  * Return         : None.
  *******************************************************************************/
+static uint8_t receiveOffset = 0;
+
+static void CDC_Receive_Advance(uint32_t len)
+{
+    receiveLength -= len;
+    receiveOffset += len;
+
+    /* re-enable the rx endpoint which we had set to receive 0 bytes */
+    if (receiveLength == 0) {
+        SetEPRxCount(ENDP3, 64);
+        SetEPRxStatus(ENDP3, EP_RX_VALID);
+        receiveOffset = 0;
+    }
+}
+
 uint32_t CDC_Receive_DATA(uint8_t* recvBuf, uint32_t len)
 {
-    static uint8_t offset = 0;
     uint8_t i;
 
     if (len > receiveLength) {
@@ -285,22 +299,27 @@ uint32_t CDC_Receive_DATA(uint8_t* recvBuf, uint32_t len)
     }
 
     for (i = 0; i < len; i++) {
-        recvBuf[i] = (uint8_t)(receiveBuffer[i + offset]);
+        recvBuf[i] = (uint8_t)(receiveBuffer[i + receiveOffset]);
     }
 
-    receiveLength -= len;
-    offset += len;
-
-    /* re-enable the rx endpoint which we had set to receive 0 bytes */
-    if (receiveLength == 0) {
-        SetEPRxCount(ENDP3, 64);
-        SetEPRxStatus(ENDP3, EP_RX_VALID);
-        offset = 0;
-    }
+    CDC_Receive_Advance(len);
 
     return len;
 }
 
+uint32_t CDC_Receive_Peek(const uint8_t **data)
+{
+    *data = (const uint8_t *)&receiveBuffer[receiveOffset];
+    return receiveLength;
+}
+
+void CDC_Receive_Consume(uint32_t len)
+{
+    if (len) {
+        CDC_Receive_Advance(len);
+    }
+}
+
 uint32_t CDC_Receive_BytesAvailable(void)
 {
     return receiveLength;
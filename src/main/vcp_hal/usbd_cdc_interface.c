@@ -359,6 +359,25 @@ uint32_t CDC_Receive_DATA(uint8_t* recvBuf, uint32_t len)
     return count;
 }
 
+uint32_t CDC_Receive_Peek(const uint8_t **data)
+{
+    *data = rxBuffPtr;
+    return rxBuffPtr != NULL ? rxAvailable : 0;
+}
+
+void CDC_Receive_Consume(uint32_t len)
+{
+    if (rxBuffPtr == NULL || len == 0) {
+        return;
+    }
+
+    rxBuffPtr += len;
+    rxAvailable -= len;
+    if (rxAvailable < 1) {
+        USBD_CDC_ReceivePacket(&USBD_Device);
+    }
+}
+
 uint32_t CDC_Receive_BytesAvailable(void)
 {
     return rxAvailable;
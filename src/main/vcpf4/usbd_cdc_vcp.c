@@ -240,6 +240,19 @@ uint32_t CDC_Receive_DATA(uint8_t* recvBuf, uint32_t len)
     return count;
 }
 
+uint32_t CDC_Receive_Peek(const uint8_t **data)
+{
+    const uint32_t in = APP_Tx_ptr_in;
+
+    *data = &APP_Tx_Buffer[APP_Tx_ptr_out];
+    return in >= APP_Tx_ptr_out ? in - APP_Tx_ptr_out : APP_TX_DATA_SIZE - APP_Tx_ptr_out;
+}
+
+void CDC_Receive_Consume(uint32_t len)
+{
+    APP_Tx_ptr_out = (APP_Tx_ptr_out + len) % APP_TX_DATA_SIZE;
+}
+
 uint32_t CDC_Receive_BytesAvailable(void)
 {
     /* return the bytes available in the receive circular buffer */
@@ -0,0 +1,864 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Gyro filter replay bench. Feeds a recorded (or synthetic) gyro signal through the gyro filter chain of the
+ * firmware, built from the same sources, and compares filter configurations side by side: noise left after
+ * filtering, group delay and the time the filters take per sample.
+ *
+ * Inputs:
+ *  - gyro capture logs (blackbox_gyro_capture), gyro only
+ *  - CSV as written by blackbox_decode: "time (us)", "gyroRaw[0..2]" (or "gyroADC[0..2]"), optionally
+ *    "axisRate[0..2]" for the Kalman setpoint and "rpm[n]" or "eRPM[n]" per motor for the RPM filter
+ *  - --synthetic <seconds>, stick motion, motor noise and white noise with known motor RPM
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <complex>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox_gyro_capture.h"
+    #include "blackbox/blackbox_io.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/filter.h"
+    #include "common/utils.h"
+
+    #include "drivers/accgyro/accgyro_fake.h"
+
+    #include "fc/runtime_config.h"
+
+    #include "flight/kalman.h"
+    #include "flight/mixer.h"
+    #include "flight/rpm_filter.h"
+
+    #include "io/beeper.h"
+
+    #include "scheduler/scheduler.h"
+
+    #include "sensors/esc_sensor.h"
+    #include "sensors/gyro.h"
+    #include "sensors/sensors.h"
+
+    extern const gyroConfig_t pgResetTemplate_gyroConfig;
+    extern const rpmFilterConfig_t pgResetTemplate_rpmFilterConfig;
+}
+
+#define FAKE_GYRO_SCALE     0.0625f     // deg/s per LSB of the fake gyro driver
+#define SPECTRUM_RESOLUTION_HZ  2       // Welch segments are the next power of two long enough for this
+#define MAX_DELAY_MS        30
+
+typedef std::array<float, XYZ_AXIS_COUNT> axisSample_t;
+
+typedef struct replayLog_s {
+    std::string description;
+    uint32_t sampleIntervalUs;
+    std::vector<axisSample_t> gyro;             // deg/s
+    std::vector<axisSample_t> setpoint;         // deg/s, empty if not in the log
+    int motorCount;
+    std::vector<std::vector<float>> motorRpm;   // Per sample, mechanical RPM
+} replayLog_t;
+
+typedef struct benchConfig_s {
+    std::string description;
+    gyroConfig_t gyro;
+    rpmFilterConfig_t rpm;
+} benchConfig_t;
+
+typedef struct replayResult_s {
+    uint32_t looptimeUs;
+    std::vector<float> input[XYZ_AXIS_COUNT];   // At the PID rate
+    std::vector<float> output[XYZ_AXIS_COUNT];
+    double nsPerGyroSample;
+    double nsPerLoop;
+} replayResult_t;
+
+// State the firmware gets from other modules, set up by the replay
+static timeDelta_t benchGyroLooptime;
+static timeDelta_t benchLooptime;
+static uint8_t benchMotorCount;
+static escSensorData_t benchEscData[MAX_SUPPORTED_MOTORS];
+
+/*
+ * Logs
+ */
+
+static bool loadCapture(const std::vector<uint8_t> &data, replayLog_t *log)
+{
+    gyroCaptureHeader_t header;
+    if (!gyroCaptureDecodeHeader(data.data(), data.size(), &header)) {
+        return false;
+    }
+
+    log->sampleIntervalUs = header.sampleIntervalUs;
+    log->motorCount = 0;
+
+    axisSample_t last = {{ 0, 0, 0 }};
+    for (size_t offset = GYRO_CAPTURE_HEADER_SIZE; offset + GYRO_CAPTURE_RECORD_SIZE <= data.size(); offset += GYRO_CAPTURE_RECORD_SIZE) {
+        int16_t values[XYZ_AXIS_COUNT];
+
+        switch (gyroCaptureDecodeRecord(&data[offset], values)) {
+        case GYRO_CAPTURE_RECORD_SAMPLE:
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                last[axis] = values[axis] * header.scale;
+            }
+            log->gyro.push_back(last);
+            break;
+        case GYRO_CAPTURE_RECORD_GAP:
+            // Hold the last sample to keep the time base, the gap shows up as low frequency content only
+            log->gyro.insert(log->gyro.end(), values[2], last);
+            break;
+        case GYRO_CAPTURE_RECORD_END:
+            return true;
+        default:
+            fprintf(stderr, "Corrupt capture record at offset %zu\n", offset);
+            return !log->gyro.empty();
+        }
+    }
+
+    fprintf(stderr, "Capture has no END record, it was cut short\n");
+    return true;
+}
+
+static std::string trim(const std::string &s)
+{
+    const size_t start = s.find_first_not_of(" \t\r\"");
+    const size_t end = s.find_last_not_of(" \t\r\"");
+    return start == std::string::npos ? "" : s.substr(start, end - start + 1);
+}
+
+static std::vector<std::string> splitCsv(const std::string &line)
+{
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+
+    while (std::getline(ss, field, ',')) {
+        fields.push_back(trim(field));
+    }
+    return fields;
+}
+
+static bool loadCsv(std::ifstream &file, replayLog_t *log, int motorPoles)
+{
+    std::string line;
+    if (!std::getline(file, line)) {
+        return false;
+    }
+
+    const std::vector<std::string> names = splitCsv(line);
+    auto column = [&names](const std::string &name) {
+        auto it = std::find(names.begin(), names.end(), name);
+        return it == names.end() ? -1 : (int)(it - names.begin());
+    };
+    auto axisColumns = [&column](const char *name, int *columns) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            columns[axis] = column(std::string(name) + "[" + std::to_string(axis) + "]");
+            if (columns[axis] < 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    const int timeColumn = column("time (us)") >= 0 ? column("time (us)") : column("time");
+    int gyroColumns[XYZ_AXIS_COUNT];
+    int setpointColumns[XYZ_AXIS_COUNT];
+    if (timeColumn < 0 || !(axisColumns("gyroRaw", gyroColumns) || axisColumns("gyroADC", gyroColumns))) {
+        fprintf(stderr, "CSV needs time and gyroRaw[0..2] or gyroADC[0..2] columns\n");
+        return false;
+    }
+    const bool hasSetpoint = axisColumns("axisRate", setpointColumns);
+
+    // Mechanical RPM if available, eRPM otherwise
+    std::vector<int> rpmColumns;
+    float rpmScale = 1.0f;
+    for (int motor = 0; motor < MAX_SUPPORTED_MOTORS && column("rpm[" + std::to_string(motor) + "]") >= 0; motor++) {
+        rpmColumns.push_back(column("rpm[" + std::to_string(motor) + "]"));
+    }
+    if (rpmColumns.empty()) {
+        for (int motor = 0; motor < MAX_SUPPORTED_MOTORS && column("eRPM[" + std::to_string(motor) + "]") >= 0; motor++) {
+            rpmColumns.push_back(column("eRPM[" + std::to_string(motor) + "]"));
+        }
+        rpmScale = 2.0f / motorPoles;
+    }
+    log->motorCount = rpmColumns.size();
+
+    std::vector<uint32_t> intervals;
+    double lastTime = -1;
+
+    while (std::getline(file, line)) {
+        const std::vector<std::string> fields = splitCsv(line);
+        if (fields.size() < names.size()) {
+            continue;
+        }
+
+        const double time = atof(fields[timeColumn].c_str());
+        if (lastTime >= 0 && time > lastTime) {
+            intervals.push_back(time - lastTime);
+        }
+        lastTime = time;
+
+        axisSample_t gyroSample, setpointSample;
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyroSample[axis] = atof(fields[gyroColumns[axis]].c_str());
+            if (hasSetpoint) {
+                setpointSample[axis] = atof(fields[setpointColumns[axis]].c_str());
+            }
+        }
+        log->gyro.push_back(gyroSample);
+        if (hasSetpoint) {
+            log->setpoint.push_back(setpointSample);
+        }
+
+        std::vector<float> rpm;
+        for (int c : rpmColumns) {
+            rpm.push_back(atof(fields[c].c_str()) * rpmScale);
+        }
+        log->motorRpm.push_back(rpm);
+    }
+
+    if (intervals.empty()) {
+        return false;
+    }
+
+    // Logging can skip iterations now and then, the typical interval is the rate
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    log->sampleIntervalUs = intervals[intervals.size() / 2];
+    return true;
+}
+
+static bool loadLog(const char *path, replayLog_t *log, int motorPoles)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "Can't open %s\n", path);
+        return false;
+    }
+
+    log->description = path;
+
+    char magic[GYRO_CAPTURE_MAGIC_LENGTH];
+    if (file.read(magic, sizeof(magic)) && memcmp(magic, GYRO_CAPTURE_MAGIC, GYRO_CAPTURE_MAGIC_LENGTH) == 0) {
+        file.seekg(0);
+        const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return loadCapture(data, log);
+    }
+
+    file.clear();
+    file.seekg(0);
+    return loadCsv(file, log, motorPoles);
+}
+
+static void makeSyntheticLog(float seconds, replayLog_t *log)
+{
+    std::mt19937 rng(1234);
+    std::normal_distribution<float> noise(0.0f, 2.0f);
+
+    log->description = "synthetic";
+    log->sampleIntervalUs = 250;
+    log->motorCount = 4;
+
+    const int samples = seconds * 1e6f / log->sampleIntervalUs;
+    const float motionK = pt2FilterGain(20.0f, log->sampleIntervalUs * 1e-6f);
+    std::normal_distribution<float> stick(0.0f, 1000.0f);
+    float motionState[XYZ_AXIS_COUNT][2] = {{ 0 }};
+    float phase[4] = { 0, 0, 0, 0 };
+
+    for (int i = 0; i < samples; i++) {
+        const float t = i * log->sampleIntervalUs * 1e-6f;
+
+        // Stick input the filters should pass, broadband up to ~20Hz so the delay can be measured
+        axisSample_t motion;
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            motionState[axis][0] += (stick(rng) - motionState[axis][0]) * motionK;
+            motionState[axis][1] += (motionState[axis][0] - motionState[axis][1]) * motionK;
+            motion[axis] = motionState[axis][1];
+        }
+
+        // Motors sweeping between 6000 and 18000 RPM, slightly apart from each other
+        std::vector<float> rpm;
+        axisSample_t gyro = motion;
+        for (int motor = 0; motor < log->motorCount; motor++) {
+            rpm.push_back(12000.0f + 6000.0f * sinf(2 * M_PIf * 0.2f * t) + motor * 150.0f);
+            phase[motor] += 2 * M_PIf * rpm[motor] / 60.0f * log->sampleIntervalUs * 1e-6f;
+
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                gyro[axis] += 8.0f * sinf(phase[motor] + axis) + 3.0f * sinf(2 * phase[motor] + axis);
+            }
+        }
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyro[axis] += noise(rng);
+        }
+
+        log->gyro.push_back(gyro);
+        log->setpoint.push_back(motion);
+        log->motorRpm.push_back(rpm);
+    }
+}
+
+/*
+ * Configurations, "name=value,name=value" using the CLI setting names
+ */
+
+static bool parseValue(const std::string &value, const std::vector<const char *> &names, int *result)
+{
+    for (size_t i = 0; i < names.size(); i++) {
+        if (strcasecmp(value.c_str(), names[i]) == 0) {
+            *result = i;
+            return true;
+        }
+    }
+
+    char *end;
+    *result = strtol(value.c_str(), &end, 10);
+    return !value.empty() && *end == '\0';
+}
+
+static bool applySetting(benchConfig_t *config, const std::string &name, const std::string &value)
+{
+    static const std::vector<const char *> offOn = { "OFF", "ON" };
+    static const std::vector<const char *> filterType = { "PT1", "BIQUAD" };
+    static const std::vector<const char *> notchMode = { "2D", "3D_R", "3D_P", "3D_Y", "3D_RP", "3D_RY", "3D_PY", "3D" };
+    static const std::vector<const char *> none = {};
+
+    gyroConfig_t *gyro = &config->gyro;
+    rpmFilterConfig_t *rpm = &config->rpm;
+    int v;
+
+#define BENCH_SETTING(_name, _field, _names)                            \
+    if (name == _name) {                                                \
+        if (!parseValue(value, _names, &v)) {                           \
+            return false;                                               \
+        }                                                               \
+        _field = v;                                                     \
+        return true;                                                    \
+    }
+
+    BENCH_SETTING("looptime", gyro->looptime, none);
+    BENCH_SETTING("gyro_anti_aliasing_lpf_hz", gyro->gyro_anti_aliasing_lpf_hz, none);
+    BENCH_SETTING("gyro_anti_aliasing_lpf_type", gyro->gyro_anti_aliasing_lpf_type, filterType);
+    BENCH_SETTING("gyro_main_lpf_hz", gyro->gyro_main_lpf_hz, none);
+    BENCH_SETTING("gyro_main_lpf_type", gyro->gyro_main_lpf_type, filterType);
+    BENCH_SETTING("dynamic_gyro_notch_enabled", gyro->dynamicGyroNotchEnabled, offOn);
+    BENCH_SETTING("dynamic_gyro_notch_q", gyro->dynamicGyroNotchQ, none);
+    BENCH_SETTING("dynamic_gyro_notch_min_hz", gyro->dynamicGyroNotchMinHz, none);
+    BENCH_SETTING("dynamic_gyro_notch_mode", gyro->dynamicGyroNotchMode, notchMode);
+    BENCH_SETTING("dynamic_gyro_notch_3d_q", gyro->dynamicGyroNotch3dQ, none);
+    BENCH_SETTING("setpoint_kalman_enabled", gyro->kalmanEnabled, offOn);
+    BENCH_SETTING("setpoint_kalman_q", gyro->kalman_q, none);
+    BENCH_SETTING("rpm_gyro_filter_enabled", rpm->gyro_filter_enabled, offOn);
+    BENCH_SETTING("rpm_gyro_harmonics", rpm->gyro_harmonics, none);
+    BENCH_SETTING("rpm_gyro_min_hz", rpm->gyro_min_hz, none);
+    BENCH_SETTING("rpm_gyro_q", rpm->gyro_q, none);
+
+#undef BENCH_SETTING
+
+    return false;
+}
+
+static bool parseConfig(const std::string &spec, benchConfig_t *config)
+{
+    config->description = spec.empty() ? "defaults" : spec;
+    config->gyro = pgResetTemplate_gyroConfig;
+    config->rpm = pgResetTemplate_rpmFilterConfig;
+
+    // The log is already calibrated
+    config->gyro.init_gyro_cal_enabled = false;
+
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim(item);
+        if (item.empty()) {
+            continue;
+        }
+
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos || !applySetting(config, trim(item.substr(0, eq)), trim(item.substr(eq + 1)))) {
+            fprintf(stderr, "Unknown setting or bad value: %s\n", item.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Replay
+ */
+
+static void replay(const replayLog_t &log, const benchConfig_t &config, replayResult_t *result)
+{
+    *gyroConfigMutable() = config.gyro;
+    *rpmFilterConfigMutable() = config.rpm;
+
+    const int loopDenom = MAX(1, (int)lrintf((float)config.gyro.looptime / log.sampleIntervalUs));
+    benchGyroLooptime = log.sampleIntervalUs;
+    benchLooptime = log.sampleIntervalUs * loopDenom;
+    result->looptimeUs = benchLooptime;
+
+    benchMotorCount = log.motorCount;
+    stateFlags = log.motorCount > 0 ? ESC_SENSOR_ENABLED : 0;
+    memset(benchEscData, 0, sizeof(benchEscData));
+
+    gyroInit();
+    // Same order as fc_init, the RPM filter is off unless rpmFiltersInit() finds a source
+    disableRpmFilters();
+    rpmFiltersInit();
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        result->input[axis].clear();
+        result->output[axis].clear();
+        result->input[axis].reserve(log.gyro.size() / loopDenom + 1);
+        result->output[axis].reserve(log.gyro.size() / loopDenom + 1);
+    }
+
+    // The RPM filter task runs on its own schedule
+    const uint32_t rpmUpdateSamples = MAX(1, (int)lrintf(RPM_FILTER_UPDATE_RATE_US / log.sampleIntervalUs));
+    size_t loops = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < log.gyro.size(); i++) {
+        fakeGyroSet(
+            constrain(lrintf(log.gyro[i][X] / FAKE_GYRO_SCALE), INT16_MIN, INT16_MAX),
+            constrain(lrintf(log.gyro[i][Y] / FAKE_GYRO_SCALE), INT16_MIN, INT16_MAX),
+            constrain(lrintf(log.gyro[i][Z] / FAKE_GYRO_SCALE), INT16_MIN, INT16_MAX)
+        );
+
+        gyroUpdate();
+
+        if (log.motorCount > 0 && i % rpmUpdateSamples == 0) {
+            for (int motor = 0; motor < log.motorCount; motor++) {
+                benchEscData[motor].rpm = log.motorRpm[i][motor];
+            }
+            rpmFilterUpdateTask(0);
+        }
+
+        if ((i + 1) % loopDenom == 0) {
+            if (!log.setpoint.empty()) {
+                for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                    gyroKalmanUpdateSetpoint(axis, log.setpoint[i][axis]);
+                }
+            }
+
+            gyroFilter();
+            loops++;
+
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                result->input[axis].push_back(gyro.gyroRaw[axis]);
+                result->output[axis].push_back(gyro.gyroADCf[axis]);
+            }
+        }
+    }
+
+    const double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    result->nsPerGyroSample = elapsedNs / MAX(log.gyro.size(), (size_t)1);
+    result->nsPerLoop = elapsedNs / MAX(loops, (size_t)1);
+}
+
+/*
+ * Analysis
+ */
+
+static void fft(std::vector<std::complex<double>> &x)
+{
+    const size_t n = x.size();
+
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(x[i], x[j]);
+        }
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const std::complex<double> w = std::polar(1.0, -2 * M_PI / len);
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<double> wn = 1;
+            for (size_t k = 0; k < len / 2; k++) {
+                const std::complex<double> u = x[i + k];
+                const std::complex<double> v = x[i + k + len / 2] * wn;
+                x[i + k] = u + v;
+                x[i + k + len / 2] = u - v;
+                wn *= w;
+            }
+        }
+    }
+}
+
+static size_t spectrumSegment(double sampleRateHz)
+{
+    size_t segment = 16;
+    while (sampleRateHz / segment > SPECTRUM_RESOLUTION_HZ) {
+        segment <<= 1;
+    }
+    return segment;
+}
+
+// Welch power spectral density, (deg/s)^2/Hz, in bins of sampleRateHz / spectrumSegment()
+static std::vector<double> powerSpectrum(const std::vector<float> &signal, double sampleRateHz)
+{
+    const size_t segment = spectrumSegment(sampleRateHz);
+    std::vector<double> psd(segment / 2 + 1, 0.0);
+    std::vector<double> window(segment);
+    double windowPower = 0;
+
+    for (size_t i = 0; i < segment; i++) {
+        window[i] = 0.5 - 0.5 * cos(2 * M_PI * i / segment);
+        windowPower += window[i] * window[i];
+    }
+
+    int segments = 0;
+    for (size_t start = 0; start + segment <= signal.size(); start += segment / 2) {
+        double mean = 0;
+        for (size_t i = 0; i < segment; i++) {
+            mean += signal[start + i];
+        }
+        mean /= segment;
+
+        std::vector<std::complex<double>> x(segment);
+        for (size_t i = 0; i < segment; i++) {
+            x[i] = (signal[start + i] - mean) * window[i];
+        }
+        fft(x);
+
+        for (size_t bin = 0; bin < psd.size(); bin++) {
+            const double scale = (bin == 0 || bin == psd.size() - 1) ? 1 : 2;
+            psd[bin] += scale * std::norm(x[bin]) / (sampleRateHz * windowPower);
+        }
+        segments++;
+    }
+
+    for (double &p : psd) {
+        p /= MAX(segments, 1);
+    }
+    return psd;
+}
+
+static double bandRms(const std::vector<double> &psd, double sampleRateHz, double fromHz, double toHz)
+{
+    const double binHz = sampleRateHz / spectrumSegment(sampleRateHz);
+    double power = 0;
+
+    for (size_t bin = 1; bin < psd.size(); bin++) {
+        const double f = bin * binHz;
+        if (f >= fromHz && f < toHz) {
+            power += psd[bin] * binHz;
+        }
+    }
+    return sqrt(power);
+}
+
+// Lag of the output behind the input at the cross-correlation peak, in samples
+static double groupDelaySamples(const std::vector<float> &input, const std::vector<float> &output, int maxLag)
+{
+    const size_t n = std::min(input.size(), output.size());
+    if (n <= (size_t)maxLag * 2) {
+        return NAN;
+    }
+
+    double inputMean = 0, outputMean = 0;
+    for (size_t i = 0; i < n; i++) {
+        inputMean += input[i];
+        outputMean += output[i];
+    }
+    inputMean /= n;
+    outputMean /= n;
+
+    std::vector<double> xcorr(maxLag + 1, 0.0);
+    for (int lag = 0; lag <= maxLag; lag++) {
+        for (size_t i = 0; i + lag < n; i++) {
+            xcorr[lag] += (input[i] - inputMean) * (output[i + lag] - outputMean);
+        }
+    }
+
+    const int peak = std::max_element(xcorr.begin(), xcorr.end()) - xcorr.begin();
+    if (peak == 0 || peak == maxLag) {
+        return peak;
+    }
+
+    const double y0 = xcorr[peak - 1], y1 = xcorr[peak], y2 = xcorr[peak + 1];
+    const double denom = y0 - 2 * y1 + y2;
+    return peak + (denom != 0 ? 0.5 * (y0 - y2) / denom : 0);
+}
+
+/*
+ * Report
+ */
+
+static const char *axisNames[XYZ_AXIS_COUNT] = { "roll", "pitch", "yaw" };
+
+static void printRow(const char *label, const std::vector<std::string> &cells)
+{
+    printf("%-26s", label);
+    for (const std::string &cell : cells) {
+        printf("%12s", cell.c_str());
+    }
+    printf("\n");
+}
+
+static std::string format(const char *fmt, double value)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), fmt, value);
+    return buf;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s (<log> | --synthetic <seconds>) [options]\n"
+        "  --config <name=value,...>  filter configuration to compare, CLI setting names, may be repeated.\n"
+        "                             Defaults are used for anything not given, an empty string is the defaults\n"
+        "  --motor-poles <n>          motor pole count to convert eRPM columns, 14 if not given\n"
+        "  --bands <f1,f2,...>        noise report band edges in Hz\n"
+        "  --spectrum-csv <file>      write the noise spectra of every configuration\n",
+        name);
+}
+
+int main(int argc, char **argv)
+{
+    replayLog_t log;
+    std::vector<benchConfig_t> configs;
+    std::vector<double> bands = { 0, 50, 100, 200, 300 };
+    const char *logPath = NULL;
+    const char *spectrumCsv = NULL;
+    float syntheticSeconds = 0;
+    int motorPoles = 14;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--config" && hasValue) {
+            benchConfig_t config;
+            if (!parseConfig(argv[++i], &config)) {
+                return 1;
+            }
+            configs.push_back(config);
+        } else if (arg == "--synthetic" && hasValue) {
+            syntheticSeconds = atof(argv[++i]);
+        } else if (arg == "--motor-poles" && hasValue) {
+            motorPoles = atoi(argv[++i]);
+        } else if (arg == "--bands" && hasValue) {
+            bands.clear();
+            std::stringstream ss(argv[++i]);
+            std::string edge;
+            while (std::getline(ss, edge, ',')) {
+                bands.push_back(atof(edge.c_str()));
+            }
+        } else if (arg == "--spectrum-csv" && hasValue) {
+            spectrumCsv = argv[++i];
+        } else if (arg[0] != '-' && !logPath) {
+            logPath = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (syntheticSeconds > 0) {
+        makeSyntheticLog(syntheticSeconds, &log);
+    } else if (!logPath || !loadLog(logPath, &log, motorPoles)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (log.gyro.empty() || log.sampleIntervalUs == 0) {
+        fprintf(stderr, "No gyro samples in the log\n");
+        return 1;
+    }
+
+    if (configs.empty()) {
+        configs.push_back(benchConfig_t());
+        parseConfig("", &configs.back());
+    }
+
+    std::vector<replayResult_t> results(configs.size());
+    for (size_t c = 0; c < configs.size(); c++) {
+        replay(log, configs[c], &results[c]);
+    }
+
+    printf("Log: %s, %u Hz gyro, %.1f s, %d motor RPM channels%s\n",
+        log.description.c_str(), 1000000 / log.sampleIntervalUs,
+        log.gyro.size() * log.sampleIntervalUs * 1e-6, log.motorCount,
+        log.setpoint.empty() ? "" : ", setpoint");
+    for (size_t c = 0; c < configs.size(); c++) {
+        printf("  %c: %s\n", (int)('A' + c), configs[c].description.c_str());
+    }
+    printf("\n");
+
+    std::vector<std::string> header = { "input" };
+    for (size_t c = 0; c < configs.size(); c++) {
+        header.push_back(std::string(1, 'A' + c));
+    }
+    printRow("", header);
+
+    std::vector<std::string> cells = { "" };
+    for (const replayResult_t &result : results) {
+        cells.push_back(format("%.0f", 1e6 / result.looptimeUs));
+    }
+    printRow("Loop rate [Hz]", cells);
+
+    cells = { "" };
+    for (const replayResult_t &result : results) {
+        cells.push_back(format("%.1f", result.nsPerGyroSample));
+    }
+    printRow("CPU [ns/gyro sample]", cells);
+
+    cells = { "" };
+    for (const replayResult_t &result : results) {
+        cells.push_back(format("%.1f", result.nsPerLoop));
+    }
+    printRow("CPU [ns/loop]", cells);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        cells = { "" };
+        for (const replayResult_t &result : results) {
+            const int maxLag = MAX_DELAY_MS * 1000 / result.looptimeUs;
+            // gyroRaw is before the anti-aliasing filter, the delay covers the whole chain
+            cells.push_back(format("%.2f", groupDelaySamples(result.input[axis], result.output[axis], maxLag) * result.looptimeUs / 1000.0));
+        }
+        printRow((std::string("Delay [ms] ") + axisNames[axis]).c_str(), cells);
+    }
+
+    std::vector<std::vector<double>> inputPsd[XYZ_AXIS_COUNT];
+    std::vector<std::vector<double>> outputPsd[XYZ_AXIS_COUNT];
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        for (const replayResult_t &result : results) {
+            const double rate = 1e6 / result.looptimeUs;
+            inputPsd[axis].push_back(powerSpectrum(result.input[axis], rate));
+            outputPsd[axis].push_back(powerSpectrum(result.output[axis], rate));
+        }
+    }
+
+    printf("\nRMS per band [deg/s], the lowest band is mostly stick input\n");
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        for (size_t b = 0; b < bands.size(); b++) {
+            const double nyquist = 0.5e6 / results[0].looptimeUs;
+            const double from = bands[b];
+            const double to = (b + 1 < bands.size()) ? bands[b + 1] : nyquist;
+            if (from >= nyquist) {
+                break;
+            }
+
+            const double rate = 1e6 / results[0].looptimeUs;
+            cells = { format("%.2f", bandRms(inputPsd[axis][0], rate, from, to)) };
+            for (size_t c = 0; c < results.size(); c++) {
+                cells.push_back(format("%.2f", bandRms(outputPsd[axis][c], 1e6 / results[c].looptimeUs, from, to)));
+            }
+
+            char label[64];
+            snprintf(label, sizeof(label), "%-6s %4.0f-%-4.0f Hz", axisNames[axis], from, to);
+            printRow(label, cells);
+        }
+    }
+
+    if (spectrumCsv) {
+        FILE *f = fopen(spectrumCsv, "w");
+        if (!f) {
+            fprintf(stderr, "Can't write %s\n", spectrumCsv);
+            return 1;
+        }
+
+        // One row per frequency of the first configuration, others only line up if their loop rate is the same
+        fprintf(f, "frequency (Hz)");
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            fprintf(f, ",input %s", axisNames[axis]);
+            for (size_t c = 0; c < results.size(); c++) {
+                fprintf(f, ",%c %s", (int)('A' + c), axisNames[axis]);
+            }
+        }
+        fprintf(f, "\n");
+
+        const double binHz = 1e6 / results[0].looptimeUs / spectrumSegment(1e6 / results[0].looptimeUs);
+        for (size_t bin = 0; bin < inputPsd[0][0].size(); bin++) {
+            fprintf(f, "%.2f", bin * binHz);
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                fprintf(f, ",%.6g", inputPsd[axis][0][bin]);
+                for (size_t c = 0; c < results.size(); c++) {
+                    fprintf(f, ",%.6g", bin < outputPsd[axis][c].size() ? outputPsd[axis][c][bin] : 0.0);
+                }
+            }
+            fprintf(f, "\n");
+        }
+        fclose(f);
+    }
+
+    return 0;
+}
+
+// STUBS
+
+extern "C" {
+
+uint32_t armingFlags;
+uint32_t stateFlags;
+uint8_t detectedSensors[SENSOR_INDEX_COUNT];
+
+timeMs_t millis(void) { return 0; }
+timeUs_t micros(void) { return 0; }
+void beeper(beeperMode_e mode) { UNUSED(mode); }
+timeDelta_t getLooptime(void) { return benchLooptime; }
+timeDelta_t getGyroLooptime(void) { return benchGyroLooptime; }
+void sensorsSet(uint32_t mask) { UNUSED(mask); }
+void schedulerResetTaskStatistics(cfTaskId_e taskId) { UNUSED(taskId); }
+
+uint8_t getMotorCount(void) { return benchMotorCount; }
+int16_t getThrottlePercent(bool useScaled) { UNUSED(useScaled); return 0; }
+escSensorData_t *getEscTelemetry(uint8_t esc) { return &benchEscData[esc]; }
+
+void blackboxWrite(uint8_t value) { UNUSED(value); }
+blackboxBufferReserveStatus_e blackboxDeviceReserveBufferSpace(int32_t bytes) { UNUSED(bytes); return BLACKBOX_RESERVE_PERMANENT_FAILURE; }
+void blackboxDeviceFlush(void) {}
+
+// The firmware uses the assembler version from CMSIS, this is the reference C implementation
+void arm_bitreversal_32(uint32_t *pSrc, const uint16_t bitRevLen, const uint16_t *pBitRevTable)
+{
+    for (uint32_t i = 0; i < bitRevLen; i += 2) {
+        const uint32_t a = pBitRevTable[i] >> 2;
+        const uint32_t b = pBitRevTable[i + 1] >> 2;
+
+        std::swap(pSrc[a], pSrc[b]);
+        std::swap(pSrc[a + 1], pSrc[b + 1]);
+    }
+}
+
+}
@@ -0,0 +1,345 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Serial receive bench. Feeds an MSP stream through a ring buffer port into the MSP parser of the firmware, built
+ * from the same sources, and reports the time per received byte. The port hands the parser the received bytes as
+ * blocks like the UART drivers do, and one byte at a time, which is what every byte cost before parsers took blocks.
+ * The CPU load is given for common baud rates with the line fully used.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/crc.h"
+    #include "common/utils.h"
+
+    #include "config/parameter_group_ids.h"
+
+    #include "drivers/serial.h"
+
+    #include "io/serial.h"
+
+    #include "msp/msp.h"
+    #include "msp/msp_protocol.h"
+    #include "msp/msp_serial.h"
+}
+
+#define BENCH_RX_BUFFER_SIZE    256     // Same as the UART drivers
+#define BENCH_RC_CHANNELS       16
+
+static const uint32_t benchBaudRates[] = { 115200, 230400, 1000000, 2000000 };
+
+typedef struct benchPort_s {
+    serialPort_t port;
+    uint8_t rxBuffer[BENCH_RX_BUFFER_SIZE];
+    bool singleBytes;
+} benchPort_t;
+
+static uint32_t benchCommandCount;
+
+static void benchWrite(serialPort_t *instance, uint8_t ch)
+{
+    UNUSED(instance);
+    UNUSED(ch);
+}
+
+static uint32_t benchRxWaiting(const serialPort_t *instance)
+{
+    return (instance->rxBufferHead - instance->rxBufferTail) & (instance->rxBufferSize - 1);
+}
+
+static uint32_t benchTxFree(const serialPort_t *instance)
+{
+    UNUSED(instance);
+    return BENCH_RX_BUFFER_SIZE;
+}
+
+static uint8_t benchRead(serialPort_t *instance)
+{
+    const uint8_t c = instance->rxBuffer[instance->rxBufferTail];
+    instance->rxBufferTail = (instance->rxBufferTail + 1) & (instance->rxBufferSize - 1);
+    return c;
+}
+
+static uint32_t benchRxPeek(serialPort_t *instance, const uint8_t **data)
+{
+    const uint32_t count = serialRxBufferPeek(instance, data);
+
+    if (((benchPort_t *)instance)->singleBytes) {
+        return std::min(count, 1U);
+    }
+
+    return count;
+}
+
+static bool benchTransmitBufferEmpty(const serialPort_t *instance)
+{
+    UNUSED(instance);
+    return true;
+}
+
+static void benchWriteBuf(serialPort_t *instance, const void *data, int count)
+{
+    UNUSED(instance);
+    UNUSED(data);
+    UNUSED(count);
+}
+
+static struct serialPortVTable benchVTable;
+
+static void initBenchPort(benchPort_t *port, bool singleBytes)
+{
+    benchVTable.serialWrite = benchWrite;
+    benchVTable.serialTotalRxWaiting = benchRxWaiting;
+    benchVTable.serialTotalTxFree = benchTxFree;
+    benchVTable.serialRead = benchRead;
+    benchVTable.serialRxPeek = benchRxPeek;
+    benchVTable.serialRxConsume = serialRxBufferConsume;
+    benchVTable.isSerialTransmitBufferEmpty = benchTransmitBufferEmpty;
+    benchVTable.writeBuf = benchWriteBuf;
+
+    memset(port, 0, sizeof(*port));
+    port->port.vTable = &benchVTable;
+    port->port.mode = MODE_RXTX;
+    port->port.rxBufferSize = BENCH_RX_BUFFER_SIZE;
+    port->port.rxBuffer = port->rxBuffer;
+    port->singleBytes = singleBytes;
+}
+
+// Copies as much of the stream as fits, like the receive interrupt filling the buffer between two scheduler runs
+static size_t fillBenchPort(benchPort_t *port, const uint8_t *data, size_t size)
+{
+    serialPort_t *instance = &port->port;
+    const size_t count = std::min<size_t>(size, BENCH_RX_BUFFER_SIZE - 1 - benchRxWaiting(instance));
+
+    const size_t first = std::min<size_t>(count, BENCH_RX_BUFFER_SIZE - instance->rxBufferHead);
+
+    memcpy(&port->rxBuffer[instance->rxBufferHead], data, first);
+    memcpy(port->rxBuffer, data + first, count - first);
+    instance->rxBufferHead = (instance->rxBufferHead + count) & (BENCH_RX_BUFFER_SIZE - 1);
+
+    return count;
+}
+
+static mspResult_e benchProcessCommand(mspPacket_t *cmd, mspPacket_t *reply, mspPostProcessFnPtr *mspPostProcessFn)
+{
+    UNUSED(reply);
+    UNUSED(mspPostProcessFn);
+
+    if (cmd->cmd == MSP_SET_RAW_RC && sbufBytesRemaining(&cmd->buf) == BENCH_RC_CHANNELS * 2) {
+        benchCommandCount++;
+    }
+
+    return MSP_RESULT_NO_REPLY;
+}
+
+// MSP_SET_RAW_RC as sent by RC over MSP, alternating MSPv1 and MSPv2 frames
+static std::vector<uint8_t> buildStream(size_t frameCount)
+{
+    std::vector<uint8_t> stream;
+
+    for (size_t frame = 0; frame < frameCount; frame++) {
+        uint8_t payload[BENCH_RC_CHANNELS * 2];
+        for (int channel = 0; channel < BENCH_RC_CHANNELS; channel++) {
+            const uint16_t value = 1000 + (frame * 7 + channel * 61) % 1000;
+            payload[channel * 2] = value & 0xFF;
+            payload[channel * 2 + 1] = value >> 8;
+        }
+
+        if (frame % 2) {
+            const uint8_t header[] = { 0, MSP_SET_RAW_RC & 0xFF, MSP_SET_RAW_RC >> 8, sizeof(payload) & 0xFF, sizeof(payload) >> 8 };
+            uint8_t crc = crc8_dvb_s2_update(0, header, sizeof(header));
+            crc = crc8_dvb_s2_update(crc, payload, sizeof(payload));
+
+            stream.insert(stream.end(), { '$', 'X', '<' });
+            stream.insert(stream.end(), header, header + sizeof(header));
+            stream.insert(stream.end(), payload, payload + sizeof(payload));
+            stream.push_back(crc);
+        } else {
+            const uint8_t header[] = { sizeof(payload), MSP_SET_RAW_RC };
+            uint8_t checksum = crc8_xor_update(0, header, sizeof(header));
+            checksum = crc8_xor_update(checksum, payload, sizeof(payload));
+
+            stream.insert(stream.end(), { '$', 'M', '<' });
+            stream.insert(stream.end(), header, header + sizeof(header));
+            stream.insert(stream.end(), payload, payload + sizeof(payload));
+            stream.push_back(checksum);
+        }
+    }
+
+    return stream;
+}
+
+// Returns ns per received byte, or a negative value if frames were lost
+static double runBench(const std::vector<uint8_t> &stream, size_t frameCount, bool singleBytes, int repeat)
+{
+    double bestNs = 1e30;
+
+    for (int run = 0; run < repeat; run++) {
+        benchPort_t port;
+        mspPort_t mspPort;
+        initBenchPort(&port, singleBytes);
+        resetMspPort(&mspPort, &port.port);
+        benchCommandCount = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        size_t offset = 0;
+        while (offset < stream.size() || benchRxWaiting(&port.port)) {
+            offset += fillBenchPort(&port, &stream[offset], stream.size() - offset);
+            mspSerialProcessOnePort(&mspPort, MSP_SKIP_NON_MSP_DATA, benchProcessCommand);
+        }
+
+        const double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        if (benchCommandCount != frameCount) {
+            fprintf(stderr, "%s: %u of %zu frames parsed\n", singleBytes ? "single bytes" : "blocks", benchCommandCount, frameCount);
+            return -1;
+        }
+
+        bestNs = std::min(bestNs, elapsedNs / stream.size());
+    }
+
+    return bestNs;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [--frames <count>] [--repeat <count>]\n"
+        "  --frames   MSP_SET_RAW_RC frames in the stream, default 100000\n"
+        "  --repeat   runs per mode, the fastest is reported, default 5\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t frameCount = 100000;
+    int repeat = 5;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frameCount = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (frameCount == 0 || repeat < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const std::vector<uint8_t> stream = buildStream(frameCount);
+    const double singleNs = runBench(stream, frameCount, true, repeat);
+    const double blockNs = runBench(stream, frameCount, false, repeat);
+
+    if (singleNs < 0 || blockNs < 0) {
+        return 1;
+    }
+
+    printf("MSP stream: %zu frames, %zu bytes\n\n", frameCount, stream.size());
+    printf("%-14s %10s", "", "ns/byte");
+    for (uint32_t baudRate : benchBaudRates) {
+        printf(" %9u", baudRate);
+    }
+    printf("\n");
+
+    const struct { const char *name; double ns; } results[] = { { "single bytes", singleNs }, { "blocks", blockNs } };
+    for (const auto &result : results) {
+        printf("%-14s %10.2f", result.name, result.ns);
+        for (uint32_t baudRate : benchBaudRates) {
+            // 10 bits per byte on the line, 8N1
+            printf(" %8.3f%%", 100 * result.ns * 1e-9 * baudRate / 10);
+        }
+        printf("\n");
+    }
+
+    printf("\nblocks take %.0f%% of the time of single bytes, CPU load is for the host\n", 100 * blockNs / singleNs);
+
+    return 0;
+}
+
+extern "C" {
+
+// Used by MSP for port allocation, the CLI and reboot requests, the bench has its own port and skips non MSP data
+PG_REGISTER(serialConfig_t, serialConfig, PG_SERIAL_CONFIG, 0);
+
+const uint32_t baudRates[] = { 0 };
+bool cliMode;
+
+serialPortConfig_t *findSerialPortConfig(serialPortFunction_e function)
+{
+    UNUSED(function);
+    return NULL;
+}
+
+serialPortConfig_t *findNextSerialPortConfig(serialPortFunction_e function)
+{
+    UNUSED(function);
+    return NULL;
+}
+
+serialPort_t *openSerialPort(serialPortIdentifier_e identifier, serialPortFunction_e function, serialReceiveCallbackPtr callback,
+    void *rxCallbackData, uint32_t baudrate, portMode_t mode, portOptions_t options)
+{
+    UNUSED(identifier);
+    UNUSED(function);
+    UNUSED(callback);
+    UNUSED(rxCallbackData);
+    UNUSED(baudrate);
+    UNUSED(mode);
+    UNUSED(options);
+    return NULL;
+}
+
+void closeSerialPort(serialPort_t *serialPort)
+{
+    UNUSED(serialPort);
+}
+
+void cliEnter(serialPort_t *serialPort)
+{
+    UNUSED(serialPort);
+}
+
+uint32_t millis(void)
+{
+    return 0;
+}
+
+void systemResetToBootloader(void) {}
+
+void waitForSerialPortToFinishTransmitting(serialPort_t *serialPort)
+{
+    UNUSED(serialPort);
+}
+
+}
@@ -0,0 +1,229 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <functional>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+
+    #include "drivers/adc.h"
+    #include "drivers/adc_decimator.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_BUFFER_SEQUENCES   32
+
+// Circular DMA buffer of interleaved conversion sequences, each half is decimated once it has been filled
+class SimulatedDma {
+public:
+    SimulatedDma(adcDecimator_t *decimator, uint8_t channelCount)
+        : decimator(decimator), channelCount(channelCount), buffer(channelCount * TEST_BUFFER_SEQUENCES), position(0) {}
+
+    void convert(const std::function<uint16_t(uint8_t channel)> &sample)
+    {
+        for (uint8_t channel = 0; channel < channelCount; channel++) {
+            buffer[position * channelCount + channel] = sample(channel);
+        }
+        position++;
+
+        if (position == TEST_BUFFER_SEQUENCES / 2) {
+            adcDecimatorProcess(decimator, &buffer[0], TEST_BUFFER_SEQUENCES / 2);
+        } else if (position == TEST_BUFFER_SEQUENCES) {
+            adcDecimatorProcess(decimator, &buffer[TEST_BUFFER_SEQUENCES / 2 * channelCount], TEST_BUFFER_SEQUENCES / 2);
+            position = 0;
+        }
+    }
+
+private:
+    adcDecimator_t *decimator;
+    uint8_t channelCount;
+    std::vector<uint16_t> buffer;
+    unsigned position;
+};
+
+static uint32_t testSeed;
+
+// Gaussian noise from the sum of uniform values, standard deviation of 1
+static float testNoise(void)
+{
+    float sum = 0;
+    for (int i = 0; i < 12; i++) {
+        testSeed = testSeed * 1103515245 + 12345;
+        sum += (testSeed >> 8) / (float)(1 << 24);
+    }
+    return sum - 6;
+}
+
+static uint16_t quantize(float value)
+{
+    return constrain(lrintf(value), 0, 0xFFF);
+}
+
+class AdcDecimatorTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        testSeed = 1;
+    }
+
+    adcDecimator_t decimator;
+};
+
+TEST_F(AdcDecimatorTest, DecimationRatio)
+{
+    EXPECT_EQ(21, adcDecimatorRatio(10670, 500));
+    EXPECT_EQ(1, adcDecimatorRatio(300, 2000));
+    EXPECT_EQ(ADC_DECIMATOR_MAX_DECIMATION, adcDecimatorRatio(100000000, 10));
+}
+
+TEST_F(AdcDecimatorTest, ConstantInputIsScaledToHighRes)
+{
+    adcDecimatorInit(&decimator, 3, 20);
+    SimulatedDma dma(&decimator, 3);
+
+    const uint16_t inputs[] = { 0, 1234, 0xFFF };
+    for (int i = 0; i < 320; i++) {
+        dma.convert([&](uint8_t channel) { return inputs[channel]; });
+    }
+
+    EXPECT_EQ(16u, decimator.outputCount);
+    EXPECT_EQ(0, adcDecimatorGetValue(&decimator, 0));
+    EXPECT_EQ(1234 << ADC_DECIMATOR_FRACTION_BITS, adcDecimatorGetValue(&decimator, 1));
+    EXPECT_EQ(ADC_HIGHRES_MAX, adcDecimatorGetValue(&decimator, 2));
+}
+
+TEST_F(AdcDecimatorTest, BoxcarSpansBufferHalves)
+{
+    // 7 doesn't divide the 16 sequences of a buffer half, sums carry over from one half to the next
+    adcDecimatorInit(&decimator, 1, 7);
+    SimulatedDma dma(&decimator, 1);
+
+    int n = 0;
+    for (int i = 0; i < 7 * 16; i++) {
+        dma.convert([&](uint8_t) { return (uint16_t)(n++ % 7 == 6 ? 700 : 0); });
+    }
+
+    EXPECT_EQ(16u, decimator.outputCount);
+    EXPECT_EQ(100 << ADC_DECIMATOR_FRACTION_BITS, adcDecimatorGetValue(&decimator, 0));
+}
+
+TEST_F(AdcDecimatorTest, ChannelsAreKeptApart)
+{
+    adcDecimatorInit(&decimator, 4, 16);
+    SimulatedDma dma(&decimator, 4);
+
+    for (int i = 0; i < 16 * 8; i++) {
+        dma.convert([](uint8_t channel) { return (uint16_t)(1000 * channel + 10); });
+    }
+
+    for (int channel = 0; channel < 4; channel++) {
+        EXPECT_EQ((1000 * channel + 10) << ADC_DECIMATOR_FRACTION_BITS, adcDecimatorGetValue(&decimator, channel));
+    }
+}
+
+TEST_F(AdcDecimatorTest, StepSettlesAfterFilterLength)
+{
+    adcDecimatorInit(&decimator, 1, 10);
+    SimulatedDma dma(&decimator, 1);
+
+    for (int i = 0; i < 160; i++) {
+        dma.convert([](uint8_t) { return (uint16_t)1000; });
+    }
+
+    std::vector<uint16_t> outputs;
+    uint32_t lastOutputCount = decimator.outputCount;
+    for (int i = 0; i < 160; i++) {
+        dma.convert([](uint8_t) { return (uint16_t)2000; });
+        if (decimator.outputCount != lastOutputCount) {
+            lastOutputCount = decimator.outputCount;
+            outputs.push_back(adcDecimatorGetValue(&decimator, 0) >> ADC_DECIMATOR_FRACTION_BITS);
+        }
+    }
+
+    // Outputs are only seen at the buffer halves, two at a time: [1 3 3 1]/8 steps through 1/8, 1/2 and 7/8
+    ASSERT_GE(outputs.size(), 4u);
+    EXPECT_LT(outputs[0], 1200);
+    EXPECT_EQ(2000, outputs[outputs.size() - 1]);
+    for (size_t i = 1; i < outputs.size(); i++) {
+        EXPECT_GE(outputs[i], outputs[i - 1]);
+    }
+}
+
+TEST_F(AdcDecimatorTest, NoiseAndResolution)
+{
+    // A battery divider between two codes, with 3 LSB of noise
+    const float input = 2345.3f;
+    const float noise = 3;
+    const uint16_t decimation = 21;
+
+    adcDecimatorInit(&decimator, 2, decimation);
+    SimulatedDma dma(&decimator, 2);
+
+    std::vector<float> rawSamples;
+    std::vector<float> outputs;
+    uint32_t lastOutputCount = 0;
+
+    for (int i = 0; i < 21 * 4000; i++) {
+        dma.convert([&](uint8_t channel) {
+            const uint16_t sample = quantize(input + noise * testNoise());
+            if (channel == 0) {
+                rawSamples.push_back(sample);
+            }
+            return sample;
+        });
+
+        if (decimator.outputCount != lastOutputCount) {
+            lastOutputCount = decimator.outputCount;
+            if (lastOutputCount > ADC_DECIMATOR_FIR_TAPS) {
+                outputs.push_back(adcDecimatorGetValue(&decimator, 0) / (float)(1 << ADC_DECIMATOR_FRACTION_BITS));
+            }
+        }
+    }
+
+    auto stats = [](const std::vector<float> &values, float *mean, float *deviation) {
+        double sum = 0;
+        for (float value : values) {
+            sum += value;
+        }
+        *mean = sum / values.size();
+
+        double sumSq = 0;
+        for (float value : values) {
+            sumSq += sq(value - *mean);
+        }
+        *deviation = sqrt(sumSq / values.size());
+    };
+
+    float rawMean, rawDeviation, mean, deviation;
+    stats(rawSamples, &rawMean, &rawDeviation);
+    stats(outputs, &mean, &deviation);
+
+    // The fraction between the two codes is resolved
+    EXPECT_NEAR(input, mean, 0.02f);
+    // Boxcar of 21 and the FIR with a noise gain of sqrt(20)/8 take the noise down by more than 7
+    EXPECT_LT(deviation, rawDeviation / 7);
+}
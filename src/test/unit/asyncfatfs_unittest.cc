@@ -0,0 +1,324 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+extern "C" {
+    #include <platform.h>
+
+    #include "common/time.h"
+    #include "drivers/io.h"
+    #include "drivers/time.h"
+    #include "drivers/sdcard/sdcard.h"
+    #include "drivers/sdcard/sdcard_file.h"
+    #include "io/asyncfatfs/asyncfatfs.h"
+    #include "io/asyncfatfs/fat_standard.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define SECTOR_SIZE         512
+#define IMAGE_SECTORS       (64 * 1024 * 1024 / SECTOR_SIZE)
+#define PARTITION_START     64
+#define RESERVED_SECTORS    32
+#define FAT32_ENTRIES_PER_SECTOR (SECTOR_SIZE / 4)
+
+// Simulated time, advanced by the tests in fixed steps
+static timeUs_t simulatedTimeUs;
+
+static const char *imagePath = "asyncfatfs_unittest.img";
+
+static void writeSector(FILE *fd, uint32_t sector, const void *data)
+{
+    fseek(fd, (long)sector * SECTOR_SIZE, SEEK_SET);
+    fwrite(data, SECTOR_SIZE, 1, fd);
+}
+
+/*
+ * Create an empty FAT32 filesystem with one sector per cluster inside a single MBR partition.
+ */
+static void formatImage(void)
+{
+    FILE *fd = fopen(imagePath, "w+b");
+    ASSERT_TRUE(fd != NULL);
+    ASSERT_EQ(0, ftruncate(fileno(fd), (off_t)IMAGE_SECTORS * SECTOR_SIZE));
+
+    uint8_t sector[SECTOR_SIZE];
+
+    const uint32_t partitionSectors = IMAGE_SECTORS - PARTITION_START;
+    const uint32_t fatSectors = (partitionSectors / FAT32_ENTRIES_PER_SECTOR) + 1;
+
+    memset(sector, 0, sizeof(sector));
+    mbrPartitionEntry_t *partition = (mbrPartitionEntry_t *)(sector + 446);
+    partition->type = MBR_PARTITION_TYPE_FAT32_LBA;
+    partition->lbaBegin = PARTITION_START;
+    partition->numSectors = partitionSectors;
+    sector[510] = 0x55;
+    sector[511] = 0xAA;
+    writeSector(fd, 0, sector);
+
+    memset(sector, 0, sizeof(sector));
+    fatVolumeID_t *volume = (fatVolumeID_t *)sector;
+    volume->bytesPerSector = SECTOR_SIZE;
+    volume->sectorsPerCluster = 1;
+    volume->reservedSectorCount = RESERVED_SECTORS;
+    volume->numFATs = 2;
+    volume->media = 0xF8;
+    volume->totalSectors32 = partitionSectors;
+    volume->fatDescriptor.fat32.FATSize32 = fatSectors;
+    volume->fatDescriptor.fat32.rootCluster = 2;
+    sector[510] = FAT_VOLUME_ID_SIGNATURE_1;
+    sector[511] = FAT_VOLUME_ID_SIGNATURE_2;
+    writeSector(fd, PARTITION_START, sector);
+
+    // Media descriptor, reserved entry and the end of the root directory's chain
+    memset(sector, 0, sizeof(sector));
+    uint32_t *fat = (uint32_t *)sector;
+    fat[0] = 0x0FFFFFF8;
+    fat[1] = 0x0FFFFFFF;
+    fat[2] = 0x0FFFFFFF;
+    writeSector(fd, PARTITION_START + RESERVED_SECTORS, sector);
+    writeSector(fd, PARTITION_START + RESERVED_SECTORS + fatSectors, sector);
+
+    fclose(fd);
+}
+
+static bool pollUntil(bool (*condition)(void), timeUs_t stepUs, uint32_t maxSteps)
+{
+    for (uint32_t i = 0; i < maxSteps; i++) {
+        if (condition()) {
+            return true;
+        }
+        afatfs_poll();
+        simulatedTimeUs += stepUs;
+    }
+    return condition();
+}
+
+static bool filesystemReady(void)
+{
+    return afatfs_getFilesystemState() == AFATFS_FILESYSTEM_STATE_READY;
+}
+
+static afatfsFilePtr_t openedFile;
+
+static void fileOpened(afatfsFilePtr_t file)
+{
+    openedFile = file;
+}
+
+static bool fileIsOpen(void)
+{
+    return openedFile != NULL;
+}
+
+static bool fileClosed;
+
+static void fileCloseComplete(void)
+{
+    fileClosed = true;
+}
+
+static bool fileIsClosed(void)
+{
+    return fileClosed;
+}
+
+static uint8_t patternByte(uint32_t offset)
+{
+    return (uint8_t)((offset * 7) ^ (offset >> 9));
+}
+
+class AsyncFatFsTest : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        formatImage();
+
+        simulatedTimeUs = 0;
+        openedFile = NULL;
+        fileClosed = false;
+
+        sdcardFileSetPath(imagePath);
+        sdcard_init();
+        sdcardFileResetStats();
+
+        afatfs_init();
+        ASSERT_TRUE(pollUntil(filesystemReady, 100, 1000000));
+    }
+
+    virtual void TearDown()
+    {
+        while (!afatfs_destroy(false)) {
+            simulatedTimeUs += 100;
+        }
+        unlink(imagePath);
+    }
+
+    afatfsFilePtr_t openFile(const char *filename, const char *mode)
+    {
+        openedFile = NULL;
+        EXPECT_TRUE(afatfs_fopen(filename, mode, fileOpened));
+        EXPECT_TRUE(pollUntil(fileIsOpen, 100, 100000));
+        return openedFile;
+    }
+
+    void closeFile(afatfsFilePtr_t file)
+    {
+        fileClosed = false;
+        EXPECT_TRUE(afatfs_fclose(file, fileCloseComplete));
+        EXPECT_TRUE(pollUntil(fileIsClosed, 100, 100000));
+    }
+};
+
+TEST_F(AsyncFatFsTest, WriteReadBack)
+{
+    const uint32_t fileSize = 300 * 1024 + 17;
+
+    afatfsFilePtr_t file = openFile("TEST.TXT", "as");
+    ASSERT_TRUE(file != NULL);
+
+    uint8_t chunk[100];
+    uint32_t written = 0;
+    while (written < fileSize) {
+        uint32_t chunkSize = std::min<uint32_t>(sizeof(chunk), fileSize - written);
+        for (uint32_t i = 0; i < chunkSize; i++) {
+            chunk[i] = patternByte(written + i);
+        }
+        uint32_t accepted = 0;
+        while (accepted < chunkSize) {
+            accepted += afatfs_fwrite(file, chunk + accepted, chunkSize - accepted);
+            afatfs_poll();
+            simulatedTimeUs += 100;
+        }
+        written += accepted;
+    }
+    closeFile(file);
+
+    file = openFile("TEST.TXT", "r");
+    ASSERT_TRUE(file != NULL);
+    EXPECT_EQ(fileSize, afatfs_fileSize(file));
+
+    uint32_t read = 0;
+    bool matches = true;
+    while (read < fileSize) {
+        uint32_t bytes = afatfs_fread(file, chunk, sizeof(chunk));
+        if (bytes == 0) {
+            ASSERT_FALSE(afatfs_feof(file));
+            afatfs_poll();
+            simulatedTimeUs += 100;
+            continue;
+        }
+        for (uint32_t i = 0; i < bytes; i++) {
+            matches &= chunk[i] == patternByte(read + i);
+        }
+        read += bytes;
+    }
+    EXPECT_TRUE(matches);
+    EXPECT_TRUE(afatfs_feof(file));
+    closeFile(file);
+}
+
+/*
+ * Stream data into a contiguous log file the way blackbox does and report the sustained write rate and the longest
+ * stall the producer saw against a card with realistic latencies.
+ */
+TEST_F(AsyncFatFsTest, StreamingBenchmark)
+{
+    const uint32_t logSize = 4 * 1024 * 1024;
+    const timeUs_t stepUs = 50;
+    const uint32_t bytesPerStep = 128;
+
+    afatfsFilePtr_t file = openFile("LOG00001.TXT", "as");
+    ASSERT_TRUE(file != NULL);
+
+    sdcardFileResetStats();
+
+    uint8_t chunk[bytesPerStep];
+    uint32_t written = 0;
+    timeUs_t startUs = simulatedTimeUs;
+    timeUs_t stallStartUs = simulatedTimeUs;
+    timeUs_t maxStallUs = 0;
+
+    while (written < logSize) {
+        for (uint32_t i = 0; i < bytesPerStep; i++) {
+            chunk[i] = patternByte(written + i);
+        }
+
+        uint32_t accepted = afatfs_fwrite(file, chunk, bytesPerStep);
+        written += accepted;
+
+        if (accepted == bytesPerStep) {
+            maxStallUs = std::max<timeUs_t>(maxStallUs, simulatedTimeUs - stallStartUs);
+            stallStartUs = simulatedTimeUs + stepUs;
+        } else {
+            // Blackbox would drop the rest of this frame; keep the byte pattern continuous for the read-back check
+            ASSERT_FALSE(afatfs_isFull());
+            uint32_t remain = bytesPerStep - accepted;
+            while (remain > 0) {
+                afatfs_poll();
+                simulatedTimeUs += stepUs;
+                uint32_t more = afatfs_fwrite(file, chunk + accepted, remain);
+                accepted += more;
+                remain -= more;
+                written += more;
+            }
+            maxStallUs = std::max<timeUs_t>(maxStallUs, simulatedTimeUs - stallStartUs);
+            stallStartUs = simulatedTimeUs + stepUs;
+        }
+
+        afatfs_poll();
+        simulatedTimeUs += stepUs;
+    }
+
+    const timeUs_t elapsedUs = simulatedTimeUs - startUs;
+    const uint32_t kbPerSecond = (uint64_t)written * 1000000 / 1024 / elapsedUs;
+    const sdcardFileStats_t *stats = sdcardFileGetStats();
+
+    // Data streams through long multi-block writes instead of restarting them for every FAT/directory update
+    EXPECT_LT(stats->multiBlockWrites * 64, stats->blocksWritten);
+    // The producer outpaces the card, so this is close to the card's multi-block write speed
+    EXPECT_GT(kbPerSecond, 1800u);
+    // The producer never has to wait for the card to finish a supercluster append
+    EXPECT_LT(maxStallUs, 20000u);
+
+    closeFile(file);
+
+    file = openFile("LOG00001.TXT", "r");
+    ASSERT_TRUE(file != NULL);
+    EXPECT_EQ(logSize, afatfs_fileSize(file));
+    closeFile(file);
+}
+
+// STUBS
+
+extern "C" {
+timeUs_t micros(void) { return simulatedTimeUs; }
+timeMs_t millis(void) { return simulatedTimeUs / 1000; }
+IO_t IOGetByTag(ioTag_t) { return NULL; }
+void IOInit(IO_t, resourceOwner_e, resourceType_e, uint8_t) {}
+void IOConfigGPIO(IO_t, ioConfig_t) {}
+bool IORead(IO_t) { return true; }
+bool rtcGetDateTimeLocal(dateTime_t *) { return false; }
+}
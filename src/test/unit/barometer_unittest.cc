@@ -0,0 +1,576 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <deque>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "drivers/bus.h"
+    #include "drivers/time.h"
+    #include "drivers/barometer/barometer.h"
+    #include "drivers/barometer/barometer_bmp280.h"
+    #include "drivers/barometer/barometer_bmp388.h"
+    #include "drivers/barometer/barometer_dps310.h"
+    #include "drivers/barometer/barometer_spl06.h"
+
+    #include "sensors/barometer.h"
+    #include "sensors/sensors.h"
+
+    void baroInitAltitudeTable(void);
+    float pressureToAltitude(const float pressure);
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+/*
+ * The sensors are register files on a fake bus. Calibration comes from register dumps, the results
+ * the sensor would measure are queued in its FIFO by the tests.
+ */
+typedef enum {
+    FAKE_BMP280,
+    FAKE_BMP388,
+    FAKE_DPS310,
+    FAKE_SPL06,
+} fakeSensor_e;
+
+static struct {
+    busDevice_t dev;
+    fakeSensor_e sensor;
+    uint8_t regs[256];
+    std::deque<uint8_t> frames;     // BMP388 FIFO, bytes
+    std::deque<uint32_t> results;   // DPS310 and SPL06 FIFO, 24 bit results
+    unsigned transactions;
+    unsigned bytes;
+    unsigned samplesRead;           // Pressures taken out of the FIFO
+} fake;
+
+#define BMP388_FRAME_SIZE       7
+#define INFINEON_FIFO_EMPTY     0x800000
+
+// BMP280 datasheet 3.12, trimming of the computation example
+static const uint8_t bmp280Calibration[] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,
+    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17,
+};
+
+// NVM_PAR_T1 (0x31) to NVM_PAR_P11 (0x45)
+static const uint8_t bmp388Calibration[] = {
+    0x80, 0x6D, 0xC8, 0x4A, 0xF9, 0x10, 0x05, 0x65, 0x08, 0x23, 0x00, 0xA5,
+    0x62, 0xEF, 0x74, 0x03, 0xF9, 0xF0, 0x3C, 0x07, 0xC4,
+};
+
+// COEF registers, 0x10 to 0x21
+static const uint8_t dps310Calibration[] = {
+    0x0D, 0x1E, 0xFB, 0x13, 0xA5, 0x5F, 0x2B, 0x33, 0xF5,
+    0x0D, 0x05, 0x95, 0xD3, 0xAA, 0x00, 0xE3, 0xFA, 0xDD,
+};
+
+static const uint8_t spl06Calibration[] = {
+    0x0C, 0xCE, 0xFB, 0x13, 0x88, 0x0F, 0x3C, 0xB0, 0xF4,
+    0x48, 0x04, 0xB0, 0xD8, 0xF0, 0x00, 0xC8, 0xFA, 0x24,
+};
+
+// Raw results of about 25C and 100kPa with the calibrations above, for the DPS310 and SPL06 temperatures are odd and pressures even
+#define BMP388_RAW_TEMPERATURE  8600000
+#define BMP388_RAW_PRESSURE     7736680
+#define DPS310_RAW_TEMPERATURE  77353
+#define DPS310_RAW_PRESSURE     (-104308)
+#define SPL06_RAW_TEMPERATURE   2320125
+#define SPL06_RAW_PRESSURE      (-3618616)
+
+static void fakeReset(fakeSensor_e sensor, busType_e busType)
+{
+    fake.dev.busType = busType;
+    fake.sensor = sensor;
+    memset(fake.regs, 0, sizeof(fake.regs));
+    fake.frames.clear();
+    fake.results.clear();
+
+    switch (sensor) {
+    case FAKE_BMP280:
+        fake.regs[0xD0] = 0x58;
+        memcpy(&fake.regs[0x88], bmp280Calibration, sizeof(bmp280Calibration));
+        break;
+    case FAKE_BMP388:
+        fake.regs[0x00] = 0x50;
+        memcpy(&fake.regs[0x31], bmp388Calibration, sizeof(bmp388Calibration));
+        break;
+    case FAKE_DPS310:
+        fake.regs[0x0D] = 0x10;
+        fake.regs[0x08] = 0xC0;     // COEF_RDY, SENSOR_RDY
+        memcpy(&fake.regs[0x10], dps310Calibration, sizeof(dps310Calibration));
+        fake.regs[0x03] = (DPS310_RAW_TEMPERATURE >> 16) & 0xFF;
+        fake.regs[0x04] = (DPS310_RAW_TEMPERATURE >> 8) & 0xFF;
+        fake.regs[0x05] = DPS310_RAW_TEMPERATURE & 0xFF;
+        break;
+    case FAKE_SPL06:
+        fake.regs[0x0D] = 0x10;
+        fake.regs[0x08] = 0x80;     // COEFFS_RDY
+        memcpy(&fake.regs[0x10], spl06Calibration, sizeof(spl06Calibration));
+        fake.regs[0x03] = (SPL06_RAW_TEMPERATURE >> 16) & 0xFF;
+        fake.regs[0x04] = (SPL06_RAW_TEMPERATURE >> 8) & 0xFF;
+        fake.regs[0x05] = SPL06_RAW_TEMPERATURE & 0xFF;
+        break;
+    }
+
+    fake.transactions = 0;
+    fake.bytes = 0;
+    fake.samplesRead = 0;
+}
+
+static void queueBmp388Frame(uint32_t ut, uint32_t up)
+{
+    const uint8_t frame[BMP388_FRAME_SIZE] = {
+        0x94,
+        (uint8_t)ut, (uint8_t)(ut >> 8), (uint8_t)(ut >> 16),
+        (uint8_t)up, (uint8_t)(up >> 8), (uint8_t)(up >> 16),
+    };
+    fake.frames.insert(fake.frames.end(), frame, frame + BMP388_FRAME_SIZE);
+}
+
+static void queueResult(int32_t result)
+{
+    fake.results.push_back(result & 0xFFFFFF);
+}
+
+static void setBmp280Data(uint32_t adc_P, uint32_t adc_T)
+{
+    fake.regs[0xF7] = adc_P >> 12;
+    fake.regs[0xF8] = adc_P >> 4;
+    fake.regs[0xF9] = adc_P << 4;
+    fake.regs[0xFA] = adc_T >> 12;
+    fake.regs[0xFB] = adc_T >> 4;
+    fake.regs[0xFC] = adc_T << 4;
+}
+
+static void readBaro(baroDev_t *dev, int32_t *pressure, int32_t *temperature)
+{
+    EXPECT_TRUE(dev->read(dev));
+    dev->calculate(dev, pressure, temperature);
+}
+
+// Bosch integer compensation the BMP388 driver used before, pressure in 1/100 Pa
+static void bmp388ReferenceCompensation(uint32_t ut, uint32_t up, int64_t *temperature, uint64_t *pressure)
+{
+    const uint16_t T1 = bmp388Calibration[0] | bmp388Calibration[1] << 8;
+    const uint16_t T2 = bmp388Calibration[2] | bmp388Calibration[3] << 8;
+    const int8_t T3 = bmp388Calibration[4];
+    const int16_t P1 = bmp388Calibration[5] | bmp388Calibration[6] << 8;
+    const int16_t P2 = bmp388Calibration[7] | bmp388Calibration[8] << 8;
+    const int8_t P3 = bmp388Calibration[9];
+    const int8_t P4 = bmp388Calibration[10];
+    const uint16_t P5 = bmp388Calibration[11] | bmp388Calibration[12] << 8;
+    const uint16_t P6 = bmp388Calibration[13] | bmp388Calibration[14] << 8;
+    const int8_t P7 = bmp388Calibration[15];
+    const int8_t P8 = bmp388Calibration[16];
+    const int16_t P9 = bmp388Calibration[17] | bmp388Calibration[18] << 8;
+    const int8_t P10 = bmp388Calibration[19];
+    const int8_t P11 = bmp388Calibration[20];
+
+    uint64_t partial_data1 = ut - (256 * T1);
+    uint64_t partial_data2 = T2 * partial_data1;
+    uint64_t partial_data3 = partial_data1 * partial_data1;
+    int64_t partial_data4 = (int64_t)partial_data3 * T3;
+    int64_t partial_data5 = ((int64_t)(partial_data2 * 262144) + partial_data4);
+    const int64_t t_lin = partial_data5 / 4294967296;
+    *temperature = (t_lin * 25) / 16384;
+
+    int64_t d1 = t_lin * t_lin;
+    int64_t d2 = d1 / 64;
+    int64_t d3 = (d2 * t_lin) / 256;
+    int64_t d4 = (P8 * d3) / 32;
+    int64_t d5 = (P7 * d1) * 16;
+    int64_t d6 = (P6 * t_lin) * 4194304;
+    const int64_t offset = (P5 * 140737488355328) + d4 + d5 + d6;
+
+    d2 = (P4 * d3) / 32;
+    d4 = (P3 * d1) * 4;
+    d5 = (P2 - 16384) * t_lin * 2097152;
+    const int64_t sensitivity = ((P1 - 16384) * 70368744177664) + d2 + d4 + d5;
+
+    d1 = (sensitivity / 16777216) * up;
+    d2 = P10 * t_lin;
+    d3 = d2 + (65536 * P9);
+    d4 = (d3 * up) / 8192;
+    d5 = (d4 * up) / 512;
+    d6 = (int64_t)((uint64_t)up * (uint64_t)up);
+    d2 = (P11 * d6) / 65536;
+    d3 = (d2 * up) / 128;
+    d4 = (offset / 4) + d1 + d5 + d3;
+    *pressure = ((uint64_t)d4 * 25) / (uint64_t)1099511627776;
+}
+
+// Datasheet compensation of the DPS310 and SPL06 in double
+static double infineonReferencePressure(const uint8_t *coef, double kP, double kT, int32_t Praw, int32_t Traw)
+{
+    const auto sign = [](int32_t v, int bits) { return v >= (1 << (bits - 1)) ? v - (1 << bits) : v; };
+    const double c00 = sign(coef[3] << 12 | coef[4] << 4 | coef[5] >> 4, 20);
+    const double c10 = sign((coef[5] & 0x0F) << 16 | coef[6] << 8 | coef[7], 20);
+    const double c01 = sign(coef[8] << 8 | coef[9], 16);
+    const double c11 = sign(coef[10] << 8 | coef[11], 16);
+    const double c20 = sign(coef[12] << 8 | coef[13], 16);
+    const double c21 = sign(coef[14] << 8 | coef[15], 16);
+    const double c30 = sign(coef[16] << 8 | coef[17], 16);
+
+    const double p = Praw / kP;
+    const double t = Traw / kT;
+    return c00 + p * (c10 + p * (c20 + p * c30)) + t * c01 + t * p * (c11 + p * c21);
+}
+
+static double referenceAltitude(double pressure)
+{
+    return (1.0 - pow(pressure / 101325.0, 0.190295)) * 4433000.0;
+}
+
+TEST(BarometerTest, AltitudeTableMatchesFormula)
+{
+    baroInitAltitudeTable();
+
+    double maxError = 0;
+    double maxSeaLevelError = 0;
+
+    for (float pressure = 24000; pressure < 120000; pressure += 0.37f) {
+        const double reference = referenceAltitude(pressure);
+        const double error = fabs(pressureToAltitude(pressure) - reference);
+        maxError = std::max(maxError, error);
+        if (pressure > 90000 && pressure < 110000) {
+            maxSeaLevelError = std::max(maxSeaLevelError, error);
+        }
+    }
+
+    EXPECT_LT(maxError, 0.35);
+    EXPECT_LT(maxSeaLevelError, 0.02);
+
+    // Outside of the table
+    EXPECT_NEAR(referenceAltitude(20000), pressureToAltitude(20000), 0.5);
+    EXPECT_NEAR(referenceAltitude(125000), pressureToAltitude(125000), 0.5);
+}
+
+TEST(BarometerTest, Bmp280DatasheetExample)
+{
+    baroDev_t dev = {};
+    fakeReset(FAKE_BMP280, BUSTYPE_I2C);
+    ASSERT_TRUE(bmp280Detect(&dev));
+    EXPECT_EQ(NULL, dev.start_up);
+
+    // Normal mode, the data registers are read without starting a measurement
+    EXPECT_EQ(0x03, fake.regs[BMP280_CTRL_MEAS_REG] & 0x03);
+
+    setBmp280Data(415148, 519888);
+    fake.transactions = 0;
+
+    int32_t pressure, temperature;
+    readBaro(&dev, &pressure, &temperature);
+
+    EXPECT_EQ(100653, pressure);
+    EXPECT_EQ(2508, temperature);
+    EXPECT_EQ(1u, fake.transactions);
+}
+
+TEST(BarometerTest, Bmp388MatchesIntegerCompensation)
+{
+    baroDev_t dev = {};
+    fakeReset(FAKE_BMP388, BUSTYPE_I2C);
+    ASSERT_TRUE(bmp388Detect(&dev));
+
+    double maxPressureError = 0;
+
+    for (uint32_t ut = 8000000; ut <= 8800000; ut += 100000) {
+        for (uint32_t up = 6000000; up <= 8000000; up += 50000) {
+            queueBmp388Frame(ut, up);
+
+            int32_t pressure, temperature;
+            readBaro(&dev, &pressure, &temperature);
+
+            int64_t referenceTemperature;
+            uint64_t referencePressure;
+            bmp388ReferenceCompensation(ut, up, &referenceTemperature, &referencePressure);
+
+            maxPressureError = std::max(maxPressureError, fabs(pressure - referencePressure / 100.0));
+            EXPECT_NEAR(referenceTemperature, temperature, 1);
+        }
+    }
+
+    // Rounding to whole pascals
+    EXPECT_LE(maxPressureError, 0.6);
+}
+
+TEST(BarometerTest, Bmp388DrainsFifoInOneRead)
+{
+    baroDev_t dev = {};
+    fakeReset(FAKE_BMP388, BUSTYPE_SPI);
+    ASSERT_TRUE(bmp388Detect(&dev));
+
+    // Normal mode with pressure and temperature in the FIFO
+    EXPECT_EQ(0x33, fake.regs[0x1B]);
+    EXPECT_EQ(0x19, fake.regs[0x17]);
+    EXPECT_EQ(0x00, fake.regs[0x18]);
+
+    int64_t t;
+    uint64_t p[3];
+    bmp388ReferenceCompensation(BMP388_RAW_TEMPERATURE, BMP388_RAW_PRESSURE, &t, &p[0]);
+    bmp388ReferenceCompensation(BMP388_RAW_TEMPERATURE, BMP388_RAW_PRESSURE + 10000, &t, &p[1]);
+    bmp388ReferenceCompensation(BMP388_RAW_TEMPERATURE, BMP388_RAW_PRESSURE + 20000, &t, &p[2]);
+    queueBmp388Frame(BMP388_RAW_TEMPERATURE, BMP388_RAW_PRESSURE);
+    queueBmp388Frame(BMP388_RAW_TEMPERATURE, BMP388_RAW_PRESSURE + 10000);
+    queueBmp388Frame(BMP388_RAW_TEMPERATURE, BMP388_RAW_PRESSURE + 20000);
+
+    fake.transactions = 0;
+    int32_t pressure, temperature;
+    readBaro(&dev, &pressure, &temperature);
+
+    // Length, then all frames at once
+    EXPECT_EQ(2u, fake.transactions);
+    EXPECT_EQ(3u, fake.samplesRead);
+    EXPECT_NEAR((p[0] + p[1] + p[2]) / 300.0, pressure, 0.6);
+    EXPECT_TRUE(fake.frames.empty());
+
+    // Nothing new
+    EXPECT_FALSE(dev.read(&dev));
+}
+
+TEST(BarometerTest, Bmp388KeepsFramesThatDontFit)
+{
+    baroDev_t dev = {};
+    fakeReset(FAKE_BMP388, BUSTYPE_I2C);
+    ASSERT_TRUE(bmp388Detect(&dev));
+
+    for (int i = 0; i < 20; i++) {
+        queueBmp388Frame(BMP388_RAW_TEMPERATURE, BMP388_RAW_PRESSURE + i * 1000);
+    }
+
+    int reads = 0;
+    while (dev.read(&dev)) {
+        reads++;
+    }
+
+    EXPECT_EQ(20u, fake.samplesRead);
+    EXPECT_EQ(3, reads);
+}
+
+TEST(BarometerTest, Dps310Fifo)
+{
+    baroDev_t dev = {};
+    fakeReset(FAKE_DPS310, BUSTYPE_I2C);
+    ASSERT_TRUE(baroDPS310Detect(&dev));
+    EXPECT_EQ(0x02, fake.regs[0x09] & 0x02);
+    EXPECT_EQ(0x07, fake.regs[0x08] & 0x07);
+
+    // The temperature of the single measurement at start compensates until the FIFO brings one
+    queueResult(DPS310_RAW_PRESSURE);
+    queueResult(DPS310_RAW_PRESSURE + 200);
+
+    int32_t pressure, temperature;
+    readBaro(&dev, &pressure, &temperature);
+
+    const double expected = (infineonReferencePressure(dps310Calibration, 253952, 253952, DPS310_RAW_PRESSURE, DPS310_RAW_TEMPERATURE) +
+                             infineonReferencePressure(dps310Calibration, 253952, 253952, DPS310_RAW_PRESSURE + 200, DPS310_RAW_TEMPERATURE)) / 2;
+    EXPECT_NEAR(expected, pressure, 1);
+    EXPECT_EQ(2500, temperature);
+    EXPECT_EQ(2u, fake.samplesRead);
+
+    // A new temperature applies to the pressures after it
+    queueResult(DPS310_RAW_TEMPERATURE + 2000);
+    queueResult(DPS310_RAW_PRESSURE);
+    readBaro(&dev, &pressure, &temperature);
+
+    EXPECT_NEAR(infineonReferencePressure(dps310Calibration, 253952, 253952, DPS310_RAW_PRESSURE, DPS310_RAW_TEMPERATURE + 2000), pressure, 1);
+    EXPECT_LT(temperature, 2500);
+
+    // Only a temperature
+    queueResult(DPS310_RAW_TEMPERATURE);
+    EXPECT_FALSE(dev.read(&dev));
+}
+
+TEST(BarometerTest, Spl06Fifo)
+{
+    baroDev_t dev = {};
+    fakeReset(FAKE_SPL06, BUSTYPE_I2C);
+    ASSERT_TRUE(spl06Detect(&dev));
+    EXPECT_EQ(SPL06_FIFO_ENABLE, fake.regs[SPL06_INT_AND_FIFO_CFG_REG] & SPL06_FIFO_ENABLE);
+    EXPECT_EQ(0x07, fake.regs[SPL06_MODE_AND_STATUS_REG] & 0x07);
+
+    for (int i = 0; i < 4; i++) {
+        queueResult(SPL06_RAW_PRESSURE + i * 1000);
+    }
+
+    fake.transactions = 0;
+    int32_t pressure, temperature;
+    readBaro(&dev, &pressure, &temperature);
+
+    double expected = 0;
+    for (int i = 0; i < 4; i++) {
+        expected += infineonReferencePressure(spl06Calibration, 7864320, 7864320, SPL06_RAW_PRESSURE + i * 1000, SPL06_RAW_TEMPERATURE) / 4;
+    }
+    EXPECT_NEAR(expected, pressure, 1);
+    EXPECT_EQ(2500, temperature);
+
+    // One read per result and one finding the FIFO empty
+    EXPECT_EQ(5u, fake.transactions);
+}
+
+/*
+ * The sensor measures at its own rate while the baro task reads at the interval the driver asks for,
+ * every sample has to come out of the FIFO.
+ */
+TEST(BarometerTest, Throughput)
+{
+    struct {
+        const char *name;
+        fakeSensor_e sensor;
+        bool (*detect)(baroDev_t *);
+        uint32_t sampleIntervalUs;
+    } sensors[] = {
+        { "BMP388", FAKE_BMP388, bmp388Detect, 20000 },
+        { "DPS310", FAKE_DPS310, baroDPS310Detect, 31250 },
+        { "SPL06", FAKE_SPL06, spl06Detect, 31250 },
+    };
+
+    for (const auto &sensor : sensors) {
+        SCOPED_TRACE(sensor.name);
+        fakeReset(sensor.sensor, BUSTYPE_I2C);
+        memset(&baro, 0, sizeof(baro));
+        ASSERT_TRUE(sensor.detect(&baro.dev));
+
+        unsigned produced = 0;
+        uint32_t nextSampleUs = 0;
+
+        for (uint32_t timeUs = 0; timeUs < 10000000;) {
+            while (nextSampleUs <= timeUs) {
+                if (sensor.sensor == FAKE_BMP388) {
+                    queueBmp388Frame(BMP388_RAW_TEMPERATURE, BMP388_RAW_PRESSURE + produced % 100);
+                } else {
+                    // Temperature once a second
+                    if (produced % 32 == 0) {
+                        queueResult(sensor.sensor == FAKE_DPS310 ? DPS310_RAW_TEMPERATURE : SPL06_RAW_TEMPERATURE);
+                    }
+                    queueResult(sensor.sensor == FAKE_DPS310 ? DPS310_RAW_PRESSURE : SPL06_RAW_PRESSURE);
+                }
+                produced++;
+                nextSampleUs += sensor.sampleIntervalUs;
+            }
+
+            timeUs += baroUpdate();
+        }
+
+        const unsigned queued = sensor.sensor == FAKE_BMP388 ? fake.frames.size() / BMP388_FRAME_SIZE : std::count_if(fake.results.begin(), fake.results.end(), [](uint32_t r) { return !(r & 1); });
+
+        EXPECT_EQ(produced, fake.samplesRead + queued);
+        EXPECT_LE(queued, 2u);
+        EXPECT_NEAR(100000, baro.baroPressure, 1000);
+    }
+}
+
+// STUBS
+
+extern "C" {
+uint8_t requestedSensors[SENSOR_INDEX_COUNT];
+uint8_t detectedSensors[SENSOR_INDEX_COUNT];
+
+bool sensors(uint32_t) { return true; }
+void sensorsSet(uint32_t) {}
+void sensorsClear(uint32_t) {}
+timeMs_t millis(void) { return 0; }
+void delay(timeMs_t) {}
+
+busDevice_t * busDeviceInit(busType_e, devHardwareType_e, uint8_t, resourceOwner_e) { return &fake.dev; }
+void busDeviceDeInit(busDevice_t *) {}
+void busSetSpeed(const busDevice_t *, busSpeed_e) {}
+
+bool busReadBuf(const busDevice_t * busdev, uint8_t reg, uint8_t * data, uint8_t length)
+{
+    fake.transactions++;
+    fake.bytes += length;
+
+    // The BMP388 answers SPI reads with a dummy byte first
+    if (fake.sensor == FAKE_BMP388 && busdev->busType == BUSTYPE_SPI) {
+        *data++ = 0xFF;
+        length--;
+    }
+
+    if (fake.sensor == FAKE_BMP388 && reg == 0x12) {
+        data[0] = fake.frames.size() & 0xFF;
+        data[1] = fake.frames.size() >> 8;
+        return true;
+    }
+
+    if (fake.sensor == FAKE_BMP388 && reg == 0x14) {
+        // Whole frames leave the FIFO, a partial one is read again next time. Past the end come empty frames.
+        const size_t available = std::min<size_t>(length, fake.frames.size());
+        std::copy(fake.frames.begin(), fake.frames.begin() + available, data);
+        for (size_t i = available; i < length; i++) {
+            data[i] = ((i - available) % 2) ? 0x00 : 0x80;
+        }
+        const size_t frames = available / BMP388_FRAME_SIZE;
+        fake.frames.erase(fake.frames.begin(), fake.frames.begin() + frames * BMP388_FRAME_SIZE);
+        fake.samplesRead += frames;
+        return true;
+    }
+
+    if ((fake.sensor == FAKE_DPS310 || fake.sensor == FAKE_SPL06) && reg == 0x00 && (fake.regs[0x09] & 0x02)) {
+        uint32_t result = INFINEON_FIFO_EMPTY;
+        if (!fake.results.empty()) {
+            result = fake.results.front();
+            fake.results.pop_front();
+            if (!(result & 1)) {
+                fake.samplesRead++;
+            }
+        }
+        data[0] = result >> 16;
+        data[1] = result >> 8;
+        data[2] = result;
+        return true;
+    }
+
+    memcpy(data, &fake.regs[reg], length);
+    return true;
+}
+
+bool busRead(const busDevice_t * busdev, uint8_t reg, uint8_t * data)
+{
+    return busReadBuf(busdev, reg, data, 1);
+}
+
+bool busWrite(const busDevice_t *, uint8_t reg, uint8_t data)
+{
+    fake.transactions++;
+    fake.bytes++;
+
+    if (fake.sensor == FAKE_BMP388 && reg == 0x7E && data == 0xB0) {
+        fake.frames.clear();
+        return true;
+    }
+
+    if ((fake.sensor == FAKE_DPS310 || fake.sensor == FAKE_SPL06) && reg == 0x0C) {
+        if (data & 0x80) {
+            fake.results.clear();
+        }
+        return true;
+    }
+
+    fake.regs[reg] = data;
+    return true;
+}
+}
@@ -0,0 +1,271 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox_gyro_capture.h"
+    #include "blackbox/blackbox_io.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static std::vector<uint8_t> deviceData;
+static int32_t deviceFreeSpace;
+
+// What a host side tool reading the log back would do
+typedef struct decodedCapture_s {
+    gyroCaptureHeader_t header;
+    std::vector<float> samples[XYZ_AXIS_COUNT];
+    uint32_t gapSamples;
+    bool ended;
+} decodedCapture_t;
+
+static bool decodeCapture(const std::vector<uint8_t> &data, decodedCapture_t *capture)
+{
+    if (!gyroCaptureDecodeHeader(data.data(), data.size(), &capture->header)) {
+        return false;
+    }
+
+    capture->gapSamples = 0;
+    capture->ended = false;
+
+    for (size_t offset = GYRO_CAPTURE_HEADER_SIZE; offset + GYRO_CAPTURE_RECORD_SIZE <= data.size(); offset += GYRO_CAPTURE_RECORD_SIZE) {
+        int16_t values[XYZ_AXIS_COUNT];
+
+        switch (gyroCaptureDecodeRecord(&data[offset], values)) {
+        case GYRO_CAPTURE_RECORD_SAMPLE:
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                capture->samples[axis].push_back(values[axis] * capture->header.scale);
+            }
+            break;
+        case GYRO_CAPTURE_RECORD_GAP:
+            capture->gapSamples += values[2];
+            break;
+        case GYRO_CAPTURE_RECORD_END:
+            capture->ended = true;
+            // Nothing belongs to the capture after the END record
+            return offset + GYRO_CAPTURE_RECORD_SIZE == data.size();
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void resetDevice(int32_t freeSpace)
+{
+    deviceData.clear();
+    deviceFreeSpace = freeSpace;
+}
+
+static void pushSample(float roll, float pitch, float yaw)
+{
+    const float sample[XYZ_AXIS_COUNT] = { roll, pitch, yaw };
+    gyroCapturePush(sample);
+}
+
+TEST(GyroCaptureTest, HeaderRoundTrip)
+{
+    gyroCaptureHeader_t header = {
+        .version = GYRO_CAPTURE_VERSION,
+        .source = GYRO_CAPTURE_PREFILTERED,
+        .axisCount = XYZ_AXIS_COUNT,
+        .sampleIntervalUs = 125,
+        .antiAliasLpfHz = 250,
+        .windowSamples = 80000,
+        .scale = 0.0625f,
+    };
+    uint8_t buf[GYRO_CAPTURE_HEADER_SIZE];
+
+    EXPECT_EQ(GYRO_CAPTURE_HEADER_SIZE, gyroCaptureEncodeHeader(&header, buf));
+    EXPECT_EQ(0, memcmp(buf, "INAVGCAP", 8));
+    // Little endian on the wire whatever the host
+    EXPECT_EQ(125, buf[12]);
+    EXPECT_EQ(0, buf[13]);
+
+    gyroCaptureHeader_t decoded;
+    ASSERT_TRUE(gyroCaptureDecodeHeader(buf, sizeof(buf), &decoded));
+    EXPECT_EQ(GYRO_CAPTURE_PREFILTERED, decoded.source);
+    EXPECT_EQ(125, decoded.sampleIntervalUs);
+    EXPECT_EQ(250, decoded.antiAliasLpfHz);
+    EXPECT_EQ(80000u, decoded.windowSamples);
+    EXPECT_FLOAT_EQ(0.0625f, decoded.scale);
+
+    EXPECT_FALSE(gyroCaptureDecodeHeader(buf, sizeof(buf) - 1, &decoded));
+    buf[0] = 'H';
+    EXPECT_FALSE(gyroCaptureDecodeHeader(buf, sizeof(buf), &decoded));
+}
+
+TEST(GyroCaptureTest, CaptureWindow)
+{
+    resetDevice(100000);
+
+    // 10ms at 4kHz
+    gyroCaptureStart(GYRO_CAPTURE_RAW, 10, 250, 250);
+    EXPECT_TRUE(gyroCaptureIsRunning());
+
+    for (int i = 0; i < 40; i++) {
+        pushSample(i, -i * 0.5f, 1000.0f);
+        if (i % 4 == 3 && i < 39) {
+            EXPECT_FALSE(gyroCaptureWrite());
+        }
+    }
+
+    // Samples past the window are ignored
+    EXPECT_FALSE(gyroCaptureIsRunning());
+    pushSample(1, 2, 3);
+
+    EXPECT_TRUE(gyroCaptureWrite());
+
+    decodedCapture_t capture;
+    ASSERT_TRUE(decodeCapture(deviceData, &capture));
+    EXPECT_TRUE(capture.ended);
+    EXPECT_EQ(GYRO_CAPTURE_RAW, capture.header.source);
+    EXPECT_EQ(250, capture.header.sampleIntervalUs);
+    EXPECT_EQ(40u, capture.header.windowSamples);
+    EXPECT_EQ(0u, capture.gapSamples);
+
+    ASSERT_EQ(40u, capture.samples[X].size());
+    for (int i = 0; i < 40; i++) {
+        EXPECT_NEAR(i, capture.samples[X][i], 1.0f / GYRO_CAPTURE_LSB_PER_DPS);
+        EXPECT_NEAR(-i * 0.5f, capture.samples[Y][i], 1.0f / GYRO_CAPTURE_LSB_PER_DPS);
+        EXPECT_NEAR(1000.0f, capture.samples[Z][i], 1.0f / GYRO_CAPTURE_LSB_PER_DPS);
+    }
+
+    EXPECT_EQ(40u, gyroCaptureGetStats()->samplesCaptured);
+}
+
+TEST(GyroCaptureTest, ClippedSamplesAreNotMarkers)
+{
+    resetDevice(100000);
+
+    gyroCaptureStart(GYRO_CAPTURE_RAW, 1, 250, 0);
+    pushSample(-5000.0f, 5000.0f, 0);
+    pushSample(0, 0, 0);
+    pushSample(0, 0, 0);
+    pushSample(0, 0, 0);
+    EXPECT_TRUE(gyroCaptureWrite());
+
+    decodedCapture_t capture;
+    ASSERT_TRUE(decodeCapture(deviceData, &capture));
+    ASSERT_EQ(4u, capture.samples[X].size());
+    EXPECT_FLOAT_EQ(-INT16_MAX * capture.header.scale, capture.samples[X][0]);
+    EXPECT_FLOAT_EQ(INT16_MAX * capture.header.scale, capture.samples[Y][0]);
+}
+
+TEST(GyroCaptureTest, SlowDeviceRecordsGap)
+{
+    // Room for the header only
+    resetDevice(GYRO_CAPTURE_HEADER_SIZE);
+
+    gyroCaptureStart(GYRO_CAPTURE_PREFILTERED, 1000, 250, 250);
+    EXPECT_FALSE(gyroCaptureWrite());
+
+    for (int i = 0; i < 1000; i++) {
+        pushSample(i, 0, 0);
+    }
+    EXPECT_FALSE(gyroCaptureWrite());
+
+    deviceFreeSpace = 100000;
+    gyroCaptureStop();
+    EXPECT_TRUE(gyroCaptureWrite());
+
+    const gyroCaptureStats_t *stats = gyroCaptureGetStats();
+    EXPECT_GT(stats->samplesDropped, 0u);
+    EXPECT_EQ(1000u, stats->samplesCaptured + stats->samplesDropped);
+
+    decodedCapture_t capture;
+    ASSERT_TRUE(decodeCapture(deviceData, &capture));
+    EXPECT_TRUE(capture.ended);
+    EXPECT_EQ(stats->samplesCaptured, capture.samples[X].size());
+    EXPECT_EQ(stats->samplesDropped, capture.gapSamples);
+
+    // What made it in is the start of the window
+    EXPECT_FLOAT_EQ(0.0f, capture.samples[X][0]);
+    EXPECT_FLOAT_EQ(capture.samples[X].size() - 1, capture.samples[X].back());
+}
+
+TEST(GyroCaptureTest, GapBeforeResumedSamples)
+{
+    resetDevice(100000);
+
+    gyroCaptureStart(GYRO_CAPTURE_RAW, 1000, 250, 250);
+    ASSERT_FALSE(gyroCaptureWrite());
+
+    // Overflow the buffer, then drain it and keep going
+    deviceFreeSpace = 0;
+    int i = 0;
+    for (; i < 200; i++) {
+        pushSample(i, 0, 0);
+    }
+    deviceFreeSpace = 100000;
+    ASSERT_FALSE(gyroCaptureWrite());
+    for (; i < 210; i++) {
+        pushSample(i, 0, 0);
+    }
+    gyroCaptureStop();
+    ASSERT_TRUE(gyroCaptureWrite());
+
+    // Walk the records, the gap shows up where the samples went missing
+    std::vector<float> timeline;
+    for (size_t offset = GYRO_CAPTURE_HEADER_SIZE; offset < deviceData.size(); offset += GYRO_CAPTURE_RECORD_SIZE) {
+        int16_t values[XYZ_AXIS_COUNT];
+        const gyroCaptureRecordType_e type = gyroCaptureDecodeRecord(&deviceData[offset], values);
+        if (type == GYRO_CAPTURE_RECORD_SAMPLE) {
+            timeline.push_back(values[X] / (float)GYRO_CAPTURE_LSB_PER_DPS);
+        } else if (type == GYRO_CAPTURE_RECORD_GAP) {
+            timeline.insert(timeline.end(), values[2], -1.0f);
+        }
+    }
+
+    ASSERT_EQ(210u, timeline.size());
+    for (int n = 0; n < 210; n++) {
+        EXPECT_TRUE(timeline[n] == n || timeline[n] == -1.0f) << n;
+    }
+    EXPECT_EQ(209.0f, timeline.back());
+}
+
+// STUBS
+
+extern "C" {
+
+void blackboxWrite(uint8_t value)
+{
+    EXPECT_GT(deviceFreeSpace, 0);
+    deviceData.push_back(value);
+    deviceFreeSpace--;
+}
+
+blackboxBufferReserveStatus_e blackboxDeviceReserveBufferSpace(int32_t bytes)
+{
+    return bytes <= deviceFreeSpace ? BLACKBOX_RESERVE_SUCCESS : BLACKBOX_RESERVE_TEMPORARY_FAILURE;
+}
+
+void blackboxDeviceFlush(void)
+{
+}
+
+}
@@ -0,0 +1,195 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "config/config_eeprom.h"
+    #include "config/parameter_group.h"
+    #include "config/parameter_group_ids.h"
+
+    #include "drivers/system.h"
+
+    #include "config/config_streamer.h"
+    #include "fc/config.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+// Parameter groups normally come from a linker section, the test provides its own registry
+
+typedef struct {
+    uint32_t value;
+    uint8_t data[60];
+} testSystemConfig_t;
+
+typedef struct {
+    uint16_t value;
+} testProfileConfig_t;
+
+static testSystemConfig_t testSystemConfig;
+static testProfileConfig_t testProfileConfig[MAX_PROFILE_COUNT];
+static testProfileConfig_t *testProfileConfigCurrent;
+
+extern "C" {
+extern const pgRegistry_t testPgRegistry[2];
+const pgRegistry_t testPgRegistry[2] = {
+    {
+        .pgn = PG_RESERVED_FOR_TESTING_1,
+        .size = sizeof(testSystemConfig_t) | PGR_SIZE_SYSTEM_FLAG,
+        .address = (uint8_t *)&testSystemConfig,
+        .copy = NULL,
+        .ptr = NULL,
+        .reset = { .ptr = NULL },
+    },
+    {
+        .pgn = PG_RESERVED_FOR_TESTING_2,
+        .size = sizeof(testProfileConfig_t) | PGR_SIZE_PROFILE_FLAG,
+        .address = (uint8_t *)&testProfileConfig,
+        .copy = NULL,
+        .ptr = (uint8_t **)&testProfileConfigCurrent,
+        .reset = { .ptr = NULL },
+    },
+};
+extern const uint8_t testPgResetData[1];
+const uint8_t testPgResetData[1] = { 0 };
+}
+
+static_assert(sizeof(testPgRegistry) == 80, "registry end symbol below assumes 40 byte entries");
+asm(".globl __pg_registry_start\n .set __pg_registry_start, testPgRegistry\n"
+    ".globl __pg_registry_end\n .set __pg_registry_end, testPgRegistry + 80\n"
+    ".globl __pg_resetdata_start\n .set __pg_resetdata_start, testPgResetData\n"
+    ".globl __pg_resetdata_end\n .set __pg_resetdata_end, testPgResetData\n");
+
+static char testEepromPath[] = "config_eeprom_file_unittest.bin";
+
+static void setTestConfig(uint32_t value)
+{
+    testSystemConfig.value = value;
+    memset(testSystemConfig.data, value, sizeof(testSystemConfig.data));
+    for (int i = 0; i < MAX_PROFILE_COUNT; i++) {
+        testProfileConfig[i].value = value + i;
+    }
+}
+
+extern "C" void config_streamer_impl_lock(void);
+
+// Throw away everything in memory and start from the file, like SITL does on a restart
+static void reboot(void)
+{
+    // Close the file if it was left open by the previous boot
+    config_streamer_impl_lock();
+
+    memset(eepromData, 0, sizeof(eepromData));
+    memset(&testSystemConfig, 0, sizeof(testSystemConfig));
+    memset(&testProfileConfig, 0, sizeof(testProfileConfig));
+
+    initEEPROM();
+}
+
+static void expectTestConfig(uint32_t value)
+{
+    ASSERT_TRUE(isEEPROMContentValid());
+    ASSERT_TRUE(loadEEPROM());
+
+    EXPECT_EQ(value, testSystemConfig.value);
+    EXPECT_EQ((uint8_t)value, testSystemConfig.data[sizeof(testSystemConfig.data) - 1]);
+    for (int i = 0; i < MAX_PROFILE_COUNT; i++) {
+        EXPECT_EQ(value + i, testProfileConfig[i].value);
+    }
+}
+
+TEST(ConfigEepromFileTest, SavesSurviveRestart)
+{
+    remove(testEepromPath);
+    ASSERT_TRUE(configFileSetPath(testEepromPath));
+    reboot();
+    EXPECT_FALSE(isEEPROMContentValid());
+
+    setTestConfig(5);
+    writeConfigToEEPROM();
+    EXPECT_TRUE(getEEPROMSaveStats()->lastSaveCompacted);
+
+    reboot();
+    expectTestConfig(5);
+
+    testProfileConfig[2].value = 1234;
+    writeConfigToEEPROM();
+    EXPECT_FALSE(getEEPROMSaveStats()->lastSaveCompacted);
+    EXPECT_EQ(1u, getEEPROMSaveStats()->lastRecordsWritten);
+
+    reboot();
+    ASSERT_TRUE(loadEEPROM());
+    EXPECT_EQ(5u, testSystemConfig.value);
+    EXPECT_EQ(1234, testProfileConfig[2].value);
+}
+
+TEST(ConfigEepromFileTest, CompactionLeavesNoStaleTail)
+{
+    remove(testEepromPath);
+    ASSERT_TRUE(configFileSetPath(testEepromPath));
+    reboot();
+
+    setTestConfig(0);
+    writeConfigToEEPROM();
+    const uint16_t compactionCount = getEEPROMSaveStats()->compactionCount;
+
+    uint32_t value = 0;
+    while (getEEPROMSaveStats()->compactionCount == compactionCount) {
+        setTestConfig(++value);
+        writeConfigToEEPROM();
+        ASSERT_LT(value, (uint32_t)EEPROM_SIZE);
+    }
+
+    reboot();
+    expectTestConfig(value);
+
+    // Segments of the log before the compaction are gone from the file, the next save can append
+    setTestConfig(++value);
+    writeConfigToEEPROM();
+    EXPECT_FALSE(getEEPROMSaveStats()->lastSaveCompacted);
+
+    reboot();
+    expectTestConfig(value);
+
+    remove(testEepromPath);
+}
+
+// STUBS
+
+extern "C" {
+
+static uint32_t testMicros;
+
+uint32_t micros(void)
+{
+    return testMicros += 10;
+}
+
+void failureMode(failureMode_e mode)
+{
+    UNUSED(mode);
+    FAIL() << "failureMode";
+}
+
+}
@@ -0,0 +1,360 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "config/config_eeprom.h"
+    #include "config/parameter_group.h"
+    #include "config/parameter_group_ids.h"
+
+    #include "drivers/system.h"
+
+    #include "fc/config.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+// Parameter groups normally come from a linker section, the test provides its own registry
+
+typedef struct {
+    uint32_t value;
+    uint8_t data[40];
+} testSystemConfig_t;
+
+typedef struct {
+    uint16_t value;
+} testSmallConfig_t;
+
+typedef struct {
+    uint8_t value[10];
+} testProfileConfig_t;
+
+static testSystemConfig_t testSystemConfig;
+static testSmallConfig_t testSmallConfig;
+static testProfileConfig_t testProfileConfig[MAX_PROFILE_COUNT];
+static testProfileConfig_t *testProfileConfigCurrent;
+
+static void resetTestSystemConfig(void *base)
+{
+    ((testSystemConfig_t *)base)->value = 1;
+}
+
+extern "C" {
+extern const pgRegistry_t testPgRegistry[3];
+const pgRegistry_t testPgRegistry[3] = {
+    {
+        .pgn = PG_RESERVED_FOR_TESTING_1 | (1 << 12),
+        .size = sizeof(testSystemConfig_t) | PGR_SIZE_SYSTEM_FLAG,
+        .address = (uint8_t *)&testSystemConfig,
+        .copy = NULL,
+        .ptr = NULL,
+        .reset = { .fn = resetTestSystemConfig },
+    },
+    {
+        .pgn = PG_RESERVED_FOR_TESTING_2 | (0 << 12),
+        .size = sizeof(testSmallConfig_t) | PGR_SIZE_SYSTEM_FLAG,
+        .address = (uint8_t *)&testSmallConfig,
+        .copy = NULL,
+        .ptr = NULL,
+        .reset = { .ptr = NULL },
+    },
+    {
+        .pgn = PG_RESERVED_FOR_TESTING_3 | (2 << 12),
+        .size = sizeof(testProfileConfig_t) | PGR_SIZE_PROFILE_FLAG,
+        .address = (uint8_t *)&testProfileConfig,
+        .copy = NULL,
+        .ptr = (uint8_t **)&testProfileConfigCurrent,
+        .reset = { .ptr = NULL },
+    },
+};
+extern const uint8_t testPgResetData[1];
+const uint8_t testPgResetData[1] = { 0 };
+}
+
+static_assert(sizeof(testPgRegistry) == 120, "registry end symbol below assumes 40 byte entries");
+asm(".globl __pg_registry_start\n .set __pg_registry_start, testPgRegistry\n"
+    ".globl __pg_registry_end\n .set __pg_registry_end, testPgRegistry + 120\n"
+    ".globl __pg_resetdata_start\n .set __pg_resetdata_start, testPgResetData\n"
+    ".globl __pg_resetdata_end\n .set __pg_resetdata_end, testPgResetData\n");
+
+static void setTestConfig(uint32_t value)
+{
+    testSystemConfig.value = value;
+    memset(testSystemConfig.data, value, sizeof(testSystemConfig.data));
+    testSmallConfig.value = value + 1;
+    for (int i = 0; i < MAX_PROFILE_COUNT; i++) {
+        memset(testProfileConfig[i].value, value + 10 * i, sizeof(testProfileConfig[i].value));
+    }
+}
+
+static void expectTestConfig(uint32_t value)
+{
+    // Load into clean memory so nothing is left over from before the save
+    memset(&testSystemConfig, 0xAA, sizeof(testSystemConfig));
+    memset(&testSmallConfig, 0xAA, sizeof(testSmallConfig));
+    memset(&testProfileConfig, 0xAA, sizeof(testProfileConfig));
+
+    ASSERT_TRUE(isEEPROMContentValid());
+    ASSERT_TRUE(loadEEPROM());
+
+    EXPECT_EQ(value, testSystemConfig.value);
+    EXPECT_EQ((uint8_t)value, testSystemConfig.data[sizeof(testSystemConfig.data) - 1]);
+    EXPECT_EQ(value + 1, testSmallConfig.value);
+    for (int i = 0; i < MAX_PROFILE_COUNT; i++) {
+        EXPECT_EQ((uint8_t)(value + 10 * i), testProfileConfig[i].value[0]);
+    }
+}
+
+static void eraseEEPROM(void)
+{
+    memset(eepromData, 0, sizeof(eepromData));
+}
+
+TEST(ConfigEepromTest, EmptyConfigLoadsDefaults)
+{
+    eraseEEPROM();
+
+    EXPECT_FALSE(isEEPROMContentValid());
+
+    testSystemConfig.value = 100;
+    loadEEPROM();
+    EXPECT_EQ(1u, testSystemConfig.value);
+}
+
+TEST(ConfigEepromTest, FirstSaveWritesEverything)
+{
+    eraseEEPROM();
+
+    setTestConfig(5);
+    writeConfigToEEPROM();
+
+    const configSaveStats_t *stats = getEEPROMSaveStats();
+    EXPECT_TRUE(stats->lastSaveCompacted);
+    EXPECT_EQ(1 + 1 + MAX_PROFILE_COUNT, stats->lastRecordsWritten);
+    EXPECT_EQ(getEEPROMConfigSize(), stats->lastBytesWritten);
+
+    expectTestConfig(5);
+}
+
+TEST(ConfigEepromTest, UnchangedSaveWritesNothing)
+{
+    eraseEEPROM();
+
+    setTestConfig(5);
+    writeConfigToEEPROM();
+    const uint32_t configSize = getEEPROMConfigSize();
+
+    writeConfigToEEPROM();
+
+    const configSaveStats_t *stats = getEEPROMSaveStats();
+    EXPECT_FALSE(stats->lastSaveCompacted);
+    EXPECT_EQ(0u, stats->lastBytesWritten);
+    EXPECT_EQ(0u, stats->lastRecordsWritten);
+    EXPECT_EQ(configSize, getEEPROMConfigSize());
+}
+
+TEST(ConfigEepromTest, ChangedRecordIsAppended)
+{
+    eraseEEPROM();
+
+    setTestConfig(5);
+    writeConfigToEEPROM();
+    const uint32_t configSize = getEEPROMConfigSize();
+    const uint16_t compactionCount = getEEPROMSaveStats()->compactionCount;
+
+    memset(testProfileConfig[1].value, 99, sizeof(testProfileConfig[1].value));
+    writeConfigToEEPROM();
+
+    const configSaveStats_t *stats = getEEPROMSaveStats();
+    EXPECT_FALSE(stats->lastSaveCompacted);
+    EXPECT_EQ(1u, stats->lastRecordsWritten);
+    EXPECT_EQ(compactionCount, stats->compactionCount);
+    EXPECT_EQ(configSize + stats->lastBytesWritten, getEEPROMConfigSize());
+
+    memset(&testProfileConfig, 0, sizeof(testProfileConfig));
+    ASSERT_TRUE(loadEEPROM());
+    EXPECT_EQ(5, testProfileConfig[0].value[0]);
+    EXPECT_EQ(99, testProfileConfig[1].value[0]);
+    EXPECT_EQ(25, testProfileConfig[2].value[0]);
+    EXPECT_EQ(5u, testSystemConfig.value);
+}
+
+TEST(ConfigEepromTest, FullLogIsCompacted)
+{
+    eraseEEPROM();
+
+    setTestConfig(0);
+    writeConfigToEEPROM();
+    const uint32_t compactedSize = getEEPROMConfigSize();
+    const uint16_t compactionCount = getEEPROMSaveStats()->compactionCount;
+
+    uint32_t value = 0;
+    while (getEEPROMSaveStats()->compactionCount == compactionCount) {
+        setTestConfig(++value);
+        writeConfigToEEPROM();
+        ASSERT_LT(value, (uint32_t)EEPROM_SIZE);
+    }
+
+    // Every save before the compaction only appended
+    EXPECT_GT(value, 10u);
+    EXPECT_TRUE(getEEPROMSaveStats()->lastSaveCompacted);
+    EXPECT_EQ(compactedSize, getEEPROMConfigSize());
+
+    expectTestConfig(value);
+}
+
+TEST(ConfigEepromTest, InterruptedAppendIsIgnored)
+{
+    eraseEEPROM();
+
+    setTestConfig(5);
+    writeConfigToEEPROM();
+    const uint32_t configSize = getEEPROMConfigSize();
+
+    setTestConfig(6);
+    writeConfigToEEPROM();
+
+    // Power lost before the checksum of the appended segment was written
+    eepromData[getEEPROMConfigSize() - 4] ^= 0xFF;
+
+    expectTestConfig(5);
+    EXPECT_EQ(configSize, getEEPROMConfigSize());
+
+    // The damaged segment can't be appended to
+    setTestConfig(7);
+    writeConfigToEEPROM();
+    EXPECT_TRUE(getEEPROMSaveStats()->lastSaveCompacted);
+
+    expectTestConfig(7);
+}
+
+TEST(ConfigEepromTest, SegmentsOfPreviousLogAreIgnored)
+{
+    eraseEEPROM();
+
+    setTestConfig(5);
+    writeConfigToEEPROM();
+    const uint32_t baseSize = getEEPROMConfigSize();
+
+    setTestConfig(6);
+    writeConfigToEEPROM();
+    const uint32_t logSize = getEEPROMConfigSize();
+    uint8_t segment[EEPROM_SIZE];
+    memcpy(segment, &eepromData[baseSize], logSize - baseSize);
+
+    // Garbage after the log forces a compaction, with the same content as the first one
+    eepromData[logSize] = 0x55;
+    setTestConfig(5);
+    writeConfigToEEPROM();
+    EXPECT_TRUE(getEEPROMSaveStats()->lastSaveCompacted);
+    ASSERT_EQ(baseSize, getEEPROMConfigSize());
+
+    // Flash which wasn't erased still holds the segment appended to the old log
+    memcpy(&eepromData[baseSize], segment, logSize - baseSize);
+
+    expectTestConfig(5);
+    EXPECT_EQ(baseSize, getEEPROMConfigSize());
+}
+
+TEST(ConfigEepromTest, AppendNeedsErasedSpace)
+{
+    eraseEEPROM();
+
+    setTestConfig(5);
+    writeConfigToEEPROM();
+    const uint32_t configSize = getEEPROMConfigSize();
+
+    // Programmed inside the space the next segment needs, the log still ends cleanly before it
+    eepromData[configSize + 8] = 0x55;
+    ASSERT_TRUE(isEEPROMContentValid());
+    ASSERT_EQ(configSize, getEEPROMConfigSize());
+
+    testSmallConfig.value = 99;
+    writeConfigToEEPROM();
+    EXPECT_TRUE(getEEPROMSaveStats()->lastSaveCompacted);
+    EXPECT_EQ(configSize, getEEPROMConfigSize());
+
+    memset(&testSmallConfig, 0, sizeof(testSmallConfig));
+    ASSERT_TRUE(loadEEPROM());
+    EXPECT_EQ(99, testSmallConfig.value);
+    EXPECT_EQ(5u, testSystemConfig.value);
+}
+
+TEST(ConfigEepromTest, AppendNotReadBackIsRewritten)
+{
+    eraseEEPROM();
+
+    setTestConfig(5);
+    writeConfigToEEPROM();
+    const uint32_t configSize = getEEPROMConfigSize();
+    const uint16_t saveCount = getEEPROMSaveStats()->saveCount;
+
+    // Right after the segment holding the small PG record (6 + 2 bytes, footer and checksum), the scan of the log
+    // after the save finds it damaged
+    eepromData[configSize + 12] = 0x55;
+
+    testSmallConfig.value = 99;
+    writeConfigToEEPROM();
+    EXPECT_TRUE(getEEPROMSaveStats()->lastSaveCompacted);
+    EXPECT_EQ(saveCount + 1, getEEPROMSaveStats()->saveCount);
+    EXPECT_EQ(configSize, getEEPROMConfigSize());
+
+    memset(&testSmallConfig, 0, sizeof(testSmallConfig));
+    ASSERT_TRUE(loadEEPROM());
+    EXPECT_EQ(99, testSmallConfig.value);
+    EXPECT_EQ(5u, testSystemConfig.value);
+}
+
+TEST(ConfigEepromTest, SaveStats)
+{
+    eraseEEPROM();
+
+    const uint16_t saveCount = getEEPROMSaveStats()->saveCount;
+
+    setTestConfig(5);
+    writeConfigToEEPROM();
+
+    const configSaveStats_t *stats = getEEPROMSaveStats();
+    EXPECT_EQ(saveCount + 1, stats->saveCount);
+    EXPECT_GT(stats->lastDurationUs, 0u);
+    EXPECT_GE(stats->maxDurationUs, stats->lastDurationUs);
+}
+
+// STUBS
+
+extern "C" {
+
+static uint32_t testMicros;
+
+uint32_t micros(void)
+{
+    return testMicros += 10;
+}
+
+void failureMode(failureMode_e mode)
+{
+    UNUSED(mode);
+    FAIL() << "failureMode";
+}
+
+}
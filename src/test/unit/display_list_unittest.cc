@@ -0,0 +1,494 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "drivers/display_canvas.h"
+    #include "drivers/display_list.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define GROUP_HORIZON       0
+#define GROUP_ARROW         1
+#define GROUP_VARIO         2
+#define GROUP_HEADING       3
+
+// Drawing state of the renderer, as a display keeps it
+typedef struct rendererState_s {
+    int strokeColor;
+    int fillColor;
+    int strokeWidth;
+    int outlineType;
+    int outlineColor;
+    int colorInversion;
+    std::string transform;      // Clip and transformations applied so far
+} rendererState_t;
+
+static const rendererState_t rendererDefaultState = { DISPLAY_CANVAS_COLOR_WHITE, DISPLAY_CANVAS_COLOR_TRANSPARENT, 1, 0, DISPLAY_CANVAS_COLOR_BLACK, 0, "" };
+
+// Host renderer, counts the bytes a FrSky OSD gets for each primitive and logs what's drawn with the state it's drawn in
+static struct {
+    unsigned bytes;
+    unsigned commands;
+    unsigned stateCommands;
+    rendererState_t state;
+    std::vector<rendererState_t> stack;
+    std::vector<std::string> log;
+} renderer;
+
+static void rendererReset(void)
+{
+    renderer.state = rendererDefaultState;
+    renderer.stack.clear();
+}
+
+static void rendererSend(unsigned payloadSize)
+{
+    // Command byte and payload, points are 3 bytes and rects 6
+    renderer.bytes += 1 + payloadSize;
+    renderer.commands++;
+}
+
+static void rendererDraw(unsigned payloadSize, const char *op, int a = 0, int b = 0, int c = 0, int d = 0, int e = 0, int f = 0, const char *s = "")
+{
+    rendererSend(payloadSize);
+
+    char buf[256];
+    const rendererState_t *st = &renderer.state;
+    snprintf(buf, sizeof(buf), "%s(%d,%d,%d,%d,%d,%d,%s) stroke=%d fill=%d width=%d outline=%d/%d inv=%d %s",
+        op, a, b, c, d, e, f, s, st->strokeColor, st->fillColor, st->strokeWidth, st->outlineType, st->outlineColor, st->colorInversion, st->transform.c_str());
+    renderer.log.push_back(buf);
+}
+
+static void rendererTransform(unsigned payloadSize, const char *op, float a, float b = 0)
+{
+    rendererSend(payloadSize);
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s(%g,%g);", op, a, b);
+    renderer.state.transform += buf;
+}
+
+static void rendererSetState(int *field, int value)
+{
+    rendererSend(1);
+    renderer.stateCommands++;
+    *field = value;
+}
+
+extern "C" {
+
+static void setStrokeColor(displayCanvas_t *canvas, displayCanvasColor_e color) { UNUSED(canvas); rendererSetState(&renderer.state.strokeColor, color); }
+static void setFillColor(displayCanvas_t *canvas, displayCanvasColor_e color) { UNUSED(canvas); rendererSetState(&renderer.state.fillColor, color); }
+static void setStrokeAndFillColor(displayCanvas_t *canvas, displayCanvasColor_e color)
+{
+    UNUSED(canvas);
+    rendererSetState(&renderer.state.strokeColor, color);
+    renderer.state.fillColor = color;
+}
+static void setColorInversion(displayCanvas_t *canvas, bool inverted) { UNUSED(canvas); rendererSetState(&renderer.state.colorInversion, inverted); }
+static void setPixel(displayCanvas_t *canvas, int x, int y, displayCanvasColor_e color) { UNUSED(canvas); rendererDraw(4, "setPixel", x, y, color); }
+static void setPixelToStrokeColor(displayCanvas_t *canvas, int x, int y) { UNUSED(canvas); rendererDraw(3, "setPixelToStrokeColor", x, y); }
+static void setPixelToFillColor(displayCanvas_t *canvas, int x, int y) { UNUSED(canvas); rendererDraw(3, "setPixelToFillColor", x, y); }
+static void setStrokeWidth(displayCanvas_t *canvas, unsigned w) { UNUSED(canvas); rendererSetState(&renderer.state.strokeWidth, w); }
+static void setLineOutlineType(displayCanvas_t *canvas, displayCanvasOutlineType_e type) { UNUSED(canvas); rendererSetState(&renderer.state.outlineType, type); }
+static void setLineOutlineColor(displayCanvas_t *canvas, displayCanvasColor_e color) { UNUSED(canvas); rendererSetState(&renderer.state.outlineColor, color); }
+static void clipToRect(displayCanvas_t *canvas, int x, int y, int w, int h)
+{
+    UNUSED(canvas);
+    rendererSend(6);
+    char buf[64];
+    snprintf(buf, sizeof(buf), "clip(%d,%d,%d,%d);", x, y, w, h);
+    renderer.state.transform += buf;
+}
+static void clearRect(displayCanvas_t *canvas, int x, int y, int w, int h) { UNUSED(canvas); rendererDraw(6, "clearRect", x, y, w, h); }
+static void resetDrawingState(displayCanvas_t *canvas) { UNUSED(canvas); rendererSend(0); renderer.state = rendererDefaultState; }
+static void drawCharacter(displayCanvas_t *canvas, int x, int y, uint16_t chr, displayCanvasBitmapOption_t opts) { UNUSED(canvas); rendererDraw(6, "drawCharacter", x, y, chr, opts); }
+static void drawCharacterMask(displayCanvas_t *canvas, int x, int y, uint16_t chr, displayCanvasColor_e color, displayCanvasBitmapOption_t opts) { UNUSED(canvas); rendererDraw(7, "drawCharacterMask", x, y, chr, color, opts); }
+static void drawString(displayCanvas_t *canvas, int x, int y, const char *s, displayCanvasBitmapOption_t opts) { UNUSED(canvas); rendererDraw(5 + strlen(s), "drawString", x, y, opts, 0, 0, 0, s); }
+static void drawStringMask(displayCanvas_t *canvas, int x, int y, const char *s, displayCanvasColor_e color, displayCanvasBitmapOption_t opts) { UNUSED(canvas); rendererDraw(6 + strlen(s), "drawStringMask", x, y, opts, color, 0, 0, s); }
+static void moveToPoint(displayCanvas_t *canvas, int x, int y) { UNUSED(canvas); rendererDraw(3, "moveToPoint", x, y); }
+static void strokeLineToPoint(displayCanvas_t *canvas, int x, int y) { UNUSED(canvas); rendererDraw(3, "strokeLineToPoint", x, y); }
+static void strokeTriangle(displayCanvas_t *canvas, int x1, int y1, int x2, int y2, int x3, int y3) { UNUSED(canvas); rendererDraw(9, "strokeTriangle", x1, y1, x2, y2, x3, y3); }
+static void fillTriangle(displayCanvas_t *canvas, int x1, int y1, int x2, int y2, int x3, int y3) { UNUSED(canvas); rendererDraw(9, "fillTriangle", x1, y1, x2, y2, x3, y3); }
+static void fillStrokeTriangle(displayCanvas_t *canvas, int x1, int y1, int x2, int y2, int x3, int y3) { UNUSED(canvas); rendererDraw(9, "fillStrokeTriangle", x1, y1, x2, y2, x3, y3); }
+static void strokeRect(displayCanvas_t *canvas, int x, int y, int w, int h) { UNUSED(canvas); rendererDraw(6, "strokeRect", x, y, w, h); }
+static void fillRect(displayCanvas_t *canvas, int x, int y, int w, int h) { UNUSED(canvas); rendererDraw(6, "fillRect", x, y, w, h); }
+static void fillStrokeRect(displayCanvas_t *canvas, int x, int y, int w, int h) { UNUSED(canvas); rendererDraw(6, "fillStrokeRect", x, y, w, h); }
+static void strokeEllipseInRect(displayCanvas_t *canvas, int x, int y, int w, int h) { UNUSED(canvas); rendererDraw(6, "strokeEllipseInRect", x, y, w, h); }
+static void fillEllipseInRect(displayCanvas_t *canvas, int x, int y, int w, int h) { UNUSED(canvas); rendererDraw(6, "fillEllipseInRect", x, y, w, h); }
+static void fillStrokeEllipseInRect(displayCanvas_t *canvas, int x, int y, int w, int h) { UNUSED(canvas); rendererDraw(6, "fillStrokeEllipseInRect", x, y, w, h); }
+static void ctmReset(displayCanvas_t *canvas) { UNUSED(canvas); rendererSend(0); renderer.state.transform += "reset;"; }
+static void ctmSet(displayCanvas_t *canvas, float m11, float m12, float m21, float m22, float m31, float m32)
+{
+    UNUSED(canvas);
+    rendererTransform(24, "set", m11 + m12 + m21, m22 + m31 + m32);
+}
+static void ctmTranslate(displayCanvas_t *canvas, float tx, float ty) { UNUSED(canvas); rendererTransform(8, "translate", tx, ty); }
+static void ctmScale(displayCanvas_t *canvas, float sx, float sy) { UNUSED(canvas); rendererTransform(8, "scale", sx, sy); }
+static void ctmRotate(displayCanvas_t *canvas, float r) { UNUSED(canvas); rendererTransform(4, "rotate", r); }
+static void contextPush(displayCanvas_t *canvas) { UNUSED(canvas); rendererSend(0); renderer.stack.push_back(renderer.state); }
+static void contextPop(displayCanvas_t *canvas)
+{
+    UNUSED(canvas);
+    rendererSend(0);
+    if (!renderer.stack.empty()) {
+        renderer.state = renderer.stack.back();
+        renderer.stack.pop_back();
+    }
+}
+
+}
+
+static const displayCanvasVTable_t rendererVTable = {
+    .setStrokeColor = setStrokeColor,
+    .setFillColor = setFillColor,
+    .setStrokeAndFillColor = setStrokeAndFillColor,
+    .setColorInversion = setColorInversion,
+    .setPixel = setPixel,
+    .setPixelToStrokeColor = setPixelToStrokeColor,
+    .setPixelToFillColor = setPixelToFillColor,
+    .setStrokeWidth = setStrokeWidth,
+    .setLineOutlineType = setLineOutlineType,
+    .setLineOutlineColor = setLineOutlineColor,
+    .clipToRect = clipToRect,
+    .clearRect = clearRect,
+    .resetDrawingState = resetDrawingState,
+    .drawCharacter = drawCharacter,
+    .drawCharacterMask = drawCharacterMask,
+    .drawString = drawString,
+    .drawStringMask = drawStringMask,
+    .moveToPoint = moveToPoint,
+    .strokeLineToPoint = strokeLineToPoint,
+    .strokeTriangle = strokeTriangle,
+    .fillTriangle = fillTriangle,
+    .fillStrokeTriangle = fillStrokeTriangle,
+    .strokeRect = strokeRect,
+    .fillRect = fillRect,
+    .fillStrokeRect = fillStrokeRect,
+    .strokeEllipseInRect = strokeEllipseInRect,
+    .fillEllipseInRect = fillEllipseInRect,
+    .fillStrokeEllipseInRect = fillStrokeEllipseInRect,
+    .ctmReset = ctmReset,
+    .ctmSet = ctmSet,
+    .ctmTranslate = ctmTranslate,
+    .ctmScale = ctmScale,
+    .ctmRotate = ctmRotate,
+    .contextPush = contextPush,
+    .contextPop = contextPop,
+    .getWidgets = NULL,
+    .beginGroup = NULL,
+    .endGroup = NULL,
+    .invalidateGroup = NULL,
+};
+
+typedef struct sceneInput_s {
+    int roll;
+    int heading;
+    int homeDirection;
+    int climbRate;
+} sceneInput_t;
+
+// Widgets drawn the way io/osd_canvas.c draws them, every frame
+static void drawScene(displayCanvas_t *canvas, const sceneInput_t *in)
+{
+    // Outside of any group, with the state changes the OSD code repeats
+    displayCanvasSetStrokeColor(canvas, DISPLAY_CANVAS_COLOR_WHITE);
+    displayCanvasSetStrokeColor(canvas, DISPLAY_CANVAS_COLOR_WHITE);
+    displayCanvasSetFillColor(canvas, DISPLAY_CANVAS_COLOR_BLACK);
+    displayCanvasFillStrokeRect(canvas, 10, 10, 20, 8);
+
+    // Horizon with a pitch ladder
+    displayCanvasBeginGroup(canvas, GROUP_HORIZON);
+    displayCanvasClearRect(canvas, 60, 40, 240, 180);
+    displayCanvasContextPush(canvas);
+    displayCanvasCtmTranslate(canvas, 180, 130);
+    displayCanvasCtmRotate(canvas, in->roll * 0.01f);
+    displayCanvasSetStrokeWidth(canvas, 2);
+    displayCanvasSetLineOutlineType(canvas, DISPLAY_CANVAS_OUTLINE_TYPE_BOTTOM);
+    displayCanvasSetLineOutlineColor(canvas, DISPLAY_CANVAS_COLOR_BLACK);
+    for (int ii = -4; ii <= 4; ii++) {
+        char label[8];
+        snprintf(label, sizeof(label), "%d", ii * 10);
+        displayCanvasSetStrokeColor(canvas, DISPLAY_CANVAS_COLOR_WHITE);
+        displayCanvasMoveToPoint(canvas, -40, ii * 20);
+        displayCanvasStrokeLineToPoint(canvas, -10, ii * 20);
+        displayCanvasMoveToPoint(canvas, 10, ii * 20);
+        displayCanvasStrokeLineToPoint(canvas, 40, ii * 20);
+        displayCanvasDrawString(canvas, 44, ii * 20 - 9, label, DISPLAY_CANVAS_BITMAP_OPT_ERASE_TRANSPARENT);
+    }
+    displayCanvasContextPop(canvas);
+    displayCanvasEndGroup(canvas);
+
+    // Home arrow, colors left behind like osdCanvasDrawDirArrow() does
+    displayCanvasBeginGroup(canvas, GROUP_ARROW);
+    displayCanvasClearRect(canvas, 297, 36, 18, 18);
+    displayCanvasSetFillColor(canvas, DISPLAY_CANVAS_COLOR_WHITE);
+    displayCanvasSetStrokeColor(canvas, DISPLAY_CANVAS_COLOR_BLACK);
+    displayCanvasContextPush(canvas);
+    displayCanvasCtmRotate(canvas, in->homeDirection * 0.017f);
+    displayCanvasCtmTranslate(canvas, 306, 45);
+    displayCanvasFillStrokeTriangle(canvas, 0, 6, 5, -6, -5, -6);
+    displayCanvasSetFillColor(canvas, DISPLAY_CANVAS_COLOR_TRANSPARENT);
+    displayCanvasFillTriangle(canvas, 0, -2, 6, -7, -5, -7);
+    displayCanvasContextPop(canvas);
+    displayCanvasEndGroup(canvas);
+
+    // Vario
+    displayCanvasBeginGroup(canvas, GROUP_VARIO);
+    displayCanvasClearRect(canvas, 12, 90, 12, 90);
+    for (int ii = 0; ii < in->climbRate; ii++) {
+        displayCanvasDrawCharacter(canvas, 12, 126 - ii * 18, 0x150, DISPLAY_CANVAS_BITMAP_OPT_ERASE_TRANSPARENT);
+    }
+    displayCanvasEndGroup(canvas);
+
+    // Uses the stroke color left behind by the arrow
+    displayCanvasStrokeRect(canvas, 200, 10, 30, 10);
+
+    // Heading graph, leaves its clip behind
+    displayCanvasBeginGroup(canvas, GROUP_HEADING);
+    displayCanvasClipToRect(canvas, 120, 18, 108, 18);
+    char graph[10];
+    for (unsigned ii = 0; ii < sizeof(graph) - 1; ii++) {
+        graph[ii] = 'A' + (in->heading / 45 + ii) % 8;
+    }
+    graph[sizeof(graph) - 1] = '\0';
+    displayCanvasDrawString(canvas, 120 - in->heading % 45 / 4, 18, graph, DISPLAY_CANVAS_BITMAP_OPT_ERASE_TRANSPARENT);
+    displayCanvasSetStrokeColor(canvas, DISPLAY_CANVAS_COLOR_BLACK);
+    displayCanvasSetFillColor(canvas, DISPLAY_CANVAS_COLOR_WHITE);
+    displayCanvasFillStrokeTriangle(canvas, 172, 17, 176, 17, 174, 19);
+    displayCanvasEndGroup(canvas);
+}
+
+class DisplayListTest : public ::testing::Test {
+protected:
+    displayCanvas_t direct;
+    displayCanvas_t listed;
+    displayList_t list;
+
+    void SetUp() override
+    {
+        memset(&direct, 0, sizeof(direct));
+        direct.vTable = &rendererVTable;
+        listed = direct;
+        displayListInit(&list, &listed);
+        rendererReset();
+        renderer.log.clear();
+    }
+
+    // One frame, started with the drawing state reset as the OSD transactions do. Returns the bytes sent.
+    unsigned frame(displayCanvas_t *canvas, const sceneInput_t *in)
+    {
+        rendererReset();
+        if (canvas->displayList) {
+            displayListResetDrawing(canvas->displayList);
+        }
+        renderer.log.clear();
+        const unsigned start = renderer.bytes;
+        drawScene(canvas, in);
+        return renderer.bytes - start;
+    }
+};
+
+TEST_F(DisplayListTest, DrawsLikeTheDisplay)
+{
+    const sceneInput_t in = { 15, 100, 30, 3 };
+
+    frame(&direct, &in);
+    const std::vector<std::string> expected = renderer.log;
+
+    frame(&listed, &in);
+
+    // Same primitives in the same state
+    ASSERT_EQ(expected.size(), renderer.log.size());
+    for (size_t ii = 0; ii < expected.size(); ii++) {
+        EXPECT_EQ(expected[ii], renderer.log[ii]);
+    }
+}
+
+TEST_F(DisplayListTest, RedundantStateChangesAreDropped)
+{
+    rendererReset();
+    renderer.stateCommands = 0;
+
+    for (int ii = 0; ii < 5; ii++) {
+        displayCanvasSetStrokeColor(&listed, DISPLAY_CANVAS_COLOR_BLACK);
+        displayCanvasSetFillColor(&listed, DISPLAY_CANVAS_COLOR_WHITE);
+        displayCanvasSetFillColor(&listed, DISPLAY_CANVAS_COLOR_BLACK);
+        displayCanvasMoveToPoint(&listed, 0, ii);
+        displayCanvasStrokeLineToPoint(&listed, 10, ii);
+        displayCanvasFillRect(&listed, 0, ii, 4, 4);
+    }
+
+    // One stroke and fill color for all of them
+    EXPECT_EQ(1u, renderer.stateCommands);
+    EXPECT_EQ(DISPLAY_CANVAS_COLOR_BLACK, renderer.state.strokeColor);
+    EXPECT_EQ(DISPLAY_CANVAS_COLOR_BLACK, renderer.state.fillColor);
+    EXPECT_EQ(15u, displayListGetStats(&list)->stateChanges);
+    EXPECT_EQ(1u, displayListGetStats(&list)->stateChangesSent);
+}
+
+TEST_F(DisplayListTest, UnchangedGroupsAreNotSent)
+{
+    const sceneInput_t in = { 15, 100, 30, 3 };
+
+    const unsigned first = frame(&listed, &in);
+    const unsigned second = frame(&listed, &in);
+
+    // Only the primitives outside of the groups, with the state they need
+    EXPECT_EQ(4u, displayListGetStats(&list)->groupsSent);
+    EXPECT_EQ(4u, displayListGetStats(&list)->groupsSkipped);
+    EXPECT_LT(second * 10, first);
+    ASSERT_EQ(2u, renderer.log.size());
+    EXPECT_EQ(0u, renderer.log[0].find("fillStrokeRect"));
+    EXPECT_EQ(0u, renderer.log[1].find("strokeRect(200"));
+
+    // Stroke color of the arrow still in effect, even though the arrow wasn't sent
+    EXPECT_NE(std::string::npos, renderer.log[1].find("stroke=0 "));
+}
+
+TEST_F(DisplayListTest, ChangedGroupIsSent)
+{
+    sceneInput_t in = { 15, 100, 30, 3 };
+
+    frame(&listed, &in);
+    frame(&listed, &in);
+
+    in.heading = 110;
+    frame(&listed, &in);
+    const std::vector<std::string> sent = renderer.log;
+
+    // Only the heading graph with the rest of the frame, drawn as it's drawn without the list
+    frame(&direct, &in);
+    std::vector<std::string> expected;
+    for (const auto &entry : renderer.log) {
+        if (entry.find("clip(120") != std::string::npos || entry.find("fillStrokeRect") == 0 || entry.find("strokeRect(200") == 0) {
+            expected.push_back(entry);
+        }
+    }
+    EXPECT_EQ(expected, sent);
+}
+
+TEST_F(DisplayListTest, GroupsAreResent)
+{
+    const sceneInput_t in = { 15, 100, 30, 3 };
+
+    frame(&listed, &in);
+    for (int ii = 0; ii < DISPLAY_LIST_MAX_SKIPS; ii++) {
+        frame(&listed, &in);
+        EXPECT_EQ(2u, renderer.log.size());
+    }
+
+    // Every group again after the maximum number of skips, in case it was drawn over
+    frame(&listed, &in);
+    EXPECT_EQ(8u, displayListGetStats(&list)->groupsSent);
+
+    // And after the screen was cleared
+    frame(&listed, &in);
+    EXPECT_EQ(2u, renderer.log.size());
+    displayListInvalidate(&list);
+    frame(&listed, &in);
+    EXPECT_EQ(12u, displayListGetStats(&list)->groupsSent);
+
+    // Or the OSD asked for it
+    displayCanvasInvalidateGroup(&listed, GROUP_VARIO);
+    frame(&listed, &in);
+    EXPECT_EQ(13u, displayListGetStats(&list)->groupsSent);
+}
+
+TEST_F(DisplayListTest, GroupLargerThanTheRecording)
+{
+    std::vector<std::string> drawn[2][2];
+
+    for (int pass = 0; pass < 2; pass++) {
+        displayCanvas_t *canvas = pass ? &listed : &direct;
+        for (int frameIndex = 0; frameIndex < 2; frameIndex++) {
+            rendererReset();
+            displayListResetDrawing(&list);
+            renderer.log.clear();
+            displayCanvasBeginGroup(canvas, GROUP_VARIO);
+            for (int ii = 0; ii < 100; ii++) {
+                displayCanvasSetStrokeColor(canvas, ii & 1 ? DISPLAY_CANVAS_COLOR_WHITE : DISPLAY_CANVAS_COLOR_BLACK);
+                displayCanvasFillStrokeRect(canvas, ii, ii, 4, 4);
+            }
+            displayCanvasEndGroup(canvas);
+            drawn[pass][frameIndex] = renderer.log;
+        }
+    }
+
+    // Sent in full every time, even though it didn't change
+    EXPECT_EQ(100u, drawn[0][0].size());
+    EXPECT_EQ(drawn[0][0], drawn[1][0]);
+    EXPECT_EQ(drawn[0][1], drawn[1][1]);
+}
+
+TEST_F(DisplayListTest, BytesPerFrame)
+{
+    struct {
+        const char *name;
+        bool horizon;
+        bool heading;
+        bool arrow;
+        bool vario;
+        bool saves;
+    } scenarios[] = {
+        { "on the ground", false, false, false, false, true },
+        { "level cruise", false, true, false, false, true },
+        { "turning", true, true, true, false, false },
+        { "everything moving", true, true, true, true, false },
+    };
+
+    for (const auto &scenario : scenarios) {
+        SCOPED_TRACE(scenario.name);
+        unsigned bytes[2] = { 0, 0 };
+        const int frames = 200;
+
+        for (int pass = 0; pass < 2; pass++) {
+            displayCanvas_t *canvas = pass ? &listed : &direct;
+            if (pass) {
+                listed = direct;
+                displayListInit(&list, &listed);
+            }
+            for (int ii = 0; ii < frames; ii++) {
+                const sceneInput_t in = {
+                    scenario.horizon ? ii : 0,
+                    scenario.heading ? ii * 7 : 0,
+                    scenario.arrow ? ii * 3 : 0,
+                    scenario.vario ? ii % 5 : 2,
+                };
+                bytes[pass] += frame(canvas, &in);
+            }
+        }
+
+        // Nothing gained when everything changes, a push and pop around each group and setting the state again after it is all it costs
+        EXPECT_LE(bytes[1], bytes[0] + frames * 16);
+        if (scenario.saves) {
+            EXPECT_LT(bytes[1], bytes[0] / 3);
+        }
+    }
+}
@@ -0,0 +1,312 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/utils.h"
+
+    #include "drivers/dshot_bidir.h"
+
+    #include "flight/mixer.h"
+    #include "flight/rpm_filter.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define BIT_TICKS 16    // DShot timer ticks per telemetry bit
+
+static const uint8_t gcrEncodeTable[16] = {
+    0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17, 0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F
+};
+
+// What the ESC sends for a period in us
+static uint16_t periodToFrame(uint32_t periodUs)
+{
+    uint16_t exponent = 0;
+    while ((periodUs >> exponent) > 0x1FF) {
+        exponent++;
+    }
+
+    const uint16_t data = (exponent << 9) | (periodUs >> exponent);
+    const uint16_t csum = ~(data ^ (data >> 4) ^ (data >> 8)) & 0xF;
+
+    return (data << 4) | csum;
+}
+
+static uint32_t frameToGcr(uint16_t frame)
+{
+    uint32_t gcr = 0;
+    for (int shift = 12; shift >= 0; shift -= 4) {
+        gcr = (gcr << 5) | gcrEncodeTable[(frame >> shift) & 0xF];
+    }
+    return gcr;
+}
+
+// Timer counter at every transition of the line, the start bit included
+static unsigned frameToEdges(uint16_t frame, uint32_t startTicks, uint32_t *edges)
+{
+    const uint32_t bits = (1 << 20) | frameToGcr(frame);
+    unsigned count = 0;
+    bool low = false;
+
+    for (int bit = 20; bit >= 0; bit--) {
+        if (bits & (1 << bit)) {
+            edges[count++] = (startTicks + (20 - bit) * BIT_TICKS) & 0xFFFF;
+            low = !low;
+        }
+    }
+
+    // ESC lets go of the line after the last bit
+    if (low) {
+        edges[count++] = (startTicks + 21 * BIT_TICKS) & 0xFFFF;
+    }
+
+    return count;
+}
+
+TEST(DshotBidirTest, GcrDecode)
+{
+    for (uint32_t nibble = 0; nibble < 16; nibble++) {
+        const uint16_t frame = (nibble << 12) | (nibble << 8) | (nibble << 4) | nibble;
+        uint16_t decoded;
+        // Checksum of four equal nibbles is 0, it's only valid for frames xoring to 0xF
+        EXPECT_FALSE(dshotBidirGcrToFrame(frameToGcr(frame), &decoded));
+
+        const uint16_t valid = (nibble << 12) | 0xF0 | nibble;
+        ASSERT_TRUE(dshotBidirGcrToFrame(frameToGcr(valid), &decoded));
+        EXPECT_EQ(valid, decoded);
+    }
+
+    // 0x00 isn't a GCR code
+    uint16_t decoded;
+    EXPECT_FALSE(dshotBidirGcrToFrame(frameToGcr(0x577A) & ~0x1F, &decoded));
+}
+
+TEST(DshotBidirTest, FrameToErpm)
+{
+    EXPECT_EQ(0x577A, periodToFrame(1500));
+    EXPECT_EQ(40000u, dshotBidirFrameToErpm(0x577A));
+
+    // Stopped motor
+    EXPECT_EQ(0u, dshotBidirFrameToErpm(0xFFF0));
+
+    // Full range of exponents, the mantissa loses the low bits of long periods
+    for (uint32_t periodUs = 20; periodUs < 65000; periodUs = periodUs * 5 / 4) {
+        const uint16_t frame = periodToFrame(periodUs);
+        const uint32_t expectedPeriodUs = ((frame >> 4) & 0x1FF) << (frame >> 13);
+        EXPECT_LE(periodUs - expectedPeriodUs, periodUs / 256);
+        EXPECT_EQ((60000000 + expectedPeriodUs / 2) / expectedPeriodUs, dshotBidirFrameToErpm(frame));
+    }
+}
+
+TEST(DshotBidirTest, EdgesRoundTrip)
+{
+    uint32_t edges[DSHOT_BIDIR_EDGE_BUFFER_SIZE];
+
+    for (uint32_t periodUs = 40; periodUs < 60000; periodUs += 37) {
+        const uint16_t frame = periodToFrame(periodUs);
+        const unsigned count = frameToEdges(frame, periodUs * 7, edges);
+        ASSERT_LE(count, (unsigned)DSHOT_BIDIR_EDGE_BUFFER_SIZE);
+
+        uint32_t gcr;
+        ASSERT_TRUE(dshotBidirEdgesToGcr(edges, count, BIT_TICKS, &gcr));
+        EXPECT_EQ(frameToGcr(frame), gcr);
+
+        uint32_t erpm;
+        ASSERT_TRUE(dshotBidirDecodeEdges(edges, count, BIT_TICKS, &erpm));
+        EXPECT_EQ(dshotBidirFrameToErpm(frame), erpm);
+    }
+}
+
+TEST(DshotBidirTest, CapturedEdges)
+{
+    // DShot600 timer capture of a 1500us period answer, with a few ticks of jitter and the counter wrapping
+    const uint32_t edges[] = {
+        0xFF7F, 0xFF8E, 0xFFB0, 0xFFD2, 0xFFDD, 0xFFFD, 0x0013, 0x0021, 0x002D, 0x004F, 0x0061, 0x006D, 0x0091, 0x00AE
+    };
+
+    uint32_t erpm = 0;
+    ASSERT_TRUE(dshotBidirDecodeEdges(edges, ARRAYLEN(edges), BIT_TICKS, &erpm));
+    EXPECT_EQ(40000u, erpm);
+
+    // Whatever the line does after the last bit doesn't matter
+    uint32_t trailing[ARRAYLEN(edges) + 1];
+    memcpy(trailing, edges, sizeof(edges));
+    trailing[ARRAYLEN(edges)] = edges[ARRAYLEN(edges) - 1] + 3 * BIT_TICKS;
+    ASSERT_TRUE(dshotBidirDecodeEdges(trailing, ARRAYLEN(trailing), BIT_TICKS, &erpm));
+    EXPECT_EQ(40000u, erpm);
+
+    // A lost edge shifts everything after it
+    uint32_t broken[ARRAYLEN(edges) - 1];
+    for (unsigned i = 0, j = 0; i < ARRAYLEN(edges); i++) {
+        if (i != 5) {
+            broken[j++] = edges[i];
+        }
+    }
+    EXPECT_FALSE(dshotBidirDecodeEdges(broken, ARRAYLEN(broken), BIT_TICKS, &erpm));
+
+    // Nothing came back
+    EXPECT_FALSE(dshotBidirDecodeEdges(edges, 0, BIT_TICKS, &erpm));
+    EXPECT_FALSE(dshotBidirDecodeEdges(edges, 1, BIT_TICKS, &erpm));
+}
+
+TEST(DshotBidirTest, ChecksumError)
+{
+    uint32_t edges[DSHOT_BIDIR_EDGE_BUFFER_SIZE];
+
+    // Valid GCR, not inverted checksum
+    const unsigned count = frameToEdges(0x5775, 0, edges);
+
+    uint32_t erpm;
+    EXPECT_FALSE(dshotBidirDecodeEdges(edges, count, BIT_TICKS, &erpm));
+}
+
+TEST(DshotBidirTest, MotorStats)
+{
+    uint32_t edges[DSHOT_BIDIR_EDGE_BUFFER_SIZE];
+    const unsigned count = frameToEdges(periodToFrame(1500), 100, edges);
+
+    dshotBidirInit(2);
+    EXPECT_TRUE(dshotBidirIsEnabled());
+
+    for (int i = 0; i < 100; i++) {
+        dshotBidirUpdateMotor(0, edges, count, BIT_TICKS);
+        // Second motor loses every tenth answer
+        dshotBidirUpdateMotor(1, edges, (i % 10 == 0) ? 0 : count, BIT_TICKS);
+    }
+
+    // Last good value is kept after an error
+    dshotBidirUpdateMotor(1, edges, 3, BIT_TICKS);
+    EXPECT_EQ(40000u, dshotBidirGetMotorErpm(0));
+    EXPECT_EQ(40000u, dshotBidirGetMotorErpm(1));
+    // Not a configured motor
+    dshotBidirUpdateMotor(2, edges, count, BIT_TICKS);
+    EXPECT_EQ(0u, dshotBidirGetMotorErpm(2));
+
+    dshotBidirStats_t stats;
+    dshotBidirGetMotorStats(0, &stats);
+    EXPECT_EQ(100u, stats.frameCount);
+    EXPECT_EQ(0u, stats.errorCount);
+    dshotBidirGetMotorStats(1, &stats);
+    EXPECT_EQ(101u, stats.frameCount);
+    EXPECT_EQ(11u, stats.errorCount);
+
+    dshotBidirGetStats(&stats);
+    EXPECT_EQ(201u, stats.frameCount);
+    EXPECT_EQ(11u, stats.errorCount);
+
+    dshotBidirInit(0);
+    EXPECT_FALSE(dshotBidirIsEnabled());
+}
+
+static uint8_t testMotorCount;
+static uint32_t testLooptime = 1000;
+
+static float sineAmplitudeAfterRpmFilter(float frequencyHz)
+{
+    float amplitude = 0;
+
+    for (int i = 0; i < 2000; i++) {
+        const float output = rpmFilterGyroApply(FD_ROLL, sinf(2 * M_PIf * frequencyHz * i * testLooptime * 1e-6f));
+        // Let the notches settle first
+        if (i >= 1000) {
+            amplitude = MAX(amplitude, fabsf(output));
+        }
+    }
+
+    return amplitude;
+}
+
+TEST(DshotBidirTest, RpmFilterFollowsErpm)
+{
+    uint32_t edges[DSHOT_BIDIR_EDGE_BUFFER_SIZE];
+
+    testMotorCount = 4;
+    motorConfigMutable()->motorPoleCount = 14;
+    rpmFilterConfigMutable()->gyro_filter_enabled = 1;
+    rpmFilterConfigMutable()->gyro_harmonics = 1;
+    rpmFilterConfigMutable()->gyro_min_hz = 50;
+    rpmFilterConfigMutable()->gyro_q = 500;
+
+    dshotBidirInit(testMotorCount);
+    rpmFiltersInit();
+    ASSERT_EQ(RPM_FILTER_SOURCE_DSHOT, rpmFilterGetSource());
+
+    // All motors at 40000 eRPM, 14 poles make that 5714 RPM or 95.2Hz
+    const unsigned count = frameToEdges(periodToFrame(1500), 0, edges);
+    const float motorHz = 40000 / 7.0f / 60;
+
+    // One answer per motor update, one motor update per PID loop
+    for (int loop = 0; loop < 100; loop++) {
+        for (int motor = 0; motor < testMotorCount; motor++) {
+            dshotBidirUpdateMotor(motor, edges, count, BIT_TICKS);
+        }
+        rpmFilterLoopUpdate();
+    }
+
+    for (int motor = 0; motor < testMotorCount; motor++) {
+        EXPECT_NEAR(motorHz, rpmFilterGetMotorFrequency(motor), 0.01f);
+    }
+
+    // The ESC sensor task has nothing to do
+    rpmFilterUpdateTask(0);
+    EXPECT_NEAR(motorHz, rpmFilterGetMotorFrequency(0), 0.01f);
+
+    // Motor noise is notched out, what the pilot commands goes through
+    EXPECT_LT(sineAmplitudeAfterRpmFilter(motorHz), 0.05f);
+    EXPECT_GT(sineAmplitudeAfterRpmFilter(20), 0.9f);
+}
+
+TEST(DshotBidirTest, RpmFilterWithoutSource)
+{
+    testMotorCount = 4;
+    rpmFilterConfigMutable()->gyro_filter_enabled = 1;
+
+    dshotBidirInit(0);
+    disableRpmFilters();
+    rpmFiltersInit();
+
+    EXPECT_EQ(RPM_FILTER_SOURCE_NONE, rpmFilterGetSource());
+    EXPECT_EQ(0.5f, rpmFilterGyroApply(FD_ROLL, 0.5f));
+}
+
+// STUBS
+
+extern "C" {
+
+motorConfig_t motorConfig_System;
+
+uint8_t getMotorCount(void)
+{
+    return testMotorCount;
+}
+
+uint32_t getLooptime(void)
+{
+    return testLooptime;
+}
+
+}
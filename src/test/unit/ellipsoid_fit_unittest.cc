@@ -0,0 +1,281 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/ellipsoid_fit.h"
+    #include "common/maths.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_FIELD              450.0f      // LSB, about 0.45 Gauss on a 1 LSB/mGauss sensor
+#define TEST_NOISE              2.0f        // LSB
+#define TEST_COMPASS_HZ         10
+#define TEST_MAX_SAMPLES        (120 * TEST_COMPASS_HZ)
+
+static uint32_t testSeed;
+
+static float testGaussian(void)
+{
+    float u[2];
+    for (int i = 0; i < 2; i++) {
+        testSeed = testSeed * 1103515245 + 12345;
+        u[i] = ((testSeed >> 8) + 1.0f) / 16777217.0f;
+    }
+    return sqrtf(-2 * logf(u[0])) * cosf(2 * M_PIf * u[1]);
+}
+
+static void normalize(fpVector3_t *v)
+{
+    const float length = sqrtf(sq(v->x) + sq(v->y) + sq(v->z));
+    for (int i = 0; i < 3; i++) {
+        v->v[i] /= length;
+    }
+}
+
+typedef struct {
+    fpVector3_t offset;
+    float softIron[3][3];       // Symmetric, field to sensor
+} distortion_t;
+
+// Hard iron larger than the field and soft iron with cross-axis terms
+static const distortion_t testDistortion = {
+    .offset = { .v = { 210, -340, 120 } },
+    .softIron = {
+        { 1.10f, 0.08f, -0.05f },
+        { 0.08f, 0.90f, 0.03f },
+        { -0.05f, 0.03f, 1.20f },
+    },
+};
+
+static fpVector3_t distort(const distortion_t *distortion, const fpVector3_t *dir)
+{
+    fpVector3_t raw;
+    for (int i = 0; i < 3; i++) {
+        raw.v[i] = distortion->offset.v[i] + TEST_NOISE * testGaussian();
+        for (int j = 0; j < 3; j++) {
+            raw.v[i] += distortion->softIron[i][j] * dir->v[j] * TEST_FIELD;
+        }
+    }
+    return raw;
+}
+
+// Body frame field direction of a craft turned around by hand, ~20deg per compass sample
+static void tumble(fpVector3_t *dir)
+{
+    for (int i = 0; i < 3; i++) {
+        dir->v[i] += 0.25f * testGaussian();
+    }
+    normalize(dir);
+}
+
+// Level flight turning around: the field stays on a cone around the vertical, 64deg inclination
+static void cruise(fpVector3_t *dir, int sample)
+{
+    const float heading = sample * 0.05f;
+    const float tilt = 0.2f * sinf(sample * 0.3f);
+    dir->x = 0.44f * cosf(heading) + tilt * 0.9f;
+    dir->y = 0.44f * sinf(heading);
+    dir->z = 0.9f - tilt * 0.44f;
+    normalize(dir);
+}
+
+typedef struct {
+    float maxAngleError;        // deg
+    float maxMagnitudeError;    // Fraction of the field
+} fitError_t;
+
+// Corrects samples all around the sphere with the fitted calibration, without noise
+static fitError_t fitError(const distortion_t *distortion, const fpVector3_t *offset, const fpMat3_t *softIron)
+{
+    fitError_t error = { 0, 0 };
+
+    for (int i = 0; i < 1000; i++) {
+        fpVector3_t dir = { .v = { testGaussian(), testGaussian(), testGaussian() } };
+        normalize(&dir);
+
+        fpVector3_t raw;
+        for (int j = 0; j < 3; j++) {
+            raw.v[j] = distortion->offset.v[j];
+            for (int k = 0; k < 3; k++) {
+                raw.v[j] += distortion->softIron[j][k] * dir.v[k] * TEST_FIELD;
+            }
+        }
+
+        fpVector3_t corrected;
+        for (int j = 0; j < 3; j++) {
+            corrected.v[j] = 0;
+            for (int k = 0; k < 3; k++) {
+                corrected.v[j] += softIron->m[j][k] * (raw.v[k] - offset->v[k]);
+            }
+        }
+
+        const float length = sqrtf(sq(corrected.x) + sq(corrected.y) + sq(corrected.z));
+        const float cosAngle = (corrected.x * dir.x + corrected.y * dir.y + corrected.z * dir.z) / length;
+
+        error.maxAngleError = MAX(error.maxAngleError, RADIANS_TO_DEGREES(acosf(MIN(cosAngle, 1.0f))));
+        error.maxMagnitudeError = MAX(error.maxMagnitudeError, fabsf(length - 1));
+    }
+
+    return error;
+}
+
+// Samples at the compass rate until the fit converges, returns the number of samples or 0
+static int runUntilConverged(ellipsoidFit_t *fit, const distortion_t *distortion, bool tumbling)
+{
+    fpVector3_t dir = { .v = { 1, 0, 0 } };
+
+    for (int sample = 1; sample <= TEST_MAX_SAMPLES; sample++) {
+        if (tumbling) {
+            tumble(&dir);
+        } else {
+            cruise(&dir, sample);
+        }
+
+        const fpVector3_t raw = distort(distortion, &dir);
+        ellipsoidFitPushSample(fit, &raw);
+
+        if (ellipsoidFitIsConverged(fit)) {
+            return sample;
+        }
+    }
+
+    return 0;
+}
+
+TEST(EllipsoidFitTest, ConvergesWhileTumbling)
+{
+    testSeed = 1;
+
+    ellipsoidFit_t fit;
+    const fpVector3_t reference = { .v = { 0, 0, 0 } };
+    ellipsoidFitInit(&fit, &reference);
+
+    const int samples = runUntilConverged(&fit, &testDistortion, true);
+
+    fpVector3_t offset;
+    fpMat3_t softIron;
+    ASSERT_TRUE(ellipsoidFitGetResult(&fit, &offset, &softIron));
+
+    const fitError_t error = fitError(&testDistortion, &offset, &softIron);
+
+    EXPECT_GT(samples, 0);
+    EXPECT_LT(samples, 30 * TEST_COMPASS_HZ);   // Default mag_calibration_time
+
+    for (int i = 0; i < 3; i++) {
+        EXPECT_NEAR(offset.v[i], testDistortion.offset.v[i], 5.0f);
+    }
+    EXPECT_LT(error.maxAngleError, 1.0f);
+    EXPECT_LT(error.maxMagnitudeError, 0.02f);
+}
+
+// Hard iron as large as the field puts the origin on the ellipsoid, where x'Ax + b'x = 1 fits fail
+TEST(EllipsoidFitTest, OriginOnEllipsoid)
+{
+    testSeed = 2;
+
+    distortion_t distortion = testDistortion;
+    distortion.offset.x = 0;
+    distortion.offset.y = 0;
+    distortion.offset.z = 1.2f * TEST_FIELD;
+
+    ellipsoidFit_t fit;
+    const fpVector3_t reference = { .v = { 0, 0, 0 } };
+    ellipsoidFitInit(&fit, &reference);
+
+    EXPECT_GT(runUntilConverged(&fit, &distortion, true), 0);
+
+    fpVector3_t offset;
+    fpMat3_t softIron;
+    ASSERT_TRUE(ellipsoidFitGetResult(&fit, &offset, &softIron));
+
+    const fitError_t error = fitError(&distortion, &offset, &softIron);
+    EXPECT_LT(error.maxAngleError, 1.0f);
+    EXPECT_LT(error.maxMagnitudeError, 0.02f);
+}
+
+// Restarted in flight from the calibration found before, as the compass does after applying one
+TEST(EllipsoidFitTest, StartsFromReference)
+{
+    testSeed = 3;
+
+    ellipsoidFit_t fit;
+    const fpVector3_t reference = { .v = { 200, -330, 110 } };
+    ellipsoidFitInit(&fit, &reference);
+
+    EXPECT_GT(runUntilConverged(&fit, &testDistortion, true), 0);
+
+    fpVector3_t offset;
+    fpMat3_t softIron;
+    ASSERT_TRUE(ellipsoidFitGetResult(&fit, &offset, &softIron));
+
+    const fitError_t error = fitError(&testDistortion, &offset, &softIron);
+    EXPECT_LT(error.maxAngleError, 1.0f);
+}
+
+// Turning in level flight only shows a cone of the ellipsoid: not enough to fit it
+TEST(EllipsoidFitTest, LevelFlightDoesNotConverge)
+{
+    testSeed = 4;
+
+    ellipsoidFit_t fit;
+    const fpVector3_t reference = { .v = { 0, 0, 0 } };
+    ellipsoidFitInit(&fit, &reference);
+
+    EXPECT_EQ(runUntilConverged(&fit, &testDistortion, false), 0);
+    EXPECT_LT(fit.binsCovered, ELLIPSOID_FIT_MIN_BINS);
+
+    fpVector3_t offset;
+    fpMat3_t softIron;
+    EXPECT_FALSE(ellipsoidFitGetResult(&fit, &offset, &softIron));
+}
+
+// Samples in the same direction are skipped and a bin stops taking samples when it's full
+TEST(EllipsoidFitTest, CoverageBinning)
+{
+    testSeed = 5;
+
+    ellipsoidFit_t fit;
+    const fpVector3_t reference = { .v = { 0, 0, 0 } };
+    ellipsoidFitInit(&fit, &reference);
+
+    fpVector3_t dir = { .v = { 1, 0, 0 } };
+    fpVector3_t raw = distort(&testDistortion, &dir);
+    EXPECT_TRUE(ellipsoidFitPushSample(&fit, &raw));
+    EXPECT_FALSE(ellipsoidFitPushSample(&fit, &raw));
+
+    for (int i = 0; i < 10000; i++) {
+        tumble(&dir);
+        raw = distort(&testDistortion, &dir);
+        ellipsoidFitPushSample(&fit, &raw);
+    }
+
+    EXPECT_EQ(fit.binsCovered, ELLIPSOID_FIT_BINS);
+    EXPECT_EQ(fit.sampleCount, ELLIPSOID_FIT_BINS * ELLIPSOID_FIT_BIN_SAMPLES);
+    for (int i = 0; i < ELLIPSOID_FIT_BINS; i++) {
+        EXPECT_EQ(fit.binSamples[i], ELLIPSOID_FIT_BIN_SAMPLES);
+    }
+    EXPECT_TRUE(ellipsoidFitIsConverged(&fit));
+}
@@ -18,6 +18,7 @@
 #include <stdint.h>
 
 #include <limits.h>
+#include <math.h>
 
 extern "C" {
     #include "sensors/gyro.h"
@@ -30,6 +31,7 @@ extern "C" {
     #include "io/gps.h"
     #include "flight/pid.h"
     #include "flight/imu.h"
+    #include "sensors/sensors.h"
 }
 
 #include "unittest_macros.h"
@@ -85,6 +87,125 @@ TEST(FlightImuTest, TestEulerAngleCalculation)
     EXPECT_NEAR(attitude.values.yaw, 2700, 1);
 }
 
+static uint32_t enabledSensors;
+
+/*
+ * Replay of a synthetic flight: vigorous coning motion with a steady yaw rate. The reference attitude is integrated
+ * in double precision at 100kHz, the IMU sees gyro and gravity sampled from it at 1kHz. Returns the largest attitude
+ * error [deg] seen at AHRS updates during the replay.
+ */
+typedef struct {
+    double q0, q1, q2, q3;
+} refQuaternion_t;
+
+static void refQuaternionMultiply(refQuaternion_t *r, const refQuaternion_t *a, const refQuaternion_t *b)
+{
+    const refQuaternion_t p = {
+        a->q0 * b->q0 - a->q1 * b->q1 - a->q2 * b->q2 - a->q3 * b->q3,
+        a->q0 * b->q1 + a->q1 * b->q0 + a->q2 * b->q3 - a->q3 * b->q2,
+        a->q0 * b->q2 - a->q1 * b->q3 + a->q2 * b->q0 + a->q3 * b->q1,
+        a->q0 * b->q3 + a->q1 * b->q2 - a->q2 * b->q1 + a->q3 * b->q0,
+    };
+    *r = p;
+}
+
+static void replayBodyRate(double t, double rate[3])
+{
+    const double coningRate = 2 * M_PI * 3.0;
+    const double coningAmplitude = 200.0 * M_PI / 180.0;
+
+    rate[0] = coningAmplitude * sin(coningRate * t);
+    rate[1] = coningAmplitude * cos(coningRate * t);
+    rate[2] = 30.0 * M_PI / 180.0;
+}
+
+static float replayImu(uint16_t ahrsUpdateHz, uint16_t kpAcc)
+{
+    const timeUs_t loopUs = 1000;
+    const int refStepsPerLoop = 10;
+    const timeUs_t startUs = 1000000;
+
+    imuConfigMutable()->dcm_kp_acc = kpAcc;
+    imuConfigMutable()->dcm_ki_acc = 0;
+    imuConfigMutable()->dcm_kp_mag = 0;
+    imuConfigMutable()->dcm_ki_mag = 0;
+    imuConfigMutable()->small_angle = 25;
+    imuConfigMutable()->acc_ignore_rate = 0;
+    imuConfigMutable()->ahrs_update_hz = ahrsUpdateHz;
+    imuConfigure();
+    imuInit();
+
+    // Sets the time base without an update, then make the accelerometer available
+    imuUpdateAttitude(startUs);
+    imuUpdateAccelerometer();
+
+    refQuaternion_t ref = { 1, 0, 0, 0 };
+    float maxErrorDeg = 0;
+
+    for (int loop = 1; loop <= 10000; loop++) {
+        for (int step = 0; step < refStepsPerLoop; step++) {
+            const double h = loopUs * 1e-6 / refStepsPerLoop;
+            double rate[3];
+            replayBodyRate(((loop - 1) * refStepsPerLoop + step + 0.5) * h, rate);
+
+            const double angle = sqrt(rate[0] * rate[0] + rate[1] * rate[1] + rate[2] * rate[2]) * h;
+            const double s = sin(angle / 2) / (angle / h);
+            const refQuaternion_t dq = { cos(angle / 2), rate[0] * s, rate[1] * s, rate[2] * s };
+            refQuaternionMultiply(&ref, &ref, &dq);
+        }
+
+        double rate[3];
+        replayBodyRate(loop * loopUs * 1e-6, rate);
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyro.gyroADCf[axis] = rate[axis] * 180.0 / M_PI;
+        }
+
+        // Gravity (EF up) rotated into body frame: conj(ref) * g * ref
+        acc.accADCf[X] = 2 * (ref.q1 * ref.q3 - ref.q0 * ref.q2);
+        acc.accADCf[Y] = 2 * (ref.q2 * ref.q3 + ref.q0 * ref.q1);
+        acc.accADCf[Z] = ref.q0 * ref.q0 - ref.q1 * ref.q1 - ref.q2 * ref.q2 + ref.q3 * ref.q3;
+
+        imuUpdateAttitude(startUs + loop * loopUs);
+
+        // Between decimated updates the attitude is held, compare only where it has been updated
+        if (ahrsUpdateHz && loop % (1000 / ahrsUpdateHz)) {
+            continue;
+        }
+
+        const double dot = fabs(ref.q0 * orientation.q0 + ref.q1 * orientation.q1 + ref.q2 * orientation.q2 + ref.q3 * orientation.q3);
+        const float errorDeg = 2 * acos(fmin(dot, 1.0)) * 180.0 / M_PI;
+        maxErrorDeg = fmaxf(maxErrorDeg, errorDeg);
+    }
+
+    return maxErrorDeg;
+}
+
+TEST(FlightImuTest, TestDecimatedAttitudeReplay)
+{
+    enabledSensors = SENSOR_ACC;
+
+    // Gyro integration only, any error is due to how the rotation is integrated
+    const float legacyGyroErrorDeg = replayImu(0, 0);
+    const float decimatedGyroErrorDeg = replayImu(100, 0);
+
+    // Full AHRS with accelerometer corrections
+    const float legacyErrorDeg = replayImu(0, 2000);
+    const float decimatedErrorDeg = replayImu(100, 2000);
+
+    EXPECT_LT(decimatedGyroErrorDeg, legacyGyroErrorDeg + 0.5f);
+    EXPECT_LT(decimatedErrorDeg, legacyErrorDeg + 0.5f);
+    EXPECT_LT(decimatedErrorDeg, 2.0f);
+
+    // Euler angles are only refreshed by the AHRS update, they must match the final orientation
+    const attitudeEulerAngles_t replayAttitude = attitude;
+    imuUpdateEulerAngles();
+    EXPECT_EQ(replayAttitude.values.roll, attitude.values.roll);
+    EXPECT_EQ(replayAttitude.values.pitch, attitude.values.pitch);
+    EXPECT_EQ(replayAttitude.values.yaw, attitude.values.yaw);
+
+    enabledSensors = 0;
+}
+
 // STUBS
 
 extern "C" {
@@ -106,8 +227,7 @@ uint8_t detectedSensors[] = { GYRO_NONE, ACC_NONE };
 
 bool sensors(uint32_t mask)
 {
-    UNUSED(mask);
-    return false;
+    return enabledSensors & mask;
 };
 uint32_t millis(void) { return 0; }
 timeDelta_t getLooptime(void) { return gyro.targetLooptime; }
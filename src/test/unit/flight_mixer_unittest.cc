@@ -0,0 +1,206 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+
+    #include "flight/mixer.h"
+    #include "flight/mixer_kernels.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+typedef struct mixerPreset_s {
+    mixerKernel_e kernel;
+    std::vector<motorMixer_t> mixer;
+} mixerPreset_t;
+
+// As the Configurator has them
+static const mixerPreset_t presets[] = {
+    { MIXER_KERNEL_QUAD_X, {
+        { 1.0f, -1.0f,  1.0f, -1.0f },
+        { 1.0f, -1.0f, -1.0f,  1.0f },
+        { 1.0f,  1.0f,  1.0f,  1.0f },
+        { 1.0f,  1.0f, -1.0f, -1.0f },
+    }},
+    { MIXER_KERNEL_HEX_X, {
+        { 1.0f, -0.5f,  0.866025f,  1.0f },
+        { 1.0f, -0.5f, -0.866025f,  1.0f },
+        { 1.0f,  0.5f,  0.866025f, -1.0f },
+        { 1.0f,  0.5f, -0.866025f, -1.0f },
+        { 1.0f, -1.0f,  0.0f,      -1.0f },
+        { 1.0f,  1.0f,  0.0f,       1.0f },
+    }},
+    { MIXER_KERNEL_OCTO_X8, {
+        { 1.0f, -1.0f,  1.0f, -1.0f },
+        { 1.0f, -1.0f, -1.0f,  1.0f },
+        { 1.0f,  1.0f,  1.0f,  1.0f },
+        { 1.0f,  1.0f, -1.0f, -1.0f },
+        { 1.0f, -1.0f,  1.0f,  1.0f },
+        { 1.0f, -1.0f, -1.0f, -1.0f },
+        { 1.0f,  1.0f,  1.0f, -1.0f },
+        { 1.0f,  1.0f, -1.0f,  1.0f },
+    }},
+    { MIXER_KERNEL_TRI, {
+        { 1.0f,  0.0f,  1.333333f, 0.0f },
+        { 1.0f, -1.0f, -0.666667f, 0.0f },
+        { 1.0f,  1.0f, -0.666667f, 0.0f },
+    }},
+};
+
+// What is left of a coefficient after a trip through MSP2_COMMON_SET_MOTOR_MIXER
+static float mspCoefficient(float value)
+{
+    const uint16_t encoded = (value + 2.0f) * 1000;
+    return encoded / 1000.0f - 2.0f;
+}
+
+static std::vector<motorMixer_t> mspMixer(const std::vector<motorMixer_t> &mixer)
+{
+    std::vector<motorMixer_t> result;
+    for (const motorMixer_t &m : mixer) {
+        result.push_back({ m.throttle, mspCoefficient(m.roll), mspCoefficient(m.pitch), mspCoefficient(m.yaw) });
+    }
+    return result;
+}
+
+static float randomInput(void)
+{
+    return (rand() % 100001) / 100.0f - 500.0f;
+}
+
+// The roll/pitch/yaw mix mixTable() used to compute, in int16_t
+static int16_t legacyRpyMix(const motorMixer_t *mixer, const int16_t *input, float mixerScale, int8_t motorYawMultiplier)
+{
+    return (input[FD_PITCH] * mixer->pitch +
+        input[FD_ROLL] * mixer->roll +
+        -motorYawMultiplier * input[FD_YAW] * mixer->yaw) * mixerScale;
+}
+
+TEST(MixerKernelTest, DetectsPresets)
+{
+    for (const mixerPreset_t &preset : presets) {
+        EXPECT_EQ(preset.kernel, mixerKernelDetect(preset.mixer.data(), preset.mixer.size()));
+        EXPECT_EQ(preset.kernel, mixerKernelDetect(mspMixer(preset.mixer).data(), preset.mixer.size()));
+        EXPECT_NE(mixerKernelGeneric, mixerKernelGet(preset.kernel));
+    }
+}
+
+TEST(MixerKernelTest, OtherMixersAreGeneric)
+{
+    std::vector<motorMixer_t> mixer = presets[0].mixer;
+
+    // Motor count has to match
+    EXPECT_EQ(MIXER_KERNEL_GENERIC, mixerKernelDetect(mixer.data(), 3));
+
+    // Motors in another order
+    std::swap(mixer[0], mixer[1]);
+    EXPECT_EQ(MIXER_KERNEL_GENERIC, mixerKernelDetect(mixer.data(), mixer.size()));
+
+    // Tuned coefficients
+    mixer = presets[0].mixer;
+    mixer[2].yaw = 0.9f;
+    EXPECT_EQ(MIXER_KERNEL_GENERIC, mixerKernelDetect(mixer.data(), mixer.size()));
+
+    // Hex with a pitch coefficient that differs between the motors
+    mixer = presets[1].mixer;
+    mixer[3].pitch = -0.867f;
+    EXPECT_EQ(MIXER_KERNEL_GENERIC, mixerKernelDetect(mixer.data(), mixer.size()));
+
+    // Close to a preset, but not close enough
+    mixer = presets[3].mixer;
+    mixer[0].pitch = 1.2f;
+    EXPECT_EQ(MIXER_KERNEL_GENERIC, mixerKernelDetect(mixer.data(), mixer.size()));
+
+    EXPECT_EQ(mixerKernelGeneric, mixerKernelGet(MIXER_KERNEL_GENERIC));
+}
+
+TEST(MixerKernelTest, KernelsMatchGenericExactly)
+{
+    srand(1);
+
+    for (const mixerPreset_t &preset : presets) {
+        const std::vector<motorMixer_t> mixer = mspMixer(preset.mixer);
+        const mixerKernelFnPtr kernelFn = mixerKernelGet(mixerKernelDetect(mixer.data(), mixer.size()));
+
+        for (int i = 0; i < 10000; i++) {
+            float input[XYZ_AXIS_COUNT] = { randomInput(), randomInput(), randomInput() };
+            if (i < 8) {
+                // Extremes and zero
+                input[FD_ROLL] = (i & 1) ? 500 : 0;
+                input[FD_PITCH] = (i & 2) ? -500 : 0;
+                input[FD_YAW] = (i & 4) ? 500 : 0;
+            }
+
+            float expected[MAX_SUPPORTED_MOTORS];
+            float actual[MAX_SUPPORTED_MOTORS];
+            mixerKernelGeneric(mixer.data(), mixer.size(), input, expected);
+            kernelFn(mixer.data(), mixer.size(), input, actual);
+
+            for (size_t motor = 0; motor < mixer.size(); motor++) {
+                ASSERT_EQ(expected[motor], actual[motor]) << "kernel " << preset.kernel << " motor " << motor;
+            }
+        }
+    }
+}
+
+TEST(MixerKernelTest, MatchesLegacyMixerUpToQuantisation)
+{
+    static const float mixerScales[] = { 1.0f, 0.5f };
+    static const int8_t yawMultipliers[] = { 1, -1 };
+
+    srand(2);
+
+    for (const mixerPreset_t &preset : presets) {
+        const std::vector<motorMixer_t> mixer = mspMixer(preset.mixer);
+        const mixerKernelFnPtr kernelFn = mixerKernelGet(mixerKernelDetect(mixer.data(), mixer.size()));
+
+        for (float mixerScale : mixerScales) {
+            for (int8_t motorYawMultiplier : yawMultipliers) {
+                for (int i = 0; i < 1000; i++) {
+                    const int16_t pid[XYZ_AXIS_COUNT] = {
+                        (int16_t)(rand() % 1001 - 500), (int16_t)(rand() % 1001 - 500), (int16_t)(rand() % 1001 - 500)
+                    };
+
+                    // The way mixTable() prepares the kernel input
+                    const float input[XYZ_AXIS_COUNT] = {
+                        pid[FD_ROLL] * mixerScale, pid[FD_PITCH] * mixerScale, pid[FD_YAW] * -motorYawMultiplier * mixerScale
+                    };
+                    float rpyMix[MAX_SUPPORTED_MOTORS];
+                    kernelFn(mixer.data(), mixer.size(), input, rpyMix);
+
+                    for (size_t motor = 0; motor < mixer.size(); motor++) {
+                        const int16_t legacy = legacyRpyMix(&mixer[motor], pid, mixerScale, motorYawMultiplier);
+                        // The old mixer truncated to int16_t, nothing else changed
+                        ASSERT_EQ(legacy, (int16_t)rpyMix[motor]);
+                        ASSERT_LT(fabsf(rpyMix[motor] - legacy), 1.0f);
+                    }
+                }
+            }
+        }
+    }
+}
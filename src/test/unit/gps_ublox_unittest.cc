@@ -0,0 +1,291 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/utils.h"
+
+    #include "drivers/serial.h"
+
+    #include "io/gps.h"
+    #include "io/gps_private.h"
+    #include "io/serial.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_RX_BUFFER_SIZE     512
+
+#define UBX_CLASS_NAV           0x01
+#define UBX_NAV_POSLLH          0x02
+#define UBX_NAV_PVT             0x07
+#define UBX_NAV_VELNED          0x12
+
+typedef struct solution_s {
+    int32_t lat;
+    timeUs_t arrivalTimeUs;
+} solution_t;
+
+static uint8_t rxBuffer[TEST_RX_BUFFER_SIZE];
+static serialPort_t testPort;
+static timeUs_t testTimeUs;
+static std::vector<solution_t> solutions;
+
+// Receives like the UART drivers, bytes going into an empty buffer are timestamped
+static void receive(const std::vector<uint8_t> &bytes, timeUs_t timeUs)
+{
+    for (uint8_t byte : bytes) {
+        if (testPort.rxBufferHead == testPort.rxBufferTail) {
+            testPort.rxBufferFirstByteUs = timeUs;
+        }
+        rxBuffer[testPort.rxBufferHead] = byte;
+        testPort.rxBufferHead = (testPort.rxBufferHead + 1) % TEST_RX_BUFFER_SIZE;
+    }
+}
+
+static std::vector<uint8_t> ubxFrame(uint8_t msgClass, uint8_t msgId, const std::vector<uint8_t> &payload)
+{
+    std::vector<uint8_t> frame = { 0xB5, 0x62, msgClass, msgId, (uint8_t)(payload.size() & 0xFF), (uint8_t)(payload.size() >> 8) };
+    frame.insert(frame.end(), payload.begin(), payload.end());
+
+    uint8_t ckA = 0;
+    uint8_t ckB = 0;
+    for (size_t i = 2; i < frame.size(); i++) {
+        ckA += frame[i];
+        ckB += ckA;
+    }
+    frame.push_back(ckA);
+    frame.push_back(ckB);
+
+    return frame;
+}
+
+static void putU32(std::vector<uint8_t> &payload, size_t offset, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        payload[offset + i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+static std::vector<uint8_t> pvtFrame(int32_t lat)
+{
+    std::vector<uint8_t> payload(92, 0);
+    payload[20] = 0x03;         // 3D fix
+    payload[21] = 0x01;         // Fix valid
+    payload[23] = 12;           // Satellites
+    putU32(payload, 24, 80000000);
+    putU32(payload, 28, lat);
+    return ubxFrame(UBX_CLASS_NAV, UBX_NAV_PVT, payload);
+}
+
+static std::vector<uint8_t> posllhFrame(int32_t lat)
+{
+    std::vector<uint8_t> payload(28, 0);
+    putU32(payload, 4, 80000000);
+    putU32(payload, 8, lat);
+    return ubxFrame(UBX_CLASS_NAV, UBX_NAV_POSLLH, payload);
+}
+
+static std::vector<uint8_t> velnedFrame(void)
+{
+    return ubxFrame(UBX_CLASS_NAV, UBX_NAV_VELNED, std::vector<uint8_t>(36, 0));
+}
+
+static void runGpsTask(timeUs_t timeUs)
+{
+    testTimeUs = timeUs;
+    gpsHandleUBLOX();
+}
+
+class GpsUbloxTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        static const serialPortVTable vTable = {
+            .serialWrite = [](serialPort_t *, uint8_t) {},
+            .serialTotalRxWaiting = [](const serialPort_t *instance) {
+                return (instance->rxBufferHead - instance->rxBufferTail + TEST_RX_BUFFER_SIZE) % TEST_RX_BUFFER_SIZE;
+            },
+            .serialTotalTxFree = [](const serialPort_t *) { return (uint32_t)TEST_RX_BUFFER_SIZE; },
+            .serialRead = nullptr,
+            .serialRxPeek = serialRxBufferPeek,
+            .serialRxConsume = serialRxBufferConsume,
+            .serialSetBaudRate = [](serialPort_t *, uint32_t) {},
+            .isSerialTransmitBufferEmpty = [](const serialPort_t *) { return true; },
+            .setMode = nullptr,
+            .writeBuf = nullptr,
+            .isConnected = nullptr,
+            .isIdle = nullptr,
+            .beginWrite = nullptr,
+            .endWrite = nullptr,
+        };
+        static gpsConfig_t config;
+
+        memset(&testPort, 0, sizeof(testPort));
+        testPort.vTable = &vTable;
+        testPort.rxBuffer = rxBuffer;
+        testPort.rxBufferSize = TEST_RX_BUFFER_SIZE;
+
+        config.autoConfig = GPS_AUTOCONFIG_OFF;
+        config.autoBaud = GPS_AUTOBAUD_OFF;
+        memset(&gpsState, 0, sizeof(gpsState));
+        gpsState.gpsConfig = &config;
+        gpsState.gpsPort = &testPort;
+
+        memset(&gpsSol, 0, sizeof(gpsSol));
+        solutions.clear();
+        gpsRestartUBLOX();
+    }
+};
+
+TEST_F(GpsUbloxTest, ProcessesEverySolutionReceivedSinceTheLastRun)
+{
+    // The task fell behind, three 25Hz epochs are waiting
+    receive(pvtFrame(1), 1000);
+    receive(pvtFrame(2), 41000);
+    receive(pvtFrame(3), 81000);
+
+    runGpsTask(90000);
+
+    ASSERT_EQ(3u, solutions.size());
+    EXPECT_EQ(1, solutions[0].lat);
+    EXPECT_EQ(2, solutions[1].lat);
+    EXPECT_EQ(3, solutions[2].lat);
+    EXPECT_EQ(0u, serialRxBytesWaiting(&testPort));
+
+    // The driver only timestamps the oldest byte in the buffer
+    EXPECT_EQ(1000u, solutions[2].arrivalTimeUs);
+}
+
+TEST_F(GpsUbloxTest, SolutionIsStampedWithItsFirstByte)
+{
+    const std::vector<uint8_t> frame = pvtFrame(10);
+    const std::vector<uint8_t> firstPart(frame.begin(), frame.begin() + 40);
+    const std::vector<uint8_t> secondPart(frame.begin() + 40, frame.end());
+
+    receive(firstPart, 5000);
+    runGpsTask(6000);
+    EXPECT_EQ(0u, solutions.size());
+
+    receive(secondPart, 12000);
+    runGpsTask(20000);
+
+    ASSERT_EQ(1u, solutions.size());
+    EXPECT_EQ(10, solutions[0].lat);
+    EXPECT_EQ(5000u, solutions[0].arrivalTimeUs);
+
+    receive(pvtFrame(11), 105000);
+    runGpsTask(120000);
+
+    ASSERT_EQ(2u, solutions.size());
+    EXPECT_EQ(105000u, solutions[1].arrivalTimeUs);
+}
+
+TEST_F(GpsUbloxTest, SolutionFromSeveralMessagesStartsWithTheFirst)
+{
+    // Receivers without PVT send position and velocity in separate messages
+    receive(posllhFrame(20), 3000);
+    runGpsTask(4000);
+    EXPECT_EQ(0u, solutions.size());
+
+    receive(velnedFrame(), 9000);
+    runGpsTask(10000);
+
+    ASSERT_EQ(1u, solutions.size());
+    EXPECT_EQ(20, solutions[0].lat);
+    EXPECT_EQ(3000u, solutions[0].arrivalTimeUs);
+}
+
+TEST_F(GpsUbloxTest, CorruptFrameIsSkipped)
+{
+    std::vector<uint8_t> corrupt = pvtFrame(30);
+    corrupt[40] ^= 0xFF;
+
+    const uint32_t errors = gpsStats.errors;
+
+    receive(corrupt, 1000);
+    receive(pvtFrame(31), 1000);
+    runGpsTask(10000);
+
+    ASSERT_EQ(1u, solutions.size());
+    EXPECT_EQ(31, solutions[0].lat);
+    EXPECT_EQ(errors + 1, gpsStats.errors);
+}
+
+// STUBS
+
+extern "C" {
+
+gpsReceiverData_t gpsState;
+gpsSolutionData_t gpsSol;
+gpsStatistics_t gpsStats;
+
+baudRate_e gpsToSerialBaudRate[GPS_BAUDRATE_COUNT] = { BAUD_115200, BAUD_57600, BAUD_38400, BAUD_19200, BAUD_9600, BAUD_230400 };
+const uint32_t baudRates[] = { 0, 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400, 250000, 460800, 921600, 1000000, 1500000, 2000000, 2470000 };
+
+timeUs_t micros(void)
+{
+    return testTimeUs;
+}
+
+timeMs_t millis(void)
+{
+    return testTimeUs / 1000;
+}
+
+void gpsSetState(gpsState_e state)
+{
+    gpsState.state = state;
+}
+
+void gpsSetProtocolTimeout(timeMs_t timeoutMs)
+{
+    UNUSED(timeoutMs);
+}
+
+uint16_t gpsConstrainEPE(uint32_t epe)
+{
+    return epe;
+}
+
+uint16_t gpsConstrainHDOP(uint32_t hdop)
+{
+    return hdop;
+}
+
+// Only used for the version string, which the tests don't send
+char *strnstr(const char *s, const char *find, size_t slen)
+{
+    UNUSED(slen);
+    return (char *)strstr(s, find);
+}
+
+void gpsProcessNewSolutionData(void)
+{
+    solutions.push_back({ gpsSol.llh.lat, gpsSol.arrivalTimeUs });
+    gpsSol.arrivalTimeUs = 0;
+}
+
+}
@@ -0,0 +1,121 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "flight/gyro_spectrum.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define WINDOW_SIZE (GYRO_SPECTRUM_BIN_COUNT * 2)
+
+static void fillSpectrum(float *magnitude, int peakBin, float peak)
+{
+    for (int bin = 0; bin < GYRO_SPECTRUM_BIN_COUNT; bin++) {
+        magnitude[bin] = (bin == peakBin) ? peak : 0.0f;
+    }
+}
+
+TEST(GyroSpectrumTest, AmplitudeOfSine)
+{
+    gyroSpectrumInit(1000, WINDOW_SIZE);
+    gyroSpectrumReset(1);
+
+    // A sine of amplitude A in the middle of a bin shows up as A * N / 4 after a Hann window
+    float magnitude[GYRO_SPECTRUM_BIN_COUNT];
+    fillSpectrum(magnitude, 10, 20.0f * WINDOW_SIZE / 4);
+    gyroSpectrumAccumulate(FD_ROLL, magnitude, 50);
+
+    const gyroSpectrum_t *spectrum = gyroSpectrumGet(FD_ROLL, 0);
+    ASSERT_NE(nullptr, spectrum);
+    EXPECT_EQ(1u, spectrum->count);
+    EXPECT_FLOAT_EQ(20.0f, spectrum->amplitude[10]);
+    EXPECT_FLOAT_EQ(0.0f, spectrum->amplitude[9]);
+
+    EXPECT_EQ(0u, gyroSpectrumGet(FD_PITCH, 0)->count);
+    EXPECT_EQ(1000, gyroSpectrumGetSampleRateHz());
+}
+
+TEST(GyroSpectrumTest, Average)
+{
+    gyroSpectrumInit(1000, WINDOW_SIZE);
+
+    float magnitude[GYRO_SPECTRUM_BIN_COUNT];
+    for (int i = 0; i < 100; i++) {
+        fillSpectrum(magnitude, 3, (i % 2) ? 0.0f : 2.0f * WINDOW_SIZE / 4);
+        gyroSpectrumAccumulate(FD_YAW, magnitude, 0);
+    }
+
+    const gyroSpectrum_t *spectrum = gyroSpectrumGet(FD_YAW, 0);
+    EXPECT_EQ(100u, spectrum->count);
+    EXPECT_NEAR(1.0f, spectrum->amplitude[3], 1e-4f);
+}
+
+TEST(GyroSpectrumTest, LongAverageFollowsChanges)
+{
+    gyroSpectrumInit(1000, WINDOW_SIZE);
+
+    float magnitude[GYRO_SPECTRUM_BIN_COUNT];
+    fillSpectrum(magnitude, 5, 1.0f * WINDOW_SIZE / 4);
+    for (int i = 0; i < GYRO_SPECTRUM_MAX_AVERAGE * 4; i++) {
+        gyroSpectrumAccumulate(FD_ROLL, magnitude, 0);
+    }
+    EXPECT_NEAR(1.0f, gyroSpectrumGet(FD_ROLL, 0)->amplitude[5], 1e-3f);
+
+    // Noise going away after a prop change shows within a few averaging lengths
+    fillSpectrum(magnitude, 5, 0.0f);
+    for (int i = 0; i < GYRO_SPECTRUM_MAX_AVERAGE * 4; i++) {
+        gyroSpectrumAccumulate(FD_ROLL, magnitude, 0);
+    }
+    EXPECT_LT(gyroSpectrumGet(FD_ROLL, 0)->amplitude[5], 0.05f);
+}
+
+TEST(GyroSpectrumTest, ThrottleBins)
+{
+    gyroSpectrumInit(1000, WINDOW_SIZE);
+    gyroSpectrumReset(4);
+    EXPECT_EQ(4, gyroSpectrumGetThrottleBins());
+
+    float magnitude[GYRO_SPECTRUM_BIN_COUNT];
+    fillSpectrum(magnitude, 1, WINDOW_SIZE / 4);
+
+    gyroSpectrumAccumulate(FD_ROLL, magnitude, -5);
+    gyroSpectrumAccumulate(FD_ROLL, magnitude, 24);
+    gyroSpectrumAccumulate(FD_ROLL, magnitude, 25);
+    gyroSpectrumAccumulate(FD_ROLL, magnitude, 80);
+    gyroSpectrumAccumulate(FD_ROLL, magnitude, 100);
+    gyroSpectrumAccumulate(FD_ROLL, magnitude, 150);
+
+    EXPECT_EQ(2u, gyroSpectrumGet(FD_ROLL, 0)->count);
+    EXPECT_EQ(1u, gyroSpectrumGet(FD_ROLL, 1)->count);
+    EXPECT_EQ(0u, gyroSpectrumGet(FD_ROLL, 2)->count);
+    EXPECT_EQ(3u, gyroSpectrumGet(FD_ROLL, 3)->count);
+    EXPECT_EQ(nullptr, gyroSpectrumGet(FD_ROLL, 4));
+
+    // Reset clears the spectrum and limits the bin count
+    gyroSpectrumReset(10);
+    EXPECT_EQ(GYRO_SPECTRUM_MAX_THROTTLE_BINS, gyroSpectrumGetThrottleBins());
+    EXPECT_EQ(0u, gyroSpectrumGet(FD_ROLL, 3)->count);
+    gyroSpectrumReset(0);
+    EXPECT_EQ(1, gyroSpectrumGetThrottleBins());
+}
@@ -84,3 +84,15 @@ extern SysTick_Type *SysTick;
 #define FAST_CODE 
 #define NOINLINE
 #define EXTENDED_FASTRAM
+
+#define __NOP()
+
+#if defined(CONFIG_IN_RAM) || defined(CONFIG_IN_FILE)
+#ifndef EEPROM_SIZE
+#define EEPROM_SIZE     8192
+#endif
+#define EEPROM_FILENAME "eeprom.bin"
+extern uint8_t eepromData[EEPROM_SIZE];
+#define __config_start (*eepromData)
+#define __config_end (eepromData[EEPROM_SIZE])
+#endif
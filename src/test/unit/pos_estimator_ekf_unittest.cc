@@ -0,0 +1,494 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+
+    #include "navigation/navigation_pos_estimator_ekf.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_LOOP_US            10000       // nav_loop_hz = 100
+#define TEST_GPS_PERIOD_US      100000      // 10Hz solutions...
+#define TEST_GPS_DELAY_US       120000      // ...arriving this late
+#define TEST_EKF_GPS_DELAY_US   100000      // inav_ekf_gps_delay default, taken off the arrival
+#define TEST_BARO_PERIOD_US     20000
+#define TEST_WARMUP_US          15000000
+#define TEST_DURATION_US        75000000
+
+#define TEST_ACC_NOISE          50.0f       // Estimator defaults
+#define TEST_BIAS_NOISE         1.0f
+
+// Defaults of the complementary estimator
+#define W_XY_GPS_P              1.0f
+#define W_XY_GPS_V              2.0f
+#define W_Z_BARO_P              0.35f
+#define W_Z_GPS_V               0.1f
+#define W_ACC_BIAS              0.01f
+#define BARO_AVERAGE_HZ         1.0f
+
+static uint32_t testSeed;
+
+static float testGaussian(void)
+{
+    float u[2];
+    for (int i = 0; i < 2; i++) {
+        testSeed = testSeed * 1103515245 + 12345;
+        u[i] = ((testSeed >> 8) + 1.0f) / 16777217.0f;
+    }
+    return sqrtf(-2 * logf(u[0])) * cosf(2 * M_PIf * u[1]);
+}
+
+typedef struct {
+    float pos[3];
+    float vel[3];
+    float acc[3];
+} truth_t;
+
+// Orbits at 12m/s with a 40m radius, climbing and descending, with some hard turns in between
+static truth_t truthAt(timeUs_t timeUs)
+{
+    const float t = US2S(timeUs);
+    const float w = 0.3f + 0.15f * sinf(0.05f * t);     // rad/s, its changes are the hard part
+    const float phase = 0.3f * t - 0.15f / 0.05f * cosf(0.05f * t);
+    const float dw = 0.15f * 0.05f * cosf(0.05f * t);
+    const float r = 4000;
+
+    truth_t truth;
+    truth.pos[0] = r * cosf(phase);
+    truth.pos[1] = r * sinf(phase);
+    truth.vel[0] = -r * w * sinf(phase);
+    truth.vel[1] = r * w * cosf(phase);
+    truth.acc[0] = -r * w * w * cosf(phase) - r * dw * sinf(phase);
+    truth.acc[1] = -r * w * w * sinf(phase) + r * dw * cosf(phase);
+
+    truth.pos[2] = 3000 + 1500 * sinf(0.2f * t);
+    truth.vel[2] = 300 * cosf(0.2f * t);
+    truth.acc[2] = -60 * sinf(0.2f * t);
+    return truth;
+}
+
+typedef struct {
+    timeUs_t time;
+    float pos[3];
+    float vel[3];
+} gpsSolution_t;
+
+typedef struct {
+    float accBias[3];           // Accelerometer error, earth frame
+    float accNoise;
+    float gpsPosNoise;          // Per axis
+    float gpsVelNoise;
+    float gpsEph;               // As the receiver reports it
+    float gpsEpv;
+    float baroNoise;
+    float baroEpv;
+} sensorModel_t;
+
+static const sensorModel_t defaultSensors = {
+    { 15, -10, 30 }, 40, 80, 15, 150, 250, 40, 100,
+};
+
+typedef struct {
+    double posErrorSq[2];       // XY, Z
+    double velErrorSq[2];
+    int samples;
+} result_t;
+
+class Estimator {
+public:
+    virtual ~Estimator() {}
+    virtual void reset(void) = 0;
+    virtual void onGps(const gpsSolution_t *solution, timeUs_t arrivalTime, const sensorModel_t *sensors) = 0;
+    virtual void onBaro(float alt, timeUs_t timeUs, const sensorModel_t *sensors) = 0;
+    virtual void update(timeUs_t currentTimeUs, const float acc[3]) = 0;
+    virtual void getEstimate(float pos[3], float vel[3]) = 0;
+};
+
+class EkfEstimator : public Estimator {
+public:
+    posEkf_t ekf;
+    timeUs_t gpsDelayUs = TEST_EKF_GPS_DELAY_US;
+
+    void reset(void) override
+    {
+        posEkfInit(&ekf, TEST_ACC_NOISE, TEST_BIAS_NOISE);
+    }
+
+    void onGps(const gpsSolution_t *solution, timeUs_t arrivalTime, const sensorModel_t *sensors) override
+    {
+        const timeUs_t gpsTime = arrivalTime - gpsDelayUs;
+        for (int axis = 0; axis < 2; axis++) {
+            posEkfAddMeasurement(&ekf, gpsTime, axis, POS_EKF_POS, solution->pos[axis], sq(sensors->gpsEph));
+            posEkfAddMeasurement(&ekf, gpsTime, axis, POS_EKF_VEL, solution->vel[axis], sq(MAX(50.0f, sensors->gpsEph / 4)));
+        }
+        posEkfAddMeasurement(&ekf, gpsTime, Z, POS_EKF_VEL, solution->vel[Z], sq(MAX(50.0f, sensors->gpsEpv / 4)));
+    }
+
+    void onBaro(float alt, timeUs_t timeUs, const sensorModel_t *sensors) override
+    {
+        posEkfAddMeasurement(&ekf, timeUs, Z, POS_EKF_POS, alt, sq(sensors->baroEpv));
+    }
+
+    void update(timeUs_t currentTimeUs, const float acc[3]) override
+    {
+        const fpVector3_t accelNEU = { .v = { acc[0], acc[1], acc[2] } };
+        posEkfUpdate(&ekf, currentTimeUs, &accelNEU);
+    }
+
+    void getEstimate(float pos[3], float vel[3]) override
+    {
+        for (int axis = 0; axis < 3; axis++) {
+            pos[axis] = ekf.pos.v[axis];
+            vel[axis] = ekf.vel.v[axis];
+        }
+    }
+};
+
+/*
+ * The corrections of updateEstimatedTopic() with the default weights: GPS compared to the estimate at the
+ * time it arrived, filtered baro, accelerometer bias from the position residuals.
+ */
+class ComplementaryEstimator : public Estimator {
+public:
+    float pos[3], vel[3], bias[3];
+    float posCorrSum[3], velCorrSum[3];
+    float historyPos[32][3];    // Estimate less the corrections, one sample per update
+    float historyVel[32][3];
+    timeUs_t historyTime[32];
+    int historyHead;
+    gpsSolution_t gps;
+    timeUs_t gpsArrival;
+    bool gpsValid;
+    float baroAlt;
+    bool baroValid;
+    timeUs_t lastTime;
+
+    void reset(void) override
+    {
+        memset(pos, 0, sizeof(pos));
+        memset(vel, 0, sizeof(vel));
+        memset(bias, 0, sizeof(bias));
+        memset(posCorrSum, 0, sizeof(posCorrSum));
+        memset(velCorrSum, 0, sizeof(velCorrSum));
+        memset(historyTime, 0, sizeof(historyTime));
+        historyHead = 0;
+        gpsValid = false;
+        baroValid = false;
+        lastTime = 0;
+    }
+
+    void onGps(const gpsSolution_t *solution, timeUs_t arrivalTime, const sensorModel_t *sensors) override
+    {
+        UNUSED(sensors);
+        if (!gpsValid) {
+            for (int axis = 0; axis < 2; axis++) {
+                pos[axis] = solution->pos[axis];
+                vel[axis] = solution->vel[axis];
+            }
+        }
+        gps = *solution;
+        gpsArrival = arrivalTime;
+        gpsValid = true;
+    }
+
+    void onBaro(float alt, timeUs_t timeUs, const sensorModel_t *sensors) override
+    {
+        UNUSED(sensors);
+        const float dt = US2S(TEST_BARO_PERIOD_US);
+        if (!baroValid) {
+            baroAlt = alt;
+            pos[Z] = alt;
+        }
+        baroAlt += (alt - baroAlt) * dt / (dt + 1 / (2 * M_PIf * BARO_AVERAGE_HZ));
+        baroValid = true;
+        UNUSED(timeUs);
+    }
+
+    void update(timeUs_t currentTimeUs, const float acc[3]) override
+    {
+        const float dt = lastTime ? US2S(currentTimeUs - lastTime) : 0;
+        lastTime = currentTimeUs;
+
+        float a[3];
+        for (int axis = 0; axis < 3; axis++) {
+            a[axis] = acc[axis] - bias[axis];
+            pos[axis] += vel[axis] * dt + a[axis] * dt * dt / 2;
+            vel[axis] += a[axis] * dt;
+        }
+
+        float posCorr[3] = { 0, 0, 0 };
+        float velCorr[3] = { 0, 0, 0 };
+        float biasCorr[3] = { 0, 0, 0 };
+
+        // GPS moved forward from its arrival by what the estimate predicted since
+        float gpsPos[3], gpsVel[3];
+        int past = -1;
+        for (int i = 1; i < 32; i++) {
+            const int index = (historyHead + 32 - i) % 32;
+            if (historyTime[index] && historyTime[index] <= gpsArrival) {
+                past = index;
+                break;
+            }
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            gpsPos[axis] = gps.pos[axis];
+            gpsVel[axis] = gps.vel[axis];
+            if (past >= 0) {
+                gpsPos[axis] += pos[axis] - posCorrSum[axis] - historyPos[past][axis];
+                gpsVel[axis] += vel[axis] - velCorrSum[axis] - historyVel[past][axis];
+            }
+        }
+
+        if (baroValid) {
+            const float residual = baroAlt - pos[Z];
+            posCorr[Z] += residual * W_Z_BARO_P * dt;
+            velCorr[Z] += residual * sq(W_Z_BARO_P) * dt;
+            if (gpsValid) {
+                const float rocResidual = gpsVel[Z] - vel[Z];
+                velCorr[Z] += rocResidual * W_Z_GPS_V * bellCurve(rocResidual, 250.0f) * dt;
+            }
+            biasCorr[Z] -= residual * sq(W_Z_BARO_P);
+        }
+
+        if (gpsValid) {
+            for (int axis = 0; axis < 2; axis++) {
+                const float residual = gpsPos[axis] - pos[axis];
+                posCorr[axis] += residual * W_XY_GPS_P * dt;
+                velCorr[axis] += residual * sq(W_XY_GPS_P) * dt;
+                velCorr[axis] += (gpsVel[axis] - vel[axis]) * W_XY_GPS_V * dt;
+                biasCorr[axis] -= residual * sq(W_XY_GPS_P);
+            }
+        }
+
+        for (int axis = 0; axis < 3; axis++) {
+            pos[axis] += posCorr[axis];
+            vel[axis] += velCorr[axis];
+            posCorrSum[axis] += posCorr[axis];
+            velCorrSum[axis] += velCorr[axis];
+            historyPos[historyHead][axis] = pos[axis] - posCorrSum[axis];
+            historyVel[historyHead][axis] = vel[axis] - velCorrSum[axis];
+        }
+        historyTime[historyHead] = currentTimeUs;
+        historyHead = (historyHead + 1) % 32;
+
+        if (sq(biasCorr[0]) + sq(biasCorr[1]) + sq(biasCorr[2]) < sq(980.665f * 0.25f)) {
+            for (int axis = 0; axis < 3; axis++) {
+                bias[axis] += biasCorr[axis] * W_ACC_BIAS * dt;
+            }
+        }
+    }
+
+    void getEstimate(float estPos[3], float estVel[3]) override
+    {
+        for (int axis = 0; axis < 3; axis++) {
+            estPos[axis] = pos[axis];
+            estVel[axis] = vel[axis];
+        }
+    }
+};
+
+// Runs the flight through the estimator, errors are taken after the warmup
+static result_t simulate(Estimator *estimator, const sensorModel_t *sensors)
+{
+    result_t result;
+    memset(&result, 0, sizeof(result));
+
+    testSeed = 1;
+    estimator->reset();
+
+    gpsSolution_t pending[4];
+    int pendingCount = 0;
+
+    for (timeUs_t now = TEST_LOOP_US; now <= TEST_WARMUP_US + TEST_DURATION_US; now += TEST_LOOP_US) {
+        const truth_t truth = truthAt(now);
+
+        if (now % TEST_GPS_PERIOD_US == 0) {
+            gpsSolution_t *solution = &pending[pendingCount++];
+            solution->time = now;
+            for (int axis = 0; axis < 3; axis++) {
+                solution->pos[axis] = truth.pos[axis] + sensors->gpsPosNoise * testGaussian();
+                solution->vel[axis] = truth.vel[axis] + sensors->gpsVelNoise * testGaussian();
+            }
+        }
+
+        if (now % TEST_BARO_PERIOD_US == 0) {
+            estimator->onBaro(truth.pos[Z] + sensors->baroNoise * testGaussian(), now, sensors);
+        }
+
+        if (pendingCount > 0 && now >= pending[0].time + TEST_GPS_DELAY_US) {
+            // Stamped with its arrival, the latency of the receiver is only known to the estimators as configured
+            estimator->onGps(&pending[0], now, sensors);
+            memmove(&pending[0], &pending[1], sizeof(pending[0]) * --pendingCount);
+        }
+
+        float acc[3];
+        for (int axis = 0; axis < 3; axis++) {
+            acc[axis] = truth.acc[axis] + sensors->accBias[axis] + sensors->accNoise * testGaussian();
+        }
+
+        estimator->update(now, acc);
+
+        if (now > TEST_WARMUP_US) {
+            float pos[3], vel[3];
+            estimator->getEstimate(pos, vel);
+            result.posErrorSq[0] += sq(pos[X] - truth.pos[X]) + sq(pos[Y] - truth.pos[Y]);
+            result.velErrorSq[0] += sq(vel[X] - truth.vel[X]) + sq(vel[Y] - truth.vel[Y]);
+            result.posErrorSq[1] += sq(pos[Z] - truth.pos[Z]);
+            result.velErrorSq[1] += sq(vel[Z] - truth.vel[Z]);
+            result.samples++;
+        }
+    }
+
+    for (int i = 0; i < 2; i++) {
+        result.posErrorSq[i] = sqrt(result.posErrorSq[i] / result.samples);
+        result.velErrorSq[i] = sqrt(result.velErrorSq[i] / result.samples);
+    }
+
+    return result;
+}
+
+static void runConstantVelocity(posEkf_t *ekf, timeUs_t *now, timeUs_t until, float vel, timeUs_t gpsDelayUs)
+{
+    const fpVector3_t zero = { .v = { 0, 0, 0 } };
+
+    for (; *now < until; *now += TEST_LOOP_US) {
+        if (*now % TEST_GPS_PERIOD_US == 0 && *now >= gpsDelayUs) {
+            const timeUs_t measured = *now - gpsDelayUs;
+            posEkfAddMeasurement(ekf, measured, X, POS_EKF_POS, vel * US2S(measured), sq(100.0f));
+        }
+        posEkfUpdate(ekf, *now, &zero);
+    }
+}
+
+TEST(PosEkfTest, AxisStartsFromPosition)
+{
+    posEkf_t ekf;
+    posEkfInit(&ekf, TEST_ACC_NOISE, TEST_BIAS_NOISE);
+
+    const fpVector3_t zero = { .v = { 0, 0, 0 } };
+    timeUs_t now = 0;
+
+    // Velocity alone doesn't start an axis
+    posEkfAddMeasurement(&ekf, now, X, POS_EKF_VEL, 100, 100);
+    for (int i = 0; i < 50; i++, now += TEST_LOOP_US) {
+        posEkfUpdate(&ekf, now, &zero);
+    }
+    EXPECT_FALSE(posEkfIsAxisValid(&ekf, X));
+
+    posEkfAddMeasurement(&ekf, now, X, POS_EKF_POS, 1234, sq(100.0f));
+    posEkfUpdate(&ekf, now, &zero);
+    EXPECT_FALSE(posEkfIsAxisValid(&ekf, X));
+
+    // Started once the filter gets to the time of the measurement
+    for (int i = 0; i < 30; i++) {
+        now += TEST_LOOP_US;
+        posEkfUpdate(&ekf, now, &zero);
+    }
+    EXPECT_TRUE(posEkfIsAxisValid(&ekf, X));
+    EXPECT_FALSE(posEkfIsAxisValid(&ekf, Y));
+    EXPECT_NEAR(1234, ekf.pos.x, 1);
+    EXPECT_LT(sqrtf(ekf.axis[X].P[POS_EKF_POS][POS_EKF_POS]), 150);
+    // Velocity is still unknown, the estimate of now is less certain than the filter
+    EXPECT_GT(ekf.posVariance[X], ekf.axis[X].P[POS_EKF_POS][POS_EKF_POS]);
+}
+
+TEST(PosEkfTest, MeasurementIsFusedAtItsTime)
+{
+    posEkf_t ekf;
+    posEkfInit(&ekf, TEST_ACC_NOISE, TEST_BIAS_NOISE);
+
+    // 10m/s, GPS 150ms late. Fused on arrival the position would be 150cm behind.
+    timeUs_t now = 0;
+    runConstantVelocity(&ekf, &now, 20000000, 1000, 150000);
+
+    EXPECT_NEAR(1000 * US2S(now - TEST_LOOP_US), ekf.pos.x, 10);
+    EXPECT_NEAR(1000, ekf.vel.x, 5);
+    EXPECT_EQ(0u, ekf.stats.dropped);
+}
+
+TEST(PosEkfTest, OutlierIsRejected)
+{
+    posEkf_t ekf;
+    posEkfInit(&ekf, TEST_ACC_NOISE, TEST_BIAS_NOISE);
+
+    timeUs_t now = 0;
+    runConstantVelocity(&ekf, &now, 10000000, 0, 0);
+    ASSERT_NEAR(0, ekf.pos.x, 50);
+
+    // One glitch of 50m
+    posEkfAddMeasurement(&ekf, now, X, POS_EKF_POS, 5000, sq(100.0f));
+    runConstantVelocity(&ekf, &now, now + 500000, 0, 0);
+    EXPECT_NEAR(0, ekf.pos.x, 50);
+    EXPECT_EQ(1u, ekf.stats.rejected);
+
+    // Jumped for good, the filter follows after POS_EKF_MAX_REJECTS measurements
+    const fpVector3_t zero = { .v = { 0, 0, 0 } };
+    for (int i = 0; i < 300; i++, now += TEST_LOOP_US) {
+        if (now % TEST_GPS_PERIOD_US == 0) {
+            posEkfAddMeasurement(&ekf, now, X, POS_EKF_POS, 5000, sq(100.0f));
+        }
+        posEkfUpdate(&ekf, now, &zero);
+    }
+    EXPECT_NEAR(5000, ekf.pos.x, 50);
+}
+
+TEST(PosEkfTest, AccelerometerBiasIsEstimated)
+{
+    sensorModel_t sensors = defaultSensors;
+    EkfEstimator estimator;
+    simulate(&estimator, &sensors);
+
+    for (int axis = 0; axis < 3; axis++) {
+        EXPECT_NEAR(sensors.accBias[axis], estimator.ekf.axis[axis].x[POS_EKF_BIAS], 5) << "axis " << axis;
+    }
+}
+
+TEST(PosEkfTest, MeasurementsWaitingForTheHorizonAreKept)
+{
+    // GPS taken as measured on arrival, it and the baro wait the whole horizon for the filter
+    EkfEstimator estimator;
+    estimator.gpsDelayUs = 0;
+    simulate(&estimator, &defaultSensors);
+
+    EXPECT_EQ(0u, estimator.ekf.stats.dropped);
+    EXPECT_EQ(0u, estimator.ekf.stats.rejected);
+}
+
+// Same flight and sensors through both estimators
+TEST(PosEkfTest, AgainstComplementaryEstimator)
+{
+    EkfEstimator ekf;
+    ComplementaryEstimator complementary;
+
+    const result_t ekfResult = simulate(&ekf, &defaultSensors);
+    const result_t complementaryResult = simulate(&complementary, &defaultSensors);
+
+    for (int i = 0; i < 2; i++) {
+        EXPECT_LT(ekfResult.posErrorSq[i], complementaryResult.posErrorSq[i]);
+        EXPECT_LT(ekfResult.velErrorSq[i], complementaryResult.velErrorSq[i]);
+    }
+}
@@ -0,0 +1,531 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <algorithm>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "drivers/bus.h"
+    #include "drivers/io.h"
+    #include "drivers/time.h"
+    #include "drivers/rangefinder/rangefinder.h"
+    #include "drivers/rangefinder/rangefinder_srf10.h"
+    #include "drivers/rangefinder/rangefinder_tof10120_i2c.h"
+    #include "drivers/rangefinder/rangefinder_us42.h"
+    #include "drivers/rangefinder/rangefinder_vl53l0x.h"
+    #include "drivers/rangefinder/rangefinder_vl53l1x.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+/*
+ * The sensors are register files on a fake I2C bus which also keeps the time: a transaction takes as
+ * long as its bytes do at 400kHz. Once started a sensor produces a result every period on its own and
+ * the time the last one was ready is kept, so the latency of the driver can be measured.
+ */
+typedef enum {
+    FAKE_VL53L0X,
+    FAKE_VL53L1X,
+    FAKE_SRF10,
+    FAKE_US42,
+    FAKE_TOF10120,
+} fakeSensor_e;
+
+#define FAKE_I2C_BYTE_NS        22500ULL        // 9 bits at 400kHz
+#define FAKE_START_NS           100000000000ULL // 100s, past the wrap of a 16 bit millisecond count
+#define FAKE_RANGE_MM           1234
+
+static struct {
+    busDevice_t dev;
+    fakeSensor_e sensor;
+    uint8_t regs[0x200];
+    uint16_t index;             // VL53L1X register index set by the last raw write
+    bool ranging;
+    bool pending;               // Result not cleared by the driver yet
+    uint64_t periodNs;
+    uint64_t nextResultNs;
+    uint64_t readyNs;           // Time the last result was ready
+    unsigned produced;
+    unsigned starts;            // Ranging started by the driver
+    uint64_t nowNs;
+    unsigned transactions;
+    unsigned bytes;
+    unsigned delays;
+} fake;
+
+static void fakeReset(fakeSensor_e sensor, bool dataReadyPin)
+{
+    memset(&fake, 0, sizeof(fake));
+    fake.sensor = sensor;
+    fake.nowNs = FAKE_START_NS;
+    fake.dev.busType = BUSTYPE_I2C;
+    fake.dev.irqPin = dataReadyPin ? (IO_t)&fake : IO_NONE;
+
+    switch (sensor) {
+    case FAKE_VL53L0X:
+        fake.regs[0xC0] = 0xEE;     // IDENTIFICATION_MODEL_ID
+        fake.periodNs = 33700000;   // Timing budget, off the task period as the clocks differ
+        break;
+    case FAKE_VL53L1X:
+        fake.dev.flags = DEVFLAGS_USE_RAW_REGISTERS;
+        fake.regs[0x10F] = 0xEA;    // IDENTIFICATION__MODEL_ID
+        fake.periodNs = 40900000;   // Inter-measurement period, the sensor clock is a bit slow
+        break;
+    case FAKE_SRF10:
+        fake.regs[0x00] = 0x06;     // Software revision
+        fake.regs[0x01] = 0x80;
+        fake.periodNs = MS2US(36) * 1000;
+        break;
+    case FAKE_US42:
+        fake.dev.flags = DEVFLAGS_USE_RAW_REGISTERS;
+        fake.periodNs = MS2US(40) * 1000;
+        break;
+    case FAKE_TOF10120:
+        fake.dev.flags = DEVFLAGS_USE_RAW_REGISTERS;
+        fake.regs[0x0F] = 0xA4;     // Bus address
+        fake.periodNs = MS2US(30) * 1000;
+        fake.ranging = true;
+        break;
+    }
+}
+
+static void fakeStartRanging(void)
+{
+    fake.ranging = true;
+    fake.nextResultNs = fake.nowNs + fake.periodNs;
+    fake.starts++;
+}
+
+static void fakeAdvance(void)
+{
+    while (fake.ranging && fake.nowNs >= fake.nextResultNs) {
+        fake.readyNs = fake.nextResultNs;
+        fake.nextResultNs += fake.periodNs;
+        fake.pending = true;
+        fake.produced++;
+
+        const uint16_t rangeMm = FAKE_RANGE_MM + fake.produced % 10;
+
+        switch (fake.sensor) {
+        case FAKE_VL53L0X:
+            fake.regs[0x13] = 0x04;     // RESULT_INTERRUPT_STATUS, new sample ready
+            fake.regs[0x1E] = rangeMm >> 8;
+            fake.regs[0x1F] = rangeMm & 0xFF;
+            break;
+        case FAKE_VL53L1X:
+            fake.regs[0x8B]++;          // RESULT__STREAM_COUNT
+            fake.regs[0x96] = rangeMm >> 8;
+            fake.regs[0x97] = rangeMm & 0xFF;
+            break;
+        case FAKE_SRF10:
+            fake.ranging = false;
+            fake.regs[0x02] = (rangeMm / 10) >> 8;
+            fake.regs[0x03] = (rangeMm / 10) & 0xFF;
+            break;
+        case FAKE_US42:
+            fake.ranging = false;
+            fake.regs[0x51] = (rangeMm / 10) >> 8;
+            fake.regs[0x52] = (rangeMm / 10) & 0xFF;
+            break;
+        case FAKE_TOF10120:
+            fake.regs[0x00] = rangeMm >> 8;
+            fake.regs[0x01] = rangeMm & 0xFF;
+            break;
+        }
+    }
+}
+
+static void fakeTransaction(unsigned bytes)
+{
+    fake.transactions++;
+    fake.bytes += bytes;
+    fake.nowNs += bytes * FAKE_I2C_BYTE_NS;
+    fakeAdvance();
+}
+
+// VL53L1X GPIO1 level with a result pending, GPIO_HV_MUX__CTRL bit 4 set is active low
+static bool fakeVl53l1xActiveLevel(void)
+{
+    return !(fake.regs[0x30] & 0x10);
+}
+
+static uint8_t fakeReadRegister(uint16_t index)
+{
+    switch (fake.sensor) {
+    case FAKE_SRF10:
+        // Doesn't answer while ranging
+        return fake.ranging ? 0xFF : fake.regs[index];
+    case FAKE_VL53L1X:
+        if (index == 0x31) {
+            return fake.pending == fakeVl53l1xActiveLevel();
+        }
+        return fake.regs[index];
+    default:
+        return fake.regs[index];
+    }
+}
+
+static void fakeWriteRegister(uint16_t index, uint8_t value)
+{
+    switch (fake.sensor) {
+    case FAKE_VL53L0X:
+        if (index == 0x00 && fake.regs[0xFF] != 0) {
+            // Page 1, not SYSRANGE_START
+            return;
+        }
+        if (index == 0x00) {
+            if (value & 0x02) {
+                fakeStartRanging();
+            } else if (value & 0x01) {
+                // Single measurement of the reference calibration, done at once
+                fake.regs[0x13] = 0x07;
+                fake.pending = true;
+            } else {
+                fake.ranging = false;
+            }
+            fake.regs[0x00] = value & ~0x01;
+            return;
+        }
+        if (index == 0x0B && (value & 0x01)) {
+            fake.regs[0x13] = 0x00;
+            fake.pending = false;
+            return;
+        }
+        if (index == 0x83 && value == 0x00) {
+            // SPAD info ready
+            fake.regs[0x83] = 0x10;
+            return;
+        }
+        break;
+    case FAKE_VL53L1X:
+        if (index == 0x87) {
+            if (value & 0x40) {
+                fakeStartRanging();
+            } else {
+                fake.ranging = false;
+            }
+        }
+        if (index == 0x86 && (value & 0x01)) {
+            fake.pending = false;
+        }
+        break;
+    case FAKE_SRF10:
+        if (index == 0x00) {
+            if (value == 0x51) {
+                fakeStartRanging();
+            }
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+
+    fake.regs[index] = value;
+}
+
+static bool fakeDataReadyPin(void)
+{
+    fakeAdvance();
+
+    if (fake.sensor == FAKE_VL53L1X) {
+        return fake.pending == fakeVl53l1xActiveLevel();
+    }
+
+    // VL53L0X GPIO1 is active low
+    return !fake.pending;
+}
+
+static void startSensor(rangefinderDev_t *dev, bool (*detect)(rangefinderDev_t *))
+{
+    memset(dev, 0, sizeof(*dev));
+    ASSERT_TRUE(detect(dev));
+    dev->init(dev);
+}
+
+typedef struct {
+    unsigned updates;
+    unsigned results;           // Updates reporting a new result
+    unsigned maxIdleTransactions;
+    unsigned maxResultTransactions;
+    uint64_t maxLatencyNs;
+    unsigned delays;
+    int32_t lastDistance;
+} taskStats_t;
+
+// Runs the update the way the scheduler does, at the period the driver asks for. The latency of a
+// result is up to that period and the transfers of the update reading it, well below a millisecond.
+static taskStats_t runTask(rangefinderDev_t *dev, uint64_t durationNs)
+{
+    taskStats_t stats = {};
+    const uint64_t endNs = fake.nowNs + durationNs;
+    const unsigned delays = fake.delays;
+    uint64_t nextUpdateNs = fake.nowNs;
+
+    while (nextUpdateNs < endNs) {
+        fake.nowNs = std::max(fake.nowNs, nextUpdateNs);
+        nextUpdateNs = fake.nowNs + MS2US(dev->delayMs) * 1000;
+        fakeAdvance();
+
+        const unsigned transactions = fake.transactions;
+
+        dev->update(dev);
+        const int32_t distance = dev->read(dev);
+
+        stats.updates++;
+
+        if (distance >= 0) {
+            stats.results++;
+            stats.lastDistance = distance;
+            stats.maxResultTransactions = std::max(stats.maxResultTransactions, fake.transactions - transactions);
+            if (fake.produced > 0) {
+                stats.maxLatencyNs = std::max(stats.maxLatencyNs, fake.nowNs - fake.readyNs);
+            }
+        } else {
+            stats.maxIdleTransactions = std::max(stats.maxIdleTransactions, fake.transactions - transactions);
+        }
+    }
+
+    stats.delays = fake.delays - delays;
+    return stats;
+}
+
+TEST(RangefinderTest, Vl53l1xReadsStatusAndRangeInOneBurst)
+{
+    rangefinderDev_t dev;
+    fakeReset(FAKE_VL53L1X, false);
+    startSensor(&dev, vl53l1xDetect);
+    EXPECT_EQ(0u, fake.delays);
+    EXPECT_TRUE(fake.ranging);
+
+    const taskStats_t stats = runTask(&dev, 2000000000ULL);
+
+    // Index, burst read of the result block and the interrupt clear
+    EXPECT_EQ(3u, stats.maxResultTransactions);
+    EXPECT_GE(stats.results + 1, fake.produced);
+    EXPECT_LE(stats.maxLatencyNs, MS2US(RANGEFINDER_VL53L1X_TASK_PERIOD_MS + 1) * 1000);
+    EXPECT_NEAR(FAKE_RANGE_MM / 10, stats.lastDistance, 1);
+
+    // Right after a result there's nothing new and nothing to clear
+    fake.transactions = 0;
+    dev.update(&dev);
+    EXPECT_EQ(2u, fake.transactions);
+    EXPECT_EQ(RANGEFINDER_NO_NEW_DATA, dev.read(&dev));
+}
+
+TEST(RangefinderTest, Vl53l1xDataReadyPin)
+{
+    rangefinderDev_t dev;
+    fakeReset(FAKE_VL53L1X, true);
+    startSensor(&dev, vl53l1xDetect);
+    EXPECT_LT(dev.delayMs, (timeMs_t)RANGEFINDER_VL53L1X_TASK_PERIOD_MS);
+
+    const taskStats_t stats = runTask(&dev, 2000000000ULL);
+
+    // Polling the pin costs nothing on the bus and a result is picked up within a poll
+    EXPECT_EQ(0u, stats.maxIdleTransactions);
+    EXPECT_EQ(3u, stats.maxResultTransactions);
+    EXPECT_GE(stats.results + 1, fake.produced);
+    EXPECT_LE(stats.maxLatencyNs, MS2US(dev.delayMs + 1) * 1000);
+    EXPECT_GT(stats.updates, 3 * stats.results);
+}
+
+TEST(RangefinderTest, Vl53l0xRangesContinuously)
+{
+    rangefinderDev_t dev;
+    fakeReset(FAKE_VL53L0X, false);
+    startSensor(&dev, vl53l0xDetect);
+    EXPECT_EQ(0u, fake.delays);
+    EXPECT_TRUE(fake.ranging);
+    EXPECT_EQ(1u, fake.starts);
+
+    const taskStats_t stats = runTask(&dev, 2000000000ULL);
+
+    // Ranging isn't started again, every update is a burst read and the clear if there was a result
+    EXPECT_EQ(1u, fake.starts);
+    EXPECT_EQ(2u, stats.maxResultTransactions);
+    EXPECT_LE(stats.maxIdleTransactions, 1u);
+    EXPECT_GE(stats.results + 1, fake.produced);
+    EXPECT_LE(stats.maxLatencyNs, MS2US(RANGEFINDER_VL53L0X_TASK_PERIOD_MS + 1) * 1000);
+}
+
+TEST(RangefinderTest, Vl53l0xDataReadyPin)
+{
+    rangefinderDev_t dev;
+    fakeReset(FAKE_VL53L0X, true);
+    startSensor(&dev, vl53l0xDetect);
+
+    const taskStats_t stats = runTask(&dev, 2000000000ULL);
+
+    EXPECT_EQ(1u, fake.starts);
+    EXPECT_EQ(0u, stats.maxIdleTransactions);
+    EXPECT_EQ(2u, stats.maxResultTransactions);
+    EXPECT_GE(stats.results + 1, fake.produced);
+    EXPECT_LE(stats.maxLatencyNs, MS2US(dev.delayMs + 1) * 1000);
+}
+
+TEST(RangefinderTest, Vl53l0xRestartsStalledRanging)
+{
+    rangefinderDev_t dev;
+    fakeReset(FAKE_VL53L0X, false);
+    startSensor(&dev, vl53l0xDetect);
+    runTask(&dev, 500000000ULL);
+
+    fake.ranging = false;
+    taskStats_t stats = runTask(&dev, 90000000ULL);
+    EXPECT_EQ(0u, stats.results);
+    EXPECT_EQ(1u, fake.starts);
+
+    // Ranging is started again once nothing came for the timeout
+    stats = runTask(&dev, 500000000ULL);
+    EXPECT_EQ(2u, fake.starts);
+    EXPECT_GT(stats.results, 10u);
+}
+
+TEST(RangefinderTest, Srf10ReadsStatusAndRangeTogether)
+{
+    rangefinderDev_t dev;
+    fakeReset(FAKE_SRF10, false);
+    startSensor(&dev, srf10Detect);
+    EXPECT_EQ(0u, fake.delays);
+
+    const taskStats_t stats = runTask(&dev, 2000000000ULL);
+
+    // One read and the next ping
+    EXPECT_EQ(2u, stats.maxResultTransactions);
+    EXPECT_EQ(stats.updates, fake.starts);
+    EXPECT_NEAR(FAKE_RANGE_MM / 10, dev.read(&dev), 1);
+}
+
+TEST(RangefinderTest, Us42WaitsForEcho)
+{
+    rangefinderDev_t dev;
+    fakeReset(FAKE_US42, false);
+    startSensor(&dev, us42Detect);
+    EXPECT_EQ(0u, fake.delays);
+
+    // Too early for the echo of the probe sent by init
+    fake.transactions = 0;
+    dev.update(&dev);
+    EXPECT_EQ(0u, fake.transactions);
+
+    const taskStats_t stats = runTask(&dev, 2000000000ULL);
+    EXPECT_EQ(2u, stats.maxResultTransactions);
+    EXPECT_NEAR(FAKE_RANGE_MM / 10, dev.read(&dev), 1);
+}
+
+TEST(RangefinderTest, NoDelays)
+{
+    struct {
+        const char *name;
+        fakeSensor_e sensor;
+        bool dataReadyPin;
+        bool (*detect)(rangefinderDev_t *);
+    } sensors[] = {
+        { "VL53L0X", FAKE_VL53L0X, false, vl53l0xDetect },
+        { "VL53L0X+INT", FAKE_VL53L0X, true, vl53l0xDetect },
+        { "VL53L1X", FAKE_VL53L1X, false, vl53l1xDetect },
+        { "VL53L1X+INT", FAKE_VL53L1X, true, vl53l1xDetect },
+        { "SRF10", FAKE_SRF10, false, srf10Detect },
+        { "US42", FAKE_US42, false, us42Detect },
+        { "TOF10120", FAKE_TOF10120, false, tof10120Detect },
+    };
+
+    for (const auto &sensor : sensors) {
+        SCOPED_TRACE(sensor.name);
+        rangefinderDev_t dev;
+        fakeReset(sensor.sensor, sensor.dataReadyPin);
+        startSensor(&dev, sensor.detect);
+        EXPECT_EQ(0u, fake.delays);
+
+        const taskStats_t stats = runTask(&dev, 10000000000ULL);
+        EXPECT_EQ(0u, stats.delays);
+        EXPECT_GT(stats.results, 0u);
+    }
+}
+
+// STUBS
+
+extern "C" {
+timeMs_t millis(void) { return fake.nowNs / 1000000; }
+void delay(timeMs_t ms)
+{
+    fake.delays++;
+    fake.nowNs += ms * 1000000ULL;
+}
+
+busDevice_t * busDeviceInit(busType_e, devHardwareType_e, uint8_t, resourceOwner_e) { return &fake.dev; }
+void busDeviceDeInit(busDevice_t *) {}
+
+bool busReadBuf(const busDevice_t * busdev, uint8_t reg, uint8_t * data, uint8_t length)
+{
+    const bool raw = (busdev->flags & DEVFLAGS_USE_RAW_REGISTERS) && reg == 0xFF;
+
+    // Address, register and address again before the data
+    fakeTransaction(raw ? length + 1 : length + 3);
+
+    for (int i = 0; i < length; i++) {
+        data[i] = fakeReadRegister(raw ? fake.index++ : reg + i);
+    }
+    return true;
+}
+
+bool busRead(const busDevice_t * busdev, uint8_t reg, uint8_t * data)
+{
+    return busReadBuf(busdev, reg, data, 1);
+}
+
+bool busWriteBuf(const busDevice_t * busdev, uint8_t reg, const uint8_t * data, uint8_t length)
+{
+    if ((busdev->flags & DEVFLAGS_USE_RAW_REGISTERS) && reg == 0xFF) {
+        // VL53L1X, 16 bit index first
+        fakeTransaction(length + 1);
+        fake.index = (data[0] << 8) | data[1];
+        for (int i = 2; i < length; i++) {
+            fakeWriteRegister(fake.index + i - 2, data[i]);
+        }
+        return true;
+    }
+
+    fakeTransaction(length + 2);
+
+    if (fake.sensor == FAKE_US42 && reg == 0x51) {
+        fakeStartRanging();
+        return true;
+    }
+
+    for (int i = 0; i < length; i++) {
+        fakeWriteRegister(reg + i, data[i]);
+    }
+    return true;
+}
+
+bool busWrite(const busDevice_t * busdev, uint8_t reg, uint8_t data)
+{
+    return busWriteBuf(busdev, reg, &data, 1);
+}
+
+void IOInit(IO_t, resourceOwner_e, resourceType_e, uint8_t) {}
+void IOConfigGPIO(IO_t, ioConfig_t) {}
+bool IORead(IO_t) { return fakeDataReadyPin(); }
+}
@@ -0,0 +1,264 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/bitarray.h"
+    #include "common/maths.h"
+
+    #include "config/feature.h"
+
+    #include "fc/rc_controls.h"
+    #include "fc/rc_modes.h"
+    #include "fc/runtime_config.h"
+
+    #include "rx/rx.h"
+
+    extern boxBitmask_t rcModeActivationMask;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_AUX_CHANNELS   8
+
+static int16_t rcData[MAX_SUPPORTED_RC_CHANNEL_COUNT];
+static uint32_t testSeed;
+
+static uint32_t testRandom(void)
+{
+    testSeed = testSeed * 1103515245 + 12345;
+    return testSeed >> 8;
+}
+
+static void setAuxChannel(int auxChannelIndex, int16_t value)
+{
+    rcData[auxChannelIndex + NON_AUX_CHANNEL_COUNT] = value;
+}
+
+static void setCondition(int index, boxId_e modeId, uint8_t auxChannelIndex, uint16_t startValue, uint16_t endValue)
+{
+    modeActivationCondition_t *condition = modeActivationConditionsMutable(index);
+    condition->modeId = modeId;
+    condition->auxChannelIndex = auxChannelIndex;
+    condition->range.startStep = CHANNEL_VALUE_TO_STEP(startValue);
+    condition->range.endStep = CHANNEL_VALUE_TO_STEP(endValue);
+}
+
+// All 40 conditions in use, five positions on each of eight switches
+static void setFullConfig(void)
+{
+    for (int index = 0; index < MAX_MODE_ACTIVATION_CONDITION_COUNT; index++) {
+        const int position = index % 5;
+        setCondition(index, (boxId_e)(index % CHECKBOX_ITEM_COUNT), index / 5, 900 + position * 240, 900 + (position + 1) * 240);
+    }
+    updateUsedModeActivationConditionFlags();
+}
+
+// Every condition of every mode checked against the channels, as the modes were worked out before the table
+static boxBitmask_t scanModes(void)
+{
+    boxBitmask_t mask;
+    memset(&mask, 0, sizeof(mask));
+
+    uint8_t specified[CHECKBOX_ITEM_COUNT] = { 0 };
+    uint8_t active[CHECKBOX_ITEM_COUNT] = { 0 };
+
+    for (int index = 0; index < MAX_MODE_ACTIVATION_CONDITION_COUNT; index++) {
+        const modeActivationCondition_t *condition = modeActivationConditions(index);
+        if (IS_RANGE_USABLE(&condition->range)) {
+            specified[condition->modeId]++;
+        }
+        if (isRangeActive(condition->auxChannelIndex, &condition->range)) {
+            active[condition->modeId]++;
+        }
+    }
+
+    for (int modeIndex = 0; modeIndex < CHECKBOX_ITEM_COUNT; modeIndex++) {
+        if (specified[modeIndex] == 0) {
+            continue;
+        }
+        if (modeActivationOperatorConfig()->modeActivationOperator == MODE_OPERATOR_AND ? active[modeIndex] == specified[modeIndex] : active[modeIndex] > 0) {
+            bitArraySet(mask.bits, modeIndex);
+        }
+    }
+
+    return mask;
+}
+
+class RcModesTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        memset(modeActivationConditionsMutable(0), 0, sizeof(modeActivationCondition_t) * MAX_MODE_ACTIVATION_CONDITION_COUNT);
+        modeActivationOperatorConfigMutable()->modeActivationOperator = MODE_OPERATOR_OR;
+        for (int channel = 0; channel < MAX_SUPPORTED_RC_CHANNEL_COUNT; channel++) {
+            rcData[channel] = 1500;
+        }
+        testSeed = 1;
+        updateUsedModeActivationConditionFlags();
+    }
+};
+
+TEST_F(RcModesTest, RangeEdges)
+{
+    setCondition(0, BOXANGLE, 0, 1300, 1700);
+    updateUsedModeActivationConditionFlags();
+
+    const struct {
+        int16_t value;
+        bool active;
+    } cases[] = {
+        { 1299, false }, { 1300, true }, { 1500, true }, { 1699, true }, { 1700, false },
+        { 800, false }, { 2200, false }, { 1300, true },
+    };
+
+    for (const auto &c : cases) {
+        setAuxChannel(0, c.value);
+        updateActivatedModes();
+        EXPECT_EQ(c.active, IS_RC_MODE_ACTIVE(BOXANGLE)) << "channel value " << c.value;
+    }
+}
+
+TEST_F(RcModesTest, OutOfBoundsValues)
+{
+    // A range can end past 2100, or start at 900 where values below 900 are still not in it
+    setCondition(0, BOXANGLE, 0, 900, 1000);
+    modeActivationConditionsMutable(1)->modeId = BOXHORIZON;
+    modeActivationConditionsMutable(1)->auxChannelIndex = 1;
+    modeActivationConditionsMutable(1)->range.startStep = 44;
+    modeActivationConditionsMutable(1)->range.endStep = 60;
+    updateUsedModeActivationConditionFlags();
+
+    setAuxChannel(0, 899);
+    setAuxChannel(1, 2300);
+    updateActivatedModes();
+    EXPECT_FALSE(IS_RC_MODE_ACTIVE(BOXANGLE));
+    EXPECT_TRUE(IS_RC_MODE_ACTIVE(BOXHORIZON));
+
+    setAuxChannel(0, 900);
+    setAuxChannel(1, 2400);
+    updateActivatedModes();
+    EXPECT_TRUE(IS_RC_MODE_ACTIVE(BOXANGLE));
+    EXPECT_FALSE(IS_RC_MODE_ACTIVE(BOXHORIZON));
+}
+
+TEST_F(RcModesTest, OperatorChangeIsApplied)
+{
+    setCondition(0, BOXANGLE, 0, 1300, 1700);
+    setCondition(1, BOXANGLE, 1, 1300, 1700);
+    updateUsedModeActivationConditionFlags();
+
+    setAuxChannel(1, 1000);
+    updateActivatedModes();
+    EXPECT_TRUE(IS_RC_MODE_ACTIVE(BOXANGLE));
+
+    // No channel moved
+    modeActivationOperatorConfigMutable()->modeActivationOperator = MODE_OPERATOR_AND;
+    updateActivatedModes();
+    EXPECT_FALSE(IS_RC_MODE_ACTIVE(BOXANGLE));
+}
+
+TEST_F(RcModesTest, ConfigChangeIsApplied)
+{
+    setCondition(0, BOXANGLE, 0, 1300, 1700);
+    updateUsedModeActivationConditionFlags();
+    updateActivatedModes();
+    EXPECT_TRUE(IS_RC_MODE_ACTIVE(BOXANGLE));
+
+    setCondition(0, BOXANGLE, 0, 1700, 2100);
+    updateUsedModeActivationConditionFlags();
+    updateActivatedModes();
+    EXPECT_FALSE(IS_RC_MODE_ACTIVE(BOXANGLE));
+}
+
+TEST_F(RcModesTest, MatchesScanOfAllConditions)
+{
+    for (int config = 0; config < 200; config++) {
+        // Overlapping, duplicated and unusable ranges, several conditions on one mode
+        for (int index = 0; index < MAX_MODE_ACTIVATION_CONDITION_COUNT; index++) {
+            modeActivationCondition_t *condition = modeActivationConditionsMutable(index);
+            condition->modeId = (boxId_e)(testRandom() % 12);
+            condition->auxChannelIndex = testRandom() % TEST_AUX_CHANNELS;
+            condition->range.startStep = testRandom() % (MAX_MODE_RANGE_STEP + 1);
+            condition->range.endStep = testRandom() % (MAX_MODE_RANGE_STEP + 1);
+        }
+        modeActivationOperatorConfigMutable()->modeActivationOperator = (config & 1) ? MODE_OPERATOR_AND : MODE_OPERATOR_OR;
+        updateUsedModeActivationConditionFlags();
+
+        for (int frame = 0; frame < 200; frame++) {
+            const int channel = testRandom() % TEST_AUX_CHANNELS;
+            if (testRandom() % 4 == 0) {
+                setAuxChannel(channel, 850 + testRandom() % 1300);
+            } else {
+                // Small movements, mostly within one step
+                setAuxChannel(channel, rcData[channel + NON_AUX_CHANNEL_COUNT] + (int)(testRandom() % 21) - 10);
+            }
+
+            updateActivatedModes();
+
+            const boxBitmask_t expected = scanModes();
+            ASSERT_EQ(0, memcmp(&expected, &rcModeActivationMask, sizeof(expected))) << "config " << config << " frame " << frame;
+        }
+    }
+}
+
+// All conditions in use, every switch moved through its positions with receiver noise on top
+TEST_F(RcModesTest, FullConfigMatchesScan)
+{
+    setFullConfig();
+    testSeed = 1;
+
+    for (int frame = 0; frame < 1000; frame++) {
+        for (int channel = 0; channel < TEST_AUX_CHANNELS; channel++) {
+            const int16_t position = (frame / (channel + 1) + channel) % 5;
+            setAuxChannel(channel, 1020 + position * 240 + (int)(testRandom() % 5) - 2);
+        }
+
+        updateActivatedModes();
+
+        const boxBitmask_t expected = scanModes();
+        ASSERT_EQ(0, memcmp(&expected, &rcModeActivationMask, sizeof(expected))) << "frame " << frame;
+    }
+}
+
+// STUBS
+
+extern "C" {
+
+uint32_t armingFlags;
+uint32_t stateFlags;
+int16_t rcCommand[4];
+rcControlsConfig_t rcControlsConfig_System;
+
+bool feature(uint32_t mask)
+{
+    UNUSED(mask);
+    return false;
+}
+
+int16_t rxGetChannelValue(unsigned channelNumber)
+{
+    return rcData[channelNumber];
+}
+
+}
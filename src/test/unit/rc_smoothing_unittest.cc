@@ -0,0 +1,265 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/maths.h"
+
+    #include "fc/config.h"
+    #include "fc/rc_controls.h"
+    #include "fc/rc_smoothing.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/mixer.h"
+
+    #include "rx/rx.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define TEST_LOOPTIME_US        1000
+#define TEST_FRAME_PERIOD_US    6666        // 150Hz CRSF
+#define TEST_WARMUP_US          1000000
+#define TEST_DURATION_US        4000000
+#define TEST_THROTTLE_IDLE      1150
+
+static timeUs_t testFrameTimeUs;
+
+typedef struct simulation_s {
+    bool frameTimestamps;       // Driver stamps the frames, otherwise the RX task time is used
+    timeDelta_t maxJitterUs;    // RX task picks up a frame up to this late
+    uint16_t minUpdateFrequency;
+    uint16_t maxUpdateFrequency;
+    std::vector<int16_t> output;
+} simulation_t;
+
+static float stickAt(timeUs_t timeUs)
+{
+    return 400 * sinf(2 * M_PIf * 2 * US2S(timeUs));
+}
+
+// Feeds a 150Hz frame stream through the smoothing, PID loop at 1kHz. Output is kept after the warmup.
+static void simulate(simulation_t *sim)
+{
+    uint32_t seed = 12345;
+    timeUs_t frameEndUs = 333;
+    timeUs_t pickupAtUs = frameEndUs;
+
+    sim->minUpdateFrequency = UINT16_MAX;
+    sim->maxUpdateFrequency = 0;
+    sim->output.clear();
+
+    for (timeUs_t now = 0; now < TEST_WARMUP_US + TEST_DURATION_US; now += TEST_LOOPTIME_US) {
+        bool isRXDataNew = false;
+
+        if (now >= pickupAtUs) {
+            rcCommand[ROLL] = lrintf(stickAt(frameEndUs));
+            testFrameTimeUs = sim->frameTimestamps ? frameEndUs : now;
+            isRXDataNew = true;
+
+            frameEndUs += TEST_FRAME_PERIOD_US;
+            seed = seed * 1103515245 + 12345;
+            pickupAtUs = frameEndUs + (sim->maxJitterUs ? (seed >> 8) % sim->maxJitterUs : 0);
+        }
+
+        rcInterpolationApply(isRXDataNew, now);
+
+        if (now >= TEST_WARMUP_US) {
+            sim->output.push_back(rcCommand[ROLL]);
+            sim->minUpdateFrequency = MIN(sim->minUpdateFrequency, getRcUpdateFrequency());
+            sim->maxUpdateFrequency = MAX(sim->maxUpdateFrequency, getRcUpdateFrequency());
+        }
+    }
+}
+
+// RMS change of the output caused by the jitter of the RX task
+static float outputJitter(bool frameTimestamps, bool extrapolation)
+{
+    rxConfigMutable()->rcFilterExtrapolation = extrapolation;
+
+    simulation_t reference = { frameTimestamps, 0, 0, 0, {} };
+    simulation_t jittered = { frameTimestamps, 3000, 0, 0, {} };
+    simulate(&reference);
+    simulate(&jittered);
+
+    float sum = 0;
+    for (size_t i = 0; i < reference.output.size(); i++) {
+        sum += sq((float)jittered.output[i] - reference.output[i]);
+    }
+    return sqrtf(sum / reference.output.size());
+}
+
+class RcSmoothingTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        rxConfigMutable()->rcFilterFrequency = 50;
+        rxConfigMutable()->autoSmooth = 1;
+        rxConfigMutable()->autoSmoothFactor = 30;
+        rxConfigMutable()->rcFilterExtrapolation = 0;
+        motorConfigMutable()->maxthrottle = 1850;
+        flightModeFlags = 0;
+    }
+};
+
+TEST_F(RcSmoothingTest, UpdateRateComesFromFrameTimes)
+{
+    simulation_t sim = { true, 3000, 0, 0, {} };
+    simulate(&sim);
+
+    EXPECT_EQ(150, sim.minUpdateFrequency);
+    EXPECT_EQ(150, sim.maxUpdateFrequency);
+
+    // Times of the RX task wander with the scheduler
+    sim.frameTimestamps = false;
+    simulate(&sim);
+
+    EXPECT_LT(sim.minUpdateFrequency, 150);
+    EXPECT_GT(sim.maxUpdateFrequency, 150);
+}
+
+TEST_F(RcSmoothingTest, RxTaskWithoutNewFrameIsNoUpdate)
+{
+    simulation_t sim = { true, 0, 0, 0, {} };
+    simulate(&sim);
+    ASSERT_EQ(150, getRcUpdateFrequency());
+
+    // RX task running on its 10Hz timeout, with the channels of the last frame
+    for (int i = 0; i < 20; i++) {
+        rcInterpolationApply(true, TEST_WARMUP_US + TEST_DURATION_US + i * 100000);
+    }
+
+    EXPECT_EQ(150, getRcUpdateFrequency());
+}
+
+TEST_F(RcSmoothingTest, ExtrapolationRemovesRxTaskJitter)
+{
+    const float taskTimeJitter = outputJitter(false, false);
+    const float frameTimeJitter = outputJitter(true, false);
+    const float extrapolatedJitter = outputJitter(true, true);
+
+    // Without extrapolation the sticks still step when the RX task picks a frame up, frame times only steady the update rate
+    EXPECT_LT(extrapolatedJitter, taskTimeJitter / 3);
+    EXPECT_LT(extrapolatedJitter, frameTimeJitter / 3);
+}
+
+TEST_F(RcSmoothingTest, ExtrapolationStopsAfterOneFramePeriod)
+{
+    rxConfigMutable()->rcFilterExtrapolation = 1;
+
+    simulation_t sim = { true, 0, 0, 0, {} };
+    simulate(&sim);
+
+    // Frames stop arriving in the middle of a stick movement, the stick is held one frame further on
+    const timeUs_t lastFrameUs = testFrameTimeUs;
+    const float heldStick = 2 * stickAt(lastFrameUs) - stickAt(lastFrameUs - TEST_FRAME_PERIOD_US);
+
+    timeUs_t now = TEST_WARMUP_US + TEST_DURATION_US;
+    for (int i = 0; i < 500; i++, now += TEST_LOOPTIME_US) {
+        rcInterpolationApply(false, now);
+    }
+
+    EXPECT_NEAR(heldStick, rcCommand[ROLL], 2);
+}
+
+TEST_F(RcSmoothingTest, NoExtrapolationInFailsafe)
+{
+    rxConfigMutable()->rcFilterExtrapolation = 1;
+
+    simulation_t sim = { true, 0, 0, 0, {} };
+    simulate(&sim);
+
+    // Failsafe takes over the sticks, the step to the failsafe value is not carried on
+    flightModeFlags |= FAILSAFE_MODE;
+    timeUs_t now = TEST_WARMUP_US + TEST_DURATION_US;
+    testFrameTimeUs += TEST_FRAME_PERIOD_US;
+    rcCommand[ROLL] = 0;
+    for (int i = 0; i < 500; i++, now += TEST_LOOPTIME_US) {
+        rcInterpolationApply(i == 0, now);
+    }
+
+    EXPECT_EQ(0, rcCommand[ROLL]);
+}
+
+TEST_F(RcSmoothingTest, ExtrapolationStaysInRcCommandRange)
+{
+    rxConfigMutable()->rcFilterExtrapolation = 1;
+
+    simulation_t sim = { true, 0, 0, 0, {} };
+    simulate(&sim);
+
+    // Sticks step from the center and idle into full deflection and are held there
+    timeUs_t now = TEST_WARMUP_US + TEST_DURATION_US;
+    int16_t maxRoll = INT16_MIN;
+    int16_t minPitch = INT16_MAX;
+    int16_t maxThrottle = INT16_MIN;
+    for (int frame = 0; frame < 100; frame++) {
+        rcCommand[ROLL] = frame < 10 ? 0 : 500;
+        rcCommand[PITCH] = frame < 10 ? 0 : -500;
+        rcCommand[THROTTLE] = frame < 10 ? TEST_THROTTLE_IDLE : motorConfig()->maxthrottle;
+        testFrameTimeUs = now;
+
+        for (int i = 0; i < TEST_FRAME_PERIOD_US / TEST_LOOPTIME_US; i++, now += TEST_LOOPTIME_US) {
+            rcInterpolationApply(i == 0, now);
+            maxRoll = MAX(maxRoll, rcCommand[ROLL]);
+            minPitch = MIN(minPitch, rcCommand[PITCH]);
+            maxThrottle = MAX(maxThrottle, rcCommand[THROTTLE]);
+        }
+    }
+
+    EXPECT_LE(maxRoll, 500);
+    EXPECT_GE(minPitch, -500);
+    EXPECT_LE(maxThrottle, motorConfig()->maxthrottle);
+
+    EXPECT_NEAR(500, rcCommand[ROLL], 1);
+    EXPECT_NEAR(-500, rcCommand[PITCH], 1);
+    EXPECT_NEAR(motorConfig()->maxthrottle, rcCommand[THROTTLE], 1);
+}
+
+// STUBS
+
+extern "C" {
+
+int16_t rcCommand[4];
+uint32_t flightModeFlags;
+rxConfig_t rxConfig_System;
+motorConfig_t motorConfig_System;
+
+uint32_t getLooptime(void)
+{
+    return TEST_LOOPTIME_US;
+}
+
+int getThrottleIdleValue(void)
+{
+    return TEST_THROTTLE_IDLE;
+}
+
+timeUs_t rxGetFrameTimeUs(void)
+{
+    return testFrameTimeUs;
+}
+
+}
@@ -0,0 +1,168 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "rx/rx_latency.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+TEST(RxLatencyTest, NoSamples)
+{
+    rxLatencyReset();
+
+    rxLatencyStats_t stats;
+    rxLatencyGetStats(&stats);
+    EXPECT_EQ(0u, stats.sampleCount);
+    EXPECT_EQ(0u, stats.minUs);
+    EXPECT_EQ(0u, stats.p99Us);
+
+    // Motor updates without a frame behind them aren't measured
+    rxLatencyMotorsMixed();
+    rxLatencyMotorsUpdated(1000);
+    rxLatencyGetStats(&stats);
+    EXPECT_EQ(0u, stats.sampleCount);
+}
+
+TEST(RxLatencyTest, MeasuresFirstMotorUpdateAfterMix)
+{
+    rxLatencyReset();
+
+    rxLatencyFrameReceived(1000);
+
+    // DShot update going out before the mixer has seen the frame
+    rxLatencyMotorsUpdated(1200);
+
+    rxLatencyMotorsMixed();
+    rxLatencyMotorsUpdated(1800);
+    // Later updates carry the same frame, only the first one counts
+    rxLatencyMotorsUpdated(2300);
+
+    rxLatencyStats_t stats;
+    rxLatencyGetStats(&stats);
+    EXPECT_EQ(1u, stats.sampleCount);
+    EXPECT_EQ(800u, stats.minUs);
+    EXPECT_EQ(800u, stats.avgUs);
+    EXPECT_EQ(800u, stats.p99Us);
+    EXPECT_EQ(800u, stats.maxUs);
+}
+
+TEST(RxLatencyTest, OlderFrameIsMeasuredWhenMixesQueueUp)
+{
+    rxLatencyReset();
+
+    rxLatencyFrameReceived(1000);
+    rxLatencyMotorsMixed();
+    rxLatencyFrameReceived(1500);
+    rxLatencyMotorsMixed();
+    rxLatencyMotorsUpdated(2000);
+
+    rxLatencyStats_t stats;
+    rxLatencyGetStats(&stats);
+    EXPECT_EQ(1u, stats.sampleCount);
+    EXPECT_EQ(1000u, stats.maxUs);
+}
+
+TEST(RxLatencyTest, TimerWrap)
+{
+    rxLatencyReset();
+
+    rxLatencyFrameReceived((timeUs_t)-300);
+    rxLatencyMotorsMixed();
+    rxLatencyMotorsUpdated(200);
+
+    rxLatencyStats_t stats;
+    rxLatencyGetStats(&stats);
+    EXPECT_EQ(1u, stats.sampleCount);
+    EXPECT_EQ(500u, stats.minUs);
+}
+
+TEST(RxLatencyTest, Percentile)
+{
+    rxLatencyReset();
+
+    timeUs_t now = 0;
+    for (int i = 0; i < 1000; i++) {
+        const uint32_t latencyUs = (i % 100 == 0) ? 3000 : 520;
+        rxLatencyFrameReceived(now);
+        rxLatencyMotorsMixed();
+        rxLatencyMotorsUpdated(now + latencyUs);
+        now += 5000;
+    }
+
+    rxLatencyStats_t stats;
+    rxLatencyGetStats(&stats);
+    EXPECT_EQ(1000u, stats.sampleCount);
+    EXPECT_EQ(520u, stats.minUs);
+    EXPECT_EQ(3000u, stats.maxUs);
+    EXPECT_EQ((990u * 520 + 10 * 3000) / 1000, stats.avgUs);
+    // 1% of the samples are slow, p99 still lands in the 500-550us bin
+    EXPECT_EQ(550u, stats.p99Us);
+
+    for (int i = 0; i < 10; i++) {
+        rxLatencyFrameReceived(now);
+        rxLatencyMotorsMixed();
+        rxLatencyMotorsUpdated(now + 3000);
+        now += 5000;
+    }
+
+    rxLatencyGetStats(&stats);
+    EXPECT_EQ(3000u, stats.p99Us);
+}
+
+TEST(RxLatencyTest, InjectedFrames)
+{
+    rxLatencyReset();
+
+    // 250Hz frames against a 1kHz loop with the RX task picking frames up after 100us, mixer runs every loop
+    // and DShot goes out 50us after the mix
+    const timeUs_t loopUs = 1000;
+    timeUs_t nextFrameUs = 130;
+    timeUs_t frameUs = 0;
+    bool framePending = false;
+    uint32_t frames = 0;
+
+    for (timeUs_t now = 0; now < 2000000; now += loopUs) {
+        if (framePending) {
+            rxLatencyFrameReceived(frameUs);
+            framePending = false;
+        }
+        if (now >= nextFrameUs + 100) {
+            frameUs = nextFrameUs;
+            framePending = true;
+            nextFrameUs += 4000;
+            frames++;
+        }
+
+        rxLatencyMotorsMixed();
+        rxLatencyMotorsUpdated(now + 50);
+    }
+
+    rxLatencyStats_t stats;
+    rxLatencyGetStats(&stats);
+    EXPECT_GE(stats.sampleCount, frames - 1);
+    // Picked up at the first loop at least 100us after the frame, processed there and mixed in the next one
+    EXPECT_EQ(1920u, stats.minUs);
+    EXPECT_EQ(1920u, stats.maxUs);
+    EXPECT_EQ(1920u, stats.avgUs);
+}
@@ -0,0 +1,662 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "drivers/bus.h"
+    #include "drivers/io.h"
+    #include "drivers/time.h"
+    #include "drivers/sdcard/sdcard.h"
+    #include "drivers/sdcard/sdcard_impl.h"
+    #include "drivers/sdcard/sdcard_standard.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+/*
+ * A high capacity card in SPI mode, byte by byte, backed by a disk image in a temporary file. The
+ * bus keeps the time: every byte takes as long as it does at 20MHz and every transaction costs the
+ * CPU a couple of microseconds to set up. After accepting a block, or the stop token of a
+ * multi-block write, the card holds its output low for a while.
+ */
+#define FAKE_SPI_BYTE_NS            400ULL          // 8 bits at 20MHz
+#define FAKE_TRANSACTION_NS         2000ULL
+#define FAKE_START_NS               100000000000ULL // 100s
+#define FAKE_CARD_BLOCKS            2048            // 1MB, a multiple of the 512kB CSD v2 size unit
+#define FAKE_POLL_US                1000            // Period of the task calling sdcard_poll()
+
+typedef enum {
+    FAKE_MODE_COMMAND,
+    FAKE_MODE_WRITE_TOKEN,
+    FAKE_MODE_WRITE_DATA,
+} fakeMode_e;
+
+static struct {
+    busDevice_t dev;
+    FILE *image;
+    bool selected;
+    uint64_t nowNs;
+
+    // Timing of the card
+    uint64_t readLatencyNs;
+    uint64_t writeBusyNs;
+    uint64_t multiWriteBusyNs;
+    uint64_t stopBusyNs;
+
+    // Protocol state
+    fakeMode_e mode;
+    uint8_t command[6];
+    int commandLength;
+    bool appCommand;
+    bool idle;
+    int initAttempts;           // ACMD41 still answered with idle this many times
+    bool multiWrite;
+    uint32_t writeBlock;
+    uint8_t block[SDCARD_BLOCK_SIZE + 2];
+    int blockLength;
+
+    uint8_t response[SDCARD_BLOCK_SIZE + 8];
+    int responseLength;
+    int responsePos;
+    uint64_t busyAfterResponseNs;   // The card goes busy once the response is out
+    uint64_t busyUntilNs;
+
+    uint8_t data[SDCARD_BLOCK_SIZE];
+    int dataLength;
+    bool dataPending;
+    uint64_t dataReadyNs;
+
+    // Bookkeeping
+    unsigned transactions;
+    unsigned bytes;
+    unsigned busyBytes;
+    unsigned blocksWritten;
+    unsigned busyPeriods;
+    uint64_t busyNs;
+    uint64_t maxIdleGapNs;          // From the end of a busy period to the next block of the multi-block write
+    unsigned protocolErrors;
+} fake;
+
+static void fakeSetBits(uint8_t *buffer, unsigned offset, unsigned length, uint32_t value)
+{
+    for (unsigned i = 0; i < length; i++) {
+        const unsigned bit = offset + i;
+        if ((value >> (length - 1 - i)) & 1) {
+            buffer[bit / 8] |= 0x80 >> (bit % 8);
+        }
+    }
+}
+
+static void fakeReset(void)
+{
+    if (fake.image) {
+        fclose(fake.image);
+    }
+
+    memset(&fake, 0, sizeof(fake));
+    fake.nowNs = FAKE_START_NS;
+    fake.readLatencyNs = 300000;
+    fake.writeBusyNs = 1500000;
+    fake.multiWriteBusyNs = 700000;
+    fake.stopBusyNs = 1000000;
+    fake.initAttempts = 3;
+
+    fake.image = tmpfile();
+    fseek(fake.image, FAKE_CARD_BLOCKS * SDCARD_BLOCK_SIZE - 1, SEEK_SET);
+    fputc(0, fake.image);
+    fflush(fake.image);
+}
+
+static void fakeImageAccess(uint32_t blockIndex, uint8_t *buffer, bool write)
+{
+    fseek(fake.image, (long)blockIndex * SDCARD_BLOCK_SIZE, SEEK_SET);
+    if (write) {
+        fwrite(buffer, SDCARD_BLOCK_SIZE, 1, fake.image);
+    } else {
+        EXPECT_EQ(1u, fread(buffer, SDCARD_BLOCK_SIZE, 1, fake.image));
+    }
+}
+
+static void fakeRespond(uint8_t byte)
+{
+    fake.response[fake.responseLength++] = byte;
+}
+
+// Data block sent by the card once it's ready
+static void fakeQueueData(const uint8_t *data, int length, uint64_t latencyNs)
+{
+    memcpy(fake.data, data, length);
+    fake.dataLength = length;
+    fake.dataPending = true;
+    fake.dataReadyNs = fake.nowNs + latencyNs;
+}
+
+static void fakeExecuteCommand(void)
+{
+    const uint8_t index = fake.command[0] & 0x3F;
+    const uint32_t arg = (fake.command[1] << 24) | (fake.command[2] << 16) | (fake.command[3] << 8) | fake.command[4];
+    const bool appCommand = fake.appCommand;
+    const uint8_t idle = fake.idle ? SDCARD_R1_STATUS_BIT_IDLE : 0;
+
+    fake.appCommand = false;
+
+    // One byte of N_CR before the response
+    fakeRespond(0xFF);
+
+    if (appCommand && index == SDCARD_ACOMMAND_SEND_OP_COND) {
+        if (fake.initAttempts > 0) {
+            fake.initAttempts--;
+        } else {
+            fake.idle = false;
+        }
+        fakeRespond(fake.idle ? SDCARD_R1_STATUS_BIT_IDLE : 0);
+        return;
+    }
+
+    if (appCommand && index == SDCARD_ACOMMAND_SET_WR_BLOCK_ERASE_COUNT) {
+        fakeRespond(0);
+        return;
+    }
+
+    switch (index) {
+        case SDCARD_COMMAND_GO_IDLE_STATE:
+            fake.idle = true;
+            fake.initAttempts = 3;
+            fake.mode = FAKE_MODE_COMMAND;
+            fake.dataPending = false;
+            fakeRespond(SDCARD_R1_STATUS_BIT_IDLE);
+        break;
+
+        case SDCARD_COMMAND_SEND_IF_COND:
+            fakeRespond(idle);
+            fakeRespond(0);
+            fakeRespond(0);
+            fakeRespond((arg >> 8) & 0x0F);
+            fakeRespond(arg & 0xFF);
+        break;
+
+        case SDCARD_COMMAND_APP_CMD:
+            fake.appCommand = true;
+            fakeRespond(idle);
+        break;
+
+        case SDCARD_COMMAND_READ_OCR:
+            // Powered up, high capacity
+            fakeRespond(idle);
+            fakeRespond(0xC0);
+            fakeRespond(0xFF);
+            fakeRespond(0x80);
+            fakeRespond(0x00);
+        break;
+
+        case SDCARD_COMMAND_SEND_CSD: {
+            uint8_t csd[16] = { 0 };
+            fakeSetBits(csd, SDCARD_CSD_V2_CSD_STRUCTURE_VER_OFFSET, SDCARD_CSD_V2_CSD_STRUCTURE_VER_LEN, SDCARD_CSD_STRUCTURE_VERSION_2);
+            fakeSetBits(csd, SDCARD_CSD_V2_CSIZE_OFFSET, SDCARD_CSD_V2_CSIZE_LEN, FAKE_CARD_BLOCKS / 1024 - 1);
+            fakeSetBits(csd, SDCARD_CSD_V2_TRAILER_OFFSET, SDCARD_CSD_V2_TRAILER_LEN, 1);
+            fakeRespond(0);
+            fakeQueueData(csd, sizeof(csd), 0);
+        }
+        break;
+
+        case SDCARD_COMMAND_SEND_CID: {
+            const uint8_t cid[16] = { 0x1B, 'S', 'M', 'F', 'A', 'K', 'E', '1', 0x10, 0x12, 0x34, 0x56, 0x78, 0x01, 0x7A, 0x01 };
+            fakeRespond(0);
+            fakeQueueData(cid, sizeof(cid), 0);
+        }
+        break;
+
+        case SDCARD_COMMAND_SET_BLOCKLEN:
+            fakeRespond(0);
+        break;
+
+        case SDCARD_COMMAND_READ_SINGLE_BLOCK:
+            if (arg >= FAKE_CARD_BLOCKS) {
+                fakeRespond(SDCARD_R1_STATUS_BIT_ADDRESS_ERROR);
+                break;
+            }
+            fakeRespond(0);
+            fakeImageAccess(arg, fake.data, false);
+            fakeQueueData(fake.data, SDCARD_BLOCK_SIZE, fake.readLatencyNs);
+        break;
+
+        case SDCARD_COMMAND_WRITE_BLOCK:
+        case SDCARD_COMMAND_WRITE_MULTIPLE_BLOCK:
+            if (arg >= FAKE_CARD_BLOCKS) {
+                fakeRespond(SDCARD_R1_STATUS_BIT_ADDRESS_ERROR);
+                break;
+            }
+            fakeRespond(0);
+            fake.multiWrite = index == SDCARD_COMMAND_WRITE_MULTIPLE_BLOCK;
+            fake.writeBlock = arg;
+            fake.mode = FAKE_MODE_WRITE_TOKEN;
+        break;
+
+        default:
+            fakeRespond(idle | SDCARD_R1_STATUS_BIT_ILLEGAL_COMMAND);
+    }
+}
+
+static void fakeReceiveByte(uint8_t in)
+{
+    switch (fake.mode) {
+        case FAKE_MODE_COMMAND:
+            if (fake.commandLength == 0 && (in & 0xC0) != 0x40) {
+                break;
+            }
+            fake.command[fake.commandLength++] = in;
+            if (fake.commandLength == sizeof(fake.command)) {
+                fake.commandLength = 0;
+                fakeExecuteCommand();
+            }
+        break;
+
+        case FAKE_MODE_WRITE_TOKEN:
+            if (in == 0xFF) {
+                break;
+            }
+            if (in == (fake.multiWrite ? SDCARD_MULTIPLE_BLOCK_WRITE_START_TOKEN : SDCARD_SINGLE_BLOCK_WRITE_START_TOKEN)) {
+                if (fake.multiWrite && fake.busyUntilNs) {
+                    fake.maxIdleGapNs = std::max(fake.maxIdleGapNs, fake.nowNs - fake.busyUntilNs);
+                }
+                fake.blockLength = 0;
+                fake.mode = FAKE_MODE_WRITE_DATA;
+            } else if (fake.multiWrite && in == SDCARD_MULTIPLE_BLOCK_WRITE_STOP_TOKEN) {
+                // One byte of N_BR, then busy
+                fakeRespond(0xFF);
+                fake.busyAfterResponseNs = fake.stopBusyNs;
+                fake.mode = FAKE_MODE_COMMAND;
+            } else {
+                fake.protocolErrors++;
+            }
+        break;
+
+        case FAKE_MODE_WRITE_DATA:
+            fake.block[fake.blockLength++] = in;
+            if (fake.blockLength == sizeof(fake.block)) {
+                fakeImageAccess(fake.writeBlock++, fake.block, true);
+                fake.blocksWritten++;
+                fakeRespond(0xE5);     // Data accepted
+                fake.busyAfterResponseNs = fake.multiWrite ? fake.multiWriteBusyNs : fake.writeBusyNs;
+                fake.mode = fake.multiWrite ? FAKE_MODE_WRITE_TOKEN : FAKE_MODE_COMMAND;
+            }
+        break;
+    }
+}
+
+static uint8_t fakeClockByte(uint8_t in)
+{
+    fake.nowNs += FAKE_SPI_BYTE_NS;
+    fake.bytes++;
+
+    if (!fake.selected) {
+        return 0xFF;
+    }
+
+    if (fake.nowNs < fake.busyUntilNs) {
+        fake.busyBytes++;
+        if (in != 0xFF) {
+            fake.protocolErrors++;
+        }
+        return 0x00;
+    }
+
+    uint8_t out = 0xFF;
+
+    if (fake.responsePos == fake.responseLength && fake.dataPending && fake.nowNs >= fake.dataReadyNs) {
+        fake.responsePos = fake.responseLength = 0;
+        fakeRespond(SDCARD_SINGLE_BLOCK_READ_START_TOKEN);
+        for (int i = 0; i < fake.dataLength; i++) {
+            fakeRespond(fake.data[i]);
+        }
+        fakeRespond(0x12);
+        fakeRespond(0x34);
+        fake.dataPending = false;
+    }
+
+    if (fake.responsePos < fake.responseLength) {
+        out = fake.response[fake.responsePos++];
+
+        if (fake.responsePos == fake.responseLength) {
+            fake.responsePos = fake.responseLength = 0;
+
+            if (fake.busyAfterResponseNs) {
+                fake.busyUntilNs = fake.nowNs + fake.busyAfterResponseNs;
+                fake.busyNs += fake.busyAfterResponseNs;
+                fake.busyPeriods++;
+                fake.busyAfterResponseNs = 0;
+            }
+        }
+    }
+
+    fakeReceiveByte(in);
+
+    return out;
+}
+
+typedef struct {
+    unsigned count;
+    uint32_t blockIndex;
+    uint8_t *buffer;
+} completion_t;
+
+static completion_t readCompletion;
+static completion_t writeCompletion;
+
+static void operationComplete(sdcardBlockOperation_e operation, uint32_t blockIndex, uint8_t *buffer, uint32_t callbackData)
+{
+    UNUSED(callbackData);
+
+    completion_t *completion = operation == SDCARD_BLOCK_OPERATION_READ ? &readCompletion : &writeCompletion;
+    completion->count++;
+    completion->blockIndex = blockIndex;
+    completion->buffer = buffer;
+}
+
+static void fakeTick(void)
+{
+    fake.nowNs += FAKE_POLL_US * 1000ULL;
+}
+
+static void startCard(void)
+{
+    fakeReset();
+    memset(&readCompletion, 0, sizeof(readCompletion));
+    memset(&writeCompletion, 0, sizeof(writeCompletion));
+
+    sdcard_init();
+
+    for (int i = 0; i < 100 && !sdcard_isInitialized(); i++) {
+        sdcard_poll();
+        fakeTick();
+    }
+
+    ASSERT_TRUE(sdcard_isInitialized());
+}
+
+static bool pollUntilReady(int maxTicks)
+{
+    for (int i = 0; i < maxTicks; i++) {
+        if (sdcard_poll() && sdcard.state == SDCARD_STATE_READY) {
+            return true;
+        }
+        fakeTick();
+    }
+    return false;
+}
+
+static void fillPattern(uint8_t *buffer, uint32_t seed)
+{
+    for (int i = 0; i < SDCARD_BLOCK_SIZE; i++) {
+        buffer[i] = (uint8_t)(seed * 31 + i * 7 + (i >> 8));
+    }
+}
+
+TEST(SdcardSpiTest, Initialises)
+{
+    startCard();
+
+    const sdcardMetadata_t *metadata = sdcard_getMetadata();
+    EXPECT_EQ((uint32_t)FAKE_CARD_BLOCKS, metadata->numBlocks);
+    EXPECT_EQ(0x1B, metadata->manufacturerID);
+    EXPECT_EQ(0, memcmp("FAKE1", metadata->productName, 5));
+    EXPECT_TRUE(sdcard.highCapacity);
+    EXPECT_EQ(0u, fake.protocolErrors);
+}
+
+TEST(SdcardSpiTest, ReadsBlocksWhereverTheTokenFallsInTheBurst)
+{
+    startCard();
+
+    // Data tokens at every offset of the first burst, and just past it
+    for (int latencyBytes = 0; latencyBytes < 16; latencyBytes++) {
+        uint8_t expected[SDCARD_BLOCK_SIZE];
+        uint8_t buffer[SDCARD_BLOCK_SIZE];
+        const uint32_t blockIndex = 10 + latencyBytes;
+
+        fillPattern(expected, blockIndex);
+        fakeImageAccess(blockIndex, expected, true);
+        memset(buffer, 0, sizeof(buffer));
+
+        fake.readLatencyNs = latencyBytes * FAKE_SPI_BYTE_NS;
+
+        readCompletion.count = 0;
+        ASSERT_TRUE(sdcard_readBlock(blockIndex, buffer, operationComplete, 0));
+
+        // Poll straight away so the token isn't waiting at the start of the burst already
+        sdcard_poll();
+        for (int i = 0; i < 5 && readCompletion.count == 0; i++) {
+            fakeTick();
+            sdcard_poll();
+        }
+
+        ASSERT_EQ(1u, readCompletion.count) << "latency " << latencyBytes;
+        EXPECT_EQ(buffer, readCompletion.buffer);
+        EXPECT_EQ(0, memcmp(expected, buffer, sizeof(buffer))) << "latency " << latencyBytes;
+        EXPECT_EQ(SDCARD_STATE_READY, sdcard.state);
+    }
+
+    EXPECT_EQ(16u, sdcard_getStats()->blocksRead);
+    EXPECT_EQ(0u, fake.protocolErrors);
+}
+
+TEST(SdcardSpiTest, SingleBlockWriteReachesTheImage)
+{
+    startCard();
+
+    uint8_t buffer[SDCARD_BLOCK_SIZE];
+    uint8_t image[SDCARD_BLOCK_SIZE];
+    fillPattern(buffer, 77);
+
+    EXPECT_EQ(SDCARD_OPERATION_IN_PROGRESS, sdcard_writeBlock(77, buffer, operationComplete, 0));
+    EXPECT_TRUE(pollUntilReady(50));
+
+    EXPECT_EQ(1u, writeCompletion.count);
+    EXPECT_EQ(buffer, writeCompletion.buffer);
+
+    fakeImageAccess(77, image, false);
+    EXPECT_EQ(0, memcmp(buffer, image, sizeof(buffer)));
+
+    const sdcardStats_t *stats = sdcard_getStats();
+    EXPECT_EQ(1u, stats->blocksWritten);
+    EXPECT_EQ(1u, stats->busyPeriods);
+    EXPECT_EQ(0u, fake.protocolErrors);
+}
+
+TEST(SdcardSpiTest, PollsABusyCardWithOneTransactionPerPoll)
+{
+    startCard();
+
+    fake.writeBusyNs = 20000000;
+
+    uint8_t buffer[SDCARD_BLOCK_SIZE];
+    fillPattern(buffer, 5);
+
+    EXPECT_EQ(SDCARD_OPERATION_IN_PROGRESS, sdcard_writeBlock(5, buffer, operationComplete, 0));
+
+    // Send the block
+    while (sdcard.state == SDCARD_STATE_SENDING_WRITE) {
+        fakeTick();
+        sdcard_poll();
+    }
+    ASSERT_EQ(SDCARD_STATE_WAITING_FOR_WRITE, sdcard.state);
+
+    const unsigned transactions = fake.transactions;
+    const unsigned busyBytes = fake.busyBytes;
+    int polls = 0;
+
+    while (sdcard.state == SDCARD_STATE_WAITING_FOR_WRITE) {
+        fakeTick();
+        sdcard_poll();
+        polls++;
+    }
+
+    EXPECT_EQ(SDCARD_STATE_READY, sdcard.state);
+    EXPECT_GE(polls, 19);
+    EXPECT_EQ((unsigned)polls, fake.transactions - transactions);
+    EXPECT_LE(fake.busyBytes - busyBytes, polls * 8u);
+
+    // The busy period is timed to within a poll
+    const sdcardStats_t *stats = sdcard_getStats();
+    EXPECT_EQ((unsigned)polls, stats->busyPolls);
+    EXPECT_EQ(1u, stats->busyPeriods);
+    EXPECT_GE(stats->busyMaxUs, fake.writeBusyNs / 1000);
+    EXPECT_LE(stats->busyMaxUs, fake.writeBusyNs / 1000 + FAKE_POLL_US);
+    EXPECT_EQ(stats->busyMaxUs, stats->busyTimeUs);
+    EXPECT_EQ(0u, fake.protocolErrors);
+}
+
+TEST(SdcardSpiTest, QueuesTheNextBlockOfAMultiBlockWriteWhileBusy)
+{
+    const uint32_t firstBlock = 200;
+    const uint32_t blockCount = 32;
+    static uint8_t buffers[32][SDCARD_BLOCK_SIZE];
+
+    startCard();
+
+    for (uint32_t i = 0; i < blockCount; i++) {
+        fillPattern(buffers[i], firstBlock + i);
+    }
+
+    ASSERT_EQ(SDCARD_OPERATION_SUCCESS, sdcard_beginWriteBlocks(firstBlock, blockCount));
+
+    uint32_t next = 0;
+    int ticks = 0;
+
+    // Like asyncfatfs: hand over the next block whenever the card says it can take one
+    while (next < blockCount && ticks < 1000) {
+        if (sdcard_poll()) {
+            const sdcardOperationStatus_e status = sdcard_writeBlock(firstBlock + next, buffers[next], operationComplete, next);
+            if (status == SDCARD_OPERATION_IN_PROGRESS) {
+                next++;
+            } else {
+                EXPECT_EQ(SDCARD_OPERATION_BUSY, status);
+            }
+        }
+        fakeTick();
+        ticks++;
+    }
+
+    EXPECT_TRUE(pollUntilReady(50));
+
+    EXPECT_EQ(blockCount, next);
+    EXPECT_EQ(blockCount, writeCompletion.count);
+    EXPECT_EQ(firstBlock + blockCount - 1, writeCompletion.blockIndex);
+    EXPECT_EQ(blockCount, fake.blocksWritten);
+
+    for (uint32_t i = 0; i < blockCount; i++) {
+        uint8_t image[SDCARD_BLOCK_SIZE];
+        fakeImageAccess(firstBlock + i, image, false);
+        EXPECT_EQ(0, memcmp(buffers[i], image, sizeof(image))) << "block " << i;
+    }
+
+    const sdcardStats_t *stats = sdcard_getStats();
+
+    // Every block but the first was handed over while the card was programming the one before
+    EXPECT_EQ(blockCount - 1, stats->queuedWrites);
+    EXPECT_EQ(0u, stats->busyRejects);
+    EXPECT_EQ(blockCount, stats->blocksWritten);
+
+    // One busy period per block and one for the stop token, each timed to within a poll
+    EXPECT_EQ(fake.busyPeriods, stats->busyPeriods);
+    EXPECT_EQ(blockCount + 1, stats->busyPeriods);
+    EXPECT_GE(stats->busyTimeUs, fake.busyNs / 1000);
+    EXPECT_LE(stats->busyTimeUs, fake.busyNs / 1000 + stats->busyPeriods * FAKE_POLL_US);
+
+    // A queued block goes out in the first poll that finds the card idle
+    EXPECT_LE(fake.maxIdleGapNs, FAKE_POLL_US * 1000ULL);
+    EXPECT_EQ(0u, fake.protocolErrors);
+}
+
+TEST(SdcardSpiTest, FailsAQueuedBlockWhenTheCardTimesOut)
+{
+    startCard();
+
+    static uint8_t buffers[2][SDCARD_BLOCK_SIZE];
+
+    ASSERT_EQ(SDCARD_OPERATION_SUCCESS, sdcard_beginWriteBlocks(300, 4));
+    ASSERT_EQ(SDCARD_OPERATION_IN_PROGRESS, sdcard_writeBlock(300, buffers[0], operationComplete, 0));
+
+    // The card never finishes programming the first block
+    fake.multiWriteBusyNs = 10000000000ULL;
+
+    while (sdcard.state == SDCARD_STATE_SENDING_WRITE) {
+        fakeTick();
+        sdcard_poll();
+    }
+    EXPECT_EQ(1u, writeCompletion.count);
+    EXPECT_EQ(buffers[0], writeCompletion.buffer);
+
+    // Not the next block, then the next block
+    EXPECT_EQ(SDCARD_OPERATION_BUSY, sdcard_writeBlock(302, buffers[1], operationComplete, 0));
+    EXPECT_EQ(SDCARD_OPERATION_IN_PROGRESS, sdcard_writeBlock(301, buffers[1], operationComplete, 0));
+    EXPECT_FALSE(sdcard_poll());
+
+    for (int i = 0; i < SDCARD_TIMEOUT_WRITE_MSEC * 1000 / FAKE_POLL_US + 10 && writeCompletion.count == 1; i++) {
+        fakeTick();
+        sdcard_poll();
+    }
+
+    EXPECT_EQ(2u, writeCompletion.count);
+    EXPECT_EQ(301u, writeCompletion.blockIndex);
+    EXPECT_EQ(NULL, writeCompletion.buffer);
+    EXPECT_FALSE(sdcard.pendingOperation.queued);
+    EXPECT_EQ(1u, sdcard.failureCount);
+}
+
+// STUBS
+
+extern "C" {
+timeMs_t millis(void) { return fake.nowNs / 1000000; }
+timeUs_t micros(void) { return fake.nowNs / 1000; }
+void delay(timeMs_t ms) { fake.nowNs += ms * 1000000ULL; }
+
+busDevice_t * busDeviceInit(busType_e, devHardwareType_e, uint8_t, resourceOwner_e) { return &fake.dev; }
+void busDeviceDeInit(busDevice_t *) {}
+void busSetSpeed(const busDevice_t *, busSpeed_e) {}
+bool busIsBusy(const busDevice_t *) { return false; }
+void busSelectDevice(const busDevice_t *) { fake.selected = true; }
+void busDeselectDevice(const busDevice_t *) { fake.selected = false; }
+
+bool busTransfer(const busDevice_t *, uint8_t * rxBuf, const uint8_t * txBuf, int length)
+{
+    fake.transactions++;
+    fake.nowNs += FAKE_TRANSACTION_NS;
+
+    for (int i = 0; i < length; i++) {
+        const uint8_t out = fakeClockByte(txBuf ? txBuf[i] : 0xFF);
+        if (rxBuf) {
+            rxBuf[i] = out;
+        }
+    }
+    return true;
+}
+
+IO_t IOGetByTag(ioTag_t) { return IO_NONE; }
+void IOInit(IO_t, resourceOwner_e, resourceType_e, uint8_t) {}
+void IOConfigGPIO(IO_t, ioConfig_t) {}
+bool IORead(IO_t) { return true; }
+}
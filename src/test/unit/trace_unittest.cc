@@ -0,0 +1,101 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * INAV is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with INAV.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/trace.h"
+    #include "drivers/time.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static timeUs_t currentTimeUs;
+
+TEST(TraceTest, RecordsEventsInOrder)
+{
+    const uint32_t head = traceGetHead();
+
+    currentTimeUs = 1000;
+    TRACE_BEGIN(TRACE_EVENT_SCHEDULER, 0);
+    currentTimeUs = 1010;
+    TRACE_BEGIN(TRACE_EVENT_TASK, 5);
+    currentTimeUs = 1250;
+    TRACE_END(TRACE_EVENT_TASK, 5);
+    TRACE_INSTANT(TRACE_EVENT_BUS, 42);
+
+    EXPECT_EQ(head + 4, traceGetHead());
+
+    traceEvent_t event;
+    ASSERT_TRUE(traceGetEvent(head, &event));
+    EXPECT_EQ(1000u, event.timeUs);
+    EXPECT_EQ(TRACE_EVENT_SCHEDULER, event.id);
+    EXPECT_EQ(TRACE_PHASE_BEGIN, event.phase);
+
+    ASSERT_TRUE(traceGetEvent(head + 2, &event));
+    EXPECT_EQ(1250u, event.timeUs);
+    EXPECT_EQ(TRACE_EVENT_TASK, event.id);
+    EXPECT_EQ(TRACE_PHASE_END, event.phase);
+    EXPECT_EQ(5, event.arg);
+
+    ASSERT_TRUE(traceGetEvent(head + 3, &event));
+    EXPECT_EQ(TRACE_PHASE_INSTANT, event.phase);
+    EXPECT_EQ(42, event.arg);
+
+    // Not recorded yet
+    EXPECT_FALSE(traceGetEvent(head + 4, &event));
+}
+
+TEST(TraceTest, OldEventsAreOverwritten)
+{
+    const uint32_t head = traceGetHead();
+
+    for (int i = 0; i < TRACE_BUFFER_SIZE + 3; i++) {
+        currentTimeUs = i;
+        TRACE_INSTANT(TRACE_EVENT_GYRO, i);
+    }
+
+    EXPECT_EQ(head + TRACE_BUFFER_SIZE + 3, traceGetHead());
+    EXPECT_EQ(head + 3, traceGetTail());
+
+    traceEvent_t event;
+    EXPECT_FALSE(traceGetEvent(head + 2, &event));
+
+    ASSERT_TRUE(traceGetEvent(head + 3, &event));
+    EXPECT_EQ(3, event.arg);
+
+    ASSERT_TRUE(traceGetEvent(traceGetHead() - 1, &event));
+    EXPECT_EQ(TRACE_BUFFER_SIZE + 2, event.arg);
+    EXPECT_EQ((uint32_t)TRACE_BUFFER_SIZE + 2, event.timeUs);
+}
+
+TEST(TraceTest, EventNames)
+{
+    EXPECT_STREQ("taskGyro", traceGetEventName(TRACE_EVENT_GYRO));
+    EXPECT_STREQ("afatfs_poll", traceGetEventName(TRACE_EVENT_AFATFS_POLL));
+    EXPECT_STREQ("unknown", traceGetEventName(TRACE_EVENT_COUNT));
+}
+
+// STUBS
+
+extern "C" {
+timeUs_t micros(void) { return currentTimeUs; }
+}
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+
+# Measures the MSP throughput of SITL serial ports and the CPU time the SITL process uses for it.
+#
+# ./sitl_serial_bench.py --pid $(pgrep -x inav_6.1.1_SITL) --ports 5760,5761 --seconds 10
+#
+# Requests are kept in flight on every port, so the result is limited by SITL and not by the round trip time.
+# The CPU time is read from /proc and is only available on Linux.
+
+import argparse
+import os
+import select
+import socket
+import struct
+import time
+
+MSP_BOXNAMES = 116
+
+def crc8_dvb_s2(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0xD5) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+def msp_v2_request(cmd, payload=b''):
+    body = struct.pack('<BHH', 0, cmd, len(payload)) + payload
+    return b'$X<' + body + bytes([crc8_dvb_s2(body)])
+
+class Connection:
+    def __init__(self, host, port, request, in_flight):
+        self.sock = socket.create_connection((host, port))
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.sock.setblocking(False)
+        self.request = request
+        self.in_flight = in_flight
+        self.pending = 0
+        self.rx = b''
+        self.responses = 0
+        self.bytes = 0
+
+    def fill(self):
+        count = self.in_flight - self.pending
+        if count > 0:
+            self.sock.sendall(self.request * count)
+            self.pending += count
+
+    def receive(self):
+        data = self.sock.recv(65536)
+        if not data:
+            raise ConnectionError('SITL closed the connection')
+        self.bytes += len(data)
+        self.rx += data
+        while True:
+            start = self.rx.find(b'$X>')
+            if start < 0 or len(self.rx) < start + 8:
+                break
+            size = struct.unpack('<H', self.rx[start + 6:start + 8])[0]
+            if len(self.rx) < start + 9 + size:
+                break
+            self.rx = self.rx[start + 9 + size:]
+            self.responses += 1
+            self.pending -= 1
+
+def process_cpu_seconds(pid):
+    if pid is None:
+        return None
+    with open('/proc/%d/stat' % pid) as f:
+        # Fields after the command name, which may contain spaces
+        fields = f.read().rsplit(')', 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / os.sysconf('SC_CLK_TCK')
+
+def measure_idle(pid, seconds):
+    start = process_cpu_seconds(pid)
+    time.sleep(seconds)
+    return (process_cpu_seconds(pid) - start) / seconds
+
+def main():
+    parser = argparse.ArgumentParser(description='SITL serial port throughput benchmark')
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--ports', default='5760', help='comma separated TCP ports, 5760 is UART1')
+    parser.add_argument('--seconds', type=float, default=5.0)
+    parser.add_argument('--in-flight', type=int, default=8, help='requests kept outstanding on each port')
+    parser.add_argument('--cmd', type=lambda x: int(x, 0), default=MSP_BOXNAMES, help='MSP command to request')
+    parser.add_argument('--pid', type=int, help='SITL process id, to report its CPU usage')
+    args = parser.parse_args()
+
+    if args.pid is not None:
+        print('idle CPU: %.1f %%' % (100 * measure_idle(args.pid, 1.0)))
+
+    request = msp_v2_request(args.cmd)
+    connections = [Connection(args.host, int(port), request, args.in_flight) for port in args.ports.split(',')]
+
+    cpu_start = process_cpu_seconds(args.pid)
+    start = time.monotonic()
+    while time.monotonic() - start < args.seconds:
+        for c in connections:
+            c.fill()
+        readable, _, _ = select.select([c.sock for c in connections], [], [], 1.0)
+        for c in connections:
+            if c.sock in readable:
+                c.receive()
+    elapsed = time.monotonic() - start
+    cpu_end = process_cpu_seconds(args.pid)
+
+    for port, c in zip(args.ports.split(','), connections):
+        print('port %s: %d responses, %.0f responses/s, %.0f bytes/s' % (port, c.responses, c.responses / elapsed, c.bytes / elapsed))
+    total = sum(c.bytes for c in connections)
+    print('total: %.0f bytes/s' % (total / elapsed))
+    if cpu_start is not None:
+        print('SITL CPU: %.1f %%' % (100 * (cpu_end - cpu_start) / elapsed))
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+
+# Stand-in for the simulators SITL connects to, to measure the round trip rate of the simulator bridges without
+# X-Plane or RealFlight.
+#
+# ./sitl_sim_standin.py xplane --seconds 10
+# ./sitl_sim_standin.py realflight --seconds 10 [--close]
+#
+# The stand-ins answer every request with a fixed aircraft state. With --sitl the given SITL binary is started with
+# matching arguments in a temporary directory and stopped afterwards, otherwise start SITL with --sim=xp or --sim=rf
+# and --simport pointing to the stand-in.
+
+import argparse
+import os
+import socket
+import socketserver
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+# Datarefs subscribed to by SITL that need a plausible value, all others are answered with 0
+XPLANE_VALUES = {
+    'sim/flightmodel/position/latitude': 47.45,
+    'sim/flightmodel/position/longitude': -122.31,
+    'sim/flightmodel/position/elevation': 120.0,
+    'sim/flightmodel/position/y_agl': 0.2,
+    'sim/flightmodel/position/groundspeed': 0.0,
+    'sim/flightmodel/position/true_airspeed': 0.0,
+    'sim/flightmodel/forces/g_nrml': 1.0,
+    'sim/weather/barometer_current_inhg': 29.92,
+}
+
+XPLANE_LAST_CONTROL = b'sim/cockpit2/engine/actuators/cowl_flap_ratio[4]'
+
+class Counter:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.count = 0
+
+    def add(self):
+        with self.lock:
+            self.count += 1
+
+    def value(self):
+        with self.lock:
+            return self.count
+
+def run_xplane(port, counter, stop):
+    sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_V6ONLY, 0)
+    sock.bind(('::', port))
+    sock.settimeout(0.5)
+    registered = {}
+
+    while not stop.is_set():
+        try:
+            data, addr = sock.recvfrom(1024)
+        except socket.timeout:
+            continue
+
+        if data.startswith(b'RREF'):
+            index = struct.unpack('<I', data[9:13])[0]
+            name = data[13:].split(b'\0', 1)[0].decode()
+            registered[index] = XPLANE_VALUES.get(name, 0.0)
+        elif data.startswith(b'DREF') and data[9:].split(b'\0', 1)[0] == XPLANE_LAST_CONTROL:
+            # All controls of one step are in, answer with the subscribed datarefs like X-Plane does once per frame
+            if registered:
+                reply = b'RREF,' + b''.join(struct.pack('<if', i, v) for i, v in registered.items())
+                sock.sendto(reply, addr)
+                counter.add()
+
+def realflight_response():
+    items = ''.join('<item>%.4f</item>' % v for v in [0.5, 0.5, 0.0, 0.5] + [0.0] * 8)
+    state = {
+        'm-currentPhysicsTime-SEC': 1.0, 'm-currentPhysicsSpeedMultiplier': 1.0, 'm-airspeed-MPS': 0.0,
+        'm-altitudeASL-MTR': 120.0, 'm-altitudeAGL-MTR': 0.2, 'm-groundspeed-MPS': 0.0, 'm-pitchRate-DEGpSEC': 0.0,
+        'm-rollRate-DEGpSEC': 0.0, 'm-yawRate-DEGpSEC': 0.0, 'm-azimuth-DEG': 90.0, 'm-inclination-DEG': 0.0,
+        'm-roll-DEG': 0.0, 'm-orientationQuaternion-X': 0.0, 'm-orientationQuaternion-Y': 0.0,
+        'm-orientationQuaternion-Z': 0.0, 'm-orientationQuaternion-W': 1.0, 'm-aircraftPositionX-MTR': 0.0,
+        'm-aircraftPositionY-MTR': 0.0, 'm-velocityWorldU-MPS': 0.0, 'm-velocityWorldV-MPS': 0.0,
+        'm-velocityWorldW-MPS': 0.0, 'm-velocityBodyU-MPS': 0.0, 'm-velocityBodyV-MPS': 0.0,
+        'm-velocityBodyW-MPS': 0.0, 'm-accelerationWorldAX-MPS2': 0.0, 'm-accelerationWorldAY-MPS2': 0.0,
+        'm-accelerationWorldAZ-MPS2': 0.0, 'm-accelerationBodyAX-MPS2': 0.0, 'm-accelerationBodyAY-MPS2': 0.0,
+        'm-accelerationBodyAZ-MPS2': -9.81, 'm-windX-MPS': 0.0, 'm-windY-MPS': 0.0, 'm-windZ-MPS': 0.0,
+        'm-propRPM': 0.0, 'm-heliMainRotorRPM': 0.0, 'm-batteryVoltage-VOLTS': 16.8,
+        'm-batteryCurrentDraw-AMPS': 0.0, 'm-batteryRemainingCapacity-MAH': 1300.0, 'm-fuelRemaining-OZ': 0.0,
+    }
+    values = ''.join('<%s>%.6f</%s>' % (k, v, k) for k, v in state.items())
+    flags = ''.join('<%s>%s</%s>' % (k, v, k) for k, v in [('m-isLocked', 'false'), ('m-hasLostComponents', 'false'),
+        ('m-anEngineIsRunning', 'true'), ('m-isTouchingGround', 'true'), ('m-flightAxisControllerIsActive', 'true'),
+        ('m-currentAircraftStatus', 'CAS-WAITINGTOLAUNCH')])
+
+    return ('<?xml version="1.0" encoding="UTF-8"?>'
+        '<SOAP-ENV:Envelope xmlns:SOAP-ENV="http://schemas.xmlsoap.org/soap/envelope/" '
+        'xmlns:SOAP-ENC="http://schemas.xmlsoap.org/soap/encoding/" '
+        'xmlns:xsd="http://www.w3.org/2001/XMLSchema" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance">'
+        '<SOAP-ENV:Body><ReturnData>'
+        '<m-channelValues-0to1 xsi:type="SOAP-ENC:Array" SOAP-ENC:arrayType="xsd:double[12]">' + items +
+        '</m-channelValues-0to1><m-aircraftState>' + values + flags + '</m-aircraftState>'
+        '<m-notifications><m-resetButtonHasBeenPressed>false</m-resetButtonHasBeenPressed></m-notifications>'
+        '</ReturnData></SOAP-ENV:Body></SOAP-ENV:Envelope>').encode()
+
+def make_realflight_handler(counter, close):
+    class Handler(socketserver.BaseRequestHandler):
+        def handle(self):
+            try:
+                self.exchange()
+            except ConnectionError:
+                pass
+
+        def exchange(self):
+            self.request.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            data = b''
+            while True:
+                while b'\r\n\r\n' not in data:
+                    chunk = self.request.recv(65536)
+                    if not chunk:
+                        return
+                    data += chunk
+                header, data = data.split(b'\r\n\r\n', 1)
+                length = 0
+                action = b''
+                for line in header.split(b'\r\n')[1:]:
+                    key, _, value = line.partition(b':')
+                    if key.strip().lower() == b'content-length':
+                        length = int(value)
+                    elif key.strip().lower() == b'soapaction':
+                        action = value.strip()
+                while len(data) < length:
+                    chunk = self.request.recv(65536)
+                    if not chunk:
+                        return
+                    data += chunk
+                data = data[length:]
+
+                body = realflight_response() if action == b'ExchangeData' else b'<ok/>'
+                connection = b'close' if close else b'keep-alive'
+                self.request.sendall(b'HTTP/1.1 200 OK\r\nContent-Type: text/xml; charset="UTF-8"\r\nContent-Length: %d\r\n'
+                    b'Connection: %s\r\n\r\n' % (len(body), connection) + body)
+                if action == b'ExchangeData':
+                    counter.add()
+                if close:
+                    return
+
+    return Handler
+
+def run_realflight(port, counter, stop, close):
+    class Server(socketserver.ThreadingTCPServer):
+        allow_reuse_address = True
+        daemon_threads = True
+
+    with Server(('127.0.0.1', port), make_realflight_handler(counter, close)) as server:
+        server.timeout = 0.5
+        while not stop.is_set():
+            server.handle_request()
+
+def main():
+    parser = argparse.ArgumentParser(description='Simulator stand-in for the SITL simulator bridges')
+    parser.add_argument('simulator', choices=['xplane', 'realflight'])
+    parser.add_argument('--port', type=int, help='default 49000 for X-Plane, 18083 for RealFlight')
+    parser.add_argument('--seconds', type=float, default=10.0)
+    parser.add_argument('--close', action='store_true', help='RealFlight: close the connection after every response, like RealFlight does')
+    parser.add_argument('--sitl', help='SITL binary to start')
+    args = parser.parse_args()
+
+    port = args.port or (49000 if args.simulator == 'xplane' else 18083)
+    counter = Counter()
+    stop = threading.Event()
+
+    if args.simulator == 'xplane':
+        server = threading.Thread(target=run_xplane, args=(port, counter, stop))
+    else:
+        server = threading.Thread(target=run_realflight, args=(port, counter, stop, args.close))
+    server.start()
+
+    sitl = None
+    if args.sitl:
+        sim = 'xp' if args.simulator == 'xplane' else 'rf'
+        workdir = tempfile.mkdtemp()
+        sitl = subprocess.Popen([os.path.abspath(args.sitl), '--sim=' + sim, '--simip=127.0.0.1', '--simport=%d' % port,
+            '--chanmap=M01-01,S01-02,S02-03,S03-04'], cwd=workdir, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    try:
+        # Skip the start up of SITL
+        deadline = time.monotonic() + 10
+        while counter.value() == 0 and time.monotonic() < deadline:
+            time.sleep(0.1)
+        if counter.value() == 0:
+            print('no round trips, is SITL connected?')
+            return 1
+
+        start_count = counter.value()
+        start = time.monotonic()
+        time.sleep(args.seconds)
+        rate = (counter.value() - start_count) / (time.monotonic() - start)
+        print('%s: %.0f round trips/s' % (args.simulator, rate))
+        return 0
+    finally:
+        stop.set()
+        if sitl:
+            sitl.terminate()
+            sitl.wait()
+        server.join()
+
+if __name__ == '__main__':
+    sys.exit(main())